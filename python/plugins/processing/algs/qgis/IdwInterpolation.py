@@ -46,6 +46,8 @@ class IdwInterpolation(QgisAlgorithm):
 
     INTERPOLATION_DATA = 'INTERPOLATION_DATA'
     DISTANCE_COEFFICIENT = 'DISTANCE_COEFFICIENT'
+    MAX_POINTS = 'MAX_POINTS'
+    SEARCH_RADIUS = 'SEARCH_RADIUS'
     PIXEL_SIZE = 'PIXEL_SIZE'
     COLUMNS = 'COLUMNS'
     ROWS = 'ROWS'
@@ -71,6 +73,17 @@ class IdwInterpolation(QgisAlgorithm):
         self.addParameter(QgsProcessingParameterNumber(self.DISTANCE_COEFFICIENT,
                                                        self.tr('Distance coefficient P'), type=QgsProcessingParameterNumber.Double,
                                                        minValue=0.0, maxValue=99.99, defaultValue=2.0))
+        max_points_param = QgsProcessingParameterNumber(self.MAX_POINTS,
+                                                        self.tr('Maximum number of nearest points (0 for all points)'),
+                                                        minValue=0, defaultValue=0, optional=True)
+        max_points_param.setFlags(max_points_param.flags() | QgsProcessingParameterDefinition.FlagAdvanced)
+        self.addParameter(max_points_param)
+        search_radius_param = QgsProcessingParameterNumber(self.SEARCH_RADIUS,
+                                                           self.tr('Search radius (0 for unlimited)'),
+                                                           type=QgsProcessingParameterNumber.Double,
+                                                           minValue=0.0, defaultValue=0.0, optional=True)
+        search_radius_param.setFlags(search_radius_param.flags() | QgsProcessingParameterDefinition.FlagAdvanced)
+        self.addParameter(search_radius_param)
         self.addParameter(QgsProcessingParameterExtent(self.EXTENT,
                                                        self.tr('Extent'),
                                                        optional=False))
@@ -108,6 +121,8 @@ class IdwInterpolation(QgisAlgorithm):
     def processAlgorithm(self, parameters, context, feedback):
         interpolationData = ParameterInterpolationData.parseValue(parameters[self.INTERPOLATION_DATA])
         coefficient = self.parameterAsDouble(parameters, self.DISTANCE_COEFFICIENT, context)
+        max_points = self.parameterAsInt(parameters, self.MAX_POINTS, context)
+        search_radius = self.parameterAsDouble(parameters, self.SEARCH_RADIUS, context)
         bbox = self.parameterAsExtent(parameters, self.EXTENT, context)
         pixel_size = self.parameterAsDouble(parameters, self.PIXEL_SIZE, context)
         output = self.parameterAsOutputLayer(parameters, self.OUTPUT, context)
@@ -146,6 +161,8 @@ class IdwInterpolation(QgisAlgorithm):
 
         interpolator = QgsIDWInterpolator(layerData)
         interpolator.setDistanceCoefficient(coefficient)
+        interpolator.setMaximumPoints(max_points)
+        interpolator.setSearchRadius(search_radius)
 
         writer = QgsGridFileWriter(interpolator,
                                    output,
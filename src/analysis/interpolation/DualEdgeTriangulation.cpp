@@ -887,6 +887,49 @@ int DualEdgeTriangulation::getOppositePoint( int p1, int p2 )
 
 }
 
+QVector<int> DualEdgeTriangulation::getTriangleVertexIndexes() const
+{
+  QVector<int> indexes;
+  if ( mPointVector.size() < 3 )
+  {
+    return indexes;
+  }
+
+  QVector<bool> visited( mHalfEdge.size(), false );
+  for ( int i = 0; i < mHalfEdge.size(); ++i )
+  {
+    if ( visited.at( i ) )
+    {
+      continue;
+    }
+
+    const int edge2 = mHalfEdge[i]->getNext();
+    if ( edge2 < 0 || edge2 >= mHalfEdge.size() )
+    {
+      continue;
+    }
+    const int edge3 = mHalfEdge[edge2]->getNext();
+    if ( edge3 < 0 || edge3 >= mHalfEdge.size() || mHalfEdge[edge3]->getNext() != i )
+    {
+      continue;
+    }
+    visited[i] = true;
+    visited[edge2] = true;
+    visited[edge3] = true;
+
+    //triangles with the virtual point are outside the convex hull
+    const int p1 = mHalfEdge[i]->getPoint();
+    const int p2 = mHalfEdge[edge2]->getPoint();
+    const int p3 = mHalfEdge[edge3]->getPoint();
+    if ( p1 < 0 || p2 < 0 || p3 < 0 )
+    {
+      continue;
+    }
+    indexes << p1 << p2 << p3;
+  }
+  return indexes;
+}
+
 QList<int> DualEdgeTriangulation::getSurroundingTriangles( int pointno )
 {
   int firstedge = baseEdgeOfPoint( pointno );
@@ -66,6 +66,13 @@ class ANALYSIS_EXPORT DualEdgeTriangulation: public Triangulation
     bool getTriangle( double x, double y, QgsPoint &p1 SIP_OUT, int &n1 SIP_OUT, QgsPoint &p2 SIP_OUT, int &n2 SIP_OUT, QgsPoint &p3 SIP_OUT, int &n3 SIP_OUT ) SIP_PYNAME( getTriangleVertices ) override;
     bool getTriangle( double x, double y, QgsPoint &p1 SIP_OUT, QgsPoint &p2 SIP_OUT, QgsPoint &p3 SIP_OUT ) override;
     QList<int> getSurroundingTriangles( int pointno ) override;
+
+    /**
+     * Returns the point numbers of all triangles inside the convex hull, three
+     * consecutive numbers for every triangle.
+     * \since QGIS 3.10
+     */
+    QVector<int> getTriangleVertexIndexes() const;
     //! Returns the largest x-coordinate value of the bounding box
     double getXMax() const override { return xMax; }
     //! Returns the smallest x-coordinate value of the bounding box
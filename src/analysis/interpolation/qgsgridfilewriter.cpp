@@ -19,8 +19,20 @@
 #include "qgsinterpolator.h"
 #include "qgsvectorlayer.h"
 #include "qgsfeedback.h"
+#include "qgsrasterfilewriter.h"
+#include "qgsrasterdataprovider.h"
+#include "qgsrasterblock.h"
+
 #include <QFile>
 #include <QFileInfo>
+#include <QtConcurrentMap>
+
+#include <cmath>
+#include <memory>
+#include <numeric>
+
+//! Value of cells which could not be interpolated
+static const double NODATA_VALUE = -9999;
 
 QgsGridFileWriter::QgsGridFileWriter( QgsInterpolator *i, const QString &outputPath, const QgsRectangle &extent, int nCols, int nRows )
   : mInterpolator( i )
@@ -34,61 +46,157 @@ QgsGridFileWriter::QgsGridFileWriter( QgsInterpolator *i, const QString &outputP
 
 int QgsGridFileWriter::writeFile( QgsFeedback *feedback )
 {
-  QFile outputFile( mOutputFilePath );
+  if ( !mInterpolator )
+  {
+    return 2;
+  }
 
-  if ( !outputFile.open( QFile::WriteOnly | QIODevice::Truncate ) )
+  QgsCoordinateReferenceSystem crs;
+  const QList< QgsInterpolator::LayerData > layerData = mInterpolator->layerData();
+  if ( !layerData.isEmpty() && layerData.at( 0 ).source )
   {
-    return 1;
+    crs = layerData.at( 0 ).source->sourceCrs();
   }
 
-  if ( !mInterpolator )
+  // formats which cannot be created directly by GDAL are written as ASCII grid
+  const QString outputFormat = QgsRasterFileWriter::driverForExtension( QFileInfo( mOutputFilePath ).suffix() );
+  const bool asciiGrid = outputFormat.isEmpty() || outputFormat == QLatin1String( "AAIGrid" );
+
+  QFile outputFile( mOutputFilePath );
+  QTextStream outStream;
+  std::unique_ptr< QgsRasterDataProvider > provider;
+  if ( asciiGrid )
   {
-    outputFile.remove();
-    return 2;
+    if ( !outputFile.open( QFile::WriteOnly | QIODevice::Truncate ) )
+    {
+      return 1;
+    }
+    outStream.setDevice( &outputFile );
+    outStream.setRealNumberPrecision( 8 );
+    writeHeader( outStream );
+  }
+  else
+  {
+    QgsRasterFileWriter writer( mOutputFilePath );
+    writer.setOutputProviderKey( QStringLiteral( "gdal" ) );
+    writer.setOutputFormat( outputFormat );
+    provider.reset( writer.createOneBandRaster( Qgis::Float32, mNumColumns, mNumRows, mInterpolationExtent, crs ) );
+    if ( !provider || !provider->isValid() )
+    {
+      return 1;
+    }
+    provider->setNoDataValue( 1, NODATA_VALUE );
   }
 
-  QTextStream outStream( &outputFile );
-  outStream.setRealNumberPrecision( 8 );
-  writeHeader( outStream );
+  auto removeOutput = [&]
+  {
+    if ( asciiGrid )
+    {
+      outputFile.remove();
+    }
+    else
+    {
+      provider.reset();
+      QFile::remove( mOutputFilePath );
+    }
+  };
 
-  double currentYValue = mInterpolationExtent.yMaximum() - mCellSizeY / 2.0; //calculate value in the center of the cell
-  double currentXValue;
-  double interpolatedValue;
+  const QgsInterpolator::Result prepareResult = mInterpolator->prepare( feedback );
+  if ( prepareResult == QgsInterpolator::Canceled )
+  {
+    removeOutput();
+    return 3;
+  }
+  const bool parallel = prepareResult == QgsInterpolator::Success && mInterpolator->supportsParallelInterpolation();
 
+  // y values in the center of the rows
+  QVector< double > rowY( mNumRows );
+  double currentYValue = mInterpolationExtent.yMaximum() - mCellSizeY / 2.0;
   for ( int i = 0; i < mNumRows; ++i )
   {
-    currentXValue = mInterpolationExtent.xMinimum() + mCellSizeX / 2.0; //calculate value in the center of the cell
-    for ( int j = 0; j < mNumColumns; ++j )
+    rowY[i] = currentYValue;
+    currentYValue -= mCellSizeY;
+  }
+  const double firstXValue = mInterpolationExtent.xMinimum() + mCellSizeX / 2.0; //calculate value in the center of the cell
+
+  // rows are interpolated in chunks of about a million cells, which are then written sequentially
+  const int chunkRows = std::max( 1, ( 1 << 20 ) / std::max( mNumColumns, 1 ) );
+  QVector< QVector< double > > rowValues( std::min( chunkRows, mNumRows ) );
+  QVector< int > chunkRowIndexes;
+
+  for ( int chunkStart = 0; chunkStart < mNumRows; chunkStart += chunkRows )
+  {
+    const int chunkEnd = std::min( chunkStart + chunkRows, mNumRows );
+    auto interpolateRow = [&]( int row )
+    {
+      if ( feedback && feedback->isCanceled() )
+        return;
+      rowValues[row - chunkStart] = mInterpolator->interpolateRow( firstXValue, rowY.at( row ), mCellSizeX, mNumColumns, feedback );
+    };
+
+    if ( parallel )
     {
-      if ( mInterpolator->interpolatePoint( currentXValue, currentYValue, interpolatedValue, feedback ) == 0 )
+      chunkRowIndexes.resize( chunkEnd - chunkStart );
+      std::iota( chunkRowIndexes.begin(), chunkRowIndexes.end(), chunkStart );
+      QtConcurrent::blockingMap( chunkRowIndexes, interpolateRow );
+    }
+    else
+    {
+      for ( int row = chunkStart; row < chunkEnd; ++row )
+        interpolateRow( row );
+    }
+
+    if ( feedback && feedback->isCanceled() )
+    {
+      removeOutput();
+      return 3;
+    }
+
+    if ( asciiGrid )
+    {
+      for ( int row = chunkStart; row < chunkEnd; ++row )
+      {
+        for ( double value : qgis::as_const( rowValues[row - chunkStart] ) )
+        {
+          if ( std::isnan( value ) )
+            outStream << "-9999 ";
+          else
+            outStream << value << ' ';
+        }
+        outStream << endl;
+      }
+    }
+    else
+    {
+      QgsRasterBlock block( Qgis::Float32, mNumColumns, chunkEnd - chunkStart );
+      for ( int row = chunkStart; row < chunkEnd; ++row )
       {
-        outStream << interpolatedValue << ' ';
+        const QVector< double > &values = rowValues.at( row - chunkStart );
+        for ( int column = 0; column < mNumColumns; ++column )
+        {
+          const double value = values.at( column );
+          block.setValue( row - chunkStart, column, std::isnan( value ) ? NODATA_VALUE : value );
+        }
       }
-      else
+      if ( !provider->writeBlock( &block, 1, 0, chunkStart ) )
       {
-        outStream << "-9999 ";
+        removeOutput();
+        return 1;
       }
-      currentXValue += mCellSizeX;
     }
-    outStream << endl;
-    currentYValue -= mCellSizeY;
 
     if ( feedback )
     {
-      if ( feedback->isCanceled() )
-      {
-        outputFile.remove();
-        return 3;
-      }
-      feedback->setProgress( 100.0 * i / static_cast< double >( mNumRows ) );
+      feedback->setProgress( 100.0 * chunkEnd / static_cast< double >( mNumRows ) );
     }
   }
 
+  if ( !asciiGrid )
+  {
+    return 0;
+  }
+
   // create prj file
-  QgsInterpolator::LayerData ld;
-  ld = mInterpolator->layerData().at( 0 );
-  QgsFeatureSource *source = ld.source;
-  QString crs = source->sourceCrs().toWkt();
   QFileInfo fi( mOutputFilePath );
   QString fileName = fi.absolutePath() + '/' + fi.completeBaseName() + ".prj";
   QFile prjFile( fileName );
@@ -97,7 +205,7 @@ int QgsGridFileWriter::writeFile( QgsFeedback *feedback )
     return 1;
   }
   QTextStream prjStream( &prjFile );
-  prjStream << crs;
+  prjStream << crs.toWkt();
   prjStream << endl;
   prjFile.close();
 
@@ -28,8 +28,11 @@ class QgsFeedback;
 
 /**
  * \ingroup analysis
- * A class that does interpolation to a grid and writes the results to an ascii grid*/
-//todo: extend such that writing to other file types is possible
+ * A class that does interpolation to a grid and writes the results to a raster file.
+ *
+ * The output format is determined by the extension of the output file. Files with
+ * an unknown extension are written as ASCII grid.
+ */
 class ANALYSIS_EXPORT QgsGridFileWriter
 {
   public:
@@ -46,6 +49,8 @@ class ANALYSIS_EXPORT QgsGridFileWriter
     /**
      * Writes the grid file.
      *
+     * Rows are interpolated in parallel if the interpolator supports it.
+     *
      * An optional \a feedback object can be set for progress reports and cancellation support
      *
      * \returns 0 in case of success
@@ -17,8 +17,10 @@
 
 #include "qgsidwinterpolator.h"
 #include "qgis.h"
+#include <algorithm>
 #include <cmath>
 #include <limits>
+#include <vector>
 
 QgsIDWInterpolator::QgsIDWInterpolator( const QList<LayerData> &layerData )
   : QgsInterpolator( layerData )
@@ -26,9 +28,14 @@ QgsIDWInterpolator::QgsIDWInterpolator( const QList<LayerData> &layerData )
 
 int QgsIDWInterpolator::interpolatePoint( double x, double y, double &result, QgsFeedback *feedback )
 {
-  if ( !mDataIsCached )
+  if ( !mPrepared )
+  {
+    prepare( feedback );
+  }
+
+  if ( usesIndex() )
   {
-    cacheBaseData( feedback );
+    return interpolatePointFromIndex( x, y, result );
   }
 
   double sumCounter = 0;
@@ -55,3 +62,169 @@ int QgsIDWInterpolator::interpolatePoint( double x, double y, double &result, Qg
   result = sumCounter / sumDenominator;
   return 0;
 }
+
+QgsInterpolator::Result QgsIDWInterpolator::prepare( QgsFeedback *feedback )
+{
+  if ( !mDataIsCached )
+  {
+    const Result res = cacheBaseData( feedback );
+    if ( res != Success )
+      return res;
+  }
+
+  if ( usesIndex() )
+    buildIndex();
+  else
+    mIndexedData.clear();
+
+  mPrepared = true;
+  return Success;
+}
+
+void QgsIDWInterpolator::buildIndex()
+{
+  mIndexedData.clear();
+  mCellStart.clear();
+  mIndexColumns = 0;
+  mIndexRows = 0;
+  if ( mCachedBaseData.isEmpty() )
+    return;
+
+  double xMin = std::numeric_limits<double>::max();
+  double xMax = std::numeric_limits<double>::lowest();
+  double yMin = std::numeric_limits<double>::max();
+  double yMax = std::numeric_limits<double>::lowest();
+  for ( const QgsInterpolatorVertexData &vertex : qgis::as_const( mCachedBaseData ) )
+  {
+    xMin = std::min( xMin, vertex.x );
+    xMax = std::max( xMax, vertex.x );
+    yMin = std::min( yMin, vertex.y );
+    yMax = std::max( yMax, vertex.y );
+  }
+
+  // about four points per cell for evenly distributed points
+  const int count = mCachedBaseData.size();
+  const double width = xMax - xMin;
+  const double height = yMax - yMin;
+  double cellSize = std::sqrt( width * height * 4 / count );
+  if ( !( cellSize > 0 ) )
+    cellSize = std::max( width, height ) * 4 / count;
+  if ( !( cellSize > 0 ) )
+    cellSize = 1;
+
+  mIndexXMin = xMin;
+  mIndexYMin = yMin;
+  mIndexCellSize = cellSize;
+  mIndexColumns = std::min( static_cast< int >( width / cellSize ) + 1, count );
+  mIndexRows = std::min( static_cast< int >( height / cellSize ) + 1, count );
+
+  auto cellIndex = [this]( const QgsInterpolatorVertexData & vertex )
+  {
+    const int column = std::min( static_cast< int >( ( vertex.x - mIndexXMin ) / mIndexCellSize ), mIndexColumns - 1 );
+    const int row = std::min( static_cast< int >( ( vertex.y - mIndexYMin ) / mIndexCellSize ), mIndexRows - 1 );
+    return row * mIndexColumns + column;
+  };
+
+  // counting sort of the points by cell
+  mCellStart.fill( 0, mIndexColumns * mIndexRows + 1 );
+  for ( const QgsInterpolatorVertexData &vertex : qgis::as_const( mCachedBaseData ) )
+    mCellStart[ cellIndex( vertex ) + 1 ]++;
+  for ( int i = 1; i < mCellStart.size(); ++i )
+    mCellStart[i] += mCellStart[i - 1];
+
+  QVector< int > position = mCellStart;
+  mIndexedData.resize( count );
+  for ( const QgsInterpolatorVertexData &vertex : qgis::as_const( mCachedBaseData ) )
+    mIndexedData[ position[ cellIndex( vertex ) ]++ ] = vertex;
+}
+
+int QgsIDWInterpolator::interpolatePointFromIndex( double x, double y, double &result ) const
+{
+  if ( mIndexedData.isEmpty() )
+    return 1;
+
+  const double radiusSquared = mSearchRadius > 0 ? mSearchRadius * mSearchRadius : std::numeric_limits<double>::max();
+
+  // locations outside the grid start at the closest cell, the distance bound of the rings holds nevertheless
+  const int queryColumn = std::max( 0, std::min( static_cast< int >( std::floor( ( x - mIndexXMin ) / mIndexCellSize ) ), mIndexColumns - 1 ) );
+  const int queryRow = std::max( 0, std::min( static_cast< int >( std::floor( ( y - mIndexYMin ) / mIndexCellSize ) ), mIndexRows - 1 ) );
+  const int lastRing = std::max( std::max( queryColumn, mIndexColumns - 1 - queryColumn ), std::max( queryRow, mIndexRows - 1 - queryRow ) );
+  const int maxRing = mSearchRadius > 0 ? std::min( lastRing, static_cast< int >( std::ceil( mSearchRadius / mIndexCellSize ) ) + 1 ) : lastRing;
+
+  // squared distance and value of the nearest points, a max heap if the number of points is limited
+  std::vector< std::pair< double, double > > neighbors;
+  double sumCounter = 0;
+  double sumDenominator = 0;
+
+  for ( int ring = 0; ring <= maxRing; ++ring )
+  {
+    const int rowStart = std::max( queryRow - ring, 0 );
+    const int rowEnd = std::min( queryRow + ring, mIndexRows - 1 );
+    for ( int row = rowStart; row <= rowEnd; ++row )
+    {
+      // inner rows of the ring only have the cells at both ends
+      const bool fullRow = row == queryRow - ring || row == queryRow + ring;
+      const int columnStep = fullRow || ring == 0 ? 1 : 2 * ring;
+      for ( int column = queryColumn - ring; column <= queryColumn + ring; column += columnStep )
+      {
+        if ( column < 0 || column >= mIndexColumns )
+          continue;
+
+        const int cell = row * mIndexColumns + column;
+        for ( int i = mCellStart.at( cell ); i < mCellStart.at( cell + 1 ); ++i )
+        {
+          const QgsInterpolatorVertexData &vertex = mIndexedData.at( i );
+          const double distanceSquared = ( vertex.x - x ) * ( vertex.x - x ) + ( vertex.y - y ) * ( vertex.y - y );
+          if ( qgsDoubleNear( std::sqrt( distanceSquared ), 0.0 ) )
+          {
+            result = vertex.z;
+            return 0;
+          }
+          if ( distanceSquared > radiusSquared )
+            continue;
+
+          if ( mMaximumPoints <= 0 )
+          {
+            const double currentWeight = 1 / ( std::pow( distanceSquared, mDistanceCoefficient / 2 ) );
+            sumCounter += currentWeight * vertex.z;
+            sumDenominator += currentWeight;
+          }
+          else if ( static_cast< int >( neighbors.size() ) < mMaximumPoints )
+          {
+            neighbors.emplace_back( distanceSquared, vertex.z );
+            std::push_heap( neighbors.begin(), neighbors.end() );
+          }
+          else if ( distanceSquared < neighbors.front().first )
+          {
+            std::pop_heap( neighbors.begin(), neighbors.end() );
+            neighbors.back() = std::make_pair( distanceSquared, vertex.z );
+            std::push_heap( neighbors.begin(), neighbors.end() );
+          }
+        }
+      }
+    }
+
+    // points in the following rings are at least ring * cell size away
+    if ( mMaximumPoints > 0 && static_cast< int >( neighbors.size() ) == mMaximumPoints )
+    {
+      const double ringDistance = ring * mIndexCellSize;
+      if ( neighbors.front().first <= ringDistance * ringDistance )
+        break;
+    }
+  }
+
+  for ( const std::pair< double, double > &neighbor : neighbors )
+  {
+    const double currentWeight = 1 / ( std::pow( neighbor.first, mDistanceCoefficient / 2 ) );
+    sumCounter += currentWeight * neighbor.second;
+    sumDenominator += currentWeight;
+  }
+
+  if ( sumDenominator == 0.0 )
+  {
+    return 1;
+  }
+
+  result = sumCounter / sumDenominator;
+  return 0;
+}
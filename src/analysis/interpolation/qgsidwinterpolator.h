@@ -36,6 +36,8 @@ class ANALYSIS_EXPORT QgsIDWInterpolator: public QgsInterpolator
     QgsIDWInterpolator( const QList<QgsInterpolator::LayerData> &layerData );
 
     int interpolatePoint( double x, double y, double &result SIP_OUT, QgsFeedback *feedback = nullptr ) override;
+    QgsInterpolator::Result prepare( QgsFeedback *feedback = nullptr ) override;
+    bool supportsParallelInterpolation() const override { return true; }
 
     /**
      * Sets the distance \a coefficient, the parameter that sets how the values are
@@ -60,11 +62,78 @@ class ANALYSIS_EXPORT QgsIDWInterpolator: public QgsInterpolator
     */
     double distanceCoefficient() const { return mDistanceCoefficient; }
 
+    /**
+     * Sets the maximum \a count of nearest points used to interpolate a value.
+     * A value of 0 (the default) means that all points are used.
+     *
+     * Limiting the number of points (or the search radius) enables a spatial
+     * index of the points, which makes interpolation of large data sets fast.
+     *
+     * \see maximumPoints()
+     * \see setSearchRadius()
+     * \since QGIS 3.10
+     */
+    void setMaximumPoints( int count ) { mMaximumPoints = count; mPrepared = false; }
+
+    /**
+     * Returns the maximum count of nearest points used to interpolate a value,
+     * or 0 if all points are used.
+     *
+     * \see setMaximumPoints()
+     * \since QGIS 3.10
+     */
+    int maximumPoints() const { return mMaximumPoints; }
+
+    /**
+     * Sets the search \a radius (in map units) around an interpolated location.
+     * Only points within this distance are used. A value of 0 (the default)
+     * means that the search radius is unlimited.
+     *
+     * Locations without points within the radius cannot be interpolated.
+     *
+     * \see searchRadius()
+     * \see setMaximumPoints()
+     * \since QGIS 3.10
+     */
+    void setSearchRadius( double radius ) { mSearchRadius = radius; mPrepared = false; }
+
+    /**
+     * Returns the search radius (in map units) around an interpolated location,
+     * or 0 if the radius is unlimited.
+     *
+     * \see setSearchRadius()
+     * \since QGIS 3.10
+     */
+    double searchRadius() const { return mSearchRadius; }
+
   private:
 
     QgsIDWInterpolator() = delete;
 
+    //! Returns TRUE if only a subset of the points is used for every location
+    bool usesIndex() const { return mMaximumPoints > 0 || mSearchRadius > 0; }
+
+    //! Sorts the cached points into the cells of a regular grid
+    void buildIndex();
+
+    //! Interpolates a value from the points found in the grid index
+    int interpolatePointFromIndex( double x, double y, double &result ) const;
+
     double mDistanceCoefficient = 2.0;
+    int mMaximumPoints = 0;
+    double mSearchRadius = 0;
+
+    bool mPrepared = false;
+
+    //! Points sorted by grid cell
+    QVector<QgsInterpolatorVertexData> mIndexedData;
+    //! Position of the first point of every grid cell in mIndexedData, with an extra entry for the end
+    QVector<int> mCellStart;
+    double mIndexXMin = 0;
+    double mIndexYMin = 0;
+    double mIndexCellSize = 1;
+    int mIndexColumns = 0;
+    int mIndexRows = 0;
 };
 
 #endif
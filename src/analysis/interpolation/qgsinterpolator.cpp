@@ -22,6 +22,8 @@
 #include "qgsgeometry.h"
 #include "qgsfeedback.h"
 
+#include <limits>
+
 QgsInterpolator::QgsInterpolator( const QList<LayerData> &layerData )
   : mLayerData( layerData )
 {
@@ -112,6 +114,28 @@ QgsInterpolator::Result QgsInterpolator::cacheBaseData( QgsFeedback *feedback )
   return Success;
 }
 
+QgsInterpolator::Result QgsInterpolator::prepare( QgsFeedback *feedback )
+{
+  if ( mDataIsCached )
+    return Success;
+
+  return cacheBaseData( feedback );
+}
+
+QVector< double > QgsInterpolator::interpolateRow( double x, double y, double xStep, int count, QgsFeedback *feedback )
+{
+  QVector< double > values( count, std::numeric_limits<double>::quiet_NaN() );
+  double currentX = x;
+  double result = 0;
+  for ( int i = 0; i < count; ++i )
+  {
+    if ( interpolatePoint( currentX, y, result, feedback ) == 0 )
+      values[i] = result;
+    currentX += xStep;
+  }
+  return values;
+}
+
 bool QgsInterpolator::addVerticesToCache( const QgsGeometry &geom, ValueSource source, double attributeValue )
 {
   if ( geom.isNull() || geom.isEmpty() )
@@ -117,6 +117,41 @@ class ANALYSIS_EXPORT QgsInterpolator
      */
     virtual int interpolatePoint( double x, double y, double &result SIP_OUT, QgsFeedback *feedback = nullptr ) = 0;
 
+    /**
+     * Prepares the interpolator for interpolation, e.g. by caching the base data
+     * and building search structures.
+     *
+     * This is called automatically on the first interpolation, but must be called
+     * explicitly before values are interpolated from several threads.
+     *
+     * An optional \a feedback argument may be specified to allow cancellation and
+     * progress reports.
+     *
+     * \returns Success in case of success
+     * \since QGIS 3.10
+     */
+    virtual Result prepare( QgsFeedback *feedback = nullptr );
+
+    /**
+     * Interpolates \a count values along the horizontal line at \a y, starting at
+     * map coordinate \a x and advancing by \a xStep map units for every value.
+     * Values which cannot be interpolated are set to NaN.
+     *
+     * The default implementation calls interpolatePoint() for every value.
+     *
+     * \see supportsParallelInterpolation()
+     * \since QGIS 3.10
+     */
+    virtual QVector< double > interpolateRow( double x, double y, double xStep, int count, QgsFeedback *feedback = nullptr );
+
+    /**
+     * Returns TRUE if interpolateRow() may be called from several threads at
+     * once, after prepare() has been called.
+     *
+     * \since QGIS 3.10
+     */
+    virtual bool supportsParallelInterpolation() const { return false; }
+
     //! \note not available in Python bindings
     QList<LayerData> layerData() const { return mLayerData; } SIP_SKIP
 
@@ -32,6 +32,9 @@
 #include "qgscurvepolygon.h"
 #include "qgsmultisurface.h"
 
+#include <cmath>
+#include <limits>
+
 QgsTinInterpolator::QgsTinInterpolator( const QList<LayerData> &inputData, TinInterpolation interpolation, QgsFeedback *feedback )
   : QgsInterpolator( inputData )
   , mIsInitialized( false )
@@ -67,6 +70,86 @@ int QgsTinInterpolator::interpolatePoint( double x, double y, double &result, Qg
   return 0;
 }
 
+QgsInterpolator::Result QgsTinInterpolator::prepare( QgsFeedback *feedback )
+{
+  if ( !mIsInitialized )
+  {
+    initialize();
+  }
+
+  if ( mInterpolation == Linear && mLinearBands.isEmpty() )
+  {
+    buildLinearIndex();
+  }
+
+  if ( ( feedback && feedback->isCanceled() ) || ( mFeedback && mFeedback->isCanceled() ) )
+    return Canceled;
+
+  return Success;
+}
+
+QVector<double> QgsTinInterpolator::interpolateRow( double x, double y, double xStep, int count, QgsFeedback *feedback )
+{
+  if ( mInterpolation != Linear || !( xStep > 0 ) )
+  {
+    return QgsInterpolator::interpolateRow( x, y, xStep, count, feedback );
+  }
+
+  if ( !mIsInitialized || mLinearBands.isEmpty() )
+  {
+    prepare( feedback );
+  }
+
+  QVector< double > values( count, std::numeric_limits<double>::quiet_NaN() );
+  if ( count <= 0 || mLinearBands.isEmpty() )
+    return values;
+
+  const int band = static_cast< int >( std::max( 0.0, std::min( std::floor( ( y - mLinearBandsYMin ) / mLinearBandHeight ), mLinearBands.size() - 1.0 ) ) );
+  for ( int index : mLinearBands.at( band ) )
+  {
+    const LinearTriangle &triangle = mLinearTriangles.at( index );
+    if ( y < triangle.yMin || y > triangle.yMax )
+      continue;
+
+    // intersection of the row with the triangle
+    double xStart = std::numeric_limits<double>::max();
+    double xEnd = std::numeric_limits<double>::lowest();
+    for ( int i = 0; i < 3; ++i )
+    {
+      const int j = ( i + 1 ) % 3;
+      const double y1 = triangle.y[i];
+      const double y2 = triangle.y[j];
+      if ( ( y < y1 && y < y2 ) || ( y > y1 && y > y2 ) )
+        continue;
+
+      if ( y1 == y2 )
+      {
+        xStart = std::min( xStart, std::min( triangle.x[i], triangle.x[j] ) );
+        xEnd = std::max( xEnd, std::max( triangle.x[i], triangle.x[j] ) );
+      }
+      else
+      {
+        const double xIntersection = triangle.x[i] + ( y - y1 ) * ( triangle.x[j] - triangle.x[i] ) / ( y2 - y1 );
+        xStart = std::min( xStart, xIntersection );
+        xEnd = std::max( xEnd, xIntersection );
+      }
+    }
+    if ( xStart > xEnd )
+      continue;
+
+    // cells on the edges are included
+    const double tolerance = 1e-9;
+    const int first = static_cast< int >( std::max( 0.0, std::ceil( ( xStart - x ) / xStep - tolerance ) ) );
+    const int last = static_cast< int >( std::min( count - 1.0, std::floor( ( xEnd - x ) / xStep + tolerance ) ) );
+    for ( int column = first; column <= last; ++column )
+    {
+      if ( std::isnan( values.at( column ) ) )
+        values[column] = triangle.a * ( x + column * xStep ) + triangle.b * y + triangle.c;
+    }
+  }
+  return values;
+}
+
 QgsFields QgsTinInterpolator::triangulationFields()
 {
   return Triangulation::triangulationFields();
@@ -166,6 +249,71 @@ void QgsTinInterpolator::initialize()
   }
 }
 
+void QgsTinInterpolator::buildLinearIndex()
+{
+  mLinearTriangles.clear();
+  mLinearBands.clear();
+
+  DualEdgeTriangulation *triangulation = dynamic_cast< DualEdgeTriangulation * >( mTriangulation );
+  if ( triangulation )
+  {
+    const QVector< int > indexes = triangulation->getTriangleVertexIndexes();
+    mLinearTriangles.reserve( indexes.size() / 3 );
+    for ( int i = 0; i + 2 < indexes.size(); i += 3 )
+    {
+      const QgsPoint *pt1 = triangulation->getPoint( indexes.at( i ) );
+      const QgsPoint *pt2 = triangulation->getPoint( indexes.at( i + 1 ) );
+      const QgsPoint *pt3 = triangulation->getPoint( indexes.at( i + 2 ) );
+      if ( !pt1 || !pt2 || !pt3 )
+        continue;
+
+      // same plane as calculated by LinTriangleInterpolator
+      const double denominatorA = ( pt1->x() - pt2->x() ) * ( pt2->y() - pt3->y() ) - ( pt2->x() - pt3->x() ) * ( pt1->y() - pt2->y() );
+      const double denominatorB = ( pt1->y() - pt2->y() ) * ( pt2->x() - pt3->x() ) - ( pt2->y() - pt3->y() ) * ( pt1->x() - pt2->x() );
+      if ( denominatorA == 0.0 || denominatorB == 0.0 )
+        continue;
+
+      LinearTriangle triangle;
+      triangle.x[0] = pt1->x();
+      triangle.x[1] = pt2->x();
+      triangle.x[2] = pt3->x();
+      triangle.y[0] = pt1->y();
+      triangle.y[1] = pt2->y();
+      triangle.y[2] = pt3->y();
+      triangle.yMin = std::min( std::min( pt1->y(), pt2->y() ), pt3->y() );
+      triangle.yMax = std::max( std::max( pt1->y(), pt2->y() ), pt3->y() );
+      triangle.a = ( pt1->z() * ( pt2->y() - pt3->y() ) + pt2->z() * ( pt3->y() - pt1->y() ) + pt3->z() * ( pt1->y() - pt2->y() ) ) / denominatorA;
+      triangle.b = ( pt1->z() * ( pt2->x() - pt3->x() ) + pt2->z() * ( pt3->x() - pt1->x() ) + pt3->z() * ( pt1->x() - pt2->x() ) ) / denominatorB;
+      triangle.c = pt1->z() - triangle.a * pt1->x() - triangle.b * pt1->y();
+      mLinearTriangles.append( triangle );
+    }
+  }
+
+  // a row crosses about sqrt(n) triangles, so bands of similar count are a good balance
+  double yMin = std::numeric_limits<double>::max();
+  double yMax = std::numeric_limits<double>::lowest();
+  for ( const LinearTriangle &triangle : qgis::as_const( mLinearTriangles ) )
+  {
+    yMin = std::min( yMin, triangle.yMin );
+    yMax = std::max( yMax, triangle.yMax );
+  }
+  const int bandCount = std::max( 1, static_cast< int >( std::sqrt( mLinearTriangles.size() ) ) );
+  mLinearBandsYMin = mLinearTriangles.isEmpty() ? 0 : yMin;
+  mLinearBandHeight = mLinearTriangles.isEmpty() || !( yMax > yMin ) ? 1 : ( yMax - yMin ) / bandCount;
+  mLinearBands.resize( bandCount );
+
+  auto bandIndex = [this, bandCount]( double y )
+  {
+    return static_cast< int >( std::max( 0.0, std::min( std::floor( ( y - mLinearBandsYMin ) / mLinearBandHeight ), bandCount - 1.0 ) ) );
+  };
+  for ( int i = 0; i < mLinearTriangles.size(); ++i )
+  {
+    const int lastBand = bandIndex( mLinearTriangles.at( i ).yMax );
+    for ( int band = bandIndex( mLinearTriangles.at( i ).yMin ); band <= lastBand; ++band )
+      mLinearBands[band].append( i );
+  }
+}
+
 int QgsTinInterpolator::insertData( const QgsFeature &f, QgsInterpolator::ValueSource source, int attr, SourceType type )
 {
   QgsGeometry g = f.geometry();
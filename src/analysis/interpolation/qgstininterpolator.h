@@ -55,6 +55,14 @@ class ANALYSIS_EXPORT QgsTinInterpolator: public QgsInterpolator
 
     int interpolatePoint( double x, double y, double &result SIP_OUT, QgsFeedback *feedback ) override;
 
+    /**
+     * Builds the triangulation. For linear interpolation, the triangles are
+     * additionally indexed for fast and thread safe interpolation of rows.
+     */
+    QgsInterpolator::Result prepare( QgsFeedback *feedback = nullptr ) override;
+    QVector< double > interpolateRow( double x, double y, double xStep, int count, QgsFeedback *feedback = nullptr ) override;
+    bool supportsParallelInterpolation() const override { return mInterpolation == Linear; }
+
     /**
      * Returns the fields output by features when saving the triangulation.
      * These fields should be used when creating
@@ -86,9 +94,32 @@ class ANALYSIS_EXPORT QgsTinInterpolator: public QgsInterpolator
     //! Type of interpolation
     TinInterpolation mInterpolation;
 
+    //! Vertices and plane of a triangle for linear interpolation of rows
+    struct LinearTriangle
+    {
+      double x[3];
+      double y[3];
+      double yMin;
+      double yMax;
+      //! Coefficients of the plane z = a * x + b * y + c
+      double a;
+      double b;
+      double c;
+    };
+
+    //! Triangles of the triangulation, for linear interpolation
+    QVector< LinearTriangle > mLinearTriangles;
+    //! Indexes of the triangles overlapping each horizontal band
+    QVector< QVector< int > > mLinearBands;
+    double mLinearBandsYMin = 0;
+    double mLinearBandHeight = 1;
+
     //! Create dual edge triangulation
     void initialize();
 
+    //! Builds the triangle index for linear interpolation of rows
+    void buildLinearIndex();
+
     /**
      * Inserts the vertices of a feature into the triangulation
      * \param f the feature
@@ -13,18 +13,26 @@
 *                                                                          *
 ***************************************************************************/
 
+#include <functional>
 #include <limits>
+#include <queue>
+#include <vector>
 
-#include <QMap>
 #include <QVector>
-#include <QPair>
 
 #include "qgsgraph.h"
 #include "qgsgraphanalyzer.h"
 
-void QgsGraphAnalyzer::dijkstra( const QgsGraph *source, int startPointIdx, int criterionNum, QVector<int> *resultTree, QVector<double> *resultCost )
+///@cond PRIVATE
+
+/**
+ * Runs Dijkstra's algorithm from \a rootVertexIdx. If \a reverse is TRUE, edges are
+ * followed against their direction, so the costs are those of the paths from every
+ * vertex to the root vertex.
+ */
+static void dijkstraSearch( const QgsGraph *source, int rootVertexIdx, int criterionNum, bool reverse, QVector<int> *resultTree, QVector<double> *resultCost )
 {
-  if ( startPointIdx < 0 || startPointIdx >= source->vertexCount() )
+  if ( rootVertexIdx < 0 || rootVertexIdx >= source->vertexCount() )
   {
     // invalid start point
     return;
@@ -42,7 +50,7 @@ void QgsGraphAnalyzer::dijkstra( const QgsGraph *source, int startPointIdx, int
 
   result->clear();
   result->insert( result->begin(), source->vertexCount(), std::numeric_limits<double>::infinity() );
-  ( *result )[ startPointIdx ] = 0.0;
+  ( *result )[ rootVertexIdx ] = 0.0;
 
   if ( resultTree )
   {
@@ -50,35 +58,38 @@ void QgsGraphAnalyzer::dijkstra( const QgsGraph *source, int startPointIdx, int
     resultTree->insert( resultTree->begin(), source->vertexCount(), -1 );
   }
 
-  // QMultiMap< cost, vertexIdx > not_begin
-  // I use it and don't create any struct or class
-  QMultiMap< double, int > not_begin;
-  QMultiMap< double, int >::iterator it;
-
-  not_begin.insert( 0.0, startPointIdx );
+  // binary heap of ( cost, vertexIdx ) with the cheapest entry on top. Vertices are pushed again
+  // when a cheaper path to them is found, outdated entries are skipped when popped.
+  typedef std::pair< double, int > CostVertex;
+  std::priority_queue< CostVertex, std::vector< CostVertex >, std::greater< CostVertex > > queue;
+  queue.push( CostVertex( 0.0, rootVertexIdx ) );
 
-  while ( !not_begin.empty() )
+  while ( !queue.empty() )
   {
-    it = not_begin.begin();
-    double curCost = it.key();
-    int curVertex = it.value();
-    not_begin.erase( it );
+    const double curCost = queue.top().first;
+    const int curVertex = queue.top().second;
+    queue.pop();
+
+    if ( curCost > ( *result )[ curVertex ] )
+      continue;
 
     // edge index list
-    const QgsGraphEdgeIds &outgoingEdges = source->vertex( curVertex ).outgoingEdges();
-    for ( int edgeId : outgoingEdges )
+    const QgsGraphVertex &vertex = source->vertex( curVertex );
+    const QgsGraphEdgeIds edges = reverse ? vertex.incomingEdges() : vertex.outgoingEdges();
+    for ( int edgeId : edges )
     {
       const QgsGraphEdge &arc = source->edge( edgeId );
+      const int nextVertex = reverse ? arc.fromVertex() : arc.toVertex();
       double cost = arc.cost( criterionNum ).toDouble() + curCost;
 
-      if ( cost < ( *result )[ arc.toVertex()] )
+      if ( cost < ( *result )[ nextVertex ] )
       {
-        ( *result )[ arc.toVertex()] = cost;
+        ( *result )[ nextVertex ] = cost;
         if ( resultTree )
         {
-          ( *resultTree )[ arc.toVertex()] = edgeId;
+          ( *resultTree )[ nextVertex ] = edgeId;
         }
-        not_begin.insert( cost, arc.toVertex() );
+        queue.push( CostVertex( cost, nextVertex ) );
       }
     }
   }
@@ -88,6 +99,18 @@ void QgsGraphAnalyzer::dijkstra( const QgsGraph *source, int startPointIdx, int
   }
 }
 
+///@endcond
+
+void QgsGraphAnalyzer::dijkstra( const QgsGraph *source, int startPointIdx, int criterionNum, QVector<int> *resultTree, QVector<double> *resultCost )
+{
+  dijkstraSearch( source, startPointIdx, criterionNum, false, resultTree, resultCost );
+}
+
+void QgsGraphAnalyzer::reverseDijkstra( const QgsGraph *source, int endVertexIdx, int criterionNum, QVector<int> *resultTree, QVector<double> *resultCost )
+{
+  dijkstraSearch( source, endVertexIdx, criterionNum, true, resultTree, resultCost );
+}
+
 QgsGraph *QgsGraphAnalyzer::shortestTree( const QgsGraph *source, int startVertexIdx, int criterionNum )
 {
   QgsGraph *treeResult = new QgsGraph();
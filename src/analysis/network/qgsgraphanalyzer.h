@@ -31,6 +31,53 @@ class QgsGraph;
 
 class ANALYSIS_EXPORT QgsGraphAnalyzer
 {
+
+#ifdef SIP_RUN
+    % TypeCode
+    // Builds the ( tree, cost ) tuple returned by dijkstra() and reverseDijkstra()
+    static PyObject *qgsGraphAnalyzer_treeAndCost( const QVector< int > &tree, const QVector< double > &cost )
+    {
+      PyObject *l1 = PyList_New( tree.size() );
+      if ( l1 == NULL )
+        return NULL;
+
+      PyObject *l2 = PyList_New( cost.size() );
+      if ( l2 == NULL )
+      {
+        Py_DECREF( l1 );
+        return NULL;
+      }
+
+      for ( int i = 0; i < cost.size(); ++i )
+      {
+        PyObject *Int = PyLong_FromLong( tree[i] );
+        PyObject *Float = PyFloat_FromDouble( cost[i] );
+        if ( Int == NULL || Float == NULL )
+        {
+          Py_XDECREF( Int );
+          Py_XDECREF( Float );
+          Py_DECREF( l1 );
+          Py_DECREF( l2 );
+          return NULL;
+        }
+        PyList_SET_ITEM( l1, i, Int );
+        PyList_SET_ITEM( l2, i, Float );
+      }
+
+      PyObject *result = PyTuple_New( 2 );
+      if ( result == NULL )
+      {
+        Py_DECREF( l1 );
+        Py_DECREF( l2 );
+        return NULL;
+      }
+      PyTuple_SET_ITEM( result, 0, l1 );
+      PyTuple_SET_ITEM( result, 1, l2 );
+      return result;
+    }
+    % End
+#endif
+
   public:
 
     /**
@@ -50,28 +97,39 @@ class ANALYSIS_EXPORT QgsGraphAnalyzer
     QVector< double > costResult;
     QgsGraphAnalyzer::dijkstra( a0, a1, a2, &treeResult, &costResult );
 
-    PyObject *l1 = PyList_New( treeResult.size() );
-    if ( l1 == NULL )
-    {
-      return NULL;
-    }
-    PyObject *l2 = PyList_New( costResult.size() );
-    if ( l2 == NULL )
-    {
-      return NULL;
-    }
-    int i;
-    for ( i = 0; i < costResult.size(); ++i )
-    {
-      PyObject *Int = PyLong_FromLong( treeResult[i] );
-      PyList_SET_ITEM( l1, i, Int );
-      PyObject *Float = PyFloat_FromDouble( costResult[i] );
-      PyList_SET_ITEM( l2, i, Float );
-    }
+    sipRes = qgsGraphAnalyzer_treeAndCost( treeResult, costResult );
+    if ( sipRes == NULL )
+      sipIsErr = 1;
+    % End
+#endif
+
+    /**
+     * Solve shortest path problem from all vertices to a single end vertex, using Dijkstra algorithm
+     * on the reversed graph.
+     *
+     * This calculates the shortest paths from any number of start points to a common destination
+     * with a single search.
+     *
+     * \param source source graph
+     * \param endVertexIdx index of the end vertex
+     * \param criterionNum index of the optimization strategy
+     * \param resultTree array that represents shortest path tree towards the end vertex. resultTree[ vertexIndex ] == outgoingArcIndex if the end vertex can be reached from the vertex, otherwise resultTree[ vertexIndex ] == -1.
+     * Note that the endVertexIdx will also have a value of -1 and may need special handling by callers.
+     * \param resultCost array of the paths costs to the end vertex
+     *
+     * \since QGIS 3.10
+     */
+    static void SIP_PYALTERNATIVETYPE( SIP_PYLIST ) reverseDijkstra( const QgsGraph *source, int endVertexIdx, int criterionNum, QVector<int> *resultTree = nullptr, QVector<double> *resultCost = nullptr );
+
+#ifdef SIP_RUN
+    % MethodCode
+    QVector< int > treeResult;
+    QVector< double > costResult;
+    QgsGraphAnalyzer::reverseDijkstra( a0, a1, a2, &treeResult, &costResult );
 
-    sipRes = PyTuple_New( 2 );
-    PyTuple_SET_ITEM( sipRes, 0, l1 );
-    PyTuple_SET_ITEM( sipRes, 1, l2 );
+    sipRes = qgsGraphAnalyzer_treeAndCost( treeResult, costResult );
+    if ( sipRes == NULL )
+      sipIsErr = 1;
     % End
 #endif
 
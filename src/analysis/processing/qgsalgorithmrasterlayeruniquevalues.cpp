@@ -130,6 +130,8 @@ QVariantMap QgsRasterLayerUniqueValuesReportAlgorithm::processAlgorithm( const Q
   int nbBlocks = nbBlocksWidth * nbBlocksHeight;
 
   QgsRasterIterator iter( mInterface.get() );
+  iter.setAlignToSourceBlocks( true );
+  iter.setReadAheadEnabled( true );
   iter.startRasterRead( mBand, mLayerWidth, mLayerHeight, mExtent );
 
   int iterLeft = 0;
@@ -153,6 +153,8 @@ QVariantMap QgsRasterSurfaceVolumeAlgorithm::processAlgorithm( const QVariantMap
   int nbBlocks = nbBlocksWidth * nbBlocksHeight;
 
   QgsRasterIterator iter( mInterface.get() );
+  iter.setAlignToSourceBlocks( true );
+  iter.setReadAheadEnabled( true );
   iter.startRasterRead( mBand, mLayerWidth, mLayerHeight, mExtent );
 
   int iterLeft = 0;
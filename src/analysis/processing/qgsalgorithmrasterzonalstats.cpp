@@ -205,8 +205,9 @@ QVariantMap QgsRasterLayerZonalStatsAlgorithm::processAlgorithm( const QVariantM
   int nbBlocksHeight = static_cast< int >( std::ceil( 1.0 * mLayerHeight / maxHeight ) );
   int nbBlocks = nbBlocksWidth * nbBlocksHeight;
 
-  QgsRasterIterator iter = mRefLayer == Source ? QgsRasterIterator( mSourceInterface )
-                           : QgsRasterIterator( mZonesInterface );
+  QgsRasterIterator iter( mRefLayer == Source ? mSourceInterface : mZonesInterface );
+  iter.setAlignToSourceBlocks( true );
+  iter.setReadAheadEnabled( true );
   iter.startRasterRead( mRefLayer == Source ? mBand : mZonesBand, mLayerWidth, mLayerHeight, mExtent );
 
   int iterLeft = 0;
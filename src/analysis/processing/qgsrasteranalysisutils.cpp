@@ -20,6 +20,10 @@
 #include "qgsrasteriterator.h"
 #include "qgsgeos.h"
 #include "qgsprocessingparameters.h"
+#include "qgscurvepolygon.h"
+#include "qgslinestring.h"
+#include <algorithm>
+#include <cmath>
 #include <map>
 ///@cond PRIVATE
 
@@ -56,108 +60,332 @@ void QgsRasterAnalysisUtils::cellInfoForBBox( const QgsRectangle &rasterBBox, co
                                     rasterBBox.yMaximum() - ( nCellsY + offsetY ) * cellSizeY );
 }
 
+/**
+ * Scanline rasterizer for polygons over a grid of cells.
+ *
+ * Polygon edges are converted to grid coordinates (columns from the left and rows from the
+ * top of the grid, in cell units) and bucketed by the rows they cross, so that each row
+ * only visits the edges which actually cross it. Rows must be processed from top to bottom.
+ */
+class QgsScanlinePolygonRasterizer
+{
+  public:
+
+    QgsScanlinePolygonRasterizer( const QgsGeometry &poly, const QgsRectangle &gridExtent, int nCellsX, int nCellsY, double cellSizeX, double cellSizeY )
+      : mCols( nCellsX )
+      , mRows( nCellsY )
+    {
+      std::unique_ptr< QgsAbstractGeometry > segmentized;
+      const QgsAbstractGeometry *geom = poly.constGet();
+      if ( !geom )
+        return;
+      if ( QgsWkbTypes::isCurvedType( geom->wkbType() ) )
+      {
+        segmentized.reset( geom->segmentize() );
+        geom = segmentized.get();
+      }
+
+      for ( auto partIt = geom->const_parts_begin(); partIt != geom->const_parts_end(); ++partIt )
+      {
+        const QgsCurvePolygon *polygon = qgsgeometry_cast< const QgsCurvePolygon * >( *partIt );
+        if ( !polygon )
+          continue;
+
+        addRing( qgsgeometry_cast< const QgsLineString * >( polygon->exteriorRing() ), true, gridExtent, cellSizeX, cellSizeY );
+        for ( int i = 0; i < polygon->numInteriorRings(); ++i )
+          addRing( qgsgeometry_cast< const QgsLineString * >( polygon->interiorRing( i ) ), false, gridExtent, cellSizeX, cellSizeY );
+      }
+
+      std::sort( mEdges.begin(), mEdges.end(), []( const Edge & a, const Edge & b ) { return a.firstRow < b.firstRow; } );
+      mCoveredAbove.fill( 0.0, mCols );
+    }
+
+    /**
+     * Returns the ranges of columns within \a row whose cell center is inside the polygon,
+     * as pairs of first and last column.
+     */
+    QVector< QPair< int, int > > centerColumns( int row )
+    {
+      advanceTo( row, false );
+
+      const double v = row + 0.5;
+      QVector< double > crossings;
+      for ( const Edge *edge : qgis::as_const( mActiveEdges ) )
+      {
+        if ( ( edge->v1 > v ) != ( edge->v2 > v ) )
+          crossings << edge->u1 + ( v - edge->v1 ) * ( edge->u2 - edge->u1 ) / ( edge->v2 - edge->v1 );
+      }
+      std::sort( crossings.begin(), crossings.end() );
+
+      // even-odd rule, cells with their center exactly on the boundary are outside (as with a contains test)
+      QVector< QPair< int, int > > ranges;
+      for ( int i = 0; i + 1 < crossings.size(); i += 2 )
+      {
+        const int first = std::max( 0, static_cast< int >( std::floor( crossings.at( i ) - 0.5 ) ) + 1 );
+        const int last = std::min( mCols - 1, static_cast< int >( std::ceil( crossings.at( i + 1 ) - 0.5 ) ) - 1 );
+        if ( first <= last )
+          ranges << qMakePair( first, last );
+      }
+      return ranges;
+    }
+
+    /**
+     * Returns the fraction of the area of each cell in \a row which is covered by the polygon.
+     *
+     * The covered area of a cell is the integral of the boundary with the vertical extent of the
+     * edges clamped to the cell's row (Green's theorem, restricted to the cell's column). Edges
+     * fully above the row contribute their whole width, which is accumulated once per edge.
+     */
+    QVector< double > coverage( int row )
+    {
+      advanceTo( row, true );
+
+      QVector< double > result = mCoveredAbove;
+      for ( const Edge *edge : qgis::as_const( mActiveEdges ) )
+        addEdgeCoverage( *edge, row, result );
+
+      for ( double &value : result )
+        value = value < 1e-10 ? 0 : std::min( value, 1.0 );
+      return result;
+    }
+
+  private:
+
+    struct Edge
+    {
+      double u1 = 0;
+      double v1 = 0;
+      double u2 = 0;
+      double v2 = 0;
+      //! +1 or -1, so that the area of all exterior rings adds and the area of holes subtracts
+      double sign = 1;
+      //! First row crossed by the edge
+      int firstRow = 0;
+      //! Last row crossed by the edge, the edge is above all rows after this one
+      int lastRow = 0;
+    };
+
+    void addRing( const QgsLineString *ring, bool exterior, const QgsRectangle &gridExtent, double cellSizeX, double cellSizeY )
+    {
+      if ( !ring || ring->numPoints() < 3 )
+        return;
+
+      const int n = ring->numPoints();
+      QVector< double > u( n );
+      QVector< double > v( n );
+      double area = 0;
+      for ( int i = 0; i < n; ++i )
+      {
+        u[ i ] = ( ring->xAt( i ) - gridExtent.xMinimum() ) / cellSizeX;
+        v[ i ] = ( gridExtent.yMaximum() - ring->yAt( i ) ) / cellSizeY;
+        if ( i > 0 )
+          area += u[ i - 1 ] * v[ i ] - u[ i ] * v[ i - 1 ];
+      }
+      const double ringSign = ( area >= 0 ) == exterior ? 1 : -1;
+
+      for ( int i = 1; i < n; ++i )
+      {
+        Edge edge;
+        edge.u1 = u[ i - 1 ];
+        edge.v1 = v[ i - 1 ];
+        edge.u2 = u[ i ];
+        edge.v2 = v[ i ];
+        edge.sign = ringSign;
+        const double vMin = std::min( edge.v1, edge.v2 );
+        const double vMax = std::max( edge.v1, edge.v2 );
+        edge.firstRow = static_cast< int >( std::floor( vMin ) );
+        edge.lastRow = static_cast< int >( std::ceil( vMax ) ) - 1;
+        if ( edge.firstRow >= mRows )
+          continue;
+
+        // edges right of the grid don't cover any cell, but they are still needed for the crossing
+        // parity of polygons extending past the grid, so they are moved to its right border
+        if ( std::min( edge.u1, edge.u2 ) >= mCols )
+        {
+          edge.u1 = mCols;
+          edge.u2 = mCols;
+        }
+
+        mEdges.append( edge );
+      }
+    }
+
+    //! Activates the edges crossing \a row and retires the ones above it
+    void advanceTo( int row, bool accumulateCoverage )
+    {
+      while ( mNextEdge < mEdges.size() && mEdges.at( mNextEdge ).firstRow <= row )
+      {
+        const Edge &edge = mEdges.at( mNextEdge++ );
+        if ( edge.lastRow < row )
+        {
+          if ( accumulateCoverage )
+            addCoverage( edge.u1, edge.u2, 1, 1, edge.sign, mCoveredAbove );
+        }
+        else
+        {
+          mActiveEdges.append( &edge );
+        }
+      }
+
+      for ( int i = mActiveEdges.size() - 1; i >= 0; --i )
+      {
+        const Edge *edge = mActiveEdges.at( i );
+        if ( edge->lastRow < row )
+        {
+          if ( accumulateCoverage )
+            addCoverage( edge->u1, edge->u2, 1, 1, edge->sign, mCoveredAbove );
+          mActiveEdges.remove( i );
+        }
+      }
+    }
+
+    //! Adds the coverage of the part of \a edge crossing \a row to \a result
+    void addEdgeCoverage( const Edge &edge, int row, QVector< double > &result ) const
+    {
+      if ( qgsDoubleNear( edge.u1, edge.u2, 0 ) )
+        return; // vertical edges don't cover anything
+
+      // split the edge where it enters and leaves the row
+      double t[4] = { 0, 0, 0, 1 };
+      int splits = 1;
+      const double dv = edge.v2 - edge.v1;
+      if ( !qgsDoubleNear( dv, 0, 0 ) )
+      {
+        for ( double boundary : { static_cast< double >( row ), row + 1.0 } )
+        {
+          const double tb = ( boundary - edge.v1 ) / dv;
+          if ( tb > 0 && tb < 1 )
+            t[ splits++ ] = tb;
+        }
+      }
+      t[ splits ] = 1;
+      std::sort( t + 1, t + splits );
+
+      for ( int i = 0; i < splits; ++i )
+      {
+        const double ua = edge.u1 + t[ i ] * ( edge.u2 - edge.u1 );
+        const double ub = edge.u1 + t[ i + 1 ] * ( edge.u2 - edge.u1 );
+        const double va = edge.v1 + t[ i ] * dv;
+        const double vb = edge.v1 + t[ i + 1 ] * dv;
+        // height of the row below the segment, which is linear within the segment
+        const double ha = row + 1 - qBound( static_cast< double >( row ), va, row + 1.0 );
+        const double hb = row + 1 - qBound( static_cast< double >( row ), vb, row + 1.0 );
+        addCoverage( ua, ub, ha, hb, edge.sign, result );
+      }
+    }
+
+    /**
+     * Adds the signed area below a segment from \a u1 to \a u2 with linearly changing
+     * height from \a h1 to \a h2 to the cells of \a result it spans.
+     */
+    void addCoverage( double u1, double u2, double h1, double h2, double sign, QVector< double > &result ) const
+    {
+      if ( qgsDoubleNear( u1, u2, 0 ) || ( h1 <= 0 && h2 <= 0 ) )
+        return;
+
+      const double uMin = std::max( 0.0, std::min( u1, u2 ) );
+      const double uMax = std::min( static_cast< double >( mCols ), std::max( u1, u2 ) );
+      const double direction = u2 > u1 ? sign : -sign;
+      const double slope = ( h2 - h1 ) / ( u2 - u1 );
+
+      double *data = result.data();
+      for ( int col = static_cast< int >( std::floor( uMin ) ); col < mCols && col < uMax; ++col )
+      {
+        const double a = std::max( uMin, static_cast< double >( col ) );
+        const double b = std::min( uMax, col + 1.0 );
+        if ( b <= a )
+          continue;
+
+        const double heightA = h1 + ( a - u1 ) * slope;
+        const double heightB = h1 + ( b - u1 ) * slope;
+        data[ col ] += direction * ( b - a ) * ( heightA + heightB ) * 0.5;
+      }
+    }
+
+    int mCols = 0;
+    int mRows = 0;
+    QVector< Edge > mEdges;
+    int mNextEdge = 0;
+    QVector< const Edge * > mActiveEdges;
+    //! Covered width of each column from the edges which are above the current row
+    QVector< double > mCoveredAbove;
+};
+
+/**
+ * Prepares a raster iterator for reading \a nCellsY rows of \a nCellsX cells as blocks spanning all
+ * columns, so that the rows are read from top to bottom.
+ */
+static void prepareRowIterator( QgsRasterIterator &iter, int rasterBand, int nCellsX, int nCellsY, const QgsRectangle &rasterBBox )
+{
+  const int maxCells = QgsRasterIterator::DEFAULT_MAXIMUM_TILE_WIDTH * QgsRasterIterator::DEFAULT_MAXIMUM_TILE_HEIGHT;
+  iter.setMaximumTileWidth( std::max( nCellsX, 1 ) );
+  iter.setMaximumTileHeight( std::max( 1, maxCells / std::max( nCellsX, 1 ) ) );
+  iter.startRasterRead( rasterBand, nCellsX, nCellsY, rasterBBox );
+}
+
 void QgsRasterAnalysisUtils::statisticsFromMiddlePointTest( QgsRasterInterface *rasterInterface, int rasterBand, const QgsGeometry &poly, int nCellsX, int nCellsY, double cellSizeX, double cellSizeY, const QgsRectangle &rasterBBox,  const std::function<void( double )> &addValue, bool skipNodata )
 {
-  std::unique_ptr< QgsGeometryEngine > polyEngine( QgsGeometry::createGeometryEngine( poly.constGet( ) ) );
-  if ( !polyEngine )
-  {
-    return;
-  }
-  polyEngine->prepareGeometry();
+  QgsScanlinePolygonRasterizer rasterizer( poly, rasterBBox, nCellsX, nCellsY, cellSizeX, cellSizeY );
 
   QgsRasterIterator iter( rasterInterface );
-  iter.startRasterRead( rasterBand, nCellsX, nCellsY, rasterBBox );
+  prepareRowIterator( iter, rasterBand, nCellsX, nCellsY, rasterBBox );
 
   std::unique_ptr< QgsRasterBlock > block;
   int iterLeft = 0;
   int iterTop = 0;
   int iterCols = 0;
   int iterRows = 0;
-  QgsRectangle blockExtent;
   bool isNoData = false;
-  while ( iter.readNextRasterPart( rasterBand, iterCols, iterRows, block, iterLeft, iterTop, &blockExtent ) )
+  while ( iter.readNextRasterPart( rasterBand, iterCols, iterRows, block, iterLeft, iterTop ) )
   {
-    double cellCenterY = blockExtent.yMaximum() - 0.5 * cellSizeY;
-
     for ( int row = 0; row < iterRows; ++row )
     {
-      double cellCenterX = blockExtent.xMinimum() + 0.5 * cellSizeX;
-      for ( int col = 0; col < iterCols; ++col )
+      const QVector< QPair< int, int > > ranges = rasterizer.centerColumns( iterTop + row );
+      for ( const QPair< int, int > &range : ranges )
       {
-        const double pixelValue = block->valueAndNoData( row, col, isNoData );
-        if ( validPixel( pixelValue ) && ( !skipNodata || !isNoData ) )
+        for ( int col = range.first; col <= range.second && col < iterCols; ++col )
         {
-          QgsPoint cellCenter( cellCenterX, cellCenterY );
-          if ( polyEngine->contains( &cellCenter ) )
+          const double pixelValue = block->valueAndNoData( row, col, isNoData );
+          if ( validPixel( pixelValue ) && ( !skipNodata || !isNoData ) )
           {
             addValue( pixelValue );
           }
         }
-        cellCenterX += cellSizeX;
       }
-      cellCenterY -= cellSizeY;
     }
   }
 }
 
 void QgsRasterAnalysisUtils::statisticsFromPreciseIntersection( QgsRasterInterface *rasterInterface, int rasterBand, const QgsGeometry &poly, int nCellsX, int nCellsY, double cellSizeX, double cellSizeY, const QgsRectangle &rasterBBox,  const std::function<void( double, double )> &addValue, bool skipNodata )
 {
-  QgsGeometry pixelRectGeometry;
-
-  double hCellSizeX = cellSizeX / 2.0;
-  double hCellSizeY = cellSizeY / 2.0;
-  double pixelArea = cellSizeX * cellSizeY;
-  double weight = 0;
-
-  std::unique_ptr< QgsGeometryEngine > polyEngine( QgsGeometry::createGeometryEngine( poly.constGet( ) ) );
-  if ( !polyEngine )
-  {
-    return;
-  }
-  polyEngine->prepareGeometry();
+  QgsScanlinePolygonRasterizer rasterizer( poly, rasterBBox, nCellsX, nCellsY, cellSizeX, cellSizeY );
 
   QgsRasterIterator iter( rasterInterface );
-  iter.startRasterRead( rasterBand, nCellsX, nCellsY, rasterBBox );
+  prepareRowIterator( iter, rasterBand, nCellsX, nCellsY, rasterBBox );
 
   std::unique_ptr< QgsRasterBlock > block;
   int iterLeft = 0;
   int iterTop = 0;
   int iterCols = 0;
   int iterRows = 0;
-  QgsRectangle blockExtent;
   bool isNoData = false;
-  while ( iter.readNextRasterPart( rasterBand, iterCols, iterRows, block, iterLeft, iterTop, &blockExtent ) )
+  while ( iter.readNextRasterPart( rasterBand, iterCols, iterRows, block, iterLeft, iterTop ) )
   {
-    double currentY = blockExtent.yMaximum() - 0.5 * cellSizeY;
     for ( int row = 0; row < iterRows; ++row )
     {
-      double currentX = blockExtent.xMinimum() + 0.5 * cellSizeX;
+      const QVector< double > coverage = rasterizer.coverage( iterTop + row );
       for ( int col = 0; col < iterCols; ++col )
       {
+        const double weight = coverage.at( col );
+        if ( weight <= 0 )
+          continue;
+
         const double pixelValue = block->valueAndNoData( row, col, isNoData );
         if ( validPixel( pixelValue ) && ( !skipNodata || !isNoData ) )
         {
-          pixelRectGeometry = QgsGeometry::fromRect( QgsRectangle( currentX - hCellSizeX, currentY - hCellSizeY, currentX + hCellSizeX, currentY + hCellSizeY ) );
-          // GEOS intersects tests on prepared geometry is MAGNITUDES faster than calculating the intersection itself,
-          // so we first test to see if there IS an intersection before doing the actual calculation
-          if ( !pixelRectGeometry.isNull() && polyEngine->intersects( pixelRectGeometry.constGet() ) )
-          {
-            //intersection
-            QgsGeometry intersectGeometry = pixelRectGeometry.intersection( poly );
-            if ( !intersectGeometry.isEmpty() )
-            {
-              double intersectionArea = intersectGeometry.area();
-              if ( intersectionArea > 0.0 )
-              {
-                weight = intersectionArea / pixelArea;
-                addValue( pixelValue, weight );
-              }
-            }
-          }
+          addValue( pixelValue, weight );
         }
-        currentX += cellSizeX;
       }
-      currentY -= cellSizeY;
     }
   }
 }
@@ -69,6 +69,8 @@ void QgsReclassifyUtils::reclassify( const QVector<QgsReclassifyUtils::RasterCla
   int maxHeight = QgsRasterIterator::DEFAULT_MAXIMUM_TILE_HEIGHT;
 
   QgsRasterIterator iter( sourceRaster );
+  iter.setAlignToSourceBlocks( true );
+  iter.setReadAheadEnabled( true );
   iter.startRasterRead( band, sourceWidthPixels, sourceHeightPixels, extent );
 
   int nbBlocksWidth = static_cast< int >( std::ceil( 1.0 * sourceWidthPixels / maxWidth ) );
@@ -16,15 +16,30 @@
 #include "qgsalignraster.h"
 
 #include <gdalwarper.h>
+#include <gdal_vrt.h>
 #include <ogr_srs_api.h>
 #include <cpl_conv.h>
+#include <cpl_string.h>
 #include <limits>
+#include <numeric>
 
+#include <QMutex>
 #include <QPair>
 #include <QString>
+#include <QTemporaryDir>
+#include <QThread>
+#include <QThreadPool>
+#include <QWaitCondition>
+#include <QtConcurrentMap>
 
 #include "qgscoordinatereferencesystem.h"
+#include "qgsfeedback.h"
 #include "qgsrectangle.h"
+#include "qgsrasterfilewriter.h"
+#include "qgsrasterpipe.h"
+#include "qgsrasterdataprovider.h"
+#include "qgsproviderregistry.h"
+#include "qgscoordinatetransformcontext.h"
 
 
 static double ceil_with_tolerance( double value )
@@ -60,13 +75,51 @@ static QgsRectangle transform_to_extent( const double *geotransform, double xSiz
 }
 
 
+///@cond PRIVATE
+
+//! Progress of all rasters which are aligned concurrently
+struct QgsAlignRasterSharedProgress
+{
+  QMutex mutex;
+  QWaitCondition progressChanged;
+  QVector< double > progress;
+  bool canceled = false;
+};
+
+//! Progress of a single raster
+struct QgsAlignRasterProgress
+{
+  QgsFeedback *feedback = nullptr;
+  //! Progress handler called directly, if the raster is not aligned concurrently
+  QgsAlignRaster::ProgressHandler *handler = nullptr;
+  QgsAlignRasterSharedProgress *shared = nullptr;
+  int index = 0;
+};
+
+///@endcond
+
 static int CPL_STDCALL _progress( double dfComplete, const char *pszMessage, void *pProgressArg )
 {
   Q_UNUSED( pszMessage )
 
-  QgsAlignRaster::ProgressHandler *handler = ( ( QgsAlignRaster * ) pProgressArg )->progressHandler();
-  if ( handler )
-    return handler->progress( dfComplete );
+  QgsAlignRasterProgress *progress = static_cast< QgsAlignRasterProgress * >( pProgressArg );
+  if ( progress->feedback )
+  {
+    progress->feedback->setProgress( 100.0 * dfComplete );
+    if ( progress->feedback->isCanceled() )
+      return false;
+  }
+
+  if ( progress->shared )
+  {
+    QMutexLocker locker( &progress->shared->mutex );
+    progress->shared->progress[ progress->index ] = dfComplete;
+    progress->shared->progressChanged.wakeAll();
+    return !progress->shared->canceled;
+  }
+
+  if ( progress->handler )
+    return progress->handler->progress( dfComplete );
   else
     return true;
 }
@@ -363,12 +416,102 @@ bool QgsAlignRaster::run()
 
   //dump();
 
-  const auto constMRasters = mRasters;
-  for ( const Item &r : constMRasters )
+  // rasters which are only part of a stacked GeoTIFF may be aligned to temporary files
+  const bool stackedCopy = !mStackedOutputFilename.isEmpty() && !mStackedOutputFilename.endsWith( QLatin1String( ".vrt" ), Qt::CaseInsensitive );
+  std::unique_ptr< QTemporaryDir > tempDir;
+  QStringList outputFilenames;
+  for ( int i = 0; i < mRasters.count(); ++i )
+  {
+    QString outputFilename = mRasters.at( i ).outputFilename;
+    if ( outputFilename.isEmpty() && stackedCopy )
+    {
+      if ( !tempDir )
+        tempDir = qgis::make_unique< QTemporaryDir >();
+      outputFilename = tempDir->filePath( QStringLiteral( "aligned_%1.tif" ).arg( i ) );
+    }
+    outputFilenames << outputFilename;
+  }
+
+  // rasters are warped concurrently, each with a share of the available threads
+  const int rasterCount = mRasters.count();
+  const int concurrentRasters = std::max( 1, std::min( rasterCount, QThreadPool::globalInstance()->maxThreadCount() ) );
+  const int warpThreads = std::max( 1, QThread::idealThreadCount() / concurrentRasters );
+
+  QgsAlignRasterSharedProgress shared;
+  shared.progress.fill( 0, rasterCount );
+  QVector< QString > errors( rasterCount );
+
+  QVector< int > indexes( rasterCount );
+  std::iota( indexes.begin(), indexes.end(), 0 );
+
+  QFuture< void > future = QtConcurrent::map( indexes, [&]( int index )
+  {
+    {
+      QMutexLocker locker( &shared.mutex );
+      if ( shared.canceled )
+        return;
+    }
+
+    QgsAlignRasterProgress progress;
+    progress.feedback = mRasters.at( index ).feedback;
+    progress.shared = &shared;
+    progress.index = index;
+
+    QString error;
+    const bool result = warpRaster( mRasters.at( index ), outputFilenames.at( index ), warpThreads, &progress, error );
+
+    QMutexLocker locker( &shared.mutex );
+    if ( !result && !shared.canceled )
+    {
+      // the alignment fails anyway, don't start the remaining rasters
+      errors[ index ] = error;
+      shared.canceled = true;
+    }
+    shared.progress[ index ] = 1;
+    shared.progressChanged.wakeAll();
+  } );
+
+  // report the overall progress from this thread, the progress handler may update a GUI
+  shared.mutex.lock();
+  while ( !future.isFinished() )
+  {
+    shared.progressChanged.wait( &shared.mutex, 100 );
+
+    double complete = 0;
+    for ( double rasterProgress : qgis::as_const( shared.progress ) )
+      complete += rasterProgress;
+    complete /= std::max( 1, rasterCount );
+
+    if ( mProgressHandler )
+    {
+      shared.mutex.unlock();
+      const bool proceed = mProgressHandler->progress( complete );
+      shared.mutex.lock();
+      if ( !proceed )
+        shared.canceled = true;
+    }
+  }
+  const bool canceled = shared.canceled;
+  shared.mutex.unlock();
+  future.waitForFinished();
+
+  for ( const QString &error : qgis::as_const( errors ) )
   {
-    if ( !createAndWarp( r ) )
+    if ( !error.isEmpty() )
+    {
+      mErrorMessage = error;
       return false;
+    }
+  }
+  if ( canceled )
+  {
+    mErrorMessage = QObject::tr( "Alignment was canceled." );
+    return false;
   }
+
+  if ( !mStackedOutputFilename.isEmpty() && !createStackedOutput( outputFilenames ) )
+    return false;
+
   return true;
 }
 
@@ -419,11 +562,19 @@ int QgsAlignRaster::suggestedReferenceLayer() const
 
 
 bool QgsAlignRaster::createAndWarp( const Item &raster )
+{
+  QgsAlignRasterProgress progress;
+  progress.feedback = raster.feedback;
+  progress.handler = mProgressHandler;
+  return warpRaster( raster, raster.outputFilename, 1, &progress, mErrorMessage );
+}
+
+bool QgsAlignRaster::warpRaster( const Item &raster, const QString &outputFilename, int warpThreads, void *progressArg, QString &error ) const
 {
   GDALDriverH hDriver = GDALGetDriverByName( "GTiff" );
   if ( !hDriver )
   {
-    mErrorMessage = QStringLiteral( "GDALGetDriverByName(GTiff) failed." );
+    error = QStringLiteral( "GDALGetDriverByName(GTiff) failed." );
     return false;
   }
 
@@ -431,7 +582,7 @@ bool QgsAlignRaster::createAndWarp( const Item &raster )
   gdal::dataset_unique_ptr hSrcDS( GDALOpen( raster.inputFilename.toLocal8Bit().constData(), GA_ReadOnly ) );
   if ( !hSrcDS )
   {
-    mErrorMessage = QObject::tr( "Unable to open input file: %1" ).arg( raster.inputFilename );
+    error = QObject::tr( "Unable to open input file: %1" ).arg( raster.inputFilename );
     return false;
   }
 
@@ -441,17 +592,17 @@ bool QgsAlignRaster::createAndWarp( const Item &raster )
   GDALDataType eDT = GDALGetRasterDataType( GDALGetRasterBand( hSrcDS.get(), 1 ) );
 
   // Create the output file.
-  gdal::dataset_unique_ptr hDstDS( GDALCreate( hDriver, raster.outputFilename.toLocal8Bit().constData(), mXSize, mYSize,
+  gdal::dataset_unique_ptr hDstDS( GDALCreate( hDriver, outputFilename.toLocal8Bit().constData(), mXSize, mYSize,
                                    bandCount, eDT, nullptr ) );
   if ( !hDstDS )
   {
-    mErrorMessage = QObject::tr( "Unable to create output file: %1" ).arg( raster.outputFilename );
+    error = QObject::tr( "Unable to create output file: %1" ).arg( outputFilename );
     return false;
   }
 
   // Write out the projection definition.
   GDALSetProjection( hDstDS.get(), mCrsWkt.toLatin1().constData() );
-  GDALSetGeoTransform( hDstDS.get(), mGeoTransform );
+  GDALSetGeoTransform( hDstDS.get(), const_cast< double * >( mGeoTransform ) );
 
   // Copy the color table, if required.
   GDALColorTableH hCT = GDALGetRasterColorTable( GDALGetRasterBand( hSrcDS.get(), 1 ) );
@@ -478,7 +629,10 @@ bool QgsAlignRaster::createAndWarp( const Item &raster )
 
   // our progress function
   psWarpOptions->pfnProgress = _progress;
-  psWarpOptions->pProgressArg = this;
+  psWarpOptions->pProgressArg = progressArg;
+
+  // multithreaded warping of the chunks
+  psWarpOptions->papszWarpOptions = CSLSetNameValue( psWarpOptions->papszWarpOptions, "NUM_THREADS", QByteArray::number( warpThreads ).constData() );
 
   // Establish reprojection transformer.
   psWarpOptions->pTransformerArg =
@@ -500,12 +654,131 @@ bool QgsAlignRaster::createAndWarp( const Item &raster )
     psWarpOptions->eWorkingDataType = GDT_Float32;
   }
 
-  // Initialize and execute the warp operation.
+  // Initialize and execute the warp operation. With multiple threads, reading of the
+  // next chunk of the source overlaps with the warping of the current one.
   GDALWarpOperation oOperation;
-  oOperation.Initialize( psWarpOptions.get() );
-  oOperation.ChunkAndWarpImage( 0, 0, mXSize, mYSize );
+  CPLErr result = oOperation.Initialize( psWarpOptions.get() );
+  if ( result == CE_None )
+  {
+    if ( warpThreads > 1 )
+      result = oOperation.ChunkAndWarpMulti( 0, 0, mXSize, mYSize );
+    else
+      result = oOperation.ChunkAndWarpImage( 0, 0, mXSize, mYSize );
+  }
 
   GDALDestroyGenImgProjTransformer( psWarpOptions->pTransformerArg );
+
+  if ( result != CE_None )
+  {
+    QgsAlignRasterProgress *progress = static_cast< QgsAlignRasterProgress * >( progressArg );
+    if ( progress->feedback && progress->feedback->isCanceled() )
+      error = QObject::tr( "Alignment was canceled." );
+    else
+      error = QObject::tr( "Unable to warp raster %1: %2" ).arg( raster.inputFilename, QString::fromUtf8( CPLGetLastErrorMsg() ) );
+    return false;
+  }
+  return true;
+}
+
+bool QgsAlignRaster::createStackedOutput( const QStringList &filenames )
+{
+  const bool virtualOutput = mStackedOutputFilename.endsWith( QLatin1String( ".vrt" ), Qt::CaseInsensitive );
+
+  GDALDriverH hVrtDriver = GDALGetDriverByName( "VRT" );
+  if ( !hVrtDriver )
+  {
+    mErrorMessage = QStringLiteral( "GDALGetDriverByName(VRT) failed." );
+    return false;
+  }
+
+  std::vector< gdal::dataset_unique_ptr > sources;
+  GDALDataType commonType = GDT_Unknown;
+  for ( const QString &filename : filenames )
+  {
+    gdal::dataset_unique_ptr hSrcDS( GDALOpen( filename.toLocal8Bit().constData(), GA_ReadOnly ) );
+    if ( !hSrcDS )
+    {
+      mErrorMessage = QObject::tr( "Unable to open aligned file: %1" ).arg( filename );
+      return false;
+    }
+    for ( int band = 1; band <= GDALGetRasterCount( hSrcDS.get() ); ++band )
+    {
+      const GDALDataType type = GDALGetRasterDataType( GDALGetRasterBand( hSrcDS.get(), band ) );
+      commonType = commonType == GDT_Unknown ? type : GDALDataTypeUnion( commonType, type );
+    }
+    sources.emplace_back( std::move( hSrcDS ) );
+  }
+
+  // the virtual raster is written to disk when it is closed, for the GeoTIFF it is the source of the raster writer
+  QTemporaryDir tempDir;
+  const QString vrtFilename = virtualOutput ? mStackedOutputFilename : tempDir.filePath( QStringLiteral( "stacked.vrt" ) );
+  gdal::dataset_unique_ptr hVrtDS( GDALCreate( hVrtDriver, vrtFilename.toLocal8Bit().constData(), mXSize, mYSize, 0, GDT_Byte, nullptr ) );
+  if ( !hVrtDS )
+  {
+    mErrorMessage = QObject::tr( "Unable to create output file: %1" ).arg( mStackedOutputFilename );
+    return false;
+  }
+  GDALSetProjection( hVrtDS.get(), mCrsWkt.toLatin1().constData() );
+  GDALSetGeoTransform( hVrtDS.get(), const_cast< double * >( mGeoTransform ) );
+
+  for ( const gdal::dataset_unique_ptr &hSrcDS : sources )
+  {
+    for ( int band = 1; band <= GDALGetRasterCount( hSrcDS.get() ); ++band )
+    {
+      GDALRasterBandH hSrcBand = GDALGetRasterBand( hSrcDS.get(), band );
+      // a GeoTIFF has a single data type for all bands
+      GDALAddBand( hVrtDS.get(), virtualOutput ? GDALGetRasterDataType( hSrcBand ) : commonType, nullptr );
+      GDALRasterBandH hVrtBand = GDALGetRasterBand( hVrtDS.get(), GDALGetRasterCount( hVrtDS.get() ) );
+      VRTAddSimpleSource( static_cast< VRTSourcedRasterBandH >( hVrtBand ), hSrcBand, 0, 0, mXSize, mYSize, 0, 0, mXSize, mYSize, nullptr, VRT_NODATA_UNSET );
+
+      int hasNoData = false;
+      const double noData = GDALGetRasterNoDataValue( hSrcBand, &hasNoData );
+      if ( hasNoData )
+        GDALSetRasterNoDataValue( hVrtBand, noData );
+    }
+  }
+
+  hVrtDS.reset();
+  if ( virtualOutput )
+    return true;
+
+  // write the cloud optimized GeoTIFF from the virtual raster, with the overviews
+  // reduced while the blocks are written
+  std::unique_ptr< QgsRasterDataProvider > provider( qobject_cast< QgsRasterDataProvider * >( QgsProviderRegistry::instance()->createProvider( QStringLiteral( "gdal" ), vrtFilename ) ) );
+  if ( !provider || !provider->isValid() )
+  {
+    mErrorMessage = QObject::tr( "Unable to open stacked raster: %1" ).arg( vrtFilename );
+    return false;
+  }
+
+  QgsRasterPipe pipe;
+  pipe.set( provider.release() );
+
+  QgsRasterFileWriter writer( mStackedOutputFilename );
+  writer.setOutputFormat( QStringLiteral( "GTiff" ) );
+  writer.setCloudOptimized( true );
+  writer.setCreateOptions( QStringList() << QStringLiteral( "COMPRESS=DEFLATE" ) << QStringLiteral( "BIGTIFF=IF_SAFER" ) );
+
+  QgsRasterBlockFeedback feedback;
+  ProgressHandler *handler = mProgressHandler;
+  QObject::connect( &feedback, &QgsFeedback::progressChanged, &feedback, [handler, &feedback]( double progress )
+  {
+    if ( handler && !handler->progress( progress / 100.0 ) )
+      feedback.cancel();
+  } );
+
+  const QgsRasterFileWriter::WriterError error = writer.writeRaster( &pipe, mXSize, mYSize, transform_to_extent( mGeoTransform, mXSize, mYSize ),
+      QgsCoordinateReferenceSystem::fromWkt( mCrsWkt ), QgsCoordinateTransformContext(), &feedback );
+  if ( error == QgsRasterFileWriter::WriteCanceled )
+  {
+    mErrorMessage = QObject::tr( "Alignment was canceled." );
+    return false;
+  }
+  else if ( error != QgsRasterFileWriter::NoError )
+  {
+    mErrorMessage = QObject::tr( "Unable to create output file: %1" ).arg( mStackedOutputFilename );
+    return false;
+  }
   return true;
 }
 
@@ -20,11 +20,13 @@
 #include <QPointF>
 #include <QSizeF>
 #include <QString>
+#include <QStringList>
 #include <gdal_version.h>
 #include "qgis_analysis.h"
 #include "qgis_sip.h"
 #include "qgsogrutils.h"
 
+class QgsFeedback;
 class QgsRectangle;
 
 typedef void *GDALDatasetH SIP_SKIP;
@@ -135,6 +137,7 @@ class ANALYSIS_EXPORT QgsAlignRaster
         , resampleMethod( RA_NearestNeighbour )
         , rescaleValues( false )
         , srcCellSizeInDestCRS( 0.0 )
+        , feedback( nullptr )
       {}
 
       //! filename of the source raster
@@ -150,6 +153,13 @@ class ANALYSIS_EXPORT QgsAlignRaster
 
       //! used for rescaling of values (if necessary)
       double srcCellSizeInDestCRS;
+
+      /**
+       * Optional feedback object for progress reporting and cancellation of this raster.
+       * Progress is reported from the thread which warps the raster.
+       * \since QGIS 3.10
+       */
+      QgsFeedback *feedback;
     };
     typedef QList<QgsAlignRaster::Item> List;
 
@@ -210,6 +220,29 @@ class ANALYSIS_EXPORT QgsAlignRaster
      */
     QgsRectangle clipExtent() const;
 
+    /**
+     * Sets the \a filename of a single multi-band raster which stacks the bands of all
+     * aligned rasters, in the order of the rasters list.
+     *
+     * If the filename ends with ".vrt", a virtual raster referencing the aligned rasters
+     * is created. Otherwise a cloud optimized GeoTIFF is written by QgsRasterFileWriter
+     * (see QgsRasterFileWriter::setCloudOptimized()), and items without an output
+     * filename are only aligned to temporary files.
+     *
+     * No stacked raster is created if the filename is empty (the default).
+     *
+     * \see stackedOutputFilename()
+     * \since QGIS 3.10
+     */
+    void setStackedOutputFilename( const QString &filename ) { mStackedOutputFilename = filename; }
+
+    /**
+     * Returns the filename of the multi-band raster which stacks the bands of all aligned rasters.
+     * \see setStackedOutputFilename()
+     * \since QGIS 3.10
+     */
+    QString stackedOutputFilename() const { return mStackedOutputFilename; }
+
     /**
      * Set destination CRS, cell size and grid offset from a raster file.
      * The user may provide custom values for some of the parameters - in such case
@@ -249,6 +282,10 @@ class ANALYSIS_EXPORT QgsAlignRaster
 
     /**
      * Run the alignment process
+     *
+     * Rasters are warped concurrently, each by multiple threads. The progress handler
+     * is called from the thread which runs the alignment.
+     *
      * \returns TRUE on success, sets error on error (see errorMessage())
      */
     bool run();
@@ -309,6 +346,17 @@ class ANALYSIS_EXPORT QgsAlignRaster
     //! Computed raster grid height
     int mYSize;
 
+    //! Filename of the raster stacking the bands of all aligned rasters
+    QString mStackedOutputFilename;
+
+  private:
+
+    //! Creates \a outputFilename and warps \a raster into it with \a warpThreads threads
+    bool warpRaster( const Item &raster, const QString &outputFilename, int warpThreads, void *progressArg, QString &error ) const;
+
+    //! Creates the stacked output raster from the aligned rasters \a filenames
+    bool createStackedOutput( const QStringList &filenames );
+
 };
 
 
@@ -30,7 +30,12 @@
 #include <QFile>
 #include <QDebug>
 #include <QFileInfo>
+#include <QtConcurrentMap>
+#include <QtConcurrentRun>
+#include <algorithm>
 #include <iterator>
+#include <numeric>
+#include <vector>
 
 
 
@@ -399,16 +404,39 @@ int QgsNineCellFilter::processRasterCPU( QgsFeedback *feedback )
     return 6;
   }
 
-  //keep only three scanlines in memory at a time, make room for initial and final nodata
-  std::size_t bufferSize( sizeof( float ) * ( xSize + 2 ) );
-  float *scanLine1 = ( float * ) CPLMalloc( bufferSize );
-  float *scanLine2 = ( float * ) CPLMalloc( bufferSize );
-  float *scanLine3 = ( float * ) CPLMalloc( bufferSize );
-
-  float *resultLine = ( float * ) CPLMalloc( sizeof( float ) * xSize );
+  // The raster is processed in chunks of rows, each read and written with a single GDALRasterIO call.
+  // A chunk is read with one halo row above and below (and one nodata column on each side), so that
+  // its rows can be computed independently and in parallel, while the next chunk is read in the background.
+  int blockXSize = 0;
+  int blockYSize = 0;
+  GDALGetBlockSize( rasterBand, &blockXSize, &blockYSize );
+  blockYSize = std::max( 1, blockYSize );
+  // at least 256 rows (aligned to the source block rows), but keep the buffers below 16M cells
+  int chunkRows = blockYSize * std::max( 1, 256 / blockYSize );
+  chunkRows = std::min( chunkRows, std::max( blockYSize, 16 * 1024 * 1024 / ( xSize + 2 ) ) );
+  chunkRows = std::min( chunkRows, ySize );
+
+  const int lineSize = xSize + 2;
+  std::vector< float > inputChunk( static_cast< std::size_t >( lineSize ) * ( chunkRows + 2 ) );
+  std::vector< float > nextInputChunk( inputChunk.size() );
+  std::vector< float > resultChunk( static_cast< std::size_t >( xSize ) * chunkRows );
 
   //values outside the layer extent (if the 3x3 window is on the border) are sent to the processing method as (input) nodata values
-  for ( int yIndex = 0; yIndex < ySize; ++yIndex )
+  const float inputNodata = mInputNodataValue;
+  auto readChunk = [ = ]( std::vector< float > &buffer, int top, int rows ) -> bool
+  {
+    const int firstRow = std::max( 0, top - 1 );
+    const int lastRow = std::min( ySize - 1, top + rows );
+    const int firstLine = firstRow - ( top - 1 );
+    std::fill( buffer.begin(), buffer.begin() + static_cast< std::size_t >( lineSize ) * ( rows + 2 ), inputNodata );
+    return GDALRasterIO( rasterBand, GF_Read, 0, firstRow, xSize, lastRow - firstRow + 1,
+                         &buffer[ static_cast< std::size_t >( firstLine ) * lineSize + 1 ], xSize, lastRow - firstRow + 1,
+                         GDT_Float32, 0, static_cast< int >( sizeof( float ) ) * lineSize ) == CE_None;
+  };
+
+  std::vector< int > rowIndexes;
+  QFuture< bool > nextRead = QtConcurrent::run( [&] { return readChunk( nextInputChunk, 0, chunkRows ); } );
+  for ( int top = 0; top < ySize; top += chunkRows )
   {
     if ( feedback && feedback->isCanceled() )
     {
@@ -417,73 +445,48 @@ int QgsNineCellFilter::processRasterCPU( QgsFeedback *feedback )
 
     if ( feedback )
     {
-      feedback->setProgress( 100.0 * static_cast< double >( yIndex ) / ySize );
+      feedback->setProgress( 100.0 * static_cast< double >( top ) / ySize );
     }
 
-    if ( yIndex == 0 )
-    {
-      //fill scanline 1 with (input) nodata for the values above the first row and feed scanline2 with the first row
-      for ( int a = 0; a < xSize + 2 ; ++a )
-      {
-        scanLine1[a] = mInputNodataValue;
-      }
-      // Read scanline2
-      if ( GDALRasterIO( rasterBand, GF_Read, 0, 0, xSize, 1, &scanLine2[1], xSize, 1, GDT_Float32, 0, 0 ) != CE_None )
-      {
-        QgsDebugMsg( QStringLiteral( "Raster IO Error" ) );
-      }
-    }
-    else
+    const int rows = std::min( chunkRows, ySize - top );
+    if ( !nextRead.result() )
     {
-      //normally fetch only scanLine3 and release scanline 1 if we move forward one row
-      CPLFree( scanLine1 );
-      scanLine1 = scanLine2;
-      scanLine2 = scanLine3;
-      scanLine3 = ( float * ) CPLMalloc( bufferSize );
+      QgsDebugMsg( QStringLiteral( "Raster IO Error" ) );
     }
+    inputChunk.swap( nextInputChunk );
 
-    // Read scanline 3
-    if ( yIndex == ySize - 1 ) //fill the row below the bottom with nodata values
+    const int nextTop = top + rows;
+    if ( nextTop < ySize )
     {
-      for ( int a = 0; a < xSize + 2; ++a )
-      {
-        scanLine3[a] = mInputNodataValue;
-      }
-    }
-    else
-    {
-      if ( GDALRasterIO( rasterBand, GF_Read, 0, yIndex + 1, xSize, 1, &scanLine3[1], xSize, 1, GDT_Float32, 0, 0 ) != CE_None )
-      {
-        QgsDebugMsg( QStringLiteral( "Raster IO Error" ) );
-      }
+      const int nextRows = std::min( chunkRows, ySize - nextTop );
+      nextRead = QtConcurrent::run( [&, nextTop, nextRows] { return readChunk( nextInputChunk, nextTop, nextRows ); } );
     }
-    // Set first and last extra columns to nodata
-    scanLine1[0] = scanLine1[xSize + 1] = mInputNodataValue;
-    scanLine2[0] = scanLine2[xSize + 1] = mInputNodataValue;
-    scanLine3[0] = scanLine3[xSize + 1] = mInputNodataValue;
-
 
-
-    // j is the x axis index, skip 0 and last cell that have been filled with nodata
-    for ( int xIndex = 0; xIndex < xSize ; ++xIndex )
+    rowIndexes.resize( rows );
+    std::iota( rowIndexes.begin(), rowIndexes.end(), 0 );
+    QtConcurrent::blockingMap( rowIndexes, [&]( int row )
     {
-      // cells(x, y) x11, x21, x31, x12, x22, x32, x13, x23, x33
-      resultLine[ xIndex ] = processNineCellWindow( &scanLine1[ xIndex ], &scanLine1[ xIndex + 1 ], &scanLine1[ xIndex + 2 ],
-                             &scanLine2[ xIndex ], &scanLine2[ xIndex + 1 ], &scanLine2[ xIndex + 2 ],
-                             &scanLine3[ xIndex ], &scanLine3[ xIndex + 1 ], &scanLine3[ xIndex + 2 ] );
+      float *scanLine1 = &inputChunk[ static_cast< std::size_t >( row ) * lineSize ];
+      float *scanLine2 = scanLine1 + lineSize;
+      float *scanLine3 = scanLine2 + lineSize;
+      float *resultLine = &resultChunk[ static_cast< std::size_t >( row ) * xSize ];
 
-    }
+      for ( int xIndex = 0; xIndex < xSize ; ++xIndex )
+      {
+        // cells(x, y) x11, x21, x31, x12, x22, x32, x13, x23, x33
+        resultLine[ xIndex ] = processNineCellWindow( &scanLine1[ xIndex ], &scanLine1[ xIndex + 1 ], &scanLine1[ xIndex + 2 ],
+                               &scanLine2[ xIndex ], &scanLine2[ xIndex + 1 ], &scanLine2[ xIndex + 2 ],
+                               &scanLine3[ xIndex ], &scanLine3[ xIndex + 1 ], &scanLine3[ xIndex + 2 ] );
+      }
+    } );
 
-    if ( GDALRasterIO( outputRasterBand, GF_Write, 0, yIndex, xSize, 1, resultLine, xSize, 1, GDT_Float32, 0, 0 ) != CE_None )
+    if ( GDALRasterIO( outputRasterBand, GF_Write, 0, top, xSize, rows, resultChunk.data(), xSize, rows, GDT_Float32, 0, 0 ) != CE_None )
     {
       QgsDebugMsg( QStringLiteral( "Raster IO Error" ) );
     }
   }
-
-  CPLFree( resultLine );
-  CPLFree( scanLine1 );
-  CPLFree( scanLine2 );
-  CPLFree( scanLine3 );
+  // don't leave a background read running on the input dataset
+  nextRead.waitForFinished();
 
   if ( feedback && feedback->isCanceled() )
   {
@@ -21,6 +21,7 @@
 #include <QString>
 #include "gdal.h"
 #include "qgis_analysis.h"
+#include "qgis_sip.h"
 #include "qgsogrutils.h"
 
 class QgsFeedback;
@@ -40,10 +41,13 @@ class ANALYSIS_EXPORT QgsNineCellFilter
 
     /**
      * Starts the calculation, reads from mInputFile and stores the result in mOutputFile
+     *
+     * Rows are calculated in parallel, so processNineCellWindow() is called from multiple threads.
+     *
      * \param feedback feedback object that receives update and that is checked for cancellation.
      * \returns 0 in case of success
      */
-    int processRaster( QgsFeedback *feedback = nullptr );
+    int processRaster( QgsFeedback *feedback = nullptr ) SIP_RELEASEGIL;
 
     double cellSizeX() const { return mCellSizeX; }
     void setCellSizeX( double size ) { mCellSizeX = size; }
@@ -0,0 +1,281 @@
+/***************************************************************************
+    qgsrastercalcprogram.cpp
+    ---------------------
+    begin                : October 2019
+    copyright            : (C) 2019 by the QGIS project
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+#include "qgsrastercalcprogram.h"
+#include "qgsrasterblock.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+///@cond PRIVATE
+
+// The operations below compute the result for every cell of the batch and only
+// then replace the results of nodata cells, so that the loops are free of branches.
+
+template <typename Function>
+static void unaryOperation( double *values, int count, double nodataValue, Function function )
+{
+  for ( int i = 0; i < count; ++i )
+  {
+    const double value = values[i];
+    const double result = function( value );
+    values[i] = value == nodataValue ? nodataValue : result;
+  }
+}
+
+template <typename Function>
+static void binaryOperation( double *left, const double *right, int count, double nodataValue, Function function )
+{
+  for ( int i = 0; i < count; ++i )
+  {
+    const double a = left[i];
+    const double b = right[i];
+    const double result = function( a, b );
+    left[i] = ( a == nodataValue || b == nodataValue ) ? nodataValue : result;
+  }
+}
+
+static void applyUnaryOperator( QgsRasterCalcNode::Operator op, double *values, int count, double nodataValue )
+{
+  switch ( op )
+  {
+    case QgsRasterCalcNode::opSQRT:
+      unaryOperation( values, count, nodataValue, [nodataValue]( double a ) { return a < 0 ? nodataValue : std::sqrt( a ); } );
+      break;
+    case QgsRasterCalcNode::opSIN:
+      unaryOperation( values, count, nodataValue, []( double a ) { return std::sin( a ); } );
+      break;
+    case QgsRasterCalcNode::opCOS:
+      unaryOperation( values, count, nodataValue, []( double a ) { return std::cos( a ); } );
+      break;
+    case QgsRasterCalcNode::opTAN:
+      unaryOperation( values, count, nodataValue, []( double a ) { return std::tan( a ); } );
+      break;
+    case QgsRasterCalcNode::opASIN:
+      unaryOperation( values, count, nodataValue, []( double a ) { return std::asin( a ); } );
+      break;
+    case QgsRasterCalcNode::opACOS:
+      unaryOperation( values, count, nodataValue, []( double a ) { return std::acos( a ); } );
+      break;
+    case QgsRasterCalcNode::opATAN:
+      unaryOperation( values, count, nodataValue, []( double a ) { return std::atan( a ); } );
+      break;
+    case QgsRasterCalcNode::opSIGN:
+      unaryOperation( values, count, nodataValue, []( double a ) { return -a; } );
+      break;
+    case QgsRasterCalcNode::opLOG:
+      unaryOperation( values, count, nodataValue, [nodataValue]( double a ) { return a <= 0 ? nodataValue : std::log( a ); } );
+      break;
+    case QgsRasterCalcNode::opLOG10:
+      unaryOperation( values, count, nodataValue, [nodataValue]( double a ) { return a <= 0 ? nodataValue : std::log10( a ); } );
+      break;
+    default:
+      break;
+  }
+}
+
+static void applyBinaryOperator( QgsRasterCalcNode::Operator op, double *left, const double *right, int count, double nodataValue )
+{
+  switch ( op )
+  {
+    case QgsRasterCalcNode::opPLUS:
+      binaryOperation( left, right, count, nodataValue, []( double a, double b ) { return a + b; } );
+      break;
+    case QgsRasterCalcNode::opMINUS:
+      binaryOperation( left, right, count, nodataValue, []( double a, double b ) { return a - b; } );
+      break;
+    case QgsRasterCalcNode::opMUL:
+      binaryOperation( left, right, count, nodataValue, []( double a, double b ) { return a * b; } );
+      break;
+    case QgsRasterCalcNode::opDIV:
+      binaryOperation( left, right, count, nodataValue, [nodataValue]( double a, double b ) { return b == 0 ? nodataValue : a / b; } );
+      break;
+    case QgsRasterCalcNode::opPOW:
+      binaryOperation( left, right, count, nodataValue, [nodataValue]( double a, double b )
+      {
+        // same validity test as QgsRasterMatrix::testPowerValidity()
+        if ( ( a == 0 && b < 0 ) || ( a < 0 && ( b - std::floor( b ) ) > 0 ) )
+          return nodataValue;
+        return std::pow( a, b );
+      } );
+      break;
+    case QgsRasterCalcNode::opEQ:
+      binaryOperation( left, right, count, nodataValue, []( double a, double b ) { return a == b ? 1.0 : 0.0; } );
+      break;
+    case QgsRasterCalcNode::opNE:
+      binaryOperation( left, right, count, nodataValue, []( double a, double b ) { return a == b ? 0.0 : 1.0; } );
+      break;
+    case QgsRasterCalcNode::opGT:
+      binaryOperation( left, right, count, nodataValue, []( double a, double b ) { return a > b ? 1.0 : 0.0; } );
+      break;
+    case QgsRasterCalcNode::opLT:
+      binaryOperation( left, right, count, nodataValue, []( double a, double b ) { return a < b ? 1.0 : 0.0; } );
+      break;
+    case QgsRasterCalcNode::opGE:
+      binaryOperation( left, right, count, nodataValue, []( double a, double b ) { return a >= b ? 1.0 : 0.0; } );
+      break;
+    case QgsRasterCalcNode::opLE:
+      binaryOperation( left, right, count, nodataValue, []( double a, double b ) { return a <= b ? 1.0 : 0.0; } );
+      break;
+    case QgsRasterCalcNode::opAND:
+      binaryOperation( left, right, count, nodataValue, []( double a, double b ) { return ( a != 0 && b != 0 ) ? 1.0 : 0.0; } );
+      break;
+    case QgsRasterCalcNode::opOR:
+      binaryOperation( left, right, count, nodataValue, []( double a, double b ) { return ( a != 0 || b != 0 ) ? 1.0 : 0.0; } );
+      break;
+    default:
+      break;
+  }
+}
+
+bool QgsRasterCalcProgram::compile( const QgsRasterCalcNode *node )
+{
+  mInstructions.clear();
+  mRasterReferences.clear();
+  mStackSize = 0;
+
+  if ( !node || !compileNode( node, 0 ) )
+  {
+    mInstructions.clear();
+    mRasterReferences.clear();
+    mStackSize = 0;
+    return false;
+  }
+  return true;
+}
+
+bool QgsRasterCalcProgram::compileNode( const QgsRasterCalcNode *node, int depth )
+{
+  mStackSize = std::max( mStackSize, depth + 1 );
+
+  Instruction instruction;
+  switch ( node->mType )
+  {
+    case QgsRasterCalcNode::tNumber:
+      instruction.type = LoadNumber;
+      instruction.number = node->mNumber;
+      break;
+
+    case QgsRasterCalcNode::tRasterRef:
+    {
+      instruction.type = LoadRaster;
+      instruction.input = mRasterReferences.indexOf( node->mRasterName );
+      if ( instruction.input < 0 )
+      {
+        instruction.input = mRasterReferences.count();
+        mRasterReferences << node->mRasterName;
+      }
+      break;
+    }
+
+    case QgsRasterCalcNode::tOperator:
+      switch ( node->mOperator )
+      {
+        case QgsRasterCalcNode::opPLUS:
+        case QgsRasterCalcNode::opMINUS:
+        case QgsRasterCalcNode::opMUL:
+        case QgsRasterCalcNode::opDIV:
+        case QgsRasterCalcNode::opPOW:
+        case QgsRasterCalcNode::opEQ:
+        case QgsRasterCalcNode::opNE:
+        case QgsRasterCalcNode::opGT:
+        case QgsRasterCalcNode::opLT:
+        case QgsRasterCalcNode::opGE:
+        case QgsRasterCalcNode::opLE:
+        case QgsRasterCalcNode::opAND:
+        case QgsRasterCalcNode::opOR:
+          if ( !node->mLeft || !node->mRight || !compileNode( node->mLeft, depth ) || !compileNode( node->mRight, depth + 1 ) )
+            return false;
+          instruction.type = BinaryOperator;
+          break;
+
+        case QgsRasterCalcNode::opSQRT:
+        case QgsRasterCalcNode::opSIN:
+        case QgsRasterCalcNode::opCOS:
+        case QgsRasterCalcNode::opTAN:
+        case QgsRasterCalcNode::opASIN:
+        case QgsRasterCalcNode::opACOS:
+        case QgsRasterCalcNode::opATAN:
+        case QgsRasterCalcNode::opSIGN:
+        case QgsRasterCalcNode::opLOG:
+        case QgsRasterCalcNode::opLOG10:
+          if ( !node->mLeft || !compileNode( node->mLeft, depth ) )
+            return false;
+          instruction.type = UnaryOperator;
+          break;
+
+        case QgsRasterCalcNode::opNONE:
+          return false;
+      }
+      instruction.op = node->mOperator;
+      break;
+
+    case QgsRasterCalcNode::tMatrix:
+      return false;
+  }
+
+  mInstructions << instruction;
+  return true;
+}
+
+void QgsRasterCalcProgram::evaluate( const QVector< const QgsRasterBlock * > &inputs, qgssize offset, int count, double nodataValue, float *result ) const
+{
+  std::vector< double > stack( static_cast< size_t >( mStackSize ) * BATCH_SIZE );
+
+  for ( int batchStart = 0; batchStart < count; batchStart += BATCH_SIZE )
+  {
+    const int batchCount = std::min( BATCH_SIZE, count - batchStart );
+    int top = 0;
+    for ( const Instruction &instruction : mInstructions )
+    {
+      switch ( instruction.type )
+      {
+        case LoadRaster:
+        {
+          double *values = stack.data() + static_cast< size_t >( top++ ) * BATCH_SIZE;
+          const QgsRasterBlock *block = inputs.at( instruction.input );
+          const qgssize start = offset + static_cast< qgssize >( batchStart );
+          bool isNoData = false;
+          for ( int i = 0; i < batchCount; ++i )
+          {
+            const double value = block->valueAndNoData( start + i, isNoData );
+            values[i] = isNoData ? nodataValue : value;
+          }
+          break;
+        }
+
+        case LoadNumber:
+        {
+          double *values = stack.data() + static_cast< size_t >( top++ ) * BATCH_SIZE;
+          std::fill( values, values + batchCount, instruction.number );
+          break;
+        }
+
+        case UnaryOperator:
+          applyUnaryOperator( instruction.op, stack.data() + static_cast< size_t >( top - 1 ) * BATCH_SIZE, batchCount, nodataValue );
+          break;
+
+        case BinaryOperator:
+          --top;
+          applyBinaryOperator( instruction.op, stack.data() + static_cast< size_t >( top - 1 ) * BATCH_SIZE,
+                               stack.data() + static_cast< size_t >( top ) * BATCH_SIZE, batchCount, nodataValue );
+          break;
+      }
+    }
+
+    std::transform( stack.data(), stack.data() + batchCount, result + batchStart, []( double value ) { return static_cast< float >( value ); } );
+  }
+}
+
+///@endcond PRIVATE
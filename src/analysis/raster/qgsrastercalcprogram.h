@@ -0,0 +1,104 @@
+/***************************************************************************
+    qgsrastercalcprogram.h
+    ---------------------
+    begin                : October 2019
+    copyright            : (C) 2019 by the QGIS project
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+#ifndef QGSRASTERCALCPROGRAM_H
+#define QGSRASTERCALCPROGRAM_H
+
+#define SIP_NO_FILE
+
+#include "qgis_analysis.h"
+#include "qgis.h"
+#include "qgsrastercalcnode.h"
+
+#include <QStringList>
+#include <QVector>
+
+class QgsRasterBlock;
+
+///@cond PRIVATE
+
+/**
+ * \ingroup analysis
+ * A raster calculator expression compiled to a flat list of instructions.
+ *
+ * Instead of building an intermediate QgsRasterMatrix for every node of the
+ * expression tree, the program is evaluated over small batches of cells which
+ * stay in the CPU cache. Every instruction is a tight loop over its batch
+ * (with nodata handled by masking the computed values), which the compiler
+ * is able to vectorize. Evaluation does not modify the program, so several
+ * threads may evaluate different cells of the same inputs concurrently.
+ *
+ * The results are identical to QgsRasterCalcNode::calculate().
+ *
+ * \note not available in Python bindings
+ * \since QGIS 3.10
+ */
+class ANALYSIS_EXPORT QgsRasterCalcProgram
+{
+  public:
+
+    //! Number of cells evaluated by a single pass over the instructions
+    static const int BATCH_SIZE = 256;
+
+    /**
+     * Compiles the expression tree starting at \a node.
+     *
+     * Returns FALSE if the expression can't be evaluated cell by cell, e.g.
+     * because it contains matrix nodes.
+     */
+    bool compile( const QgsRasterCalcNode *node );
+
+    /**
+     * Returns the names of the rasters referenced by the expression. The input
+     * blocks passed to evaluate() must be given in this order.
+     */
+    QStringList rasterReferences() const { return mRasterReferences; }
+
+    /**
+     * Evaluates the expression for \a count cells, starting at cell \a offset of
+     * the \a inputs blocks, and stores the results in \a result.
+     *
+     * Input nodata cells and invalid operations result in \a nodataValue.
+     */
+    void evaluate( const QVector< const QgsRasterBlock * > &inputs, qgssize offset, int count, double nodataValue, float *result ) const;
+
+  private:
+
+    enum InstructionType
+    {
+      LoadRaster,
+      LoadNumber,
+      UnaryOperator,
+      BinaryOperator,
+    };
+
+    struct Instruction
+    {
+      InstructionType type = LoadNumber;
+      QgsRasterCalcNode::Operator op = QgsRasterCalcNode::opNONE;
+      //! Index of the input raster for LoadRaster instructions
+      int input = 0;
+      //! Value of LoadNumber instructions
+      double number = 0;
+    };
+
+    bool compileNode( const QgsRasterCalcNode *node, int depth );
+
+    QVector< Instruction > mInstructions;
+    QStringList mRasterReferences;
+    int mStackSize = 0;
+};
+
+///@endcond PRIVATE
+
+#endif // QGSRASTERCALCPROGRAM_H
@@ -17,6 +17,7 @@
 
 #include "qgsgdalutils.h"
 #include "qgsrastercalculator.h"
+#include "qgsrastercalcprogram.h"
 #include "qgsrasterdataprovider.h"
 #include "qgsrasterinterface.h"
 #include "qgsrasterlayer.h"
@@ -27,6 +28,10 @@
 #include "qgsproject.h"
 
 #include <QFile>
+#include <QtConcurrentMap>
+
+#include <algorithm>
+#include <numeric>
 
 #include <cpl_string.h>
 #include <gdalwarper.h>
@@ -36,6 +41,9 @@
 #include "qgsgdalutils.h"
 #endif
 
+//! Maximum number of cells of the chunks processed by the fast calculation route
+static const int CALCULATION_CHUNK_CELLS = 1 << 20;
+
 QgsRasterCalculator::QgsRasterCalculator( const QString &formulaString, const QString &outputFile, const QString &outputFormat, const QgsRectangle &outputExtent, int nOutputColumns, int nOutputRows, const QVector<QgsRasterCalculatorEntry> &rasterEntries, const QgsCoordinateTransformContext &transformContext )
   : mFormulaString( formulaString )
   , mOutputFile( outputFile )
@@ -131,6 +139,32 @@ QgsRasterCalculator::Result QgsRasterCalculator::processCalculation( QgsFeedback
     return processCalculationGPU( std::move( calcNode ), feedback );
 #endif
 
+  // Check if we need to read the raster as a whole (which is memory inefficient
+  // and not interruptable by the user), i.e. if the expression can't be compiled
+  // for evaluation cell by cell because it contains raster matrix nodes
+  QgsRasterCalcProgram program;
+  const bool requiresMatrix = !program.compile( calcNode.get() );
+
+  // Entries of the rasters referenced by the compiled expression
+  QVector< QgsRasterCalculatorEntry > inputEntries;
+  if ( !requiresMatrix )
+  {
+    const QStringList references = program.rasterReferences();
+    for ( const QString &reference : references )
+    {
+      auto entryIt = std::find_if( mRasterEntries.constBegin(), mRasterEntries.constEnd(), [&reference]( const QgsRasterCalculatorEntry & entry )
+      {
+        return entry.ref == reference;
+      } );
+      if ( entryIt == mRasterEntries.constEnd() )
+      {
+        mLastError = QObject::tr( "No raster layer for entry %1" ).arg( reference );
+        return InputLayerError;
+      }
+      inputEntries << *entryIt;
+    }
+  }
+
   //open output dataset for writing
   GDALDriverH outputDriver = openOutputDriver();
   if ( !outputDriver )
@@ -152,44 +186,36 @@ QgsRasterCalculator::Result QgsRasterCalculator::processCalculation( QgsFeedback
   float outputNodataValue = -FLT_MAX;
   GDALSetRasterNoDataValue( outputRasterBand, outputNodataValue );
 
-  // Check if we need to read the raster as a whole (which is memory inefficient
-  // and not interruptable by the user) by checking if any raster matrix nodes are
-  // in the expression
-  bool requiresMatrix = ! calcNode->findNodes( QgsRasterCalcNode::Type::tMatrix ).isEmpty();
-
-  // Take the fast route (process one line at a time) if we can
-  if ( ! requiresMatrix )
+  // Take the fast route (process a chunk of rows at a time) if we can
+  if ( !requiresMatrix )
   {
-    // Map of raster names -> blocks
-    std::map<QString, std::unique_ptr<QgsRasterBlock>> inputBlocks;
-    std::map<QString, QgsRasterCalculatorEntry> uniqueRasterEntries;
-    for ( const auto &r : calcNode->findNodes( QgsRasterCalcNode::Type::tRasterRef ) )
+    std::vector< std::unique_ptr< QgsRasterProjector > > projectors;
+    for ( const QgsRasterCalculatorEntry &entry : qgis::as_const( inputEntries ) )
     {
-      QString layerRef( r->toString().remove( 0, 1 ) );
-      layerRef.chop( 1 );
-      if ( ! inputBlocks.count( layerRef ) )
+      std::unique_ptr< QgsRasterProjector > projector;
+      if ( entry.raster->crs() != mOutputCrs )
       {
-        for ( const auto &ref : mRasterEntries )
-        {
-          if ( ref.ref == layerRef )
-          {
-            uniqueRasterEntries[layerRef] = ref;
-            inputBlocks[layerRef ] = qgis::make_unique<QgsRasterBlock>();
-          }
-        }
+        projector = qgis::make_unique< QgsRasterProjector >();
+        projector->setCrs( entry.raster->crs(), mOutputCrs, mTransformContext );
+        projector->setInput( entry.raster->dataProvider() );
+        projector->setPrecision( QgsRasterProjector::Exact );
       }
+      projectors.emplace_back( std::move( projector ) );
     }
 
-    //read / write line by line
-    QMap<QString, QgsRasterBlock * > _rasterData;
-    // Cast to float
-    std::vector<float> castedResult( static_cast<size_t>( mNumOutputColumns ), 0 );
-    auto rowHeight = mOutputRectangle.height() / mNumOutputRows;
-    for ( size_t row = 0; row < static_cast<size_t>( mNumOutputRows ); ++row )
+    // Chunks are read with a single block request per input (providers can't be used
+    // from several threads), then the rows of the chunk are evaluated in parallel
+    const int rowsPerChunk = std::max( 1, std::min( mNumOutputRows, CALCULATION_CHUNK_CELLS / std::max( 1, mNumOutputColumns ) ) );
+    const double rowHeight = mOutputRectangle.height() / mNumOutputRows;
+    std::vector< std::unique_ptr< QgsRasterBlock > > inputBlocks( static_cast< size_t >( inputEntries.size() ) );
+    QVector< const QgsRasterBlock * > blocks( inputEntries.size() );
+    std::vector< float > chunkResult( static_cast< size_t >( rowsPerChunk ) * mNumOutputColumns );
+    std::vector< int > rowIndexes;
+    for ( int startRow = 0; startRow < mNumOutputRows; startRow += rowsPerChunk )
     {
       if ( feedback )
       {
-        feedback->setProgress( 100.0 * static_cast< double >( row ) / mNumOutputRows );
+        feedback->setProgress( 100.0 * static_cast< double >( startRow ) / mNumOutputRows );
       }
 
       if ( feedback && feedback->isCanceled() )
@@ -197,45 +223,37 @@ QgsRasterCalculator::Result QgsRasterCalculator::processCalculation( QgsFeedback
         break;
       }
 
-      // Calculates the rect for a single row read
+      const int rows = std::min( rowsPerChunk, mNumOutputRows - startRow );
+
+      // Calculates the rect for the rows of the chunk
       QgsRectangle rect( mOutputRectangle );
-      rect.setYMaximum( rect.yMaximum() - rowHeight * row );
-      rect.setYMinimum( rect.yMaximum() - rowHeight );
+      rect.setYMaximum( rect.yMaximum() - rowHeight * startRow );
+      rect.setYMinimum( rect.yMaximum() - rowHeight * rows );
 
-      // Read rows into input blocks
-      for ( auto &layerRef : inputBlocks )
+      for ( int i = 0; i < inputEntries.size(); ++i )
       {
-        QgsRasterCalculatorEntry ref = uniqueRasterEntries[layerRef.first];
-        if ( uniqueRasterEntries[layerRef.first].raster->crs() != mOutputCrs )
+        const QgsRasterCalculatorEntry &entry = inputEntries.at( i );
+        QgsRasterInterface *input = projectors[ i ] ? static_cast< QgsRasterInterface * >( projectors[ i ].get() ) : entry.raster->dataProvider();
+        inputBlocks[ i ].reset( input->block( entry.bandNumber, rect, mNumOutputColumns, rows ) );
+        if ( !inputBlocks[ i ] || inputBlocks[ i ]->isEmpty() )
         {
-          QgsRasterProjector proj;
-          proj.setCrs( ref.raster->crs(), mOutputCrs, mTransformContext );
-          proj.setInput( ref.raster->dataProvider() );
-          proj.setPrecision( QgsRasterProjector::Exact );
-          layerRef.second.reset( proj.block( ref.bandNumber, rect, mNumOutputColumns, 1 ) );
-        }
-        else
-        {
-          inputBlocks[layerRef.first].reset( ref.raster->dataProvider()->block( ref.bandNumber, rect, mNumOutputColumns, 1 ) );
+          mLastError = QObject::tr( "Could not allocate required memory for %1" ).arg( entry.ref );
+          return MemoryError;
         }
+        blocks[ i ] = inputBlocks[ i ].get();
       }
 
-      QgsRasterMatrix resultMatrix;
-      resultMatrix.setNodataValue( outputNodataValue );
-
-      _rasterData.clear();
-      for ( const auto &layerRef : inputBlocks )
+      rowIndexes.resize( rows );
+      std::iota( rowIndexes.begin(), rowIndexes.end(), 0 );
+      QtConcurrent::blockingMap( rowIndexes, [&]( int row )
       {
-        _rasterData.insert( layerRef.first, inputBlocks[layerRef.first].get() );
-      }
+        const qgssize offset = static_cast< qgssize >( row ) * mNumOutputColumns;
+        program.evaluate( blocks, offset, mNumOutputColumns, outputNodataValue, chunkResult.data() + offset );
+      } );
 
-      if ( calcNode->calculate( _rasterData, resultMatrix, 0 ) )
+      if ( GDALRasterIO( outputRasterBand, GF_Write, 0, startRow, mNumOutputColumns, rows, chunkResult.data(), mNumOutputColumns, rows, GDT_Float32, 0, 0 ) != CE_None )
       {
-        std::copy( resultMatrix.data(), resultMatrix.data() + mNumOutputColumns, castedResult.begin() );
-        if ( GDALRasterIO( outputRasterBand, GF_Write, 0, row, mNumOutputColumns, 1, castedResult.data(), mNumOutputColumns, 1, GDT_Float32, 0, 0 ) != CE_None )
-        {
-          QgsDebugMsg( QStringLiteral( "RasterIO error!" ) );
-        }
+        QgsDebugMsg( QStringLiteral( "RasterIO error!" ) );
       }
     }
 
@@ -289,36 +289,55 @@ void QgsFieldCalculator::accept()
     std::unique_ptr< QgsScopedProxyProgressTask > task = qgis::make_unique< QgsScopedProxyProgressTask >( tr( "Calculating field" ) );
     long long count = mOnlyUpdateSelectedCheckBox->isChecked() ? mVectorLayer->selectedFeatureCount() : mVectorLayer->featureCount();
     long long i = 0;
-    while ( fit.nextFeature( feature ) )
+
+    // features are evaluated in blocks, so that simple expressions avoid the per-feature evaluation
+    // overhead. @row_number changes for every feature, so it needs blocks of a single feature
+    const int blockSize = exp.referencedVariables().contains( QStringLiteral( "row_number" ) ) ? 1 : 1000;
+    QgsFeatureList block;
+    block.reserve( blockSize );
+    bool finished = false;
+    while ( !finished )
     {
-      i++;
-      task->setProgress( i / static_cast< double >( count ) * 100 );
+      finished = !fit.nextFeature( feature );
+      if ( !finished )
+        block << feature;
+      if ( block.isEmpty() || ( block.size() < blockSize && !finished ) )
+        continue;
 
-      expContext.setFeature( feature );
       expContext.lastScope()->addVariable( QgsExpressionContextScope::StaticVariable( QStringLiteral( "row_number" ), rownum, true ) );
 
-      QVariant value = exp.evaluate( &expContext );
+      const QVariantList values = exp.evaluateBatch( block, &expContext );
       if ( exp.hasEvalError() )
       {
         calculationSuccess = false;
         error = exp.evalErrorString();
         break;
       }
-      else if ( updatingGeom )
+
+      for ( int j = 0; j < block.size(); ++j )
       {
-        if ( value.canConvert< QgsGeometry >() )
+        i++;
+        task->setProgress( i / static_cast< double >( count ) * 100 );
+
+        const QgsFeature &blockFeature = block.at( j );
+        QVariant value = values.at( j );
+        if ( updatingGeom )
         {
-          QgsGeometry geom = value.value< QgsGeometry >();
-          mVectorLayer->changeGeometry( feature.id(), geom );
+          if ( value.canConvert< QgsGeometry >() )
+          {
+            QgsGeometry geom = value.value< QgsGeometry >();
+            mVectorLayer->changeGeometry( blockFeature.id(), geom );
+          }
+        }
+        else
+        {
+          ( void )field.convertCompatible( value );
+          mVectorLayer->changeAttributeValue( blockFeature.id(), mAttributeId, value, newField ? emptyAttribute : blockFeature.attributes().value( mAttributeId ) );
         }
-      }
-      else
-      {
-        ( void )field.convertCompatible( value );
-        mVectorLayer->changeAttributeValue( feature.id(), mAttributeId, value, newField ? emptyAttribute : feature.attributes().value( mAttributeId ) );
       }
 
-      rownum++;
+      rownum += block.size();
+      block.clear();
     }
 
     if ( !calculationSuccess )
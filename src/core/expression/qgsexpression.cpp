@@ -25,6 +25,8 @@
 #include "qgsproject.h"
 #include "qgsexpressioncontextutils.h"
 
+#include <vector>
+
 // from parser
 extern QgsExpressionNode *parseExpression( const QString &str, QString &parserErrorMsg, QList<QgsExpression::ParserError> &parserErrors );
 
@@ -103,6 +105,7 @@ void QgsExpression::setExpression( const QString &expression )
   d->mEvalErrorString = QString();
   d->mExp = expression;
   d->mIsPrepared = false;
+  d->mProgram.reset();
 }
 
 QString QgsExpression::expression() const
@@ -372,6 +375,7 @@ bool QgsExpression::prepare( const QgsExpressionContext *context )
 {
   detach();
   d->mEvalErrorString = QString();
+  d->mProgram.reset();
   if ( !d->mRootNode )
   {
     //re-parse expression. Creation of QgsExpressionContexts may have added extra
@@ -416,9 +420,255 @@ QVariant QgsExpression::evaluate( const QgsExpressionContext *context )
   {
     prepare( context );
   }
+
+  QVariant result;
+  if ( d->mProgram && d->mProgram->run( this, context, result ) )
+    return result;
+
   return d->mRootNode->eval( this, context );
 }
 
+bool QgsExpression::compile( const QgsExpressionContext *context )
+{
+  if ( !d->mRootNode )
+    return false;
+
+  if ( !d->mIsPrepared )
+    prepare( context );
+
+  detach();
+  d->mProgram = QgsExpressionProgram::compile( d->mRootNode, context );
+  return static_cast< bool >( d->mProgram );
+}
+
+bool QgsExpression::isCompiled() const
+{
+  return static_cast< bool >( d->mProgram );
+}
+
+QVariantList QgsExpression::evaluateBatch( const QList< QgsFeature > &features, QgsExpressionContext *context )
+{
+  QVariantList results;
+  results.reserve( features.size() );
+
+  d->mEvalErrorString = QString();
+  if ( !d->mRootNode )
+  {
+    d->mEvalErrorString = tr( "No root node! Parsing failed?" );
+    for ( int i = 0; i < features.size(); ++i )
+      results << QVariant();
+    return results;
+  }
+
+  QgsExpressionContext localContext;
+  if ( !context )
+    context = &localContext;
+
+  if ( !d->mIsPrepared )
+  {
+    prepare( context );
+  }
+
+  QString firstError;
+  auto evaluateFeature = [this, context, &firstError]( const QgsFeature & feature ) -> QVariant
+  {
+    context->setFeature( feature );
+    d->mEvalErrorString = QString();
+    QVariant value;
+    if ( !d->mProgram || !d->mProgram->run( this, context, value ) )
+      value = d->mRootNode->eval( this, context );
+    if ( !d->mEvalErrorString.isNull() && firstError.isNull() )
+      firstError = d->mEvalErrorString;
+    return value;
+  };
+
+  // look for the "field <op> numeric literal" shape, which covers most filter predicates
+  QgsExpressionNodeBinaryOperator::BinaryOperator op = QgsExpressionNodeBinaryOperator::boOr;
+  int fieldIndex = -1;
+  QVariant literal;
+  if ( !features.isEmpty() && d->mRootNode->nodeType() == QgsExpressionNode::ntBinaryOperator )
+  {
+    const QgsExpressionNodeBinaryOperator *binOp = static_cast< const QgsExpressionNodeBinaryOperator * >( d->mRootNode );
+    op = binOp->op();
+    switch ( op )
+    {
+      case QgsExpressionNodeBinaryOperator::boEQ:
+      case QgsExpressionNodeBinaryOperator::boNE:
+      case QgsExpressionNodeBinaryOperator::boLT:
+      case QgsExpressionNodeBinaryOperator::boGT:
+      case QgsExpressionNodeBinaryOperator::boLE:
+      case QgsExpressionNodeBinaryOperator::boGE:
+      case QgsExpressionNodeBinaryOperator::boPlus:
+      case QgsExpressionNodeBinaryOperator::boMinus:
+      case QgsExpressionNodeBinaryOperator::boMul:
+      case QgsExpressionNodeBinaryOperator::boDiv:
+        if ( binOp->opLeft()->nodeType() == QgsExpressionNode::ntColumnRef &&
+             binOp->opRight()->nodeType() == QgsExpressionNode::ntLiteral )
+        {
+          literal = static_cast< const QgsExpressionNodeLiteral * >( binOp->opRight() )->value();
+          if ( literal.type() == QVariant::Int || literal.type() == QVariant::LongLong || literal.type() == QVariant::Double )
+          {
+            const QString name = static_cast< const QgsExpressionNodeColumnRef * >( binOp->opLeft() )->name();
+            QgsFields fields = context->fields();
+            if ( fields.isEmpty() )
+              fields = features.at( 0 ).fields();
+            fieldIndex = fields.lookupField( name );
+          }
+        }
+        break;
+
+      default:
+        break;
+    }
+  }
+
+  if ( fieldIndex < 0 )
+  {
+    for ( const QgsFeature &feature : features )
+      results << evaluateFeature( feature );
+
+    d->mEvalErrorString = firstError;
+    return results;
+  }
+
+  enum ValueKind
+  {
+    IntValue,
+    DoubleValue,
+    NullValue,
+    OtherValue, //!< Needs the generic evaluation (e.g. strings, dates)
+  };
+
+  const int count = features.size();
+  const bool isComparison = op != QgsExpressionNodeBinaryOperator::boPlus && op != QgsExpressionNodeBinaryOperator::boMinus
+                            && op != QgsExpressionNodeBinaryOperator::boMul && op != QgsExpressionNodeBinaryOperator::boDiv;
+  const bool literalIsInt = literal.type() != QVariant::Double;
+  const double literalDouble = literal.toDouble();
+  const qlonglong literalInt = literal.toLongLong();
+
+  // gather the operands of the whole block into contiguous arrays first
+  std::vector< ValueKind > kinds( count );
+  std::vector< double > doubles( count, 0.0 );
+  std::vector< qlonglong > ints( count, 0 );
+  for ( int i = 0; i < count; ++i )
+  {
+    const QVariant value = features.at( i ).attribute( fieldIndex );
+    if ( value.isNull() )
+    {
+      kinds[i] = NullValue;
+      continue;
+    }
+
+    switch ( value.type() )
+    {
+      case QVariant::Int:
+      case QVariant::LongLong:
+        kinds[i] = IntValue;
+        ints[i] = value.toLongLong();
+        doubles[i] = static_cast< double >( ints[i] );
+        break;
+
+      case QVariant::Double:
+        kinds[i] = DoubleValue;
+        doubles[i] = value.toDouble();
+        break;
+
+      default:
+        kinds[i] = OtherValue;
+        break;
+    }
+  }
+
+  // then run the operator as a tight loop over the arrays
+  std::vector< double > doubleResults( count );
+  std::vector< qlonglong > intResults( count );
+  switch ( op )
+  {
+    case QgsExpressionNodeBinaryOperator::boEQ:
+      for ( int i = 0; i < count; ++i )
+        intResults[i] = qgsDoubleNear( doubles[i] - literalDouble, 0.0 );
+      break;
+    case QgsExpressionNodeBinaryOperator::boNE:
+      for ( int i = 0; i < count; ++i )
+        intResults[i] = !qgsDoubleNear( doubles[i] - literalDouble, 0.0 );
+      break;
+    case QgsExpressionNodeBinaryOperator::boLT:
+      for ( int i = 0; i < count; ++i )
+        intResults[i] = doubles[i] - literalDouble < 0;
+      break;
+    case QgsExpressionNodeBinaryOperator::boGT:
+      for ( int i = 0; i < count; ++i )
+        intResults[i] = doubles[i] - literalDouble > 0;
+      break;
+    case QgsExpressionNodeBinaryOperator::boLE:
+      for ( int i = 0; i < count; ++i )
+        intResults[i] = doubles[i] - literalDouble <= 0;
+      break;
+    case QgsExpressionNodeBinaryOperator::boGE:
+      for ( int i = 0; i < count; ++i )
+        intResults[i] = doubles[i] - literalDouble >= 0;
+      break;
+    case QgsExpressionNodeBinaryOperator::boPlus:
+      for ( int i = 0; i < count; ++i )
+      {
+        intResults[i] = ints[i] + literalInt;
+        doubleResults[i] = doubles[i] + literalDouble;
+      }
+      break;
+    case QgsExpressionNodeBinaryOperator::boMinus:
+      for ( int i = 0; i < count; ++i )
+      {
+        intResults[i] = ints[i] - literalInt;
+        doubleResults[i] = doubles[i] - literalDouble;
+      }
+      break;
+    case QgsExpressionNodeBinaryOperator::boMul:
+      for ( int i = 0; i < count; ++i )
+      {
+        intResults[i] = ints[i] * literalInt;
+        doubleResults[i] = doubles[i] * literalDouble;
+      }
+      break;
+    case QgsExpressionNodeBinaryOperator::boDiv:
+      for ( int i = 0; i < count; ++i )
+        doubleResults[i] = doubles[i] / literalDouble;
+      break;
+    default:
+      Q_ASSERT( false );
+      break;
+  }
+
+  // box the results, matching the types returned by QgsExpressionNodeBinaryOperator
+  for ( int i = 0; i < count; ++i )
+  {
+    switch ( kinds[i] )
+    {
+      case NullValue:
+        results << QVariant();
+        break;
+
+      case OtherValue:
+        results << evaluateFeature( features.at( i ) );
+        break;
+
+      case IntValue:
+      case DoubleValue:
+        if ( isComparison )
+          results << QVariant( static_cast< int >( intResults[i] ) );
+        else if ( op == QgsExpressionNodeBinaryOperator::boDiv && literalDouble == 0.0 )
+          results << QVariant(); // division by zero returns NULL
+        else if ( op != QgsExpressionNodeBinaryOperator::boDiv && kinds[i] == IntValue && literalIsInt )
+          results << QVariant( intResults[i] );
+        else
+          results << QVariant( doubleResults[i] );
+        break;
+    }
+  }
+
+  d->mEvalErrorString = firstError;
+  return results;
+}
+
 bool QgsExpression::hasEvalError() const
 {
   return !d->mEvalErrorString.isNull();
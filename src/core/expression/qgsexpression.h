@@ -242,6 +242,35 @@ class CORE_EXPORT QgsExpression
      */
     bool prepare( const QgsExpressionContext *context );
 
+    /**
+     * Compiles the prepared expression into a flat program of typed instructions, which
+     * evaluate() and evaluateBatch() then run instead of walking the expression tree.
+     *
+     * Comparisons, arithmetic, logical operators, concatenation and IN with a list of
+     * values are compiled when the types of their operands are known from the fields
+     * of the \a context and the static values of the expression. Other nodes, such as
+     * function calls, keep being evaluated by the tree. Features whose attribute types
+     * do not match the fields are also evaluated by the tree, so the results are the
+     * same either way.
+     *
+     * The expression is prepared first if prepare() has not been called yet. The
+     * compiled program is discarded by prepare() and setExpression().
+     *
+     * Returns TRUE if the expression could be compiled.
+     *
+     * \see isCompiled()
+     * \since QGIS 3.10
+     */
+    bool compile( const QgsExpressionContext *context );
+
+    /**
+     * Returns TRUE if the expression has been compiled with compile().
+     *
+     * \see compile()
+     * \since QGIS 3.10
+     */
+    bool isCompiled() const;
+
     /**
      * Gets list of columns referenced by the expression.
      *
@@ -327,6 +356,24 @@ class CORE_EXPORT QgsExpression
      */
     QVariant evaluate( const QgsExpressionContext *context );
 
+    /**
+     * Evaluates the expression for every feature in \a features and returns the results,
+     * in the same order as the features.
+     *
+     * The \a context is reused for the whole block, only its feature is replaced between
+     * evaluations. Simple comparisons and arithmetic between a numeric field and a numeric
+     * literal (e.g. "population" > 10000) are computed in a single typed loop over the
+     * attribute values, without walking the expression tree for each feature.
+     *
+     * The result for a feature which fails to evaluate is an invalid QVariant. In that case
+     * hasEvalError() returns TRUE after the call and evalErrorString() reports the first
+     * error encountered.
+     *
+     * \note prepare() should be called before calling this method.
+     * \since QGIS 3.10
+     */
+    QVariantList evaluateBatch( const QList< QgsFeature > &features, QgsExpressionContext *context );
+
     //! Returns TRUE if an error occurred when evaluating last input
     bool hasEvalError() const;
     //! Returns evaluation error
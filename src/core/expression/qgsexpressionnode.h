@@ -266,6 +266,24 @@ class CORE_EXPORT QgsExpressionNode SIP_ABSTRACT
      */
     bool prepare( QgsExpression *parent, const QgsExpressionContext *context );
 
+    /**
+     * Returns TRUE if the node was found static by prepare(), in which case
+     * eval() returns cachedStaticValue() without evaluating the node.
+     *
+     * \see cachedStaticValue()
+     * \since QGIS 3.10
+     */
+    bool hasCachedStaticValue() const { return mHasCachedValue; }
+
+    /**
+     * Returns the value cached by prepare() for a static node. Only valid if
+     * hasCachedStaticValue() returns TRUE.
+     *
+     * \see hasCachedStaticValue()
+     * \since QGIS 3.10
+     */
+    QVariant cachedStaticValue() const { return mCachedStaticValue; }
+
     /**
      * First line in the parser this node was found.
      * \note This might not be complete for all nodes. Currently
@@ -178,6 +178,18 @@ QVariant QgsExpressionNodeBinaryOperator::evalNode( QgsExpression *parent, const
 {
   QVariant vL = mOpLeft->eval( parent, context );
   ENSURE_NO_EVAL_ERROR;
+
+  if ( mOp == boAnd || mOp == boOr )
+  {
+    // short-circuit: the right operand cannot change the result
+    QgsExpressionUtils::TVL tvlL = QgsExpressionUtils::getTVLValue( vL, parent );
+    ENSURE_NO_EVAL_ERROR;
+    if ( mOp == boAnd && tvlL == QgsExpressionUtils::False )
+      return TVL_False;
+    if ( mOp == boOr && tvlL == QgsExpressionUtils::True )
+      return TVL_True;
+  }
+
   QVariant vR = mOpRight->eval( parent, context );
   ENSURE_NO_EVAL_ERROR;
 
@@ -463,45 +475,17 @@ QVariant QgsExpressionNodeBinaryOperator::evalNode( QgsExpression *parent, const
       {
         QString str    = QgsExpressionUtils::getStringValue( vL, parent );
         ENSURE_NO_EVAL_ERROR;
-        QString regexp = QgsExpressionUtils::getStringValue( vR, parent );
-        ENSURE_NO_EVAL_ERROR;
-        // TODO: cache QRegExp in case that regexp is a literal string (i.e. it will stay constant)
         bool matches;
-        if ( mOp == boLike || mOp == boILike || mOp == boNotLike || mOp == boNotILike ) // change from LIKE syntax to regexp
+        if ( mHasCachedRegExp )
         {
-          QString esc_regexp = QRegExp::escape( regexp );
-          // manage escape % and _
-          if ( esc_regexp.startsWith( '%' ) )
-          {
-            esc_regexp.replace( 0, 1, QStringLiteral( ".*" ) );
-          }
-          QRegExp rx( "[^\\\\](%)" );
-          int pos = 0;
-          while ( ( pos = rx.indexIn( esc_regexp, pos ) ) != -1 )
-          {
-            esc_regexp.replace( pos + 1, 1, QStringLiteral( ".*" ) );
-            pos += 1;
-          }
-          rx.setPattern( QStringLiteral( "\\\\%" ) );
-          esc_regexp.replace( rx, QStringLiteral( "%" ) );
-          if ( esc_regexp.startsWith( '_' ) )
-          {
-            esc_regexp.replace( 0, 1, QStringLiteral( "." ) );
-          }
-          rx.setPattern( QStringLiteral( "[^\\\\](_)" ) );
-          pos = 0;
-          while ( ( pos = rx.indexIn( esc_regexp, pos ) ) != -1 )
-          {
-            esc_regexp.replace( pos + 1, 1, '.' );
-            pos += 1;
-          }
-          rx.setPattern( QStringLiteral( "\\\\_" ) );
-          esc_regexp.replace( rx, QStringLiteral( "_" ) );
-          matches = QRegExp( esc_regexp, mOp == boLike || mOp == boNotLike ? Qt::CaseSensitive : Qt::CaseInsensitive ).exactMatch( str );
+          matches = mOp == boRegexp ? mCachedRegExp.indexIn( str ) != -1 : mCachedRegExp.exactMatch( str );
         }
         else
         {
-          matches = QRegExp( regexp ).indexIn( str ) != -1;
+          QString regexp = QgsExpressionUtils::getStringValue( vR, parent );
+          ENSURE_NO_EVAL_ERROR;
+          QRegExp rx = createRegExp( regexp );
+          matches = mOp == boRegexp ? rx.indexIn( str ) != -1 : rx.exactMatch( str );
         }
 
         if ( mOp == boNotLike || mOp == boNotILike )
@@ -573,6 +557,43 @@ qlonglong QgsExpressionNodeBinaryOperator::computeInt( qlonglong x, qlonglong y
   }
 }
 
+QRegExp QgsExpressionNodeBinaryOperator::createRegExp( const QString &pattern ) const
+{
+  if ( mOp == boRegexp )
+    return QRegExp( pattern );
+
+  // change from LIKE syntax to regexp
+  QString esc_regexp = QRegExp::escape( pattern );
+  // manage escape % and _
+  if ( esc_regexp.startsWith( '%' ) )
+  {
+    esc_regexp.replace( 0, 1, QStringLiteral( ".*" ) );
+  }
+  QRegExp rx( "[^\\\\](%)" );
+  int pos = 0;
+  while ( ( pos = rx.indexIn( esc_regexp, pos ) ) != -1 )
+  {
+    esc_regexp.replace( pos + 1, 1, QStringLiteral( ".*" ) );
+    pos += 1;
+  }
+  rx.setPattern( QStringLiteral( "\\\\%" ) );
+  esc_regexp.replace( rx, QStringLiteral( "%" ) );
+  if ( esc_regexp.startsWith( '_' ) )
+  {
+    esc_regexp.replace( 0, 1, QStringLiteral( "." ) );
+  }
+  rx.setPattern( QStringLiteral( "[^\\\\](_)" ) );
+  pos = 0;
+  while ( ( pos = rx.indexIn( esc_regexp, pos ) ) != -1 )
+  {
+    esc_regexp.replace( pos + 1, 1, '.' );
+    pos += 1;
+  }
+  rx.setPattern( QStringLiteral( "\\\\_" ) );
+  esc_regexp.replace( rx, QStringLiteral( "_" ) );
+  return QRegExp( esc_regexp, mOp == boLike || mOp == boNotLike ? Qt::CaseSensitive : Qt::CaseInsensitive );
+}
+
 QDateTime QgsExpressionNodeBinaryOperator::computeDateTimeFromInterval( const QDateTime &d, QgsInterval *i )
 {
   switch ( mOp )
@@ -616,6 +637,31 @@ bool QgsExpressionNodeBinaryOperator::prepareNode( QgsExpression *parent, const
 {
   bool resL = mOpLeft->prepare( parent, context );
   bool resR = mOpRight->prepare( parent, context );
+
+  mHasCachedRegExp = false;
+  switch ( mOp )
+  {
+    case boRegexp:
+    case boLike:
+    case boNotLike:
+    case boILike:
+    case boNotILike:
+      // the pattern is usually a literal, so avoid rebuilding the regular expression for every feature
+      if ( resR && mOpRight->isStatic( parent, context ) )
+      {
+        const QVariant pattern = mOpRight->eval( parent, context );
+        if ( !parent->hasEvalError() && !QgsExpressionUtils::isNull( pattern ) )
+        {
+          mCachedRegExp = createRegExp( QgsExpressionUtils::getStringValue( pattern, parent ) );
+          mHasCachedRegExp = !parent->hasEvalError();
+        }
+      }
+      break;
+
+    default:
+      break;
+  }
+
   return resL && resR;
 }
 
@@ -764,6 +810,8 @@ QgsExpressionNode *QgsExpressionNodeBinaryOperator::clone() const
 {
   QgsExpressionNodeBinaryOperator *copy = new QgsExpressionNodeBinaryOperator( mOp, mOpLeft->clone(), mOpRight->clone() );
   cloneTo( copy );
+  copy->mCachedRegExp = mCachedRegExp;
+  copy->mHasCachedRegExp = mHasCachedRegExp;
   return copy;
 }
 
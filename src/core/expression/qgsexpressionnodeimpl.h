@@ -20,6 +20,8 @@
 #include "qgsexpressionnode.h"
 #include "qgsinterval.h"
 
+#include <QRegExp>
+
 /**
  * \ingroup core
  * A unary node is either negative as in boolean (not) or as in numbers (minus).
@@ -199,10 +201,20 @@ class CORE_EXPORT QgsExpressionNodeBinaryOperator : public QgsExpressionNode
      */
     QDateTime computeDateTimeFromInterval( const QDateTime &d, QgsInterval *i );
 
+    /**
+     * Creates the regular expression used by the ~, LIKE and ILIKE operators
+     * (and their negations) to match against \a pattern.
+     */
+    QRegExp createRegExp( const QString &pattern ) const;
+
     BinaryOperator mOp;
     QgsExpressionNode *mOpLeft = nullptr;
     QgsExpressionNode *mOpRight = nullptr;
 
+    //! Regular expression built at prepare time when the pattern of a matching operator is static
+    QRegExp mCachedRegExp;
+    bool mHasCachedRegExp = false;
+
     static const char *BINARY_OPERATOR_TEXT[];
 };
 
@@ -0,0 +1,852 @@
+/***************************************************************************
+                               qgsexpressionprogram.cpp
+                             -------------------
+    begin                : October 2019
+    copyright            : (C) 2019 by the QGIS project
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgsexpressionprogram.h"
+
+#include "qgsexpression.h"
+#include "qgsexpressioncontext.h"
+#include "qgsexpressionnodeimpl.h"
+#include "qgsexpressionutils.h"
+#include "qgsfeature.h"
+
+#include <cmath>
+
+///@cond PRIVATE
+
+// mirrors QgsExpressionNodeBinaryOperator::compare()
+static bool compareDiff( int op, double diff )
+{
+  switch ( op )
+  {
+    case QgsExpressionNodeBinaryOperator::boEQ:
+      return qgsDoubleNear( diff, 0.0 );
+    case QgsExpressionNodeBinaryOperator::boNE:
+      return !qgsDoubleNear( diff, 0.0 );
+    case QgsExpressionNodeBinaryOperator::boLT:
+      return diff < 0;
+    case QgsExpressionNodeBinaryOperator::boGT:
+      return diff > 0;
+    case QgsExpressionNodeBinaryOperator::boLE:
+      return diff <= 0;
+    case QgsExpressionNodeBinaryOperator::boGE:
+      return diff >= 0;
+    default:
+      Q_ASSERT( false );
+      return false;
+  }
+}
+
+std::unique_ptr<QgsExpressionProgram> QgsExpressionProgram::compile( QgsExpressionNode *root, const QgsExpressionContext *context )
+{
+  if ( !root || !context || nodeIsConstant( root ) || root->nodeType() == QgsExpressionNode::ntColumnRef )
+    return nullptr;
+
+  std::unique_ptr< QgsExpressionProgram > program( new QgsExpressionProgram() );
+  program->mContext = context;
+
+  // a root which is evaluated by the interpreter anyway would only add overhead
+  if ( program->kindOf( root ) == Variant )
+    return nullptr;
+
+  program->mResult = program->compileNode( root );
+
+  // only needed while compiling
+  program->mContext = nullptr;
+  program->mKinds.clear();
+  program->mColumnRegisters.clear();
+  return program;
+}
+
+bool QgsExpressionProgram::run( QgsExpression *parent, const QgsExpressionContext *context, QVariant &result )
+{
+  if ( !mColumnLoads.empty() )
+  {
+    // load and check all the attributes first, so that a feature which does not match
+    // the compiled types can still be handed over to the interpreter
+    if ( !context )
+      return false;
+
+    const QgsFeature feature = context->feature();
+    if ( !feature.isValid() )
+      return false;
+
+    const QgsAttributes attributes = feature.attributes();
+    for ( const ColumnLoad &load : mColumnLoads )
+    {
+      if ( !loadColumn( mRegisters[ load.reg ], load.kind, load.fieldIndex < attributes.size() ? attributes.at( load.fieldIndex ) : QVariant() ) )
+        return false;
+    }
+  }
+
+  const int count = static_cast< int >( mInstructions.size() );
+  for ( int pc = 0; pc < count; ++pc )
+  {
+    const Instruction &instruction = mInstructions[ pc ];
+    Register &dst = mRegisters[ instruction.dst ];
+    bool ok = true;
+
+    switch ( instruction.op )
+    {
+      case Eval:
+        dst.variantValue = instruction.node->eval( parent, context );
+        dst.isNull = dst.variantValue.isNull();
+        ok = !parent->hasEvalError();
+        break;
+
+      case Not:
+      {
+        int tvl = QgsExpressionUtils::Unknown;
+        ok = toTvl( instruction.left, parent, tvl );
+        if ( ok )
+          setTvl( dst, QgsExpressionUtils::NOT[ tvl ] );
+        break;
+      }
+
+      case ShortCircuitAnd:
+      case ShortCircuitOr:
+      {
+        int tvl = QgsExpressionUtils::Unknown;
+        ok = toTvl( instruction.left, parent, tvl );
+        if ( ok )
+        {
+          setTvl( dst, static_cast< QgsExpressionUtils::TVL >( tvl ) );
+          if ( ( instruction.op == ShortCircuitAnd && tvl == QgsExpressionUtils::False ) ||
+               ( instruction.op == ShortCircuitOr && tvl == QgsExpressionUtils::True ) )
+            pc = instruction.arg - 1;
+        }
+        break;
+      }
+
+      case And:
+      case Or:
+      {
+        int tvl = QgsExpressionUtils::Unknown;
+        ok = toTvl( instruction.right, parent, tvl );
+        if ( ok )
+          setTvl( dst, instruction.op == And ? QgsExpressionUtils::AND[ dst.tvl ][ tvl ] : QgsExpressionUtils::OR[ dst.tvl ][ tvl ] );
+        break;
+      }
+
+      case ArithmeticInt:
+      {
+        const Register &left = mRegisters[ instruction.left ];
+        const Register &right = mRegisters[ instruction.right ];
+        dst.isNull = left.isNull || right.isNull;
+        if ( dst.isNull )
+          break;
+
+        switch ( instruction.arg )
+        {
+          case QgsExpressionNodeBinaryOperator::boPlus:
+            dst.intValue = left.intValue + right.intValue;
+            break;
+          case QgsExpressionNodeBinaryOperator::boMinus:
+            dst.intValue = left.intValue - right.intValue;
+            break;
+          case QgsExpressionNodeBinaryOperator::boMul:
+            dst.intValue = left.intValue * right.intValue;
+            break;
+          case QgsExpressionNodeBinaryOperator::boMod:
+            if ( right.intValue == 0 )
+              dst.isNull = true;
+            else
+              dst.intValue = left.intValue % right.intValue;
+            break;
+          default:
+            Q_ASSERT( false );
+            break;
+        }
+        break;
+      }
+
+      case ArithmeticDouble:
+      case Power:
+      {
+        dst.isNull = mRegisters[ instruction.left ].isNull || mRegisters[ instruction.right ].isNull;
+        if ( dst.isNull )
+          break;
+
+        double x = 0;
+        double y = 0;
+        ok = toDouble( instruction.left, parent, x ) && toDouble( instruction.right, parent, y );
+        if ( !ok )
+          break;
+
+        if ( instruction.op == Power )
+        {
+          dst.doubleValue = std::pow( x, y );
+          break;
+        }
+
+        switch ( instruction.arg )
+        {
+          case QgsExpressionNodeBinaryOperator::boPlus:
+            dst.doubleValue = x + y;
+            break;
+          case QgsExpressionNodeBinaryOperator::boMinus:
+            dst.doubleValue = x - y;
+            break;
+          case QgsExpressionNodeBinaryOperator::boMul:
+            dst.doubleValue = x * y;
+            break;
+          case QgsExpressionNodeBinaryOperator::boDiv:
+          case QgsExpressionNodeBinaryOperator::boMod:
+            // silently handle division by zero and return NULL
+            if ( y == 0. )
+              dst.isNull = true;
+            else
+              dst.doubleValue = instruction.arg == QgsExpressionNodeBinaryOperator::boDiv ? x / y : std::fmod( x, y );
+            break;
+          default:
+            Q_ASSERT( false );
+            break;
+        }
+        break;
+      }
+
+      case AddStrings:
+      {
+        // "+" between two values of string type concatenates them, even when NULL
+        const Register &left = mRegisters[ instruction.left ];
+        const Register &right = mRegisters[ instruction.right ];
+        if ( ( left.isNull && !left.isStringType ) || ( right.isNull && !right.isStringType ) )
+        {
+          dst.isNull = true;
+          dst.isStringType = false;
+          break;
+        }
+        dst.stringValue = left.stringValue + right.stringValue;
+        dst.isNull = dst.stringValue.isNull();
+        dst.isStringType = true;
+        break;
+      }
+
+      case Concat:
+      {
+        const QVariant left = box( instruction.left );
+        const QVariant right = box( instruction.right );
+        if ( left.isNull() || right.isNull() )
+        {
+          dst.isNull = true;
+          dst.isStringType = false;
+          break;
+        }
+        dst.stringValue = left.toString() + right.toString();
+        dst.isNull = dst.stringValue.isNull();
+        dst.isStringType = true;
+        break;
+      }
+
+      case CompareNumeric:
+      {
+        if ( mRegisters[ instruction.left ].isNull || mRegisters[ instruction.right ].isNull )
+        {
+          setTvl( dst, QgsExpressionUtils::Unknown );
+          break;
+        }
+
+        double x = 0;
+        double y = 0;
+        ok = toDouble( instruction.left, parent, x ) && toDouble( instruction.right, parent, y );
+        if ( ok )
+          setTvl( dst, compareDiff( instruction.arg, x - y ) ? QgsExpressionUtils::True : QgsExpressionUtils::False );
+        break;
+      }
+
+      case CompareString:
+      {
+        const Register &left = mRegisters[ instruction.left ];
+        const Register &right = mRegisters[ instruction.right ];
+        if ( left.isNull || right.isNull )
+          setTvl( dst, QgsExpressionUtils::Unknown );
+        else
+          setTvl( dst, compareDiff( instruction.arg, QString::compare( left.stringValue, right.stringValue ) ) ? QgsExpressionUtils::True : QgsExpressionUtils::False );
+        break;
+      }
+
+      case Is:
+      {
+        const Register &left = mRegisters[ instruction.left ];
+        const Register &right = mRegisters[ instruction.right ];
+        bool equal = false;
+        if ( left.isNull || right.isNull )
+        {
+          equal = left.isNull && right.isNull;
+        }
+        else if ( isNumeric( mRegisterKinds[ instruction.left ] ) )
+        {
+          double x = 0;
+          double y = 0;
+          ok = toDouble( instruction.left, parent, x ) && toDouble( instruction.right, parent, y );
+          equal = qgsDoubleNear( x, y );
+        }
+        else
+        {
+          equal = left.stringValue == right.stringValue;
+        }
+
+        if ( ok )
+          setTvl( dst, equal == ( instruction.arg == QgsExpressionNodeBinaryOperator::boIs ) ? QgsExpressionUtils::True : QgsExpressionUtils::False );
+        break;
+      }
+
+      case In:
+      {
+        int tvl = QgsExpressionUtils::Unknown;
+        ok = evalIn( instruction, parent, tvl );
+        if ( ok )
+          setTvl( dst, static_cast< QgsExpressionUtils::TVL >( tvl ) );
+        break;
+      }
+    }
+
+    if ( !ok )
+    {
+      // the error was reported to the parent, like the interpreter does
+      result = QVariant();
+      return true;
+    }
+  }
+
+  result = box( mResult );
+  return true;
+}
+
+bool QgsExpressionProgram::nodeIsConstant( const QgsExpressionNode *node )
+{
+  return node->hasCachedStaticValue() || node->nodeType() == QgsExpressionNode::ntLiteral;
+}
+
+QVariant QgsExpressionProgram::constantValue( const QgsExpressionNode *node )
+{
+  if ( node->hasCachedStaticValue() )
+    return node->cachedStaticValue();
+  return static_cast< const QgsExpressionNodeLiteral * >( node )->value();
+}
+
+QgsExpressionProgram::Kind QgsExpressionProgram::kindForValue( const QVariant &value )
+{
+  if ( !value.isValid() )
+    return Null;
+
+  return kindForType( value.type() );
+}
+
+QgsExpressionProgram::Kind QgsExpressionProgram::kindForType( QVariant::Type type )
+{
+  switch ( type )
+  {
+    case QVariant::Int:
+    case QVariant::UInt:
+    case QVariant::LongLong:
+    case QVariant::ULongLong:
+      return Int;
+    case QVariant::Double:
+      return Double;
+    case QVariant::String:
+      return String;
+    default:
+      return Variant;
+  }
+}
+
+QgsExpressionProgram::Kind QgsExpressionProgram::kindOf( const QgsExpressionNode *node )
+{
+  auto it = mKinds.constFind( node );
+  if ( it != mKinds.constEnd() )
+    return it.value();
+
+  Kind kind = Variant;
+  if ( nodeIsConstant( node ) )
+  {
+    kind = kindForValue( constantValue( node ) );
+  }
+  else
+  {
+    switch ( node->nodeType() )
+    {
+      case QgsExpressionNode::ntColumnRef:
+      {
+        // typed by the field, or left to the interpreter which also looks the name up in the feature
+        const QgsFields fields = mContext->fields();
+        const int index = fields.lookupField( static_cast< const QgsExpressionNodeColumnRef * >( node )->name() );
+        if ( index >= 0 )
+          kind = kindForType( fields.at( index ).type() );
+        break;
+      }
+
+      case QgsExpressionNode::ntUnaryOperator:
+      {
+        const QgsExpressionNodeUnaryOperator *unOp = static_cast< const QgsExpressionNodeUnaryOperator * >( node );
+        if ( unOp->op() == QgsExpressionNodeUnaryOperator::uoNot )
+        {
+          kindOf( unOp->operand() );
+          kind = Tvl;
+        }
+        break;
+      }
+
+      case QgsExpressionNode::ntBinaryOperator:
+      {
+        const QgsExpressionNodeBinaryOperator *binOp = static_cast< const QgsExpressionNodeBinaryOperator * >( node );
+        const Kind left = kindOf( binOp->opLeft() );
+        const Kind right = kindOf( binOp->opRight() );
+        switch ( binOp->op() )
+        {
+          case QgsExpressionNodeBinaryOperator::boAnd:
+          case QgsExpressionNodeBinaryOperator::boOr:
+            kind = Tvl;
+            break;
+
+          case QgsExpressionNodeBinaryOperator::boEQ:
+          case QgsExpressionNodeBinaryOperator::boNE:
+          case QgsExpressionNodeBinaryOperator::boLT:
+          case QgsExpressionNodeBinaryOperator::boGT:
+          case QgsExpressionNodeBinaryOperator::boLE:
+          case QgsExpressionNodeBinaryOperator::boGE:
+            if ( ( isNumeric( left ) && isNumeric( right ) ) || ( left == String && right == String ) )
+              kind = Tvl;
+            break;
+
+          case QgsExpressionNodeBinaryOperator::boIs:
+          case QgsExpressionNodeBinaryOperator::boIsNot:
+            if ( left == Null || right == Null || ( isNumeric( left ) && isNumeric( right ) ) || ( left == String && right == String ) )
+              kind = Tvl;
+            break;
+
+          case QgsExpressionNodeBinaryOperator::boPlus:
+            if ( left == String && right == String )
+            {
+              kind = String;
+              break;
+            }
+            FALLTHROUGH
+          case QgsExpressionNodeBinaryOperator::boMinus:
+          case QgsExpressionNodeBinaryOperator::boMul:
+          case QgsExpressionNodeBinaryOperator::boMod:
+            if ( left == Int && right == Int )
+              kind = Int;
+            else if ( isNumeric( left ) && isNumeric( right ) )
+              kind = Double;
+            break;
+
+          case QgsExpressionNodeBinaryOperator::boDiv:
+          case QgsExpressionNodeBinaryOperator::boPow:
+            if ( isNumeric( left ) && isNumeric( right ) )
+              kind = Double;
+            break;
+
+          case QgsExpressionNodeBinaryOperator::boConcat:
+            if ( left != Null && right != Null )
+              kind = String;
+            break;
+
+          default:
+            break;
+        }
+        break;
+      }
+
+      case QgsExpressionNode::ntInOperator:
+      {
+        const QgsExpressionNodeInOperator *inOp = static_cast< const QgsExpressionNodeInOperator * >( node );
+        const Kind value = kindOf( inOp->node() );
+        if ( ( isNumeric( value ) || value == String ) && inOp->list()->count() > 0 )
+        {
+          kind = Tvl;
+          const QList< QgsExpressionNode * > items = inOp->list()->list();
+          for ( const QgsExpressionNode *item : items )
+          {
+            if ( !nodeIsConstant( item ) )
+            {
+              kind = Variant;
+              break;
+            }
+          }
+        }
+        break;
+      }
+
+      default:
+        break;
+    }
+  }
+
+  mKinds.insert( node, kind );
+  return kind;
+}
+
+int QgsExpressionProgram::compileNode( QgsExpressionNode *node )
+{
+  const Kind kind = kindOf( node );
+
+  if ( nodeIsConstant( node ) )
+  {
+    const int reg = addRegister( kind );
+    Register &constant = mRegisters[ reg ];
+    const QVariant value = constantValue( node );
+    constant.isNull = value.isNull();
+    constant.isStringType = value.type() == QVariant::String;
+    switch ( kind )
+    {
+      case Int:
+        constant.intValue = value.toLongLong();
+        break;
+      case Double:
+        constant.doubleValue = value.toDouble();
+        break;
+      case String:
+        constant.stringValue = value.toString();
+        break;
+      case Variant:
+        constant.variantValue = value;
+        break;
+      case Null:
+      case Tvl:
+        break;
+    }
+    return reg;
+  }
+
+  if ( kind == Variant )
+  {
+    const int reg = addRegister( Variant );
+    addInstruction( Eval, reg, -1, -1, 0, node );
+    return reg;
+  }
+
+  switch ( node->nodeType() )
+  {
+    case QgsExpressionNode::ntColumnRef:
+    {
+      const int fieldIndex = mContext->fields().lookupField( static_cast< const QgsExpressionNodeColumnRef * >( node )->name() );
+      auto it = mColumnRegisters.constFind( fieldIndex );
+      if ( it != mColumnRegisters.constEnd() )
+        return it.value();
+
+      const int reg = addRegister( kind );
+      mColumnLoads.push_back( { fieldIndex, kind, reg } );
+      mColumnRegisters.insert( fieldIndex, reg );
+      return reg;
+    }
+
+    case QgsExpressionNode::ntUnaryOperator:
+    {
+      // only NOT is compiled
+      const int operand = compileNode( static_cast< QgsExpressionNodeUnaryOperator * >( node )->operand() );
+      const int reg = addRegister( Tvl );
+      addInstruction( Not, reg, operand );
+      return reg;
+    }
+
+    case QgsExpressionNode::ntBinaryOperator:
+    {
+      QgsExpressionNodeBinaryOperator *binOp = static_cast< QgsExpressionNodeBinaryOperator * >( node );
+      const QgsExpressionNodeBinaryOperator::BinaryOperator op = binOp->op();
+      const int reg = addRegister( kind );
+      const int left = compileNode( binOp->opLeft() );
+
+      if ( op == QgsExpressionNodeBinaryOperator::boAnd || op == QgsExpressionNodeBinaryOperator::boOr )
+      {
+        const int shortCircuit = addInstruction( op == QgsExpressionNodeBinaryOperator::boAnd ? ShortCircuitAnd : ShortCircuitOr, reg, left );
+        const int right = compileNode( binOp->opRight() );
+        addInstruction( op == QgsExpressionNodeBinaryOperator::boAnd ? And : Or, reg, reg, right );
+        mInstructions[ shortCircuit ].arg = static_cast< int >( mInstructions.size() );
+        return reg;
+      }
+
+      const int right = compileNode( binOp->opRight() );
+      OpCode code = Eval;
+      switch ( op )
+      {
+        case QgsExpressionNodeBinaryOperator::boEQ:
+        case QgsExpressionNodeBinaryOperator::boNE:
+        case QgsExpressionNodeBinaryOperator::boLT:
+        case QgsExpressionNodeBinaryOperator::boGT:
+        case QgsExpressionNodeBinaryOperator::boLE:
+        case QgsExpressionNodeBinaryOperator::boGE:
+          code = isNumeric( mRegisterKinds[ left ] ) ? CompareNumeric : CompareString;
+          break;
+
+        case QgsExpressionNodeBinaryOperator::boIs:
+        case QgsExpressionNodeBinaryOperator::boIsNot:
+          code = Is;
+          break;
+
+        case QgsExpressionNodeBinaryOperator::boPlus:
+        case QgsExpressionNodeBinaryOperator::boMinus:
+        case QgsExpressionNodeBinaryOperator::boMul:
+        case QgsExpressionNodeBinaryOperator::boMod:
+          code = kind == String ? AddStrings : kind == Int ? ArithmeticInt : ArithmeticDouble;
+          break;
+
+        case QgsExpressionNodeBinaryOperator::boDiv:
+          code = ArithmeticDouble;
+          break;
+
+        case QgsExpressionNodeBinaryOperator::boPow:
+          code = Power;
+          break;
+
+        case QgsExpressionNodeBinaryOperator::boConcat:
+          code = Concat;
+          break;
+
+        default:
+          Q_ASSERT( false );
+          break;
+      }
+      addInstruction( code, reg, left, right, op );
+      return reg;
+    }
+
+    case QgsExpressionNode::ntInOperator:
+    {
+      QgsExpressionNodeInOperator *inOp = static_cast< QgsExpressionNodeInOperator * >( node );
+      const int value = compileNode( inOp->node() );
+
+      InList list;
+      list.notIn = inOp->isNotIn();
+      list.hasNull = false;
+      const QList< QgsExpressionNode * > items = inOp->list()->list();
+      for ( const QgsExpressionNode *itemNode : items )
+      {
+        InItem item;
+        item.value = constantValue( itemNode );
+        item.isNull = item.value.isNull();
+        item.isDoubleSafe = QgsExpressionUtils::isDoubleSafe( item.value );
+        item.doubleValue = item.value.toDouble();
+        item.stringValue = item.value.toString();
+        list.hasNull = list.hasNull || item.isNull;
+        list.items.push_back( item );
+      }
+      mInLists.push_back( list );
+
+      const int reg = addRegister( Tvl );
+      addInstruction( In, reg, value, -1, static_cast< int >( mInLists.size() ) - 1 );
+      return reg;
+    }
+
+    default:
+      break;
+  }
+
+  Q_ASSERT( false );
+  return -1;
+}
+
+void QgsExpressionProgram::setTvl( Register &reg, int tvl )
+{
+  reg.tvl = tvl;
+  reg.isNull = tvl == QgsExpressionUtils::Unknown;
+}
+
+int QgsExpressionProgram::addRegister( Kind kind )
+{
+  mRegisterKinds.push_back( kind );
+  mRegisters.emplace_back( Register() );
+  return static_cast< int >( mRegisters.size() ) - 1;
+}
+
+int QgsExpressionProgram::addInstruction( OpCode op, int dst, int left, int right, int arg, QgsExpressionNode *node )
+{
+  mInstructions.push_back( { op, dst, left, right, arg, node } );
+  return static_cast< int >( mInstructions.size() ) - 1;
+}
+
+bool QgsExpressionProgram::loadColumn( Register &reg, Kind kind, const QVariant &value ) const
+{
+  reg.isNull = value.isNull();
+  reg.isStringType = value.type() == QVariant::String;
+  if ( reg.isNull )
+  {
+    reg.stringValue.clear();
+    return true;
+  }
+
+  switch ( kind )
+  {
+    case Int:
+      if ( value.type() != QVariant::Int && value.type() != QVariant::UInt && value.type() != QVariant::LongLong && value.type() != QVariant::ULongLong )
+        return false;
+      reg.intValue = value.toLongLong();
+      return true;
+
+    case Double:
+      if ( value.type() != QVariant::Double )
+        return false;
+      reg.doubleValue = value.toDouble();
+      return true;
+
+    case String:
+      if ( value.type() != QVariant::String )
+        return false;
+      reg.stringValue = value.toString();
+      return true;
+
+    case Null:
+    case Tvl:
+    case Variant:
+      break;
+  }
+  return false;
+}
+
+QVariant QgsExpressionProgram::box( int reg ) const
+{
+  const Register &value = mRegisters[ reg ];
+  switch ( mRegisterKinds[ reg ] )
+  {
+    case Null:
+      return QVariant();
+    case Int:
+      return value.isNull ? QVariant() : QVariant( value.intValue );
+    case Double:
+      return value.isNull ? QVariant() : QVariant( value.doubleValue );
+    case String:
+      return value.isNull && !value.isStringType ? QVariant() : QVariant( value.stringValue );
+    case Tvl:
+      return QgsExpressionUtils::tvl2variant( static_cast< QgsExpressionUtils::TVL >( value.tvl ) );
+    case Variant:
+      return value.variantValue;
+  }
+  return QVariant();
+}
+
+bool QgsExpressionProgram::toTvl( int reg, QgsExpression *parent, int &tvl ) const
+{
+  const Register &value = mRegisters[ reg ];
+  if ( value.isNull )
+  {
+    tvl = QgsExpressionUtils::Unknown;
+    return true;
+  }
+
+  switch ( mRegisterKinds[ reg ] )
+  {
+    case Null:
+      tvl = QgsExpressionUtils::Unknown;
+      return true;
+    case Tvl:
+      tvl = value.tvl;
+      return true;
+    case Int:
+      tvl = value.intValue != 0 ? QgsExpressionUtils::True : QgsExpressionUtils::False;
+      return true;
+    case Double:
+      tvl = !qgsDoubleNear( value.doubleValue, 0.0 ) ? QgsExpressionUtils::True : QgsExpressionUtils::False;
+      return true;
+    case String:
+    case Variant:
+      break;
+  }
+
+  tvl = QgsExpressionUtils::getTVLValue( box( reg ), parent );
+  return !parent->hasEvalError();
+}
+
+bool QgsExpressionProgram::toDouble( int reg, QgsExpression *parent, double &value ) const
+{
+  const Register &number = mRegisters[ reg ];
+  if ( mRegisterKinds[ reg ] == Int )
+  {
+    value = static_cast< double >( number.intValue );
+    return true;
+  }
+
+  if ( !std::isfinite( number.doubleValue ) )
+  {
+    // let the interpreter's conversion report the error
+    QgsExpressionUtils::getDoubleValue( box( reg ), parent );
+    return false;
+  }
+  value = number.doubleValue;
+  return true;
+}
+
+bool QgsExpressionProgram::evalIn( const Instruction &instruction, QgsExpression *parent, int &tvl ) const
+{
+  const Register &value = mRegisters[ instruction.left ];
+  const InList &list = mInLists[ instruction.arg ];
+  if ( value.isNull )
+  {
+    tvl = QgsExpressionUtils::Unknown;
+    return true;
+  }
+
+  // mirrors QgsExpressionUtils::isDoubleSafe() for the tested value
+  const Kind kind = mRegisterKinds[ instruction.left ];
+  bool valueIsDoubleSafe = true;
+  double valueDouble = 0;
+  if ( kind == String )
+  {
+    valueDouble = value.stringValue.toDouble( &valueIsDoubleSafe );
+    valueIsDoubleSafe = valueIsDoubleSafe && std::isfinite( valueDouble );
+  }
+  else if ( kind == Int )
+  {
+    valueDouble = static_cast< double >( value.intValue );
+  }
+  else
+  {
+    valueDouble = value.doubleValue;
+  }
+
+  QString valueString;
+  bool hasValueString = false;
+  for ( const InItem &item : list.items )
+  {
+    if ( item.isNull )
+      continue;
+
+    bool equal = false;
+    if ( valueIsDoubleSafe && item.isDoubleSafe )
+    {
+      if ( !std::isfinite( valueDouble ) )
+      {
+        QgsExpressionUtils::getDoubleValue( box( instruction.left ), parent );
+        return false;
+      }
+      if ( !std::isfinite( item.doubleValue ) )
+      {
+        QgsExpressionUtils::getDoubleValue( item.value, parent );
+        return false;
+      }
+      equal = qgsDoubleNear( valueDouble, item.doubleValue );
+    }
+    else
+    {
+      if ( !hasValueString )
+      {
+        valueString = kind == String ? value.stringValue : box( instruction.left ).toString();
+        hasValueString = true;
+      }
+      equal = valueString == item.stringValue;
+    }
+
+    if ( equal )
+    {
+      tvl = list.notIn ? QgsExpressionUtils::False : QgsExpressionUtils::True;
+      return true;
+    }
+  }
+
+  if ( list.hasNull )
+    tvl = QgsExpressionUtils::Unknown;
+  else
+    tvl = list.notIn ? QgsExpressionUtils::True : QgsExpressionUtils::False;
+  return true;
+}
+
+///@endcond
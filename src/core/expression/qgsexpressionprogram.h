@@ -0,0 +1,190 @@
+/***************************************************************************
+                               qgsexpressionprogram.h
+                             -------------------
+    begin                : October 2019
+    copyright            : (C) 2019 by the QGIS project
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef QGSEXPRESSIONPROGRAM_H
+#define QGSEXPRESSIONPROGRAM_H
+
+#define SIP_NO_FILE
+
+#include <QHash>
+#include <QString>
+#include <QVariant>
+#include <memory>
+#include <vector>
+
+class QgsExpression;
+class QgsExpressionContext;
+class QgsExpressionNode;
+
+/// @cond PRIVATE
+
+/**
+ * A prepared expression tree flattened into a linear list of instructions
+ * working on typed registers.
+ *
+ * Operators whose operand types are known at compile time (from the
+ * field types of the context and the static values of the prepared nodes)
+ * are turned into typed instructions, which avoids walking the tree and
+ * boxing every intermediate value into a QVariant. All other nodes are
+ * kept as a single instruction evaluating the node with the interpreter.
+ *
+ * The attributes read by the typed instructions are loaded and checked
+ * before any instruction runs. If a feature does not match the field
+ * types seen at compile time, run() returns FALSE and the caller should
+ * evaluate the node tree instead.
+ *
+ * Like QgsExpression itself, a program is not reentrant.
+ *
+ * \since QGIS 3.10
+ */
+class QgsExpressionProgram
+{
+  public:
+
+    /**
+     * Compiles the prepared expression tree starting at \a root, using the
+     * fields of the \a context to type the column references.
+     *
+     * Returns NULLPTR if there is nothing to gain over the interpreter, i.e.
+     * the root is a column, a static value or a node which cannot be compiled.
+     */
+    static std::unique_ptr< QgsExpressionProgram > compile( QgsExpressionNode *root, const QgsExpressionContext *context );
+
+    /**
+     * Runs the program against the feature of the \a context and stores the
+     * value in \a result. Evaluation errors are reported to \a parent, in
+     * which case \a result is an invalid QVariant.
+     *
+     * Returns FALSE if the program cannot be used for this feature, and the
+     * node tree must be evaluated instead.
+     */
+    bool run( QgsExpression *parent, const QgsExpressionContext *context, QVariant &result );
+
+    //! Returns the number of instructions of the program
+    int instructionCount() const { return static_cast< int >( mInstructions.size() ); }
+
+  private:
+
+    //! Type of the value held by a register, known at compile time
+    enum Kind
+    {
+      Null, //!< Always NULL
+      Int, //!< qlonglong
+      Double, //!< double
+      String, //!< QString
+      Tvl, //!< Three-valued logic result of a comparison or a logical operator
+      Variant, //!< Any value, as returned by the interpreter
+    };
+
+    enum OpCode
+    {
+      Eval, //!< Evaluates a node with the interpreter
+      Not,
+      ShortCircuitAnd, //!< Stores the left operand of AND, skips the right one if FALSE
+      ShortCircuitOr, //!< Stores the left operand of OR, skips the right one if TRUE
+      And,
+      Or,
+      ArithmeticInt,
+      ArithmeticDouble,
+      Power,
+      AddStrings,
+      Concat,
+      CompareNumeric,
+      CompareString,
+      Is, //!< IS or IS NOT between numbers, between strings, or with a NULL operand
+      In,
+    };
+
+    struct Register
+    {
+      bool isNull = true;
+      //! Whether a NULL value still has the string type, which matters for "+" between strings
+      bool isStringType = false;
+      qlonglong intValue = 0;
+      double doubleValue = 0.0;
+      QString stringValue;
+      QVariant variantValue;
+      //! QgsExpressionUtils::TVL value
+      int tvl = 2;
+    };
+
+    struct Instruction
+    {
+      OpCode op;
+      int dst;
+      int left;
+      int right;
+      //! Binary operator, or the instruction to jump to for short-circuits, or the value list for In
+      int arg;
+      QgsExpressionNode *node;
+    };
+
+    struct ColumnLoad
+    {
+      int fieldIndex;
+      Kind kind;
+      int reg;
+    };
+
+    struct InItem
+    {
+      bool isNull;
+      bool isDoubleSafe;
+      double doubleValue;
+      QString stringValue;
+      QVariant value;
+    };
+
+    struct InList
+    {
+      bool notIn;
+      bool hasNull;
+      std::vector< InItem > items;
+    };
+
+    QgsExpressionProgram() = default;
+
+    static bool nodeIsConstant( const QgsExpressionNode *node );
+    static QVariant constantValue( const QgsExpressionNode *node );
+    static Kind kindForValue( const QVariant &value );
+    static Kind kindForType( QVariant::Type type );
+    static bool isNumeric( Kind kind ) { return kind == Int || kind == Double; }
+
+    Kind kindOf( const QgsExpressionNode *node );
+    int compileNode( QgsExpressionNode *node );
+    int addRegister( Kind kind );
+    int addInstruction( OpCode op, int dst, int left = -1, int right = -1, int arg = 0, QgsExpressionNode *node = nullptr );
+
+    static void setTvl( Register &reg, int tvl );
+    bool loadColumn( Register &reg, Kind kind, const QVariant &value ) const;
+    QVariant box( int reg ) const;
+    bool toTvl( int reg, QgsExpression *parent, int &tvl ) const;
+    bool toDouble( int reg, QgsExpression *parent, double &value ) const;
+    bool evalIn( const Instruction &instruction, QgsExpression *parent, int &tvl ) const;
+
+    const QgsExpressionContext *mContext = nullptr;
+    QHash< const QgsExpressionNode *, Kind > mKinds;
+    QHash< int, int > mColumnRegisters;
+
+    std::vector< Kind > mRegisterKinds;
+    std::vector< Register > mRegisters;
+    std::vector< Instruction > mInstructions;
+    std::vector< ColumnLoad > mColumnLoads;
+    std::vector< InList > mInLists;
+    int mResult = -1;
+};
+
+/// @endcond
+
+#endif // QGSEXPRESSIONPROGRAM_H
@@ -14,6 +14,7 @@ email                : marco.hugentobler at sourcepole dot com
  ***************************************************************************/
 
 #include "qgsgeos.h"
+#include "qgsconfig.h"
 #include "qgsabstractgeometry.h"
 #include "qgsgeometrycollection.h"
 #include "qgsgeometryfactory.h"
@@ -27,6 +28,7 @@ email                : marco.hugentobler at sourcepole dot com
 #include "qgsgeometryeditutils.h"
 #include <limits>
 #include <cstdio>
+#include <QThreadStorage>
 
 #define DEFAULT_QUADRANT_SEGMENTS 8
 
@@ -116,26 +118,32 @@ class GEOSInit
     GEOSInit &operator=( const GEOSInit &rh ) = delete;
 };
 
-static GEOSInit geosinit;
+// every thread uses its own GEOS context, so that the error and notice handlers
+// of concurrent GEOS calls (e.g. when labeling in parallel) don't interfere
+#if defined(USE_THREAD_LOCAL) && !defined(Q_OS_WIN)
+static thread_local GEOSInit sGeosInit;
+#else
+static QThreadStorage< GEOSInit * > sGeosInit;
+#endif
 
 void geos::GeosDeleter::operator()( GEOSGeometry *geom )
 {
-  GEOSGeom_destroy_r( geosinit.ctxt, geom );
+  GEOSGeom_destroy_r( QgsGeos::getGEOSHandler(), geom );
 }
 
 void geos::GeosDeleter::operator()( const GEOSPreparedGeometry *geom )
 {
-  GEOSPreparedGeom_destroy_r( geosinit.ctxt, geom );
+  GEOSPreparedGeom_destroy_r( QgsGeos::getGEOSHandler(), geom );
 }
 
 void geos::GeosDeleter::operator()( GEOSBufferParams *params )
 {
-  GEOSBufferParams_destroy_r( geosinit.ctxt, params );
+  GEOSBufferParams_destroy_r( QgsGeos::getGEOSHandler(), params );
 }
 
 void geos::GeosDeleter::operator()( GEOSCoordSequence *sequence )
 {
-  GEOSCoordSeq_destroy_r( geosinit.ctxt, sequence );
+  GEOSCoordSeq_destroy_r( QgsGeos::getGEOSHandler(), sequence );
 }
 
 
@@ -200,7 +208,7 @@ void QgsGeos::prepareGeometry()
   mGeosPrepared.reset();
   if ( mGeos )
   {
-    mGeosPrepared.reset( GEOSPrepare_r( geosinit.ctxt, mGeos.get() ) );
+    mGeosPrepared.reset( GEOSPrepare_r( QgsGeos::getGEOSHandler(), mGeos.get() ) );
   }
 }
 
@@ -233,7 +241,7 @@ std::unique_ptr<QgsAbstractGeometry> QgsGeos::clip( const QgsRectangle &rect, QS
 
   try
   {
-    geos::unique_ptr opGeom( GEOSClipByRect_r( geosinit.ctxt, mGeos.get(), rect.xMinimum(), rect.yMinimum(), rect.xMaximum(), rect.yMaximum() ) );
+    geos::unique_ptr opGeom( GEOSClipByRect_r( QgsGeos::getGEOSHandler(), mGeos.get(), rect.xMinimum(), rect.yMinimum(), rect.xMaximum(), rect.yMaximum() ) );
     return fromGeos( opGeom.get() );
   }
   catch ( GEOSException &e )
@@ -251,7 +259,7 @@ std::unique_ptr<QgsAbstractGeometry> QgsGeos::clip( const QgsRectangle &rect, QS
 
 void QgsGeos::subdivideRecursive( const GEOSGeometry *currentPart, int maxNodes, int depth, QgsGeometryCollection *parts, const QgsRectangle &clipRect ) const
 {
-  int partType = GEOSGeomTypeId_r( geosinit.ctxt, currentPart );
+  int partType = GEOSGeomTypeId_r( QgsGeos::getGEOSHandler(), currentPart );
   if ( qgsDoubleNear( clipRect.width(), 0.0 ) && qgsDoubleNear( clipRect.height(), 0.0 ) )
   {
     if ( partType == GEOS_POINT )
@@ -267,10 +275,10 @@ void QgsGeos::subdivideRecursive( const GEOSGeometry *currentPart, int maxNodes,
 
   if ( partType == GEOS_MULTILINESTRING || partType == GEOS_MULTIPOLYGON || partType == GEOS_GEOMETRYCOLLECTION )
   {
-    int partCount = GEOSGetNumGeometries_r( geosinit.ctxt, currentPart );
+    int partCount = GEOSGetNumGeometries_r( QgsGeos::getGEOSHandler(), currentPart );
     for ( int i = 0; i < partCount; ++i )
     {
-      subdivideRecursive( GEOSGetGeometryN_r( geosinit.ctxt, currentPart, i ), maxNodes, depth, parts, clipRect );
+      subdivideRecursive( GEOSGetGeometryN_r( QgsGeos::getGEOSHandler(), currentPart, i ), maxNodes, depth, parts, clipRect );
     }
     return;
   }
@@ -281,7 +289,7 @@ void QgsGeos::subdivideRecursive( const GEOSGeometry *currentPart, int maxNodes,
     return;
   }
 
-  int vertexCount = GEOSGetNumCoordinates_r( geosinit.ctxt, currentPart );
+  int vertexCount = GEOSGetNumCoordinates_r( QgsGeos::getGEOSHandler(), currentPart );
   if ( vertexCount == 0 )
   {
     return;
@@ -323,8 +331,8 @@ void QgsGeos::subdivideRecursive( const GEOSGeometry *currentPart, int maxNodes,
     halfClipRect2.setXMaximum( halfClipRect2.xMaximum() + std::numeric_limits<double>::epsilon() );
   }
 
-  geos::unique_ptr clipPart1( GEOSClipByRect_r( geosinit.ctxt, currentPart, halfClipRect1.xMinimum(), halfClipRect1.yMinimum(), halfClipRect1.xMaximum(), halfClipRect1.yMaximum() ) );
-  geos::unique_ptr clipPart2( GEOSClipByRect_r( geosinit.ctxt, currentPart, halfClipRect2.xMinimum(), halfClipRect2.yMinimum(), halfClipRect2.xMaximum(), halfClipRect2.yMaximum() ) );
+  geos::unique_ptr clipPart1( GEOSClipByRect_r( QgsGeos::getGEOSHandler(), currentPart, halfClipRect1.xMinimum(), halfClipRect1.yMinimum(), halfClipRect1.xMaximum(), halfClipRect1.yMaximum() ) );
+  geos::unique_ptr clipPart2( GEOSClipByRect_r( QgsGeos::getGEOSHandler(), currentPart, halfClipRect2.xMinimum(), halfClipRect2.yMinimum(), halfClipRect2.xMaximum(), halfClipRect2.yMaximum() ) );
 
   ++depth;
 
@@ -379,7 +387,7 @@ QgsAbstractGeometry *QgsGeos::combine( const QVector<QgsAbstractGeometry *> &geo
   try
   {
     geos::unique_ptr geomCollection = createGeosCollection( GEOS_GEOMETRYCOLLECTION, geosGeometries );
-    geomUnion.reset( GEOSUnaryUnion_r( geosinit.ctxt, geomCollection.get() ) );
+    geomUnion.reset( GEOSUnaryUnion_r( QgsGeos::getGEOSHandler(), geomCollection.get() ) );
   }
   CATCH_GEOS_WITH_ERRMSG( nullptr )
 
@@ -403,7 +411,7 @@ QgsAbstractGeometry *QgsGeos::combine( const QVector<QgsGeometry> &geomList, QSt
   try
   {
     geos::unique_ptr geomCollection = createGeosCollection( GEOS_GEOMETRYCOLLECTION, geosGeometries );
-    geomUnion.reset( GEOSUnaryUnion_r( geosinit.ctxt, geomCollection.get() ) );
+    geomUnion.reset( GEOSUnaryUnion_r( QgsGeos::getGEOSHandler(), geomCollection.get() ) );
   }
   CATCH_GEOS_WITH_ERRMSG( nullptr )
 
@@ -432,7 +440,7 @@ double QgsGeos::distance( const QgsAbstractGeometry *geom, QString *errorMsg ) c
 
   try
   {
-    GEOSDistance_r( geosinit.ctxt, mGeos.get(), otherGeosGeom.get(), &distance );
+    GEOSDistance_r( QgsGeos::getGEOSHandler(), mGeos.get(), otherGeosGeom.get(), &distance );
   }
   CATCH_GEOS_WITH_ERRMSG( -1.0 )
 
@@ -455,7 +463,7 @@ double QgsGeos::hausdorffDistance( const QgsAbstractGeometry *geom, QString *err
 
   try
   {
-    GEOSHausdorffDistance_r( geosinit.ctxt, mGeos.get(), otherGeosGeom.get(), &distance );
+    GEOSHausdorffDistance_r( QgsGeos::getGEOSHandler(), mGeos.get(), otherGeosGeom.get(), &distance );
   }
   CATCH_GEOS_WITH_ERRMSG( -1.0 )
 
@@ -478,7 +486,7 @@ double QgsGeos::hausdorffDistanceDensify( const QgsAbstractGeometry *geom, doubl
 
   try
   {
-    GEOSHausdorffDistanceDensify_r( geosinit.ctxt, mGeos.get(), otherGeosGeom.get(), densifyFraction, &distance );
+    GEOSHausdorffDistanceDensify_r( QgsGeos::getGEOSHandler(), mGeos.get(), otherGeosGeom.get(), densifyFraction, &distance );
   }
   CATCH_GEOS_WITH_ERRMSG( -1.0 )
 
@@ -536,11 +544,11 @@ QString QgsGeos::relate( const QgsAbstractGeometry *geom, QString *errorMsg ) co
   QString result;
   try
   {
-    char *r = GEOSRelate_r( geosinit.ctxt, mGeos.get(), geosGeom.get() );
+    char *r = GEOSRelate_r( QgsGeos::getGEOSHandler(), mGeos.get(), geosGeom.get() );
     if ( r )
     {
       result = QString( r );
-      GEOSFree_r( geosinit.ctxt, r );
+      GEOSFree_r( QgsGeos::getGEOSHandler(), r );
     }
   }
   catch ( GEOSException &e )
@@ -570,7 +578,7 @@ bool QgsGeos::relatePattern( const QgsAbstractGeometry *geom, const QString &pat
   bool result = false;
   try
   {
-    result = ( GEOSRelatePattern_r( geosinit.ctxt, mGeos.get(), geosGeom.get(), pattern.toLocal8Bit().constData() ) == 1 );
+    result = ( GEOSRelatePattern_r( QgsGeos::getGEOSHandler(), mGeos.get(), geosGeom.get(), pattern.toLocal8Bit().constData() ) == 1 );
   }
   catch ( GEOSException &e )
   {
@@ -593,7 +601,7 @@ double QgsGeos::area( QString *errorMsg ) const
 
   try
   {
-    if ( GEOSArea_r( geosinit.ctxt, mGeos.get(), &area ) != 1 )
+    if ( GEOSArea_r( QgsGeos::getGEOSHandler(), mGeos.get(), &area ) != 1 )
       return -1.0;
   }
   CATCH_GEOS_WITH_ERRMSG( -1.0 );
@@ -609,7 +617,7 @@ double QgsGeos::length( QString *errorMsg ) const
   }
   try
   {
-    if ( GEOSLength_r( geosinit.ctxt, mGeos.get(), &length ) != 1 )
+    if ( GEOSLength_r( QgsGeos::getGEOSHandler(), mGeos.get(), &length ) != 1 )
       return -1.0;
   }
   CATCH_GEOS_WITH_ERRMSG( -1.0 )
@@ -635,7 +643,7 @@ QgsGeometryEngine::EngineOperationResult QgsGeos::splitGeometry( const QgsLineSt
     return SplitCannotSplitPoint; //cannot split points
   }
 
-  if ( !GEOSisValid_r( geosinit.ctxt, mGeos.get() ) )
+  if ( !GEOSisValid_r( QgsGeos::getGEOSHandler(), mGeos.get() ) )
     return InvalidBaseGeometry;
 
   //make sure splitLine is valid
@@ -661,7 +669,7 @@ QgsGeometryEngine::EngineOperationResult QgsGeos::splitGeometry( const QgsLineSt
       return InvalidInput;
     }
 
-    if ( !GEOSisValid_r( geosinit.ctxt, splitLineGeos.get() ) || !GEOSisSimple_r( geosinit.ctxt, splitLineGeos.get() ) )
+    if ( !GEOSisValid_r( QgsGeos::getGEOSHandler(), splitLineGeos.get() ) || !GEOSisSimple_r( QgsGeos::getGEOSHandler(), splitLineGeos.get() ) )
     {
       return InvalidInput;
     }
@@ -710,18 +718,18 @@ bool QgsGeos::topologicalTestPointsSplit( const GEOSGeometry *splitLine, QgsPoin
   try
   {
     testPoints.clear();
-    geos::unique_ptr intersectionGeom( GEOSIntersection_r( geosinit.ctxt, mGeos.get(), splitLine ) );
+    geos::unique_ptr intersectionGeom( GEOSIntersection_r( QgsGeos::getGEOSHandler(), mGeos.get(), splitLine ) );
     if ( !intersectionGeom )
       return false;
 
     bool simple = false;
     int nIntersectGeoms = 1;
-    if ( GEOSGeomTypeId_r( geosinit.ctxt, intersectionGeom.get() ) == GEOS_LINESTRING
-         || GEOSGeomTypeId_r( geosinit.ctxt, intersectionGeom.get() ) == GEOS_POINT )
+    if ( GEOSGeomTypeId_r( QgsGeos::getGEOSHandler(), intersectionGeom.get() ) == GEOS_LINESTRING
+         || GEOSGeomTypeId_r( QgsGeos::getGEOSHandler(), intersectionGeom.get() ) == GEOS_POINT )
       simple = true;
 
     if ( !simple )
-      nIntersectGeoms = GEOSGetNumGeometries_r( geosinit.ctxt, intersectionGeom.get() );
+      nIntersectGeoms = GEOSGetNumGeometries_r( QgsGeos::getGEOSHandler(), intersectionGeom.get() );
 
     for ( int i = 0; i < nIntersectGeoms; ++i )
     {
@@ -729,18 +737,18 @@ bool QgsGeos::topologicalTestPointsSplit( const GEOSGeometry *splitLine, QgsPoin
       if ( simple )
         currentIntersectGeom = intersectionGeom.get();
       else
-        currentIntersectGeom = GEOSGetGeometryN_r( geosinit.ctxt, intersectionGeom.get(), i );
+        currentIntersectGeom = GEOSGetGeometryN_r( QgsGeos::getGEOSHandler(), intersectionGeom.get(), i );
 
-      const GEOSCoordSequence *lineSequence = GEOSGeom_getCoordSeq_r( geosinit.ctxt, currentIntersectGeom );
+      const GEOSCoordSequence *lineSequence = GEOSGeom_getCoordSeq_r( QgsGeos::getGEOSHandler(), currentIntersectGeom );
       unsigned int sequenceSize = 0;
       double x, y;
-      if ( GEOSCoordSeq_getSize_r( geosinit.ctxt, lineSequence, &sequenceSize ) != 0 )
+      if ( GEOSCoordSeq_getSize_r( QgsGeos::getGEOSHandler(), lineSequence, &sequenceSize ) != 0 )
       {
         for ( unsigned int i = 0; i < sequenceSize; ++i )
         {
-          if ( GEOSCoordSeq_getX_r( geosinit.ctxt, lineSequence, i, &x ) != 0 )
+          if ( GEOSCoordSeq_getX_r( QgsGeos::getGEOSHandler(), lineSequence, i, &x ) != 0 )
           {
-            if ( GEOSCoordSeq_getY_r( geosinit.ctxt, lineSequence, i, &y ) != 0 )
+            if ( GEOSCoordSeq_getY_r( QgsGeos::getGEOSHandler(), lineSequence, i, &y ) != 0 )
             {
               testPoints.push_back( QgsPoint( x, y ) );
             }
@@ -756,7 +764,7 @@ bool QgsGeos::topologicalTestPointsSplit( const GEOSGeometry *splitLine, QgsPoin
 
 geos::unique_ptr QgsGeos::linePointDifference( GEOSGeometry *GEOSsplitPoint ) const
 {
-  int type = GEOSGeomTypeId_r( geosinit.ctxt, mGeos.get() );
+  int type = GEOSGeomTypeId_r( QgsGeos::getGEOSHandler(), mGeos.get() );
 
   std::unique_ptr< QgsMultiCurve > multiCurve;
   if ( type == GEOS_MULTILINESTRING )
@@ -826,15 +834,15 @@ QgsGeometryEngine::EngineOperationResult QgsGeos::splitLinearGeometry( GEOSGeome
     return InvalidBaseGeometry;
 
   //first test if linestring intersects geometry. If not, return straight away
-  if ( !GEOSIntersects_r( geosinit.ctxt, splitLine, mGeos.get() ) )
+  if ( !GEOSIntersects_r( QgsGeos::getGEOSHandler(), splitLine, mGeos.get() ) )
     return NothingHappened;
 
   //check that split line has no linear intersection
-  int linearIntersect = GEOSRelatePattern_r( geosinit.ctxt, mGeos.get(), splitLine, "1********" );
+  int linearIntersect = GEOSRelatePattern_r( QgsGeos::getGEOSHandler(), mGeos.get(), splitLine, "1********" );
   if ( linearIntersect > 0 )
     return InvalidInput;
 
-  int splitGeomType = GEOSGeomTypeId_r( geosinit.ctxt, splitLine );
+  int splitGeomType = GEOSGeomTypeId_r( QgsGeos::getGEOSHandler(), splitLine );
 
   geos::unique_ptr splitGeom;
   if ( splitGeomType == GEOS_POINT )
@@ -843,22 +851,22 @@ QgsGeometryEngine::EngineOperationResult QgsGeos::splitLinearGeometry( GEOSGeome
   }
   else
   {
-    splitGeom.reset( GEOSDifference_r( geosinit.ctxt, mGeos.get(), splitLine ) );
+    splitGeom.reset( GEOSDifference_r( QgsGeos::getGEOSHandler(), mGeos.get(), splitLine ) );
   }
   QVector<GEOSGeometry *> lineGeoms;
 
-  int splitType = GEOSGeomTypeId_r( geosinit.ctxt, splitGeom.get() );
+  int splitType = GEOSGeomTypeId_r( QgsGeos::getGEOSHandler(), splitGeom.get() );
   if ( splitType == GEOS_MULTILINESTRING )
   {
-    int nGeoms = GEOSGetNumGeometries_r( geosinit.ctxt, splitGeom.get() );
+    int nGeoms = GEOSGetNumGeometries_r( QgsGeos::getGEOSHandler(), splitGeom.get() );
     lineGeoms.reserve( nGeoms );
     for ( int i = 0; i < nGeoms; ++i )
-      lineGeoms << GEOSGeom_clone_r( geosinit.ctxt, GEOSGetGeometryN_r( geosinit.ctxt, splitGeom.get(), i ) );
+      lineGeoms << GEOSGeom_clone_r( QgsGeos::getGEOSHandler(), GEOSGetGeometryN_r( QgsGeos::getGEOSHandler(), splitGeom.get(), i ) );
 
   }
   else
   {
-    lineGeoms << GEOSGeom_clone_r( geosinit.ctxt, splitGeom.get() );
+    lineGeoms << GEOSGeom_clone_r( QgsGeos::getGEOSHandler(), splitGeom.get() );
   }
 
   mergeGeometriesMultiTypeSplit( lineGeoms );
@@ -866,7 +874,7 @@ QgsGeometryEngine::EngineOperationResult QgsGeos::splitLinearGeometry( GEOSGeome
   for ( int i = 0; i < lineGeoms.size(); ++i )
   {
     newGeometries << QgsGeometry( fromGeos( lineGeoms[i] ) );
-    GEOSGeom_destroy_r( geosinit.ctxt, lineGeoms[i] );
+    GEOSGeom_destroy_r( QgsGeos::getGEOSHandler(), lineGeoms[i] );
   }
 
   return Success;
@@ -881,7 +889,7 @@ QgsGeometryEngine::EngineOperationResult QgsGeos::splitPolygonGeometry( GEOSGeom
     return InvalidBaseGeometry;
 
   //first test if linestring intersects geometry. If not, return straight away
-  if ( !GEOSIntersects_r( geosinit.ctxt, splitLine, mGeos.get() ) )
+  if ( !GEOSIntersects_r( QgsGeos::getGEOSHandler(), splitLine, mGeos.get() ) )
     return NothingHappened;
 
   //first union all the polygon rings together (to get them noded, see JTS developer guide)
@@ -890,7 +898,7 @@ QgsGeometryEngine::EngineOperationResult QgsGeos::splitPolygonGeometry( GEOSGeom
     return NodedGeometryError; //an error occurred during noding
 
   const GEOSGeometry *noded = nodedGeometry.get();
-  geos::unique_ptr polygons( GEOSPolygonize_r( geosinit.ctxt, &noded, 1 ) );
+  geos::unique_ptr polygons( GEOSPolygonize_r( QgsGeos::getGEOSHandler(), &noded, 1 ) );
   if ( !polygons || numberOfGeometries( polygons.get() ) == 0 )
   {
     return InvalidBaseGeometry;
@@ -906,8 +914,8 @@ QgsGeometryEngine::EngineOperationResult QgsGeos::splitPolygonGeometry( GEOSGeom
 
   for ( int i = 0; i < numberOfGeometries( polygons.get() ); i++ )
   {
-    const GEOSGeometry *polygon = GEOSGetGeometryN_r( geosinit.ctxt, polygons.get(), i );
-    intersectGeometry.reset( GEOSIntersection_r( geosinit.ctxt, mGeos.get(), polygon ) );
+    const GEOSGeometry *polygon = GEOSGetGeometryN_r( QgsGeos::getGEOSHandler(), polygons.get(), i );
+    intersectGeometry.reset( GEOSIntersection_r( QgsGeos::getGEOSHandler(), mGeos.get(), polygon ) );
     if ( !intersectGeometry )
     {
       QgsDebugMsg( QStringLiteral( "intersectGeometry is nullptr" ) );
@@ -915,14 +923,14 @@ QgsGeometryEngine::EngineOperationResult QgsGeos::splitPolygonGeometry( GEOSGeom
     }
 
     double intersectionArea;
-    GEOSArea_r( geosinit.ctxt, intersectGeometry.get(), &intersectionArea );
+    GEOSArea_r( QgsGeos::getGEOSHandler(), intersectGeometry.get(), &intersectionArea );
 
     double polygonArea;
-    GEOSArea_r( geosinit.ctxt, polygon, &polygonArea );
+    GEOSArea_r( QgsGeos::getGEOSHandler(), polygon, &polygonArea );
 
     const double areaRatio = intersectionArea / polygonArea;
     if ( areaRatio > 0.99 && areaRatio < 1.01 )
-      testedGeometries << GEOSGeom_clone_r( geosinit.ctxt, polygon );
+      testedGeometries << GEOSGeom_clone_r( QgsGeos::getGEOSHandler(), polygon );
   }
 
   int nGeometriesThis = numberOfGeometries( mGeos.get() ); //original number of geometries
@@ -931,7 +939,7 @@ QgsGeometryEngine::EngineOperationResult QgsGeos::splitPolygonGeometry( GEOSGeom
     //no split done, preserve original geometry
     for ( int i = 0; i < testedGeometries.size(); ++i )
     {
-      GEOSGeom_destroy_r( geosinit.ctxt, testedGeometries[i] );
+      GEOSGeom_destroy_r( QgsGeos::getGEOSHandler(), testedGeometries[i] );
     }
     return NothingHappened;
   }
@@ -939,13 +947,13 @@ QgsGeometryEngine::EngineOperationResult QgsGeos::splitPolygonGeometry( GEOSGeom
   mergeGeometriesMultiTypeSplit( testedGeometries );
 
   int i;
-  for ( i = 0; i < testedGeometries.size() && GEOSisValid_r( geosinit.ctxt, testedGeometries[i] ); ++i )
+  for ( i = 0; i < testedGeometries.size() && GEOSisValid_r( QgsGeos::getGEOSHandler(), testedGeometries[i] ); ++i )
     ;
 
   if ( i < testedGeometries.size() )
   {
     for ( i = 0; i < testedGeometries.size(); ++i )
-      GEOSGeom_destroy_r( geosinit.ctxt, testedGeometries[i] );
+      GEOSGeom_destroy_r( QgsGeos::getGEOSHandler(), testedGeometries[i] );
 
     return InvalidBaseGeometry;
   }
@@ -953,7 +961,7 @@ QgsGeometryEngine::EngineOperationResult QgsGeos::splitPolygonGeometry( GEOSGeom
   for ( i = 0; i < testedGeometries.size(); ++i )
   {
     newGeometries << QgsGeometry( fromGeos( testedGeometries[i] ) );
-    GEOSGeom_destroy_r( geosinit.ctxt, testedGeometries[i] );
+    GEOSGeom_destroy_r( QgsGeos::getGEOSHandler(), testedGeometries[i] );
   }
 
   return Success;
@@ -965,13 +973,13 @@ geos::unique_ptr QgsGeos::nodeGeometries( const GEOSGeometry *splitLine, const G
     return nullptr;
 
   geos::unique_ptr geometryBoundary;
-  if ( GEOSGeomTypeId_r( geosinit.ctxt, geom ) == GEOS_POLYGON || GEOSGeomTypeId_r( geosinit.ctxt, geom ) == GEOS_MULTIPOLYGON )
-    geometryBoundary.reset( GEOSBoundary_r( geosinit.ctxt, geom ) );
+  if ( GEOSGeomTypeId_r( QgsGeos::getGEOSHandler(), geom ) == GEOS_POLYGON || GEOSGeomTypeId_r( QgsGeos::getGEOSHandler(), geom ) == GEOS_MULTIPOLYGON )
+    geometryBoundary.reset( GEOSBoundary_r( QgsGeos::getGEOSHandler(), geom ) );
   else
-    geometryBoundary.reset( GEOSGeom_clone_r( geosinit.ctxt, geom ) );
+    geometryBoundary.reset( GEOSGeom_clone_r( QgsGeos::getGEOSHandler(), geom ) );
 
-  geos::unique_ptr splitLineClone( GEOSGeom_clone_r( geosinit.ctxt, splitLine ) );
-  geos::unique_ptr unionGeometry( GEOSUnion_r( geosinit.ctxt, splitLineClone.get(), geometryBoundary.get() ) );
+  geos::unique_ptr splitLineClone( GEOSGeom_clone_r( QgsGeos::getGEOSHandler(), splitLine ) );
+  geos::unique_ptr unionGeometry( GEOSUnion_r( QgsGeos::getGEOSHandler(), splitLineClone.get(), geometryBoundary.get() ) );
 
   return unionGeometry;
 }
@@ -982,7 +990,7 @@ int QgsGeos::mergeGeometriesMultiTypeSplit( QVector<GEOSGeometry *> &splitResult
     return 1;
 
   //convert mGeos to geometry collection
-  int type = GEOSGeomTypeId_r( geosinit.ctxt, mGeos.get() );
+  int type = GEOSGeomTypeId_r( QgsGeos::getGEOSHandler(), mGeos.get() );
   if ( type != GEOS_GEOMETRYCOLLECTION &&
        type != GEOS_MULTILINESTRING &&
        type != GEOS_MULTIPOLYGON &&
@@ -999,9 +1007,9 @@ int QgsGeos::mergeGeometriesMultiTypeSplit( QVector<GEOSGeometry *> &splitResult
   {
     //is this geometry a part of the original multitype?
     bool isPart = false;
-    for ( int j = 0; j < GEOSGetNumGeometries_r( geosinit.ctxt, mGeos.get() ); j++ )
+    for ( int j = 0; j < GEOSGetNumGeometries_r( QgsGeos::getGEOSHandler(), mGeos.get() ); j++ )
     {
-      if ( GEOSEquals_r( geosinit.ctxt, copyList[i], GEOSGetGeometryN_r( geosinit.ctxt, mGeos.get(), j ) ) )
+      if ( GEOSEquals_r( QgsGeos::getGEOSHandler(), copyList[i], GEOSGetGeometryN_r( QgsGeos::getGEOSHandler(), mGeos.get(), j ) ) )
       {
         isPart = true;
         break;
@@ -1022,7 +1030,7 @@ int QgsGeos::mergeGeometriesMultiTypeSplit( QVector<GEOSGeometry *> &splitResult
       else if ( type == GEOS_MULTIPOLYGON )
         splitResult << createGeosCollection( GEOS_MULTIPOLYGON, geomVector ).release();
       else
-        GEOSGeom_destroy_r( geosinit.ctxt, copyList[i] );
+        GEOSGeom_destroy_r( QgsGeos::getGEOSHandler(), copyList[i] );
     }
   }
 
@@ -1067,7 +1075,7 @@ geos::unique_ptr QgsGeos::createGeosCollection( int typeId, const QVector<GEOSGe
 
   try
   {
-    geom.reset( GEOSGeom_createCollection_r( geosinit.ctxt, typeId, geomarr, nNotNullGeoms ) );
+    geom.reset( GEOSGeom_createCollection_r( QgsGeos::getGEOSHandler(), typeId, geomarr, nNotNullGeoms ) );
   }
   catch ( GEOSException & )
   {
@@ -1085,16 +1093,16 @@ std::unique_ptr<QgsAbstractGeometry> QgsGeos::fromGeos( const GEOSGeometry *geos
     return nullptr;
   }
 
-  int nCoordDims = GEOSGeom_getCoordinateDimension_r( geosinit.ctxt, geos );
-  int nDims = GEOSGeom_getDimensions_r( geosinit.ctxt, geos );
+  int nCoordDims = GEOSGeom_getCoordinateDimension_r( QgsGeos::getGEOSHandler(), geos );
+  int nDims = GEOSGeom_getDimensions_r( QgsGeos::getGEOSHandler(), geos );
   bool hasZ = ( nCoordDims == 3 );
   bool hasM = ( ( nDims - nCoordDims ) == 1 );
 
-  switch ( GEOSGeomTypeId_r( geosinit.ctxt, geos ) )
+  switch ( GEOSGeomTypeId_r( QgsGeos::getGEOSHandler(), geos ) )
   {
     case GEOS_POINT:                 // a point
     {
-      const GEOSCoordSequence *cs = GEOSGeom_getCoordSeq_r( geosinit.ctxt, geos );
+      const GEOSCoordSequence *cs = GEOSGeom_getCoordSeq_r( QgsGeos::getGEOSHandler(), geos );
       return std::unique_ptr<QgsAbstractGeometry>( coordSeqPoint( cs, 0, hasZ, hasM ).clone() );
     }
     case GEOS_LINESTRING:
@@ -1108,11 +1116,11 @@ std::unique_ptr<QgsAbstractGeometry> QgsGeos::fromGeos( const GEOSGeometry *geos
     case GEOS_MULTIPOINT:
     {
       std::unique_ptr< QgsMultiPoint > multiPoint( new QgsMultiPoint() );
-      int nParts = GEOSGetNumGeometries_r( geosinit.ctxt, geos );
+      int nParts = GEOSGetNumGeometries_r( QgsGeos::getGEOSHandler(), geos );
       multiPoint->reserve( nParts );
       for ( int i = 0; i < nParts; ++i )
       {
-        const GEOSCoordSequence *cs = GEOSGeom_getCoordSeq_r( geosinit.ctxt, GEOSGetGeometryN_r( geosinit.ctxt, geos, i ) );
+        const GEOSCoordSequence *cs = GEOSGeom_getCoordSeq_r( QgsGeos::getGEOSHandler(), GEOSGetGeometryN_r( QgsGeos::getGEOSHandler(), geos, i ) );
         if ( cs )
         {
           multiPoint->addGeometry( coordSeqPoint( cs, 0, hasZ, hasM ).clone() );
@@ -1123,11 +1131,11 @@ std::unique_ptr<QgsAbstractGeometry> QgsGeos::fromGeos( const GEOSGeometry *geos
     case GEOS_MULTILINESTRING:
     {
       std::unique_ptr< QgsMultiLineString > multiLineString( new QgsMultiLineString() );
-      int nParts = GEOSGetNumGeometries_r( geosinit.ctxt, geos );
+      int nParts = GEOSGetNumGeometries_r( QgsGeos::getGEOSHandler(), geos );
       multiLineString->reserve( nParts );
       for ( int i = 0; i < nParts; ++i )
       {
-        std::unique_ptr< QgsLineString >line( sequenceToLinestring( GEOSGetGeometryN_r( geosinit.ctxt, geos, i ), hasZ, hasM ) );
+        std::unique_ptr< QgsLineString >line( sequenceToLinestring( GEOSGetGeometryN_r( QgsGeos::getGEOSHandler(), geos, i ), hasZ, hasM ) );
         if ( line )
         {
           multiLineString->addGeometry( line.release() );
@@ -1139,11 +1147,11 @@ std::unique_ptr<QgsAbstractGeometry> QgsGeos::fromGeos( const GEOSGeometry *geos
     {
       std::unique_ptr< QgsMultiPolygon > multiPolygon( new QgsMultiPolygon() );
 
-      int nParts = GEOSGetNumGeometries_r( geosinit.ctxt, geos );
+      int nParts = GEOSGetNumGeometries_r( QgsGeos::getGEOSHandler(), geos );
       multiPolygon->reserve( nParts );
       for ( int i = 0; i < nParts; ++i )
       {
-        std::unique_ptr< QgsPolygon > poly = fromGeosPolygon( GEOSGetGeometryN_r( geosinit.ctxt, geos, i ) );
+        std::unique_ptr< QgsPolygon > poly = fromGeosPolygon( GEOSGetGeometryN_r( QgsGeos::getGEOSHandler(), geos, i ) );
         if ( poly )
         {
           multiPolygon->addGeometry( poly.release() );
@@ -1154,11 +1162,11 @@ std::unique_ptr<QgsAbstractGeometry> QgsGeos::fromGeos( const GEOSGeometry *geos
     case GEOS_GEOMETRYCOLLECTION:
     {
       std::unique_ptr< QgsGeometryCollection > geomCollection( new QgsGeometryCollection() );
-      int nParts = GEOSGetNumGeometries_r( geosinit.ctxt, geos );
+      int nParts = GEOSGetNumGeometries_r( QgsGeos::getGEOSHandler(), geos );
       geomCollection->reserve( nParts );
       for ( int i = 0; i < nParts; ++i )
       {
-        std::unique_ptr< QgsAbstractGeometry > geom( fromGeos( GEOSGetGeometryN_r( geosinit.ctxt, geos, i ) ) );
+        std::unique_ptr< QgsAbstractGeometry > geom( fromGeos( GEOSGetGeometryN_r( QgsGeos::getGEOSHandler(), geos, i ) ) );
         if ( geom )
         {
           geomCollection->addGeometry( geom.release() );
@@ -1172,30 +1180,30 @@ std::unique_ptr<QgsAbstractGeometry> QgsGeos::fromGeos( const GEOSGeometry *geos
 
 std::unique_ptr<QgsPolygon> QgsGeos::fromGeosPolygon( const GEOSGeometry *geos )
 {
-  if ( GEOSGeomTypeId_r( geosinit.ctxt, geos ) != GEOS_POLYGON )
+  if ( GEOSGeomTypeId_r( QgsGeos::getGEOSHandler(), geos ) != GEOS_POLYGON )
   {
     return nullptr;
   }
 
-  int nCoordDims = GEOSGeom_getCoordinateDimension_r( geosinit.ctxt, geos );
-  int nDims = GEOSGeom_getDimensions_r( geosinit.ctxt, geos );
+  int nCoordDims = GEOSGeom_getCoordinateDimension_r( QgsGeos::getGEOSHandler(), geos );
+  int nDims = GEOSGeom_getDimensions_r( QgsGeos::getGEOSHandler(), geos );
   bool hasZ = ( nCoordDims == 3 );
   bool hasM = ( ( nDims - nCoordDims ) == 1 );
 
   std::unique_ptr< QgsPolygon > polygon( new QgsPolygon() );
 
-  const GEOSGeometry *ring = GEOSGetExteriorRing_r( geosinit.ctxt, geos );
+  const GEOSGeometry *ring = GEOSGetExteriorRing_r( QgsGeos::getGEOSHandler(), geos );
   if ( ring )
   {
     polygon->setExteriorRing( sequenceToLinestring( ring, hasZ, hasM ).release() );
   }
 
   QVector<QgsCurve *> interiorRings;
-  const int ringCount = GEOSGetNumInteriorRings_r( geosinit.ctxt, geos );
+  const int ringCount = GEOSGetNumInteriorRings_r( QgsGeos::getGEOSHandler(), geos );
   interiorRings.reserve( ringCount );
   for ( int i = 0; i < ringCount; ++i )
   {
-    ring = GEOSGetInteriorRingN_r( geosinit.ctxt, geos, i );
+    ring = GEOSGetInteriorRingN_r( QgsGeos::getGEOSHandler(), geos, i );
     if ( ring )
     {
       interiorRings.push_back( sequenceToLinestring( ring, hasZ, hasM ).release() );
@@ -1208,9 +1216,9 @@ std::unique_ptr<QgsPolygon> QgsGeos::fromGeosPolygon( const GEOSGeometry *geos )
 
 std::unique_ptr<QgsLineString> QgsGeos::sequenceToLinestring( const GEOSGeometry *geos, bool hasZ, bool hasM )
 {
-  const GEOSCoordSequence *cs = GEOSGeom_getCoordSeq_r( geosinit.ctxt, geos );
+  const GEOSCoordSequence *cs = GEOSGeom_getCoordSeq_r( QgsGeos::getGEOSHandler(), geos );
   unsigned int nPoints;
-  GEOSCoordSeq_getSize_r( geosinit.ctxt, cs, &nPoints );
+  GEOSCoordSeq_getSize_r( QgsGeos::getGEOSHandler(), cs, &nPoints );
   QVector< double > xOut( nPoints );
   QVector< double > yOut( nPoints );
   QVector< double > zOut;
@@ -1225,15 +1233,15 @@ std::unique_ptr<QgsLineString> QgsGeos::sequenceToLinestring( const GEOSGeometry
   double *m = mOut.data();
   for ( unsigned int i = 0; i < nPoints; ++i )
   {
-    GEOSCoordSeq_getX_r( geosinit.ctxt, cs, i, x++ );
-    GEOSCoordSeq_getY_r( geosinit.ctxt, cs, i, y++ );
+    GEOSCoordSeq_getX_r( QgsGeos::getGEOSHandler(), cs, i, x++ );
+    GEOSCoordSeq_getY_r( QgsGeos::getGEOSHandler(), cs, i, y++ );
     if ( hasZ )
     {
-      GEOSCoordSeq_getZ_r( geosinit.ctxt, cs, i, z++ );
+      GEOSCoordSeq_getZ_r( QgsGeos::getGEOSHandler(), cs, i, z++ );
     }
     if ( hasM )
     {
-      GEOSCoordSeq_getOrdinate_r( geosinit.ctxt, cs, i, 3, m++ );
+      GEOSCoordSeq_getOrdinate_r( QgsGeos::getGEOSHandler(), cs, i, 3, m++ );
     }
   }
   std::unique_ptr< QgsLineString > line( new QgsLineString( xOut, yOut, zOut, mOut ) );
@@ -1245,13 +1253,13 @@ int QgsGeos::numberOfGeometries( GEOSGeometry *g )
   if ( !g )
     return 0;
 
-  int geometryType = GEOSGeomTypeId_r( geosinit.ctxt, g );
+  int geometryType = GEOSGeomTypeId_r( QgsGeos::getGEOSHandler(), g );
   if ( geometryType == GEOS_POINT || geometryType == GEOS_LINESTRING || geometryType == GEOS_LINEARRING
        || geometryType == GEOS_POLYGON )
     return 1;
 
   //calling GEOSGetNumGeometries is save for multi types and collections also in geos2
-  return GEOSGetNumGeometries_r( geosinit.ctxt, g );
+  return GEOSGetNumGeometries_r( QgsGeos::getGEOSHandler(), g );
 }
 
 QgsPoint QgsGeos::coordSeqPoint( const GEOSCoordSequence *cs, int i, bool hasZ, bool hasM )
@@ -1264,15 +1272,15 @@ QgsPoint QgsGeos::coordSeqPoint( const GEOSCoordSequence *cs, int i, bool hasZ,
   double x, y;
   double z = 0;
   double m = 0;
-  GEOSCoordSeq_getX_r( geosinit.ctxt, cs, i, &x );
-  GEOSCoordSeq_getY_r( geosinit.ctxt, cs, i, &y );
+  GEOSCoordSeq_getX_r( QgsGeos::getGEOSHandler(), cs, i, &x );
+  GEOSCoordSeq_getY_r( QgsGeos::getGEOSHandler(), cs, i, &y );
   if ( hasZ )
   {
-    GEOSCoordSeq_getZ_r( geosinit.ctxt, cs, i, &z );
+    GEOSCoordSeq_getZ_r( QgsGeos::getGEOSHandler(), cs, i, &z );
   }
   if ( hasM )
   {
-    GEOSCoordSeq_getOrdinate_r( geosinit.ctxt, cs, i, 3, &m );
+    GEOSCoordSeq_getOrdinate_r( QgsGeos::getGEOSHandler(), cs, i, 3, &m );
   }
 
   QgsWkbTypes::Type t = QgsWkbTypes::Point;
@@ -1390,18 +1398,18 @@ std::unique_ptr<QgsAbstractGeometry> QgsGeos::overlay( const QgsAbstractGeometry
     switch ( op )
     {
       case OverlayIntersection:
-        opGeom.reset( GEOSIntersection_r( geosinit.ctxt, mGeos.get(), geosGeom.get() ) );
+        opGeom.reset( GEOSIntersection_r( QgsGeos::getGEOSHandler(), mGeos.get(), geosGeom.get() ) );
         break;
       case OverlayDifference:
-        opGeom.reset( GEOSDifference_r( geosinit.ctxt, mGeos.get(), geosGeom.get() ) );
+        opGeom.reset( GEOSDifference_r( QgsGeos::getGEOSHandler(), mGeos.get(), geosGeom.get() ) );
         break;
       case OverlayUnion:
       {
-        geos::unique_ptr unionGeometry( GEOSUnion_r( geosinit.ctxt, mGeos.get(), geosGeom.get() ) );
+        geos::unique_ptr unionGeometry( GEOSUnion_r( QgsGeos::getGEOSHandler(), mGeos.get(), geosGeom.get() ) );
 
-        if ( unionGeometry && GEOSGeomTypeId_r( geosinit.ctxt, unionGeometry.get() ) == GEOS_MULTILINESTRING )
+        if ( unionGeometry && GEOSGeomTypeId_r( QgsGeos::getGEOSHandler(), unionGeometry.get() ) == GEOS_MULTILINESTRING )
         {
-          geos::unique_ptr mergedLines( GEOSLineMerge_r( geosinit.ctxt, unionGeometry.get() ) );
+          geos::unique_ptr mergedLines( GEOSLineMerge_r( QgsGeos::getGEOSHandler(), unionGeometry.get() ) );
           if ( mergedLines )
           {
             unionGeometry = std::move( mergedLines );
@@ -1412,7 +1420,7 @@ std::unique_ptr<QgsAbstractGeometry> QgsGeos::overlay( const QgsAbstractGeometry
       }
       break;
       case OverlaySymDifference:
-        opGeom.reset( GEOSSymDifference_r( geosinit.ctxt, mGeos.get(), geosGeom.get() ) );
+        opGeom.reset( GEOSSymDifference_r( QgsGeos::getGEOSHandler(), mGeos.get(), geosGeom.get() ) );
         break;
       default:    //unknown op
         return nullptr;
@@ -1450,25 +1458,25 @@ bool QgsGeos::relation( const QgsAbstractGeometry *geom, Relation r, QString *er
       switch ( r )
       {
         case RelationIntersects:
-          result = ( GEOSPreparedIntersects_r( geosinit.ctxt, mGeosPrepared.get(), geosGeom.get() ) == 1 );
+          result = ( GEOSPreparedIntersects_r( QgsGeos::getGEOSHandler(), mGeosPrepared.get(), geosGeom.get() ) == 1 );
           break;
         case RelationTouches:
-          result = ( GEOSPreparedTouches_r( geosinit.ctxt, mGeosPrepared.get(), geosGeom.get() ) == 1 );
+          result = ( GEOSPreparedTouches_r( QgsGeos::getGEOSHandler(), mGeosPrepared.get(), geosGeom.get() ) == 1 );
           break;
         case RelationCrosses:
-          result = ( GEOSPreparedCrosses_r( geosinit.ctxt, mGeosPrepared.get(), geosGeom.get() ) == 1 );
+          result = ( GEOSPreparedCrosses_r( QgsGeos::getGEOSHandler(), mGeosPrepared.get(), geosGeom.get() ) == 1 );
           break;
         case RelationWithin:
-          result = ( GEOSPreparedWithin_r( geosinit.ctxt, mGeosPrepared.get(), geosGeom.get() ) == 1 );
+          result = ( GEOSPreparedWithin_r( QgsGeos::getGEOSHandler(), mGeosPrepared.get(), geosGeom.get() ) == 1 );
           break;
         case RelationContains:
-          result = ( GEOSPreparedContains_r( geosinit.ctxt, mGeosPrepared.get(), geosGeom.get() ) == 1 );
+          result = ( GEOSPreparedContains_r( QgsGeos::getGEOSHandler(), mGeosPrepared.get(), geosGeom.get() ) == 1 );
           break;
         case RelationDisjoint:
-          result = ( GEOSPreparedDisjoint_r( geosinit.ctxt, mGeosPrepared.get(), geosGeom.get() ) == 1 );
+          result = ( GEOSPreparedDisjoint_r( QgsGeos::getGEOSHandler(), mGeosPrepared.get(), geosGeom.get() ) == 1 );
           break;
         case RelationOverlaps:
-          result = ( GEOSPreparedOverlaps_r( geosinit.ctxt, mGeosPrepared.get(), geosGeom.get() ) == 1 );
+          result = ( GEOSPreparedOverlaps_r( QgsGeos::getGEOSHandler(), mGeosPrepared.get(), geosGeom.get() ) == 1 );
           break;
         default:
           return false;
@@ -1479,25 +1487,25 @@ bool QgsGeos::relation( const QgsAbstractGeometry *geom, Relation r, QString *er
     switch ( r )
     {
       case RelationIntersects:
-        result = ( GEOSIntersects_r( geosinit.ctxt, mGeos.get(), geosGeom.get() ) == 1 );
+        result = ( GEOSIntersects_r( QgsGeos::getGEOSHandler(), mGeos.get(), geosGeom.get() ) == 1 );
         break;
       case RelationTouches:
-        result = ( GEOSTouches_r( geosinit.ctxt, mGeos.get(), geosGeom.get() ) == 1 );
+        result = ( GEOSTouches_r( QgsGeos::getGEOSHandler(), mGeos.get(), geosGeom.get() ) == 1 );
         break;
       case RelationCrosses:
-        result = ( GEOSCrosses_r( geosinit.ctxt, mGeos.get(), geosGeom.get() ) == 1 );
+        result = ( GEOSCrosses_r( QgsGeos::getGEOSHandler(), mGeos.get(), geosGeom.get() ) == 1 );
         break;
       case RelationWithin:
-        result = ( GEOSWithin_r( geosinit.ctxt, mGeos.get(), geosGeom.get() ) == 1 );
+        result = ( GEOSWithin_r( QgsGeos::getGEOSHandler(), mGeos.get(), geosGeom.get() ) == 1 );
         break;
       case RelationContains:
-        result = ( GEOSContains_r( geosinit.ctxt, mGeos.get(), geosGeom.get() ) == 1 );
+        result = ( GEOSContains_r( QgsGeos::getGEOSHandler(), mGeos.get(), geosGeom.get() ) == 1 );
         break;
       case RelationDisjoint:
-        result = ( GEOSDisjoint_r( geosinit.ctxt, mGeos.get(), geosGeom.get() ) == 1 );
+        result = ( GEOSDisjoint_r( QgsGeos::getGEOSHandler(), mGeos.get(), geosGeom.get() ) == 1 );
         break;
       case RelationOverlaps:
-        result = ( GEOSOverlaps_r( geosinit.ctxt, mGeos.get(), geosGeom.get() ) == 1 );
+        result = ( GEOSOverlaps_r( QgsGeos::getGEOSHandler(), mGeos.get(), geosGeom.get() ) == 1 );
         break;
       default:
         return false;
@@ -1525,7 +1533,7 @@ QgsAbstractGeometry *QgsGeos::buffer( double distance, int segments, QString *er
   geos::unique_ptr geos;
   try
   {
-    geos.reset( GEOSBuffer_r( geosinit.ctxt, mGeos.get(), distance, segments ) );
+    geos.reset( GEOSBuffer_r( QgsGeos::getGEOSHandler(), mGeos.get(), distance, segments ) );
   }
   CATCH_GEOS_WITH_ERRMSG( nullptr );
   return fromGeos( geos.get() ).release();
@@ -1541,7 +1549,7 @@ QgsAbstractGeometry *QgsGeos::buffer( double distance, int segments, int endCapS
   geos::unique_ptr geos;
   try
   {
-    geos.reset( GEOSBufferWithStyle_r( geosinit.ctxt, mGeos.get(), distance, segments, endCapStyle, joinStyle, miterLimit ) );
+    geos.reset( GEOSBufferWithStyle_r( QgsGeos::getGEOSHandler(), mGeos.get(), distance, segments, endCapStyle, joinStyle, miterLimit ) );
   }
   CATCH_GEOS_WITH_ERRMSG( nullptr );
   return fromGeos( geos.get() ).release();
@@ -1556,7 +1564,7 @@ QgsAbstractGeometry *QgsGeos::simplify( double tolerance, QString *errorMsg ) co
   geos::unique_ptr geos;
   try
   {
-    geos.reset( GEOSTopologyPreserveSimplify_r( geosinit.ctxt, mGeos.get(), tolerance ) );
+    geos.reset( GEOSTopologyPreserveSimplify_r( QgsGeos::getGEOSHandler(), mGeos.get(), tolerance ) );
   }
   CATCH_GEOS_WITH_ERRMSG( nullptr );
   return fromGeos( geos.get() ).release();
@@ -1571,7 +1579,7 @@ QgsAbstractGeometry *QgsGeos::interpolate( double distance, QString *errorMsg )
   geos::unique_ptr geos;
   try
   {
-    geos.reset( GEOSInterpolate_r( geosinit.ctxt, mGeos.get(), distance ) );
+    geos.reset( GEOSInterpolate_r( QgsGeos::getGEOSHandler(), mGeos.get(), distance ) );
   }
   CATCH_GEOS_WITH_ERRMSG( nullptr );
   return fromGeos( geos.get() ).release();
@@ -1590,13 +1598,13 @@ QgsPoint *QgsGeos::centroid( QString *errorMsg ) const
 
   try
   {
-    geos.reset( GEOSGetCentroid_r( geosinit.ctxt,  mGeos.get() ) );
+    geos.reset( GEOSGetCentroid_r( QgsGeos::getGEOSHandler(),  mGeos.get() ) );
 
     if ( !geos )
       return nullptr;
 
-    GEOSGeomGetX_r( geosinit.ctxt, geos.get(), &x );
-    GEOSGeomGetY_r( geosinit.ctxt, geos.get(), &y );
+    GEOSGeomGetX_r( QgsGeos::getGEOSHandler(), geos.get(), &x );
+    GEOSGeomGetY_r( QgsGeos::getGEOSHandler(), geos.get(), &y );
   }
   CATCH_GEOS_WITH_ERRMSG( nullptr );
 
@@ -1612,7 +1620,7 @@ QgsAbstractGeometry *QgsGeos::envelope( QString *errorMsg ) const
   geos::unique_ptr geos;
   try
   {
-    geos.reset( GEOSEnvelope_r( geosinit.ctxt, mGeos.get() ) );
+    geos.reset( GEOSEnvelope_r( QgsGeos::getGEOSHandler(), mGeos.get() ) );
   }
   CATCH_GEOS_WITH_ERRMSG( nullptr );
   return fromGeos( geos.get() ).release();
@@ -1631,15 +1639,15 @@ QgsPoint *QgsGeos::pointOnSurface( QString *errorMsg ) const
   geos::unique_ptr geos;
   try
   {
-    geos.reset( GEOSPointOnSurface_r( geosinit.ctxt, mGeos.get() ) );
+    geos.reset( GEOSPointOnSurface_r( QgsGeos::getGEOSHandler(), mGeos.get() ) );
 
-    if ( !geos || GEOSisEmpty_r( geosinit.ctxt, geos.get() ) != 0 )
+    if ( !geos || GEOSisEmpty_r( QgsGeos::getGEOSHandler(), geos.get() ) != 0 )
     {
       return nullptr;
     }
 
-    GEOSGeomGetX_r( geosinit.ctxt, geos.get(), &x );
-    GEOSGeomGetY_r( geosinit.ctxt, geos.get(), &y );
+    GEOSGeomGetX_r( QgsGeos::getGEOSHandler(), geos.get(), &x );
+    GEOSGeomGetY_r( QgsGeos::getGEOSHandler(), geos.get(), &y );
   }
   CATCH_GEOS_WITH_ERRMSG( nullptr );
 
@@ -1655,7 +1663,7 @@ QgsAbstractGeometry *QgsGeos::convexHull( QString *errorMsg ) const
 
   try
   {
-    geos::unique_ptr cHull( GEOSConvexHull_r( geosinit.ctxt, mGeos.get() ) );
+    geos::unique_ptr cHull( GEOSConvexHull_r( QgsGeos::getGEOSHandler(), mGeos.get() ) );
     std::unique_ptr< QgsAbstractGeometry > cHullGeom = fromGeos( cHull.get() );
     return cHullGeom.release();
   }
@@ -1673,7 +1681,7 @@ bool QgsGeos::isValid( QString *errorMsg, const bool allowSelfTouchingHoles, Qgs
   {
     GEOSGeometry *g1 = nullptr;
     char *r = nullptr;
-    char res = GEOSisValidDetail_r( geosinit.ctxt, mGeos.get(), allowSelfTouchingHoles ? GEOSVALID_ALLOW_SELFTOUCHING_RING_FORMING_HOLE : 0, &r, &g1 );
+    char res = GEOSisValidDetail_r( QgsGeos::getGEOSHandler(), mGeos.get(), allowSelfTouchingHoles ? GEOSVALID_ALLOW_SELFTOUCHING_RING_FORMING_HOLE : 0, &r, &g1 );
     const bool invalid = res != 1;
 
     if ( invalid && errorMsg )
@@ -1706,7 +1714,7 @@ bool QgsGeos::isValid( QString *errorMsg, const bool allowSelfTouchingHoles, Qgs
       }
       else if ( g1 )
       {
-        GEOSGeom_destroy_r( geosinit.ctxt, g1 );
+        GEOSGeom_destroy_r( QgsGeos::getGEOSHandler(), g1 );
       }
     }
     return !invalid;
@@ -1728,7 +1736,7 @@ bool QgsGeos::isEqual( const QgsAbstractGeometry *geom, QString *errorMsg ) cons
     {
       return false;
     }
-    bool equal = GEOSEquals_r( geosinit.ctxt, mGeos.get(), geosGeom.get() );
+    bool equal = GEOSEquals_r( QgsGeos::getGEOSHandler(), mGeos.get(), geosGeom.get() );
     return equal;
   }
   CATCH_GEOS_WITH_ERRMSG( false );
@@ -1743,7 +1751,7 @@ bool QgsGeos::isEmpty( QString *errorMsg ) const
 
   try
   {
-    return GEOSisEmpty_r( geosinit.ctxt, mGeos.get() );
+    return GEOSisEmpty_r( QgsGeos::getGEOSHandler(), mGeos.get() );
   }
   CATCH_GEOS_WITH_ERRMSG( false );
 }
@@ -1757,7 +1765,7 @@ bool QgsGeos::isSimple( QString *errorMsg ) const
 
   try
   {
-    return GEOSisSimple_r( geosinit.ctxt, mGeos.get() );
+    return GEOSisSimple_r( QgsGeos::getGEOSHandler(), mGeos.get() );
   }
   CATCH_GEOS_WITH_ERRMSG( false );
 }
@@ -1801,7 +1809,7 @@ GEOSCoordSequence *QgsGeos::createCoordinateSequence( const QgsCurve *curve, dou
   GEOSCoordSequence *coordSeq = nullptr;
   try
   {
-    coordSeq = GEOSCoordSeq_create_r( geosinit.ctxt, numOutPoints, coordDims );
+    coordSeq = GEOSCoordSeq_create_r( QgsGeos::getGEOSHandler(), numOutPoints, coordDims );
     if ( !coordSeq )
     {
       QgsDebugMsg( QStringLiteral( "GEOS Exception: Could not create coordinate sequence for %1 points in %2 dimensions" ).arg( numPoints ).arg( coordDims ) );
@@ -1825,15 +1833,15 @@ GEOSCoordSequence *QgsGeos::createCoordinateSequence( const QgsCurve *curve, dou
           zData = hasZ ? line->zData() : nullptr;
           mData = hasM ? line->mData() : nullptr;
         }
-        GEOSCoordSeq_setX_r( geosinit.ctxt, coordSeq, i, std::round( *xData++ / precision ) * precision );
-        GEOSCoordSeq_setY_r( geosinit.ctxt, coordSeq, i, std::round( *yData++ / precision ) * precision );
+        GEOSCoordSeq_setX_r( QgsGeos::getGEOSHandler(), coordSeq, i, std::round( *xData++ / precision ) * precision );
+        GEOSCoordSeq_setY_r( QgsGeos::getGEOSHandler(), coordSeq, i, std::round( *yData++ / precision ) * precision );
         if ( hasZ )
         {
-          GEOSCoordSeq_setOrdinate_r( geosinit.ctxt, coordSeq, i, 2, std::round( *zData++ / precision ) * precision );
+          GEOSCoordSeq_setOrdinate_r( QgsGeos::getGEOSHandler(), coordSeq, i, 2, std::round( *zData++ / precision ) * precision );
         }
         if ( hasM )
         {
-          GEOSCoordSeq_setOrdinate_r( geosinit.ctxt, coordSeq, i, 3, line->mAt( *mData++ ) );
+          GEOSCoordSeq_setOrdinate_r( QgsGeos::getGEOSHandler(), coordSeq, i, 3, line->mAt( *mData++ ) );
         }
       }
     }
@@ -1849,15 +1857,15 @@ GEOSCoordSequence *QgsGeos::createCoordinateSequence( const QgsCurve *curve, dou
           zData = hasZ ? line->zData() : nullptr;
           mData = hasM ? line->mData() : nullptr;
         }
-        GEOSCoordSeq_setX_r( geosinit.ctxt, coordSeq, i, *xData++ );
-        GEOSCoordSeq_setY_r( geosinit.ctxt, coordSeq, i, *yData++ );
+        GEOSCoordSeq_setX_r( QgsGeos::getGEOSHandler(), coordSeq, i, *xData++ );
+        GEOSCoordSeq_setY_r( QgsGeos::getGEOSHandler(), coordSeq, i, *yData++ );
         if ( hasZ )
         {
-          GEOSCoordSeq_setOrdinate_r( geosinit.ctxt, coordSeq, i, 2, *zData++ );
+          GEOSCoordSeq_setOrdinate_r( QgsGeos::getGEOSHandler(), coordSeq, i, 2, *zData++ );
         }
         if ( hasM )
         {
-          GEOSCoordSeq_setOrdinate_r( geosinit.ctxt, coordSeq, i, 3, *mData++ );
+          GEOSCoordSeq_setOrdinate_r( QgsGeos::getGEOSHandler(), coordSeq, i, 3, *mData++ );
         }
       }
     }
@@ -1885,7 +1893,7 @@ geos::unique_ptr QgsGeos::createGeosPointXY( double x, double y, bool hasZ, doub
 
   try
   {
-    GEOSCoordSequence *coordSeq = GEOSCoordSeq_create_r( geosinit.ctxt, 1, coordDims );
+    GEOSCoordSequence *coordSeq = GEOSCoordSeq_create_r( QgsGeos::getGEOSHandler(), 1, coordDims );
     if ( !coordSeq )
     {
       QgsDebugMsg( QStringLiteral( "GEOS Exception: Could not create coordinate sequence for point with %1 dimensions" ).arg( coordDims ) );
@@ -1893,29 +1901,29 @@ geos::unique_ptr QgsGeos::createGeosPointXY( double x, double y, bool hasZ, doub
     }
     if ( precision > 0. )
     {
-      GEOSCoordSeq_setX_r( geosinit.ctxt, coordSeq, 0, std::round( x / precision ) * precision );
-      GEOSCoordSeq_setY_r( geosinit.ctxt, coordSeq, 0, std::round( y / precision ) * precision );
+      GEOSCoordSeq_setX_r( QgsGeos::getGEOSHandler(), coordSeq, 0, std::round( x / precision ) * precision );
+      GEOSCoordSeq_setY_r( QgsGeos::getGEOSHandler(), coordSeq, 0, std::round( y / precision ) * precision );
       if ( hasZ )
       {
-        GEOSCoordSeq_setOrdinate_r( geosinit.ctxt, coordSeq, 0, 2, std::round( z / precision ) * precision );
+        GEOSCoordSeq_setOrdinate_r( QgsGeos::getGEOSHandler(), coordSeq, 0, 2, std::round( z / precision ) * precision );
       }
     }
     else
     {
-      GEOSCoordSeq_setX_r( geosinit.ctxt, coordSeq, 0, x );
-      GEOSCoordSeq_setY_r( geosinit.ctxt, coordSeq, 0, y );
+      GEOSCoordSeq_setX_r( QgsGeos::getGEOSHandler(), coordSeq, 0, x );
+      GEOSCoordSeq_setY_r( QgsGeos::getGEOSHandler(), coordSeq, 0, y );
       if ( hasZ )
       {
-        GEOSCoordSeq_setOrdinate_r( geosinit.ctxt, coordSeq, 0, 2, z );
+        GEOSCoordSeq_setOrdinate_r( QgsGeos::getGEOSHandler(), coordSeq, 0, 2, z );
       }
     }
 #if 0 //disabled until geos supports m-coordinates
     if ( hasM )
     {
-      GEOSCoordSeq_setOrdinate_r( geosinit.ctxt, coordSeq, 0, 3, m );
+      GEOSCoordSeq_setOrdinate_r( QgsGeos::getGEOSHandler(), coordSeq, 0, 3, m );
     }
 #endif
-    geosPoint.reset( GEOSGeom_createPoint_r( geosinit.ctxt, coordSeq ) );
+    geosPoint.reset( GEOSGeom_createPoint_r( QgsGeos::getGEOSHandler(), coordSeq ) );
   }
   CATCH_GEOS( nullptr )
   return geosPoint;
@@ -1934,7 +1942,7 @@ geos::unique_ptr QgsGeos::createGeosLinestring( const QgsAbstractGeometry *curve
   geos::unique_ptr geosGeom;
   try
   {
-    geosGeom.reset( GEOSGeom_createLineString_r( geosinit.ctxt, coordSeq ) );
+    geosGeom.reset( GEOSGeom_createLineString_r( QgsGeos::getGEOSHandler(), coordSeq ) );
   }
   CATCH_GEOS( nullptr )
   return geosGeom;
@@ -1955,7 +1963,7 @@ geos::unique_ptr QgsGeos::createGeosPolygon( const QgsAbstractGeometry *poly, do
   geos::unique_ptr geosPolygon;
   try
   {
-    geos::unique_ptr exteriorRingGeos( GEOSGeom_createLinearRing_r( geosinit.ctxt, createCoordinateSequence( exteriorRing, precision, true ) ) );
+    geos::unique_ptr exteriorRingGeos( GEOSGeom_createLinearRing_r( QgsGeos::getGEOSHandler(), createCoordinateSequence( exteriorRing, precision, true ) ) );
 
     int nHoles = polygon->numInteriorRings();
     GEOSGeometry **holes = nullptr;
@@ -1967,9 +1975,9 @@ geos::unique_ptr QgsGeos::createGeosPolygon( const QgsAbstractGeometry *poly, do
     for ( int i = 0; i < nHoles; ++i )
     {
       const QgsCurve *interiorRing = polygon->interiorRing( i );
-      holes[i] = GEOSGeom_createLinearRing_r( geosinit.ctxt, createCoordinateSequence( interiorRing, precision, true ) );
+      holes[i] = GEOSGeom_createLinearRing_r( QgsGeos::getGEOSHandler(), createCoordinateSequence( interiorRing, precision, true ) );
     }
-    geosPolygon.reset( GEOSGeom_createPolygon_r( geosinit.ctxt, exteriorRingGeos.release(), holes, nHoles ) );
+    geosPolygon.reset( GEOSGeom_createPolygon_r( QgsGeos::getGEOSHandler(), exteriorRingGeos.release(), holes, nHoles ) );
     delete[] holes;
   }
   CATCH_GEOS( nullptr )
@@ -1985,7 +1993,7 @@ QgsAbstractGeometry *QgsGeos::offsetCurve( double distance, int segments, int jo
   geos::unique_ptr offset;
   try
   {
-    offset.reset( GEOSOffsetCurve_r( geosinit.ctxt, mGeos.get(), distance, segments, joinStyle, miterLimit ) );
+    offset.reset( GEOSOffsetCurve_r( QgsGeos::getGEOSHandler(), mGeos.get(), distance, segments, joinStyle, miterLimit ) );
   }
   CATCH_GEOS_WITH_ERRMSG( nullptr )
   std::unique_ptr< QgsAbstractGeometry > offsetGeom = fromGeos( offset.get() );
@@ -2002,17 +2010,17 @@ std::unique_ptr<QgsAbstractGeometry> QgsGeos::singleSidedBuffer( double distance
   geos::unique_ptr geos;
   try
   {
-    geos::buffer_params_unique_ptr bp( GEOSBufferParams_create_r( geosinit.ctxt ) );
-    GEOSBufferParams_setSingleSided_r( geosinit.ctxt, bp.get(), 1 );
-    GEOSBufferParams_setQuadrantSegments_r( geosinit.ctxt, bp.get(), segments );
-    GEOSBufferParams_setJoinStyle_r( geosinit.ctxt, bp.get(), joinStyle );
-    GEOSBufferParams_setMitreLimit_r( geosinit.ctxt, bp.get(), miterLimit );  //#spellok
+    geos::buffer_params_unique_ptr bp( GEOSBufferParams_create_r( QgsGeos::getGEOSHandler() ) );
+    GEOSBufferParams_setSingleSided_r( QgsGeos::getGEOSHandler(), bp.get(), 1 );
+    GEOSBufferParams_setQuadrantSegments_r( QgsGeos::getGEOSHandler(), bp.get(), segments );
+    GEOSBufferParams_setJoinStyle_r( QgsGeos::getGEOSHandler(), bp.get(), joinStyle );
+    GEOSBufferParams_setMitreLimit_r( QgsGeos::getGEOSHandler(), bp.get(), miterLimit );  //#spellok
 
     if ( side == 1 )
     {
       distance = -distance;
     }
-    geos.reset( GEOSBufferWithParams_r( geosinit.ctxt, mGeos.get(), bp.get(), distance ) );
+    geos.reset( GEOSBufferWithParams_r( QgsGeos::getGEOSHandler(), mGeos.get(), bp.get(), distance ) );
   }
   CATCH_GEOS_WITH_ERRMSG( nullptr );
   return fromGeos( geos.get() );
@@ -2035,7 +2043,7 @@ std::unique_ptr<QgsAbstractGeometry> QgsGeos::reshapeGeometry( const QgsLineStri
   geos::unique_ptr reshapeLineGeos = createGeosLinestring( &reshapeWithLine, mPrecision );
 
   //single or multi?
-  int numGeoms = GEOSGetNumGeometries_r( geosinit.ctxt, mGeos.get() );
+  int numGeoms = GEOSGetNumGeometries_r( QgsGeos::getGEOSHandler(), mGeos.get() );
   if ( numGeoms == -1 )
   {
     if ( errorCode )
@@ -2046,7 +2054,7 @@ std::unique_ptr<QgsAbstractGeometry> QgsGeos::reshapeGeometry( const QgsLineStri
   }
 
   bool isMultiGeom = false;
-  int geosTypeId = GEOSGeomTypeId_r( geosinit.ctxt, mGeos.get() );
+  int geosTypeId = GEOSGeomTypeId_r( QgsGeos::getGEOSHandler(), mGeos.get() );
   if ( geosTypeId == GEOS_MULTILINESTRING || geosTypeId == GEOS_MULTIPOLYGON )
     isMultiGeom = true;
 
@@ -2082,9 +2090,9 @@ std::unique_ptr<QgsAbstractGeometry> QgsGeos::reshapeGeometry( const QgsLineStri
       for ( int i = 0; i < numGeoms; ++i )
       {
         if ( isLine )
-          currentReshapeGeometry = reshapeLine( GEOSGetGeometryN_r( geosinit.ctxt, mGeos.get(), i ), reshapeLineGeos.get(), mPrecision );
+          currentReshapeGeometry = reshapeLine( GEOSGetGeometryN_r( QgsGeos::getGEOSHandler(), mGeos.get(), i ), reshapeLineGeos.get(), mPrecision );
         else
-          currentReshapeGeometry = reshapePolygon( GEOSGetGeometryN_r( geosinit.ctxt, mGeos.get(), i ), reshapeLineGeos.get(), mPrecision );
+          currentReshapeGeometry = reshapePolygon( GEOSGetGeometryN_r( QgsGeos::getGEOSHandler(), mGeos.get(), i ), reshapeLineGeos.get(), mPrecision );
 
         if ( currentReshapeGeometry )
         {
@@ -2093,18 +2101,18 @@ std::unique_ptr<QgsAbstractGeometry> QgsGeos::reshapeGeometry( const QgsLineStri
         }
         else
         {
-          newGeoms[i] = GEOSGeom_clone_r( geosinit.ctxt, GEOSGetGeometryN_r( geosinit.ctxt, mGeos.get(), i ) );
+          newGeoms[i] = GEOSGeom_clone_r( QgsGeos::getGEOSHandler(), GEOSGetGeometryN_r( QgsGeos::getGEOSHandler(), mGeos.get(), i ) );
         }
       }
 
       geos::unique_ptr newMultiGeom;
       if ( isLine )
       {
-        newMultiGeom.reset( GEOSGeom_createCollection_r( geosinit.ctxt, GEOS_MULTILINESTRING, newGeoms, numGeoms ) );
+        newMultiGeom.reset( GEOSGeom_createCollection_r( QgsGeos::getGEOSHandler(), GEOS_MULTILINESTRING, newGeoms, numGeoms ) );
       }
       else //multipolygon
       {
-        newMultiGeom.reset( GEOSGeom_createCollection_r( geosinit.ctxt, GEOS_MULTIPOLYGON, newGeoms, numGeoms ) );
+        newMultiGeom.reset( GEOSGeom_createCollection_r( QgsGeos::getGEOSHandler(), GEOS_MULTIPOLYGON, newGeoms, numGeoms ) );
       }
 
       delete[] newGeoms;
@@ -2141,13 +2149,13 @@ QgsGeometry QgsGeos::mergeLines( QString *errorMsg ) const
     return QgsGeometry();
   }
 
-  if ( GEOSGeomTypeId_r( geosinit.ctxt, mGeos.get() ) != GEOS_MULTILINESTRING )
+  if ( GEOSGeomTypeId_r( QgsGeos::getGEOSHandler(), mGeos.get() ) != GEOS_MULTILINESTRING )
     return QgsGeometry();
 
   geos::unique_ptr geos;
   try
   {
-    geos.reset( GEOSLineMerge_r( geosinit.ctxt, mGeos.get() ) );
+    geos.reset( GEOSLineMerge_r( QgsGeos::getGEOSHandler(), mGeos.get() ) );
   }
   CATCH_GEOS_WITH_ERRMSG( QgsGeometry() );
   return QgsGeometry( fromGeos( geos.get() ) );
@@ -2170,10 +2178,10 @@ QgsGeometry QgsGeos::closestPoint( const QgsGeometry &other, QString *errorMsg )
   double ny = 0.0;
   try
   {
-    geos::coord_sequence_unique_ptr nearestCoord( GEOSNearestPoints_r( geosinit.ctxt, mGeos.get(), otherGeom.get() ) );
+    geos::coord_sequence_unique_ptr nearestCoord( GEOSNearestPoints_r( QgsGeos::getGEOSHandler(), mGeos.get(), otherGeom.get() ) );
 
-    ( void )GEOSCoordSeq_getX_r( geosinit.ctxt, nearestCoord.get(), 0, &nx );
-    ( void )GEOSCoordSeq_getY_r( geosinit.ctxt, nearestCoord.get(), 0, &ny );
+    ( void )GEOSCoordSeq_getX_r( QgsGeos::getGEOSHandler(), nearestCoord.get(), 0, &nx );
+    ( void )GEOSCoordSeq_getY_r( QgsGeos::getGEOSHandler(), nearestCoord.get(), 0, &ny );
   }
   catch ( GEOSException &e )
   {
@@ -2206,12 +2214,12 @@ QgsGeometry QgsGeos::shortestLine( const QgsGeometry &other, QString *errorMsg )
   double ny2 = 0.0;
   try
   {
-    geos::coord_sequence_unique_ptr nearestCoord( GEOSNearestPoints_r( geosinit.ctxt, mGeos.get(), otherGeom.get() ) );
+    geos::coord_sequence_unique_ptr nearestCoord( GEOSNearestPoints_r( QgsGeos::getGEOSHandler(), mGeos.get(), otherGeom.get() ) );
 
-    ( void )GEOSCoordSeq_getX_r( geosinit.ctxt, nearestCoord.get(), 0, &nx1 );
-    ( void )GEOSCoordSeq_getY_r( geosinit.ctxt, nearestCoord.get(), 0, &ny1 );
-    ( void )GEOSCoordSeq_getX_r( geosinit.ctxt, nearestCoord.get(), 1, &nx2 );
-    ( void )GEOSCoordSeq_getY_r( geosinit.ctxt, nearestCoord.get(), 1, &ny2 );
+    ( void )GEOSCoordSeq_getX_r( QgsGeos::getGEOSHandler(), nearestCoord.get(), 0, &nx1 );
+    ( void )GEOSCoordSeq_getY_r( QgsGeos::getGEOSHandler(), nearestCoord.get(), 0, &ny1 );
+    ( void )GEOSCoordSeq_getX_r( QgsGeos::getGEOSHandler(), nearestCoord.get(), 1, &nx2 );
+    ( void )GEOSCoordSeq_getY_r( QgsGeos::getGEOSHandler(), nearestCoord.get(), 1, &ny2 );
   }
   catch ( GEOSException &e )
   {
@@ -2244,7 +2252,7 @@ double QgsGeos::lineLocatePoint( const QgsPoint &point, QString *errorMsg ) cons
   double distance = -1;
   try
   {
-    distance = GEOSProject_r( geosinit.ctxt, mGeos.get(), otherGeom.get() );
+    distance = GEOSProject_r( QgsGeos::getGEOSHandler(), mGeos.get(), otherGeom.get() );
   }
   catch ( GEOSException &e )
   {
@@ -2274,10 +2282,10 @@ QgsGeometry QgsGeos::polygonize( const QVector<const QgsAbstractGeometry *> &geo
 
   try
   {
-    geos::unique_ptr result( GEOSPolygonize_r( geosinit.ctxt, lineGeosGeometries, validLines ) );
+    geos::unique_ptr result( GEOSPolygonize_r( QgsGeos::getGEOSHandler(), lineGeosGeometries, validLines ) );
     for ( int i = 0; i < validLines; ++i )
     {
-      GEOSGeom_destroy_r( geosinit.ctxt, lineGeosGeometries[i] );
+      GEOSGeom_destroy_r( QgsGeos::getGEOSHandler(), lineGeosGeometries[i] );
     }
     delete[] lineGeosGeometries;
     return QgsGeometry( fromGeos( result.get() ) );
@@ -2290,7 +2298,7 @@ QgsGeometry QgsGeos::polygonize( const QVector<const QgsAbstractGeometry *> &geo
     }
     for ( int i = 0; i < validLines; ++i )
     {
-      GEOSGeom_destroy_r( geosinit.ctxt, lineGeosGeometries[i] );
+      GEOSGeom_destroy_r( QgsGeos::getGEOSHandler(), lineGeosGeometries[i] );
     }
     delete[] lineGeosGeometries;
     return QgsGeometry();
@@ -2317,9 +2325,9 @@ QgsGeometry QgsGeos::voronoiDiagram( const QgsAbstractGeometry *extent, double t
   geos::unique_ptr geos;
   try
   {
-    geos.reset( GEOSVoronoiDiagram_r( geosinit.ctxt, mGeos.get(), extentGeosGeom.get(), tolerance, edgesOnly ) );
+    geos.reset( GEOSVoronoiDiagram_r( QgsGeos::getGEOSHandler(), mGeos.get(), extentGeosGeom.get(), tolerance, edgesOnly ) );
 
-    if ( !geos || GEOSisEmpty_r( geosinit.ctxt, geos.get() ) != 0 )
+    if ( !geos || GEOSisEmpty_r( QgsGeos::getGEOSHandler(), geos.get() ) != 0 )
     {
       return QgsGeometry();
     }
@@ -2339,9 +2347,9 @@ QgsGeometry QgsGeos::delaunayTriangulation( double tolerance, bool edgesOnly, QS
   geos::unique_ptr geos;
   try
   {
-    geos.reset( GEOSDelaunayTriangulation_r( geosinit.ctxt, mGeos.get(), tolerance, edgesOnly ) );
+    geos.reset( GEOSDelaunayTriangulation_r( QgsGeos::getGEOSHandler(), mGeos.get(), tolerance, edgesOnly ) );
 
-    if ( !geos || GEOSisEmpty_r( geosinit.ctxt, geos.get() ) != 0 )
+    if ( !geos || GEOSisEmpty_r( QgsGeos::getGEOSHandler(), geos.get() ) != 0 )
     {
       return QgsGeometry();
     }
@@ -2355,21 +2363,21 @@ QgsGeometry QgsGeos::delaunayTriangulation( double tolerance, bool edgesOnly, QS
 //! Extract coordinates of linestring's endpoints. Returns false on error.
 static bool _linestringEndpoints( const GEOSGeometry *linestring, double &x1, double &y1, double &x2, double &y2 )
 {
-  const GEOSCoordSequence *coordSeq = GEOSGeom_getCoordSeq_r( geosinit.ctxt, linestring );
+  const GEOSCoordSequence *coordSeq = GEOSGeom_getCoordSeq_r( QgsGeos::getGEOSHandler(), linestring );
   if ( !coordSeq )
     return false;
 
   unsigned int coordSeqSize;
-  if ( GEOSCoordSeq_getSize_r( geosinit.ctxt, coordSeq, &coordSeqSize ) == 0 )
+  if ( GEOSCoordSeq_getSize_r( QgsGeos::getGEOSHandler(), coordSeq, &coordSeqSize ) == 0 )
     return false;
 
   if ( coordSeqSize < 2 )
     return false;
 
-  GEOSCoordSeq_getX_r( geosinit.ctxt, coordSeq, 0, &x1 );
-  GEOSCoordSeq_getY_r( geosinit.ctxt, coordSeq, 0, &y1 );
-  GEOSCoordSeq_getX_r( geosinit.ctxt, coordSeq, coordSeqSize - 1, &x2 );
-  GEOSCoordSeq_getY_r( geosinit.ctxt, coordSeq, coordSeqSize - 1, &y2 );
+  GEOSCoordSeq_getX_r( QgsGeos::getGEOSHandler(), coordSeq, 0, &x1 );
+  GEOSCoordSeq_getY_r( QgsGeos::getGEOSHandler(), coordSeq, 0, &y1 );
+  GEOSCoordSeq_getX_r( QgsGeos::getGEOSHandler(), coordSeq, coordSeqSize - 1, &x2 );
+  GEOSCoordSeq_getY_r( QgsGeos::getGEOSHandler(), coordSeq, coordSeqSize - 1, &y2 );
   return true;
 }
 
@@ -2395,11 +2403,11 @@ static geos::unique_ptr _mergeLinestrings( const GEOSGeometry *line1, const GEOS
   // the intersection must be at the begin/end of both lines
   if ( intersectionAtOrigLineEndpoint && intersectionAtReshapeLineEndpoint )
   {
-    geos::unique_ptr g1( GEOSGeom_clone_r( geosinit.ctxt, line1 ) );
-    geos::unique_ptr g2( GEOSGeom_clone_r( geosinit.ctxt, line2 ) );
+    geos::unique_ptr g1( GEOSGeom_clone_r( QgsGeos::getGEOSHandler(), line1 ) );
+    geos::unique_ptr g2( GEOSGeom_clone_r( QgsGeos::getGEOSHandler(), line2 ) );
     GEOSGeometry *geoms[2] = { g1.release(), g2.release() };
-    geos::unique_ptr multiGeom( GEOSGeom_createCollection_r( geosinit.ctxt, GEOS_MULTILINESTRING, geoms, 2 ) );
-    geos::unique_ptr res( GEOSLineMerge_r( geosinit.ctxt, multiGeom.get() ) );
+    geos::unique_ptr multiGeom( GEOSGeom_createCollection_r( QgsGeos::getGEOSHandler(), GEOS_MULTILINESTRING, geoms, 2 ) );
+    geos::unique_ptr res( GEOSLineMerge_r( QgsGeos::getGEOSHandler(), multiGeom.get() ) );
     return res;
   }
   else
@@ -2419,18 +2427,18 @@ geos::unique_ptr QgsGeos::reshapeLine( const GEOSGeometry *line, const GEOSGeome
   try
   {
     //make sure there are at least two intersection between line and reshape geometry
-    geos::unique_ptr intersectGeom( GEOSIntersection_r( geosinit.ctxt, line, reshapeLineGeos ) );
+    geos::unique_ptr intersectGeom( GEOSIntersection_r( QgsGeos::getGEOSHandler(), line, reshapeLineGeos ) );
     if ( intersectGeom )
     {
-      atLeastTwoIntersections = ( GEOSGeomTypeId_r( geosinit.ctxt, intersectGeom.get() ) == GEOS_MULTIPOINT
-                                  && GEOSGetNumGeometries_r( geosinit.ctxt, intersectGeom.get() ) > 1 );
+      atLeastTwoIntersections = ( GEOSGeomTypeId_r( QgsGeos::getGEOSHandler(), intersectGeom.get() ) == GEOS_MULTIPOINT
+                                  && GEOSGetNumGeometries_r( QgsGeos::getGEOSHandler(), intersectGeom.get() ) > 1 );
       // one point is enough when extending line at its endpoint
-      if ( GEOSGeomTypeId_r( geosinit.ctxt, intersectGeom.get() ) == GEOS_POINT )
+      if ( GEOSGeomTypeId_r( QgsGeos::getGEOSHandler(), intersectGeom.get() ) == GEOS_POINT )
       {
-        const GEOSCoordSequence *intersectionCoordSeq = GEOSGeom_getCoordSeq_r( geosinit.ctxt, intersectGeom.get() );
+        const GEOSCoordSequence *intersectionCoordSeq = GEOSGeom_getCoordSeq_r( QgsGeos::getGEOSHandler(), intersectGeom.get() );
         double xi, yi;
-        GEOSCoordSeq_getX_r( geosinit.ctxt, intersectionCoordSeq, 0, &xi );
-        GEOSCoordSeq_getY_r( geosinit.ctxt, intersectionCoordSeq, 0, &yi );
+        GEOSCoordSeq_getX_r( QgsGeos::getGEOSHandler(), intersectionCoordSeq, 0, &xi );
+        GEOSCoordSeq_getY_r( QgsGeos::getGEOSHandler(), intersectionCoordSeq, 0, &yi );
         oneIntersection = true;
         oneIntersectionPoint = QgsPointXY( xi, yi );
       }
@@ -2457,8 +2465,8 @@ geos::unique_ptr QgsGeos::reshapeLine( const GEOSGeometry *line, const GEOSGeome
   geos::unique_ptr endLineVertex = createGeosPointXY( x2, y2, false, 0, false, 0, 2, precision );
 
   bool isRing = false;
-  if ( GEOSGeomTypeId_r( geosinit.ctxt, line ) == GEOS_LINEARRING
-       || GEOSEquals_r( geosinit.ctxt, beginLineVertex.get(), endLineVertex.get() ) == 1 )
+  if ( GEOSGeomTypeId_r( QgsGeos::getGEOSHandler(), line ) == GEOS_LINEARRING
+       || GEOSEquals_r( QgsGeos::getGEOSHandler(), beginLineVertex.get(), endLineVertex.get() ) == 1 )
     isRing = true;
 
   //node line and reshape line
@@ -2469,18 +2477,18 @@ geos::unique_ptr QgsGeos::reshapeLine( const GEOSGeometry *line, const GEOSGeome
   }
 
   //and merge them together
-  geos::unique_ptr mergedLines( GEOSLineMerge_r( geosinit.ctxt, nodedGeometry.get() ) );
+  geos::unique_ptr mergedLines( GEOSLineMerge_r( QgsGeos::getGEOSHandler(), nodedGeometry.get() ) );
   if ( !mergedLines )
   {
     return nullptr;
   }
 
-  int numMergedLines = GEOSGetNumGeometries_r( geosinit.ctxt, mergedLines.get() );
+  int numMergedLines = GEOSGetNumGeometries_r( QgsGeos::getGEOSHandler(), mergedLines.get() );
   if ( numMergedLines < 2 ) //some special cases. Normally it is >2
   {
     if ( numMergedLines == 1 ) //reshape line is from begin to endpoint. So we keep the reshapeline
     {
-      geos::unique_ptr result( GEOSGeom_clone_r( geosinit.ctxt, reshapeLineGeos ) );
+      geos::unique_ptr result( GEOSGeom_clone_r( QgsGeos::getGEOSHandler(), reshapeLineGeos ) );
       return result;
     }
     else
@@ -2494,19 +2502,19 @@ geos::unique_ptr QgsGeos::reshapeLine( const GEOSGeometry *line, const GEOSGeome
   {
     const GEOSGeometry *currentGeom = nullptr;
 
-    currentGeom = GEOSGetGeometryN_r( geosinit.ctxt, mergedLines.get(), i );
-    const GEOSCoordSequence *currentCoordSeq = GEOSGeom_getCoordSeq_r( geosinit.ctxt, currentGeom );
+    currentGeom = GEOSGetGeometryN_r( QgsGeos::getGEOSHandler(), mergedLines.get(), i );
+    const GEOSCoordSequence *currentCoordSeq = GEOSGeom_getCoordSeq_r( QgsGeos::getGEOSHandler(), currentGeom );
     unsigned int currentCoordSeqSize;
-    GEOSCoordSeq_getSize_r( geosinit.ctxt, currentCoordSeq, &currentCoordSeqSize );
+    GEOSCoordSeq_getSize_r( QgsGeos::getGEOSHandler(), currentCoordSeq, &currentCoordSeqSize );
     if ( currentCoordSeqSize < 2 )
       continue;
 
     //get the two endpoints of the current line merge result
     double xBegin, xEnd, yBegin, yEnd;
-    GEOSCoordSeq_getX_r( geosinit.ctxt, currentCoordSeq, 0, &xBegin );
-    GEOSCoordSeq_getY_r( geosinit.ctxt, currentCoordSeq, 0, &yBegin );
-    GEOSCoordSeq_getX_r( geosinit.ctxt, currentCoordSeq, currentCoordSeqSize - 1, &xEnd );
-    GEOSCoordSeq_getY_r( geosinit.ctxt, currentCoordSeq, currentCoordSeqSize - 1, &yEnd );
+    GEOSCoordSeq_getX_r( QgsGeos::getGEOSHandler(), currentCoordSeq, 0, &xBegin );
+    GEOSCoordSeq_getY_r( QgsGeos::getGEOSHandler(), currentCoordSeq, 0, &yBegin );
+    GEOSCoordSeq_getX_r( QgsGeos::getGEOSHandler(), currentCoordSeq, currentCoordSeqSize - 1, &xEnd );
+    GEOSCoordSeq_getY_r( QgsGeos::getGEOSHandler(), currentCoordSeq, currentCoordSeqSize - 1, &yEnd );
     geos::unique_ptr beginCurrentGeomVertex = createGeosPointXY( xBegin, yBegin, false, 0, false, 0, 2, precision );
     geos::unique_ptr endCurrentGeomVertex = createGeosPointXY( xEnd, yEnd, false, 0, false, 0, 2, precision );
 
@@ -2520,12 +2528,12 @@ geos::unique_ptr QgsGeos::reshapeLine( const GEOSGeometry *line, const GEOSGeome
 
     //check how many endpoints equal the endpoints of the original line
     int nEndpointsSameAsOriginalLine = 0;
-    if ( GEOSEquals_r( geosinit.ctxt, beginCurrentGeomVertex.get(), beginLineVertex.get() ) == 1
-         || GEOSEquals_r( geosinit.ctxt, beginCurrentGeomVertex.get(), endLineVertex.get() ) == 1 )
+    if ( GEOSEquals_r( QgsGeos::getGEOSHandler(), beginCurrentGeomVertex.get(), beginLineVertex.get() ) == 1
+         || GEOSEquals_r( QgsGeos::getGEOSHandler(), beginCurrentGeomVertex.get(), endLineVertex.get() ) == 1 )
       nEndpointsSameAsOriginalLine += 1;
 
-    if ( GEOSEquals_r( geosinit.ctxt, endCurrentGeomVertex.get(), beginLineVertex.get() ) == 1
-         || GEOSEquals_r( geosinit.ctxt, endCurrentGeomVertex.get(), endLineVertex.get() ) == 1 )
+    if ( GEOSEquals_r( QgsGeos::getGEOSHandler(), endCurrentGeomVertex.get(), beginLineVertex.get() ) == 1
+         || GEOSEquals_r( QgsGeos::getGEOSHandler(), endCurrentGeomVertex.get(), endLineVertex.get() ) == 1 )
       nEndpointsSameAsOriginalLine += 1;
 
     //check if the current geometry overlaps the original geometry (GEOSOverlap does not seem to work with linestrings)
@@ -2540,24 +2548,24 @@ geos::unique_ptr QgsGeos::reshapeLine( const GEOSGeometry *line, const GEOSGeome
     //logic to decide if this part belongs to the result
     if ( !isRing && nEndpointsSameAsOriginalLine == 1 && nEndpointsOnOriginalLine == 2 && currentGeomOverlapsOriginalGeom )
     {
-      resultLineParts.push_back( GEOSGeom_clone_r( geosinit.ctxt, currentGeom ) );
+      resultLineParts.push_back( GEOSGeom_clone_r( QgsGeos::getGEOSHandler(), currentGeom ) );
     }
     //for closed rings, we take one segment from the candidate list
     else if ( isRing && nEndpointsOnOriginalLine == 2 && currentGeomOverlapsOriginalGeom )
     {
-      probableParts.push_back( GEOSGeom_clone_r( geosinit.ctxt, currentGeom ) );
+      probableParts.push_back( GEOSGeom_clone_r( QgsGeos::getGEOSHandler(), currentGeom ) );
     }
     else if ( nEndpointsOnOriginalLine == 2 && !currentGeomOverlapsOriginalGeom )
     {
-      resultLineParts.push_back( GEOSGeom_clone_r( geosinit.ctxt, currentGeom ) );
+      resultLineParts.push_back( GEOSGeom_clone_r( QgsGeos::getGEOSHandler(), currentGeom ) );
     }
     else if ( nEndpointsSameAsOriginalLine == 2 && !currentGeomOverlapsOriginalGeom )
     {
-      resultLineParts.push_back( GEOSGeom_clone_r( geosinit.ctxt, currentGeom ) );
+      resultLineParts.push_back( GEOSGeom_clone_r( QgsGeos::getGEOSHandler(), currentGeom ) );
     }
     else if ( currentGeomOverlapsOriginalGeom && currentGeomOverlapsReshapeLine )
     {
-      resultLineParts.push_back( GEOSGeom_clone_r( geosinit.ctxt, currentGeom ) );
+      resultLineParts.push_back( GEOSGeom_clone_r( QgsGeos::getGEOSHandler(), currentGeom ) );
     }
   }
 
@@ -2571,7 +2579,7 @@ geos::unique_ptr QgsGeos::reshapeLine( const GEOSGeometry *line, const GEOSGeome
     for ( int i = 0; i < probableParts.size(); ++i )
     {
       currentGeom = probableParts.at( i );
-      GEOSLength_r( geosinit.ctxt, currentGeom, &currentLength );
+      GEOSLength_r( QgsGeos::getGEOSHandler(), currentGeom, &currentLength );
       if ( currentLength > maxLength )
       {
         maxLength = currentLength;
@@ -2579,7 +2587,7 @@ geos::unique_ptr QgsGeos::reshapeLine( const GEOSGeometry *line, const GEOSGeome
       }
       else
       {
-        GEOSGeom_destroy_r( geosinit.ctxt, currentGeom );
+        GEOSGeom_destroy_r( QgsGeos::getGEOSHandler(), currentGeom );
       }
     }
     resultLineParts.push_back( maxGeom.release() );
@@ -2602,15 +2610,15 @@ geos::unique_ptr QgsGeos::reshapeLine( const GEOSGeometry *line, const GEOSGeome
     }
 
     //create multiline from resultLineParts
-    geos::unique_ptr multiLineGeom( GEOSGeom_createCollection_r( geosinit.ctxt, GEOS_MULTILINESTRING, lineArray, resultLineParts.size() ) );
+    geos::unique_ptr multiLineGeom( GEOSGeom_createCollection_r( QgsGeos::getGEOSHandler(), GEOS_MULTILINESTRING, lineArray, resultLineParts.size() ) );
     delete [] lineArray;
 
     //then do a linemerge with the newly combined partstrings
-    result.reset( GEOSLineMerge_r( geosinit.ctxt, multiLineGeom.get() ) );
+    result.reset( GEOSLineMerge_r( QgsGeos::getGEOSHandler(), multiLineGeom.get() ) );
   }
 
   //now test if the result is a linestring. Otherwise something went wrong
-  if ( GEOSGeomTypeId_r( geosinit.ctxt, result.get() ) != GEOS_LINESTRING )
+  if ( GEOSGeomTypeId_r( QgsGeos::getGEOSHandler(), result.get() ) != GEOS_LINESTRING )
   {
     return nullptr;
   }
@@ -2625,13 +2633,13 @@ geos::unique_ptr QgsGeos::reshapePolygon( const GEOSGeometry *polygon, const GEO
   int lastIntersectingRing = -2;
   const GEOSGeometry *lastIntersectingGeom = nullptr;
 
-  int nRings = GEOSGetNumInteriorRings_r( geosinit.ctxt, polygon );
+  int nRings = GEOSGetNumInteriorRings_r( QgsGeos::getGEOSHandler(), polygon );
   if ( nRings < 0 )
     return nullptr;
 
   //does outer ring intersect?
-  const GEOSGeometry *outerRing = GEOSGetExteriorRing_r( geosinit.ctxt, polygon );
-  if ( GEOSIntersects_r( geosinit.ctxt, outerRing, reshapeLineGeos ) == 1 )
+  const GEOSGeometry *outerRing = GEOSGetExteriorRing_r( QgsGeos::getGEOSHandler(), polygon );
+  if ( GEOSIntersects_r( QgsGeos::getGEOSHandler(), outerRing, reshapeLineGeos ) == 1 )
   {
     ++nIntersections;
     lastIntersectingRing = -1;
@@ -2645,8 +2653,8 @@ geos::unique_ptr QgsGeos::reshapePolygon( const GEOSGeometry *polygon, const GEO
   {
     for ( int i = 0; i < nRings; ++i )
     {
-      innerRings[i] = GEOSGetInteriorRingN_r( geosinit.ctxt, polygon, i );
-      if ( GEOSIntersects_r( geosinit.ctxt, innerRings[i], reshapeLineGeos ) == 1 )
+      innerRings[i] = GEOSGetInteriorRingN_r( QgsGeos::getGEOSHandler(), polygon, i );
+      if ( GEOSIntersects_r( QgsGeos::getGEOSHandler(), innerRings[i], reshapeLineGeos ) == 1 )
       {
         ++nIntersections;
         lastIntersectingRing = i;
@@ -2675,12 +2683,12 @@ geos::unique_ptr QgsGeos::reshapePolygon( const GEOSGeometry *polygon, const GEO
 
   //if reshaping took place, we need to reassemble the polygon and its rings
   GEOSGeometry *newRing = nullptr;
-  const GEOSCoordSequence *reshapeSequence = GEOSGeom_getCoordSeq_r( geosinit.ctxt, reshapeResult.get() );
-  GEOSCoordSequence *newCoordSequence = GEOSCoordSeq_clone_r( geosinit.ctxt, reshapeSequence );
+  const GEOSCoordSequence *reshapeSequence = GEOSGeom_getCoordSeq_r( QgsGeos::getGEOSHandler(), reshapeResult.get() );
+  GEOSCoordSequence *newCoordSequence = GEOSCoordSeq_clone_r( QgsGeos::getGEOSHandler(), reshapeSequence );
 
   reshapeResult.reset();
 
-  newRing = GEOSGeom_createLinearRing_r( geosinit.ctxt, newCoordSequence );
+  newRing = GEOSGeom_createLinearRing_r( QgsGeos::getGEOSHandler(), newCoordSequence );
   if ( !newRing )
   {
     delete [] innerRings;
@@ -2691,13 +2699,13 @@ geos::unique_ptr QgsGeos::reshapePolygon( const GEOSGeometry *polygon, const GEO
   if ( lastIntersectingRing == -1 )
     newOuterRing = newRing;
   else
-    newOuterRing = GEOSGeom_clone_r( geosinit.ctxt, outerRing );
+    newOuterRing = GEOSGeom_clone_r( QgsGeos::getGEOSHandler(), outerRing );
 
   //check if all the rings are still inside the outer boundary
   QVector<GEOSGeometry *> ringList;
   if ( nRings > 0 )
   {
-    GEOSGeometry *outerRingPoly = GEOSGeom_createPolygon_r( geosinit.ctxt, GEOSGeom_clone_r( geosinit.ctxt, newOuterRing ), nullptr, 0 );
+    GEOSGeometry *outerRingPoly = GEOSGeom_createPolygon_r( QgsGeos::getGEOSHandler(), GEOSGeom_clone_r( QgsGeos::getGEOSHandler(), newOuterRing ), nullptr, 0 );
     if ( outerRingPoly )
     {
       GEOSGeometry *currentRing = nullptr;
@@ -2706,16 +2714,16 @@ geos::unique_ptr QgsGeos::reshapePolygon( const GEOSGeometry *polygon, const GEO
         if ( lastIntersectingRing == i )
           currentRing = newRing;
         else
-          currentRing = GEOSGeom_clone_r( geosinit.ctxt, innerRings[i] );
+          currentRing = GEOSGeom_clone_r( QgsGeos::getGEOSHandler(), innerRings[i] );
 
         //possibly a ring is no longer contained in the result polygon after reshape
-        if ( GEOSContains_r( geosinit.ctxt, outerRingPoly, currentRing ) == 1 )
+        if ( GEOSContains_r( QgsGeos::getGEOSHandler(), outerRingPoly, currentRing ) == 1 )
           ringList.push_back( currentRing );
         else
-          GEOSGeom_destroy_r( geosinit.ctxt, currentRing );
+          GEOSGeom_destroy_r( QgsGeos::getGEOSHandler(), currentRing );
       }
     }
-    GEOSGeom_destroy_r( geosinit.ctxt, outerRingPoly );
+    GEOSGeom_destroy_r( QgsGeos::getGEOSHandler(), outerRingPoly );
   }
 
   GEOSGeometry **newInnerRings = new GEOSGeometry*[ringList.size()];
@@ -2724,7 +2732,7 @@ geos::unique_ptr QgsGeos::reshapePolygon( const GEOSGeometry *polygon, const GEO
 
   delete [] innerRings;
 
-  geos::unique_ptr reshapedPolygon( GEOSGeom_createPolygon_r( geosinit.ctxt, newOuterRing, newInnerRings, ringList.size() ) );
+  geos::unique_ptr reshapedPolygon( GEOSGeom_createPolygon_r( QgsGeos::getGEOSHandler(), newOuterRing, newInnerRings, ringList.size() ) );
   delete[] newInnerRings;
 
   return reshapedPolygon;
@@ -2739,18 +2747,18 @@ int QgsGeos::lineContainedInLine( const GEOSGeometry *line1, const GEOSGeometry
 
   double bufferDistance = std::pow( 10.0L, geomDigits( line2 ) - 11 );
 
-  geos::unique_ptr bufferGeom( GEOSBuffer_r( geosinit.ctxt, line2, bufferDistance, DEFAULT_QUADRANT_SEGMENTS ) );
+  geos::unique_ptr bufferGeom( GEOSBuffer_r( QgsGeos::getGEOSHandler(), line2, bufferDistance, DEFAULT_QUADRANT_SEGMENTS ) );
   if ( !bufferGeom )
     return -2;
 
-  geos::unique_ptr intersectionGeom( GEOSIntersection_r( geosinit.ctxt, bufferGeom.get(), line1 ) );
+  geos::unique_ptr intersectionGeom( GEOSIntersection_r( QgsGeos::getGEOSHandler(), bufferGeom.get(), line1 ) );
 
   //compare ratio between line1Length and intersectGeomLength (usually close to 1 if line1 is contained in line2)
   double intersectGeomLength;
   double line1Length;
 
-  GEOSLength_r( geosinit.ctxt, intersectionGeom.get(), &intersectGeomLength );
-  GEOSLength_r( geosinit.ctxt, line1, &line1Length );
+  GEOSLength_r( QgsGeos::getGEOSHandler(), intersectionGeom.get(), &intersectGeomLength );
+  GEOSLength_r( QgsGeos::getGEOSHandler(), line1, &line1Length );
 
   double intersectRatio = line1Length / intersectGeomLength;
   if ( intersectRatio > 0.9 && intersectRatio < 1.1 )
@@ -2766,12 +2774,12 @@ int QgsGeos::pointContainedInLine( const GEOSGeometry *point, const GEOSGeometry
 
   double bufferDistance = std::pow( 10.0L, geomDigits( line ) - 11 );
 
-  geos::unique_ptr lineBuffer( GEOSBuffer_r( geosinit.ctxt, line, bufferDistance, 8 ) );
+  geos::unique_ptr lineBuffer( GEOSBuffer_r( QgsGeos::getGEOSHandler(), line, bufferDistance, 8 ) );
   if ( !lineBuffer )
     return -2;
 
   bool contained = false;
-  if ( GEOSContains_r( geosinit.ctxt, lineBuffer.get(), point ) == 1 )
+  if ( GEOSContains_r( QgsGeos::getGEOSHandler(), lineBuffer.get(), point ) == 1 )
     contained = true;
 
   return contained;
@@ -2779,35 +2787,35 @@ int QgsGeos::pointContainedInLine( const GEOSGeometry *point, const GEOSGeometry
 
 int QgsGeos::geomDigits( const GEOSGeometry *geom )
 {
-  geos::unique_ptr bbox( GEOSEnvelope_r( geosinit.ctxt, geom ) );
+  geos::unique_ptr bbox( GEOSEnvelope_r( QgsGeos::getGEOSHandler(), geom ) );
   if ( !bbox.get() )
     return -1;
 
-  const GEOSGeometry *bBoxRing = GEOSGetExteriorRing_r( geosinit.ctxt, bbox.get() );
+  const GEOSGeometry *bBoxRing = GEOSGetExteriorRing_r( QgsGeos::getGEOSHandler(), bbox.get() );
   if ( !bBoxRing )
     return -1;
 
-  const GEOSCoordSequence *bBoxCoordSeq = GEOSGeom_getCoordSeq_r( geosinit.ctxt, bBoxRing );
+  const GEOSCoordSequence *bBoxCoordSeq = GEOSGeom_getCoordSeq_r( QgsGeos::getGEOSHandler(), bBoxRing );
 
   if ( !bBoxCoordSeq )
     return -1;
 
   unsigned int nCoords = 0;
-  if ( !GEOSCoordSeq_getSize_r( geosinit.ctxt, bBoxCoordSeq, &nCoords ) )
+  if ( !GEOSCoordSeq_getSize_r( QgsGeos::getGEOSHandler(), bBoxCoordSeq, &nCoords ) )
     return -1;
 
   int maxDigits = -1;
   for ( unsigned int i = 0; i < nCoords - 1; ++i )
   {
     double t;
-    GEOSCoordSeq_getX_r( geosinit.ctxt, bBoxCoordSeq, i, &t );
+    GEOSCoordSeq_getX_r( QgsGeos::getGEOSHandler(), bBoxCoordSeq, i, &t );
 
     int digits;
     digits = std::ceil( std::log10( std::fabs( t ) ) );
     if ( digits > maxDigits )
       maxDigits = digits;
 
-    GEOSCoordSeq_getY_r( geosinit.ctxt, bBoxCoordSeq, i, &t );
+    GEOSCoordSeq_getY_r( QgsGeos::getGEOSHandler(), bBoxCoordSeq, i, &t );
     digits = std::ceil( std::log10( std::fabs( t ) ) );
     if ( digits > maxDigits )
       maxDigits = digits;
@@ -2818,5 +2826,11 @@ int QgsGeos::geomDigits( const GEOSGeometry *geom )
 
 GEOSContextHandle_t QgsGeos::getGEOSHandler()
 {
-  return geosinit.ctxt;
+#if defined(USE_THREAD_LOCAL) && !defined(Q_OS_WIN)
+  return sGeosInit.ctxt;
+#else
+  if ( !sGeosInit.hasLocalData() )
+    sGeosInit.setLocalData( new GEOSInit() );
+  return sGeosInit.localData()->ctxt;
+#endif
 }
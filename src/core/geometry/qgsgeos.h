@@ -356,6 +356,7 @@ class CORE_EXPORT QgsGeos: public QgsGeometryEngine
     static geos::unique_ptr asGeos( const QgsAbstractGeometry *geometry, double precision = 0 );
     static QgsPoint coordSeqPoint( const GEOSCoordSequence *cs, int i, bool hasZ, bool hasM );
 
+    //! Returns the GEOS context handle of the calling thread
     static GEOSContextHandle_t getGEOSHandler();
 
 
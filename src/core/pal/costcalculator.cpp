@@ -36,6 +36,11 @@ bool CostCalculator::candidateSortShrink( const LabelPosition *c1, const LabelPo
 }
 
 void CostCalculator::addObstacleCostPenalty( LabelPosition *lp, FeaturePart *obstacle )
+{
+  applyObstacleCostPenalty( lp, obstacle, obstacleCostPenalty( lp, obstacle ) );
+}
+
+int CostCalculator::obstacleCostPenalty( const LabelPosition *lp, FeaturePart *obstacle )
 {
   int n = 0;
   double dist;
@@ -83,6 +88,11 @@ void CostCalculator::addObstacleCostPenalty( LabelPosition *lp, FeaturePart *obs
       break;
   }
 
+  return n;
+}
+
+void CostCalculator::applyObstacleCostPenalty( LabelPosition *lp, const FeaturePart *obstacle, int n )
+{
   if ( n > 0 )
     lp->setConflictsWithObstacle( true );
 
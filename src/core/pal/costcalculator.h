@@ -38,6 +38,19 @@ namespace pal
       //! Increase candidate's cost according to its collision with passed feature
       static void addObstacleCostPenalty( LabelPosition *lp, pal::FeaturePart *obstacle );
 
+      /**
+       * Calculates the penalty (0 to 12) for the collision of a candidate with an obstacle,
+       * without modifying the candidate.
+       * \see applyObstacleCostPenalty()
+       */
+      static int obstacleCostPenalty( const LabelPosition *lp, pal::FeaturePart *obstacle );
+
+      /**
+       * Increases the candidate's cost by a \a penalty calculated by obstacleCostPenalty().
+       * \see obstacleCostPenalty()
+       */
+      static void applyObstacleCostPenalty( LabelPosition *lp, const pal::FeaturePart *obstacle, int penalty );
+
       static void setPolygonCandidatesCost( int nblp, QList< LabelPosition * > &lPos, RTree<pal::FeaturePart *, double, 2, double> *obstacles, double bbx[4], double bby[4] );
 
       //! Sets cost to the smallest distance between lPos's centroid and a polygon stored in geoetry field
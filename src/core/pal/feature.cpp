@@ -38,7 +38,6 @@
 #include "qgis.h"
 #include "qgsgeos.h"
 #include "qgsmessagelog.h"
-#include "costcalculator.h"
 #include "qgsgeometryutils.h"
 #include <QLinkedList>
 #include <cmath>
@@ -1603,13 +1602,19 @@ int FeaturePart::createCandidatesForPolygon( QList< LabelPosition *> &lPos, Poin
   return nbp;
 }
 
-QList<LabelPosition *> FeaturePart::createCandidates( const GEOSPreparedGeometry *mapBoundary,
-    PointSet *mapShape, RTree<LabelPosition *, double, 2, double> *candidates )
+QList<LabelPosition *> FeaturePart::createCandidates( const GEOSPreparedGeometry *mapBoundary, PointSet *mapShape )
 {
   QList<LabelPosition *> lPos;
   double angle = mLF->hasFixedAngle() ? mLF->fixedAngle() : 0.0;
 
-  if ( mLF->hasFixedPosition() )
+  if ( mLF->hasCachedPlacement() )
+  {
+    // reuse the placement of a previous render
+    const QgsLabelPlacementCache::Placement &placement = mLF->cachedPlacement();
+    lPos << new LabelPosition( 0, placement.x, placement.y, placement.width, placement.height, placement.angle, 0.0, this,
+                               placement.reversed, static_cast< LabelPosition::Quadrant >( placement.quadrant ) );
+  }
+  else if ( mLF->hasFixedPosition() )
   {
     lPos << new LabelPosition( 0, mLF->fixedPosition().x(), mLF->fixedPosition().y(), getLabelWidth(), getLabelHeight(), angle, 0.0, this );
   }
@@ -1674,13 +1679,8 @@ QList<LabelPosition *> FeaturePart::createCandidates( const GEOSPreparedGeometry
       i.remove();
       delete pos;
     }
-    else   // this one is OK
-    {
-      pos->insertIntoIndex( candidates );
-    }
   }
 
-  std::sort( lPos.begin(), lPos.end(), CostCalculator::candidateSortGrow );
   return lPos;
 }
 
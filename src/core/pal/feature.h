@@ -131,10 +131,11 @@ namespace pal
        * Generic method to generate label candidates for the feature.
        * \param mapBoundary map boundary geometry
        * \param mapShape generate candidates for this spatial entity
-       * \param candidates index for candidates
-       * \returns a list of generated candidates positions
+       * \returns a list of generated candidates positions, in the order they were generated.
+       * The candidates are neither sorted by cost nor inserted into a spatial index, which allows
+       * candidates for several features to be generated concurrently.
        */
-      QList<LabelPosition *> createCandidates( const GEOSPreparedGeometry *mapBoundary, PointSet *mapShape, RTree<LabelPosition *, double, 2, double> *candidates );
+      QList<LabelPosition *> createCandidates( const GEOSPreparedGeometry *mapBoundary, PointSet *mapShape );
 
       /**
        * Generate candidates for point feature, located around a specified point.
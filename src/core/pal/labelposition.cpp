@@ -246,6 +246,23 @@ bool LabelPosition::within( const GEOSPreparedGeometry *geometry )
   return true;
 }
 
+bool LabelPosition::isStrictlyInside( double xp, double yp ) const
+{
+  // the candidate is a (possibly rotated) rectangle, so the point is in its interior
+  // if it lies strictly on the same side of all four edges
+  int side = 0;
+  for ( int i = 0; i < 4; ++i )
+  {
+    const int j = ( i + 1 ) % 4;
+    const double cross = ( x[j] - x[i] ) * ( yp - y[i] ) - ( y[j] - y[i] ) * ( xp - x[i] );
+    const int edgeSide = cross > 0 ? 1 : ( cross < 0 ? -1 : 0 );
+    if ( edgeSide == 0 || ( side != 0 && edgeSide != side ) )
+      return false;
+    side = edgeSide;
+  }
+  return true;
+}
+
 bool LabelPosition::isInside( double *bbox )
 {
   for ( int i = 0; i < 4; i++ )
@@ -432,24 +449,15 @@ void LabelPosition::insertIntoIndex( RTree<LabelPosition *, double, 2, double> *
   index->Insert( amin, amax, this );
 }
 
-bool LabelPosition::pruneCallback( LabelPosition *candidatePosition, void *ctx )
+bool LabelPosition::ignoresObstacle( FeaturePart *obstacle ) const
 {
-  FeaturePart *obstaclePart = ( reinterpret_cast< PruneCtx * >( ctx ) )->obstacle;
-
   // test whether we should ignore this obstacle for the candidate. We do this if:
   // 1. it's not a hole, and the obstacle belongs to the same label feature as the candidate (e.g.,
   // features aren't obstacles for their own labels)
   // 2. it IS a hole, and the hole belongs to a different label feature to the candidate (e.g., holes
   // are ONLY obstacles for the labels of the feature they belong to)
-  if ( ( !obstaclePart->getHoleOf() && candidatePosition->feature->hasSameLabelFeatureAs( obstaclePart ) )
-       || ( obstaclePart->getHoleOf() && !candidatePosition->feature->hasSameLabelFeatureAs( dynamic_cast< FeaturePart * >( obstaclePart->getHoleOf() ) ) ) )
-  {
-    return true;
-  }
-
-  CostCalculator::addObstacleCostPenalty( candidatePosition, obstaclePart );
-
-  return true;
+  return ( !obstacle->getHoleOf() && feature->hasSameLabelFeatureAs( obstacle ) )
+         || ( obstacle->getHoleOf() && !feature->hasSameLabelFeatureAs( dynamic_cast< FeaturePart * >( obstacle->getHoleOf() ) ) );
 }
 
 bool LabelPosition::countOverlapCallback( LabelPosition *lp, void *ctx )
@@ -496,7 +504,7 @@ bool LabelPosition::removeOverlapCallback( LabelPosition *lp, void *ctx )
 double LabelPosition::getDistanceToPoint( double xp, double yp ) const
 {
   //first check if inside, if so then distance is -1
-  double distance = ( containsPoint( xp, yp ) ? -1
+  double distance = ( isStrictlyInside( xp, yp ) ? -1
                       : std::sqrt( minDistanceToPoint( xp, yp ) ) );
 
   if ( nextPart && distance > 0 )
@@ -130,6 +130,14 @@ namespace pal
        */
       bool isInside( double *bbox );
 
+      /**
+       * Returns TRUE if the point (\a xp, \a yp) lies in the interior of this part of the label.
+       *
+       * Unlike containsPoint() this does not use the prepared geometry, and is therefore
+       * safe to call while other threads test the candidate against obstacles.
+       */
+      bool isStrictlyInside( double xp, double yp ) const;
+
       /**
        * \brief Check whether or not this overlap with another labelPosition
        *
@@ -259,14 +267,11 @@ namespace pal
       void removeFromIndex( RTree<LabelPosition *, double, 2, double> *index );
       void insertIntoIndex( RTree<LabelPosition *, double, 2, double> *index );
 
-      typedef struct
-      {
-        Pal *pal = nullptr;
-        FeaturePart *obstacle = nullptr;
-      } PruneCtx;
-
-      //! Check whether the candidate in ctx overlap with obstacle feat
-      static bool pruneCallback( LabelPosition *candidatePosition, void *ctx );
+      /**
+       * Returns TRUE if \a obstacle must not be considered as an obstacle for this candidate,
+       * i.e. if it is part of the candidate's own label feature or a hole of a different feature.
+       */
+      bool ignoresObstacle( FeaturePart *obstacle ) const;
 
       // for counting number of overlaps
       typedef struct
@@ -42,6 +42,9 @@
 #include "internalexception.h"
 #include "util.h"
 #include <cfloat>
+#include <numeric>
+#include <QThread>
+#include <QtConcurrentMap>
 
 using namespace pal;
 
@@ -115,12 +118,8 @@ Layer *Pal::addLayer( QgsAbstractLabelProvider *provider, const QString &layerNa
 
 typedef struct _featCbackCtx
 {
-  Layer *layer = nullptr;
-  QLinkedList<Feats *> *fFeats;
+  std::vector< FeaturePart * > *featureParts;
   RTree<FeaturePart *, double, 2, double> *obstacles;
-  RTree<LabelPosition *, double, 2, double> *candidates;
-  QList<LabelPosition *> *positionsWithNoCandidates;
-  const GEOSPreparedGeometry *mapBoundary = nullptr;
 } FeatCallBackCtx;
 
 
@@ -147,25 +146,8 @@ bool extractFeatCallback( FeaturePart *ft_ptr, void *ctx )
     }
   }
 
-  // generate candidates for the feature part
-  const QList< LabelPosition * > lPos = ft_ptr->createCandidates( context->mapBoundary, ft_ptr, context->candidates );
-  if ( !lPos.empty() )
-  {
-    // valid features are added to fFeats
-    Feats *ft = new Feats();
-    ft->feature = ft_ptr;
-    ft->shape = nullptr;
-    ft->lPos = lPos;
-    ft->priority = ft_ptr->calculatePriority();
-    context->fFeats->append( ft );
-  }
-  else
-  {
-    // features with no candidates are recorded in the unlabeled feature list
-    std::unique_ptr< LabelPosition > unplacedPosition = ft_ptr->createCandidatePointOnSurface( ft_ptr );
-    if ( unplacedPosition )
-      context->positionsWithNoCandidates->append( unplacedPosition.release() );
-  }
+  // candidates are generated afterwards, for all extracted feature parts at once
+  context->featureParts->push_back( ft_ptr );
 
   return true;
 }
@@ -193,32 +175,87 @@ bool extractObstaclesCallback( FeaturePart *ft_ptr, void *ctx )
   return true;
 }
 
-typedef struct _filterContext
+//! Label candidates generated for a single feature part
+struct FeatureCandidates
 {
-  RTree<LabelPosition *, double, 2, double> *cdtsIndex;
-  Pal *pal = nullptr;
-} FilterContext;
+  FeaturePart *feature = nullptr;
+  //! Candidates in the order they were generated, which is the order they are indexed in
+  QList< LabelPosition * > generated;
+  //! Candidates sorted by ascending cost
+  QList< LabelPosition * > sorted;
+  //! Position for the unplaced label of a feature without any candidate
+  std::unique_ptr< LabelPosition > unplacedPosition;
+};
 
-bool filteringCallback( FeaturePart *featurePart, void *ctx )
+//! Penalties of the candidates colliding with an obstacle
+struct ObstaclePenalties
 {
+  FeaturePart *obstacle = nullptr;
+  //! Candidates with a non zero penalty, in the order they were found in the candidates index
+  std::vector< std::pair< LabelPosition *, int > > penalties;
+};
 
-  RTree<LabelPosition *, double, 2, double> *cdtsIndex = ( reinterpret_cast< FilterContext * >( ctx ) )->cdtsIndex;
-  Pal *pal = ( reinterpret_cast< FilterContext * >( ctx ) )->pal;
+bool collectObstaclesCallback( FeaturePart *featurePart, void *ctx )
+{
+  std::vector< ObstaclePenalties > *obstacles = reinterpret_cast< std::vector< ObstaclePenalties > * >( ctx );
+  obstacles->emplace_back();
+  obstacles->back().obstacle = featurePart;
+  return true;
+}
 
-  if ( pal->isCanceled() )
-    return false; // do not continue searching
+bool obstaclePenaltyCallback( LabelPosition *candidatePosition, void *ctx )
+{
+  ObstaclePenalties *obstacle = reinterpret_cast< ObstaclePenalties * >( ctx );
 
-  double amin[2], amax[2];
-  featurePart->getBoundingBox( amin, amax );
+  if ( candidatePosition->ignoresObstacle( obstacle->obstacle ) )
+    return true;
 
-  LabelPosition::PruneCtx pruneContext;
-  pruneContext.obstacle = featurePart;
-  pruneContext.pal = pal;
-  cdtsIndex->Search( amin, amax, LabelPosition::pruneCallback, static_cast< void * >( &pruneContext ) );
+  const int penalty = CostCalculator::obstacleCostPenalty( candidatePosition, obstacle->obstacle );
+  if ( penalty > 0 )
+    obstacle->penalties.emplace_back( candidatePosition, penalty );
 
   return true;
 }
 
+/*
+ * Splits the range [0, count) into chunks of at least minimumChunkSize items, with
+ * a few chunks per thread to balance the load.
+ */
+static QVector< QPair< int, int > > chunkRanges( int count, int minimumChunkSize )
+{
+  const int chunkSize = std::max( minimumChunkSize, count / ( 4 * std::max( 1, QThread::idealThreadCount() ) ) + 1 );
+  QVector< QPair< int, int > > ranges;
+  for ( int start = 0; start < count; start += chunkSize )
+    ranges << qMakePair( start, std::min( start + chunkSize, count ) );
+  return ranges;
+}
+
+/*
+ * Interleaves the bits of the candidate's center cell in the extent, so that sorting
+ * by this key keeps candidates which are close to each other together
+ */
+static quint32 spatialKey( const LabelPosition *lp, const double bbox[4] )
+{
+  double amin[2];
+  double amax[2];
+  lp->getBoundingBox( amin, amax );
+
+  const double width = bbox[2] - bbox[0];
+  const double height = bbox[3] - bbox[1];
+  const double fx = width > 0 ? ( ( amin[0] + amax[0] ) / 2 - bbox[0] ) / width : 0;
+  const double fy = height > 0 ? ( ( amin[1] + amax[1] ) / 2 - bbox[1] ) / height : 0;
+  const quint32 cellX = static_cast< quint32 >( qBound( 0.0, fx, 1.0 ) * 65535 );
+  const quint32 cellY = static_cast< quint32 >( qBound( 0.0, fy, 1.0 ) * 65535 );
+
+  quint32 key = 0;
+  for ( int bit = 0; bit < 16; ++bit )
+  {
+    key |= ( ( cellX >> bit ) & 1 ) << ( 2 * bit );
+    key |= ( ( cellY >> bit ) & 1 ) << ( 2 * bit + 1 );
+  }
+  return key;
+}
+
 std::unique_ptr<Problem> Pal::extract( const QgsRectangle &extent, const QgsGeometry &mapBoundary )
 {
   // to store obstacles
@@ -244,19 +281,17 @@ std::unique_ptr<Problem> Pal::extract( const QgsRectangle &extent, const QgsGeom
 
   prob->pal = this;
 
-  QLinkedList<Feats *> fFeats;
+  QVector<Feats *> fFeats;
+
+  // feature parts to label, in the order they are extracted from the layers
+  std::vector< FeaturePart * > featureParts;
 
   FeatCallBackCtx context;
+  context.featureParts = &featureParts;
+  context.obstacles = &obstacles;
 
   // prepare map boundary
   geos::unique_ptr mapBoundaryGeos( QgsGeos::asGeos( mapBoundary ) );
-  geos::prepared_unique_ptr mapBoundaryPrepared( GEOSPrepare_r( QgsGeos::getGEOSHandler(), mapBoundaryGeos.get() ) );
-
-  context.fFeats = &fFeats;
-  context.obstacles = &obstacles;
-  context.candidates = prob->candidates;
-  context.positionsWithNoCandidates = prob->positionsWithNoCandidates();
-  context.mapBoundary = mapBoundaryPrepared.get();
 
   ObstacleCallBackCtx obstacleContext;
   obstacleContext.obstacles = &obstacles;
@@ -264,10 +299,13 @@ std::unique_ptr<Problem> Pal::extract( const QgsRectangle &extent, const QgsGeom
 
   // first step : extract features from layers
 
-  int previousFeatureCount = 0;
-  int previousObstacleCount = 0;
-
-  QStringList layersWithFeaturesInBBox;
+  struct ExtractedLayer
+  {
+    QString name;
+    std::size_t featurePartsEnd;
+    bool hasObstacles;
+  };
+  QList< ExtractedLayer > extractedLayers;
 
   mMutex.lock();
   const auto constMLayers = mLayers;
@@ -291,22 +329,100 @@ std::unique_ptr<Problem> Pal::extract( const QgsRectangle &extent, const QgsGeom
 
     layer->mMutex.lock();
 
-    // find features within bounding box and generate candidates list
-    context.layer = layer;
+    // find features within bounding box
+    const int previousObstacleCount = obstacleContext.obstacleCount;
     layer->mFeatureIndex->Search( amin, amax, extractFeatCallback, static_cast< void * >( &context ) );
     // find obstacles within bounding box
     layer->mObstacleIndex->Search( amin, amax, extractObstaclesCallback, static_cast< void * >( &obstacleContext ) );
 
     layer->mMutex.unlock();
 
-    if ( context.fFeats->size() - previousFeatureCount > 0 || obstacleContext.obstacleCount > previousObstacleCount )
+    extractedLayers << ExtractedLayer { layer->name(), featureParts.size(), obstacleContext.obstacleCount > previousObstacleCount };
+  }
+  mMutex.unlock();
+
+  // generate the candidates of all feature parts concurrently. Each chunk of features uses its
+  // own prepared map boundary, as GEOS prepared geometries must not be shared between threads
+  std::vector< FeatureCandidates > featureCandidates( featureParts.size() );
+  for ( std::size_t k = 0; k < featureParts.size(); ++k )
+    featureCandidates[k].feature = featureParts[k];
+
+  QVector< QPair< int, int > > featureChunks = chunkRanges( static_cast< int >( featureCandidates.size() ), 16 );
+  QtConcurrent::blockingMap( featureChunks, [this, &featureCandidates, &mapBoundaryGeos]( const QPair< int, int > & chunk )
+  {
+    GEOSContextHandle_t geosctxt = QgsGeos::getGEOSHandler();
+    geos::prepared_unique_ptr mapBoundaryPrepared( GEOSPrepare_r( geosctxt, mapBoundaryGeos.get() ) );
+
+    for ( int k = chunk.first; k < chunk.second; ++k )
     {
-      layersWithFeaturesInBBox << layer->name();
+      if ( isCanceled() )
+        return;
+
+      FeatureCandidates &result = featureCandidates[k];
+      FeaturePart *feature = result.feature;
+      result.generated = feature->createCandidates( mapBoundaryPrepared.get(), feature );
+      if ( !result.generated.empty() )
+      {
+        result.sorted = result.generated;
+        std::sort( result.sorted.begin(), result.sorted.end(), CostCalculator::candidateSortGrow );
+      }
+      else
+      {
+        // features with no candidates are recorded in the unlabeled feature list
+        result.unplacedPosition = feature->createCandidatePointOnSurface( feature );
+      }
+
+      // geometries which are read by other threads later on have to be created upfront
+      feature->precomputeGeos();
+      for ( LabelPosition *candidate : qgis::as_const( result.generated ) )
+      {
+        for ( LabelPosition *part = candidate; part; part = part->getNextPart() )
+          part->precomputeGeos();
+      }
+    }
+  } );
+
+  if ( isCanceled() )
+  {
+    for ( FeatureCandidates &result : featureCandidates )
+      qDeleteAll( result.generated );
+    return nullptr;
+  }
+
+  // index the candidates and collect the valid features, in extraction order
+  QStringList layersWithFeaturesInBBox;
+  std::size_t featurePartIndex = 0;
+  for ( const ExtractedLayer &extractedLayer : qgis::as_const( extractedLayers ) )
+  {
+    bool hasFeatures = false;
+    for ( ; featurePartIndex < extractedLayer.featurePartsEnd; ++featurePartIndex )
+    {
+      FeatureCandidates &result = featureCandidates[featurePartIndex];
+      for ( LabelPosition *candidate : qgis::as_const( result.generated ) )
+        candidate->insertIntoIndex( prob->candidates );
+
+      if ( !result.sorted.empty() )
+      {
+        // valid features are added to fFeats
+        Feats *ft = new Feats();
+        ft->feature = result.feature;
+        ft->shape = nullptr;
+        ft->lPos = result.sorted;
+        ft->priority = result.feature->calculatePriority();
+        fFeats.append( ft );
+        hasFeatures = true;
+      }
+      else if ( result.unplacedPosition )
+      {
+        prob->positionsWithNoCandidates()->append( result.unplacedPosition.release() );
+      }
+    }
+
+    if ( hasFeatures || extractedLayer.hasObstacles )
+    {
+      layersWithFeaturesInBBox << extractedLayer.name;
     }
-    previousFeatureCount = context.fFeats->size();
-    previousObstacleCount = obstacleContext.obstacleCount;
   }
-  mMutex.unlock();
 
   prob->nbLabelledLayers = layersWithFeaturesInBBox.size();
   prob->labelledLayersName = layersWithFeaturesInBBox;
@@ -322,13 +438,28 @@ std::unique_ptr<Problem> Pal::extract( const QgsRectangle &extent, const QgsGeom
   {
     Feats *feat = nullptr;
 
-    // Filtering label positions against obstacles
+    // Filtering label positions against obstacles. The penalties are calculated concurrently
+    // for every obstacle, but applied in the order of the obstacles so that the costs are exactly
+    // the same as if they were calculated one after another
+    std::vector< ObstaclePenalties > obstaclePenalties;
     amin[0] = amin[1] = std::numeric_limits<double>::lowest();
     amax[0] = amax[1] = std::numeric_limits<double>::max();
-    FilterContext filterCtx;
-    filterCtx.cdtsIndex = prob->candidates;
-    filterCtx.pal = this;
-    obstacles.Search( amin, amax, filteringCallback, static_cast< void * >( &filterCtx ) );
+    obstacles.Search( amin, amax, collectObstaclesCallback, static_cast< void * >( &obstaclePenalties ) );
+
+    RTree<LabelPosition *, double, 2, double> *candidatesIndex = prob->candidates;
+    QtConcurrent::blockingMap( obstaclePenalties, [this, candidatesIndex]( ObstaclePenalties & obstacle )
+    {
+      if ( isCanceled() )
+        return;
+
+      // the obstacle geometry is read by other threads when polygon candidate costs are calculated
+      obstacle.obstacle->precomputeGeos();
+
+      double obstacleMin[2];
+      double obstacleMax[2];
+      obstacle.obstacle->getBoundingBox( obstacleMin, obstacleMax );
+      candidatesIndex->Search( obstacleMin, obstacleMax, obstaclePenaltyCallback, static_cast< void * >( &obstacle ) );
+    } );
 
     if ( isCanceled() )
     {
@@ -342,29 +473,45 @@ std::unique_ptr<Problem> Pal::extract( const QgsRectangle &extent, const QgsGeom
       return nullptr;
     }
 
-    int idlp = 0;
-    for ( i = 0; i < prob->nbft; i++ ) /* foreach feature into prob */
+    for ( const ObstaclePenalties &obstacle : obstaclePenalties )
     {
-      feat = fFeats.takeFirst();
-
-      prob->featStartId[i] = idlp;
-      prob->inactiveCost[i] = std::pow( 2, 10 - 10 * feat->priority );
+      for ( const std::pair< LabelPosition *, int > &penalty : obstacle.penalties )
+        CostCalculator::applyObstacleCostPenalty( penalty.first, obstacle.obstacle, penalty.second );
+    }
 
-      switch ( feat->feature->getGeosType() )
+    // sort candidates by cost, skip less interesting ones, calculate polygon costs (if using polygons)
+    QVector< int > maxCandidates( prob->nbft );
+    QVector< int > featureIndexes( prob->nbft );
+    std::iota( featureIndexes.begin(), featureIndexes.end(), 0 );
+    QtConcurrent::blockingMap( featureIndexes, [this, &fFeats, &maxCandidates, &obstacles, &bbx, &bby]( int featureIndex )
+    {
+      Feats *featureFeats = fFeats.at( featureIndex );
+      int maxCandidateCount = 0;
+      switch ( featureFeats->feature->getGeosType() )
       {
         case GEOS_POINT:
-          max_p = point_p;
+          maxCandidateCount = point_p;
           break;
         case GEOS_LINESTRING:
-          max_p = line_p;
+          maxCandidateCount = line_p;
           break;
         case GEOS_POLYGON:
-          max_p = poly_p;
+          maxCandidateCount = poly_p;
           break;
       }
 
-      // sort candidates by cost, skip less interesting ones, calculate polygon costs (if using polygons)
-      max_p = CostCalculator::finalizeCandidatesCosts( feat, max_p, &obstacles, bbx, bby );
+      maxCandidates[featureIndex] = CostCalculator::finalizeCandidatesCosts( featureFeats, maxCandidateCount, &obstacles, bbx, bby );
+    } );
+
+    int idlp = 0;
+    for ( i = 0; i < prob->nbft; i++ ) /* foreach feature into prob */
+    {
+      feat = fFeats.at( i );
+
+      prob->featStartId[i] = idlp;
+      prob->inactiveCost[i] = std::pow( 2, 10 - 10 * feat->priority );
+
+      max_p = maxCandidates.at( i );
 
       // only keep the 'max_p' best candidates
       while ( feat->lPos.count() > max_p )
@@ -385,29 +532,16 @@ std::unique_ptr<Problem> Pal::extract( const QgsRectangle &extent, const QgsGeom
         //lp->insertIntoIndex(prob->candidates);
         lp->setProblemIds( i, idlp ); // bugfix #1 (maxence 10/23/2008)
       }
-      fFeats.append( feat );
     }
 
-    int nbOverlaps = 0;
-
-    while ( !fFeats.isEmpty() ) // foreach feature
+    QVector< LabelPosition * > candidates;
+    candidates.reserve( prob->nblp );
+    for ( i = 0; i < prob->nbft; i++ ) // foreach feature
     {
-      if ( isCanceled() )
-      {
-        for ( Feats *feat : qgis::as_const( fFeats ) )
-        {
-          qDeleteAll( feat->lPos );
-          feat->lPos.clear();
-        }
-
-        qDeleteAll( fFeats );
-        return nullptr;
-      }
-
-      feat = fFeats.takeFirst();
-      while ( !feat->lPos.isEmpty() ) // foreach label candidate
+      feat = fFeats.at( i );
+      for ( j = 0; j < feat->lPos.count(); j++ ) // foreach label candidate
       {
-        lp = feat->lPos.takeFirst();
+        lp = feat->lPos.at( j );
         lp->resetNumOverlaps();
 
         // make sure that candidate's cost is less than 1
@@ -415,16 +549,46 @@ std::unique_ptr<Problem> Pal::extract( const QgsRectangle &extent, const QgsGeom
 
         prob->addCandidatePosition( lp );
         //prob->feat[idlp] = j;
-
-        lp->getBoundingBox( amin, amax );
-
-        // lookup for overlapping candidate
-        prob->candidates->Search( amin, amax, LabelPosition::countOverlapCallback, static_cast< void * >( lp ) );
-
-        nbOverlaps += lp->getNumOverlaps();
+        candidates << lp;
       }
       delete feat;
     }
+    fFeats.clear();
+
+    // lookup for overlapping candidates. Every candidate only counts its own overlaps, so candidates
+    // can be checked concurrently. Chunks of nearby candidates are processed together, so that every
+    // chunk only searches a small part of the index
+    std::vector< std::pair< quint32, LabelPosition * > > spatialOrder;
+    spatialOrder.reserve( candidates.size() );
+    for ( LabelPosition *candidate : qgis::as_const( candidates ) )
+      spatialOrder.emplace_back( spatialKey( candidate, prob->bbox ), candidate );
+    std::stable_sort( spatialOrder.begin(), spatialOrder.end(), []( const std::pair< quint32, LabelPosition * > & a, const std::pair< quint32, LabelPosition * > & b )
+    {
+      return a.first < b.first;
+    } );
+
+    QVector< QPair< int, int > > candidateChunks = chunkRanges( static_cast< int >( spatialOrder.size() ), 64 );
+    QtConcurrent::blockingMap( candidateChunks, [this, &spatialOrder, candidatesIndex]( const QPair< int, int > & chunk )
+    {
+      double candidateMin[2];
+      double candidateMax[2];
+      for ( int k = chunk.first; k < chunk.second; ++k )
+      {
+        if ( isCanceled() )
+          return;
+
+        LabelPosition *candidate = spatialOrder[k].second;
+        candidate->getBoundingBox( candidateMin, candidateMax );
+        candidatesIndex->Search( candidateMin, candidateMax, LabelPosition::countOverlapCallback, static_cast< void * >( candidate ) );
+      }
+    } );
+
+    if ( isCanceled() )
+      return nullptr;
+
+    int nbOverlaps = 0;
+    for ( const LabelPosition *candidate : qgis::as_const( candidates ) )
+      nbOverlaps += candidate->getNumOverlaps();
     nbOverlaps /= 2;
     prob->all_nblp = prob->nblp;
     prob->nbOverlap = nbOverlaps;
@@ -453,7 +617,9 @@ QList<LabelPosition *> Pal::solveProblem( Problem *prob, bool displayAll, QList<
 
   try
   {
-    if ( searchMethod == FALP )
+    if ( mSplitComponents )
+      prob->componentSearch();
+    else if ( searchMethod == FALP )
       prob->init_sol_falp();
     else if ( searchMethod == CHAIN )
       prob->chain_search();
@@ -169,6 +169,37 @@ namespace pal
        */
       bool getShowPartial();
 
+      /**
+       * Sets whether the problem is split into the independent groups of conflicting
+       * labels, which are solved separately and in parallel.
+       * \see splitComponents()
+       * \since QGIS 3.10
+       */
+      void setSplitComponents( bool split ) { mSplitComponents = split; }
+
+      /**
+       * Returns whether the problem is split into independent groups of conflicting labels.
+       * \see setSplitComponents()
+       * \since QGIS 3.10
+       */
+      bool splitComponents() const { return mSplitComponents; }
+
+      /**
+       * Sets the maximum total number of candidates of the group solutions which are kept
+       * for reuse by later renders. A \a size of 0 disables the reuse.
+       * \see componentSolutionCacheSize()
+       * \since QGIS 3.10
+       */
+      void setComponentSolutionCacheSize( int size ) { mComponentSolutionCacheSize = size; }
+
+      /**
+       * Returns the maximum total number of candidates of the group solutions which are
+       * kept for reuse by later renders, or 0 if solutions are not reused.
+       * \see setComponentSolutionCacheSize()
+       * \since QGIS 3.10
+       */
+      int componentSolutionCacheSize() const { return mComponentSolutionCacheSize; }
+
       /**
        * \brief set # candidates to generate for points features
        * Higher the value is, longer Pal::labeller will spend time
@@ -263,6 +294,11 @@ namespace pal
        */
       bool showPartial;
 
+      //! Whether independent groups of conflicting labels are solved separately
+      bool mSplitComponents = false;
+      //! Maximum number of candidates of the cached group solutions, 0 disables the cache
+      int mComponentSolutionCacheSize = 0;
+
       //! Callback that may be called from PAL to check whether the job has not been canceled in meanwhile
       FnIsCanceled fnIsCanceled;
       //! Application-specific context for the cancellation check function
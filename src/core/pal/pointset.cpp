@@ -905,6 +905,26 @@ const GEOSGeometry *PointSet::geos() const
   return mGeos;
 }
 
+void PointSet::precomputeGeos() const
+{
+  if ( !mGeos )
+    createGeosGeom();
+
+  if ( !mGeos )
+    return;
+
+  // GEOS computes and caches the envelope of a geometry on first use
+  GEOSContextHandle_t geosctxt = QgsGeos::getGEOSHandler();
+  try
+  {
+    geos::unique_ptr envelope( GEOSEnvelope_r( geosctxt, mGeos ) );
+  }
+  catch ( GEOSException &e )
+  {
+    QgsMessageLog::logMessage( QObject::tr( "Exception: %1" ).arg( e.what() ), QObject::tr( "GEOS" ) );
+  }
+}
+
 double PointSet::length() const
 {
   if ( !mGeos )
@@ -168,6 +168,16 @@ namespace pal
       */
       const GEOSGeometry *geos() const;
 
+      /**
+       * Creates the point set's GEOS geometry and computes its envelope, unless this was
+       * already done.
+       *
+       * Both are otherwise created lazily on first use, so this must be called before the
+       * geometry is read concurrently from several threads. The prepared geometry is not
+       * created, as it must only ever be used by a single thread at a time.
+       */
+      void precomputeGeos() const;
+
       /**
        * Returns length of line geometry.
        */
@@ -40,6 +40,11 @@
 #include "internalexception.h"
 #include <cfloat>
 #include <limits> //for std::numeric_limits<int>::max()
+#include <numeric>
+
+#include <QCache>
+#include <QMutex>
+#include <QtConcurrentMap>
 
 #include "qgslabelingengine.h"
 
@@ -2213,6 +2218,316 @@ void Problem::chain_search()
   delete[] ok;
 }
 
+typedef struct _conflictContext
+{
+  LabelPosition *lp = nullptr;
+  std::vector< std::pair< int, int > > *conflicts = nullptr;
+} ConflictContext;
+
+bool conflictCallback( LabelPosition *lp, void *context )
+{
+  ConflictContext *ctx = reinterpret_cast< ConflictContext * >( context );
+  LabelPosition *lp2 = ctx->lp;
+
+  // every pair of features only needs to be tested once
+  if ( lp->getProblemFeatureId() > lp2->getProblemFeatureId() && lp2->isInConflict( lp ) )
+  {
+    ctx->conflicts->emplace_back( lp2->getProblemFeatureId(), lp->getProblemFeatureId() );
+  }
+
+  return true;
+}
+
+//! Features with conflicting candidates, found by a chunk of features
+struct ConflictChunk
+{
+  int firstFeature;
+  int lastFeature;
+  std::vector< std::pair< int, int > > conflicts;
+};
+
+/*
+ * Recently solved components, keyed by everything the search depends on. The cost
+ * of an entry is its number of candidates, the maximum cost is set from the engine
+ * settings (QgsLabelingEngineSettings::componentSolutionCacheSize()).
+ */
+struct CachedComponentSolution
+{
+  QVector< int > solution;
+  double cost;
+  int nbActive;
+};
+
+typedef QCache< QVector< double >, CachedComponentSolution > ComponentSolutionCache;
+
+static QMutex *componentSolutionCacheMutex()
+{
+  static QMutex mutex;
+  return &mutex;
+}
+
+static ComponentSolutionCache *componentSolutionCache()
+{
+  static ComponentSolutionCache cache;
+  return &cache;
+}
+
+void Problem::clearComponentSolutionCache()
+{
+  QMutexLocker locker( componentSolutionCacheMutex() );
+  componentSolutionCache()->clear();
+}
+
+std::vector< Problem::Component > Problem::conflictComponents()
+{
+  // find the pairs of features with conflicting candidates, for chunks of features in parallel.
+  // A candidate's prepared geometry is only used by the chunk of its own feature
+  std::vector< ConflictChunk > chunks;
+  const int chunkSize = 64;
+  for ( int first = 0; first < nbft; first += chunkSize )
+  {
+    chunks.emplace_back();
+    chunks.back().firstFeature = first;
+    chunks.back().lastFeature = std::min( first + chunkSize, nbft );
+  }
+
+  QtConcurrent::blockingMap( chunks, [this]( ConflictChunk & chunk )
+  {
+    ConflictContext context;
+    context.conflicts = &chunk.conflicts;
+    double amin[2];
+    double amax[2];
+    for ( int i = chunk.firstFeature; i < chunk.lastFeature; i++ )
+    {
+      if ( pal->isCanceled() )
+        return;
+
+      for ( int j = featStartId[i]; j < featStartId[i] + featNbLp[i]; j++ )
+      {
+        context.lp = mLabelPositions.at( j );
+        context.lp->getBoundingBox( amin, amax );
+        candidates->Search( amin, amax, conflictCallback, reinterpret_cast< void * >( &context ) );
+      }
+    }
+  } );
+
+  // union-find over the conflicting pairs
+  QVector< int > parent( nbft );
+  std::iota( parent.begin(), parent.end(), 0 );
+  auto root = [&parent]( int feat ) -> int
+  {
+    while ( parent[feat] != feat )
+    {
+      parent[feat] = parent[parent[feat]];
+      feat = parent[feat];
+    }
+    return feat;
+  };
+
+  for ( const ConflictChunk &chunk : chunks )
+  {
+    for ( const std::pair< int, int > &conflict : chunk.conflicts )
+    {
+      const int root1 = root( conflict.first );
+      const int root2 = root( conflict.second );
+      if ( root1 != root2 )
+        parent[std::max( root1, root2 )] = std::min( root1, root2 );
+    }
+  }
+
+  // components are ordered by their first feature
+  std::vector< Component > components;
+  QVector< int > componentIndex( nbft, -1 );
+  for ( int i = 0; i < nbft; i++ )
+  {
+    const int featRoot = root( i );
+    if ( componentIndex[featRoot] == -1 )
+    {
+      componentIndex[featRoot] = static_cast< int >( components.size() );
+      components.emplace_back();
+    }
+    components[componentIndex[featRoot]].features << i;
+  }
+
+  return components;
+}
+
+QVector< double > Problem::searchSignature() const
+{
+  QVector< double > signature;
+  signature.reserve( 8 + 2 * nbft + 8 * nblp );
+  signature << pal->searchMethod << pal->ejChainDeg << pal->tenure << pal->candListSize
+            << pal->tabuMinIt << pal->tabuMaxIt << pal->popmusic_r << displayAll;
+
+  for ( int i = 0; i < nbft; i++ )
+  {
+    signature << featNbLp[i] << inactiveCost[i];
+    for ( int j = featStartId[i]; j < featStartId[i] + featNbLp[i]; j++ )
+    {
+      const LabelPosition *lp = mLabelPositions.at( j );
+      signature << lp->cost() << lp->getNumOverlaps();
+      for ( const LabelPosition *part = lp; part; part = part->getNextPart() )
+      {
+        signature << part->getX() << part->getY() << part->getWidth() << part->getHeight() << part->getAlpha();
+      }
+      // separates the parts of consecutive candidates
+      signature << std::numeric_limits< double >::infinity();
+    }
+  }
+  return signature;
+}
+
+void Problem::solveComponent( Component &component )
+{
+  const int componentNbFt = component.features.size();
+  component.solution = QVector< int >( componentNbFt, -1 );
+
+  if ( pal->isCanceled() )
+    return;
+
+  // a feature without any conflict keeps its best candidate, which is the only one left after reduce()
+  if ( componentNbFt == 1 && featNbLp[component.features.at( 0 )] == 1 )
+  {
+    component.solution[0] = 0;
+    component.cost = mLabelPositions.at( featStartId[component.features.at( 0 )] )->cost();
+    component.nbActive = 1;
+    return;
+  }
+
+  // the component is solved as a problem of its own, which borrows the candidates of this problem
+  Problem componentProblem;
+  componentProblem.pal = pal;
+  componentProblem.displayAll = displayAll;
+  std::copy( bbox, bbox + 4, componentProblem.bbox );
+  componentProblem.nbft = componentNbFt;
+  componentProblem.featStartId = new int[componentNbFt];
+  componentProblem.featNbLp = new int[componentNbFt];
+  componentProblem.inactiveCost = new double[componentNbFt];
+
+  int lpId = 0;
+  for ( int i = 0; i < componentNbFt; i++ )
+  {
+    const int feat = component.features.at( i );
+    componentProblem.featStartId[i] = lpId;
+    componentProblem.featNbLp[i] = featNbLp[feat];
+    componentProblem.inactiveCost[i] = inactiveCost[feat];
+    for ( int j = 0; j < featNbLp[feat]; j++, lpId++ )
+    {
+      LabelPosition *lp = mLabelPositions.at( featStartId[feat] + j );
+      lp->setProblemIds( i, lpId );
+      lp->insertIntoIndex( componentProblem.candidates );
+      componentProblem.mLabelPositions << lp;
+    }
+  }
+  componentProblem.nblp = lpId;
+  componentProblem.all_nblp = lpId;
+
+  const int cacheSize = pal->componentSolutionCacheSize();
+  const QVector< double > signature = cacheSize > 0 ? componentProblem.searchSignature() : QVector< double >();
+  bool found = false;
+  if ( cacheSize > 0 )
+  {
+    QMutexLocker locker( componentSolutionCacheMutex() );
+    if ( componentSolutionCache()->maxCost() != cacheSize )
+      componentSolutionCache()->setMaxCost( cacheSize );
+    if ( const CachedComponentSolution *cached = componentSolutionCache()->object( signature ) )
+    {
+      component.solution = cached->solution;
+      component.cost = cached->cost;
+      component.nbActive = cached->nbActive;
+      found = true;
+    }
+  }
+
+  if ( !found )
+  {
+    try
+    {
+      if ( pal->searchMethod == FALP )
+        componentProblem.init_sol_falp();
+      else if ( pal->searchMethod == CHAIN )
+        componentProblem.chain_search();
+      else
+        componentProblem.popmusic();
+
+      if ( componentProblem.sol )
+      {
+        for ( int i = 0; i < componentNbFt; i++ )
+        {
+          const int lid = componentProblem.sol->s[i];
+          component.solution[i] = lid == -1 ? -1 : lid - componentProblem.featStartId[i];
+        }
+        component.cost = componentProblem.sol->cost;
+        component.nbActive = componentProblem.nbActive;
+
+        // a canceled search may have been stopped before the best solution was found
+        if ( cacheSize > 0 && !pal->isCanceled() )
+        {
+          QMutexLocker locker( componentSolutionCacheMutex() );
+          componentSolutionCache()->insert( signature, new CachedComponentSolution { component.solution, component.cost, component.nbActive }, std::max( lpId, 1 ) );
+        }
+      }
+    }
+    catch ( InternalException::Empty & )
+    {
+      component.empty = true;
+    }
+  }
+
+  // restore the ids of the candidates in this problem, which still owns them
+  for ( int i = 0; i < componentNbFt; i++ )
+  {
+    const int feat = component.features.at( i );
+    for ( int j = 0; j < featNbLp[feat]; j++ )
+      mLabelPositions.at( featStartId[feat] + j )->setProblemIds( feat, featStartId[feat] + j );
+  }
+  componentProblem.mLabelPositions.clear();
+}
+
+void Problem::componentSearch()
+{
+  init_sol_empty();
+  nbActive = 0;
+
+  if ( nbft == 0 )
+    return;
+
+  std::vector< Component > components = conflictComponents();
+
+  // larger components take longer to solve, start them first
+  std::vector< Component * > bySize;
+  bySize.reserve( components.size() );
+  for ( Component &component : components )
+    bySize.push_back( &component );
+  std::stable_sort( bySize.begin(), bySize.end(), []( const Component * c1, const Component * c2 )
+  {
+    return c1->features.size() > c2->features.size();
+  } );
+
+  QtConcurrent::blockingMap( bySize, [this]( Component * component )
+  {
+    solveComponent( *component );
+  } );
+
+  sol->cost = 0.0;
+  for ( const Component &component : components )
+  {
+    if ( component.empty )
+      throw InternalException::Empty();
+
+    for ( int i = 0; i < component.features.size(); i++ )
+    {
+      const int feat = component.features.at( i );
+      const int candidate = component.solution.at( i );
+      sol->s[feat] = candidate == -1 ? -1 : featStartId[feat] + candidate;
+      if ( candidate != -1 )
+        mLabelPositions.at( sol->s[feat] )->insertIntoIndex( candidates_sol );
+    }
+    sol->cost += component.cost;
+    nbActive += component.nbActive;
+  }
+}
+
 bool Problem::compareLabelArea( pal::LabelPosition *l1, pal::LabelPosition *l2 )
 {
   return l1->getWidth() * l1->getHeight() > l2->getWidth() * l2->getHeight();
@@ -35,7 +35,9 @@
 
 #include "qgis_core.h"
 #include <list>
+#include <vector>
 #include <QList>
+#include <QVector>
 #include "rtree.hpp"
 
 namespace pal
@@ -150,6 +152,27 @@ namespace pal
        */
       void chain_search();
 
+      /**
+       * Solves the problem with the search method of the pal object, after splitting it into
+       * the connected components of its conflict graph, i.e. groups of features whose
+       * candidates only conflict with candidates of the same group.
+       *
+       * The components are independent from each other and are solved in parallel. If the
+       * pal object has a component solution cache size, the solution of a component which is
+       * identical to a recently solved one (e.g. after the map was panned or another layer was
+       * refreshed) is reused instead of searched again.
+       *
+       * \throws InternalException::Empty if a component could not be solved
+       * \since QGIS 3.10
+       */
+      void componentSearch();
+
+      /**
+       * Clears the solutions of recently solved components which are reused by componentSearch().
+       * \since QGIS 3.10
+       */
+      static void clearComponentSolutionCache();
+
       /**
        * Solves the labeling problem, selecting the best candidate locations for all labels and returns a list of these
        * calculated label positions.
@@ -274,6 +297,28 @@ namespace pal
 
       Chain *chain( int seed );
 
+      //! A connected component of the conflict graph and its solution
+      struct Component
+      {
+        //! Features of the component, in ascending order
+        QVector< int > features;
+        //! Retained candidate of each feature, as index in the candidates of the feature, or -1 if the feature is not labeled
+        QVector< int > solution;
+        double cost = 0.0;
+        int nbActive = 0;
+        //! TRUE if the search for the component failed
+        bool empty = false;
+      };
+
+      //! Splits the features into the connected components of the conflict graph
+      std::vector< Component > conflictComponents();
+
+      //! Searches the solution of a \a component, or reuses a cached one
+      void solveComponent( Component &component );
+
+      //! Returns everything the search for a solution depends on, used as key for cached solutions
+      QVector< double > searchSignature() const;
+
       Pal *pal = nullptr;
 
       void solution_cost();
@@ -2594,6 +2594,95 @@ QgsRasterBandStats QgsGdalProvider::bandStatistics( int bandNo, int stats, const
 
 } // QgsGdalProvider::bandStatistics
 
+QgsRasterStatisticsSketch QgsGdalProvider::statisticsSketch( int bandNo, const QgsRectangle &boundingBox, int sampleSize, QgsRasterBlockFeedback *feedback )
+{
+  QMutexLocker locker( mpMutex );
+  if ( !initIfNeeded() )
+    return QgsRasterStatisticsSketch();
+
+  QgsRasterBandStats myRasterBandStats;
+  initStatistics( myRasterBandStats, bandNo, QgsRasterBandStats::All, boundingBox, sampleSize );
+
+  const auto constSketches = mStatisticsSketches;
+  for ( const QPair< QgsRasterBandStats, QgsRasterStatisticsSketch > &sketch : constSketches )
+  {
+    if ( sketch.first.contains( myRasterBandStats ) )
+    {
+      QgsDebugMsgLevel( QStringLiteral( "Using cached statistics sketch." ), 4 );
+      return sketch.second;
+    }
+  }
+
+  // Sketches of the whole extent with the source no data values can be persisted with the
+  // dataset as band metadata, which GDAL stores e.g. in the .aux.xml file. The key
+  // contains the size of the sample, sketches of samples read from overviews are
+  // stored next to the full resolution one.
+  GDALRasterBandH myGdalBand = nullptr;
+  if ( myRasterBandStats.extent == extent() &&
+       !( sourceHasNoDataValue( bandNo ) && !useSourceNoDataValue( bandNo ) ) &&
+       userNoDataValues( bandNo ).isEmpty() )
+  {
+    myGdalBand = getBand( bandNo );
+  }
+
+  if ( myGdalBand )
+  {
+    // use the most detailed persisted sketch with at least the requested resolution,
+    // so that a quick estimate can use a full resolution sketch as well
+    const QRegularExpression keyRegExp( QStringLiteral( "^STATISTICS_SKETCH_(\\d+)_(\\d+)=" ) );
+    const QStringList metadata = QgsOgrUtils::cStringListToQStringList( GDALGetMetadata( myGdalBand, "QGIS" ) );
+    QString bestSketch;
+    qgssize bestSize = 0;
+    for ( const QString &item : metadata )
+    {
+      const QRegularExpressionMatch match = keyRegExp.match( item );
+      if ( !match.hasMatch() )
+        continue;
+
+      const int width = match.captured( 1 ).toInt();
+      const int height = match.captured( 2 ).toInt();
+      const qgssize size = static_cast< qgssize >( width ) * height;
+      if ( width >= myRasterBandStats.width && height >= myRasterBandStats.height && size > bestSize )
+      {
+        bestSize = size;
+        bestSketch = item.mid( match.capturedLength() );
+      }
+    }
+
+    bool ok = false;
+    const QgsRasterStatisticsSketch sketch = QgsRasterStatisticsSketch::fromString( bestSketch, &ok );
+    if ( ok )
+    {
+      QgsDebugMsgLevel( QStringLiteral( "Using persisted statistics sketch." ), 4 );
+      mStatisticsSketches.append( qMakePair( myRasterBandStats, sketch ) );
+      return sketch;
+    }
+  }
+
+  const QgsRasterStatisticsSketch sketch = QgsRasterDataProvider::statisticsSketch( bandNo, boundingBox, sampleSize, feedback );
+
+  if ( myGdalBand && sketch.count() > 0 && !( feedback && feedback->isCanceled() ) )
+  {
+    // sketches are only added to an existing auxiliary file, a new one is only created
+    // for full resolution sketches if the user opted in
+    const bool pamFileExists = QFileInfo::exists( dataSourceUri( true ) + QLatin1String( ".aux.xml" ) );
+    const bool fullResolution = myRasterBandStats.width == xSize() && myRasterBandStats.height == ySize();
+    const bool createPamFile = !pamFileExists && fullResolution &&
+                               QgsSettings().value( QStringLiteral( "/Raster/persistStatisticsSketches" ), false ).toBool();
+    if ( pamFileExists || createPamFile )
+    {
+      const QString key = QStringLiteral( "STATISTICS_SKETCH_%1_%2" ).arg( myRasterBandStats.width ).arg( myRasterBandStats.height );
+      if ( GDALSetMetadataItem( myGdalBand, key.toUtf8().constData(), sketch.toString().toUtf8().constData(), "QGIS" ) == CE_None && createPamFile )
+      {
+        // keep the auxiliary file GDAL writes when closing the dataset
+        mStatisticsAreReliable = true;
+      }
+    }
+  }
+
+  return sketch;
+}
+
 bool QgsGdalProvider::initIfNeeded()
 {
   if ( mHasInit )
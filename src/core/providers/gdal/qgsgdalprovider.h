@@ -167,6 +167,10 @@ class QgsGdalProvider : public QgsRasterDataProvider, QgsGdalProviderBase
                                        const QgsRectangle &boundingBox = QgsRectangle(),
                                        int sampleSize = 0, QgsRasterBlockFeedback *feedback = nullptr ) override;
 
+    QgsRasterStatisticsSketch statisticsSketch( int bandNo,
+        const QgsRectangle &boundingBox = QgsRectangle(),
+        int sampleSize = 0, QgsRasterBlockFeedback *feedback = nullptr ) override;
+
     bool hasHistogram( int bandNo,
                        int binCount = 0,
                        double minimum = std::numeric_limits<double>::quiet_NaN(),
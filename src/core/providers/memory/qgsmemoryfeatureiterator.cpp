@@ -50,6 +50,31 @@ QgsMemoryFeatureIterator::QgsMemoryFeatureIterator( QgsMemoryFeatureSource *sour
     mSubsetExpression->prepare( &mSource->mExpressionContext );
   }
 
+  // features are materialized from the store, so only create what was asked for
+  mFetchGeometry = !( mRequest.flags() & QgsFeatureRequest::NoGeometry );
+  mFetchAllAttributes = !( mRequest.flags() & QgsFeatureRequest::SubsetOfAttributes );
+  if ( !mFetchAllAttributes )
+  {
+    mFetchAttributes = mRequest.subsetOfAttributes();
+
+    // also fetch the attributes required by the subset string, filter expression and order by
+    if ( mSubsetExpression )
+      addExpressionAttributes( *mSubsetExpression );
+    if ( mRequest.filterType() == QgsFeatureRequest::FilterExpression && mRequest.filterExpression() )
+      addExpressionAttributes( *mRequest.filterExpression() );
+    const auto usedAttributeIndices = mRequest.orderBy().usedAttributeIndices( mSource->mFields );
+    for ( int attrIndex : usedAttributeIndices )
+    {
+      if ( !mFetchAttributes.contains( attrIndex ) )
+        mFetchAttributes << attrIndex;
+    }
+  }
+  if ( ( mSubsetExpression && mSubsetExpression->needsGeometry() )
+       || ( mRequest.filterType() == QgsFeatureRequest::FilterExpression && mRequest.filterExpression() && mRequest.filterExpression()->needsGeometry() ) )
+  {
+    mFetchGeometry = true;
+  }
+
   if ( !mFilterRect.isNull() && mRequest.flags() & QgsFeatureRequest::ExactIntersect )
   {
     mSelectRectGeom = QgsGeometry::fromRect( mFilterRect );
@@ -68,8 +93,7 @@ QgsMemoryFeatureIterator::QgsMemoryFeatureIterator( QgsMemoryFeatureSource *sour
   else if ( mRequest.filterType() == QgsFeatureRequest::FilterFid )
   {
     mUsingFeatureIdList = true;
-    QgsFeatureMap::const_iterator it = mSource->mFeatures.constFind( mRequest.filterFid() );
-    if ( it != mSource->mFeatures.constEnd() )
+    if ( mSource->mFeatures.contains( mRequest.filterFid() ) )
       mFeatureIdList.append( mRequest.filterFid() );
   }
   else if ( mRequest.filterType() == QgsFeatureRequest::FilterFids )
@@ -106,122 +130,118 @@ bool QgsMemoryFeatureIterator::fetchFeature( QgsFeature &feature )
 
 bool QgsMemoryFeatureIterator::nextFeatureUsingList( QgsFeature &feature )
 {
-  bool hasFeature = false;
-
   // option 1: we have a list of features to traverse
-  QgsFeature candidate;
   while ( mFeatureIdListIterator != mFeatureIdList.constEnd() )
   {
-    candidate = mSource->mFeatures.value( *mFeatureIdListIterator );
-    if ( !mFilterRect.isNull() )
-    {
-      if ( mRequest.flags() & QgsFeatureRequest::ExactIntersect )
-      {
-        // do exact check in case we're doing intersection
-        if ( candidate.hasGeometry() && mSelectRectEngine->intersects( candidate.geometry().constGet() ) )
-          hasFeature = true;
-      }
-      else if ( mSource->mSpatialIndex )
-      {
-        // using a spatial index - so we already know that the bounding box intersects correctly
-        hasFeature = true;
-      }
-      else
-      {
-        // do bounding box check if we aren't using a spatial index
-        if ( candidate.hasGeometry() && candidate.geometry().boundingBoxIntersects( mFilterRect ) )
-          hasFeature = true;
-      }
-    }
-    else
-      hasFeature = true;
+    const QgsFeatureId id = *mFeatureIdListIterator;
+    ++mFeatureIdListIterator;
 
-    if ( hasFeature && mSubsetExpression )
+    if ( fetchCandidate( id, feature ) )
     {
-      mSource->mExpressionContext.setFeature( candidate );
-      if ( !mSubsetExpression->evaluate( &mSource->mExpressionContext ).toBool() )
-        hasFeature = false;
+      geometryToDestinationCrs( feature, mTransform );
+      return true;
     }
+  }
 
-    if ( hasFeature )
-      break;
+  feature.setValid( false );
+  close();
+  return false;
+}
 
-    ++mFeatureIdListIterator;
-  }
 
-  // copy feature
-  if ( hasFeature )
+bool QgsMemoryFeatureIterator::nextFeatureTraverseAll( QgsFeature &feature )
+{
+  // option 2: traversing the whole layer
+  const QgsFeatureId end = mSource->mFeatures.nextFeatureId();
+  while ( mSelectIterator < end )
   {
-    feature = candidate;
-    ++mFeatureIdListIterator;
-  }
-  else
-    close();
+    const QgsFeatureId id = mSelectIterator;
+    ++mSelectIterator;
 
-  if ( hasFeature )
-  {
-    feature.setFields( mSource->mFields ); // allow name-based attribute lookups
-    geometryToDestinationCrs( feature, mTransform );
+    if ( fetchCandidate( id, feature ) )
+    {
+      geometryToDestinationCrs( feature, mTransform );
+      return true;
+    }
   }
 
-  return hasFeature;
+  feature.setValid( false );
+  close();
+  return false;
 }
 
-
-bool QgsMemoryFeatureIterator::nextFeatureTraverseAll( QgsFeature &feature )
+bool QgsMemoryFeatureIterator::fetchCandidate( QgsFeatureId id, QgsFeature &feature )
 {
-  bool hasFeature = false;
+  const QgsMemoryFeatureStore &store = mSource->mFeatures;
+  if ( !store.contains( id ) )
+    return false;
 
-  // option 2: traversing the whole layer
-  while ( mSelectIterator != mSource->mFeatures.constEnd() )
+  QgsGeometry geometry;
+  if ( !mFilterRect.isNull() )
   {
-    if ( mFilterRect.isNull() )
-    {
-      // selection rect empty => using all features
-      hasFeature = true;
-    }
-    else
+    // check just bounding box against rect first, this doesn't need the geometry to be created
+    if ( !store.hasGeometry( id ) || !store.boundingBox( id ).intersects( mFilterRect ) )
+      return false;
+
+    if ( mRequest.flags() & QgsFeatureRequest::ExactIntersect )
     {
-      if ( mRequest.flags() & QgsFeatureRequest::ExactIntersect )
-      {
-        // using exact test when checking for intersection
-        if ( mSelectIterator->hasGeometry() && mSelectRectEngine->intersects( mSelectIterator->geometry().constGet() ) )
-          hasFeature = true;
-      }
-      else
-      {
-        // check just bounding box against rect when not using intersection
-        if ( mSelectIterator->hasGeometry() && mSelectIterator->geometry().boundingBox().intersects( mFilterRect ) )
-          hasFeature = true;
-      }
+      // do exact check in case we're doing intersection
+      geometry = store.geometry( id );
+      if ( !mSelectRectEngine->intersects( geometry.constGet() ) )
+        return false;
     }
+  }
 
-    if ( mSubsetExpression )
+  // only materialize the parts of the feature which were requested
+  const int fieldCount = mSource->mFields.count();
+  QgsAttributes attributes( fieldCount );
+  if ( mFetchAllAttributes )
+  {
+    for ( int idx = 0; idx < fieldCount; ++idx )
+      attributes[ idx ] = store.attribute( id, idx );
+  }
+  else
+  {
+    for ( int idx : qgis::as_const( mFetchAttributes ) )
     {
-      mSource->mExpressionContext.setFeature( *mSelectIterator );
-      if ( !mSubsetExpression->evaluate( &mSource->mExpressionContext ).toBool() )
-        hasFeature = false;
+      if ( idx >= 0 && idx < fieldCount )
+        attributes[ idx ] = store.attribute( id, idx );
     }
+  }
 
-    if ( hasFeature )
-      break;
+  feature.setId( id );
+  feature.setFields( mSource->mFields ); // allow name-based attribute lookups
+  feature.setAttributes( attributes );
+  if ( mFetchGeometry && store.hasGeometry( id ) )
+    feature.setGeometry( geometry.isNull() ? store.geometry( id ) : geometry );
+  else
+    feature.clearGeometry();
+  feature.setValid( true );
 
-    ++mSelectIterator;
+  if ( mSubsetExpression )
+  {
+    mSource->mExpressionContext.setFeature( feature );
+    if ( !mSubsetExpression->evaluate( &mSource->mExpressionContext ).toBool() )
+      return false;
   }
 
-  // copy feature
-  if ( hasFeature )
+  return true;
+}
+
+void QgsMemoryFeatureIterator::addExpressionAttributes( const QgsExpression &expression )
+{
+  if ( expression.referencedColumns().contains( QgsFeatureRequest::ALL_ATTRIBUTES ) )
   {
-    feature = mSelectIterator.value();
-    ++mSelectIterator;
-    feature.setValid( true );
-    feature.setFields( mSource->mFields ); // allow name-based attribute lookups
-    geometryToDestinationCrs( feature, mTransform );
+    mFetchAllAttributes = true;
+    return;
   }
-  else
-    close();
 
-  return hasFeature;
+  const QSet<int> attributeIndexes = expression.referencedAttributeIndexes( mSource->mFields );
+  for ( int idx : attributeIndexes )
+  {
+    if ( !mFetchAttributes.contains( idx ) )
+      mFetchAttributes << idx;
+  }
 }
 
 bool QgsMemoryFeatureIterator::rewind()
@@ -232,7 +252,7 @@ bool QgsMemoryFeatureIterator::rewind()
   if ( mUsingFeatureIdList )
     mFeatureIdListIterator = mFeatureIdList.constBegin();
   else
-    mSelectIterator = mSource->mFeatures.constBegin();
+    mSelectIterator = mSource->mFeatures.firstFeatureId();
 
   return true;
 }
@@ -21,13 +21,12 @@
 #include "qgsexpressioncontext.h"
 #include "qgsfields.h"
 #include "qgsgeometry.h"
+#include "qgsmemoryfeaturestore.h"
 
 ///@cond PRIVATE
 
 class QgsMemoryProvider;
 
-typedef QMap<QgsFeatureId, QgsFeature> QgsFeatureMap;
-
 class QgsSpatialIndex;
 
 
@@ -40,7 +39,7 @@ class QgsMemoryFeatureSource : public QgsAbstractFeatureSource
 
   private:
     QgsFields mFields;
-    QgsFeatureMap mFeatures;
+    QgsMemoryFeatureStore mFeatures;
     std::unique_ptr< QgsSpatialIndex > mSpatialIndex;
     QString mSubsetString;
     QgsExpressionContext mExpressionContext;
@@ -68,10 +67,19 @@ class QgsMemoryFeatureIterator : public QgsAbstractFeatureIteratorFromSource<Qgs
     bool nextFeatureUsingList( QgsFeature &feature );
     bool nextFeatureTraverseAll( QgsFeature &feature );
 
+    //! Fetches the feature with matching \a id if it passes the request's filter rect and the subset string
+    bool fetchCandidate( QgsFeatureId id, QgsFeature &feature );
+
+    //! Adds the attributes needed by \a expression to the attributes to fetch
+    void addExpressionAttributes( const QgsExpression &expression );
+
     QgsGeometry mSelectRectGeom;
     std::unique_ptr< QgsGeometryEngine > mSelectRectEngine;
     QgsRectangle mFilterRect;
-    QgsFeatureMap::const_iterator mSelectIterator;
+    QgsFeatureId mSelectIterator = 0;
+    bool mFetchGeometry = true;
+    bool mFetchAllAttributes = true;
+    QgsAttributeList mFetchAttributes;
     bool mUsingFeatureIdList = false;
     QList<QgsFeatureId> mFeatureIdList;
     QList<QgsFeatureId>::const_iterator mFeatureIdListIterator;
@@ -0,0 +1,459 @@
+/***************************************************************************
+    qgsmemoryfeaturestore.cpp
+    ---------------------
+    begin                : October 2019
+    copyright            : (C) 2019 by the QGIS project
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+#include "qgsmemoryfeaturestore.h"
+
+#include "qgsgeometryfactory.h"
+#include "qgspoint.h"
+#include "qgswkbptr.h"
+
+#include <algorithm>
+
+///@cond PRIVATE
+
+//! Size of the chunks WKB geometries are packed into
+static const int WKB_CHUNK_SIZE = 16 * 1024 * 1024;
+//! Initial capacity of a WKB chunk, which then grows up to WKB_CHUNK_SIZE
+static const int WKB_CHUNK_INITIAL_SIZE = 64 * 1024;
+
+/**
+ * Appends \a size bytes of \a data to the last of the \a chunks, or to a new chunk
+ * once it is full. The capacity of the chunks is doubled as needed, so that small
+ * layers don't allocate the full chunk size.
+ * Returns the offset of the data within the last chunk.
+ */
+static int appendToChunks( QVector< QByteArray > &chunks, const char *data, int size )
+{
+  if ( chunks.isEmpty() || ( !chunks.last().isEmpty() && chunks.last().size() + size > WKB_CHUNK_SIZE ) )
+  {
+    QByteArray chunk;
+    chunk.reserve( std::max( WKB_CHUNK_INITIAL_SIZE, size ) );
+    chunks.append( chunk );
+  }
+
+  QByteArray &chunk = chunks.last();
+  const int offset = chunk.size();
+  if ( chunk.capacity() < offset + size )
+    chunk.reserve( std::max( offset + size, std::min( 2 * chunk.capacity(), WKB_CHUNK_SIZE ) ) );
+  chunk.append( data, size );
+  return offset;
+}
+
+QgsMemoryColumn::QgsMemoryColumn( QVariant::Type type )
+  : mType( type )
+{
+  switch ( type )
+  {
+    case QVariant::Int:
+      mStorage = Int;
+      break;
+    case QVariant::LongLong:
+      mStorage = LongLong;
+      break;
+    case QVariant::Double:
+      mStorage = Double;
+      break;
+    case QVariant::String:
+      mStorage = String;
+      break;
+    default:
+      mStorage = Variant;
+      break;
+  }
+}
+
+int QgsMemoryColumn::count() const
+{
+  return mStorage == Variant ? mVariants.count() : mStates.count();
+}
+
+void QgsMemoryColumn::append( const QVariant &value )
+{
+  if ( mStorage != Variant )
+  {
+    mStates.append( Invalid );
+    switch ( mStorage )
+    {
+      case Int:
+        mInts.append( 0 );
+        break;
+      case LongLong:
+        mLongLongs.append( 0 );
+        break;
+      case Double:
+        mDoubles.append( 0 );
+        break;
+      case String:
+        mStrings.append( QString() );
+        break;
+      case Variant:
+        break;
+    }
+    if ( setTypedValue( mStates.count() - 1, value ) )
+      return;
+
+    switchToVariants();
+    mVariants.last() = value;
+    return;
+  }
+
+  mVariants.append( value );
+}
+
+QVariant QgsMemoryColumn::value( int row ) const
+{
+  if ( mStorage == Variant )
+    return mVariants.at( row );
+
+  switch ( mStates.at( row ) )
+  {
+    case Invalid:
+      return QVariant();
+    case Null:
+      return QVariant( mType );
+    default:
+      break;
+  }
+
+  switch ( mStorage )
+  {
+    case Int:
+      return mInts.at( row );
+    case LongLong:
+      return mLongLongs.at( row );
+    case Double:
+      return mDoubles.at( row );
+    case String:
+      return mStrings.at( row );
+    case Variant:
+      break;
+  }
+  return QVariant();
+}
+
+void QgsMemoryColumn::setValue( int row, const QVariant &value )
+{
+  if ( mStorage != Variant )
+  {
+    if ( setTypedValue( row, value ) )
+      return;
+
+    switchToVariants();
+  }
+
+  mVariants[ row ] = value;
+}
+
+void QgsMemoryColumn::clear()
+{
+  mStates.clear();
+  mInts.clear();
+  mLongLongs.clear();
+  mDoubles.clear();
+  mStrings.clear();
+  mVariants.clear();
+}
+
+bool QgsMemoryColumn::setTypedValue( int row, const QVariant &value )
+{
+  if ( value.isValid() && value.type() != mType )
+    return false;
+
+  if ( !value.isValid() || value.isNull() )
+  {
+    mStates[ row ] = value.isValid() ? Null : Invalid;
+    if ( mStorage == String )
+      mStrings[ row ] = QString();
+    return true;
+  }
+
+  mStates[ row ] = Value;
+  switch ( mStorage )
+  {
+    case Int:
+      mInts[ row ] = value.toInt();
+      break;
+    case LongLong:
+      mLongLongs[ row ] = value.toLongLong();
+      break;
+    case Double:
+      mDoubles[ row ] = value.toDouble();
+      break;
+    case String:
+      mStrings[ row ] = value.toString();
+      break;
+    case Variant:
+      return false;
+  }
+  return true;
+}
+
+void QgsMemoryColumn::switchToVariants()
+{
+  const int rows = mStates.count();
+  QVector< QVariant > variants;
+  variants.reserve( rows );
+  for ( int row = 0; row < rows; ++row )
+    variants.append( value( row ) );
+
+  clear();
+  mVariants = variants;
+  mStorage = Variant;
+}
+
+//
+// QgsMemoryFeatureStore
+//
+
+bool QgsMemoryFeatureStore::contains( QgsFeatureId id ) const
+{
+  if ( id < mFirstId || id >= nextFeatureId() )
+    return false;
+
+  return mGeometries.at( row( id ) ).chunk != Deleted;
+}
+
+QgsFeatureId QgsMemoryFeatureStore::addFeature( const QgsFeature &feature )
+{
+  const QgsFeatureId id = nextFeatureId();
+  mGeometries.append( GeometryEntry() );
+
+  const QgsAttributes attributes = feature.attributes();
+  for ( int i = 0; i < mColumns.count(); ++i )
+    mColumns[ i ].append( i < attributes.count() ? attributes.at( i ) : QVariant() );
+
+  if ( feature.hasGeometry() )
+    setGeometry( id, feature.geometry() );
+
+  mCount++;
+  return id;
+}
+
+void QgsMemoryFeatureStore::deleteFeature( QgsFeatureId id )
+{
+  if ( !contains( id ) )
+    return;
+
+  const int r = row( id );
+  releaseGeometry( r );
+  mGeometries[ r ].chunk = Deleted;
+  mExtentValid = false;
+
+  // don't keep large values of deleted features around
+  for ( QgsMemoryColumn &column : mColumns )
+    column.setValue( r, QVariant() );
+
+  mCount--;
+}
+
+void QgsMemoryFeatureStore::clear()
+{
+  mFirstId = nextFeatureId();
+  mCount = 0;
+
+  for ( QgsMemoryColumn &column : mColumns )
+    column.clear();
+
+  mGeometries.clear();
+  mPointCoordinates.clear();
+  mWkbChunks.clear();
+  mBoundingBoxes.clear();
+  mWkbBytes = 0;
+  mReleasedWkbBytes = 0;
+  mExtentValid = false;
+}
+
+void QgsMemoryFeatureStore::addColumn( QVariant::Type type )
+{
+  QgsMemoryColumn column( type );
+  for ( int i = 0; i < mGeometries.count(); ++i )
+    column.append( QVariant() );
+  mColumns.append( column );
+}
+
+void QgsMemoryFeatureStore::removeColumn( int index )
+{
+  if ( index >= 0 && index < mColumns.count() )
+    mColumns.remove( index );
+}
+
+QVariant QgsMemoryFeatureStore::attribute( QgsFeatureId id, int index ) const
+{
+  if ( index < 0 || index >= mColumns.count() || !contains( id ) )
+    return QVariant();
+
+  return mColumns.at( index ).value( row( id ) );
+}
+
+void QgsMemoryFeatureStore::setAttribute( QgsFeatureId id, int index, const QVariant &value )
+{
+  if ( index < 0 || index >= mColumns.count() || !contains( id ) )
+    return;
+
+  mColumns[ index ].setValue( row( id ), value );
+}
+
+bool QgsMemoryFeatureStore::hasGeometry( QgsFeatureId id ) const
+{
+  if ( !contains( id ) )
+    return false;
+
+  const int chunk = mGeometries.at( row( id ) ).chunk;
+  return chunk >= 0 || chunk == FlatPoint;
+}
+
+QgsGeometry QgsMemoryFeatureStore::geometry( QgsFeatureId id ) const
+{
+  if ( !hasGeometry( id ) )
+    return QgsGeometry();
+
+  const GeometryEntry &entry = mGeometries.at( row( id ) );
+  if ( entry.chunk == FlatPoint )
+  {
+    return QgsGeometry( new QgsPoint( mPointCoordinates.at( 2 * entry.offset ), mPointCoordinates.at( 2 * entry.offset + 1 ) ) );
+  }
+
+  QgsConstWkbPtr wkbPtr( reinterpret_cast< const unsigned char * >( mWkbChunks.at( entry.chunk ).constData() ) + entry.offset, entry.size );
+  return QgsGeometry( QgsGeometryFactory::geomFromWkb( wkbPtr ) );
+}
+
+QgsRectangle QgsMemoryFeatureStore::boundingBox( QgsFeatureId id ) const
+{
+  if ( !hasGeometry( id ) )
+    return QgsRectangle();
+
+  const int r = row( id );
+  const GeometryEntry &entry = mGeometries.at( r );
+  if ( entry.chunk == FlatPoint )
+  {
+    const double x = mPointCoordinates.at( 2 * entry.offset );
+    const double y = mPointCoordinates.at( 2 * entry.offset + 1 );
+    return QgsRectangle( x, y, x, y );
+  }
+
+  return mBoundingBoxes.at( r );
+}
+
+void QgsMemoryFeatureStore::setGeometry( QgsFeatureId id, const QgsGeometry &geometry )
+{
+  if ( id < mFirstId || id >= nextFeatureId() || mGeometries.at( row( id ) ).chunk == Deleted )
+    return;
+
+  const int r = row( id );
+  if ( geometry.isNull() )
+  {
+    releaseGeometry( r );
+    mGeometries[ r ] = GeometryEntry();
+    mExtentValid = false;
+    return;
+  }
+
+  if ( geometry.wkbType() == QgsWkbTypes::Point )
+  {
+    const QgsPoint *point = qgsgeometry_cast< const QgsPoint * >( geometry.constGet() );
+    GeometryEntry &entry = mGeometries[ r ];
+    if ( entry.chunk != FlatPoint )
+    {
+      releaseGeometry( r );
+      entry.chunk = FlatPoint;
+      entry.offset = mPointCoordinates.count() / 2;
+      entry.size = 0;
+      mPointCoordinates << point->x() << point->y();
+    }
+    else
+    {
+      mPointCoordinates[ 2 * entry.offset ] = point->x();
+      mPointCoordinates[ 2 * entry.offset + 1 ] = point->y();
+      mExtentValid = false;
+    }
+    if ( mExtentValid )
+      mExtent.combineExtentWith( point->x(), point->y() );
+    return;
+  }
+
+  releaseGeometry( r );
+
+  const QByteArray wkb = geometry.asWkb();
+  GeometryEntry &entry = mGeometries[ r ];
+  entry.offset = appendToChunks( mWkbChunks, wkb.constData(), wkb.size() );
+  entry.chunk = mWkbChunks.count() - 1;
+  entry.size = wkb.size();
+  mWkbBytes += wkb.size();
+
+  if ( mBoundingBoxes.count() <= r )
+    mBoundingBoxes.resize( mGeometries.count() );
+  mBoundingBoxes[ r ] = geometry.boundingBox();
+  if ( mExtentValid )
+    mExtent.combineExtentWith( mBoundingBoxes.at( r ) );
+}
+
+QgsRectangle QgsMemoryFeatureStore::extent() const
+{
+  if ( mExtentValid )
+    return mExtent;
+
+  QgsRectangle extent;
+  extent.setMinimal();
+  for ( int r = 0; r < mGeometries.count(); ++r )
+  {
+    const GeometryEntry &entry = mGeometries.at( r );
+    if ( entry.chunk == FlatPoint )
+    {
+      const double x = mPointCoordinates.at( 2 * entry.offset );
+      const double y = mPointCoordinates.at( 2 * entry.offset + 1 );
+      extent.combineExtentWith( x, y );
+    }
+    else if ( entry.chunk >= 0 )
+    {
+      extent.combineExtentWith( mBoundingBoxes.at( r ) );
+    }
+  }
+  mExtent = extent;
+  mExtentValid = true;
+  return extent;
+}
+
+void QgsMemoryFeatureStore::releaseGeometry( int row )
+{
+  const GeometryEntry &entry = mGeometries.at( row );
+  if ( entry.chunk < 0 )
+    return;
+
+  mReleasedWkbBytes += entry.size;
+  mGeometries[ row ].chunk = NoGeometry;
+  mExtentValid = false;
+
+  // reclaim the space of replaced geometries once it makes up most of the buffers
+  if ( mReleasedWkbBytes > WKB_CHUNK_SIZE && mReleasedWkbBytes > mWkbBytes / 2 )
+    compactWkb();
+}
+
+void QgsMemoryFeatureStore::compactWkb()
+{
+  QVector< QByteArray > chunks;
+  for ( GeometryEntry &entry : mGeometries )
+  {
+    if ( entry.chunk < 0 )
+      continue;
+
+    const int offset = appendToChunks( chunks, mWkbChunks.at( entry.chunk ).constData() + entry.offset, entry.size );
+    entry.chunk = chunks.count() - 1;
+    entry.offset = offset;
+  }
+
+  mWkbChunks = chunks;
+  mWkbBytes -= mReleasedWkbBytes;
+  mReleasedWkbBytes = 0;
+}
+
+///@endcond PRIVATE
@@ -0,0 +1,216 @@
+/***************************************************************************
+    qgsmemoryfeaturestore.h
+    ---------------------
+    begin                : October 2019
+    copyright            : (C) 2019 by the QGIS project
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+#ifndef QGSMEMORYFEATURESTORE_H
+#define QGSMEMORYFEATURESTORE_H
+
+#define SIP_NO_FILE
+
+#include "qgsfeature.h"
+#include "qgsgeometry.h"
+#include "qgsrectangle.h"
+
+#include <QByteArray>
+#include <QString>
+#include <QVariant>
+#include <QVector>
+
+///@cond PRIVATE
+
+/**
+ * Values of a single attribute for all features of a QgsMemoryFeatureStore.
+ *
+ * Integer, double and string values are kept in arrays of their native type.
+ * As soon as a value of any other type is stored (the memory provider does not
+ * convert values to the field type), the column falls back to storing QVariants.
+ */
+class QgsMemoryColumn
+{
+  public:
+
+    explicit QgsMemoryColumn( QVariant::Type type = QVariant::Invalid );
+
+    //! Returns the number of rows in the column
+    int count() const;
+
+    //! Appends a \a value to the column
+    void append( const QVariant &value );
+
+    //! Returns the value stored at \a row
+    QVariant value( int row ) const;
+
+    //! Replaces the value stored at \a row
+    void setValue( int row, const QVariant &value );
+
+    //! Removes all rows from the column
+    void clear();
+
+  private:
+
+    enum Storage
+    {
+      Int,
+      LongLong,
+      Double,
+      String,
+      Variant,
+    };
+
+    enum ValueState : char
+    {
+      Value,
+      Null, //!< Null value of the column type
+      Invalid, //!< Invalid QVariant
+    };
+
+    //! Converts all stored values to QVariants
+    void switchToVariants();
+
+    //! Stores \a value at \a row, returns FALSE if it can't be stored in the typed arrays
+    bool setTypedValue( int row, const QVariant &value );
+
+    QVariant::Type mType = QVariant::Invalid;
+    Storage mStorage = Variant;
+
+    QVector< char > mStates;
+    QVector< int > mInts;
+    QVector< qlonglong > mLongLongs;
+    QVector< double > mDoubles;
+    QVector< QString > mStrings;
+    QVector< QVariant > mVariants;
+};
+
+
+/**
+ * Columnar storage for the features of the memory provider.
+ *
+ * Feature IDs are dense: they are assigned sequentially and map directly to a
+ * row in the attribute columns and geometry entries. Deleted features leave an
+ * empty row behind. 2D point geometries are stored as a flat coordinate array,
+ * all other geometries as WKB within large shared byte chunks.
+ *
+ * All members are implicitly shared, so copying a store (e.g. for a feature
+ * source snapshot) is cheap and only the parts modified later are detached.
+ */
+class QgsMemoryFeatureStore
+{
+  public:
+
+    //! Returns the number of features in the store
+    int count() const { return mCount; }
+
+    //! Returns TRUE if the store does not contain any features
+    bool isEmpty() const { return mCount == 0; }
+
+    //! Returns the smallest feature ID which may be in the store
+    QgsFeatureId firstFeatureId() const { return mFirstId; }
+
+    //! Returns the ID which will be assigned to the next added feature
+    QgsFeatureId nextFeatureId() const { return mFirstId + mGeometries.count(); }
+
+    //! Returns TRUE if the store contains a feature with the given \a id
+    bool contains( QgsFeatureId id ) const;
+
+    /**
+     * Adds a \a feature to the store, which must have exactly one attribute
+     * for every column. Returns the ID assigned to the feature.
+     */
+    QgsFeatureId addFeature( const QgsFeature &feature );
+
+    //! Deletes the feature with matching \a id
+    void deleteFeature( QgsFeatureId id );
+
+    //! Deletes all features, feature IDs are not reused
+    void clear();
+
+    //! Returns the number of attribute columns
+    int columnCount() const { return mColumns.count(); }
+
+    //! Adds an attribute column of the given \a type, existing features get invalid values
+    void addColumn( QVariant::Type type );
+
+    //! Removes the attribute column at \a index
+    void removeColumn( int index );
+
+    //! Returns the value of the attribute at \a index for feature \a id
+    QVariant attribute( QgsFeatureId id, int index ) const;
+
+    //! Sets the attribute at \a index of feature \a id
+    void setAttribute( QgsFeatureId id, int index, const QVariant &value );
+
+    //! Returns TRUE if the feature with matching \a id has a geometry
+    bool hasGeometry( QgsFeatureId id ) const;
+
+    //! Returns the geometry of feature \a id
+    QgsGeometry geometry( QgsFeatureId id ) const;
+
+    //! Returns the bounding box of the geometry of feature \a id, without creating the geometry
+    QgsRectangle boundingBox( QgsFeatureId id ) const;
+
+    //! Sets the \a geometry of feature \a id
+    void setGeometry( QgsFeatureId id, const QgsGeometry &geometry );
+
+    /**
+     * Returns the combined bounding box of all geometries in the store. The extent
+     * is cached, added geometries extend it while other changes invalidate it.
+     */
+    QgsRectangle extent() const;
+
+  private:
+
+    enum GeometryStorage
+    {
+      Deleted = -3, //!< Row of a deleted feature
+      FlatPoint = -2, //!< 2D point stored in mPointCoordinates
+      NoGeometry = -1, //!< Feature without geometry
+      // values >= 0 are an index into mWkbChunks
+    };
+
+    struct GeometryEntry
+    {
+      //! Index of the WKB chunk, or a GeometryStorage value
+      int chunk = NoGeometry;
+      //! Offset within the WKB chunk, or index of the point within mPointCoordinates
+      int offset = 0;
+      //! Size of the WKB
+      int size = 0;
+    };
+
+    int row( QgsFeatureId id ) const { return static_cast< int >( id - mFirstId ); }
+
+    //! Forgets the geometry stored at \a row, without changing its state
+    void releaseGeometry( int row );
+
+    //! Rewrites the WKB chunks without the space of released geometries
+    void compactWkb();
+
+    QgsFeatureId mFirstId = 1;
+    int mCount = 0;
+
+    QVector< QgsMemoryColumn > mColumns;
+
+    QVector< GeometryEntry > mGeometries;
+    QVector< double > mPointCoordinates;
+    QVector< QByteArray > mWkbChunks;
+    //! Bounding boxes of WKB geometries, indexed by row (may be shorter than mGeometries)
+    QVector< QgsRectangle > mBoundingBoxes;
+    qint64 mWkbBytes = 0;
+    qint64 mReleasedWkbBytes = 0;
+
+    mutable QgsRectangle mExtent;
+    mutable bool mExtentValid = false;
+};
+
+///@endcond PRIVATE
+
+#endif // QGSMEMORYFEATURESTORE_H
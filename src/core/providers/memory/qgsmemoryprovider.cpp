@@ -62,8 +62,6 @@ QgsMemoryProvider::QgsMemoryProvider( const QString &uri, const ProviderOptions
     mCrs.createFromString( crsDef );
   }
 
-  mNextFeatureId = 1;
-
   setNativeTypes( QList< NativeType >()
                   << QgsVectorDataProvider::NativeType( tr( "Whole number (integer)" ), QStringLiteral( "integer" ), QVariant::Int, 0, 10 )
                   // Decimal number from OGR/Shapefile/dbf may come with length up to 32 and
@@ -295,13 +293,8 @@ QgsRectangle QgsMemoryProvider::extent() const
     mExtent.setMinimal();
     if ( mSubsetString.isEmpty() )
     {
-      // fast way - iterate through all features
-      const auto constMFeatures = mFeatures;
-      for ( const QgsFeature &feat : constMFeatures )
-      {
-        if ( feat.hasGeometry() )
-          mExtent.combineExtentWith( feat.geometry().boundingBox() );
-      }
+      // fast way - use the bounding boxes kept by the store
+      mExtent = mFeatures.extent();
     }
     else
     {
@@ -365,7 +358,6 @@ void QgsMemoryProvider::handlePostCloneOperations( QgsVectorDataProvider *source
   {
     // these properties aren't copied when cloning a memory provider by uri, so we need to do it manually
     mFeatures = other->mFeatures;
-    mNextFeatureId = other->mNextFeatureId;
     mExtent = other->mExtent;
   }
 }
@@ -382,7 +374,7 @@ bool QgsMemoryProvider::addFeatures( QgsFeatureList &flist, Flags )
   // TODO: sanity checks of fields
   for ( QgsFeatureList::iterator it = flist.begin(); it != flist.end(); ++it )
   {
-    it->setId( mNextFeatureId );
+    it->setId( mFeatures.nextFeatureId() );
     it->setValid( true );
     if ( it->attributes().count() < fieldCount )
     {
@@ -417,7 +409,7 @@ bool QgsMemoryProvider::addFeatures( QgsFeatureList &flist, Flags )
       continue;
     }
 
-    mFeatures.insert( mNextFeatureId, *it );
+    mFeatures.addFeature( *it );
 
     if ( it->hasGeometry() )
     {
@@ -428,8 +420,6 @@ bool QgsMemoryProvider::addFeatures( QgsFeatureList &flist, Flags )
       if ( mSpatialIndex )
         mSpatialIndex->addFeature( *it );
     }
-
-    mNextFeatureId++;
   }
 
   clearMinMaxCache();
@@ -440,17 +430,19 @@ bool QgsMemoryProvider::deleteFeatures( const QgsFeatureIds &id )
 {
   for ( QgsFeatureIds::const_iterator it = id.begin(); it != id.end(); ++it )
   {
-    QgsFeatureMap::iterator fit = mFeatures.find( *it );
-
     // check whether such feature exists
-    if ( fit == mFeatures.end() )
+    if ( !mFeatures.contains( *it ) )
       continue;
 
     // update spatial index
-    if ( mSpatialIndex )
-      mSpatialIndex->deleteFeature( *fit );
+    if ( mSpatialIndex && mFeatures.hasGeometry( *it ) )
+    {
+      QgsFeature feature( *it );
+      feature.setGeometry( mFeatures.geometry( *it ) );
+      mSpatialIndex->deleteFeature( feature );
+    }
 
-    mFeatures.erase( fit );
+    mFeatures.deleteFeature( *it );
   }
 
   updateExtents();
@@ -483,14 +475,7 @@ bool QgsMemoryProvider::addAttributes( const QList<QgsField> &attributes )
     }
     // add new field as a last one
     mFields.append( *it );
-
-    for ( QgsFeatureMap::iterator fit = mFeatures.begin(); fit != mFeatures.end(); ++fit )
-    {
-      QgsFeature &f = fit.value();
-      QgsAttributes attr = f.attributes();
-      attr.append( QVariant() );
-      f.setAttributes( attr );
-    }
+    mFeatures.addColumn( it->type() );
   }
   return true;
 }
@@ -529,14 +514,7 @@ bool QgsMemoryProvider::deleteAttributes( const QgsAttributeIds &attributes )
   {
     int idx = *it;
     mFields.remove( idx );
-
-    for ( QgsFeatureMap::iterator fit = mFeatures.begin(); fit != mFeatures.end(); ++fit )
-    {
-      QgsFeature &f = fit.value();
-      QgsAttributes attr = f.attributes();
-      attr.remove( idx );
-      f.setAttributes( attr );
-    }
+    mFeatures.removeColumn( idx );
   }
   clearMinMaxCache();
   return true;
@@ -546,13 +524,12 @@ bool QgsMemoryProvider::changeAttributeValues( const QgsChangedAttributesMap &at
 {
   for ( QgsChangedAttributesMap::const_iterator it = attr_map.begin(); it != attr_map.end(); ++it )
   {
-    QgsFeatureMap::iterator fit = mFeatures.find( it.key() );
-    if ( fit == mFeatures.end() )
+    if ( !mFeatures.contains( it.key() ) )
       continue;
 
     const QgsAttributeMap &attrs = it.value();
     for ( QgsAttributeMap::const_iterator it2 = attrs.constBegin(); it2 != attrs.constEnd(); ++it2 )
-      fit->setAttribute( it2.key(), it2.value() );
+      mFeatures.setAttribute( it.key(), it2.key(), it2.value() );
   }
   clearMinMaxCache();
   return true;
@@ -562,19 +539,26 @@ bool QgsMemoryProvider::changeGeometryValues( const QgsGeometryMap &geometry_map
 {
   for ( QgsGeometryMap::const_iterator it = geometry_map.begin(); it != geometry_map.end(); ++it )
   {
-    QgsFeatureMap::iterator fit = mFeatures.find( it.key() );
-    if ( fit == mFeatures.end() )
+    if ( !mFeatures.contains( it.key() ) )
       continue;
 
+    QgsFeature feature( it.key() );
+
     // update spatial index
-    if ( mSpatialIndex )
-      mSpatialIndex->deleteFeature( *fit );
+    if ( mSpatialIndex && mFeatures.hasGeometry( it.key() ) )
+    {
+      feature.setGeometry( mFeatures.geometry( it.key() ) );
+      mSpatialIndex->deleteFeature( feature );
+    }
 
-    fit->setGeometry( it.value() );
+    mFeatures.setGeometry( it.key(), it.value() );
 
     // update spatial index
-    if ( mSpatialIndex )
-      mSpatialIndex->addFeature( *fit );
+    if ( mSpatialIndex && it.value().constGet() )
+    {
+      feature.setGeometry( it.value() );
+      mSpatialIndex->addFeature( feature );
+    }
   }
 
   updateExtents();
@@ -613,13 +597,15 @@ bool QgsMemoryProvider::createSpatialIndex()
 {
   if ( !mSpatialIndex )
   {
-    mSpatialIndex = new QgsSpatialIndex();
-
-    // add existing features to index
-    for ( QgsFeatureMap::iterator it = mFeatures.begin(); it != mFeatures.end(); ++it )
+    // bulk load existing features into the index
+    QVector< QPair< QgsFeatureId, QgsRectangle > > boundingBoxes;
+    boundingBoxes.reserve( mFeatures.count() );
+    for ( QgsFeatureId id = mFeatures.firstFeatureId(); id < mFeatures.nextFeatureId(); ++id )
     {
-      mSpatialIndex->addFeature( *it );
+      if ( mFeatures.hasGeometry( id ) )
+        boundingBoxes.append( qMakePair( id, mFeatures.boundingBox( id ) ) );
     }
+    mSpatialIndex = new QgsSpatialIndex( boundingBoxes );
   }
   return true;
 }
@@ -18,9 +18,9 @@
 #include "qgsvectordataprovider.h"
 #include "qgscoordinatereferencesystem.h"
 #include "qgsfields.h"
+#include "qgsmemoryfeaturestore.h"
 
 ///@cond PRIVATE
-typedef QMap<QgsFeatureId, QgsFeature> QgsFeatureMap;
 
 class QgsSpatialIndex;
 
@@ -90,8 +90,7 @@ class QgsMemoryProvider : public QgsVectorDataProvider
     mutable QgsRectangle mExtent;
 
     // features
-    QgsFeatureMap mFeatures;
-    QgsFeatureId mNextFeatureId;
+    QgsMemoryFeatureStore mFeatures;
 
     // indexing
     QgsSpatialIndex *mSpatialIndex = nullptr;
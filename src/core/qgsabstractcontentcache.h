@@ -31,6 +31,7 @@
 #include <QSet>
 #include <QDateTime>
 #include <QList>
+#include <QAtomicInteger>
 #include "qgsnetworkcontentfetchertask.h"
 #include <QNetworkReply>
 
@@ -182,6 +183,11 @@ class CORE_EXPORT QgsAbstractContentCacheBase: public QObject
  * content (via HTTP), and automatically invalidating cached content when the corresponding
  * file is changed.
  *
+ * Entries are distributed over a fixed number of shards by entryHash(), each with its own lock,
+ * lookup table and least recently used list. Threads rendering different content therefore do
+ * not contend for a single lock. Subclasses must hold the lock returned by mutexForEntry()
+ * while they access or modify an entry.
+ *
  * \note Not available in Python bindings.
  * \since QGIS 3.6
  */
@@ -191,6 +197,9 @@ class CORE_EXPORT QgsAbstractContentCache : public QgsAbstractContentCacheBase
 
   public:
 
+    //! Number of independently locked shards of the cache
+    static const int SHARD_COUNT = 16;
+
     /**
      * Constructor for QgsAbstractContentCache, with the specified \a parent object.
      *
@@ -216,31 +225,71 @@ class CORE_EXPORT QgsAbstractContentCache : public QgsAbstractContentCacheBase
 
     ~QgsAbstractContentCache() override
     {
-      qDeleteAll( mEntryLookup );
+      for ( Shard &shard : mShards )
+        qDeleteAll( shard.entryLookup );
     }
 
   protected:
 
+    /**
+     * Returns a hash of the properties of \a entry which are compared by the entry's isEqual()
+     * implementation. It decides which shard of the cache holds the entry, so equal entries should
+     * have equal hashes. Otherwise they may be cached more than once.
+     *
+     * The default implementation hashes the entry's path only. Subclasses should include
+     * further properties so that variants of the same file are spread over the shards.
+     */
+    virtual uint entryHash( const T *entry ) const
+    {
+      return qHash( entry->path );
+    }
+
+    /**
+     * Returns the mutex guarding the shard of the cache which holds entries equal to \a entry.
+     *
+     * The mutex must be locked while calling findExistingEntry(), addCachedSize() or trimToMaximumSize()
+     * for the entry, and while reading or modifying the entry returned by findExistingEntry(). It is
+     * recursive and may be locked before mMutex, but never while holding mMutex.
+     */
+    QMutex *mutexForEntry( const T *entry ) const
+    {
+      return &shardForEntry( entry ).mutex;
+    }
+
+    /**
+     * Adds \a size bytes of content cached for \a entry to the total size of the cache.
+     *
+     * The size of an entry must always match its dataSize() after the content was added.
+     */
+    void addCachedSize( const T *entry, long size )
+    {
+      shardForEntry( entry ).totalSize += size;
+      mTotalSize.fetchAndAddOrdered( size );
+    }
+
     /**
      * Removes the least used cache entries until the maximum cache size is under the predefined size limit.
+     *
+     * Entries are removed from the shard holding \a entry first, except for its most recently used entry.
+     * If that is not enough, entries are removed from the other shards which are not locked by another
+     * thread at that moment. The total size may therefore exceed the limit by the content of the shards
+     * in use by other threads, until the next time the cache is trimmed.
      */
-    void trimToMaximumSize()
+    void trimToMaximumSize( const T *entry )
     {
-      //only one entry in cache
-      if ( mLeastRecentEntry == mMostRecentEntry )
-      {
-        return;
-      }
-      T *entry = mLeastRecentEntry;
-      while ( entry && ( mTotalSize > mMaxCacheSize ) )
+      Shard &shard = shardForEntry( entry );
+      trimShard( shard, shard.mostRecentEntry );
+
+      for ( Shard &otherShard : mShards )
       {
-        T *bkEntry = entry;
-        entry = static_cast< T * >( entry->nextEntry );
+        if ( mTotalSize.load() <= mMaxCacheSize )
+          break;
+        if ( &otherShard == &shard || !otherShard.mutex.tryLock() )
+          continue;
 
-        takeEntryFromList( bkEntry );
-        mEntryLookup.remove( bkEntry->path, bkEntry );
-        mTotalSize -= bkEntry->dataSize();
-        delete bkEntry;
+        // no entry of a shard is in use while its lock is held
+        trimShard( otherShard, nullptr );
+        otherShard.mutex.unlock();
       }
     }
 
@@ -373,19 +422,23 @@ class CORE_EXPORT QgsAbstractContentCache : public QgsAbstractContentCacheBase
 
     void onRemoteContentFetched( const QString &url, bool success ) override
     {
-      QMutexLocker locker( &mMutex );
-      mPendingRemoteUrls.remove( url );
+      {
+        QMutexLocker locker( &mMutex );
+        mPendingRemoteUrls.remove( url );
+      }
 
-      T *nextEntry = mLeastRecentEntry;
-      while ( T *entry = nextEntry )
+      // the shard locks are taken before mMutex elsewhere, so mMutex must not be held here
+      for ( Shard &shard : mShards )
       {
-        nextEntry = static_cast< T * >( entry->nextEntry );
-        if ( entry->path == url )
+        QMutexLocker locker( &shard.mutex );
+        T *nextEntry = shard.leastRecentEntry;
+        while ( T *entry = nextEntry )
         {
-          takeEntryFromList( entry );
-          mEntryLookup.remove( entry->path, entry );
-          mTotalSize -= entry->dataSize();
-          delete entry;
+          nextEntry = static_cast< T * >( entry->nextEntry );
+          if ( entry->path == url )
+          {
+            removeEntry( shard, entry );
+          }
         }
       }
 
@@ -401,13 +454,17 @@ class CORE_EXPORT QgsAbstractContentCache : public QgsAbstractContentCacheBase
      *
      * If an existing entry was found, then the corresponding file MAY be rechecked for changes (only if a suitable
      * time has occurred since the last check).
+     *
+     * The mutex returned by mutexForEntry() for \a entryTemplate must be locked by the caller.
      */
     T *findExistingEntry( T *entryTemplate )
     {
-      //search entries in mEntryLookup
+      Shard &shard = shardForEntry( entryTemplate );
+
+      //search entries in the shard's lookup
       const QString path = entryTemplate->path;
       T *currentEntry = nullptr;
-      const QList<T *> entries = mEntryLookup.values( path );
+      const QList<T *> entries = shard.entryLookup.values( path );
       QDateTime modified;
       for ( T *cacheEntry : entries )
       {
@@ -431,24 +488,24 @@ class CORE_EXPORT QgsAbstractContentCache : public QgsAbstractContentCacheBase
       //if not found: insert entryTemplate as a new entry
       if ( !currentEntry )
       {
-        currentEntry = insertCacheEntry( entryTemplate );
+        currentEntry = insertCacheEntry( shard, entryTemplate );
       }
       else
       {
         delete entryTemplate;
         entryTemplate = nullptr;
-        takeEntryFromList( currentEntry );
-        if ( !mMostRecentEntry ) //list is empty
+        takeEntryFromList( shard, currentEntry );
+        if ( !shard.mostRecentEntry ) //list is empty
         {
-          mMostRecentEntry = currentEntry;
-          mLeastRecentEntry = currentEntry;
+          shard.mostRecentEntry = currentEntry;
+          shard.leastRecentEntry = currentEntry;
         }
         else
         {
-          mMostRecentEntry->nextEntry = currentEntry;
-          currentEntry->previousEntry = mMostRecentEntry;
+          shard.mostRecentEntry->nextEntry = currentEntry;
+          currentEntry->previousEntry = shard.mostRecentEntry;
           currentEntry->nextEntry = nullptr;
-          mMostRecentEntry = currentEntry;
+          shard.mostRecentEntry = currentEntry;
         }
       }
 
@@ -458,21 +515,49 @@ class CORE_EXPORT QgsAbstractContentCache : public QgsAbstractContentCacheBase
       return currentEntry;
     }
 
+    //! Guards the state of remote content requests
     mutable QMutex mMutex;
+
     //! Estimated total size of all cached content
-    long mTotalSize = 0;
+    QAtomicInteger< qint64 > mTotalSize;
 
     //! Maximum cache size
     long mMaxCacheSize = 20000000;
 
   private:
 
+    //! Independently locked part of the cache
+    struct Shard
+    {
+      Shard()
+        : mutex( QMutex::Recursive )
+      {}
+
+      QMutex mutex;
+
+      //! Entry pointers accessible by file name
+      QMultiHash< QString, T * > entryLookup;
+
+      //The shard keeps its entries on a double connected list, moving the current entry to the front.
+      //That way, removing entries for more space can start with the least used objects.
+      T *leastRecentEntry = nullptr;
+      T *mostRecentEntry = nullptr;
+
+      //! Estimated total size of the content cached in this shard
+      long totalSize = 0;
+    };
+
+    Shard &shardForEntry( const T *entry ) const
+    {
+      return mShards[ entryHash( entry ) % SHARD_COUNT ];
+    }
+
     /**
-     * Inserts a new \a entry into the cache.
+     * Inserts a new \a entry into the \a shard.
      *
      * Ownership of \a entry is transferred to the cache.
      */
-    T *insertCacheEntry( T *entry )
+    T *insertCacheEntry( Shard &shard, T *entry )
     {
       entry->mFileModifiedCheckTimeout = mFileModifiedCheckTimeout;
 
@@ -482,33 +567,61 @@ class CORE_EXPORT QgsAbstractContentCache : public QgsAbstractContentCacheBase
         entry->fileModifiedLastCheckTimer.start();
       }
 
-      mEntryLookup.insert( entry->path, entry );
+      shard.entryLookup.insert( entry->path, entry );
 
       //insert to most recent place in entry list
-      if ( !mMostRecentEntry ) //inserting first entry
+      if ( !shard.mostRecentEntry ) //inserting first entry
       {
-        mLeastRecentEntry = entry;
-        mMostRecentEntry = entry;
+        shard.leastRecentEntry = entry;
+        shard.mostRecentEntry = entry;
         entry->previousEntry = nullptr;
         entry->nextEntry = nullptr;
       }
       else
       {
-        entry->previousEntry = mMostRecentEntry;
+        entry->previousEntry = shard.mostRecentEntry;
         entry->nextEntry = nullptr;
-        mMostRecentEntry->nextEntry = entry;
-        mMostRecentEntry = entry;
+        shard.mostRecentEntry->nextEntry = entry;
+        shard.mostRecentEntry = entry;
       }
 
-      trimToMaximumSize();
+      trimToMaximumSize( entry );
       return entry;
     }
 
+    /**
+     * Removes the least used entries of a \a shard while the cache exceeds its maximum size,
+     * stopping at the \a keep entry.
+     */
+    void trimShard( Shard &shard, const T *keep )
+    {
+      T *entry = shard.leastRecentEntry;
+      while ( entry && entry != keep && ( mTotalSize.load() > mMaxCacheSize ) )
+      {
+        T *bkEntry = entry;
+        entry = static_cast< T * >( entry->nextEntry );
+
+        removeEntry( shard, bkEntry );
+      }
+    }
 
     /**
-     * Removes an \a entry from the ordered list (but does not delete the entry itself).
+     * Removes an \a entry from the \a shard and deletes it.
      */
-    void takeEntryFromList( T *entry )
+    void removeEntry( Shard &shard, T *entry )
+    {
+      takeEntryFromList( shard, entry );
+      shard.entryLookup.remove( entry->path, entry );
+      const int size = entry->dataSize();
+      shard.totalSize -= size;
+      mTotalSize.fetchAndAddOrdered( -size );
+      delete entry;
+    }
+
+    /**
+     * Removes an \a entry from the ordered list of the \a shard (but does not delete the entry itself).
+     */
+    void takeEntryFromList( Shard &shard, T *entry )
     {
       if ( !entry )
       {
@@ -521,7 +634,7 @@ class CORE_EXPORT QgsAbstractContentCache : public QgsAbstractContentCacheBase
       }
       else
       {
-        mLeastRecentEntry = static_cast< T * >( entry->nextEntry );
+        shard.leastRecentEntry = static_cast< T * >( entry->nextEntry );
       }
       if ( entry->nextEntry )
       {
@@ -529,7 +642,7 @@ class CORE_EXPORT QgsAbstractContentCache : public QgsAbstractContentCacheBase
       }
       else
       {
-        mMostRecentEntry = static_cast< T * >( entry->previousEntry );
+        shard.mostRecentEntry = static_cast< T * >( entry->previousEntry );
       }
     }
 
@@ -539,27 +652,26 @@ class CORE_EXPORT QgsAbstractContentCache : public QgsAbstractContentCacheBase
     void printEntryList()
     {
       QgsDebugMsg( QStringLiteral( "****************cache entry list*************************" ) );
-      QgsDebugMsg( "Cache size: " + QString::number( mTotalSize ) );
-      T *entry = mLeastRecentEntry;
-      while ( entry )
+      QgsDebugMsg( "Cache size: " + QString::number( mTotalSize.load() ) );
+      for ( Shard &shard : mShards )
       {
-        QgsDebugMsg( QStringLiteral( "***Entry:" ) );
-        entry->dump();
-        entry = entry->nextEntry;
+        QMutexLocker locker( &shard.mutex );
+        QgsDebugMsg( "***Shard size: " + QString::number( shard.totalSize ) );
+        T *entry = shard.leastRecentEntry;
+        while ( entry )
+        {
+          QgsDebugMsg( QStringLiteral( "***Entry:" ) );
+          entry->dump();
+          entry = static_cast< T * >( entry->nextEntry );
+        }
       }
     }
 
-    //! Entry pointers accessible by file name
-    QMultiHash< QString, T * > mEntryLookup;
+    mutable Shard mShards[ SHARD_COUNT ];
 
     //! Minimum time (in ms) between consecutive file modified time checks
     int mFileModifiedCheckTimeout = 30000;
 
-    //The content cache keeps the entries on a double connected list, moving the current entry to the front.
-    //That way, removing entries for more space can start with the least used objects.
-    T *mLeastRecentEntry = nullptr;
-    T *mMostRecentEntry = nullptr;
-
     mutable QCache< QString, QByteArray > mRemoteContentCache;
     mutable QSet< QString > mPendingRemoteUrls;
 
@@ -667,16 +667,33 @@ QVariant QgsAggregateCalculator::calculateNumericAggregate( QgsFeatureIterator &
   QgsStatisticalSummary s( stat );
   QgsFeature f;
 
-  while ( fit.nextFeature( f ) )
+  if ( expression )
   {
-    if ( expression )
+    Q_ASSERT( context );
+
+    // evaluate the expression in blocks, so that simple expressions avoid the per-feature evaluation overhead
+    const int blockSize = 1000;
+    QgsFeatureList block;
+    block.reserve( blockSize );
+    bool finished = false;
+    while ( !finished )
     {
-      Q_ASSERT( context );
-      context->setFeature( f );
-      QVariant v = expression->evaluate( context );
-      s.addVariant( v );
+      finished = !fit.nextFeature( f );
+      if ( !finished )
+        block << f;
+
+      if ( block.size() == blockSize || ( finished && !block.isEmpty() ) )
+      {
+        const QVariantList values = expression->evaluateBatch( block, context );
+        for ( const QVariant &v : values )
+          s.addVariant( v );
+        block.clear();
+      }
     }
-    else
+  }
+  else
+  {
+    while ( fit.nextFeature( f ) )
     {
       s.addVariant( f.attribute( attr ) );
     }
@@ -32,6 +32,8 @@
 #include "qgsfieldformatterregistry.h"
 #include "qgssvgcache.h"
 #include "qgsimagecache.h"
+#include "qgslabelplacementcache.h"
+#include "qgstextlayoutcache.h"
 #include "qgscolorschemeregistry.h"
 #include "qgspainteffectregistry.h"
 #include "qgsprojectstorageregistry.h"
@@ -1885,6 +1887,16 @@ QgsImageCache *QgsApplication::imageCache()
   return members()->mImageCache;
 }
 
+QgsLabelPlacementCache *QgsApplication::labelPlacementCache()
+{
+  return members()->mLabelPlacementCache;
+}
+
+QgsTextLayoutCache *QgsApplication::textLayoutCache()
+{
+  return members()->mTextLayoutCache;
+}
+
 QgsNetworkContentFetcherRegistry *QgsApplication::networkContentFetcherRegistry()
 {
   return members()->mNetworkContentFetcherRegistry;
@@ -1966,6 +1978,8 @@ QgsApplication::ApplicationMembers::ApplicationMembers()
   mFieldFormatterRegistry = new QgsFieldFormatterRegistry();
   mSvgCache = new QgsSvgCache();
   mImageCache = new QgsImageCache();
+  mLabelPlacementCache = new QgsLabelPlacementCache();
+  mTextLayoutCache = new QgsTextLayoutCache();
   mColorSchemeRegistry = new QgsColorSchemeRegistry();
   mPaintEffectRegistry = new QgsPaintEffectRegistry();
   mSymbolLayerRegistry = new QgsSymbolLayerRegistry();
@@ -2006,6 +2020,8 @@ QgsApplication::ApplicationMembers::~ApplicationMembers()
   delete mRendererRegistry;
   delete mSvgCache;
   delete mImageCache;
+  delete mLabelPlacementCache;
+  delete mTextLayoutCache;
   delete mCalloutRegistry;
   delete mSymbolLayerRegistry;
   delete mTaskManager;
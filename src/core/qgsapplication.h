@@ -35,6 +35,8 @@ class QgsProjectStorageRegistry;
 class QgsRendererRegistry;
 class QgsSvgCache;
 class QgsImageCache;
+class QgsLabelPlacementCache;
+class QgsTextLayoutCache;
 class QgsSymbolLayerRegistry;
 class QgsRasterRendererRegistry;
 class QgsGpsConnectionRegistry;
@@ -595,6 +597,24 @@ class CORE_EXPORT QgsApplication : public QApplication
      */
     static QgsImageCache *imageCache();
 
+    /**
+     * Returns the application's label placement cache, which keeps label positions
+     * across map renders when the QgsLabelingEngineSettings::UsePlacementCache flag is set.
+     *
+     * \note not available in Python bindings
+     * \since QGIS 3.10
+     */
+    static QgsLabelPlacementCache *labelPlacementCache() SIP_SKIP;
+
+    /**
+     * Returns the application's text layout cache, used for caching the widths and
+     * outlines of rendered text.
+     *
+     * \note not available in Python bindings
+     * \since QGIS 3.10
+     */
+    static QgsTextLayoutCache *textLayoutCache() SIP_SKIP;
+
     /**
      * Returns the application's network content registry used for fetching temporary files during QGIS session
      * \since QGIS 3.2
@@ -877,6 +897,8 @@ class CORE_EXPORT QgsApplication : public QApplication
       QgsRuntimeProfiler *mProfiler = nullptr;
       QgsSvgCache *mSvgCache = nullptr;
       QgsImageCache *mImageCache = nullptr;
+      QgsLabelPlacementCache *mLabelPlacementCache = nullptr;
+      QgsTextLayoutCache *mTextLayoutCache = nullptr;
       QgsSymbolLayerRegistry *mSymbolLayerRegistry = nullptr;
       QgsCalloutRegistry *mCalloutRegistry = nullptr;
       QgsTaskManager *mTaskManager = nullptr;
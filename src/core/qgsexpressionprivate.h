@@ -24,6 +24,7 @@
 #include "qgsdistancearea.h"
 #include "qgsunittypes.h"
 #include "qgsexpressionnode.h"
+#include "qgsexpressionprogram.h"
 
 ///@cond
 
@@ -73,6 +74,9 @@ class QgsExpressionPrivate
 
     //! Whether prepare() has been called before evaluate()
     bool mIsPrepared = false;
+
+    //! Compiled form of the prepared tree, see QgsExpression::compile(). Never shared between copies.
+    std::unique_ptr<QgsExpressionProgram> mProgram;
 };
 ///@endcond
 
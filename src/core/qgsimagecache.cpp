@@ -108,11 +108,12 @@ QImage QgsImageCache::pathAsImage( const QString &f, const QSize size, const boo
   if ( file.isEmpty() )
     return QImage();
 
-  QMutexLocker locker( &mMutex );
+  std::unique_ptr< QgsImageCacheEntry > entryTemplate = qgis::make_unique< QgsImageCacheEntry >( file, size, keepAspectRatio, opacity );
+  QMutexLocker locker( mutexForEntry( entryTemplate.get() ) );
 
   fitsInCache = true;
 
-  QgsImageCacheEntry *currentEntry = findExistingEntry( new QgsImageCacheEntry( file, size, keepAspectRatio, opacity ) );
+  QgsImageCacheEntry *currentEntry = findExistingEntry( entryTemplate.release() );
 
   QImage result;
 
@@ -131,10 +132,10 @@ QImage QgsImageCache::pathAsImage( const QString &f, const QSize size, const boo
     }
     else
     {
-      mTotalSize += ( result.width() * result.height() * 32 );
       currentEntry->image = result;
+      addCachedSize( currentEntry, result.width() * result.height() * 32 );
     }
-    trimToMaximumSize();
+    trimToMaximumSize( currentEntry );
   }
   else
   {
@@ -144,6 +145,11 @@ QImage QgsImageCache::pathAsImage( const QString &f, const QSize size, const boo
   return result;
 }
 
+uint QgsImageCache::entryHash( const QgsImageCacheEntry *entry ) const
+{
+  return qHash( entry->path ) ^ qHash( entry->size.width() ) ^ ( qHash( entry->size.height() ) * 31 ) ^ qHash( entry->opacity ) ^ qHash( entry->keepAspectRatio );
+}
+
 QSize QgsImageCache::originalSize( const QString &path ) const
 {
   if ( path.isEmpty() )
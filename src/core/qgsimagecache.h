@@ -142,6 +142,10 @@ class CORE_EXPORT QgsImageCache : public QgsAbstractContentCache< QgsImageCacheE
 
     QImage renderImage( const QString &path, QSize size, const bool keepAspectRatio, const double opacity ) const;
 
+#ifndef SIP_RUN
+    uint entryHash( const QgsImageCacheEntry *entry ) const override;
+#endif
+
     //! SVG content to be rendered if SVG file was not found.
     QByteArray mMissingSvg;
 
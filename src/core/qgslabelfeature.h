@@ -22,6 +22,7 @@
 #include "geos_c.h"
 #include "qgsgeos.h"
 #include "qgsmargins.h"
+#include "qgslabelplacementcache.h"
 #include "pal.h"
 
 namespace pal
@@ -459,6 +460,29 @@ class CORE_EXPORT QgsLabelFeature
      */
     void setLabelAllParts( bool labelAllParts ) { mLabelAllParts = labelAllParts; }
 
+    /**
+     * Returns TRUE if the label should be placed at cachedPlacement() instead
+     * of generating candidates.
+     * \see setCachedPlacement()
+     * \since QGIS 3.10
+     */
+    bool hasCachedPlacement() const { return mHasCachedPlacement; }
+
+    /**
+     * Returns the placement of the label from a previous render.
+     * \see setCachedPlacement()
+     * \since QGIS 3.10
+     */
+    const QgsLabelPlacementCache::Placement &cachedPlacement() const { return mCachedPlacement; }
+
+    /**
+     * Sets the \a placement of the label from a previous render, which will be
+     * the only candidate of the label.
+     * \see cachedPlacement()
+     * \since QGIS 3.10
+     */
+    void setCachedPlacement( const QgsLabelPlacementCache::Placement &placement ) { mCachedPlacement = placement; mHasCachedPlacement = true; }
+
   protected:
     //! Pointer to PAL layer (assigned when registered to PAL)
     pal::Layer *mLayer = nullptr;
@@ -535,6 +559,9 @@ class CORE_EXPORT QgsLabelFeature
 
     bool mLabelAllParts = false;
 
+    bool mHasCachedPlacement = false;
+    QgsLabelPlacementCache::Placement mCachedPlacement;
+
 };
 
 #endif // QGSLABELFEATURE_H
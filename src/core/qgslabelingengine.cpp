@@ -27,6 +27,9 @@
 #include "qgsmaplayer.h"
 #include "qgssymbol.h"
 #include "qgsexpressioncontextutils.h"
+#include "qgsapplication.h"
+#include "qgslabelplacementcache.h"
+#include "qgstextlayoutcache.h"
 
 // helper function for checking for job cancellation within PAL
 static bool _palIsCanceled( void *ctx )
@@ -34,6 +37,36 @@ static bool _palIsCanceled( void *ctx )
   return ( reinterpret_cast< QgsRenderContext * >( ctx ) )->renderingStopped();
 }
 
+//! Returns TRUE if the label of \a feature can be stored in the label placement cache
+static bool _isPlacementCacheable( const QgsAbstractLabelProvider *provider, const QgsLabelFeature *feature )
+{
+  // only single, straight labels of map layer features are cached
+  return !provider->layerId().isEmpty()
+         && !feature->hasFixedPosition()
+         && !feature->labelAllParts()
+         && feature->repeatDistance() <= 0
+         && !feature->curvedLabelInfo()
+         && feature->feature().hasGeometry();
+}
+
+//! Returns the key of the label of \a feature in the label placement cache
+static QgsLabelPlacementCache::Key _placementCacheKey( const QgsAbstractLabelProvider *provider, const QgsLabelFeature *feature, int scaleBand )
+{
+  QgsLabelPlacementCache::Key key;
+  key.layerId = provider->layerId();
+  key.providerId = provider->providerId();
+  key.featureId = feature->id();
+  key.textHash = qHash( feature->labelText() );
+  key.scaleBand = scaleBand;
+  return key;
+}
+
+//! Returns a hash of the properties of \a feature which invalidate a cached placement when changed
+static uint _placementSignature( const QgsLabelFeature *feature, uint mapHash )
+{
+  return qHash( feature->feature().geometry().asWkb() ) ^ mapHash;
+}
+
 /**
  * \ingroup core
  * \class QgsLabelSorter
@@ -160,9 +193,13 @@ void QgsLabelingEngine::processProvider( QgsAbstractLabelProvider *provider, Qgs
 
 
   const QList<QgsLabelFeature *> features = provider->labelFeatures( context );
+  const bool usePlacementCache = usesPlacementCache();
 
   for ( QgsLabelFeature *feature : features )
   {
+    if ( usePlacementCache )
+      applyCachedPlacement( provider, feature );
+
     try
     {
       l->registerFeature( feature );
@@ -184,6 +221,76 @@ void QgsLabelingEngine::processProvider( QgsAbstractLabelProvider *provider, Qgs
   }
 }
 
+bool QgsLabelingEngine::usesPlacementCache() const
+{
+  // labels are placed in unrotated map coordinates, which depend on the rotation center
+  return mMapSettings.labelingEngineSettings().testFlag( QgsLabelingEngineSettings::UsePlacementCache )
+         && qgsDoubleNear( mMapSettings.rotation(), 0.0 );
+}
+
+void QgsLabelingEngine::applyCachedPlacement( QgsAbstractLabelProvider *provider, QgsLabelFeature *feature )
+{
+  if ( !_isPlacementCacheable( provider, feature ) )
+    return;
+
+  QgsLabelPlacementCache::Placement placement;
+  if ( !QgsApplication::labelPlacementCache()->placement( _placementCacheKey( provider, feature, QgsLabelPlacementCache::scaleBand( mMapSettings.scale() ) ), placement ) )
+    return;
+
+  // the feature or the label size changed since the label was placed
+  if ( placement.signature != _placementSignature( feature, mPlacementCacheMapHash )
+       || !qgsDoubleNear( placement.width, feature->size().width(), feature->size().width() * 1e-6 )
+       || !qgsDoubleNear( placement.height, feature->size().height(), feature->size().height() * 1e-6 ) )
+    return;
+
+  feature->setCachedPlacement( placement );
+  mCachedPlacementFeatures << feature;
+}
+
+void QgsLabelingEngine::updatePlacementCache( const QList<pal::LabelPosition *> &labels, const QgsRectangle &extent )
+{
+  QgsLabelPlacementCache *cache = QgsApplication::labelPlacementCache();
+  const int scaleBand = QgsLabelPlacementCache::scaleBand( mMapSettings.scale() );
+
+  QSet< QgsLabelFeature * > placedFeatures;
+  for ( pal::LabelPosition *label : labels )
+  {
+    QgsLabelFeature *lf = label->getFeaturePart()->feature();
+    if ( !lf || label->getNextPart() || !_isPlacementCacheable( lf->provider(), lf ) )
+      continue;
+
+    placedFeatures << lf;
+    if ( lf->hasCachedPlacement() )
+      continue;
+
+    // store the arguments of the LabelPosition constructor, which turns upside down labels around
+    const int origin = label->getUpsideDown() ? 2 : 0;
+    QgsLabelPlacementCache::Placement placement;
+    placement.x = label->getX( origin );
+    placement.y = label->getY( origin );
+    placement.width = label->getWidth();
+    placement.height = label->getHeight();
+    placement.angle = label->getUpsideDown() ? label->getAlpha() + M_PI : label->getAlpha();
+    placement.quadrant = label->getQuadrant();
+    placement.reversed = label->getReversed();
+    placement.signature = _placementSignature( lf, mPlacementCacheMapHash );
+    cache->insert( _placementCacheKey( lf->provider(), lf, scaleBand ), placement );
+  }
+
+  // a cached label which could not be placed although it was completely visible lost a
+  // conflict against a new label, it is solved from scratch the next time
+  for ( QgsLabelFeature *lf : qgis::as_const( mCachedPlacementFeatures ) )
+  {
+    if ( placedFeatures.contains( lf ) )
+      continue;
+
+    const QgsLabelPlacementCache::Placement &placement = lf->cachedPlacement();
+    const double radius = placement.width + placement.height;
+    if ( extent.contains( QgsRectangle( placement.x - radius, placement.y - radius, placement.x + radius, placement.y + radius ) ) )
+      cache->remove( _placementCacheKey( lf->provider(), lf, scaleBand ) );
+  }
+}
+
 
 void QgsLabelingEngine::run( QgsRenderContext &context )
 {
@@ -219,7 +326,12 @@ void QgsLabelingEngine::run( QgsRenderContext &context )
   p.setPolyP( candPolygon );
 
   p.setShowPartial( settings.testFlag( QgsLabelingEngineSettings::UsePartialCandidates ) );
+  p.setSplitComponents( settings.testFlag( QgsLabelingEngineSettings::SplitConflictComponents ) );
+  p.setComponentSolutionCacheSize( settings.testFlag( QgsLabelingEngineSettings::ReuseComponentSolutions ) ? settings.componentSolutionCacheSize() : 0 );
 
+  mCachedPlacementFeatures.clear();
+  if ( usesPlacementCache() )
+    mPlacementCacheMapHash = qHash( mMapSettings.destinationCrs().toWkt() );
 
   // for each provider: get labels and register them in PAL
   for ( QgsAbstractLabelProvider *provider : qgis::as_const( mProviders ) )
@@ -344,6 +456,10 @@ void QgsLabelingEngine::run( QgsRenderContext &context )
   {
     return;
   }
+
+  if ( usesPlacementCache() )
+    updatePlacementCache( labels, extent );
+
   painter->setRenderHint( QPainter::Antialiasing );
 
   // sort labels
@@ -438,9 +554,16 @@ void QgsLabelingEngine::run( QgsRenderContext &context )
   // Reset composition mode for further drawing operations
   painter->setCompositionMode( QPainter::CompositionMode_SourceOver );
 
+  QgsApplication::textLayoutCache()->updateProfilerCounters( QgsApplication::profiler() );
+
   QgsDebugMsgLevel( QStringLiteral( "LABELING draw:  %1 ms" ).arg( t.elapsed() ), 4 );
 }
 
+void QgsLabelingEngine::clearComponentSolutionCache()
+{
+  pal::Problem::clearComponentSolutionCache();
+}
+
 QgsLabelingResults *QgsLabelingEngine::takeResults()
 {
   return mResults.release();
@@ -246,12 +246,38 @@ class CORE_EXPORT QgsLabelingEngine
     //! Returns pointer to recently computed results and pass the ownership of results to the caller
     QgsLabelingResults *takeResults();
 
+    /**
+     * Clears the solutions of groups of conflicting labels which are kept for reuse by later
+     * renders (see QgsLabelingEngineSettings::ReuseComponentSolutions).
+     * \since QGIS 3.10
+     */
+    static void clearComponentSolutionCache();
+
     //! For internal use by the providers
     QgsLabelingResults *results() const { return mResults.get(); }
 
   protected:
     void processProvider( QgsAbstractLabelProvider *provider, QgsRenderContext &context, pal::Pal &p );
 
+    /**
+     * Returns TRUE if label placements are taken from and stored in the label placement cache.
+     * \since QGIS 3.10
+     */
+    bool usesPlacementCache() const;
+
+    /**
+     * Places \a feature at its cached placement, if there is a valid one.
+     * \since QGIS 3.10
+     */
+    void applyCachedPlacement( QgsAbstractLabelProvider *provider, QgsLabelFeature *feature );
+
+    /**
+     * Stores the placements of the solved \a labels in the label placement cache. Cached
+     * placements which lost a conflict within the labeling \a extent are removed.
+     * \since QGIS 3.10
+     */
+    void updatePlacementCache( const QList<pal::LabelPosition *> &labels, const QgsRectangle &extent );
+
   protected:
     //! Associated map settings instance
     QgsMapSettings mMapSettings;
@@ -263,6 +289,11 @@ class CORE_EXPORT QgsLabelingEngine
     //! Resulting labeling layout
     std::unique_ptr< QgsLabelingResults > mResults;
 
+    //! Features placed at their cached placement in the current run
+    QList< QgsLabelFeature * > mCachedPlacementFeatures;
+    //! Hash of the map settings which invalidate cached placements
+    uint mPlacementCacheMapHash = 0;
+
 };
 
 
@@ -19,7 +19,7 @@
 #include "qgssymbollayerutils.h"
 
 QgsLabelingEngineSettings::QgsLabelingEngineSettings()
-  : mFlags( UsePartialCandidates )
+  : mFlags( UsePartialCandidates | SplitConflictComponents )
 {
 }
 
@@ -42,6 +42,10 @@ void QgsLabelingEngineSettings::readSettingsFromProject( QgsProject *prj )
   if ( prj->readBoolEntry( QStringLiteral( "PAL" ), QStringLiteral( "/ShowingAllLabels" ), false, &saved ) ) mFlags |= UseAllLabels;
   if ( prj->readBoolEntry( QStringLiteral( "PAL" ), QStringLiteral( "/ShowingPartialsLabels" ), true, &saved ) ) mFlags |= UsePartialCandidates;
   if ( prj->readBoolEntry( QStringLiteral( "PAL" ), QStringLiteral( "/DrawUnplaced" ), false, &saved ) ) mFlags |= DrawUnplacedLabels;
+  if ( prj->readBoolEntry( QStringLiteral( "PAL" ), QStringLiteral( "/UsePlacementCache" ), false, &saved ) ) mFlags |= UsePlacementCache;
+  if ( prj->readBoolEntry( QStringLiteral( "PAL" ), QStringLiteral( "/SplitConflictComponents" ), true, &saved ) ) mFlags |= SplitConflictComponents;
+  if ( prj->readBoolEntry( QStringLiteral( "PAL" ), QStringLiteral( "/ReuseComponentSolutions" ), false, &saved ) ) mFlags |= ReuseComponentSolutions;
+  mComponentSolutionCacheSize = prj->readNumEntry( QStringLiteral( "PAL" ), QStringLiteral( "/ComponentSolutionCacheSize" ), 500000, &saved );
 
   mDefaultTextRenderFormat = QgsRenderContext::TextFormatAlwaysOutlines;
   // if users have disabled the older PAL "DrawOutlineLabels" setting, respect that
@@ -67,6 +71,10 @@ void QgsLabelingEngineSettings::writeSettingsToProject( QgsProject *project )
   project->writeEntry( QStringLiteral( "PAL" ), QStringLiteral( "/DrawUnplaced" ), mFlags.testFlag( DrawUnplacedLabels ) );
   project->writeEntry( QStringLiteral( "PAL" ), QStringLiteral( "/ShowingAllLabels" ), mFlags.testFlag( UseAllLabels ) );
   project->writeEntry( QStringLiteral( "PAL" ), QStringLiteral( "/ShowingPartialsLabels" ), mFlags.testFlag( UsePartialCandidates ) );
+  project->writeEntry( QStringLiteral( "PAL" ), QStringLiteral( "/UsePlacementCache" ), mFlags.testFlag( UsePlacementCache ) );
+  project->writeEntry( QStringLiteral( "PAL" ), QStringLiteral( "/SplitConflictComponents" ), mFlags.testFlag( SplitConflictComponents ) );
+  project->writeEntry( QStringLiteral( "PAL" ), QStringLiteral( "/ReuseComponentSolutions" ), mFlags.testFlag( ReuseComponentSolutions ) );
+  project->writeEntry( QStringLiteral( "PAL" ), QStringLiteral( "/ComponentSolutionCacheSize" ), mComponentSolutionCacheSize );
 
   project->writeEntry( QStringLiteral( "PAL" ), QStringLiteral( "/TextFormat" ), static_cast< int >( mDefaultTextRenderFormat ) );
 
@@ -39,6 +39,9 @@ class CORE_EXPORT QgsLabelingEngineSettings
       DrawLabelRectOnly     = 1 << 4,  //!< Whether to only draw the label rect and not the actual label text (used for unit tests)
       DrawCandidates        = 1 << 5,  //!< Whether to draw rectangles of generated candidates (good for debugging)
       DrawUnplacedLabels    = 1 << 6,  //!< Whether to render unplaced labels as an indicator/warning for users
+      UsePlacementCache     = 1 << 7,  //!< Whether to reuse label placements of previous renders, see QgsLabelPlacementCache (since QGIS 3.10)
+      SplitConflictComponents = 1 << 8,  //!< Whether to solve independent groups of conflicting labels separately and in parallel, enabled by default. The placements may differ slightly from solving all labels at once (since QGIS 3.10)
+      ReuseComponentSolutions = 1 << 9,  //!< Whether to reuse the solutions of unchanged groups of conflicting labels from previous renders, only used with SplitConflictComponents (since QGIS 3.10)
     };
     Q_DECLARE_FLAGS( Flags, Flag )
 
@@ -126,6 +129,24 @@ class CORE_EXPORT QgsLabelingEngineSettings
      */
     void setUnplacedLabelColor( const QColor &color );
 
+    /**
+     * Returns the maximum total number of label candidates of the solutions which
+     * are kept for reuse when the ReuseComponentSolutions flag is set.
+     *
+     * \see setComponentSolutionCacheSize()
+     * \since QGIS 3.10
+     */
+    int componentSolutionCacheSize() const { return mComponentSolutionCacheSize; }
+
+    /**
+     * Sets the maximum total number of label candidates of the solutions which
+     * are kept for reuse when the ReuseComponentSolutions flag is set.
+     *
+     * \see componentSolutionCacheSize()
+     * \since QGIS 3.10
+     */
+    void setComponentSolutionCacheSize( int size ) { mComponentSolutionCacheSize = size; }
+
   private:
     //! Flags
     Flags mFlags;
@@ -136,6 +157,8 @@ class CORE_EXPORT QgsLabelingEngineSettings
 
     QColor mUnplacedLabelColor = QColor( 255, 0, 0 );
 
+    int mComponentSolutionCacheSize = 500000;
+
     QgsRenderContext::TextRenderFormat mDefaultTextRenderFormat = QgsRenderContext::TextFormatAlwaysOutlines;
 
 };
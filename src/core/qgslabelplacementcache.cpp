@@ -0,0 +1,84 @@
+/***************************************************************************
+    qgslabelplacementcache.cpp
+    ---------------------
+    begin                : October 2019
+    copyright            : (C) 2019 by the QGIS project
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+#include "qgslabelplacementcache.h"
+
+#include <cmath>
+
+int QgsLabelPlacementCache::scaleBand( double scale )
+{
+  if ( !( scale > 0 ) )
+    return 0;
+  return static_cast< int >( std::floor( std::log2( scale ) * 4 ) );
+}
+
+bool QgsLabelPlacementCache::placement( const Key &key, Placement &placement ) const
+{
+  QMutexLocker locker( &mMutex );
+  if ( const Placement *cached = mPlacements.object( key ) )
+  {
+    placement = *cached;
+    return true;
+  }
+  return false;
+}
+
+void QgsLabelPlacementCache::insert( const Key &key, const Placement &placement )
+{
+  QMutexLocker locker( &mMutex );
+  mPlacements.insert( key, new Placement( placement ) );
+}
+
+void QgsLabelPlacementCache::remove( const Key &key )
+{
+  QMutexLocker locker( &mMutex );
+  mPlacements.remove( key );
+}
+
+void QgsLabelPlacementCache::removeLayer( const QString &layerId )
+{
+  QMutexLocker locker( &mMutex );
+  if ( mPlacements.isEmpty() )
+    return;
+
+  const QList< Key > keys = mPlacements.keys();
+  for ( const Key &key : keys )
+  {
+    if ( key.layerId == layerId )
+      mPlacements.remove( key );
+  }
+}
+
+void QgsLabelPlacementCache::clear()
+{
+  QMutexLocker locker( &mMutex );
+  mPlacements.clear();
+}
+
+int QgsLabelPlacementCache::count() const
+{
+  QMutexLocker locker( &mMutex );
+  return mPlacements.count();
+}
+
+void QgsLabelPlacementCache::setMaximumCount( int count )
+{
+  QMutexLocker locker( &mMutex );
+  mPlacements.setMaxCost( count );
+}
+
+int QgsLabelPlacementCache::maximumCount() const
+{
+  QMutexLocker locker( &mMutex );
+  return mPlacements.maxCost();
+}
@@ -0,0 +1,156 @@
+/***************************************************************************
+    qgslabelplacementcache.h
+    ---------------------
+    begin                : October 2019
+    copyright            : (C) 2019 by the QGIS project
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+#ifndef QGSLABELPLACEMENTCACHE_H
+#define QGSLABELPLACEMENTCACHE_H
+
+#define SIP_NO_FILE
+
+#include "qgis_core.h"
+#include "qgsfeatureid.h"
+
+#include <QCache>
+#include <QMutex>
+#include <QString>
+
+/**
+ * \ingroup core
+ * Keeps the placements of labels accepted by the labeling engine across
+ * map renders.
+ *
+ * When the QgsLabelingEngineSettings::UsePlacementCache flag is set, the
+ * labeling engine places labels which have been placed before for the
+ * same feature, label text and scale band at their previous position instead
+ * of generating candidates for them, so only new or changed labels are
+ * actually solved. This stabilizes labels between neighboring map tiles
+ * and saves most of the labeling work for tiled rendering.
+ *
+ * A cached placement is only used if the size of the label and the
+ * geometry of the feature did not change.
+ *
+ * The cache is thread safe, the application wide instance is returned by
+ * QgsApplication::labelPlacementCache().
+ *
+ * \note not available in Python bindings
+ * \since QGIS 3.10
+ */
+class CORE_EXPORT QgsLabelPlacementCache
+{
+  public:
+
+    //! Identifies the label of a feature
+    struct Key
+    {
+      //! ID of the labeled layer
+      QString layerId;
+      //! ID of the label provider, e.g. the rule of rule based labeling
+      QString providerId;
+      //! ID of the labeled feature
+      QgsFeatureId featureId = 0;
+      //! Hash of the label text
+      uint textHash = 0;
+      //! Scale band, see scaleBand()
+      int scaleBand = 0;
+
+      bool operator==( const Key &other ) const
+      {
+        return featureId == other.featureId && textHash == other.textHash && scaleBand == other.scaleBand
+               && layerId == other.layerId && providerId == other.providerId;
+      }
+    };
+
+    //! Position of a placed label in map units
+    struct Placement
+    {
+      //! X coordinate of the label origin
+      double x = 0;
+      //! Y coordinate of the label origin
+      double y = 0;
+      //! Width of the label
+      double width = 0;
+      //! Height of the label
+      double height = 0;
+      //! Angle of the label in radians
+      double angle = 0;
+      //! Quadrant of the label relative to its feature, a pal::LabelPosition::Quadrant value
+      int quadrant = 0;
+      //! TRUE if the label is reversed along its line
+      bool reversed = false;
+      //! Hash of the feature geometry and the map settings the label was placed with
+      uint signature = 0;
+    };
+
+    //! Default maximum number of cached placements
+    static const int DEFAULT_MAX_PLACEMENTS = 200000;
+
+    //! Constructor for QgsLabelPlacementCache
+    QgsLabelPlacementCache() = default;
+
+    //! QgsLabelPlacementCache cannot be copied
+    QgsLabelPlacementCache( const QgsLabelPlacementCache &rh ) = delete;
+    //! QgsLabelPlacementCache cannot be copied
+    QgsLabelPlacementCache &operator=( const QgsLabelPlacementCache &rh ) = delete;
+
+    /**
+     * Returns the scale band of a map \a scale. Labels are only reused within
+     * a band, each band spans a quarter of a factor of two.
+     */
+    static int scaleBand( double scale );
+
+    /**
+     * Looks up the placement stored for \a key. Returns FALSE if there is none,
+     * otherwise the placement is stored in \a placement.
+     */
+    bool placement( const Key &key, Placement &placement ) const;
+
+    //! Stores the \a placement of the label identified by \a key
+    void insert( const Key &key, const Placement &placement );
+
+    //! Removes the placement of the label identified by \a key
+    void remove( const Key &key );
+
+    //! Removes all placements of the layer with the given \a layerId
+    void removeLayer( const QString &layerId );
+
+    //! Removes all placements
+    void clear();
+
+    //! Returns the number of cached placements
+    int count() const;
+
+    /**
+     * Sets the maximum number of cached placements. The least recently used
+     * placements are dropped when the cache is full.
+     * \see maximumCount()
+     */
+    void setMaximumCount( int count );
+
+    /**
+     * Returns the maximum number of cached placements.
+     * \see setMaximumCount()
+     */
+    int maximumCount() const;
+
+  private:
+
+    mutable QMutex mMutex;
+    QCache< Key, Placement > mPlacements { DEFAULT_MAX_PLACEMENTS };
+};
+
+//! Hash for a label placement cache key
+inline uint qHash( const QgsLabelPlacementCache::Key &key, uint seed = 0 )
+{
+  return qHash( key.layerId, seed ) ^ qHash( key.providerId ) ^ qHash( key.featureId ) ^ key.textHash ^ qHash( key.scaleBand );
+}
+
+#endif // QGSLABELPLACEMENTCACHE_H
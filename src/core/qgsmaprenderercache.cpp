@@ -17,6 +17,10 @@
 
 #include "qgsmaplayer.h"
 #include "qgsmaplayerlistutils.h"
+#include "qgsvectorlayer.h"
+
+#include <QPainter>
+#include <cmath>
 
 QgsMapRendererCache::QgsMapRendererCache()
 {
@@ -39,10 +43,7 @@ void QgsMapRendererCache::clearInternal()
   for ( const QgsWeakMapLayerPointer &layer : constMConnectedLayers )
   {
     if ( layer.data() )
-    {
-      disconnect( layer.data(), &QgsMapLayer::repaintRequested, this, &QgsMapRendererCache::layerRequestedRepaint );
-      disconnect( layer.data(), &QgsMapLayer::willBeDeleted, this, &QgsMapRendererCache::layerRequestedRepaint );
-    }
+      disconnect( layer.data(), nullptr, this, nullptr );
   }
   mCachedImages.clear();
   mConnectedLayers.clear();
@@ -56,10 +57,7 @@ void QgsMapRendererCache::dropUnusedConnections()
   for ( const QgsWeakMapLayerPointer &layer : constDisconnects )
   {
     if ( layer.data() )
-    {
-      disconnect( layer.data(), &QgsMapLayer::repaintRequested, this, &QgsMapRendererCache::layerRequestedRepaint );
-      disconnect( layer.data(), &QgsMapLayer::willBeDeleted, this, &QgsMapRendererCache::layerRequestedRepaint );
-    }
+      disconnect( layer.data(), nullptr, this, nullptr );
   }
 
   mConnectedLayers = stillDepends;
@@ -90,7 +88,10 @@ bool QgsMapRendererCache::init( const QgsRectangle &extent, double scale )
        qgsDoubleNear( scale, mScale ) )
     return true;
 
-  clearInternal();
+  // images rendered at a different scale are useless, but after a pan
+  // we keep them around so that pannedCacheImage() can reuse them
+  if ( !qgsDoubleNear( scale, mScale ) )
+    clearInternal();
 
   // set new params
   mExtent = extent;
@@ -105,6 +106,7 @@ void QgsMapRendererCache::setCacheImage( const QString &cacheKey, const QImage &
 
   CacheParameters params;
   params.cachedImage = image;
+  params.extent = mExtent;
 
   // connect to the layer to listen to layer's repaintRequested() signals
   const auto constDependentLayers = dependentLayers;
@@ -116,7 +118,18 @@ void QgsMapRendererCache::setCacheImage( const QString &cacheKey, const QImage &
       if ( !mConnectedLayers.contains( QgsWeakMapLayerPointer( layer ) ) )
       {
         connect( layer, &QgsMapLayer::repaintRequested, this, &QgsMapRendererCache::layerRequestedRepaint );
-        connect( layer, &QgsMapLayer::willBeDeleted, this, &QgsMapRendererCache::layerRequestedRepaint );
+        connect( layer, &QgsMapLayer::willBeDeleted, this, &QgsMapRendererCache::removeLayerImages );
+        if ( QgsVectorLayer *vl = qobject_cast< QgsVectorLayer * >( layer ) )
+        {
+          connect( vl, &QgsVectorLayer::areaModified, this, &QgsMapRendererCache::layerAreaModified );
+          connect( vl, &QgsVectorLayer::layerModified, this, &QgsMapRendererCache::layerModified );
+          // changed attributes and fields may change the symbology of any feature
+          connect( vl, &QgsVectorLayer::attributeValueChanged, this, &QgsMapRendererCache::removeLayerImages );
+          connect( vl, &QgsVectorLayer::updatedFields, this, &QgsMapRendererCache::removeLayerImages );
+          // vertex markers are only drawn while the layer is being edited
+          connect( vl, &QgsVectorLayer::editingStarted, this, &QgsMapRendererCache::removeLayerImages );
+          connect( vl, &QgsVectorLayer::editingStopped, this, &QgsMapRendererCache::removeLayerImages );
+        }
         mConnectedLayers << layer;
       }
     }
@@ -127,13 +140,79 @@ void QgsMapRendererCache::setCacheImage( const QString &cacheKey, const QImage &
 
 bool QgsMapRendererCache::hasCacheImage( const QString &cacheKey ) const
 {
-  return mCachedImages.contains( cacheKey );
+  QMutexLocker lock( &mMutex );
+  QMap<QString, CacheParameters>::const_iterator it = mCachedImages.constFind( cacheKey );
+  return it != mCachedImages.constEnd() && it.value().extent == mExtent && !it.value().dirty;
 }
 
 QImage QgsMapRendererCache::cacheImage( const QString &cacheKey ) const
 {
   QMutexLocker lock( &mMutex );
-  return mCachedImages.value( cacheKey ).cachedImage;
+  QMap<QString, CacheParameters>::const_iterator it = mCachedImages.constFind( cacheKey );
+  if ( it == mCachedImages.constEnd() || it.value().extent != mExtent || it.value().dirty )
+    return QImage();
+
+  return it.value().cachedImage;
+}
+
+QImage QgsMapRendererCache::pannedCacheImage( const QString &cacheKey, QRect *reusedArea ) const
+{
+  if ( reusedArea )
+    *reusedArea = QRect();
+
+  QMutexLocker lock( &mMutex );
+  QMap<QString, CacheParameters>::const_iterator it = mCachedImages.constFind( cacheKey );
+  if ( it == mCachedImages.constEnd() || it.value().dirty )
+    return QImage();
+
+  const QImage &source = it.value().cachedImage;
+  const QgsRectangle &sourceExtent = it.value().extent;
+  if ( source.isNull() || sourceExtent.isEmpty() || mExtent.isEmpty() )
+    return QImage();
+
+  // the previous render must match the current one pixel for pixel, only shifted
+  const double pixelWidth = mExtent.width() / source.width();
+  const double pixelHeight = mExtent.height() / source.height();
+  if ( std::fabs( sourceExtent.width() - mExtent.width() ) > 0.01 * pixelWidth
+       || std::fabs( sourceExtent.height() - mExtent.height() ) > 0.01 * pixelHeight )
+    return QImage();
+
+  const double dx = ( sourceExtent.xMinimum() - mExtent.xMinimum() ) / pixelWidth;
+  const double dy = ( mExtent.yMaximum() - sourceExtent.yMaximum() ) / pixelHeight;
+  const QPoint offset( static_cast< int >( std::round( dx ) ), static_cast< int >( std::round( dy ) ) );
+  if ( std::fabs( dx - offset.x() ) > 0.05 || std::fabs( dy - offset.y() ) > 0.05 )
+    return QImage();
+
+  const QRect reused = QRect( offset, source.size() ).intersected( source.rect() );
+  if ( reused.isEmpty() )
+    return QImage();
+
+  QImage result( source.size(), source.format() );
+  result.fill( Qt::transparent );
+  QPainter painter( &result );
+  painter.setCompositionMode( QPainter::CompositionMode_Source );
+  painter.drawImage( reused, source, reused.translated( -offset ) );
+  painter.end();
+  result.setDevicePixelRatio( source.devicePixelRatio() );
+
+  if ( reusedArea )
+    *reusedArea = reused;
+  return result;
+}
+
+QImage QgsMapRendererCache::dirtyCacheImage( const QString &cacheKey, QgsRectangle *dirtyExtent ) const
+{
+  if ( dirtyExtent )
+    *dirtyExtent = QgsRectangle();
+
+  QMutexLocker lock( &mMutex );
+  QMap<QString, CacheParameters>::const_iterator it = mCachedImages.constFind( cacheKey );
+  if ( it == mCachedImages.constEnd() || it.value().extent != mExtent || !it.value().dirty )
+    return QImage();
+
+  if ( dirtyExtent )
+    *dirtyExtent = it.value().dirtyExtent;
+  return it.value().cachedImage;
 }
 
 QList< QgsMapLayer * > QgsMapRendererCache::dependentLayers( const QString &cacheKey ) const
@@ -153,11 +232,87 @@ void QgsMapRendererCache::layerRequestedRepaint()
 
   QMutexLocker lock( &mMutex );
 
+  // the repaint which follows an edit of the layer's features only needs
+  // the edited area of the layer's own image to be rendered again
+  bool keepLayerImage = false;
+  QMap<QString, CacheParameters>::iterator it = mCachedImages.find( layer->id() );
+  if ( it != mCachedImages.end() && it.value().editRepaintPending )
+  {
+    it.value().editRepaintPending = false;
+    keepLayerImage = true;
+  }
+  removeDependentImages( layer, keepLayerImage );
+}
+
+void QgsMapRendererCache::removeLayerImages()
+{
+  QgsMapLayer *layer = qobject_cast<QgsMapLayer *>( sender() );
+  if ( !layer )
+    return;
+
+  QMutexLocker lock( &mMutex );
+  removeDependentImages( layer, false );
+}
+
+void QgsMapRendererCache::layerAreaModified( const QgsRectangle &extent )
+{
+  QgsMapLayer *layer = qobject_cast<QgsMapLayer *>( sender() );
+  if ( !layer )
+    return;
+
+  QMutexLocker lock( &mMutex );
+
+  QMap<QString, CacheParameters>::iterator it = mCachedImages.find( layer->id() );
+  if ( it != mCachedImages.end() )
+  {
+    CacheParameters &params = it.value();
+    if ( params.dirty )
+    {
+      // not using combineExtentWith(), which would skip a point at the origin
+      params.dirtyExtent.set( std::min( params.dirtyExtent.xMinimum(), extent.xMinimum() ),
+                              std::min( params.dirtyExtent.yMinimum(), extent.yMinimum() ),
+                              std::max( params.dirtyExtent.xMaximum(), extent.xMaximum() ),
+                              std::max( params.dirtyExtent.yMaximum(), extent.yMaximum() ) );
+    }
+    else
+    {
+      params.dirtyExtent = extent;
+      params.dirty = true;
+    }
+    params.areaReported = true;
+    params.editRepaintPending = true;
+  }
+
+  // labels and other images are not rendered piecewise
+  removeDependentImages( layer, true );
+}
+
+void QgsMapRendererCache::layerModified()
+{
+  QgsMapLayer *layer = qobject_cast<QgsMapLayer *>( sender() );
+  if ( !layer )
+    return;
+
+  QMutexLocker lock( &mMutex );
+
+  // a modification which did not report the area it affects may have changed anything
+  bool keepLayerImage = false;
+  QMap<QString, CacheParameters>::iterator it = mCachedImages.find( layer->id() );
+  if ( it != mCachedImages.end() && it.value().areaReported )
+  {
+    it.value().areaReported = false;
+    keepLayerImage = true;
+  }
+  removeDependentImages( layer, keepLayerImage );
+}
+
+void QgsMapRendererCache::removeDependentImages( QgsMapLayer *layer, bool keepLayerImage )
+{
   // check through all cached images to clear any which depend on this layer
   QMap<QString, CacheParameters>::iterator it = mCachedImages.begin();
   for ( ; it != mCachedImages.end(); )
   {
-    if ( !it.value().dependentLayers.contains( layer ) )
+    if ( !it.value().dependentLayers.contains( layer ) || ( keepLayerImage && it.key() == layer->id() ) )
     {
       ++it;
       continue;
@@ -35,6 +35,13 @@
  * If triggered, the cache removes the rendered image (and disconnects from the
  * layers).
  *
+ * When features of a dependent vector layer are added, deleted or have their geometry
+ * changed in the layer's edit buffer, the image rendered from that layer is kept, including
+ * through the repaint which follows the edit. Only the area covered by the edited features
+ * is marked as out of date (see dirtyCacheImage()), so that just this area needs to be rendered
+ * again. Other images depending on the layer, like the labels, are removed. Any other
+ * modification of the layer's edit buffer removes all images depending on the layer.
+ *
  * The class is thread-safe (multiple classes can access the same instance safely).
  *
  * \since QGIS 2.4
@@ -53,8 +60,14 @@ class CORE_EXPORT QgsMapRendererCache : public QObject
     void clear();
 
     /**
-     * Initialize cache: set new parameters and clears the cache if any
-     * parameters have changed since last initialization.
+     * Initialize cache: set new parameters and clears the cache if the
+     * scale has changed since last initialization.
+     *
+     * If only the extent has changed (e.g. after panning the map) the cached
+     * images are kept, but they are no longer reported by hasCacheImage() or
+     * cacheImage(). The part of them which overlaps the new extent can be retrieved
+     * via pannedCacheImage().
+     *
      * \returns flag whether the parameters are the same as last time
      */
     bool init( const QgsRectangle &extent, double scale );
@@ -85,6 +98,36 @@ class CORE_EXPORT QgsMapRendererCache : public QObject
      */
     QImage cacheImage( const QString &cacheKey ) const;
 
+    /**
+     * Returns the image cached for \a cacheKey at a previous extent, shifted so that it
+     * lines up with the current extent of the cache.
+     *
+     * This is only possible if the previous image was rendered at the same scale and
+     * size, with the extents offset by a whole number of pixels (as happens when panning
+     * the map). Parts of the returned image which were not covered by the previous render
+     * are left transparent, and the area which was filled from the previous render is
+     * stored in \a reusedArea (in device pixels).
+     *
+     * Returns a null image if no suitable image is cached.
+     *
+     * \see cacheImage()
+     * \since QGIS 3.10
+     */
+    QImage pannedCacheImage( const QString &cacheKey, QRect *reusedArea SIP_OUT = nullptr ) const;
+
+    /**
+     * Returns the image cached for \a cacheKey at the current extent if parts of it are out
+     * of date, because features of the layer it is a render of have been edited since it
+     * was rendered. The out of date area is stored in \a dirtyExtent (in the layer's CRS), and
+     * only this area of the image needs to be rendered again.
+     *
+     * Returns a null image if no image is cached for \a cacheKey at the current extent, or if
+     * the cached image is entirely up to date (see cacheImage()).
+     *
+     * \since QGIS 3.10
+     */
+    QImage dirtyCacheImage( const QString &cacheKey, QgsRectangle *dirtyExtent SIP_OUT = nullptr ) const;
+
     /**
      * Returns a list of map layers on which an image in the cache depends.
      * \since QGIS 3.0
@@ -101,17 +144,42 @@ class CORE_EXPORT QgsMapRendererCache : public QObject
     //! Remove layer (that emitted the signal) from the cache
     void layerRequestedRepaint();
 
+    //! Remove layer (that emitted the signal) from the cache, including an image kept after an edit
+    void removeLayerImages();
+
+    //! Mark an area of the image of the layer (that emitted the signal) as out of date
+    void layerAreaModified( const QgsRectangle &extent );
+
+    //! Remove layer (that emitted the signal) from the cache unless the area of the modification was reported
+    void layerModified();
+
   private:
 
     struct CacheParameters
     {
       QImage cachedImage;
+      //! Extent of the cache when the image was stored
+      QgsRectangle extent;
       QgsWeakMapLayerPointerList dependentLayers;
+      //! TRUE if parts of the image are out of date after an edit of the layer
+      bool dirty = false;
+      //! Area (in layer CRS) of the image which is out of date
+      QgsRectangle dirtyExtent;
+      //! TRUE if an area was reported since the layer last emitted layerModified()
+      bool areaReported = false;
+      //! TRUE if the layer was edited since its last repaint request
+      bool editRepaintPending = false;
     };
 
     //! Invalidate cache contents (without locking)
     void clearInternal();
 
+    /**
+     * Removes all images depending on \a layer (without locking), except for the
+     * image rendered from the layer itself if \a keepLayerImage is TRUE.
+     */
+    void removeDependentImages( QgsMapLayer *layer, bool keepLayerImage );
+
     //! Disconnects from layers we no longer care about
     void dropUnusedConnections();
 
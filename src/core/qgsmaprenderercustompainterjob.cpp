@@ -259,7 +259,7 @@ void QgsMapRendererCustomPainterJob::doRender()
       QTime layerTime;
       layerTime.start();
 
-      if ( job.img )
+      if ( job.img && !job.imageInitialized )
       {
         job.img->fill( 0 );
         job.imageInitialized = true;
@@ -16,9 +16,12 @@
 #include "qgsmaprendererjob.h"
 
 #include <QPainter>
+#include <QPainterPath>
+#include <QSet>
 #include <QTime>
 #include <QTimer>
 #include <QtConcurrentMap>
+#include <QThreadPool>
 
 #include "qgslogger.h"
 #include "qgsrendercontext.h"
@@ -31,17 +34,28 @@
 #include "qgspallabeling.h"
 #include "qgsvectorlayerrenderer.h"
 #include "qgsvectorlayer.h"
+#include "qgsrenderer.h"
 #include "qgsexception.h"
 #include "qgslabelingengine.h"
 #include "qgsmaplayerlistutils.h"
 #include "qgsvectorlayerlabeling.h"
 #include "qgssettings.h"
 #include "qgsexpressioncontextutils.h"
+#include "qgssymbol.h"
+#include "qgssymbollayer.h"
+#include "qgsmarkersymbollayer.h"
+#include "qgssymbollayerutils.h"
+#include "qgspainteffect.h"
 
 ///@cond PRIVATE
 
 const QString QgsMapRendererJob::LABEL_CACHE_ID = QStringLiteral( "_labels_" );
 
+//! Margin (in pixels) added to the estimated symbol bleed around a partially rendered area of the map, for antialiasing
+static const double SYMBOL_BLEED_MARGIN = 2;
+//! Minimum height (in device pixels) of the tiles a layer is split into for parallel rendering
+static const int MINIMUM_RENDER_TILE_HEIGHT = 64;
+
 QgsMapRendererJob::QgsMapRendererJob( const QgsMapSettings &settings )
   : mSettings( settings )
 
@@ -218,6 +232,241 @@ bool QgsMapRendererJob::reprojectToLayerExtent( const QgsMapLayer *ml, const Qgs
   return split;
 }
 
+bool QgsMapRendererJob::canRenderPiecewise( QgsMapLayer *ml )
+{
+  // only vector renderers whose output for a feature does not depend on the
+  // other features within the rendered extent
+  QgsVectorLayer *vl = qobject_cast<QgsVectorLayer *>( ml );
+  if ( !vl || !vl->renderer() )
+    return false;
+
+  const QString rendererType = vl->renderer()->type();
+  return rendererType == QLatin1String( "singleSymbol" )
+         || rendererType == QLatin1String( "categorizedSymbol" )
+         || rendererType == QLatin1String( "graduatedSymbol" )
+         || rendererType == QLatin1String( "RuleRenderer" )
+         || rendererType == QLatin1String( "nullSymbol" );
+}
+
+// Returns TRUE if the line or fill symbol layer type \a layerType estimates its maximum bleed, or
+// draws within the feature's geometry
+static bool symbolLayerEstimatesBleed( const QString &layerType )
+{
+  static const QSet< QString > sLayerTypes
+  {
+    QStringLiteral( "SimpleLine" ),
+    QStringLiteral( "MarkerLine" ),
+    QStringLiteral( "HashLine" ),
+    QStringLiteral( "SimpleFill" ),
+    QStringLiteral( "GradientFill" ),
+    QStringLiteral( "ShapeburstFill" ),
+    QStringLiteral( "SVGFill" ),
+    QStringLiteral( "RasterFill" ),
+    QStringLiteral( "LinePatternFill" ),
+    QStringLiteral( "PointPatternFill" ),
+    QStringLiteral( "CentroidFill" ),
+  };
+  return sLayerTypes.contains( layerType );
+}
+
+// Returns how far (in pixels) \a symbol may reach beyond a feature's geometry, or -1 if unknown
+static double symbolBleed( QgsSymbol *symbol, const QgsRenderContext &context )
+{
+  // the size of the symbol may change from one feature to the next
+  if ( symbol->hasDataDefinedProperties() )
+    return -1;
+
+  double maxBleed = QgsSymbolLayerUtils::estimateMaxSymbolBleed( symbol, context );
+  for ( int i = 0; i < symbol->symbolLayerCount(); ++i )
+  {
+    const QgsSymbolLayer *layer = symbol->symbolLayer( i );
+    if ( layer->paintEffect() && layer->paintEffect()->enabled() )
+      return -1;
+
+    double layerBleed = 0;
+    if ( layer->type() == QgsSymbol::Marker )
+    {
+      // marker symbol layers don't estimate their bleed, so derive it from their size
+      // (allowing for rotated symbols) for the markers which are drawn within it
+      const QgsMarkerSymbolLayer *marker = static_cast< const QgsMarkerSymbolLayer * >( layer );
+      double size = context.convertToPainterUnits( marker->size(), marker->sizeUnit(), marker->sizeMapUnitScale() );
+      if ( layer->layerType() == QLatin1String( "SimpleMarker" ) )
+      {
+        const QgsSimpleMarkerSymbolLayer *simpleMarker = static_cast< const QgsSimpleMarkerSymbolLayer * >( layer );
+        size += context.convertToPainterUnits( simpleMarker->strokeWidth(), simpleMarker->strokeWidthUnit(), simpleMarker->strokeWidthMapUnitScale() );
+      }
+      else if ( layer->layerType() == QLatin1String( "SvgMarker" ) )
+      {
+        const QgsSvgMarkerSymbolLayer *svgMarker = static_cast< const QgsSvgMarkerSymbolLayer * >( layer );
+        // without a fixed aspect ratio, the height of the marker depends on the SVG content
+        if ( svgMarker->fixedAspectRatio() <= 0 )
+          return -1;
+        size *= std::max( 1.0, svgMarker->fixedAspectRatio() );
+      }
+      else if ( layer->layerType() != QLatin1String( "FilledMarker" ) )
+      {
+        return -1;
+      }
+      const QPointF offset = marker->offset();
+      layerBleed = size * M_SQRT1_2 + context.convertToPainterUnits( std::sqrt( offset.x() * offset.x() + offset.y() * offset.y() ), marker->offsetUnit(), marker->offsetMapUnitScale() );
+    }
+    else if ( !symbolLayerEstimatesBleed( layer->layerType() ) )
+    {
+      // e.g. arrows, geometry generators or symbol layers of plugins
+      return -1;
+    }
+
+    // e.g. markers placed along lines or at polygon centroids
+    if ( QgsSymbol *subSymbol = const_cast< QgsSymbolLayer * >( layer )->subSymbol() )
+    {
+      const double subSymbolBleed = symbolBleed( subSymbol, context );
+      if ( subSymbolBleed < 0 )
+        return -1;
+      layerBleed += subSymbolBleed;
+    }
+
+    maxBleed = std::max( maxBleed, layerBleed );
+  }
+  return maxBleed;
+}
+
+double QgsMapRendererJob::estimateSymbolBleed( QgsMapLayer *ml, QgsRenderContext &context )
+{
+  QgsVectorLayer *vl = qobject_cast<QgsVectorLayer *>( ml );
+  if ( !vl || !vl->renderer() )
+    return -1;
+
+  QgsFeatureRenderer *renderer = vl->renderer();
+  if ( renderer->paintEffect() && renderer->paintEffect()->enabled() )
+    return -1;
+
+  double maxBleed = 0;
+  const QgsSymbolList symbols = renderer->symbols( context );
+  for ( QgsSymbol *symbol : symbols )
+  {
+    if ( !symbol )
+      continue;
+
+    const double bleed = symbolBleed( symbol, context );
+    if ( bleed < 0 )
+      return -1;
+    maxBleed = std::max( maxBleed, bleed );
+  }
+  return maxBleed;
+}
+
+bool QgsMapRendererJob::canReuseCachedImage( QgsMapLayer *ml ) const
+{
+  if ( !qgsDoubleNear( mSettings.rotation(), 0.0 ) )
+    return false;
+
+  QgsVectorLayer *vl = qobject_cast<QgsVectorLayer *>( ml );
+  return vl && canRenderPiecewise( vl );
+}
+
+bool QgsMapRendererJob::prepareTiles( LayerRenderJob &job, const QgsCoordinateTransform &ct )
+{
+  QgsVectorLayer *vl = qobject_cast<QgsVectorLayer *>( job.layer.data() );
+  if ( !vl || !job.img || !canRenderPiecewise( vl ) )
+    return false;
+
+  // labels and diagrams would be registered once per tile
+  if ( job.context.labelingEngine() && QgsPalLabeling::staticWillUseLayer( vl ) )
+    return false;
+
+  // with symbol levels, the order in which overlapping symbols are painted across a tile
+  // edge would depend on which features each tile fetched, leaving visible seams
+  if ( vl->renderer()->usingSymbolLevels() )
+    return false;
+
+  // features just outside a tile may have symbols reaching into it, so the tiles
+  // can only be rendered separately if this reach is known
+  const double bleed = estimateSymbolBleed( vl, job.context );
+  if ( bleed < 0 )
+    return false;
+
+  const int height = job.img->height();
+  const int tileCount = std::min( QThreadPool::globalInstance()->maxThreadCount(), height / MINIMUM_RENDER_TILE_HEIGHT );
+  if ( tileCount < 2 )
+    return false;
+
+  const qreal dpr = job.img->devicePixelRatio();
+  const QgsMapToPixel &mtp = mSettings.mapToPixel();
+  const double marginPixels = bleed + SYMBOL_BLEED_MARGIN + mSettings.extentBuffer() / mtp.mapUnitsPerPixel();
+
+  // tiles are horizontal bands of the layer image, so that each tile can paint
+  // directly into the shared image data without any compositing
+  for ( int i = 0; i < tileCount; ++i )
+  {
+    const int top = height * i / tileCount;
+    const int bottom = height * ( i + 1 ) / tileCount;
+
+    // features just outside the band may have symbols reaching into it, so
+    // fetch features from a slightly larger area than the one which will be painted
+    const double logicalTop = top / dpr - marginPixels;
+    const double logicalBottom = bottom / dpr + marginPixels;
+    const double logicalLeft = -marginPixels;
+    const double logicalRight = job.img->width() / dpr + marginPixels;
+    QgsRectangle tileExtent( mtp.toMapCoordinates( logicalLeft, logicalTop ), mtp.toMapCoordinates( logicalRight, logicalBottom ) );
+    tileExtent.combineExtentWith( mtp.toMapCoordinates( logicalLeft, logicalBottom ) );
+    tileExtent.combineExtentWith( mtp.toMapCoordinates( logicalRight, logicalTop ) );
+
+    QgsRectangle tileExtent2;
+    if ( ct.isValid() )
+      reprojectToLayerExtent( vl, ct, tileExtent, tileExtent2 );
+    if ( !tileExtent.isFinite() || !tileExtent2.isFinite() )
+    {
+      cleanupTiles( job );
+      return false;
+    }
+
+    LayerRenderTile tile;
+    tile.img = new QImage( job.img->scanLine( top ), job.img->width(), bottom - top, job.img->bytesPerLine(), job.img->format() );
+    tile.img->setDevicePixelRatio( dpr );
+
+    QPainter *painter = new QPainter( tile.img );
+    painter->setRenderHint( QPainter::Antialiasing, mSettings.testFlag( QgsMapSettings::Antialiasing ) );
+    painter->translate( 0, -top / dpr );
+
+    tile.context = job.context;
+    tile.context.setPainter( painter );
+    tile.context.setLabelingEngine( nullptr );
+    tile.context.setExtent( tileExtent );
+    tile.renderer = vl->createMapRenderer( tile.context );
+    job.tiles.append( tile );
+  }
+
+  return true;
+}
+
+void QgsMapRendererJob::cleanupTiles( LayerRenderJob &job )
+{
+  QStringList errors;
+  for ( LayerRenderTile &tile : job.tiles )
+  {
+    delete tile.context.painter();
+    tile.context.setPainter( nullptr );
+    delete tile.img;
+    tile.img = nullptr;
+
+    if ( tile.renderer )
+    {
+      const QStringList tileErrors = tile.renderer->errors();
+      for ( const QString &message : tileErrors )
+      {
+        if ( !errors.contains( message ) )
+        {
+          errors << message;
+          mErrors.append( Error( tile.renderer->layerId(), message ) );
+        }
+      }
+      delete tile.renderer;
+      tile.renderer = nullptr;
+    }
+  }
+  job.tiles.clear();
+}
+
 LayerRenderJobs QgsMapRendererJob::prepareJobs( QPainter *painter, QgsLabelingEngine *labelingEngine2 )
 {
   LayerRenderJobs layerJobs;
@@ -269,14 +518,15 @@ LayerRenderJobs QgsMapRendererJob::prepareJobs( QPainter *painter, QgsLabelingEn
       continue;
     }
 
-    // Force render of layers that are being edited
-    // or if there's a labeling engine that needs the layer to register features
+    // Force render of layers that are being edited (unless the cache tracks their edits, see
+    // QgsMapRendererCache::dirtyCacheImage()) or if there's a labeling engine that needs the
+    // layer to register features
     if ( mCache && ml->type() == QgsMapLayerType::VectorLayer )
     {
       QgsVectorLayer *vl = qobject_cast<QgsVectorLayer *>( ml );
       bool requiresLabeling = false;
       requiresLabeling = ( labelingEngine2 && QgsPalLabeling::staticWillUseLayer( vl ) ) && requiresLabelRedraw;
-      if ( vl->isEditable() || requiresLabeling )
+      if ( ( vl->isEditable() && !canReuseCachedImage( vl ) ) || requiresLabeling )
       {
         mCache->clearCacheImage( ml->id() );
       }
@@ -322,6 +572,90 @@ LayerRenderJobs QgsMapRendererJob::prepareJobs( QPainter *painter, QgsLabelingEn
       continue;
     }
 
+    // after a pan at the same scale, reuse the overlapping part of the previous render
+    // and only render the newly exposed area of the map. After features have been edited,
+    // only render the part of the previous render covered by the edited features again.
+    QRect reusedArea;
+    QgsRectangle dirtyExtent;
+    QImage reusedImage;
+    bool edited = false;
+    if ( mCache && canReuseCachedImage( ml ) )
+    {
+      reusedImage = mCache->dirtyCacheImage( ml->id(), &dirtyExtent );
+      edited = !reusedImage.isNull();
+      if ( !edited )
+        reusedImage = mCache->pannedCacheImage( ml->id(), &reusedArea );
+    }
+    if ( !reusedImage.isNull() && reusedImage.size() == mSettings.deviceOutputSize() )
+    {
+      const qreal dpr = static_cast<qreal>( mSettings.devicePixelRatio() );
+      const QgsMapToPixel &mtp = mSettings.mapToPixel();
+
+      // features just outside the exposed area may have symbols reaching into it, so
+      // fetch features from a larger area than the one which will be painted. If the
+      // symbols' reach is unknown, the layer is rendered in full instead.
+      const double bleed = estimateSymbolBleed( ml, job.context );
+
+      QPainterPath exposedPath;
+      if ( edited )
+      {
+        // the symbols of the edited features, and their vertex markers while the layer is
+        // being edited, reach beyond their bounding boxes
+        double margin = bleed + SYMBOL_BLEED_MARGIN;
+        QgsVectorLayer *vl = qobject_cast<QgsVectorLayer *>( ml );
+        if ( vl->editBuffer() )
+          margin += job.context.convertToPainterUnits( QgsSettings().value( QStringLiteral( "qgis/digitizing/marker_size_mm" ), 2.0 ).toDouble(), QgsUnitTypes::RenderMillimeters ) / 2;
+
+        const QgsRectangle dirtyMapExtent = mSettings.layerExtentToOutputExtent( ml, dirtyExtent );
+        const QgsPointXY topLeft = mtp.transform( dirtyMapExtent.xMinimum(), dirtyMapExtent.yMaximum() );
+        const QgsPointXY bottomRight = mtp.transform( dirtyMapExtent.xMaximum(), dirtyMapExtent.yMinimum() );
+        const QRectF dirtyRect = QRectF( QPointF( topLeft.x(), topLeft.y() ), QPointF( bottomRight.x(), bottomRight.y() ) ).normalized();
+        exposedPath.addRect( dirtyRect.adjusted( -margin, -margin, margin, margin ).intersected( QRectF( QPointF( 0, 0 ), QSizeF( mSettings.outputSize() ) ) ) );
+      }
+      else
+      {
+        exposedPath.addRect( QRectF( QPointF( 0, 0 ), QSizeF( mSettings.outputSize() ) ) );
+        QPainterPath reusedPath;
+        reusedPath.addRect( QRectF( reusedArea.x() / dpr, reusedArea.y() / dpr, reusedArea.width() / dpr, reusedArea.height() / dpr ) );
+        exposedPath = exposedPath.subtracted( reusedPath );
+      }
+
+      const QRectF exposedRect = exposedPath.boundingRect();
+      QgsRectangle exposedExtent( mtp.toMapCoordinates( exposedRect.left(), exposedRect.top() ),
+                                  mtp.toMapCoordinates( exposedRect.right(), exposedRect.bottom() ) );
+      exposedExtent.normalize();
+      exposedExtent.grow( ( bleed + SYMBOL_BLEED_MARGIN ) * mtp.mapUnitsPerPixel() + mSettings.extentBuffer() );
+
+      QgsRectangle exposedExtent2;
+      if ( bleed >= 0 && ct.isValid() )
+        reprojectToLayerExtent( ml, ct, exposedExtent, exposedExtent2 );
+
+      if ( bleed >= 0 && exposedExtent.isFinite() && exposedExtent2.isFinite() )
+      {
+        job.img = new QImage( reusedImage );
+        job.img->setDevicePixelRatio( dpr );
+        job.imageInitialized = true;
+
+        QPainter *mypPainter = new QPainter( job.img );
+        // erase the out of date render of the edited features
+        mypPainter->setCompositionMode( QPainter::CompositionMode_Clear );
+        mypPainter->fillPath( exposedPath, Qt::transparent );
+        mypPainter->setCompositionMode( QPainter::CompositionMode_SourceOver );
+        mypPainter->setRenderHint( QPainter::Antialiasing, mSettings.testFlag( QgsMapSettings::Antialiasing ) );
+        mypPainter->setClipPath( exposedPath );
+        job.context.setPainter( mypPainter );
+        job.context.setExtent( exposedExtent );
+
+        QgsDebugMsgLevel( QStringLiteral( "Reusing cached image for %1, rendering %2" ).arg( ml->id(), exposedExtent.toString() ), 2 );
+
+        QTime layerTime;
+        layerTime.start();
+        job.renderer = ml->createMapRenderer( job.context );
+        job.renderingTime = layerTime.elapsed();
+        continue;
+      }
+    }
+
     // If we are drawing with an alternative blending mode then we need to render to a separate image
     // before compositing this on the map. This effectively flattens the layer and prevents
     // blending occurring between objects on the layer
@@ -347,7 +681,8 @@ LayerRenderJobs QgsMapRendererJob::prepareJobs( QPainter *painter, QgsLabelingEn
 
     QTime layerTime;
     layerTime.start();
-    job.renderer = ml->createMapRenderer( job.context );
+    if ( painter || !mSettings.testFlag( QgsMapSettings::RenderLayerTilesInParallel ) || !prepareTiles( job, ct ) )
+      job.renderer = ml->createMapRenderer( job.context );
     job.renderingTime = layerTime.elapsed(); // include job preparation time in layer rendering time
   } // while (li.hasPrevious())
 
@@ -403,6 +738,10 @@ void QgsMapRendererJob::cleanupJobs( LayerRenderJobs &jobs )
   for ( LayerRenderJobs::iterator it = jobs.begin(); it != jobs.end(); ++it )
   {
     LayerRenderJob &job = *it;
+
+    // tiles paint into the layer image, so they must be gone before it is used
+    cleanupTiles( job );
+
     if ( job.img )
     {
       delete job.context.painter();
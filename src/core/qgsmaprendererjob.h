@@ -38,6 +38,20 @@ class QgsFeatureFilterProvider;
 #ifndef SIP_RUN
 /// @cond PRIVATE
 
+/**
+ * \ingroup core
+ * Structure keeping low-level information about the rendering of one
+ * horizontal band of a layer, when the layer is split into tiles rendered in parallel.
+ */
+struct LayerRenderTile
+{
+  QgsRenderContext context;
+
+  //! Image covering the tile's band of the parent job's image (shares the image data, must be deleted)
+  QImage *img = nullptr;
+  QgsMapLayerRenderer *renderer = nullptr; // must be deleted
+};
+
 /**
  * \ingroup core
  * Structure keeping low-level rendering job information.
@@ -62,6 +76,12 @@ struct LayerRenderJob
   QgsWeakMapLayerPointer layer;
   int renderingTime; //!< Time it took to render the layer in ms (it is -1 if not rendered or still rendering)
   QStringList errors; //!< Rendering errors
+
+  /**
+   * Tiles which are rendered in parallel into img, if the layer was split into tiles.
+   * In that case renderer is NULLPTR.
+   */
+  QList< LayerRenderTile > tiles;
 };
 
 typedef QList<LayerRenderJob> LayerRenderJobs;
@@ -315,6 +335,36 @@ class CORE_EXPORT QgsMapRendererJob : public QObject
 
     bool needTemporaryImage( QgsMapLayer *ml );
 
+    /**
+     * Returns TRUE if \a ml can be rendered piece by piece, i.e. the rendering
+     * of a feature does not depend on the other features within the rendered extent.
+     */
+    static bool canRenderPiecewise( QgsMapLayer *ml );
+
+    /**
+     * Estimates how far (in pixels) the symbols of \a ml may reach beyond the geometries
+     * of the rendered features. Returns -1 if the distance cannot be estimated, e.g. when
+     * symbol sizes are data defined, paint effects are enabled or a symbol layer type
+     * is not known to estimate its bleed (like arrows or symbol layers of plugins).
+     */
+    static double estimateSymbolBleed( QgsMapLayer *ml, QgsRenderContext &context );
+
+    /**
+     * Returns TRUE if a render of \a ml from before a pan or an edit of its features
+     * may be reused, so that only the newly exposed or the edited part of the map
+     * needs rendering.
+     */
+    bool canReuseCachedImage( QgsMapLayer *ml ) const;
+
+    /**
+     * Splits the rendering of \a job into horizontal tiles which can be rendered in parallel.
+     * Returns FALSE if the layer was not split.
+     */
+    bool prepareTiles( LayerRenderJob &job, const QgsCoordinateTransform &ct );
+
+    //! Deletes the tiles of \a job, collecting their rendering errors
+    void cleanupTiles( LayerRenderJob &job );
+
     const QgsFeatureFilterProvider *mFeatureFilterProvider = nullptr;
 };
 
@@ -84,6 +84,12 @@ void QgsMapRendererParallelJob::cancel()
     it->context.setRenderingStopped( true );
     if ( it->renderer && it->renderer->feedback() )
       it->renderer->feedback()->cancel();
+    for ( LayerRenderTile &tile : it->tiles )
+    {
+      tile.context.setRenderingStopped( true );
+      if ( tile.renderer && tile.renderer->feedback() )
+        tile.renderer->feedback()->cancel();
+    }
   }
 
   if ( mStatus == RenderingLayers )
@@ -120,6 +126,12 @@ void QgsMapRendererParallelJob::cancelWithoutBlocking()
     it->context.setRenderingStopped( true );
     if ( it->renderer && it->renderer->feedback() )
       it->renderer->feedback()->cancel();
+    for ( LayerRenderTile &tile : it->tiles )
+    {
+      tile.context.setRenderingStopped( true );
+      if ( tile.renderer && tile.renderer->feedback() )
+        tile.renderer->feedback()->cancel();
+    }
   }
 
   if ( mStatus == RenderingLayers )
@@ -251,7 +263,7 @@ void QgsMapRendererParallelJob::renderLayerStatic( LayerRenderJob &job )
   if ( job.cached )
     return;
 
-  if ( job.img )
+  if ( job.img && !job.imageInitialized )
   {
     job.img->fill( 0 );
     job.imageInitialized = true;
@@ -260,6 +272,26 @@ void QgsMapRendererParallelJob::renderLayerStatic( LayerRenderJob &job )
   QTime t;
   t.start();
   QgsDebugMsgLevel( QStringLiteral( "job %1 start (layer %2)" ).arg( reinterpret_cast< quint64 >( &job ), 0, 16 ).arg( job.layer ? job.layer->id() : QString() ), 2 );
+
+  if ( !job.tiles.isEmpty() )
+  {
+    // the calling thread takes part in rendering the tiles, so this can't starve the pool
+    QtConcurrent::blockingMap( job.tiles, renderLayerTileStatic );
+
+    for ( const LayerRenderTile &tile : qgis::as_const( job.tiles ) )
+    {
+      const QStringList tileErrors = tile.renderer->errors();
+      for ( const QString &message : tileErrors )
+      {
+        if ( !job.errors.contains( message ) )
+          job.errors << message;
+      }
+    }
+    job.renderingTime += t.elapsed();
+    QgsDebugMsgLevel( QStringLiteral( "job %1 end [%2 ms] (layer %3, %4 tiles)" ).arg( reinterpret_cast< quint64 >( &job ), 0, 16 ).arg( job.renderingTime ).arg( job.layer ? job.layer->id() : QString() ).arg( job.tiles.count() ), 2 );
+    return;
+  }
+
   try
   {
     job.renderer->render();
@@ -284,6 +316,30 @@ void QgsMapRendererParallelJob::renderLayerStatic( LayerRenderJob &job )
   QgsDebugMsgLevel( QStringLiteral( "job %1 end [%2 ms] (layer %3)" ).arg( reinterpret_cast< quint64 >( &job ), 0, 16 ).arg( job.renderingTime ).arg( job.layer ? job.layer->id() : QString() ), 2 );
 }
 
+void QgsMapRendererParallelJob::renderLayerTileStatic( LayerRenderTile &tile )
+{
+  if ( tile.context.renderingStopped() )
+    return;
+
+  try
+  {
+    tile.renderer->render();
+  }
+  catch ( QgsException &e )
+  {
+    Q_UNUSED( e )
+    QgsDebugMsg( "Caught unhandled QgsException: " + e.what() );
+  }
+  catch ( std::exception &e )
+  {
+    Q_UNUSED( e )
+    QgsDebugMsg( "Caught unhandled std::exception: " + QString::fromLatin1( e.what() ) );
+  }
+  catch ( ... )
+  {
+    QgsDebugMsg( QStringLiteral( "Caught unhandled unknown exception" ) );
+  }
+}
 
 void QgsMapRendererParallelJob::renderLabelsStatic( QgsMapRendererParallelJob *self )
 {
@@ -59,6 +59,8 @@ class CORE_EXPORT QgsMapRendererParallelJob : public QgsMapRendererQImageJob
     //! \note not available in Python bindings
     static void renderLayerStatic( LayerRenderJob &job ) SIP_SKIP;
     //! \note not available in Python bindings
+    static void renderLayerTileStatic( LayerRenderTile &tile ) SIP_SKIP;
+    //! \note not available in Python bindings
     static void renderLabelsStatic( QgsMapRendererParallelJob *self ) SIP_SKIP;
 
     QImage mFinalImage;
@@ -20,6 +20,7 @@
 #include "qgsunittypes.h"
 #include "qgsexception.h"
 #include "qgsapplication.h"
+#include "qgstextlayoutcache.h"
 
 #include <list>
 
@@ -1369,12 +1370,23 @@ bool QgsPalLayerSettings::checkMinimumSizeMM( const QgsRenderContext &ct, const
 }
 
 void QgsPalLayerSettings::calculateLabelSize( const QFontMetricsF *fm, const QString &text, double &labelX, double &labelY, const QgsFeature *f, QgsRenderContext *context )
+{
+  calculateLabelSize( fm, nullptr, text, labelX, labelY, f, context );
+}
+
+void QgsPalLayerSettings::calculateLabelSize( const QFontMetricsF *fm, const QFont *font, const QString &text, double &labelX, double &labelY, const QgsFeature *f, QgsRenderContext *context )
 {
   if ( !fm || !f )
   {
     return;
   }
 
+  QgsTextLayoutCache *layoutCache = QgsApplication::textLayoutCache();
+  auto textWidth = [fm, font, layoutCache]( const QString & string ) -> double
+  {
+    return font ? layoutCache->textWidth( *font, string ) : fm->width( string );
+  };
+
   QString textCopy( text );
 
   //try to keep < 2.12 API - handle no passed render context
@@ -1498,7 +1510,7 @@ void QgsPalLayerSettings::calculateLabelSize( const QFontMetricsF *fm, const QSt
   {
     QString dirSym = leftDirSymb;
 
-    if ( fm->width( rightDirSymb ) > fm->width( dirSym ) )
+    if ( textWidth( rightDirSymb ) > textWidth( dirSym ) )
       dirSym = rightDirSymb;
 
     if ( placeDirSymb == QgsPalLayerSettings::SymbolLeftRight )
@@ -1521,7 +1533,7 @@ void QgsPalLayerSettings::calculateLabelSize( const QFontMetricsF *fm, const QSt
 
   for ( const QString &line : multiLineSplit )
   {
-    w = std::max( w, fm->width( line ) );
+    w = std::max( w, textWidth( line ) );
   }
 
 #if 0 // XXX strk
@@ -1805,7 +1817,7 @@ void QgsPalLayerSettings::registerFeature( const QgsFeature &f, QgsRenderContext
   // NOTE: this should come AFTER any option that affects font metrics
   std::unique_ptr<QFontMetricsF> labelFontMetrics( new QFontMetricsF( labelFont ) );
   double labelX, labelY; // will receive label size
-  calculateLabelSize( labelFontMetrics.get(), labelText, labelX, labelY, mCurFeat, &context );
+  calculateLabelSize( labelFontMetrics.get(), &labelFont, labelText, labelX, labelY, mCurFeat, &context );
 
 
   // maximum angle between curved label characters (hardcoded defaults used in QGIS <2.0)
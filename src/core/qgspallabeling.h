@@ -1096,6 +1096,12 @@ class CORE_EXPORT QgsPalLayerSettings
      */
     void registerObstacleFeature( const QgsFeature &f, QgsRenderContext &context, QgsLabelFeature **obstacleFeature, const QgsGeometry &obstacleGeometry = QgsGeometry() );
 
+    /**
+     * Calculates the space required to render the provided \a text in map units.
+     * If \a font, the font of \a fm, is set the text widths are taken from the text layout cache.
+     */
+    void calculateLabelSize( const QFontMetricsF *fm, const QFont *font, const QString &text, double &labelX, double &labelY, const QgsFeature *f, QgsRenderContext *context );
+
     QMap<Property, QVariant> dataDefinedValues;
 
     //! Property collection for data defined label settings
@@ -18,6 +18,7 @@
 #include "qgsproject.h"
 
 #include "qgsdatasourceuri.h"
+#include "qgslabelingengine.h"
 #include "qgslabelingenginesettings.h"
 #include "qgslayertree.h"
 #include "qgslayertreeutils.h"
@@ -732,6 +733,8 @@ void QgsProject::clear()
   emit mapThemeCollectionChanged();
 
   mLabelingEngineSettings->clear();
+  // label solutions of the previous project won't be reused
+  QgsLabelingEngine::clearComponentSolutionCache();
 
   mAuxiliaryStorage.reset( new QgsAuxiliaryStorage() );
   mArchive->clear();
@@ -15,6 +15,11 @@
 #include "qgsruntimeprofiler.h"
 #include "qgslogger.h"
 
+#include <QMutex>
+
+//! Guards the counters, which are set from rendering threads
+static QMutex sCounterMutex;
+
 void QgsRuntimeProfiler::beginGroup( const QString &name )
 {
   mGroupStack.push( name );
@@ -69,3 +74,21 @@ double QgsRuntimeProfiler::totalTime()
   }
   return total;
 }
+
+void QgsRuntimeProfiler::setCounter( const QString &name, double value )
+{
+  QMutexLocker locker( &sCounterMutex );
+  mCounters.insert( name, value );
+}
+
+double QgsRuntimeProfiler::counter( const QString &name ) const
+{
+  QMutexLocker locker( &sCounterMutex );
+  return mCounters.value( name, 0 );
+}
+
+QStringList QgsRuntimeProfiler::counterNames() const
+{
+  QMutexLocker locker( &sCounterMutex );
+  return mCounters.keys();
+}
@@ -18,6 +18,8 @@
 #include <QTime>
 #include "qgis_sip.h"
 #include <QPair>
+#include <QMap>
+#include <QStringList>
 #include <QStack>
 
 #include "qgis_core.h"
@@ -77,12 +79,35 @@ class CORE_EXPORT QgsRuntimeProfiler
      */
     double totalTime();
 
+    /**
+     * Sets the \a value of the counter with the given \a name, e.g. the number of
+     * hits of a cache. Unlike profile events, counters may be set from any thread.
+     * \see counter()
+     * \since QGIS 3.10
+     */
+    void setCounter( const QString &name, double value );
+
+    /**
+     * Returns the value of the counter with the given \a name, or 0 if the counter was never set.
+     * \see setCounter()
+     * \since QGIS 3.10
+     */
+    double counter( const QString &name ) const;
+
+    /**
+     * Returns the names of all counters.
+     * \see counter()
+     * \since QGIS 3.10
+     */
+    QStringList counterNames() const;
+
   private:
     QString mGroupPrefix;
     QStack<QString> mGroupStack;
     QTime mProfileTime;
     QString mCurrentName;
     QList<QPair<QString, double > > mProfileTimes;
+    QMap<QString, double > mCounters;
 };
 
 #endif // QGSRUNTIMEPROFILER_H
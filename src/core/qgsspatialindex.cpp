@@ -27,6 +27,8 @@
 #include <QMutex>
 #include <QMutexLocker>
 
+#include <algorithm>
+
 using namespace SpatialIndex;
 
 
@@ -61,13 +63,14 @@ class QgisVisitor : public SpatialIndex::IVisitor
 /**
  * \ingroup core
  * \class QgsSpatialIndexCopyVisitor
+ * \brief Custom visitor that collects the bounding boxes of all entries of an index.
  * \note not available in Python bindings
  */
 class QgsSpatialIndexCopyVisitor : public SpatialIndex::IVisitor
 {
   public:
-    explicit QgsSpatialIndexCopyVisitor( SpatialIndex::ISpatialIndex *newIndex )
-      : mNewIndex( newIndex ) {}
+    explicit QgsSpatialIndexCopyVisitor( QVector< QPair< QgsFeatureId, QgsRectangle > > &boundingBoxes )
+      : mBoundingBoxes( boundingBoxes ) {}
 
     void visitNode( const INode &n ) override
     { Q_UNUSED( n ) }
@@ -76,15 +79,17 @@ class QgsSpatialIndexCopyVisitor : public SpatialIndex::IVisitor
     {
       SpatialIndex::IShape *shape = nullptr;
       d.getShape( &shape );
-      mNewIndex->insertData( 0, nullptr, *shape, d.getIdentifier() );
+      SpatialIndex::Region region;
+      shape->getMBR( region );
       delete shape;
+      mBoundingBoxes.append( qMakePair( d.getIdentifier(), QgsRectangle( region.getLow( 0 ), region.getLow( 1 ), region.getHigh( 0 ), region.getHigh( 1 ) ) ) );
     }
 
     void visitData( std::vector<const IData *> &v ) override
     { Q_UNUSED( v ) }
 
   private:
-    SpatialIndex::ISpatialIndex *mNewIndex = nullptr;
+    QVector< QPair< QgsFeatureId, QgsRectangle > > &mBoundingBoxes;
 };
 
 ///@cond PRIVATE
@@ -154,74 +159,39 @@ class QgsNearestNeighborComparator : public INearestNeighborComparator
 
 /**
  * \ingroup core
- * \class QgsFeatureIteratorDataStream
- * \brief Utility class for bulk loading of R-trees. Not a part of public API.
+ * \class QgsBoundingBoxDataStream
+ * \brief Utility class for bulk loading of R-trees from a list of bounding boxes. Not a part of public API.
  * \note not available in Python bindings
 */
-class QgsFeatureIteratorDataStream : public IDataStream
+class QgsBoundingBoxDataStream : public IDataStream
 {
   public:
-    //! constructor - needs to load all data to a vector for later access when bulk loading
-    explicit QgsFeatureIteratorDataStream( const QgsFeatureIterator &fi, QgsFeedback *feedback = nullptr, QgsSpatialIndex::Flags flags = nullptr )
-      : mFi( fi )
-      , mFeedback( feedback )
-      , mFlags( flags )
-    {
-      readNextEntry();
-    }
-
-    ~QgsFeatureIteratorDataStream() override
-    {
-      delete mNextData;
-    }
+    explicit QgsBoundingBoxDataStream( const QVector< QPair< QgsFeatureId, QgsRectangle > > &boundingBoxes )
+      : mBoundingBoxes( boundingBoxes )
+    {}
 
     //! returns a pointer to the next entry in the stream or 0 at the end of the stream.
     IData *getNext() override
     {
-      if ( mFeedback && mFeedback->isCanceled() )
+      if ( mPosition >= mBoundingBoxes.count() )
         return nullptr;
 
-      RTree::Data *ret = mNextData;
-      mNextData = nullptr;
-      readNextEntry();
-      return ret;
+      const QPair< QgsFeatureId, QgsRectangle > &entry = mBoundingBoxes.at( mPosition++ );
+      return new RTree::Data( 0, nullptr, QgsSpatialIndex::rectToRegion( entry.second ), entry.first );
     }
 
     //! returns true if there are more items in the stream.
-    bool hasNext() override { return nullptr != mNextData; }
+    bool hasNext() override { return mPosition < mBoundingBoxes.count(); }
 
     //! returns the total number of entries available in the stream.
-    uint32_t size() override { Q_ASSERT( false && "not available" ); return 0; }
+    uint32_t size() override { return static_cast< uint32_t >( mBoundingBoxes.count() ); }
 
     //! sets the stream pointer to the first entry, if possible.
-    void rewind() override { Q_ASSERT( false && "not available" ); }
-
-    QHash< QgsFeatureId, QgsGeometry > geometries;
-
-  protected:
-    void readNextEntry()
-    {
-      QgsFeature f;
-      SpatialIndex::Region r;
-      QgsFeatureId id;
-      while ( mFi.nextFeature( f ) )
-      {
-        if ( QgsSpatialIndex::featureInfo( f, r, id ) )
-        {
-          mNextData = new RTree::Data( 0, nullptr, r, id );
-          if ( mFlags & QgsSpatialIndex::FlagStoreFeatureGeometries )
-            geometries.insert( f.id(), f.geometry() );
-          return;
-        }
-      }
-    }
+    void rewind() override { mPosition = 0; }
 
   private:
-    QgsFeatureIterator mFi;
-    RTree::Data *mNextData = nullptr;
-    QgsFeedback *mFeedback = nullptr;
-    QgsSpatialIndex::Flags mFlags = nullptr;
-
+    const QVector< QPair< QgsFeatureId, QgsRectangle > > &mBoundingBoxes;
+    int mPosition = 0;
 };
 
 
@@ -252,13 +222,33 @@ class QgsSpatialIndexData : public QSharedData
      * of \a feedback is not transferred, and callers must take care that the lifetime of feedback exceeds
      * that of the spatial index construction.
      */
-    explicit QgsSpatialIndexData( const QgsFeatureIterator &fi, QgsFeedback *feedback = nullptr, QgsSpatialIndex::Flags flags = nullptr )
+    explicit QgsSpatialIndexData( QgsFeatureIterator fi, QgsFeedback *feedback = nullptr, QgsSpatialIndex::Flags flags = nullptr )
       : mFlags( flags )
     {
-      QgsFeatureIteratorDataStream fids( fi, feedback, mFlags );
-      initTree( &fids );
-      if ( flags & QgsSpatialIndex::FlagStoreFeatureGeometries )
-        mGeometries = fids.geometries;
+      // collect all bounding boxes first, so that the tree can be packed in a single pass
+      QVector< QPair< QgsFeatureId, QgsRectangle > > boundingBoxes;
+      QgsFeature f;
+      QgsRectangle rect;
+      QgsFeatureId id;
+      while ( fi.nextFeature( f ) )
+      {
+        if ( feedback && feedback->isCanceled() )
+          break;
+
+        if ( !QgsSpatialIndex::featureInfo( f, rect, id ) )
+          continue;
+
+        boundingBoxes.append( qMakePair( id, rect ) );
+        if ( flags & QgsSpatialIndex::FlagStoreFeatureGeometries )
+          mGeometries.insert( id, f.geometry() );
+      }
+
+      initTree( &boundingBoxes );
+    }
+
+    explicit QgsSpatialIndexData( const QVector< QPair< QgsFeatureId, QgsRectangle > > &boundingBoxes )
+    {
+      initTree( &boundingBoxes );
     }
 
     QgsSpatialIndexData( const QgsSpatialIndexData &other )
@@ -268,14 +258,15 @@ class QgsSpatialIndexData : public QSharedData
     {
       QMutexLocker locker( &other.mMutex );
 
-      initTree();
-
-      // copy R-tree data one by one (is there a faster way??)
+      // collect the entries of the other tree and bulk load them into the copy
+      QVector< QPair< QgsFeatureId, QgsRectangle > > boundingBoxes;
       double low[]  = { std::numeric_limits<double>::lowest(), std::numeric_limits<double>::lowest() };
       double high[] = { std::numeric_limits<double>::max(), std::numeric_limits<double>::max() };
       SpatialIndex::Region query( low, high, 2 );
-      QgsSpatialIndexCopyVisitor visitor( mRTree );
+      QgsSpatialIndexCopyVisitor visitor( boundingBoxes );
       other.mRTree->intersectsWithQuery( query, visitor );
+
+      initTree( &boundingBoxes );
     }
 
     ~QgsSpatialIndexData()
@@ -286,7 +277,7 @@ class QgsSpatialIndexData : public QSharedData
 
     QgsSpatialIndexData &operator=( const QgsSpatialIndexData &rh ) = delete;
 
-    void initTree( IDataStream *inputStream = nullptr )
+    void initTree( const QVector< QPair< QgsFeatureId, QgsRectangle > > *boundingBoxes = nullptr )
     {
       // for now only memory manager
       mStorage = StorageManager::createNewMemoryStorageManager();
@@ -301,12 +292,41 @@ class QgsSpatialIndexData : public QSharedData
       // create R-tree
       SpatialIndex::id_type indexId;
 
-      if ( inputStream && inputStream->hasNext() )
-        mRTree = RTree::createAndBulkLoadNewRTree( RTree::BLM_STR, *inputStream, *mStorage, fillFactor, indexCapacity,
-                 leafCapacity, dimension, variant, indexId );
+      if ( boundingBoxes && !boundingBoxes->isEmpty() )
+      {
+        Tools::PropertySet properties;
+        Tools::Variant var;
+        var.m_varType = Tools::VT_LONG;
+        var.m_val.lVal = variant;
+        properties.setProperty( "TreeVariant", var );
+        var.m_varType = Tools::VT_DOUBLE;
+        var.m_val.dblVal = fillFactor;
+        properties.setProperty( "FillFactor", var );
+        var.m_varType = Tools::VT_ULONG;
+        var.m_val.ulVal = indexCapacity;
+        properties.setProperty( "IndexCapacity", var );
+        var.m_val.ulVal = leafCapacity;
+        properties.setProperty( "LeafCapacity", var );
+        var.m_val.ulVal = dimension;
+        properties.setProperty( "Dimension", var );
+
+        // By default the STR bulk loader only keeps 1M entries in memory while sorting and spills
+        // the rest into temporary files, which dominates the build time of large indexes.
+        // All entries are in memory already, so size the sort buffer to hold all of them.
+        const unsigned long pageSize = 10000;
+        var.m_val.ulVal = pageSize;
+        properties.setProperty( "ExternalSortBufferPageSize", var );
+        var.m_val.ulVal = std::max( 100UL, static_cast< unsigned long >( boundingBoxes->count() ) / pageSize + 1 );
+        properties.setProperty( "ExternalSortBufferTotalPages", var );
+
+        QgsBoundingBoxDataStream stream( *boundingBoxes );
+        mRTree = RTree::createAndBulkLoadNewRTree( RTree::BLM_STR, stream, *mStorage, properties, indexId );
+      }
       else
+      {
         mRTree = RTree::createNewRTree( *mStorage, fillFactor, indexCapacity,
                                         leafCapacity, dimension, variant, indexId );
+      }
     }
 
     //! Storage manager
@@ -334,6 +354,11 @@ QgsSpatialIndex::QgsSpatialIndex( const QgsFeatureIterator &fi, QgsFeedback *fee
   d = new QgsSpatialIndexData( fi, feedback, flags );
 }
 
+QgsSpatialIndex::QgsSpatialIndex( const QVector< QPair< QgsFeatureId, QgsRectangle > > &boundingBoxes )
+{
+  d = new QgsSpatialIndexData( boundingBoxes );
+}
+
 QgsSpatialIndex::QgsSpatialIndex( const QgsFeatureSource &source, QgsFeedback *feedback, QgsSpatialIndex::Flags flags )
 {
   d = new QgsSpatialIndexData( source.getFeatures( QgsFeatureRequest().setNoAttributes() ), feedback, flags );
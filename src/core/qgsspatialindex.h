@@ -41,6 +41,8 @@ class QgsPointXY;
 #include "qgis_core.h"
 #include "qgsfeaturesink.h"
 #include <QList>
+#include <QPair>
+#include <QVector>
 #include <QSharedDataPointer>
 
 #include "qgsfeature.h"
@@ -108,6 +110,20 @@ class CORE_EXPORT QgsSpatialIndex : public QgsFeatureSink
      */
     explicit QgsSpatialIndex( const QgsFeatureSource &source, QgsFeedback *feedback = nullptr, QgsSpatialIndex::Flags flags = nullptr );
 
+    /**
+     * Constructor - creates R-tree and bulk loads it with the given feature \a boundingBoxes,
+     * as pairs of feature ID and bounding box.
+     *
+     * All entries are packed into a sort-tile-recursive tree in a single pass, which is much
+     * faster than creating an empty index and then inserting features one by one. This is
+     * intended for code which already knows the feature bounding boxes, e.g. a data provider
+     * scanning its source.
+     *
+     * \note not available in Python bindings
+     * \since QGIS 3.10
+     */
+    explicit QgsSpatialIndex( const QVector< QPair< QgsFeatureId, QgsRectangle > > &boundingBoxes ) SIP_SKIP;
+
     //! Copy constructor
     QgsSpatialIndex( const QgsSpatialIndex &other );
 
@@ -278,7 +294,8 @@ class CORE_EXPORT QgsSpatialIndex : public QgsFeatureSink
      */
     static bool featureInfo( const QgsFeature &f, QgsRectangle &rect, QgsFeatureId &id );
 
-    friend class QgsFeatureIteratorDataStream; // for access to featureInfo()
+    friend class QgsBoundingBoxDataStream; // for access to rectToRegion()
+    friend class QgsSpatialIndexData; // for access to featureInfo()
 
   private:
 
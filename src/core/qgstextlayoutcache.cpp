@@ -0,0 +1,118 @@
+/***************************************************************************
+    qgstextlayoutcache.cpp
+    ---------------------
+    begin                : October 2019
+    copyright            : (C) 2019 by the QGIS project
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+#include "qgstextlayoutcache.h"
+#include "qgsruntimeprofiler.h"
+
+#include <QFontMetricsF>
+
+#include <algorithm>
+
+uint qHash( const QgsTextLayoutCache::Key &key, uint seed )
+{
+  return qHash( key.font, seed ) ^ qHash( key.text );
+}
+
+QgsTextLayoutCache::Shard &QgsTextLayoutCache::shardForKey( const Key &key )
+{
+  return mShards[ qHash( key, 0 ) % SHARD_COUNT ];
+}
+
+double QgsTextLayoutCache::textWidth( const QFont &font, const QString &text )
+{
+  const Key key { font, text };
+  Shard &shard = shardForKey( key );
+  {
+    QMutexLocker locker( &shard.mutex );
+    if ( const double *width = shard.widths.object( key ) )
+    {
+      locker.unlock();
+      mHits.fetchAndAddRelaxed( 1 );
+      return *width;
+    }
+  }
+  mMisses.fetchAndAddRelaxed( 1 );
+
+  // shape the text without holding the lock
+  const double width = QFontMetricsF( font ).width( text );
+
+  QMutexLocker locker( &shard.mutex );
+  shard.widths.insert( key, new double( width ) );
+  return width;
+}
+
+QPainterPath QgsTextLayoutCache::textPath( const QFont &font, const QString &text )
+{
+  QPainterPath result;
+  result.setFillRule( Qt::WindingFill );
+
+  const Key key { font, text };
+  Shard &shard = shardForKey( key );
+  {
+    QMutexLocker locker( &shard.mutex );
+    if ( const QPainterPath *path = shard.paths.object( key ) )
+    {
+      // QPainterPath lazily caches data for drawing in its shared data, so
+      // a deep copy is returned instead of a shallow one
+      result.addPath( *path );
+      locker.unlock();
+      mHits.fetchAndAddRelaxed( 1 );
+      return result;
+    }
+  }
+  mMisses.fetchAndAddRelaxed( 1 );
+
+  QPainterPath path;
+  path.setFillRule( Qt::WindingFill );
+  path.addText( 0, 0, font, text );
+  result.addPath( path );
+
+  QMutexLocker locker( &shard.mutex );
+  shard.paths.insert( key, new QPainterPath( path ), std::max( path.elementCount(), 1 ) );
+  return result;
+}
+
+void QgsTextLayoutCache::clear()
+{
+  for ( Shard &shard : mShards )
+  {
+    QMutexLocker locker( &shard.mutex );
+    shard.widths.clear();
+    shard.paths.clear();
+  }
+  mHits.store( 0 );
+  mMisses.store( 0 );
+}
+
+qint64 QgsTextLayoutCache::hits() const
+{
+  return mHits.load();
+}
+
+qint64 QgsTextLayoutCache::misses() const
+{
+  return mMisses.load();
+}
+
+void QgsTextLayoutCache::updateProfilerCounters( QgsRuntimeProfiler *profiler ) const
+{
+  if ( !profiler )
+    return;
+
+  const qint64 hits = mHits.load();
+  const qint64 misses = mMisses.load();
+
+  profiler->setCounter( QStringLiteral( "Text layout cache/hits" ), hits );
+  profiler->setCounter( QStringLiteral( "Text layout cache/misses" ), misses );
+  profiler->setCounter( QStringLiteral( "Text layout cache/hit rate" ), hits + misses > 0 ? static_cast< double >( hits ) / ( hits + misses ) : 0.0 );
+}
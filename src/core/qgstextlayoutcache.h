@@ -0,0 +1,126 @@
+/***************************************************************************
+    qgstextlayoutcache.h
+    ---------------------
+    begin                : October 2019
+    copyright            : (C) 2019 by the QGIS project
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+#ifndef QGSTEXTLAYOUTCACHE_H
+#define QGSTEXTLAYOUTCACHE_H
+
+#define SIP_NO_FILE
+
+#include "qgis_core.h"
+
+#include <QAtomicInteger>
+#include <QCache>
+#include <QFont>
+#include <QMutex>
+#include <QPainterPath>
+#include <QString>
+
+class QgsRuntimeProfiler;
+
+/**
+ * \ingroup core
+ * Caches the shaped outlines and the widths of text strings.
+ *
+ * Shaping a string is the most expensive part of measuring and drawing text,
+ * and maps usually contain the same label texts many times. Widths are
+ * used for calculating the size of labels, the outlines for drawing text and
+ * text buffers.
+ *
+ * Entries are keyed by the font, including its pixel size and all spacing and
+ * capitalization settings, and the text. The cache is thread safe, the
+ * application wide instance is returned by QgsApplication::textLayoutCache().
+ * Entries are spread over a fixed number of independently locked shards, so
+ * that threads drawing different labels rarely wait for each other.
+ *
+ * \note not available in Python bindings
+ * \since QGIS 3.10
+ */
+class CORE_EXPORT QgsTextLayoutCache
+{
+  public:
+
+    //! Number of independently locked shards of the cache
+    static const int SHARD_COUNT = 16;
+
+    //! Default maximum number of cached widths
+    static const int DEFAULT_MAX_WIDTHS = 100000;
+
+    //! Default maximum total number of elements of the cached outlines
+    static const int DEFAULT_MAX_PATH_ELEMENTS = 1000000;
+
+    //! Constructor for QgsTextLayoutCache
+    QgsTextLayoutCache() = default;
+
+    //! QgsTextLayoutCache cannot be copied
+    QgsTextLayoutCache( const QgsTextLayoutCache &rh ) = delete;
+    //! QgsTextLayoutCache cannot be copied
+    QgsTextLayoutCache &operator=( const QgsTextLayoutCache &rh ) = delete;
+
+    /**
+     * Returns the advance width of \a text in pixels when drawn with \a font, as
+     * returned by QFontMetricsF::width() for a QFontMetricsF object created from \a font.
+     */
+    double textWidth( const QFont &font, const QString &text );
+
+    /**
+     * Returns the outline of \a text drawn with \a font, with the base line of the text
+     * starting at the origin, as created by QPainterPath::addText(). The fill rule of
+     * the path is Qt::WindingFill.
+     *
+     * The returned path does not share data with the cached path, so it can be drawn
+     * without synchronization.
+     */
+    QPainterPath textPath( const QFont &font, const QString &text );
+
+    //! Removes all cached entries and resets the statistics
+    void clear();
+
+    //! Returns the number of lookups which were answered from the cache
+    qint64 hits() const;
+
+    //! Returns the number of lookups which had to shape the text
+    qint64 misses() const;
+
+    /**
+     * Publishes the hit and miss counts and the hit rate of the cache as counters
+     * of the \a profiler, in the "Text layout cache" group.
+     */
+    void updateProfilerCounters( QgsRuntimeProfiler *profiler ) const;
+
+  private:
+
+    struct Key
+    {
+      QFont font;
+      QString text;
+
+      bool operator==( const Key &other ) const { return text == other.text && font == other.font; }
+    };
+
+    friend uint qHash( const Key &key, uint seed );
+
+    struct Shard
+    {
+      QMutex mutex;
+      QCache< Key, double > widths { DEFAULT_MAX_WIDTHS / SHARD_COUNT };
+      QCache< Key, QPainterPath > paths { DEFAULT_MAX_PATH_ELEMENTS / SHARD_COUNT };
+    };
+
+    Shard &shardForKey( const Key &key );
+
+    Shard mShards[ SHARD_COUNT ];
+    QAtomicInteger< qint64 > mHits { 0 };
+    QAtomicInteger< qint64 > mMisses { 0 };
+};
+
+#endif // QGSTEXTLAYOUTCACHE_H
@@ -26,6 +26,8 @@
 #include "qgsmarkersymbollayer.h"
 #include "qgspainteffectregistry.h"
 #include "qgspallabeling.h"
+#include "qgsapplication.h"
+#include "qgstextlayoutcache.h"
 #include <QFontDatabase>
 #include <QDesktopWidget>
 
@@ -2557,9 +2559,7 @@ void QgsTextRenderer::drawBuffer( QgsRenderContext &context, const QgsTextRender
 
   double penSize = context.convertToPainterUnits( buffer.size(), buffer.sizeUnit(), buffer.sizeMapUnitScale() );
 
-  QPainterPath path;
-  path.setFillRule( Qt::WindingFill );
-  path.addText( 0, 0, format.scaledFont( context ), component.text );
+  const QPainterPath path = QgsApplication::textLayoutCache()->textPath( format.scaledFont( context ), component.text );
   QColor bufferColor = buffer.color();
   bufferColor.setAlphaF( buffer.opacity() );
   QPen pen( bufferColor );
@@ -3217,6 +3217,10 @@ void QgsTextRenderer::drawTextInternal( TextPart drawType,
     return;
   }
 
+  // widths and outlines of the text lines are shared with the label size calculation
+  QgsTextLayoutCache *layoutCache = QgsApplication::textLayoutCache();
+  const QFont font = format.scaledFont( context );
+
   double labelWidest = 0.0;
   switch ( mode )
   {
@@ -3224,7 +3228,7 @@ void QgsTextRenderer::drawTextInternal( TextPart drawType,
     case Point:
       for ( const QString &line : textLines )
       {
-        double labelWidth = fontMetrics->width( line );
+        double labelWidth = layoutCache->textWidth( font, line );
         if ( labelWidth > labelWidest )
         {
           labelWidest = labelWidth;
@@ -3261,7 +3265,7 @@ void QgsTextRenderer::drawTextInternal( TextPart drawType,
 
     // figure x offset for horizontal alignment of multiple lines
     double xMultiLineOffset = 0.0;
-    double labelWidth = fontMetrics->width( line );
+    double labelWidth = layoutCache->textWidth( font, line );
     if ( adjustForAlignment )
     {
       double labelWidthDiff = labelWidest - labelWidth;
@@ -3325,9 +3329,7 @@ void QgsTextRenderer::drawTextInternal( TextPart drawType,
     else
     {
       // draw text, QPainterPath method
-      QPainterPath path;
-      path.setFillRule( Qt::WindingFill );
-      path.addText( 0, 0, format.scaledFont( context ), subComponent.text );
+      const QPainterPath path = layoutCache->textPath( font, subComponent.text );
 
       // store text's drawing in QPicture for drop shadow call
       QPicture textPict;
@@ -3375,7 +3377,7 @@ void QgsTextRenderer::drawTextInternal( TextPart drawType,
 
         case QgsRenderContext::TextFormatAlwaysText:
         {
-          context.painter()->setFont( format.scaledFont( context ) );
+          context.painter()->setFont( font );
           QColor textColor = format.color();
           textColor.setAlphaF( format.opacity() );
           context.painter()->setPen( textColor );
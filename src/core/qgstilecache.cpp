@@ -18,44 +18,68 @@
 #include "qgsnetworkaccessmanager.h"
 #include "qgsapplication.h"
 #include <QAbstractNetworkCache>
+#include <QDateTime>
 #include <QImage>
 
-QCache<QUrl, QImage> QgsTileCache::sTileCache( 256 );
+#include <algorithm>
+#include <memory>
+
+// 64 MiB, i.e. 256 tiles of 256x256 pixels in ARGB32
+QCache<QUrl, QImage> QgsTileCache::sTileCache( 64 * 1024 );
 QMutex QgsTileCache::sTileCacheMutex;
 
 
 void QgsTileCache::insertTile( const QUrl &url, const QImage &image )
 {
+  const int cost = imageCost( image );
   QMutexLocker locker( &sTileCacheMutex );
-  sTileCache.insert( url, new QImage( image ) );
+  sTileCache.insert( url, new QImage( image ), cost );
 }
 
 bool QgsTileCache::tile( const QUrl &url, QImage &image )
 {
-  QMutexLocker locker( &sTileCacheMutex );
-  bool success = false;
-  if ( QImage *i = sTileCache.object( url ) )
   {
-    image = *i;
-    success = true;
-  }
-  else if ( QgsNetworkAccessManager::instance()->cache()->metaData( url ).isValid() )
-  {
-    if ( QIODevice *data = QgsNetworkAccessManager::instance()->cache()->data( url ) )
+    QMutexLocker locker( &sTileCacheMutex );
+    if ( QImage *i = sTileCache.object( url ) )
     {
-      QByteArray imageData = data->readAll();
-      delete data;
-
-      image = QImage::fromData( imageData );
-
-      // cache it as well (mutex is already locked)
-      // Check for null because it could be a redirect (see: https://github.com/qgis/QGIS/issues/24336 )
-      if ( ! image.isNull( ) )
-      {
-        sTileCache.insert( url, new QImage( image ) );
-        success = true;
-      }
+      image = *i;
+      return true;
     }
   }
-  return success;
+
+  // read and decode from the disk cache without holding the mutex, so that
+  // other threads can still be served from the in-memory cache meanwhile
+  QAbstractNetworkCache *diskCache = QgsNetworkAccessManager::instance()->cache();
+  const QNetworkCacheMetaData metaData = diskCache->metaData( url );
+  if ( !metaData.isValid() )
+    return false;
+
+  // an expired tile must be requested again from the server
+  if ( metaData.expirationDate().isValid() && metaData.expirationDate() < QDateTime::currentDateTimeUtc() )
+    return false;
+
+  std::unique_ptr< QIODevice > data( diskCache->data( url ) );
+  if ( !data )
+    return false;
+
+  image = QImage::fromData( data->readAll() );
+
+  // Check for null because it could be a redirect (see: https://github.com/qgis/QGIS/issues/24336 )
+  if ( image.isNull() )
+    return false;
+
+  insertTile( url, image );
+  return true;
+}
+
+void QgsTileCache::setMaxCost( int maxCost )
+{
+  QMutexLocker locker( &sTileCacheMutex );
+  sTileCache.setMaxCost( maxCost );
+}
+
+int QgsTileCache::imageCost( const QImage &image )
+{
+  // in KiB, at least one so that the number of tiny tiles remains bounded too
+  return std::max( 1, image.bytesPerLine() * image.height() / 1024 );
 }
@@ -31,6 +31,12 @@ class QUrl;
  * The in-memory cache is there to save CPU time otherwise wasted to read and
  * uncompress data saved on the disk.
  *
+ * The in-memory cache is limited by the size of the decoded images rather than
+ * by the number of tiles. The secondary cache is the network disk cache, which
+ * stores the encoded tiles as received from the server: tiles are only read
+ * from it and decoded when they are requested, and tiles whose HTTP expiration
+ * date has passed are ignored so that they get fetched again from the server.
+ *
  * The class is thread safe (its methods can be called from any thread).
  *
  * \note Not available in Python bindings
@@ -50,12 +56,21 @@ class CORE_EXPORT QgsTileCache
      */
     static bool tile( const QUrl &url, QImage &image );
 
-    //! how many tiles are stored in the in-memory cache
-    static int totalCost() { return sTileCache.totalCost(); }
-    //! how many tiles can be stored in the in-memory cache
-    static int maxCost() { return sTileCache.maxCost(); }
+    //! Size of the images stored in the in-memory cache, in KiB
+    static int totalCost() { QMutexLocker locker( &sTileCacheMutex ); return sTileCache.totalCost(); }
+    //! Maximum size of the images stored in the in-memory cache, in KiB
+    static int maxCost() { QMutexLocker locker( &sTileCacheMutex ); return sTileCache.maxCost(); }
+
+    /**
+     * Sets the maximum size of the images stored in the in-memory cache, in KiB.
+     * \since QGIS 3.10
+     */
+    static void setMaxCost( int maxCost );
 
   private:
+    //! Returns the cost of an image in the in-memory cache
+    static int imageCost( const QImage &image );
+
     //! in-memory cache
     static QCache<QUrl, QImage> sTileCache;
     //! mutex to protect the in-memory cache
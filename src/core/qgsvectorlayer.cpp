@@ -56,6 +56,7 @@
 #include "qgsfields.h"
 #include "qgsgeometry.h"
 #include "qgslayermetadataformatter.h"
+#include "qgslabelplacementcache.h"
 #include "qgslogger.h"
 #include "qgsmaplayerlegend.h"
 #include "qgsmaptopixel.h"
@@ -1320,6 +1321,9 @@ void QgsVectorLayer::setLabeling( QgsAbstractVectorLayerLabeling *labeling )
 
   delete mLabeling;
   mLabeling = labeling;
+
+  // placements of the previous labeling are not valid anymore
+  QgsApplication::labelPlacementCache()->removeLayer( id() );
 }
 
 bool QgsVectorLayer::startEditing()
@@ -1367,6 +1371,7 @@ bool QgsVectorLayer::startEditing()
   connect( mEditBuffer, &QgsVectorLayerEditBuffer::featureAdded, this, &QgsVectorLayer::featureAdded );
   connect( mEditBuffer, &QgsVectorLayerEditBuffer::featureDeleted, this, &QgsVectorLayer::onFeatureDeleted );
   connect( mEditBuffer, &QgsVectorLayerEditBuffer::geometryChanged, this, &QgsVectorLayer::geometryChanged );
+  connect( mEditBuffer, &QgsVectorLayerEditBuffer::areaModified, this, &QgsVectorLayer::areaModified );
   connect( mEditBuffer, &QgsVectorLayerEditBuffer::attributeValueChanged, this, &QgsVectorLayer::attributeValueChanged );
   connect( mEditBuffer, &QgsVectorLayerEditBuffer::attributeAdded, this, &QgsVectorLayer::attributeAdded );
   connect( mEditBuffer, &QgsVectorLayerEditBuffer::attributeDeleted, this, &QgsVectorLayer::attributeDeleted );
@@ -2339,6 +2339,16 @@ class CORE_EXPORT QgsVectorLayer : public QgsMapLayer, public QgsExpressionConte
      */
     void geometryChanged( QgsFeatureId fid, const QgsGeometry &geometry );
 
+    /**
+     * Emitted when a feature is added or deleted or its geometry is changed in the edit
+     * buffer, with the bounding box (in layer CRS) of a geometry which was added or removed
+     * from the layer. Only this area of the layer needs to be redrawn after the modification.
+     *
+     * \param extent The bounding box of the added or removed geometry
+     * \since QGIS 3.10
+     */
+    void areaModified( const QgsRectangle &extent );
+
     //! Emitted when attributes are deleted from the provider
     void committedAttributesDeleted( const QString &layerId, const QgsAttributeList &deletedAttributes );
     //! Emitted when attributes are added to the provider
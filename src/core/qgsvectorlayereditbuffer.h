@@ -203,6 +203,14 @@ class CORE_EXPORT QgsVectorLayerEditBuffer : public QObject
      */
     void geometryChanged( QgsFeatureId fid, const QgsGeometry &geom );
 
+    /**
+     * Emitted when a feature is added or deleted or its geometry is changed, with the
+     * bounding box (in layer CRS) of a geometry which was added or removed from the layer.
+     * Only this area of the layer needs to be redrawn after the modification.
+     * \since QGIS 3.10
+     */
+    void areaModified( const QgsRectangle &extent );
+
     void attributeValueChanged( QgsFeatureId fid, int idx, const QVariant & );
     void attributeAdded( int idx );
     void attributeDeleted( int idx );
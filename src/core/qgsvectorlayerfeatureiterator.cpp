@@ -28,6 +28,9 @@
 #include "qgsexception.h"
 #include "qgsexpressioncontextutils.h"
 
+//! Number of provider features for which the filter expression is evaluated at once
+static const int FILTER_BLOCK_SIZE = 256;
+
 QgsVectorLayerFeatureSource::QgsVectorLayerFeatureSource( const QgsVectorLayer *layer )
 {
   QMutexLocker locker( &layer->mFeatureSourceConstructorMutex );
@@ -144,6 +147,7 @@ QgsVectorLayerFeatureIterator::QgsVectorLayerFeatureIterator( QgsVectorLayerFeat
   {
     mRequest.expressionContext()->setFields( mSource->mFields );
     mRequest.filterExpression()->prepare( mRequest.expressionContext() );
+    mRequest.filterExpression()->compile( mRequest.expressionContext() );
 
     if ( mRequest.flags() & QgsFeatureRequest::SubsetOfAttributes )
     {
@@ -344,6 +348,24 @@ bool QgsVectorLayerFeatureIterator::fetchFeature( QgsFeature &f )
     mProviderIterator.setInterruptionChecker( mInterruptionChecker );
   }
 
+  if ( mRequest.filterType() == QgsFeatureRequest::FilterExpression && mProviderRequest.filterType() != QgsFeatureRequest::FilterExpression && mRequest.limit() < 0 )
+  {
+    //filtering by expression, and couldn't do it on the provider side
+    while ( fetchNextFilteredProviderFeature( f ) )
+    {
+      if ( !( mRequest.flags() & QgsFeatureRequest::NoGeometry ) )
+        updateFeatureGeometry( f );
+
+      if ( !postProcessFeature( f ) )
+        continue;
+
+      return true;
+    }
+
+    close();
+    return false;
+  }
+
   while ( mProviderIterator.nextFeature( f ) )
   {
     if ( mFetchConsidered.contains( f.id() ) )
@@ -361,7 +383,7 @@ bool QgsVectorLayerFeatureIterator::fetchFeature( QgsFeature &f )
 
     if ( mRequest.filterType() == QgsFeatureRequest::FilterExpression && mProviderRequest.filterType() != QgsFeatureRequest::FilterExpression )
     {
-      //filtering by expression, and couldn't do it on the provider side
+      //filtering by expression with a limit, don't read ahead more features than needed
       mRequest.expressionContext()->setFeature( f );
       if ( !mRequest.filterExpression()->evaluate( mRequest.expressionContext() ).toBool() )
       {
@@ -403,6 +425,10 @@ bool QgsVectorLayerFeatureIterator::rewind()
     rewindEditBuffer();
   }
 
+  mFilterBuffer.clear();
+  mFilterResults.clear();
+  mFilterBufferIndex = 0;
+
   return true;
 }
 
@@ -413,6 +439,10 @@ bool QgsVectorLayerFeatureIterator::close()
 
   mProviderIterator.close();
 
+  mFilterBuffer.clear();
+  mFilterResults.clear();
+  mFilterBufferIndex = 0;
+
   iteratorClosed();
 
   mClosed = true;
@@ -430,6 +460,51 @@ bool QgsVectorLayerFeatureIterator::isValid() const
   return mProviderIterator.isValid();
 }
 
+bool QgsVectorLayerFeatureIterator::fetchNextFilteredProviderFeature( QgsFeature &f )
+{
+  for ( ;; )
+  {
+    while ( mFilterBufferIndex < mFilterBuffer.size() )
+    {
+      const int index = mFilterBufferIndex++;
+      if ( mFilterResults.at( index ).toBool() )
+      {
+        f = mFilterBuffer.at( index );
+        return true;
+      }
+    }
+
+    // read the next block of provider features and evaluate the filter for all of them at once
+    mFilterBuffer.clear();
+    mFilterBufferIndex = 0;
+    QgsFeature feature;
+    while ( mFilterBuffer.size() < FILTER_BLOCK_SIZE && mProviderIterator.nextFeature( feature ) )
+    {
+      if ( mFetchConsidered.contains( feature.id() ) )
+        continue;
+
+      feature.setFields( mSource->mFields );
+
+      // update attributes
+      if ( mSource->mHasEditBuffer )
+        updateChangedAttributes( feature );
+
+      if ( mHasVirtualAttributes )
+        addVirtualAttributes( feature );
+
+      mFilterBuffer << feature;
+    }
+
+    if ( mFilterBuffer.isEmpty() )
+    {
+      mFilterResults.clear();
+      return false;
+    }
+
+    mFilterResults = mRequest.filterExpression()->evaluateBatch( mFilterBuffer, mRequest.expressionContext() );
+  }
+}
+
 bool QgsVectorLayerFeatureIterator::fetchNextAddedFeature( QgsFeature &f )
 {
   while ( mFetchAddedFeaturesIt-- != mSource->mAddedFeatures.constBegin() )
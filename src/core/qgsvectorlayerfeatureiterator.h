@@ -266,6 +266,19 @@ class CORE_EXPORT QgsVectorLayerFeatureIterator : public QgsAbstractFeatureItera
     //! Join list sorted by dependency
     QList< FetchJoinInfo > mOrderedJoinInfoList;
 
+    /**
+     * Fetches the next provider feature which matches the filter expression. The expression
+     * is evaluated with QgsExpression::evaluateBatch() for blocks of provider features.
+     */
+    bool fetchNextFilteredProviderFeature( QgsFeature &f );
+
+    //! Provider features read ahead by fetchNextFilteredProviderFeature()
+    QgsFeatureList mFilterBuffer;
+    //! Filter expression results of the features in mFilterBuffer
+    QVariantList mFilterResults;
+    //! Index of the next feature of mFilterBuffer to consider
+    int mFilterBufferIndex = 0;
+
     /**
      * Will always return TRUE. We assume that ordering has been done on provider level already.
      *
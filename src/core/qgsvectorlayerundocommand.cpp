@@ -51,6 +51,8 @@ void QgsVectorLayerUndoCommandAddFeature::undo()
   mBuffer->mAddedFeatures.remove( mFeature.id() );
 
   emit mBuffer->featureDeleted( mFeature.id() );
+  if ( mFeature.hasGeometry() )
+    emit mBuffer->areaModified( mFeature.geometry().boundingBox() );
 }
 
 void QgsVectorLayerUndoCommandAddFeature::redo()
@@ -58,6 +60,8 @@ void QgsVectorLayerUndoCommandAddFeature::redo()
   mBuffer->mAddedFeatures.insert( mFeature.id(), mFeature );
 
   emit mBuffer->featureAdded( mFeature.id() );
+  if ( mFeature.hasGeometry() )
+    emit mBuffer->areaModified( mFeature.geometry().boundingBox() );
 }
 
 
@@ -72,6 +76,18 @@ QgsVectorLayerUndoCommandDeleteFeature::QgsVectorLayerUndoCommandDeleteFeature(
     QgsFeatureMap::const_iterator it = mBuffer->mAddedFeatures.constFind( mFid );
     Q_ASSERT( it != mBuffer->mAddedFeatures.constEnd() );
     mOldAddedFeature = it.value();
+    mHasBounds = mOldAddedFeature.hasGeometry();
+    if ( mHasBounds )
+      mBounds = mOldAddedFeature.geometry().boundingBox();
+  }
+  else
+  {
+    QgsFeature f;
+    if ( layer()->getFeatures( QgsFeatureRequest().setFilterFid( mFid ).setNoAttributes() ).nextFeature( f ) && f.hasGeometry() )
+    {
+      mBounds = f.geometry().boundingBox();
+      mHasBounds = true;
+    }
   }
 }
 
@@ -87,6 +103,8 @@ void QgsVectorLayerUndoCommandDeleteFeature::undo()
   }
 
   emit mBuffer->featureAdded( mFid );
+  if ( mHasBounds )
+    emit mBuffer->areaModified( mBounds );
 }
 
 void QgsVectorLayerUndoCommandDeleteFeature::redo()
@@ -101,6 +119,8 @@ void QgsVectorLayerUndoCommandDeleteFeature::redo()
   }
 
   emit mBuffer->featureDeleted( mFid );
+  if ( mHasBounds )
+    emit mBuffer->areaModified( mBounds );
 }
 
 
@@ -119,6 +139,16 @@ QgsVectorLayerUndoCommandChangeGeometry::QgsVectorLayerUndoCommandChangeGeometry
   else
   {
     mOldGeom = mBuffer->mChangedGeometries.value( mFid, QgsGeometry() );
+    if ( mOldGeom.isNull() )
+    {
+      // the feature still has its geometry from the provider, which the change will erase from the map
+      QgsFeature f;
+      if ( layer()->getFeatures( QgsFeatureRequest().setFilterFid( mFid ).setNoAttributes() ).nextFeature( f ) && f.hasGeometry() )
+      {
+        mOriginalBounds = f.geometry().boundingBox();
+        mHasOriginalBounds = true;
+      }
+    }
   }
 }
 
@@ -176,7 +206,7 @@ void QgsVectorLayerUndoCommandChangeGeometry::undo()
       emit mBuffer->geometryChanged( mFid, mOldGeom );
     }
   }
-
+  emitAreaModified();
 }
 
 void QgsVectorLayerUndoCommandChangeGeometry::redo()
@@ -193,6 +223,17 @@ void QgsVectorLayerUndoCommandChangeGeometry::redo()
     mBuffer->mChangedGeometries[ mFid ] = mNewGeom;
   }
   emit mBuffer->geometryChanged( mFid, mNewGeom );
+  emitAreaModified();
+}
+
+void QgsVectorLayerUndoCommandChangeGeometry::emitAreaModified() const
+{
+  if ( !mOldGeom.isNull() )
+    emit mBuffer->areaModified( mOldGeom.boundingBox() );
+  else if ( mHasOriginalBounds )
+    emit mBuffer->areaModified( mOriginalBounds );
+  if ( !mNewGeom.isNull() )
+    emit mBuffer->areaModified( mNewGeom.boundingBox() );
 }
 
 
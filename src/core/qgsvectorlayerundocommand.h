@@ -109,6 +109,9 @@ class CORE_EXPORT QgsVectorLayerUndoCommandDeleteFeature : public QgsVectorLayer
   private:
     QgsFeatureId mFid;
     QgsFeature mOldAddedFeature;
+    //! Bounding box of the deleted feature's geometry
+    QgsRectangle mBounds;
+    bool mHasBounds = false;
 };
 
 /**
@@ -138,6 +141,12 @@ class CORE_EXPORT QgsVectorLayerUndoCommandChangeGeometry : public QgsVectorLaye
     QgsFeatureId mFid;
     QgsGeometry mOldGeom;
     mutable QgsGeometry mNewGeom;
+    //! Bounding box of the feature's geometry in the provider, used when mOldGeom is null
+    QgsRectangle mOriginalBounds;
+    bool mHasOriginalBounds = false;
+
+    //! Emits QgsVectorLayerEditBuffer::areaModified() for the geometries before and after the change
+    void emitAreaModified() const;
 };
 
 
@@ -17,6 +17,7 @@
 
 #include "qgsmultibandcolorrenderer.h"
 #include "qgscontrastenhancement.h"
+#include "qgsrasterlookuptable_p.h"
 #include "qgsrastertransparency.h"
 #include "qgsrasterviewport.h"
 
@@ -25,6 +26,10 @@
 #include <QImage>
 #include <QSet>
 
+#include <cmath>
+#include <limits>
+#include <vector>
+
 QgsMultiBandColorRenderer::QgsMultiBandColorRenderer( QgsRasterInterface *input, int redBand, int greenBand, int blueBand,
     QgsContrastEnhancement *redEnhancement,
     QgsContrastEnhancement *greenEnhancement,
@@ -262,78 +267,10 @@ QgsRasterBlock *QgsMultiBandColorRenderer::block( int bandNo, QgsRectangle  cons
   }
 
   qgssize count = ( qgssize )width * height;
-  for ( qgssize i = 0; i < count; i++ )
-  {
-    if ( fastDraw ) //fast rendering if no transparency, stretching, color inversion, etc.
-    {
-      if ( redBlock->isNoData( i ) ||
-           greenBlock->isNoData( i ) ||
-           blueBlock->isNoData( i ) )
-      {
-        outputBlock->setColor( i, myDefaultColor );
-      }
-      else
-      {
-        if ( hasByteRgb )
-        {
-          outputBlockColorData[i] = qRgb( redData[i], greenData[i], blueData[i] );
-        }
-        else
-        {
-          int redVal = static_cast<int>( redBlock->value( i ) );
-          int greenVal = static_cast<int>( greenBlock->value( i ) );
-          int blueVal = static_cast<int>( blueBlock->value( i ) );
-          outputBlockColorData[i] = qRgb( redVal, greenVal, blueVal );
-        }
-      }
-      continue;
-    }
-
-    bool isNoData = false;
-    double redVal = 0;
-    double greenVal = 0;
-    double blueVal = 0;
-    if ( mRedBand > 0 )
-    {
-      redVal = redBlock->valueAndNoData( i, isNoData );
-    }
-    if ( !isNoData && mGreenBand > 0 )
-    {
-      greenVal = greenBlock->valueAndNoData( i, isNoData );
-    }
-    if ( !isNoData && mBlueBand > 0 )
-    {
-      blueVal = blueBlock->valueAndNoData( i, isNoData );
-    }
-    if ( isNoData )
-    {
-      outputBlock->setColor( i, myDefaultColor );
-      continue;
-    }
-
-    //apply default color if red, green or blue not in displayable range
-    if ( ( mRedContrastEnhancement && !mRedContrastEnhancement->isValueInDisplayableRange( redVal ) )
-         || ( mGreenContrastEnhancement && !mGreenContrastEnhancement->isValueInDisplayableRange( redVal ) )
-         || ( mBlueContrastEnhancement && !mBlueContrastEnhancement->isValueInDisplayableRange( redVal ) ) )
-    {
-      outputBlock->setColor( i, myDefaultColor );
-      continue;
-    }
-
-    //stretch color values
-    if ( mRedContrastEnhancement )
-    {
-      redVal = mRedContrastEnhancement->enhanceContrast( redVal );
-    }
-    if ( mGreenContrastEnhancement )
-    {
-      greenVal = mGreenContrastEnhancement->enhanceContrast( greenVal );
-    }
-    if ( mBlueContrastEnhancement )
-    {
-      blueVal = mBlueContrastEnhancement->enhanceContrast( blueVal );
-    }
 
+  // Returns the color of cell i from the enhanced band values
+  auto cellColor = [this, alphaBlock]( qgssize i, double redVal, double greenVal, double blueVal ) -> QRgb
+  {
     //opacity
     double currentOpacity = mOpacity;
     if ( mRasterTransparency )
@@ -347,12 +284,141 @@ QgsRasterBlock *QgsMultiBandColorRenderer::block( int bandNo, QgsRectangle  cons
 
     if ( qgsDoubleNear( currentOpacity, 1.0 ) )
     {
-      outputBlock->setColor( i, qRgba( redVal, greenVal, blueVal, 255 ) );
+      return qRgba( redVal, greenVal, blueVal, 255 );
     }
     else
     {
-      outputBlock->setColor( i, qRgba( currentOpacity * redVal, currentOpacity * greenVal, currentOpacity * blueVal, currentOpacity * 255 ) );
+      return qRgba( currentOpacity * redVal, currentOpacity * greenVal, currentOpacity * blueVal, currentOpacity * 255 );
+    }
+  };
+
+  // Byte and 16 bit bands which need to be enhanced: enhance every value of a band only once.
+  // Cells with no data or values out of the displayable range are mapped to NaN.
+  const float invalidValue = std::numeric_limits<float>::quiet_NaN();
+  QgsRasterLookupTable< float > redTable;
+  QgsRasterLookupTable< float > greenTable;
+  QgsRasterLookupTable< float > blueTable;
+  const bool useTables = !fastDraw && redBlock && greenBlock && blueBlock
+                         && redTable.build( redBlock, invalidValue, [this, invalidValue]( double value ) -> float
+  {
+    // like in the per cell calculation, the displayable range of all bands is checked with the red value
+    if ( ( mRedContrastEnhancement && !mRedContrastEnhancement->isValueInDisplayableRange( value ) )
+         || ( mGreenContrastEnhancement && !mGreenContrastEnhancement->isValueInDisplayableRange( value ) )
+         || ( mBlueContrastEnhancement && !mBlueContrastEnhancement->isValueInDisplayableRange( value ) ) )
+    {
+      return invalidValue;
+    }
+    return mRedContrastEnhancement ? mRedContrastEnhancement->enhanceContrast( value ) : value;
+  } )
+  && greenTable.build( greenBlock, invalidValue, [this]( double value ) -> float
+  {
+    return mGreenContrastEnhancement ? mGreenContrastEnhancement->enhanceContrast( value ) : value;
+  } )
+  && blueTable.build( blueBlock, invalidValue, [this]( double value ) -> float
+  {
+    return mBlueContrastEnhancement ? mBlueContrastEnhancement->enhanceContrast( value ) : value;
+  } );
+
+  if ( useTables )
+  {
+    const qgssize chunkSize = 4096;
+    std::vector< float > redValues( chunkSize );
+    std::vector< float > greenValues( chunkSize );
+    std::vector< float > blueValues( chunkSize );
+    for ( qgssize start = 0; start < count; start += chunkSize )
+    {
+      const qgssize chunkCount = std::min( chunkSize, count - start );
+      redTable.map( start, chunkCount, redValues.data() );
+      greenTable.map( start, chunkCount, greenValues.data() );
+      blueTable.map( start, chunkCount, blueValues.data() );
+      for ( qgssize j = 0; j < chunkCount; j++ )
+      {
+        if ( std::isnan( redValues[j] ) || std::isnan( greenValues[j] ) || std::isnan( blueValues[j] ) )
+        {
+          outputBlockColorData[start + j] = myDefaultColor;
+          continue;
+        }
+        outputBlockColorData[start + j] = cellColor( start + j, redValues[j], greenValues[j], blueValues[j] );
+      }
+    }
+  }
+  else
+  {
+    for ( qgssize i = 0; i < count; i++ )
+    {
+      if ( fastDraw ) //fast rendering if no transparency, stretching, color inversion, etc.
+      {
+        if ( redBlock->isNoData( i ) ||
+             greenBlock->isNoData( i ) ||
+             blueBlock->isNoData( i ) )
+        {
+          outputBlock->setColor( i, myDefaultColor );
+        }
+        else
+        {
+          if ( hasByteRgb )
+          {
+            outputBlockColorData[i] = qRgb( redData[i], greenData[i], blueData[i] );
+          }
+          else
+          {
+            int redVal = static_cast<int>( redBlock->value( i ) );
+            int greenVal = static_cast<int>( greenBlock->value( i ) );
+            int blueVal = static_cast<int>( blueBlock->value( i ) );
+            outputBlockColorData[i] = qRgb( redVal, greenVal, blueVal );
+          }
+        }
+        continue;
+      }
+
+      bool isNoData = false;
+      double redVal = 0;
+      double greenVal = 0;
+      double blueVal = 0;
+      if ( mRedBand > 0 )
+      {
+        redVal = redBlock->valueAndNoData( i, isNoData );
+      }
+      if ( !isNoData && mGreenBand > 0 )
+      {
+        greenVal = greenBlock->valueAndNoData( i, isNoData );
+      }
+      if ( !isNoData && mBlueBand > 0 )
+      {
+        blueVal = blueBlock->valueAndNoData( i, isNoData );
+      }
+      if ( isNoData )
+      {
+        outputBlock->setColor( i, myDefaultColor );
+        continue;
+      }
+
+      //apply default color if red, green or blue not in displayable range
+      if ( ( mRedContrastEnhancement && !mRedContrastEnhancement->isValueInDisplayableRange( redVal ) )
+           || ( mGreenContrastEnhancement && !mGreenContrastEnhancement->isValueInDisplayableRange( redVal ) )
+           || ( mBlueContrastEnhancement && !mBlueContrastEnhancement->isValueInDisplayableRange( redVal ) ) )
+      {
+        outputBlock->setColor( i, myDefaultColor );
+        continue;
+      }
+
+      //stretch color values
+      if ( mRedContrastEnhancement )
+      {
+        redVal = mRedContrastEnhancement->enhanceContrast( redVal );
+      }
+      if ( mGreenContrastEnhancement )
+      {
+        greenVal = mGreenContrastEnhancement->enhanceContrast( greenVal );
+      }
+      if ( mBlueContrastEnhancement )
+      {
+        blueVal = mBlueContrastEnhancement->enhanceContrast( blueVal );
+      }
+
+      outputBlockColorData[i] = cellColor( i, redVal, greenVal, blueVal );
     }
+
   }
 
   //delete input blocks
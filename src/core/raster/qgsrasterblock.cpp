@@ -509,6 +509,20 @@ char *QgsRasterBlock::bits()
   return nullptr;
 }
 
+const char *QgsRasterBlock::constBits() const
+{
+  if ( mData )
+  {
+    return reinterpret_cast< const char * >( mData );
+  }
+  if ( mImage && mImage->constBits() )
+  {
+    return reinterpret_cast< const char * >( mImage->constBits() );
+  }
+
+  return nullptr;
+}
+
 bool QgsRasterBlock::convert( Qgis::DataType destDataType )
 {
   if ( isEmpty() ) return false;
@@ -561,6 +561,13 @@ class CORE_EXPORT QgsRasterBlock
      */
     char *bits() SIP_SKIP;
 
+    /**
+     * Returns a const pointer to block data.
+     * \note not available in Python bindings
+     * \since QGIS 3.10
+     */
+    const char *constBits() const SIP_SKIP;
+
     /**
      * \brief Print double value with all necessary significant digits.
      *         It is ensured that conversion back to double gives the same number.
@@ -401,6 +401,11 @@ void QgsRasterDataProvider::setUserNoDataValue( int bandNo, const QgsRasterRange
         i++;
       }
     }
+    for ( int j = mStatisticsSketches.size() - 1; j >= 0; --j )
+    {
+      if ( mStatisticsSketches.at( j ).first.bandNumber == bandNo )
+        mStatisticsSketches.removeAt( j );
+    }
     mUserNoDataValue[bandNo - 1] = noData;
   }
 }
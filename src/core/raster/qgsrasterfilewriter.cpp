@@ -27,12 +27,276 @@
 
 #include <QCoreApplication>
 #include <QProgressDialog>
+#include <QTemporaryDir>
 #include <QTextStream>
 #include <QMessageBox>
 
 #include <gdal.h>
 #include <cpl_string.h>
 
+#include <cmath>
+#include <memory>
+#include <vector>
+
+///@cond PRIVATE
+
+/**
+ * Writes a cloud optimized GeoTIFF. The blocks are written to a temporary tiled GeoTIFF
+ * and reduced on the fly into temporary overview rasters, so that the pyramids do not
+ * need a separate pass which reads the whole output again. finish() copies the tiles
+ * with their overviews into the cloud optimized layout.
+ */
+class QgsRasterFileWriter::CogOutput
+{
+  public:
+
+    //! Size of the tiles, blocks are read aligned to multiples of it
+    static const int TILE_SIZE = 512;
+
+    //! Maximum number of overview levels, blocks aligned to TILE_SIZE are aligned in all of them
+    static const int MAX_LEVELS = 9;
+
+    CogOutput( const QString &outputUrl, const QString &providerKey, const QStringList &createOptions, const QString &resampling )
+      : mOutputUrl( outputUrl )
+      , mProviderKey( providerKey )
+      , mCreateOptions( createOptions )
+      , mNearest( resampling.compare( QLatin1String( "NEAREST" ), Qt::CaseInsensitive ) == 0 )
+      , mTempDir( QFileInfo( outputUrl ).absolutePath() + QStringLiteral( "/.qgis-cog-XXXXXX" ) )
+    {
+      setOption( mCreateOptions, QStringLiteral( "COMPRESS" ), QStringLiteral( "DEFLATE" ), false );
+      setOption( mCreateOptions, QStringLiteral( "NUM_THREADS" ), QStringLiteral( "ALL_CPUS" ), false );
+      setOption( mCreateOptions, QStringLiteral( "BIGTIFF" ), QStringLiteral( "IF_SAFER" ), false );
+    }
+
+    //! Returns TRUE if the temporary files can be created
+    bool isValid() const { return mTempDir.isValid(); }
+
+    //! Returns the read block size aligned to the tiles for the requested \a size
+    static int alignedBlockSize( int size )
+    {
+      return size <= TILE_SIZE ? TILE_SIZE : ( size + TILE_SIZE - 1 ) / TILE_SIZE * TILE_SIZE;
+    }
+
+    //! Creates the provider for the full resolution data
+    QgsRasterDataProvider *createProvider( int nCols, int nRows, const QgsCoordinateReferenceSystem &crs, double *geoTransform, int nBands,
+                                           Qgis::DataType type, const QList<bool> &destHasNoDataValueList, const QList<double> &destNoDataValueList )
+    {
+      mHasNoDataValueList = destHasNoDataValueList;
+      mNoDataValueList = destNoDataValueList;
+      mLevelFiles.clear();
+      mLevels.clear();
+
+      // overviews are added until the raster fits into a single tile
+      int levelCols = nCols;
+      int levelRows = nRows;
+      while ( ( levelCols > TILE_SIZE || levelRows > TILE_SIZE ) && static_cast< int >( mLevels.size() ) < MAX_LEVELS )
+      {
+        levelCols = ( levelCols + 1 ) / 2;
+        levelRows = ( levelRows + 1 ) / 2;
+
+        double levelGeoTransform[6];
+        std::copy( geoTransform, geoTransform + 6, levelGeoTransform );
+        levelGeoTransform[1] = geoTransform[1] * nCols / levelCols;
+        levelGeoTransform[5] = geoTransform[5] * nRows / levelRows;
+
+        const QString levelFile = mTempDir.filePath( QStringLiteral( "overview%1.tif" ).arg( mLevels.size() + 1 ) );
+        std::unique_ptr< QgsRasterDataProvider > levelProvider( QgsRasterDataProvider::create( mProviderKey, levelFile, QStringLiteral( "GTiff" ), nBands, type, levelCols, levelRows, levelGeoTransform, crs, temporaryCreateOptions() ) );
+        if ( !levelProvider )
+        {
+          QgsDebugMsg( QStringLiteral( "Cannot create overview %1" ).arg( levelFile ) );
+          return nullptr;
+        }
+        for ( int i = 1; i <= nBands; ++i )
+        {
+          if ( mHasNoDataValueList.value( i - 1 ) )
+            levelProvider->setNoDataValue( i, mNoDataValueList.value( i - 1 ) );
+        }
+        mLevelFiles << levelFile;
+        mLevels.emplace_back( std::move( levelProvider ) );
+      }
+
+      return QgsRasterDataProvider::create( mProviderKey, fullResolutionFile(), QStringLiteral( "GTiff" ), nBands, type, nCols, nRows, geoTransform, crs, temporaryCreateOptions() );
+    }
+
+    //! Reduces the \a block of \a band written at \a left, \a top into all overview levels
+    void addBlock( int band, const QgsRasterBlock &block, int left, int top )
+    {
+      const QgsRasterBlock *current = &block;
+      std::unique_ptr< QgsRasterBlock > reduced;
+      for ( const std::unique_ptr< QgsRasterDataProvider > &level : mLevels )
+      {
+        reduced = reduce( *current, band );
+        left /= 2;
+        top /= 2;
+        level->write( reduced->bits(), band, reduced->width(), reduced->height(), left, top );
+        current = reduced.get();
+      }
+    }
+
+    //! Writes the cloud optimized GeoTIFF, the providers of the temporary files must be closed
+    bool finish( QgsRasterBlockFeedback *feedback )
+    {
+      // close the overviews
+      mLevels.clear();
+
+      gdal::dataset_unique_ptr hSrcDS( GDALOpen( fullResolutionFile().toUtf8().constData(), GA_ReadOnly ) );
+      if ( !hSrcDS )
+        return false;
+
+      // attach the overviews to a virtual copy of the full resolution raster
+      gdal::dataset_unique_ptr hVrtDS( GDALCreateCopy( GDALGetDriverByName( "VRT" ), "", hSrcDS.get(), FALSE, nullptr, nullptr, nullptr ) );
+      char **vrtXml = hVrtDS ? GDALGetMetadata( hVrtDS.get(), "xml:VRT" ) : nullptr;
+      if ( !vrtXml || !vrtXml[0] )
+        return false;
+
+      QDomDocument vrtDocument;
+      if ( !vrtDocument.setContent( QString::fromUtf8( vrtXml[0] ) ) )
+        return false;
+      hVrtDS.reset();
+
+      const QDomNodeList bands = vrtDocument.elementsByTagName( QStringLiteral( "VRTRasterBand" ) );
+      for ( int i = 0; i < bands.size(); ++i )
+      {
+        QDomElement bandElem = bands.at( i ).toElement();
+        for ( const QString &levelFile : qgis::as_const( mLevelFiles ) )
+        {
+          QDomElement overviewElem = vrtDocument.createElement( QStringLiteral( "Overview" ) );
+          QDomElement sourceFilenameElem = vrtDocument.createElement( QStringLiteral( "SourceFilename" ) );
+          sourceFilenameElem.setAttribute( QStringLiteral( "relativeToVRT" ), QStringLiteral( "0" ) );
+          sourceFilenameElem.appendChild( vrtDocument.createTextNode( levelFile ) );
+          overviewElem.appendChild( sourceFilenameElem );
+          QDomElement sourceBandElem = vrtDocument.createElement( QStringLiteral( "SourceBand" ) );
+          sourceBandElem.appendChild( vrtDocument.createTextNode( bandElem.attribute( QStringLiteral( "band" ) ) ) );
+          overviewElem.appendChild( sourceBandElem );
+          bandElem.appendChild( overviewElem );
+        }
+      }
+
+      hVrtDS.reset( GDALOpen( vrtDocument.toString().toUtf8().constData(), GA_ReadOnly ) );
+      if ( !hVrtDS )
+        return false;
+
+      // the COG driver (GDAL >= 3.1) uses the existing overviews, older versions need the GTiff driver
+      // to copy them in front of the full resolution data
+      QStringList options = mCreateOptions;
+      for ( const QString &key : { QStringLiteral( "TILED" ), QStringLiteral( "BLOCKXSIZE" ), QStringLiteral( "BLOCKYSIZE" ) } )
+        setOption( options, key, QString(), true );
+      GDALDriverH hDriver = GDALGetDriverByName( "COG" );
+      if ( hDriver )
+      {
+        setOption( options, QStringLiteral( "BLOCKSIZE" ), QString::number( TILE_SIZE ), true );
+      }
+      else
+      {
+        hDriver = GDALGetDriverByName( "GTiff" );
+        setOption( options, QStringLiteral( "TILED" ), QStringLiteral( "YES" ), true );
+        setOption( options, QStringLiteral( "BLOCKXSIZE" ), QString::number( TILE_SIZE ), true );
+        setOption( options, QStringLiteral( "BLOCKYSIZE" ), QString::number( TILE_SIZE ), true );
+        setOption( options, QStringLiteral( "COPY_SRC_OVERVIEWS" ), QStringLiteral( "YES" ), true );
+      }
+
+      char **papszOptions = QgsGdalUtils::papszFromStringList( options );
+      gdal::dataset_unique_ptr hDstDS( GDALCreateCopy( hDriver, mOutputUrl.toUtf8().constData(), hVrtDS.get(), FALSE, papszOptions, progressCallback, feedback ) );
+      CSLDestroy( papszOptions );
+      return static_cast< bool >( hDstDS );
+    }
+
+  private:
+
+    QString fullResolutionFile() const { return mTempDir.filePath( QStringLiteral( "data.tif" ) ); }
+
+    QStringList temporaryCreateOptions() const
+    {
+      QStringList options = mCreateOptions;
+      setOption( options, QStringLiteral( "TILED" ), QStringLiteral( "YES" ), true );
+      setOption( options, QStringLiteral( "BLOCKXSIZE" ), QString::number( TILE_SIZE ), true );
+      setOption( options, QStringLiteral( "BLOCKYSIZE" ), QString::number( TILE_SIZE ), true );
+      return options;
+    }
+
+    //! Sets the create option \a key to \a value, an empty value removes the option
+    static void setOption( QStringList &options, const QString &key, const QString &value, bool replace )
+    {
+      const QString prefix = key + '=';
+      for ( int i = options.size() - 1; i >= 0; --i )
+      {
+        if ( options.at( i ).startsWith( prefix, Qt::CaseInsensitive ) )
+        {
+          if ( !replace )
+            return;
+          options.removeAt( i );
+        }
+      }
+      if ( !value.isEmpty() )
+        options << prefix + value;
+    }
+
+    static int CPL_STDCALL progressCallback( double, const char *, void *progressArg )
+    {
+      QgsRasterBlockFeedback *feedback = static_cast< QgsRasterBlockFeedback * >( progressArg );
+      return !feedback || !feedback->isCanceled();
+    }
+
+    //! Returns the \a block reduced to half of its size, by averaging or nearest neighbour
+    std::unique_ptr< QgsRasterBlock > reduce( const QgsRasterBlock &block, int band ) const
+    {
+      const Qgis::DataType type = block.dataType();
+      const bool isInteger = type >= Qgis::Byte && type <= Qgis::Int32;
+      const bool hasNoDataValue = mHasNoDataValueList.value( band - 1 );
+      const double noDataValue = mNoDataValueList.value( band - 1 );
+
+      const int width = ( block.width() + 1 ) / 2;
+      const int height = ( block.height() + 1 ) / 2;
+      std::unique_ptr< QgsRasterBlock > reduced = qgis::make_unique< QgsRasterBlock >( type, width, height );
+      if ( hasNoDataValue )
+        reduced->setNoDataValue( noDataValue );
+
+      for ( int row = 0; row < height; ++row )
+      {
+        for ( int col = 0; col < width; ++col )
+        {
+          double sum = 0;
+          double first = 0;
+          int count = 0;
+          for ( int sourceRow = 2 * row; sourceRow < std::min( 2 * row + 2, block.height() ); ++sourceRow )
+          {
+            for ( int sourceCol = 2 * col; sourceCol < std::min( 2 * col + 2, block.width() ); ++sourceCol )
+            {
+              if ( block.isNoData( sourceRow, sourceCol ) )
+                continue;
+              const double value = block.value( sourceRow, sourceCol );
+              if ( count == 0 )
+                first = value;
+              sum += value;
+              count++;
+            }
+          }
+
+          const qgssize index = static_cast< qgssize >( row ) * width + col;
+          if ( count == 0 )
+            reduced->setValue( index, hasNoDataValue ? noDataValue : 0 );
+          else if ( mNearest )
+            reduced->setValue( index, first );
+          else
+            reduced->setValue( index, isInteger ? std::round( sum / count ) : sum / count );
+        }
+      }
+      return reduced;
+    }
+
+    QString mOutputUrl;
+    QString mProviderKey;
+    QStringList mCreateOptions;
+    bool mNearest = false;
+    QTemporaryDir mTempDir;
+    QList<bool> mHasNoDataValueList;
+    QList<double> mNoDataValueList;
+    QStringList mLevelFiles;
+    std::vector< std::unique_ptr< QgsRasterDataProvider > > mLevels;
+};
+
+///@endcond
+
 QgsRasterDataProvider *QgsRasterFileWriter::createOneBandRaster( Qgis::DataType dataType, int width, int height, const QgsRectangle &extent, const QgsCoordinateReferenceSystem &crs )
 {
   if ( mTiledMode )
@@ -144,16 +408,37 @@ QgsRasterFileWriter::WriterError QgsRasterFileWriter::writeRaster( const QgsRast
   if ( pyramidFile.exists() )
     pyramidFile.remove();
 
+  std::unique_ptr< CogOutput > cogOutput;
+  if ( mCloudOptimized && !mTiledMode && mOutputFormat.compare( QLatin1String( "GTiff" ), Qt::CaseInsensitive ) == 0 )
+  {
+    cogOutput = qgis::make_unique< CogOutput >( mOutputUrl, mOutputProviderKey, mCreateOptions, mPyramidsResampling );
+    if ( !cogOutput->isValid() )
+    {
+      QgsDebugMsg( QStringLiteral( "Cannot create temporary directory for " ) + mOutputUrl );
+      return CreateDatasourceError;
+    }
+    mCogOutput = cogOutput.get();
+  }
+
+  WriterError e;
   if ( mMode == Image )
   {
-    WriterError e = writeImageRaster( &iter, nCols, nRows, outputExtent, crs, feedback );
-    return e;
+    e = writeImageRaster( &iter, nCols, nRows, outputExtent, crs, feedback );
   }
   else
   {
-    WriterError e = writeDataRaster( pipe, &iter, nCols, nRows, outputExtent, crs, transformContext, feedback );
-    return e;
+    e = writeDataRaster( pipe, &iter, nCols, nRows, outputExtent, crs, transformContext, feedback );
   }
+
+  if ( cogOutput )
+  {
+    mCogOutput = nullptr;
+    if ( e == NoError && !cogOutput->finish( feedback ) )
+    {
+      e = ( feedback && feedback->isCanceled() ) ? WriteCanceled : WriteError;
+    }
+  }
+  return e;
 }
 
 QgsRasterFileWriter::WriterError QgsRasterFileWriter::writeDataRaster( const QgsRasterPipe *pipe, QgsRasterIterator *iter, int nCols, int nRows, const QgsRectangle &outputExtent,
@@ -178,8 +463,9 @@ QgsRasterFileWriter::WriterError QgsRasterFileWriter::writeDataRaster( const Qgs
     return SourceProviderError;
   }
 
-  iter->setMaximumTileWidth( mMaxTileWidth );
-  iter->setMaximumTileHeight( mMaxTileHeight );
+  // cloud optimized output reduces the blocks into overviews, they must be aligned to the tiles
+  iter->setMaximumTileWidth( mCogOutput ? CogOutput::alignedBlockSize( mMaxTileWidth ) : mMaxTileWidth );
+  iter->setMaximumTileHeight( mCogOutput ? CogOutput::alignedBlockSize( mMaxTileHeight ) : mMaxTileHeight );
 
   int nBands = iface->bandCount();
   if ( nBands < 1 )
@@ -402,7 +688,7 @@ QgsRasterFileWriter::WriterError QgsRasterFileWriter::writeDataRaster( const Qgs
         }
         else
         {
-          if ( mBuildPyramidsFlag == QgsRaster::PyramidsFlagYes )
+          if ( mBuildPyramidsFlag == QgsRaster::PyramidsFlagYes && !mCogOutput )
           {
             buildPyramids( mOutputUrl, destProvider );
           }
@@ -473,6 +759,10 @@ QgsRasterFileWriter::WriterError QgsRasterFileWriter::writeDataRaster( const Qgs
       for ( int i = 1; i <= nBands; ++i )
       {
         destProvider->write( destBlockList[i - 1]->bits( 0 ), i, iterCols, iterRows, iterLeft, iterTop );
+        if ( mCogOutput )
+        {
+          mCogOutput->addBlock( i, *destBlockList[i - 1], iterLeft, iterTop );
+        }
         delete destBlockList[i - 1];
       }
     }
@@ -502,13 +792,16 @@ QgsRasterFileWriter::WriterError QgsRasterFileWriter::writeImageRaster( QgsRaste
     return SourceProviderError;
   }
 
-  iter->setMaximumTileWidth( mMaxTileWidth );
-  iter->setMaximumTileHeight( mMaxTileHeight );
+  // cloud optimized output reduces the blocks into overviews, they must be aligned to the tiles
+  const int maxTileWidth = mCogOutput ? CogOutput::alignedBlockSize( mMaxTileWidth ) : mMaxTileWidth;
+  const int maxTileHeight = mCogOutput ? CogOutput::alignedBlockSize( mMaxTileHeight ) : mMaxTileHeight;
+  iter->setMaximumTileWidth( maxTileWidth );
+  iter->setMaximumTileHeight( maxTileHeight );
 
-  void *redData = qgsMalloc( static_cast<size_t>( mMaxTileWidth * mMaxTileHeight ) );
-  void *greenData = qgsMalloc( static_cast<size_t>( mMaxTileWidth * mMaxTileHeight ) );
-  void *blueData = qgsMalloc( static_cast<size_t>( mMaxTileWidth * mMaxTileHeight ) );
-  void *alphaData = qgsMalloc( static_cast<size_t>( mMaxTileWidth * mMaxTileHeight ) );
+  void *redData = qgsMalloc( static_cast<size_t>( maxTileWidth * maxTileHeight ) );
+  void *greenData = qgsMalloc( static_cast<size_t>( maxTileWidth * maxTileHeight ) );
+  void *blueData = qgsMalloc( static_cast<size_t>( maxTileWidth * maxTileHeight ) );
+  void *alphaData = qgsMalloc( static_cast<size_t>( maxTileWidth * maxTileHeight ) );
   int iterLeft = 0, iterTop = 0, iterCols = 0, iterRows = 0;
   int fileIndex = 0;
 
@@ -604,6 +897,17 @@ QgsRasterFileWriter::WriterError QgsRasterFileWriter::writeImageRaster( QgsRaste
       destProvider->write( greenData, 2, iterCols, iterRows, iterLeft, iterTop );
       destProvider->write( blueData, 3, iterCols, iterRows, iterLeft, iterTop );
       destProvider->write( alphaData, 4, iterCols, iterRows, iterLeft, iterTop );
+
+      if ( mCogOutput )
+      {
+        const void *bandData[4] = { redData, greenData, blueData, alphaData };
+        for ( int i = 0; i < 4; ++i )
+        {
+          QgsRasterBlock block( Qgis::Byte, iterCols, iterRows );
+          block.setData( QByteArray::fromRawData( static_cast< const char * >( bandData[i] ), static_cast< int >( nPixels ) ) );
+          mCogOutput->addBlock( i + 1, block, iterLeft, iterTop );
+        }
+      }
     }
 
     ++fileIndex;
@@ -631,7 +935,7 @@ QgsRasterFileWriter::WriterError QgsRasterFileWriter::writeImageRaster( QgsRaste
   }
   else
   {
-    if ( mBuildPyramidsFlag == QgsRaster::PyramidsFlagYes )
+    if ( mBuildPyramidsFlag == QgsRaster::PyramidsFlagYes && !mCogOutput )
     {
       buildPyramids( mOutputUrl );
     }
@@ -911,7 +1215,11 @@ QgsRasterDataProvider *QgsRasterFileWriter::initOutput( int nCols, int nRows, co
       mCreateOptions << "COPY_SRC_OVERVIEWS=YES";
 #endif
 
-    QgsRasterDataProvider *destProvider = QgsRasterDataProvider::create( mOutputProviderKey, mOutputUrl, mOutputFormat, nBands, type, nCols, nRows, geoTransform, crs, mCreateOptions );
+    QgsRasterDataProvider *destProvider = nullptr;
+    if ( mCogOutput )
+      destProvider = mCogOutput->createProvider( nCols, nRows, crs, geoTransform, nBands, type, destHasNoDataValueList, destNoDataValueList );
+    else
+      destProvider = QgsRasterDataProvider::create( mOutputProviderKey, mOutputUrl, mOutputFormat, nBands, type, nCols, nRows, geoTransform, crs, mCreateOptions );
 
     if ( !destProvider )
     {
@@ -164,6 +164,31 @@ class CORE_EXPORT QgsRasterFileWriter
     void setPyramidsConfigOptions( const QStringList &list ) { mPyramidsConfigOptions = list; }
     QStringList pyramidsConfigOptions() const { return mPyramidsConfigOptions; }
 
+    /**
+     * Sets whether writeRaster() creates a cloud optimized GeoTIFF.
+     *
+     * The output is tiled, and the overviews are reduced from the blocks while they
+     * are written, using the pyramids resampling method ("NEAREST" or averaging).
+     * Compression is taken from the create options (DEFLATE by default) and the
+     * encoding uses all CPUs unless NUM_THREADS is set. Finally the data is arranged
+     * in the cloud optimized layout, with the overviews in front of the full resolution
+     * data. No separate pyramids pass is run, the pyramids flag and list are ignored.
+     *
+     * This is only used for single file output (not tiled mode) with the output format
+     * set to GTiff.
+     *
+     * \see cloudOptimized()
+     * \since QGIS 3.10
+     */
+    void setCloudOptimized( bool enabled ) { mCloudOptimized = enabled; }
+
+    /**
+     * Returns TRUE if writeRaster() creates a cloud optimized GeoTIFF.
+     * \see setCloudOptimized()
+     * \since QGIS 3.10
+     */
+    bool cloudOptimized() const { return mCloudOptimized; }
+
     //! Creates a filter for an GDAL driver key
     static QString filterForDriver( const QString &driverName );
 
@@ -228,6 +253,8 @@ class CORE_EXPORT QgsRasterFileWriter
     static QStringList extensionsForFormat( const QString &format );
 
   private:
+    class CogOutput;
+
     QgsRasterFileWriter(); //forbidden
     WriterError writeDataRaster( const QgsRasterPipe *pipe, QgsRasterIterator *iter, int nCols, int nRows, const QgsRectangle &outputExtent,
                                  const QgsCoordinateReferenceSystem &crs, const QgsCoordinateTransformContext &transformContext,
@@ -312,6 +339,11 @@ class CORE_EXPORT QgsRasterFileWriter
     QgsRaster::RasterPyramidsFormat mPyramidsFormat = QgsRaster::PyramidsGTiff;
     QStringList mPyramidsConfigOptions;
 
+    //! TRUE: Write a cloud optimized GeoTIFF
+    bool mCloudOptimized = false;
+    //! Cloud optimized output of the running writeRaster() call
+    CogOutput *mCogOutput = nullptr;
+
     QDomDocument mVRTDocument;
     QList<QDomElement> mVRTBands;
 
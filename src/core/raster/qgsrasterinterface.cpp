@@ -17,10 +17,13 @@
 
 #include <limits>
 #include <typeinfo>
+#include <vector>
 
 #include <QByteArray>
 #include <QTime>
+#include <QThread>
 #include <QStringList>
+#include <QtConcurrentMap>
 
 #include "qgslogger.h"
 #include "qgsrasterbandstats.h"
@@ -135,12 +138,63 @@ QgsRasterBandStats QgsRasterInterface::bandStatistics( int bandNo,
     }
   }
 
+  const QgsRasterStatisticsSketch sketch = statisticsSketch( bandNo, extent, sampleSize, feedback );
+  if ( feedback && feedback->isCanceled() )
+    return myRasterBandStats;
+
+  myRasterBandStats.sum = sketch.sum();
+  myRasterBandStats.elementCount = sketch.count();
+  if ( sketch.finiteCount() > 0 )
+  {
+    myRasterBandStats.minimumValue = sketch.minimum();
+    myRasterBandStats.maximumValue = sketch.maximum();
+  }
+
+  myRasterBandStats.range = myRasterBandStats.maximumValue - myRasterBandStats.minimumValue;
+  myRasterBandStats.mean = myRasterBandStats.sum / myRasterBandStats.elementCount;
+
+  myRasterBandStats.sumOfSquares = sketch.sumOfSquares(); // OK with single pass?
+
+  // stdDev may differ  from GDAL stats, because GDAL is using naive single pass
+  // algorithm which is more error prone (because of rounding errors)
+  // Divide result by sample size - 1 and get square root to get stdev
+  myRasterBandStats.stdDev = std::sqrt( sketch.sumOfSquares() / ( myRasterBandStats.elementCount - 1 ) );
+
+  QgsDebugMsgLevel( QStringLiteral( "************ STATS **************" ), 4 );
+  QgsDebugMsgLevel( QStringLiteral( "MIN %1" ).arg( myRasterBandStats.minimumValue ), 4 );
+  QgsDebugMsgLevel( QStringLiteral( "MAX %1" ).arg( myRasterBandStats.maximumValue ), 4 );
+  QgsDebugMsgLevel( QStringLiteral( "RANGE %1" ).arg( myRasterBandStats.range ), 4 );
+  QgsDebugMsgLevel( QStringLiteral( "MEAN %1" ).arg( myRasterBandStats.mean ), 4 );
+  QgsDebugMsgLevel( QStringLiteral( "STDDEV %1" ).arg( myRasterBandStats.stdDev ), 4 );
+
+  myRasterBandStats.statsGathered = QgsRasterBandStats::All;
+  mStatistics.append( myRasterBandStats );
+
+  return myRasterBandStats;
+}
+
+QgsRasterStatisticsSketch QgsRasterInterface::statisticsSketch( int bandNo,
+    const QgsRectangle &extent,
+    int sampleSize, QgsRasterBlockFeedback *feedback )
+{
+  QgsDebugMsgLevel( QStringLiteral( "theBandNo = %1 sampleSize = %2" ).arg( bandNo ).arg( sampleSize ), 4 );
+
+  QgsRasterBandStats myRasterBandStats;
+  initStatistics( myRasterBandStats, bandNo, QgsRasterBandStats::All, extent, sampleSize );
+
+  for ( const QPair< QgsRasterBandStats, QgsRasterStatisticsSketch > &sketch : qgis::as_const( mStatisticsSketches ) )
+  {
+    if ( sketch.first.contains( myRasterBandStats ) )
+    {
+      QgsDebugMsgLevel( QStringLiteral( "Using cached statistics sketch." ), 4 );
+      return sketch.second;
+    }
+  }
+
   QgsRectangle myExtent = myRasterBandStats.extent;
   int myWidth = myRasterBandStats.width;
   int myHeight = myRasterBandStats.height;
 
-  //int myDataType = dataType( bandNo );
-
   int myXBlockSize = xBlockSize();
   int myYBlockSize = yBlockSize();
   if ( myXBlockSize == 0 ) // should not happen, but happens
@@ -157,20 +211,52 @@ QgsRasterBandStats QgsRasterInterface::bandStatistics( int bandNo,
 
   double myXRes = myExtent.width() / myWidth;
   double myYRes = myExtent.height() / myHeight;
-  // TODO: progress signals
 
-  // used by single pass stdev
-  double myMean = 0;
-  double mySumOfSquares = 0;
+  // Blocks are read on this thread (interfaces and providers are not thread safe). While
+  // the next batch of blocks is read, the values of the previous one are summarized in
+  // parallel, the sketches of the blocks are then merged in order.
+  struct BlockSketch
+  {
+    std::unique_ptr< QgsRasterBlock > block;
+    QgsRasterStatisticsSketch sketch;
+  };
+  const int maxBatchBlocks = std::max( 1, 4 * QThread::idealThreadCount() );
+  const qgssize maxBatchCells = 16 * 1024 * 1024;
+
+  QgsRasterStatisticsSketch mySketch;
+  std::vector< BlockSketch > batch;
+  std::vector< BlockSketch > summarizedBatch;
+  QFuture< void > summarizedFuture;
+  qgssize batchCells = 0;
+
+  auto finishSummarizedBatch = [&summarizedBatch, &summarizedFuture, &mySketch]
+  {
+    summarizedFuture.waitForFinished();
+    for ( const BlockSketch &item : summarizedBatch )
+      mySketch.merge( item.sketch );
+    summarizedBatch.clear();
+  };
+  auto summarizeBatch = [&]
+  {
+    finishSummarizedBatch();
+    summarizedBatch.swap( batch );
+    batchCells = 0;
+    summarizedFuture = QtConcurrent::map( summarizedBatch, []( BlockSketch & item )
+    {
+      item.sketch.addBlock( item.block.get() );
+      item.block.reset();
+    } );
+  };
 
-  bool myFirstIterationFlag = true;
-  bool isNoData = false;
   for ( int myYBlock = 0; myYBlock < myNYBlocks; myYBlock++ )
   {
     for ( int myXBlock = 0; myXBlock < myNXBlocks; myXBlock++ )
     {
       if ( feedback && feedback->isCanceled() )
-        return myRasterBandStats;
+      {
+        summarizedFuture.waitForFinished();
+        return QgsRasterStatisticsSketch();
+      }
 
       QgsDebugMsgLevel( QStringLiteral( "myYBlock = %1 myXBlock = %2" ).arg( myYBlock ).arg( myXBlock ), 4 );
       int myBlockWidth = std::min( myXBlockSize, myWidth - myXBlock * myXBlockSize );
@@ -183,67 +269,21 @@ QgsRasterBandStats QgsRasterInterface::bandStatistics( int bandNo,
 
       QgsRectangle myPartExtent( xmin, ymin, xmax, ymax );
 
-      std::unique_ptr< QgsRasterBlock > blk( block( bandNo, myPartExtent, myBlockWidth, myBlockHeight, feedback ) );
-
-      // Collect the histogram counts.
-      for ( qgssize i = 0; i < ( static_cast< qgssize >( myBlockHeight ) ) * myBlockWidth; i++ )
-      {
-        double myValue = blk->valueAndNoData( i, isNoData );
-        if ( isNoData )
-          continue; // NULL
-
-        myRasterBandStats.sum += myValue;
-        myRasterBandStats.elementCount++;
+      BlockSketch item;
+      item.block.reset( block( bandNo, myPartExtent, myBlockWidth, myBlockHeight, feedback ) );
+      batch.emplace_back( std::move( item ) );
+      batchCells += static_cast< qgssize >( myBlockWidth ) * myBlockHeight;
 
-        if ( !std::isfinite( myValue ) ) continue; // inf
-
-        if ( myFirstIterationFlag )
-        {
-          myFirstIterationFlag = false;
-          myRasterBandStats.minimumValue = myValue;
-          myRasterBandStats.maximumValue = myValue;
-        }
-        else
-        {
-          if ( myValue < myRasterBandStats.minimumValue )
-          {
-            myRasterBandStats.minimumValue = myValue;
-          }
-          if ( myValue > myRasterBandStats.maximumValue )
-          {
-            myRasterBandStats.maximumValue = myValue;
-          }
-        }
-
-        // Single pass stdev
-        double myDelta = myValue - myMean;
-        myMean += myDelta / myRasterBandStats.elementCount;
-        mySumOfSquares += myDelta * ( myValue - myMean );
-      }
+      if ( static_cast< int >( batch.size() ) >= maxBatchBlocks || batchCells >= maxBatchCells )
+        summarizeBatch();
     }
   }
+  summarizeBatch();
+  finishSummarizedBatch();
 
-  myRasterBandStats.range = myRasterBandStats.maximumValue - myRasterBandStats.minimumValue;
-  myRasterBandStats.mean = myRasterBandStats.sum / myRasterBandStats.elementCount;
-
-  myRasterBandStats.sumOfSquares = mySumOfSquares; // OK with single pass?
-
-  // stdDev may differ  from GDAL stats, because GDAL is using naive single pass
-  // algorithm which is more error prone (because of rounding errors)
-  // Divide result by sample size - 1 and get square root to get stdev
-  myRasterBandStats.stdDev = std::sqrt( mySumOfSquares / ( myRasterBandStats.elementCount - 1 ) );
-
-  QgsDebugMsgLevel( QStringLiteral( "************ STATS **************" ), 4 );
-  QgsDebugMsgLevel( QStringLiteral( "MIN %1" ).arg( myRasterBandStats.minimumValue ), 4 );
-  QgsDebugMsgLevel( QStringLiteral( "MAX %1" ).arg( myRasterBandStats.maximumValue ), 4 );
-  QgsDebugMsgLevel( QStringLiteral( "RANGE %1" ).arg( myRasterBandStats.range ), 4 );
-  QgsDebugMsgLevel( QStringLiteral( "MEAN %1" ).arg( myRasterBandStats.mean ), 4 );
-  QgsDebugMsgLevel( QStringLiteral( "STDDEV %1" ).arg( myRasterBandStats.stdDev ), 4 );
-
-  myRasterBandStats.statsGathered = QgsRasterBandStats::All;
-  mStatistics.append( myRasterBandStats );
+  mStatisticsSketches.append( qMakePair( myRasterBandStats, mySketch ) );
 
-  return myRasterBandStats;
+  return mySketch;
 }
 
 void QgsRasterInterface::initHistogram( QgsRasterHistogram &histogram,
@@ -527,41 +567,12 @@ void QgsRasterInterface::cumulativeCut( int bandNo,
   lowerValue = std::numeric_limits<double>::quiet_NaN();
   upperValue = std::numeric_limits<double>::quiet_NaN();
 
-  //get band stats to specify real histogram min/max (fix #9793 Byte bands)
-  QgsRasterBandStats stats = bandStatistics( bandNo, QgsRasterBandStats::Min, extent, sampleSize );
-  if ( stats.maximumValue < stats.minimumValue )
+  const QgsRasterStatisticsSketch sketch = statisticsSketch( bandNo, extent, sampleSize );
+  if ( sketch.finiteCount() == 0 )
     return;
 
-  // for byte bands make sure bin count == actual range
-  int myBinCount = ( mySrcDataType == Qgis::Byte ) ? int( std::ceil( stats.maximumValue - stats.minimumValue + 1 ) ) : 0;
-  QgsRasterHistogram myHistogram = histogram( bandNo, myBinCount, stats.minimumValue, stats.maximumValue, extent, sampleSize );
-  //QgsRasterHistogram myHistogram = histogram( bandNo, 0, std::numeric_limits<double>::quiet_NaN(), std::numeric_limits<double>::quiet_NaN(), extent, sampleSize );
-
-  double myBinXStep = ( myHistogram.maximum - myHistogram.minimum ) / myHistogram.binCount;
-  int myCount = 0;
-  int myMinCount = static_cast< int >( std::round( lowerCount * myHistogram.nonNullCount ) );
-  int myMaxCount = static_cast< int >( std::round( upperCount * myHistogram.nonNullCount ) );
-  bool myLowerFound = false;
-  QgsDebugMsgLevel( QStringLiteral( "binCount = %1 minimum = %2 maximum = %3 myBinXStep = %4" ).arg( myHistogram.binCount ).arg( myHistogram.minimum ).arg( myHistogram.maximum ).arg( myBinXStep ), 4 );
-  QgsDebugMsgLevel( QStringLiteral( "myMinCount = %1 myMaxCount = %2" ).arg( myMinCount ).arg( myMaxCount ), 4 );
-
-  for ( int myBin = 0; myBin < myHistogram.histogramVector.size(); myBin++ )
-  {
-    int myBinValue = myHistogram.histogramVector.value( myBin );
-    myCount += myBinValue;
-    if ( !myLowerFound && myCount > myMinCount )
-    {
-      lowerValue = myHistogram.minimum + myBin * myBinXStep;
-      myLowerFound = true;
-      QgsDebugMsgLevel( QStringLiteral( "found lowerValue %1 at bin %2" ).arg( lowerValue ).arg( myBin ), 4 );
-    }
-    if ( myCount >= myMaxCount )
-    {
-      upperValue = myHistogram.minimum + myBin * myBinXStep;
-      QgsDebugMsgLevel( QStringLiteral( "found upperValue %1 at bin %2" ).arg( upperValue ).arg( myBin ), 4 );
-      break;
-    }
-  }
+  sketch.cumulativeCut( lowerCount, upperCount, lowerValue, upperValue );
+  QgsDebugMsgLevel( QStringLiteral( "found lowerValue %1 upperValue %2, exact = %3" ).arg( lowerValue ).arg( upperValue ).arg( sketch.isExact() ), 4 );
 
   // fix integer data - round down/up
   if ( mySrcDataType == Qgis::Byte ||
@@ -29,8 +29,11 @@
 #include "qgsrasterbandstats.h"
 #include "qgsrasterblock.h"
 #include "qgsrasterhistogram.h"
+#include "qgsrasterstatisticssketch.h"
 #include "qgsrectangle.h"
 
+#include <QPair>
+
 /**
  * \ingroup core
  * Feedback object tailored for raster block reading.
@@ -456,6 +459,29 @@ class CORE_EXPORT QgsRasterInterface
                                 const QgsRectangle &extent = QgsRectangle(),
                                 int sampleSize = 0 );
 
+    /**
+     * Returns a one pass summary of the band values, with moments and a quantile sketch.
+     *
+     * Sketches are calculated in parallel over the blocks of the band and cached,
+     * providers may persist them with the dataset. They are used by cumulativeCut()
+     * and bandStatistics().
+     *
+     * The GDAL provider adds whole extent sketches to an existing .aux.xml file. A new
+     * file is only created for full resolution sketches if the "Raster/persistStatisticsSketches"
+     * setting is enabled.
+     *
+     * \param bandNo The band (number).
+     * \param extent Extent used to calc the sketch, if empty, whole raster extent is used.
+     * \param sampleSize Approximate number of cells in sample. If 0, all cells (whole raster will be used). If raster does not have exact size (WCS without exact size for example), provider decides size of sample.
+     * \param feedback optional feedback object
+     * \note not available in Python bindings
+     * \since QGIS 3.10
+     */
+    virtual QgsRasterStatisticsSketch statisticsSketch( int bandNo,
+        const QgsRectangle &extent = QgsRectangle(),
+        int sampleSize = 0,
+        QgsRasterBlockFeedback *feedback = nullptr ) SIP_SKIP;
+
     //! Write base class members to xml.
     virtual void writeXml( QDomDocument &doc, QDomElement &parentElem ) const { Q_UNUSED( doc ) Q_UNUSED( parentElem ); }
     //! Sets base class members from xml. Usually called from create() methods of subclasses
@@ -471,6 +497,11 @@ class CORE_EXPORT QgsRasterInterface
     //! \brief List  of cached histograms, all bands mixed
     QList<QgsRasterHistogram> mHistograms;
 
+#ifndef SIP_RUN
+    //! \brief List of cached statistics sketches with the statistics describing the sampled extent, all bands mixed
+    QList< QPair< QgsRasterBandStats, QgsRasterStatisticsSketch > > mStatisticsSketches;
+#endif
+
     // On/off state, if off, it does not do anything, replicates input
     bool mOn = true;
 
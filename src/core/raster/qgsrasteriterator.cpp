@@ -18,6 +18,44 @@
 #include "qgsrasterviewport.h"
 #include "qgsrasterdataprovider.h"
 
+#include <QFuture>
+#include <QtConcurrentRun>
+
+#include <cmath>
+
+///@cond PRIVATE
+
+//! Background read of the following part of a band
+struct QgsRasterIterator::ReadAhead
+{
+  ~ReadAhead()
+  {
+    cancel();
+  }
+
+  //! Waits for the pending read and discards its block
+  void cancel()
+  {
+    if ( !pending )
+      return;
+
+    future.waitForFinished();
+    delete future.result();
+    pending = false;
+  }
+
+  //! Clones of the input interfaces, from the iterated interface down to the provider
+  std::vector< std::unique_ptr< QgsRasterInterface > > interfaces;
+
+  QFuture< QgsRasterBlock * > future;
+  bool pending = false;
+  QgsRectangle extent;
+  int columns = 0;
+  int rows = 0;
+};
+
+///@endcond
+
 QgsRasterIterator::QgsRasterIterator( QgsRasterInterface *input )
   : mInput( input )
   , mMaximumTileWidth( DEFAULT_MAXIMUM_TILE_WIDTH )
@@ -35,6 +73,52 @@ QgsRasterIterator::QgsRasterIterator( QgsRasterInterface *input )
   }
 }
 
+QgsRasterIterator::~QgsRasterIterator() = default;
+
+QgsRasterIterator::QgsRasterIterator( const QgsRasterIterator &other )
+  : mInput( other.mInput )
+  , mExtent( other.mExtent )
+  , mFeedback( other.mFeedback )
+  , mMaximumTileWidth( other.mMaximumTileWidth )
+  , mMaximumTileHeight( other.mMaximumTileHeight )
+  , mAlignToSourceBlocks( other.mAlignToSourceBlocks )
+  , mReadAheadEnabled( other.mReadAheadEnabled )
+{
+  QMutexLocker locker( &other.mMutex );
+  mRasterPartInfos = other.mRasterPartInfos;
+}
+
+QgsRasterIterator &QgsRasterIterator::operator=( const QgsRasterIterator &other )
+{
+  if ( &other == this )
+    return *this;
+
+  mReadAheads.clear();
+  mInput = other.mInput;
+  mExtent = other.mExtent;
+  mFeedback = other.mFeedback;
+  mMaximumTileWidth = other.mMaximumTileWidth;
+  mMaximumTileHeight = other.mMaximumTileHeight;
+  mAlignToSourceBlocks = other.mAlignToSourceBlocks;
+  mReadAheadEnabled = other.mReadAheadEnabled;
+
+  QMap<int, RasterPartInfo> partInfos;
+  {
+    QMutexLocker locker( &other.mMutex );
+    partInfos = other.mRasterPartInfos;
+  }
+  QMutexLocker locker( &mMutex );
+  mRasterPartInfos = partInfos;
+  return *this;
+}
+
+void QgsRasterIterator::setReadAheadEnabled( bool enabled )
+{
+  mReadAheadEnabled = enabled;
+  if ( !enabled )
+    mReadAheads.clear();
+}
+
 void QgsRasterIterator::startRasterRead( int bandNumber, int nCols, int nRows, const QgsRectangle &extent, QgsRasterBlockFeedback *feedback )
 {
   if ( !mInput )
@@ -54,6 +138,43 @@ void QgsRasterIterator::startRasterRead( int bandNumber, int nCols, int nRows, c
   pInfo.nRows = nRows;
   pInfo.currentCol = 0;
   pInfo.currentRow = 0;
+  pInfo.blockWidth = 0;
+  pInfo.blockHeight = 0;
+  pInfo.columnOffset = 0;
+  pInfo.rowOffset = 0;
+
+  if ( mAlignToSourceBlocks && nCols > 0 && nRows > 0 )
+  {
+    // blocks can only be used if the raster is read on the pixel grid of the provider
+    QgsRasterDataProvider *provider = nullptr;
+    bool reprojected = false;
+    for ( QgsRasterInterface *ri = mInput; ri && !provider; ri = ri->input() )
+    {
+      provider = dynamic_cast<QgsRasterDataProvider *>( ri );
+      if ( QgsRasterProjector *projector = dynamic_cast<QgsRasterProjector *>( ri ) )
+        reprojected = reprojected || projector->destinationCrs() != projector->sourceCrs();
+    }
+
+    if ( provider && !reprojected && provider->xBlockSize() > 0 && provider->yBlockSize() > 0 && provider->xSize() > 0 && provider->ySize() > 0 )
+    {
+      const QgsRectangle providerExtent = provider->extent();
+      const double xRes = providerExtent.width() / provider->xSize();
+      const double yRes = providerExtent.height() / provider->ySize();
+      const double columnOffset = ( extent.xMinimum() - providerExtent.xMinimum() ) / xRes;
+      const double rowOffset = ( providerExtent.yMaximum() - extent.yMaximum() ) / yRes;
+      if ( qgsDoubleNear( extent.width() / nCols, xRes, xRes * 1e-6 ) && qgsDoubleNear( extent.height() / nRows, yRes, yRes * 1e-6 )
+           && qgsDoubleNear( columnOffset, std::round( columnOffset ), 1e-6 ) && qgsDoubleNear( rowOffset, std::round( rowOffset ), 1e-6 )
+           && columnOffset > -0.5 && rowOffset > -0.5 )
+      {
+        pInfo.blockWidth = provider->xBlockSize();
+        pInfo.blockHeight = provider->yBlockSize();
+        pInfo.columnOffset = static_cast< int >( std::round( columnOffset ) );
+        pInfo.rowOffset = static_cast< int >( std::round( rowOffset ) );
+      }
+    }
+  }
+
+  QMutexLocker locker( &mMutex );
   mRasterPartInfos.insert( bandNumber, pInfo );
 }
 
@@ -85,23 +206,67 @@ bool QgsRasterIterator::readNextRasterPartInternal( int bandNumber, int &nCols,
   QgsDebugMsgLevel( QStringLiteral( "Entered" ), 4 );
   if ( block )
     block->reset();
-  //get partinfo
-  QMap<int, RasterPartInfo>::iterator partIt = mRasterPartInfos.find( bandNumber );
-  if ( partIt == mRasterPartInfos.end() )
+
+  QgsRectangle blockRect;
+  QgsRectangle followingRect;
+  int followingCols = 0;
+  int followingRows = 0;
+  bool hasFollowing = false;
   {
-    return false;
+    QMutexLocker locker( &mMutex );
+
+    //get partinfo
+    QMap<int, RasterPartInfo>::iterator partIt = mRasterPartInfos.find( bandNumber );
+    if ( partIt == mRasterPartInfos.end() )
+    {
+      return false;
+    }
+
+    if ( !nextPart( partIt.value(), nCols, nRows, topLeftCol, topLeftRow, blockRect, true ) )
+    {
+      return false;
+    }
+
+    if ( block && mReadAheadEnabled )
+    {
+      int followingLeft = 0;
+      int followingTop = 0;
+      RasterPartInfo followingInfo = partIt.value();
+      hasFollowing = nextPart( followingInfo, followingCols, followingRows, followingLeft, followingTop, followingRect, false );
+    }
   }
 
-  RasterPartInfo &pInfo = partIt.value();
+  if ( blockExtent )
+    *blockExtent = blockRect;
+
+  if ( block )
+    block->reset( readBlock( bandNumber, blockRect, nCols, nRows, hasFollowing ? &followingRect : nullptr, followingCols, followingRows ) );
+
+  return true;
+}
 
+///@cond PRIVATE
+static int partSize( int maximumSize, int blockSize, int position, int remaining )
+{
+  int size = maximumSize;
+  if ( blockSize > 0 && maximumSize >= blockSize )
+  {
+    // end the part at the next boundary of a block
+    size = maximumSize / blockSize * blockSize;
+    size -= position % size;
+  }
+  return std::min( size, remaining );
+}
+///@endcond
+
+bool QgsRasterIterator::nextPart( RasterPartInfo &pInfo, int &nCols, int &nRows, int &topLeftCol, int &topLeftRow, QgsRectangle &blockExtent, bool advance ) const
+{
   // If we started with zero cols or zero rows, just return (avoids divide by zero below)
   if ( 0 == pInfo.nCols || 0 == pInfo.nRows )
   {
     return false;
   }
 
-  //remove last data block
-
   //already at end
   if ( pInfo.currentCol == pInfo.nCols && pInfo.currentRow == pInfo.nRows )
   {
@@ -109,8 +274,8 @@ bool QgsRasterIterator::readNextRasterPartInternal( int bandNumber, int &nCols,
   }
 
   //read data block
-  nCols = std::min( mMaximumTileWidth, pInfo.nCols - pInfo.currentCol );
-  nRows = std::min( mMaximumTileHeight, pInfo.nRows - pInfo.currentRow );
+  nCols = partSize( mMaximumTileWidth, pInfo.blockWidth, pInfo.columnOffset + pInfo.currentCol, pInfo.nCols - pInfo.currentCol );
+  nRows = partSize( mMaximumTileHeight, pInfo.blockHeight, pInfo.rowOffset + pInfo.currentRow, pInfo.nRows - pInfo.currentRow );
   QgsDebugMsgLevel( QStringLiteral( "nCols = %1 nRows = %2" ).arg( nCols ).arg( nRows ), 4 );
 
   //get subrectangle
@@ -121,16 +286,14 @@ bool QgsRasterIterator::readNextRasterPartInternal( int bandNumber, int &nCols,
   double ymin = pInfo.currentRow + nRows == pInfo.nRows ? viewPortExtent.yMinimum() :  // avoid extra FP math if not necessary
                 viewPortExtent.yMaximum() - ( pInfo.currentRow + nRows ) / static_cast< double >( pInfo.nRows ) * viewPortExtent.height();
   double ymax = viewPortExtent.yMaximum() - pInfo.currentRow / static_cast< double >( pInfo.nRows ) * viewPortExtent.height();
-  QgsRectangle blockRect( xmin, ymin, xmax, ymax );
+  blockExtent = QgsRectangle( xmin, ymin, xmax, ymax );
 
-  if ( blockExtent )
-    *blockExtent = blockRect;
-
-  if ( block )
-    block->reset( mInput->block( bandNumber, blockRect, nCols, nRows, mFeedback ) );
   topLeftCol = pInfo.currentCol;
   topLeftRow = pInfo.currentRow;
 
+  if ( !advance )
+    return true;
+
   pInfo.currentCol += nCols;
   if ( pInfo.currentCol == pInfo.nCols && pInfo.currentRow + nRows == pInfo.nRows ) //end of raster
   {
@@ -145,6 +308,70 @@ bool QgsRasterIterator::readNextRasterPartInternal( int bandNumber, int &nCols,
   return true;
 }
 
+QgsRasterBlock *QgsRasterIterator::readBlock( int bandNumber, const QgsRectangle &extent, int nCols, int nRows,
+    const QgsRectangle *followingExtent, int followingCols, int followingRows )
+{
+  if ( !mReadAheadEnabled )
+    return mInput->block( bandNumber, extent, nCols, nRows, mFeedback );
+
+  std::unique_ptr< ReadAhead > &readAhead = mReadAheads[ bandNumber ];
+  if ( !readAhead )
+  {
+    readAhead = qgis::make_unique< ReadAhead >();
+
+    // clone the chain from the provider up, interfaces need a valid input to accept it
+    QList< QgsRasterInterface * > chain;
+    for ( QgsRasterInterface *ri = mInput; ri; ri = ri->input() )
+      chain.prepend( ri );
+
+    for ( QgsRasterInterface *ri : qgis::as_const( chain ) )
+    {
+      std::unique_ptr< QgsRasterInterface > clone( ri->clone() );
+      if ( !clone || ( !readAhead->interfaces.empty() && !clone->setInput( readAhead->interfaces.front().get() ) ) )
+      {
+        QgsDebugMsgLevel( QStringLiteral( "Cannot clone raster interfaces for read ahead" ), 2 );
+        readAhead->interfaces.clear();
+        break;
+      }
+      readAhead->interfaces.insert( readAhead->interfaces.begin(), std::move( clone ) );
+    }
+  }
+
+  // without a clone of the input, read synchronously
+  if ( readAhead->interfaces.empty() )
+    return mInput->block( bandNumber, extent, nCols, nRows, mFeedback );
+
+  QgsRasterInterface *input = readAhead->interfaces.front().get();
+
+  std::unique_ptr< QgsRasterBlock > block;
+  if ( readAhead->pending && readAhead->extent == extent && readAhead->columns == nCols && readAhead->rows == nRows )
+  {
+    block.reset( readAhead->future.result() );
+    readAhead->pending = false;
+  }
+  else
+  {
+    readAhead->cancel();
+    block.reset( input->block( bandNumber, extent, nCols, nRows, mFeedback ) );
+  }
+
+  if ( followingExtent && !( mFeedback && mFeedback->isCanceled() ) )
+  {
+    const QgsRectangle followingRect = *followingExtent;
+    QgsRasterBlockFeedback *feedback = mFeedback;
+    readAhead->future = QtConcurrent::run( [input, bandNumber, followingRect, followingCols, followingRows, feedback]
+    {
+      return input->block( bandNumber, followingRect, followingCols, followingRows, feedback );
+    } );
+    readAhead->pending = true;
+    readAhead->extent = followingRect;
+    readAhead->columns = followingCols;
+    readAhead->rows = followingRows;
+  }
+
+  return block.release();
+}
+
 void QgsRasterIterator::stopRasterRead( int bandNumber )
 {
   removePartInfo( bandNumber );
@@ -152,6 +379,9 @@ void QgsRasterIterator::stopRasterRead( int bandNumber )
 
 void QgsRasterIterator::removePartInfo( int bandNumber )
 {
+  mReadAheads.erase( bandNumber );
+
+  QMutexLocker locker( &mMutex );
   auto partIt = mRasterPartInfos.constFind( bandNumber );
   if ( partIt != mRasterPartInfos.constEnd() )
   {
@@ -19,6 +19,9 @@
 #include "qgsrectangle.h"
 #include "qgis_sip.h"
 #include <QMap>
+#include <QMutex>
+#include <map>
+#include <memory>
 
 class QgsMapToPixel;
 class QgsRasterBlock;
@@ -40,6 +43,18 @@ class CORE_EXPORT QgsRasterIterator
      */
     QgsRasterIterator( QgsRasterInterface *input );
 
+    ~QgsRasterIterator();
+
+    /**
+     * Copy constructor. The parts which are read in the background are not copied.
+     */
+    QgsRasterIterator( const QgsRasterIterator &other );
+
+    /**
+     * Assignment operator. The parts which are read in the background are not copied.
+     */
+    QgsRasterIterator &operator=( const QgsRasterIterator &other ) SIP_SKIP;
+
     /**
      * Start reading of raster band. Raster data can then be retrieved by calling readNextRasterPart until it returns FALSE.
      * \param bandNumber number of raster band to read
@@ -59,6 +74,10 @@ class CORE_EXPORT QgsRasterIterator
      *
      * Note that calling this method also advances the iterator, just like calling readNextRasterPart().
      *
+     * Several workers may call this method concurrently to process disjoint parts of the
+     * raster in parallel, each reading the data from its own clone of the input. It must not
+     * be called concurrently with any other method of the iterator, e.g. readNextRasterPart().
+     *
      * \param bandNumber band to read
      * \param columns number of columns on output device
      * \param rows number of rows on output device
@@ -144,6 +163,48 @@ class CORE_EXPORT QgsRasterIterator
      */
     int maximumTileHeight() const { return mMaximumTileHeight; }
 
+    /**
+     * Sets whether the parts are aligned to the blocks of the source data provider.
+     *
+     * If enabled and the raster is read on the pixel grid of the provider (i.e. not
+     * resampled or reprojected), the maximum tile size is rounded down to a multiple of
+     * the provider's block size and the parts start at block boundaries, so that no
+     * source block is read for two parts. The first part of a row or column may then be
+     * smaller than the others.
+     *
+     * This is disabled by default and takes effect at the next startRasterRead() call.
+     *
+     * \see alignToSourceBlocks()
+     * \since QGIS 3.10
+     */
+    void setAlignToSourceBlocks( bool align ) { mAlignToSourceBlocks = align; }
+
+    /**
+     * Returns TRUE if the parts are aligned to the blocks of the source data provider.
+     * \see setAlignToSourceBlocks()
+     * \since QGIS 3.10
+     */
+    bool alignToSourceBlocks() const { return mAlignToSourceBlocks; }
+
+    /**
+     * Sets whether readNextRasterPart() reads the following part in a background thread,
+     * while the caller processes the current part.
+     *
+     * The background reads use clones of the input interfaces, so the input may be
+     * used by the caller meanwhile. This is disabled by default.
+     *
+     * \see readAheadEnabled()
+     * \since QGIS 3.10
+     */
+    void setReadAheadEnabled( bool enabled );
+
+    /**
+     * Returns TRUE if the following part is read in a background thread.
+     * \see setReadAheadEnabled()
+     * \since QGIS 3.10
+     */
+    bool readAheadEnabled() const { return mReadAheadEnabled; }
+
     //! Default maximum tile width
     static const int DEFAULT_MAXIMUM_TILE_WIDTH = 2000;
 
@@ -151,6 +212,7 @@ class CORE_EXPORT QgsRasterIterator
     static const int DEFAULT_MAXIMUM_TILE_HEIGHT = 2000;
 
   private:
+
     //Stores information about reading of a raster band. Columns and rows are in unsampled coordinates
     struct RasterPartInfo
     {
@@ -158,8 +220,16 @@ class CORE_EXPORT QgsRasterIterator
       int currentRow;
       int nCols;
       int nRows;
+      //! Size of the source blocks, or 0 if parts are not aligned to them
+      int blockWidth;
+      int blockHeight;
+      //! Position of the first column and row in the source raster
+      int columnOffset;
+      int rowOffset;
     };
 
+    struct ReadAhead;
+
     QgsRasterInterface *mInput = nullptr;
     QMap<int, RasterPartInfo> mRasterPartInfos;
     QgsRectangle mExtent;
@@ -168,9 +238,25 @@ class CORE_EXPORT QgsRasterIterator
     int mMaximumTileWidth;
     int mMaximumTileHeight;
 
+    bool mAlignToSourceBlocks = false;
+    bool mReadAheadEnabled = false;
+
+    //! Protects the part infos, next() may be called from several threads
+    mutable QMutex mMutex;
+
+    //! Pending background reads, by band number. Only accessed by readNextRasterPart(), which is not thread safe
+    std::map< int, std::unique_ptr< ReadAhead > > mReadAheads;
+
     //! Remove part into and release memory
     void removePartInfo( int bandNumber );
     bool readNextRasterPartInternal( int bandNumber, int &nCols, int &nRows, std::unique_ptr<QgsRasterBlock> *block, int &topLeftCol, int &topLeftRow, QgsRectangle *blockExtent );
+
+    //! Calculates the next part of \a partInfo and advances it if \a advance is TRUE
+    bool nextPart( RasterPartInfo &partInfo, int &nCols, int &nRows, int &topLeftCol, int &topLeftRow, QgsRectangle &blockExtent, bool advance ) const;
+
+    //! Reads a block, starts the read of the \a following part in the background if read ahead is enabled
+    QgsRasterBlock *readBlock( int bandNumber, const QgsRectangle &extent, int nCols, int nRows,
+                               const QgsRectangle *followingExtent, int followingCols, int followingRows );
 };
 
 #endif // QGSRASTERITERATOR_H
@@ -0,0 +1,159 @@
+/***************************************************************************
+    qgsrasterlookuptable_p.h
+    ---------------------
+    begin                : October 2019
+    copyright            : (C) 2019 by the QGIS project
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+#ifndef QGSRASTERLOOKUPTABLE_P_H
+#define QGSRASTERLOOKUPTABLE_P_H
+
+#define SIP_NO_FILE
+
+#include "qgsrasterblock.h"
+
+#include <QVector>
+#include <algorithm>
+
+/// @cond PRIVATE
+
+/**
+ * \ingroup core
+ * Lookup table which maps the values of a raster block with integer data of a
+ * small range (e.g. Byte or UInt16 bands) to renderer output values.
+ *
+ * The renderer function is evaluated once per distinct value instead of once
+ * per pixel, and the block is then mapped with plain loops over its typed data.
+ *
+ * \since QGIS 3.10
+ */
+template <typename T>
+class QgsRasterLookupTable
+{
+  public:
+
+    //! Maximum number of table entries
+    static const int MAX_SIZE = 65536;
+
+    /**
+     * Builds the table for the values of \a block, mapping them with \a function and
+     * no data values to \a noDataValue.
+     *
+     * Returns FALSE if the block data can't be mapped with a table: if it is not of a
+     * 8 or 16 bit integer type, or if the range of the 16 bit values is larger than the
+     * number of cells of the block.
+     */
+    template <typename Function>
+    bool build( const QgsRasterBlock *block, const T &noDataValue, Function function )
+    {
+      mBlock = block;
+      mNoDataValue = noDataValue;
+
+      const qgssize count = static_cast< qgssize >( block->width() ) * block->height();
+      bool hasRange = false;
+      switch ( block->dataType() )
+      {
+        case Qgis::Byte:
+          hasRange = findRange( reinterpret_cast< const quint8 * >( block->constBits() ), count );
+          break;
+        case Qgis::UInt16:
+          hasRange = findRange( reinterpret_cast< const quint16 * >( block->constBits() ), count );
+          break;
+        case Qgis::Int16:
+          hasRange = findRange( reinterpret_cast< const qint16 * >( block->constBits() ), count );
+          break;
+        default:
+          break;
+      }
+      if ( !hasRange )
+        return false;
+
+      const int size = mMaximum - mMinimum + 1;
+      if ( size > MAX_SIZE || ( block->dataType() != Qgis::Byte && static_cast< qgssize >( size ) > count ) )
+        return false;
+
+      mTable.resize( size );
+      for ( int i = 0; i < size; ++i )
+      {
+        const double value = mMinimum + i;
+        mTable[i] = block->hasNoDataValue() && block->isNoDataValue( value ) ? noDataValue : function( value );
+      }
+      return true;
+    }
+
+    //! Maps \a count cells of the block, starting at cell \a start, to \a output
+    void map( qgssize start, qgssize count, T *output ) const
+    {
+      switch ( mBlock->dataType() )
+      {
+        case Qgis::Byte:
+          mapData( reinterpret_cast< const quint8 * >( mBlock->constBits() ) + start, count, output );
+          break;
+        case Qgis::UInt16:
+          mapData( reinterpret_cast< const quint16 * >( mBlock->constBits() ) + start, count, output );
+          break;
+        case Qgis::Int16:
+          mapData( reinterpret_cast< const qint16 * >( mBlock->constBits() ) + start, count, output );
+          break;
+        default:
+          return;
+      }
+
+      // no data which is not defined by a value, e.g. outside of reprojected data
+      if ( mBlock->hasNoData() && !mBlock->hasNoDataValue() )
+      {
+        for ( qgssize i = 0; i < count; ++i )
+        {
+          if ( mBlock->isNoData( start + i ) )
+            output[i] = mNoDataValue;
+        }
+      }
+    }
+
+  private:
+
+    template <typename D>
+    bool findRange( const D *data, qgssize count )
+    {
+      if ( !data || count == 0 )
+        return false;
+
+      D minimum = data[0];
+      D maximum = data[0];
+      for ( qgssize i = 1; i < count; ++i )
+      {
+        minimum = std::min( minimum, data[i] );
+        maximum = std::max( maximum, data[i] );
+      }
+      mMinimum = minimum;
+      mMaximum = maximum;
+      return true;
+    }
+
+    template <typename D>
+    void mapData( const D *data, qgssize count, T *output ) const
+    {
+      const T *table = mTable.constData();
+      const int minimum = mMinimum;
+      for ( qgssize i = 0; i < count; ++i )
+      {
+        output[i] = table[ static_cast< int >( data[i] ) - minimum ];
+      }
+    }
+
+    const QgsRasterBlock *mBlock = nullptr;
+    QVector< T > mTable;
+    T mNoDataValue = T();
+    int mMinimum = 0;
+    int mMaximum = 0;
+};
+
+/// @endcond
+
+#endif // QGSRASTERLOOKUPTABLE_P_H
@@ -22,6 +22,11 @@
 #include "qgscoordinatetransform.h"
 #include "qgsexception.h"
 
+#include <QCache>
+#include <QHash>
+#include <QMutex>
+#include <QMutexLocker>
+
 Q_NOWARN_DEPRECATED_PUSH // because of deprecated members
 QgsRasterProjector::QgsRasterProjector()
   : QgsRasterInterface( nullptr )
@@ -90,6 +95,91 @@ void QgsRasterProjector::setCrs( const QgsCoordinateReferenceSystem &srcCRS, con
 }
 
 
+/**
+ * Cache of approximation matrices shared by all projectors.
+ *
+ * Map renders use a new projector for every frame, but as long as the transformation and
+ * destination extent and size don't change, the control points are the same. When only the
+ * extent changes (e.g. when panning), the matrix size needed to reach the tolerance is
+ * usually the same and is kept as a starting point for the refinement of the new matrix.
+ */
+class QgsRasterProjectorMatrixCache
+{
+  public:
+
+    struct Matrix
+    {
+      QList< QList<QgsPointXY> > points;
+      QList< QList<bool> > legal;
+      bool withinTolerance = false;
+    };
+
+    //! Maximum number of control points kept in the cache
+    static const int MAX_CACHED_POINTS = 1000000;
+
+    //! Maximum number of remembered matrix sizes
+    static const int MAX_SIZES = 100;
+
+    QgsRasterProjectorMatrixCache()
+      : mMatrices( MAX_CACHED_POINTS )
+    {}
+
+    bool matrix( const QString &key, Matrix &matrix ) const
+    {
+      QMutexLocker locker( &mMutex );
+      const Matrix *cached = mMatrices.object( key );
+      if ( !cached )
+        return false;
+      matrix = *cached;
+      return true;
+    }
+
+    bool matrixSize( const QString &key, int &rows, int &cols ) const
+    {
+      QMutexLocker locker( &mMutex );
+      auto it = mSizes.constFind( key );
+      if ( it == mSizes.constEnd() )
+        return false;
+      rows = it->first;
+      cols = it->second;
+      return true;
+    }
+
+    void insert( const QString &key, const QString &sizeKey, const Matrix &matrix )
+    {
+      const int rows = matrix.points.size();
+      const int cols = rows > 0 ? matrix.points.at( 0 ).size() : 0;
+      QMutexLocker locker( &mMutex );
+      mMatrices.insert( key, new Matrix( matrix ), std::max( 1, rows * cols ) );
+      if ( matrix.withinTolerance )
+      {
+        if ( mSizes.size() >= MAX_SIZES )
+          mSizes.clear();
+        mSizes.insert( sizeKey, qMakePair( rows, cols ) );
+      }
+    }
+
+  private:
+
+    mutable QMutex mMutex;
+    QCache< QString, Matrix > mMatrices;
+    QHash< QString, QPair< int, int > > mSizes;
+};
+
+Q_GLOBAL_STATIC( QgsRasterProjectorMatrixCache, sMatrixCache )
+
+//! Returns a string identifying the operation used by a coordinate transform
+static QString transformKey( const QgsCoordinateTransform &ct )
+{
+  Q_NOWARN_DEPRECATED_PUSH
+  return QStringLiteral( "%1|%2|%3|%4|%5" ).arg( ct.sourceCrs().toWkt(),
+         ct.destinationCrs().toWkt(),
+         ct.coordinateOperation() )
+         .arg( ct.sourceDatumTransformId() )
+         .arg( ct.destinationDatumTransformId() );
+  Q_NOWARN_DEPRECATED_POP
+}
+
 ProjectorData::ProjectorData( const QgsRectangle &extent, int width, int height, QgsRasterInterface *input, const QgsCoordinateTransform &inverseCt, QgsRasterProjector::Precision precision )
   : mApproximate( false )
   , mInverseCt( inverseCt )
@@ -152,54 +242,52 @@ ProjectorData::ProjectorData( const QgsRectangle &extent, int width, int height,
   }
 
   // Always try to calculate mCPMatrix, it is used in calcSrcExtent() for both Approximate and Exact
-  // Initialize the matrix by corners and middle points
-  mCPCols = mCPRows = 3;
-  for ( int i = 0; i < mCPRows; i++ )
+  QgsRasterProjectorMatrixCache::Matrix matrix;
+  QString matrixKey;
+  QString sizeKey;
+  if ( inverseCt.isValid() )
   {
-    QList<QgsPointXY> myRow;
-    myRow.append( QgsPointXY() );
-    myRow.append( QgsPointXY() );
-    myRow.append( QgsPointXY() );
-    mCPMatrix.insert( i, myRow );
-    // And the legal points
-    QList<bool> myLegalRow;
-    myLegalRow.append( bool( false ) );
-    myLegalRow.append( bool( false ) );
-    myLegalRow.append( bool( false ) );
-    mCPLegalMatrix.insert( i, myLegalRow );
+    const QString ctKey = transformKey( inverseCt );
+    matrixKey = QStringLiteral( "%1|%2,%3,%4,%5|%6x%7" ).arg( ctKey )
+                .arg( mDestExtent.xMinimum(), 0, 'g', 17 ).arg( mDestExtent.yMinimum(), 0, 'g', 17 )
+                .arg( mDestExtent.xMaximum(), 0, 'g', 17 ).arg( mDestExtent.yMaximum(), 0, 'g', 17 )
+                .arg( mDestCols ).arg( mDestRows );
+    sizeKey = QStringLiteral( "%1|%2,%3|%4x%5" ).arg( ctKey )
+              .arg( mDestXRes, 0, 'g', 10 ).arg( mDestYRes, 0, 'g', 10 )
+              .arg( mDestCols ).arg( mDestRows );
   }
-  for ( int i = 0; i < mCPRows; i++ )
+
+  if ( !matrixKey.isEmpty() && sMatrixCache()->matrix( matrixKey, matrix ) )
   {
-    calcRow( i, inverseCt );
+    mCPMatrix = matrix.points;
+    mCPLegalMatrix = matrix.legal;
+    mCPRows = mCPMatrix.size();
+    mCPCols = mCPMatrix.at( 0 ).size();
   }
-
-  while ( true )
+  else
   {
-    bool myColsOK = checkCols( inverseCt );
-    if ( !myColsOK )
-    {
-      insertRows( inverseCt );
-    }
-    bool myRowsOK = checkRows( inverseCt );
-    if ( !myRowsOK )
-    {
-      insertCols( inverseCt );
-    }
-    if ( myColsOK && myRowsOK )
-    {
-      QgsDebugMsgLevel( QStringLiteral( "CP matrix within tolerance" ), 4 );
-      break;
-    }
-    // What is the maximum reasonable size of transformatio matrix?
-    // TODO: consider better when to break - ratio
-    if ( mCPRows * mCPCols > 0.25 * mDestRows * mDestCols )
-      //if ( mCPRows * mCPCols > mDestRows * mDestCols )
+    // Initialize the matrix by corners and middle points, or with the size which was
+    // needed for another extent with the same resolution
+    int rows = 3;
+    int cols = 3;
+    if ( !sizeKey.isEmpty() )
+      sMatrixCache()->matrixSize( sizeKey, rows, cols );
+    initCPMatrix( rows, cols, inverseCt );
+
+    matrix.withinTolerance = refineCPMatrix( inverseCt );
+    if ( !matrixKey.isEmpty() )
     {
-      QgsDebugMsgLevel( QStringLiteral( "Too large CP matrix" ), 4 );
-      mApproximate = false;
-      break;
+      matrix.points = mCPMatrix;
+      matrix.legal = mCPLegalMatrix;
+      sMatrixCache()->insert( matrixKey, sizeKey, matrix );
     }
   }
+
+  if ( !matrix.withinTolerance )
+  {
+    QgsDebugMsgLevel( QStringLiteral( "Too large CP matrix" ), 4 );
+    mApproximate = false;
+  }
   QgsDebugMsgLevel( QStringLiteral( "CPMatrix size: mCPRows = %1 mCPCols = %2" ).arg( mCPRows ).arg( mCPCols ), 4 );
   mDestRowsPerMatrixRow = static_cast< double >( mDestRows ) / ( mCPRows - 1 );
   mDestColsPerMatrixCol = static_cast< double >( mDestCols ) / ( mCPCols - 1 );
@@ -462,19 +550,13 @@ bool ProjectorData::preciseSrcRowCol( int destRow, int destCol, int *srcRow, int
   QgsDebugMsgLevel( QStringLiteral( "theDestRow = %1 mDestExtent.yMaximum() = %2 mDestYRes = %3" ).arg( destRow ).arg( mDestExtent.yMaximum() ).arg( mDestYRes ), 5 );
 #endif
 
-  // Get coordinate of center of destination cell
-  double x = mDestExtent.xMinimum() + ( destCol + 0.5 ) * mDestXRes;
-  double y = mDestExtent.yMaximum() - ( destRow + 0.5 ) * mDestYRes;
-  double z = 0;
-
-#ifdef QGISDEBUG
-  QgsDebugMsgLevel( QStringLiteral( "x = %1 y = %2" ).arg( x ).arg( y ), 5 );
-#endif
-
-  if ( mInverseCt.isValid() )
+  // Source coordinates of the cell centers are transformed for the whole row at once
+  if ( destRow != mPreciseRow )
   {
-    mInverseCt.transformInPlace( x, y, z );
+    calcPreciseRow( destRow );
   }
+  const double x = mPreciseX[destCol];
+  const double y = mPreciseY[destCol];
 
 #ifdef QGISDEBUG
   QgsDebugMsgLevel( QStringLiteral( "x = %1 y = %2" ).arg( x ).arg( y ), 5 );
@@ -579,10 +661,20 @@ void ProjectorData::insertRows( const QgsCoordinateTransform &ct )
     mCPLegalMatrix.insert( 1 + r * 2, myLegalRow );
   }
   mCPRows += mCPRows - 1;
+
+  QVector<int> rows;
+  QVector<int> cols;
+  rows.reserve( ( mCPRows / 2 ) * mCPCols );
+  cols.reserve( ( mCPRows / 2 ) * mCPCols );
   for ( int r = 1; r < mCPRows - 1; r += 2 )
   {
-    calcRow( r, ct );
+    for ( int c = 0; c < mCPCols; c++ )
+    {
+      rows << r;
+      cols << c;
+    }
   }
+  calcCPs( rows, cols, ct );
 }
 
 void ProjectorData::insertCols( const QgsCoordinateTransform &ct )
@@ -596,11 +688,20 @@ void ProjectorData::insertCols( const QgsCoordinateTransform &ct )
     }
   }
   mCPCols += mCPCols - 1;
-  for ( int c = 1; c < mCPCols - 1; c += 2 )
+
+  QVector<int> rows;
+  QVector<int> cols;
+  rows.reserve( mCPRows * ( mCPCols / 2 ) );
+  cols.reserve( mCPRows * ( mCPCols / 2 ) );
+  for ( int r = 0; r < mCPRows; r++ )
   {
-    calcCol( c, ct );
+    for ( int c = 1; c < mCPCols - 1; c += 2 )
+    {
+      rows << r;
+      cols << c;
+    }
   }
-
+  calcCPs( rows, cols, ct );
 }
 
 void ProjectorData::calcCP( int row, int col, const QgsCoordinateTransform &ct )
@@ -628,113 +729,237 @@ void ProjectorData::calcCP( int row, int col, const QgsCoordinateTransform &ct )
   }
 }
 
-bool ProjectorData::calcRow( int row, const QgsCoordinateTransform &ct )
+void ProjectorData::calcCPs( const QVector<int> &rows, const QVector<int> &cols, const QgsCoordinateTransform &ct )
 {
-  QgsDebugMsgLevel( QStringLiteral( "theRow = %1" ).arg( row ), 3 );
-  for ( int i = 0; i < mCPCols; i++ )
+  const int count = rows.size();
+  if ( !ct.isValid() )
   {
-    calcCP( row, i, ct );
+    for ( int i = 0; i < count; i++ )
+    {
+      mCPLegalMatrix[rows[i]][cols[i]] = false;
+    }
+    return;
   }
 
-  return true;
+  QVector<double> x( count );
+  QVector<double> y( count );
+  QVector<double> z( count, 0.0 );
+  for ( int i = 0; i < count; i++ )
+  {
+    destPointOnCPMatrix( rows[i], cols[i], &x[i], &y[i] );
+  }
+
+  try
+  {
+    ct.transformCoords( count, x.data(), y.data(), z.data() );
+  }
+  catch ( QgsCsException &e )
+  {
+    Q_UNUSED( e )
+    // Some points can't be transformed, find out which ones
+    for ( int i = 0; i < count; i++ )
+    {
+      calcCP( rows[i], cols[i], ct );
+    }
+    return;
+  }
+
+  for ( int i = 0; i < count; i++ )
+  {
+    mCPMatrix[rows[i]][cols[i]] = QgsPointXY( x[i], y[i] );
+    mCPLegalMatrix[rows[i]][cols[i]] = true;
+  }
 }
 
-bool ProjectorData::calcCol( int col, const QgsCoordinateTransform &ct )
+void ProjectorData::initCPMatrix( int rows, int cols, const QgsCoordinateTransform &ct )
 {
-  QgsDebugMsgLevel( QStringLiteral( "theCol = %1" ).arg( col ), 3 );
-  for ( int i = 0; i < mCPRows; i++ )
+  mCPRows = rows;
+  mCPCols = cols;
+
+  QList<QgsPointXY> myRow;
+  QList<bool> myLegalRow;
+  myRow.reserve( mCPCols );
+  myLegalRow.reserve( mCPCols );
+  for ( int c = 0; c < mCPCols; c++ )
   {
-    calcCP( i, col, ct );
+    myRow.append( QgsPointXY() );
+    myLegalRow.append( false );
+  }
+  mCPMatrix.clear();
+  mCPLegalMatrix.clear();
+  for ( int r = 0; r < mCPRows; r++ )
+  {
+    mCPMatrix.append( myRow );
+    mCPLegalMatrix.append( myLegalRow );
   }
 
-  return true;
+  QVector<int> cpRows;
+  QVector<int> cpCols;
+  cpRows.reserve( mCPRows * mCPCols );
+  cpCols.reserve( mCPRows * mCPCols );
+  for ( int r = 0; r < mCPRows; r++ )
+  {
+    for ( int c = 0; c < mCPCols; c++ )
+    {
+      cpRows << r;
+      cpCols << c;
+    }
+  }
+  calcCPs( cpRows, cpCols, ct );
 }
 
-bool ProjectorData::checkCols( const QgsCoordinateTransform &ct )
+bool ProjectorData::refineCPMatrix( const QgsCoordinateTransform &ct )
 {
-  if ( !ct.isValid() )
+  while ( true )
   {
-    return false;
+    bool myColsOK = checkCols( ct );
+    if ( !myColsOK )
+    {
+      insertRows( ct );
+    }
+    bool myRowsOK = checkRows( ct );
+    if ( !myRowsOK )
+    {
+      insertCols( ct );
+    }
+    if ( myColsOK && myRowsOK )
+    {
+      QgsDebugMsgLevel( QStringLiteral( "CP matrix within tolerance" ), 4 );
+      return true;
+    }
+    // What is the maximum reasonable size of transformatio matrix?
+    // TODO: consider better when to break - ratio
+    if ( mCPRows * mCPCols > 0.25 * mDestRows * mDestCols )
+    {
+      return false;
+    }
   }
+}
 
-  for ( int c = 0; c < mCPCols; c++ )
+void ProjectorData::calcPreciseRow( int destRow )
+{
+  mPreciseRow = destRow;
+  mPreciseX.resize( mDestCols );
+  mPreciseY.resize( mDestCols );
+
+  // Get coordinates of centers of destination cells
+  const double y = mDestExtent.yMaximum() - ( destRow + 0.5 ) * mDestYRes;
+  for ( int col = 0; col < mDestCols; col++ )
   {
-    for ( int r = 1; r < mCPRows - 1; r += 2 )
-    {
-      double myDestX, myDestY;
-      destPointOnCPMatrix( r, c, &myDestX, &myDestY );
-      QgsPointXY myDestPoint( myDestX, myDestY );
+    mPreciseX[col] = mDestExtent.xMinimum() + ( col + 0.5 ) * mDestXRes;
+    mPreciseY[col] = y;
+  }
 
-      QgsPointXY mySrcPoint1 = mCPMatrix[r - 1][c];
-      QgsPointXY mySrcPoint2 = mCPMatrix[r][c];
-      QgsPointXY mySrcPoint3 = mCPMatrix[r + 1][c];
+  if ( !mInverseCt.isValid() )
+  {
+    return;
+  }
 
-      QgsPointXY mySrcApprox( ( mySrcPoint1.x() + mySrcPoint3.x() ) / 2, ( mySrcPoint1.y() + mySrcPoint3.y() ) / 2 );
-      if ( !mCPLegalMatrix[r - 1][c] || !mCPLegalMatrix[r][c] || !mCPLegalMatrix[r + 1][c] )
-      {
-        // There was an error earlier in transform, just abort
-        return false;
-      }
+  QVector<double> z( mDestCols, 0.0 );
+  try
+  {
+    mInverseCt.transformCoords( mDestCols, mPreciseX.data(), mPreciseY.data(), z.data() );
+  }
+  catch ( QgsCsException &e )
+  {
+    Q_UNUSED( e )
+    // Some cells can't be transformed, find out which ones and leave them out of the source
+    for ( int col = 0; col < mDestCols; col++ )
+    {
+      double x = mDestExtent.xMinimum() + ( col + 0.5 ) * mDestXRes;
+      double cellY = y;
+      double cellZ = 0;
       try
       {
-        QgsPointXY myDestApprox = ct.transform( mySrcApprox, QgsCoordinateTransform::ReverseTransform );
-        double mySqrDist = myDestApprox.sqrDist( myDestPoint );
-        if ( mySqrDist > mSqrTolerance )
-        {
-          return false;
-        }
+        mInverseCt.transformInPlace( x, cellY, cellZ );
       }
       catch ( QgsCsException &e )
       {
         Q_UNUSED( e )
-        // Caught an error in transform
-        return false;
+        x = cellY = std::numeric_limits<double>::quiet_NaN();
       }
+      mPreciseX[col] = x;
+      mPreciseY[col] = cellY;
     }
   }
-  return true;
+}
+
+bool ProjectorData::checkCols( const QgsCoordinateTransform &ct )
+{
+  QVector<int> rows;
+  QVector<int> cols;
+  for ( int c = 0; c < mCPCols; c++ )
+  {
+    for ( int r = 1; r < mCPRows - 1; r += 2 )
+    {
+      rows << r;
+      cols << c;
+    }
+  }
+  return checkMidpoints( rows, cols, 1, 0, ct );
 }
 
 bool ProjectorData::checkRows( const QgsCoordinateTransform &ct )
+{
+  QVector<int> rows;
+  QVector<int> cols;
+  for ( int r = 0; r < mCPRows; r++ )
+  {
+    for ( int c = 1; c < mCPCols - 1; c += 2 )
+    {
+      rows << r;
+      cols << c;
+    }
+  }
+  return checkMidpoints( rows, cols, 0, 1, ct );
+}
+
+bool ProjectorData::checkMidpoints( const QVector<int> &rows, const QVector<int> &cols, int rowStep, int colStep, const QgsCoordinateTransform &ct )
 {
   if ( !ct.isValid() )
   {
     return false;
   }
 
-  for ( int r = 0; r < mCPRows; r++ )
+  const int count = rows.size();
+  QVector<double> x( count );
+  QVector<double> y( count );
+  QVector<double> z( count, 0.0 );
+  for ( int i = 0; i < count; i++ )
   {
-    for ( int c = 1; c < mCPCols - 1; c += 2 )
+    const int r = rows[i];
+    const int c = cols[i];
+    if ( !mCPLegalMatrix[r - rowStep][c - colStep] || !mCPLegalMatrix[r][c] || !mCPLegalMatrix[r + rowStep][c + colStep] )
     {
-      double myDestX, myDestY;
-      destPointOnCPMatrix( r, c, &myDestX, &myDestY );
+      // There was an error earlier in transform, just abort
+      return false;
+    }
 
-      QgsPointXY myDestPoint( myDestX, myDestY );
-      QgsPointXY mySrcPoint1 = mCPMatrix[r][c - 1];
-      QgsPointXY mySrcPoint2 = mCPMatrix[r][c];
-      QgsPointXY mySrcPoint3 = mCPMatrix[r][c + 1];
+    const QgsPointXY &mySrcPoint1 = mCPMatrix[r - rowStep][c - colStep];
+    const QgsPointXY &mySrcPoint3 = mCPMatrix[r + rowStep][c + colStep];
+    x[i] = ( mySrcPoint1.x() + mySrcPoint3.x() ) / 2;
+    y[i] = ( mySrcPoint1.y() + mySrcPoint3.y() ) / 2;
+  }
 
-      QgsPointXY mySrcApprox( ( mySrcPoint1.x() + mySrcPoint3.x() ) / 2, ( mySrcPoint1.y() + mySrcPoint3.y() ) / 2 );
-      if ( !mCPLegalMatrix[r][c - 1] || !mCPLegalMatrix[r][c] || !mCPLegalMatrix[r][c + 1] )
-      {
-        // There was an error earlier in transform, just abort
-        return false;
-      }
-      try
-      {
-        QgsPointXY myDestApprox = ct.transform( mySrcApprox, QgsCoordinateTransform::ReverseTransform );
-        double mySqrDist = myDestApprox.sqrDist( myDestPoint );
-        if ( mySqrDist > mSqrTolerance )
-        {
-          return false;
-        }
-      }
-      catch ( QgsCsException &e )
-      {
-        Q_UNUSED( e )
-        // Caught an error in transform
-        return false;
-      }
+  try
+  {
+    ct.transformCoords( count, x.data(), y.data(), z.data(), QgsCoordinateTransform::ReverseTransform );
+  }
+  catch ( QgsCsException &e )
+  {
+    Q_UNUSED( e )
+    // Caught an error in transform
+    return false;
+  }
+
+  for ( int i = 0; i < count; i++ )
+  {
+    double myDestX, myDestY;
+    destPointOnCPMatrix( rows[i], cols[i], &myDestX, &myDestY );
+    const double mySqrDist = ( x[i] - myDestX ) * ( x[i] - myDestX ) + ( y[i] - myDestY ) * ( y[i] - myDestY );
+    if ( mySqrDist > mSqrTolerance )
+    {
+      return false;
     }
   }
   return true;
@@ -182,11 +182,24 @@ class ProjectorData
     //! Calculate single control point in current matrix
     void calcCP( int row, int col, const QgsCoordinateTransform &ct );
 
-    //! \brief calculate matrix row
-    bool calcRow( int row, const QgsCoordinateTransform &ct );
+    /**
+     * Calculate the control points at the given matrix \a rows and \a cols with a single
+     * transform call, falling back to calcCP() for each point if the batch fails.
+     */
+    void calcCPs( const QVector<int> &rows, const QVector<int> &cols, const QgsCoordinateTransform &ct );
+
+
+    //! Initialize the matrix with \a rows x \a cols control points and calculate them
+    void initCPMatrix( int rows, int cols, const QgsCoordinateTransform &ct );
+
+    /**
+     * Refines mCPMatrix until the approximation is within tolerance.
+     * \returns FALSE if the matrix became too large to be used for approximation
+     */
+    bool refineCPMatrix( const QgsCoordinateTransform &ct );
 
-    //! \brief calculate matrix column
-    bool calcCol( int col, const QgsCoordinateTransform &ct );
+    //! Transform the centers of all cells of destination row \a destRow for preciseSrcRowCol()
+    void calcPreciseRow( int destRow );
 
     //! \brief calculate source extent
     void calcSrcExtent();
@@ -204,6 +217,13 @@ class ProjectorData
       * returns TRUE if within threshold */
     bool checkRows( const QgsCoordinateTransform &ct );
 
+    /**
+     * Check that the midpoints between the neighbors (at \a rowStep, \a colStep) of the control
+     * points at \a rows, \a cols, transformed back to destination in a single call, are within
+     * tolerance of the control points.
+     */
+    bool checkMidpoints( const QVector<int> &rows, const QVector<int> &cols, int rowStep, int colStep, const QgsCoordinateTransform &ct );
+
     //! Calculate array of src helper points
     void calcHelper( int matrixRow, QgsPointXY *points );
 
@@ -290,6 +310,13 @@ class ProjectorData
     double mMaxSrcXRes;
     double mMaxSrcYRes;
 
+    //! Destination row of the source coordinates in mPreciseX / mPreciseY
+    int mPreciseRow = -1;
+
+    //! Source coordinates of the destination cell centers of mPreciseRow (NaN if they can't be transformed)
+    QVector<double> mPreciseX;
+    QVector<double> mPreciseY;
+
 };
 
 /// @endcond
@@ -0,0 +1,355 @@
+/***************************************************************************
+    qgsrasterstatisticssketch.cpp
+    ---------------------
+    begin                : October 2019
+    copyright            : (C) 2019 by the QGIS project
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+#include "qgsrasterstatisticssketch.h"
+#include "qgsrasterblock.h"
+
+#include <QStringList>
+
+#include <algorithm>
+#include <cmath>
+
+//! Version of the string representation
+static const QString SKETCH_FORMAT_VERSION = QStringLiteral( "1" );
+
+QgsRasterStatisticsSketch::QgsRasterStatisticsSketch( double compression )
+  : mCompression( std::max( compression, 10.0 ) )
+{
+}
+
+void QgsRasterStatisticsSketch::addValue( double value )
+{
+  mCount++;
+  mSum += value;
+
+  if ( !std::isfinite( value ) )
+    return;
+
+  mFiniteCount++;
+  mMinimum = std::min( mMinimum, value );
+  mMaximum = std::max( mMaximum, value );
+
+  // Single pass stdev
+  const double delta = value - mMean;
+  mMean += delta / mFiniteCount;
+  mSumOfSquares += delta * ( value - mMean );
+
+  mBuffer.push_back( value );
+  if ( mBuffer.size() >= static_cast< size_t >( 8 * mCompression ) )
+    flush();
+}
+
+void QgsRasterStatisticsSketch::addBlock( const QgsRasterBlock *block )
+{
+  if ( !block )
+    return;
+
+  const qgssize count = static_cast< qgssize >( block->width() ) * block->height();
+  bool isNoData = false;
+  for ( qgssize i = 0; i < count; ++i )
+  {
+    const double value = block->valueAndNoData( i, isNoData );
+    if ( !isNoData )
+      addValue( value );
+  }
+}
+
+void QgsRasterStatisticsSketch::merge( const QgsRasterStatisticsSketch &other )
+{
+  if ( other.mFiniteCount > 0 )
+  {
+    // parallel variant of the single pass stdev (Chan et al.)
+    const double n = static_cast< double >( mFiniteCount ) + other.mFiniteCount;
+    const double delta = other.mMean - mMean;
+    mMean += delta * other.mFiniteCount / n;
+    mSumOfSquares += other.mSumOfSquares + delta * delta * mFiniteCount * other.mFiniteCount / n;
+    mMinimum = std::min( mMinimum, other.mMinimum );
+    mMaximum = std::max( mMaximum, other.mMaximum );
+  }
+  mCount += other.mCount;
+  mFiniteCount += other.mFiniteCount;
+  mSum += other.mSum;
+
+  flush();
+  QgsRasterStatisticsSketch otherSketch( other );
+  otherSketch.flush();
+  mergeCentroids( otherSketch.mCentroids, otherSketch.mExact );
+}
+
+double QgsRasterStatisticsSketch::quantile( double q ) const
+{
+  QgsRasterStatisticsSketch sketch( *this );
+  sketch.flush();
+
+  const QVector< Centroid > &centroids = sketch.mCentroids;
+  if ( centroids.isEmpty() )
+    return std::numeric_limits<double>::quiet_NaN();
+
+  double total = 0;
+  for ( const Centroid &centroid : centroids )
+    total += centroid.weight;
+
+  const double target = std::min( std::max( q, 0.0 ), 1.0 ) * total;
+
+  if ( sketch.mExact )
+  {
+    double cumulative = 0;
+    for ( const Centroid &centroid : centroids )
+    {
+      cumulative += centroid.weight;
+      if ( cumulative >= target )
+        return centroid.mean;
+    }
+    return centroids.last().mean;
+  }
+
+  // the mean of a centroid is placed in the middle of its weight, values in
+  // between are interpolated linearly with the minimum and maximum at the ends
+  double previousPosition = 0;
+  double previousValue = mMinimum;
+  double cumulative = 0;
+  for ( const Centroid &centroid : centroids )
+  {
+    const double position = cumulative + centroid.weight / 2;
+    if ( target <= position )
+    {
+      if ( qgsDoubleNear( position, previousPosition ) )
+        return centroid.mean;
+      return previousValue + ( target - previousPosition ) / ( position - previousPosition ) * ( centroid.mean - previousValue );
+    }
+    previousPosition = position;
+    previousValue = centroid.mean;
+    cumulative += centroid.weight;
+  }
+
+  if ( qgsDoubleNear( total, previousPosition ) )
+    return mMaximum;
+  return previousValue + ( target - previousPosition ) / ( total - previousPosition ) * ( mMaximum - previousValue );
+}
+
+void QgsRasterStatisticsSketch::cumulativeCut( double lowerFraction, double upperFraction, double &lowerValue, double &upperValue ) const
+{
+  lowerValue = std::numeric_limits<double>::quiet_NaN();
+  upperValue = std::numeric_limits<double>::quiet_NaN();
+
+  QgsRasterStatisticsSketch sketch( *this );
+  sketch.flush();
+
+  const QVector< Centroid > &centroids = sketch.mCentroids;
+  if ( centroids.isEmpty() )
+    return;
+
+  if ( !sketch.mExact )
+  {
+    lowerValue = sketch.quantile( lowerFraction );
+    upperValue = sketch.quantile( upperFraction );
+    return;
+  }
+
+  double total = 0;
+  for ( const Centroid &centroid : centroids )
+    total += centroid.weight;
+
+  const double lowerCount = std::round( lowerFraction * total );
+  const double upperCount = std::round( upperFraction * total );
+  double cumulative = 0;
+  for ( const Centroid &centroid : centroids )
+  {
+    cumulative += centroid.weight;
+    if ( std::isnan( lowerValue ) && cumulative > lowerCount )
+      lowerValue = centroid.mean;
+    if ( cumulative >= upperCount )
+    {
+      upperValue = centroid.mean;
+      break;
+    }
+  }
+}
+
+bool QgsRasterStatisticsSketch::isExact() const
+{
+  QgsRasterStatisticsSketch sketch( *this );
+  sketch.flush();
+  return sketch.mExact;
+}
+
+QString QgsRasterStatisticsSketch::toString() const
+{
+  QgsRasterStatisticsSketch sketch( *this );
+  sketch.flush();
+
+  QStringList centroids;
+  centroids.reserve( sketch.mCentroids.size() );
+  for ( const Centroid &centroid : qgis::as_const( sketch.mCentroids ) )
+  {
+    centroids << QStringLiteral( "%1:%2" ).arg( QString::number( centroid.mean, 'g', 17 ), QString::number( centroid.weight, 'g', 17 ) );
+  }
+
+  return QStringList( { SKETCH_FORMAT_VERSION,
+                        QString::number( sketch.mCount ),
+                        QString::number( sketch.mFiniteCount ),
+                        QString::number( sketch.mSum, 'g', 17 ),
+                        QString::number( sketch.mMean, 'g', 17 ),
+                        QString::number( sketch.mSumOfSquares, 'g', 17 ),
+                        QString::number( sketch.mMinimum, 'g', 17 ),
+                        QString::number( sketch.mMaximum, 'g', 17 ),
+                        QString::number( sketch.mCompression, 'g', 17 ),
+                        sketch.mExact ? QStringLiteral( "1" ) : QStringLiteral( "0" ),
+                        centroids.join( ',' ) } ).join( ';' );
+}
+
+QgsRasterStatisticsSketch QgsRasterStatisticsSketch::fromString( const QString &string, bool *ok )
+{
+  if ( ok )
+    *ok = false;
+
+  const QStringList parts = string.split( ';' );
+  if ( parts.size() != 11 || parts.at( 0 ) != SKETCH_FORMAT_VERSION )
+    return QgsRasterStatisticsSketch();
+
+  bool valid = true;
+  auto toDouble = [&valid]( const QString & value )
+  {
+    bool ok = false;
+    const double result = value.toDouble( &ok );
+    valid = valid && ok;
+    return result;
+  };
+
+  bool countsValid = false;
+  bool finiteCountsValid = false;
+  QgsRasterStatisticsSketch sketch( toDouble( parts.at( 8 ) ) );
+  sketch.mCount = parts.at( 1 ).toULongLong( &countsValid );
+  sketch.mFiniteCount = parts.at( 2 ).toULongLong( &finiteCountsValid );
+  valid = valid && countsValid && finiteCountsValid;
+  sketch.mSum = toDouble( parts.at( 3 ) );
+  sketch.mMean = toDouble( parts.at( 4 ) );
+  sketch.mSumOfSquares = toDouble( parts.at( 5 ) );
+  sketch.mMinimum = toDouble( parts.at( 6 ) );
+  sketch.mMaximum = toDouble( parts.at( 7 ) );
+  sketch.mExact = parts.at( 9 ) == QLatin1String( "1" );
+
+  const QStringList centroids = parts.at( 10 ).split( ',', QString::SkipEmptyParts );
+  sketch.mCentroids.reserve( centroids.size() );
+  for ( const QString &centroid : centroids )
+  {
+    const QStringList values = centroid.split( ':' );
+    if ( values.size() != 2 )
+      return QgsRasterStatisticsSketch();
+    sketch.mCentroids.append( { toDouble( values.at( 0 ) ), toDouble( values.at( 1 ) ) } );
+  }
+
+  if ( !valid )
+    return QgsRasterStatisticsSketch();
+
+  if ( ok )
+    *ok = true;
+  return sketch;
+}
+
+void QgsRasterStatisticsSketch::flush()
+{
+  if ( mBuffer.empty() )
+    return;
+
+  std::sort( mBuffer.begin(), mBuffer.end() );
+
+  QVector< Centroid > centroids;
+  for ( double value : mBuffer )
+  {
+    if ( !centroids.isEmpty() && centroids.last().mean == value )
+      centroids.last().weight += 1;
+    else
+      centroids.append( { value, 1 } );
+  }
+  mBuffer.clear();
+
+  mergeCentroids( centroids, true );
+}
+
+void QgsRasterStatisticsSketch::mergeCentroids( const QVector< Centroid > &centroids, bool exact )
+{
+  if ( centroids.isEmpty() )
+    return;
+
+  QVector< Centroid > merged;
+  merged.reserve( mCentroids.size() + centroids.size() );
+
+  auto append = [&merged]( const Centroid & centroid )
+  {
+    if ( !merged.isEmpty() && merged.last().mean == centroid.mean )
+      merged.last().weight += centroid.weight;
+    else
+      merged.append( centroid );
+  };
+
+  int i = 0;
+  int j = 0;
+  while ( i < mCentroids.size() || j < centroids.size() )
+  {
+    if ( j >= centroids.size() || ( i < mCentroids.size() && mCentroids.at( i ).mean <= centroids.at( j ).mean ) )
+      append( mCentroids.at( i++ ) );
+    else
+      append( centroids.at( j++ ) );
+  }
+  mCentroids = merged;
+
+  mExact = mExact && exact && mCentroids.size() <= MAX_EXACT_VALUES;
+  if ( !mExact )
+    compress();
+}
+
+void QgsRasterStatisticsSketch::compress()
+{
+  if ( mCentroids.size() <= 1 )
+    return;
+
+  double total = 0;
+  for ( const Centroid &centroid : qgis::as_const( mCentroids ) )
+    total += centroid.weight;
+
+  // k1 scale function of the t-digest: centroids are small near the tails,
+  // which keeps the estimate of low and high quantiles accurate
+  const double compression = mCompression;
+  auto scale = [compression]( double q )
+  {
+    return compression / ( 2 * M_PI ) * std::asin( 2 * q - 1 );
+  };
+  auto inverseScale = [compression]( double k )
+  {
+    return ( std::sin( std::min( k, compression / 4 ) * 2 * M_PI / compression ) + 1 ) / 2;
+  };
+
+  QVector< Centroid > compressed;
+  Centroid current = mCentroids.at( 0 );
+  double weightSoFar = 0;
+  double weightLimit = total * inverseScale( scale( 0 ) + 1 );
+  for ( int i = 1; i < mCentroids.size(); ++i )
+  {
+    const Centroid &next = mCentroids.at( i );
+    if ( weightSoFar + current.weight + next.weight <= weightLimit )
+    {
+      current.weight += next.weight;
+      current.mean += ( next.mean - current.mean ) * next.weight / current.weight;
+    }
+    else
+    {
+      compressed.append( current );
+      weightSoFar += current.weight;
+      weightLimit = total * inverseScale( scale( weightSoFar / total ) + 1 );
+      current = next;
+    }
+  }
+  compressed.append( current );
+  mCentroids = compressed;
+}
@@ -0,0 +1,155 @@
+/***************************************************************************
+    qgsrasterstatisticssketch.h
+    ---------------------
+    begin                : October 2019
+    copyright            : (C) 2019 by the QGIS project
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+#ifndef QGSRASTERSTATISTICSSKETCH_H
+#define QGSRASTERSTATISTICSSKETCH_H
+
+#define SIP_NO_FILE
+
+#include "qgis_core.h"
+#include "qgis.h"
+
+#include <QString>
+#include <QVector>
+#include <limits>
+#include <vector>
+
+class QgsRasterBlock;
+
+/**
+ * \ingroup core
+ * One pass summary of raster values: moments, minimum and maximum plus a
+ * quantile sketch.
+ *
+ * The quantile sketch is a merging t-digest. As long as there are only few
+ * distinct values (e.g. for Byte data) the exact count of every value is kept
+ * instead, so quantiles of such data are exact.
+ *
+ * Sketches of parts of a raster can be merged, which allows to summarize
+ * blocks in parallel. Sketches can be serialized to strings to persist them
+ * with a dataset.
+ *
+ * \note not available in Python bindings
+ * \since QGIS 3.10
+ */
+class CORE_EXPORT QgsRasterStatisticsSketch
+{
+  public:
+
+    //! Default compression of the t-digest, the number of centroids is about twice this value
+    static const int DEFAULT_COMPRESSION = 200;
+
+    //! Maximum number of distinct values which are counted exactly
+    static const int MAX_EXACT_VALUES = 1024;
+
+    //! Constructor for an empty sketch with the given \a compression
+    explicit QgsRasterStatisticsSketch( double compression = DEFAULT_COMPRESSION );
+
+    //! Adds a single \a value to the sketch
+    void addValue( double value );
+
+    //! Adds all values of \a block which are not no data
+    void addBlock( const QgsRasterBlock *block );
+
+    //! Merges the values summarized by \a other into this sketch
+    void merge( const QgsRasterStatisticsSketch &other );
+
+    //! Returns the number of values added, including infinite values
+    qgssize count() const { return mCount; }
+
+    //! Returns the number of finite values added
+    qgssize finiteCount() const { return mFiniteCount; }
+
+    //! Returns the sum of all values
+    double sum() const { return mSum; }
+
+    //! Returns the minimum of the finite values, or NaN if there are none
+    double minimum() const { return mFiniteCount > 0 ? mMinimum : std::numeric_limits<double>::quiet_NaN(); }
+
+    //! Returns the maximum of the finite values, or NaN if there are none
+    double maximum() const { return mFiniteCount > 0 ? mMaximum : std::numeric_limits<double>::quiet_NaN(); }
+
+    //! Returns the mean of the finite values
+    double mean() const { return mMean; }
+
+    //! Returns the sum of the squared differences of the finite values to their mean
+    double sumOfSquares() const { return mSumOfSquares; }
+
+    /**
+     * Returns the (approximate) value below which the fraction \a q (0-1) of the
+     * finite values lies, or NaN if the sketch does not contain finite values.
+     */
+    double quantile( double q ) const;
+
+    /**
+     * Calculates the values cutting off the fractions \a lowerFraction and
+     * \a upperFraction (0-1) of the finite values, as used for cumulative cut
+     * contrast enhancement limits.
+     *
+     * Exact sketches follow the rule of a cut of a histogram with one bin per value:
+     * \a lowerValue is the first value whose cumulative count exceeds the rounded
+     * lower count, \a upperValue the first value whose cumulative count reaches the
+     * rounded upper count. Otherwise the quantiles are used.
+     *
+     * Both values are set to NaN if the sketch does not contain finite values.
+     */
+    void cumulativeCut( double lowerFraction, double upperFraction, double &lowerValue, double &upperValue ) const;
+
+    //! Returns TRUE if quantiles are exact, i.e. the sketch counts all distinct values
+    bool isExact() const;
+
+    //! Serializes the sketch to a string
+    QString toString() const;
+
+    /**
+     * Restores a sketch from a \a string created by toString(). If \a ok is
+     * set it will be set to FALSE if the string could not be parsed.
+     */
+    static QgsRasterStatisticsSketch fromString( const QString &string, bool *ok = nullptr );
+
+  private:
+
+    struct Centroid
+    {
+      double mean;
+      double weight;
+    };
+
+    //! Merges the buffered values into the centroids
+    void flush();
+
+    //! Merges the sorted \a centroids into the centroids of the sketch
+    void mergeCentroids( const QVector< Centroid > &centroids, bool exact );
+
+    //! Merges neighboring centroids up to the size limit of the t-digest
+    void compress();
+
+    double mCompression = DEFAULT_COMPRESSION;
+
+    qgssize mCount = 0;
+    qgssize mFiniteCount = 0;
+    double mSum = 0;
+    double mMean = 0;
+    double mSumOfSquares = 0;
+    double mMinimum = std::numeric_limits<double>::max();
+    double mMaximum = std::numeric_limits<double>::lowest();
+
+    //! Centroids sorted by mean
+    QVector< Centroid > mCentroids;
+    //! TRUE as long as every centroid is a distinct value with its count
+    bool mExact = true;
+    //! Values not merged into the centroids yet
+    std::vector< double > mBuffer;
+};
+
+#endif // QGSRASTERSTATISTICSSKETCH_H
@@ -18,6 +18,7 @@
 #include "qgssinglebandgrayrenderer.h"
 #include "qgscontrastenhancement.h"
 #include "qgsrastertransparency.h"
+#include "qgsrasterlookuptable_p.h"
 #include <QDomDocument>
 #include <QDomElement>
 #include <QImage>
@@ -116,34 +117,23 @@ QgsRasterBlock *QgsSingleBandGrayRenderer::block( int bandNo, const QgsRectangle
     return outputBlock.release();
   }
 
-  QRgb myDefaultColor = NODATA_COLOR;
-  bool isNoData = false;
-  for ( qgssize i = 0; i < ( qgssize )width * height; i++ )
-  {
-    double grayVal = inputBlock->valueAndNoData( i, isNoData );
-
-    if ( isNoData )
-    {
-      outputBlock->setColor( i, myDefaultColor );
-      continue;
-    }
+  const QRgb myDefaultColor = NODATA_COLOR;
 
+  // Returns the color of a gray value, alphaFactor is the value of the alpha band (0-1)
+  auto grayColor = [this, myDefaultColor]( double grayVal, double alphaFactor ) -> QRgb
+  {
     double currentAlpha = mOpacity;
     if ( mRasterTransparency )
     {
       currentAlpha = mRasterTransparency->alphaValue( grayVal, mOpacity * 255 ) / 255.0;
     }
-    if ( mAlphaBand > 0 )
-    {
-      currentAlpha *= alphaBlock->value( i ) / 255.0;
-    }
+    currentAlpha *= alphaFactor;
 
     if ( mContrastEnhancement )
     {
       if ( !mContrastEnhancement->isValueInDisplayableRange( grayVal ) )
       {
-        outputBlock->setColor( i, myDefaultColor );
-        continue;
+        return myDefaultColor;
       }
       grayVal = mContrastEnhancement->enhanceContrast( grayVal );
     }
@@ -155,12 +145,37 @@ QgsRasterBlock *QgsSingleBandGrayRenderer::block( int bandNo, const QgsRectangle
 
     if ( qgsDoubleNear( currentAlpha, 1.0 ) )
     {
-      outputBlock->setColor( i, qRgba( grayVal, grayVal, grayVal, 255 ) );
+      return qRgba( grayVal, grayVal, grayVal, 255 );
     }
     else
     {
-      outputBlock->setColor( i, qRgba( currentAlpha * grayVal, currentAlpha * grayVal, currentAlpha * grayVal, currentAlpha * 255 ) );
+      return qRgba( currentAlpha * grayVal, currentAlpha * grayVal, currentAlpha * grayVal, currentAlpha * 255 );
+    }
+  };
+
+  QRgb *outputBlockData = outputBlock->colorData();
+  const qgssize count = static_cast< qgssize >( width ) * height;
+
+  // Byte and 16 bit data without alpha band: calculate the color of every value only once
+  QgsRasterLookupTable< QRgb > lookupTable;
+  if ( !alphaBlock && lookupTable.build( inputBlock.get(), myDefaultColor, [&grayColor]( double value ) { return grayColor( value, 1.0 ); } ) )
+  {
+    lookupTable.map( 0, count, outputBlockData );
+    return outputBlock.release();
+  }
+
+  bool isNoData = false;
+  for ( qgssize i = 0; i < count; i++ )
+  {
+    const double grayVal = inputBlock->valueAndNoData( i, isNoData );
+
+    if ( isNoData )
+    {
+      outputBlockData[i] = myDefaultColor;
+      continue;
     }
+
+    outputBlockData[i] = grayColor( grayVal, mAlphaBand > 0 ? alphaBlock->value( i ) / 255.0 : 1.0 );
   }
 
   return outputBlock.release();
@@ -20,6 +20,7 @@
 #include "qgscolorrampshader.h"
 #include "qgsrastershader.h"
 #include "qgsrastertransparency.h"
+#include "qgsrasterlookuptable_p.h"
 #include "qgsrasterviewport.h"
 #include "qgsstyleentityvisitor.h"
 
@@ -234,26 +235,17 @@ QgsRasterBlock *QgsSingleBandPseudoColorRenderer::block( int bandNo, QgsRectangl
     return outputBlock.release();
   }
 
-  QRgb myDefaultColor = NODATA_COLOR;
+  const QRgb myDefaultColor = NODATA_COLOR;
   QRgb *outputBlockData = outputBlock->colorData();
   const QgsRasterShaderFunction *fcn = mShader->rasterShaderFunction();
 
-  qgssize count = ( qgssize )width * height;
-  bool isNoData = false;
-  for ( qgssize i = 0; i < count; i++ )
+  // Returns the color of a value, alphaFactor is the value of the alpha band (0-1)
+  auto pixelColor = [this, fcn, hasTransparency, myDefaultColor]( double val, double alphaFactor ) -> QRgb
   {
-    double val = inputBlock->valueAndNoData( i, isNoData );
-    if ( isNoData )
-    {
-      outputBlockData[i] = myDefaultColor;
-      continue;
-    }
-
     int red, green, blue, alpha;
     if ( !fcn->shade( val, &red, &green, &blue, &alpha ) )
     {
-      outputBlockData[i] = myDefaultColor;
-      continue;
+      return myDefaultColor;
     }
 
     if ( alpha < 255 )
@@ -266,7 +258,7 @@ QgsRasterBlock *QgsSingleBandPseudoColorRenderer::block( int bandNo, QgsRectangl
 
     if ( !hasTransparency )
     {
-      outputBlockData[i] = qRgba( red, green, blue, alpha );
+      return qRgba( red, green, blue, alpha );
     }
     else
     {
@@ -276,13 +268,33 @@ QgsRasterBlock *QgsSingleBandPseudoColorRenderer::block( int bandNo, QgsRectangl
       {
         currentOpacity = mRasterTransparency->alphaValue( val, mOpacity * 255 ) / 255.0;
       }
-      if ( mAlphaBand > 0 )
-      {
-        currentOpacity *= alphaBlock->value( i ) / 255.0;
-      }
+      currentOpacity *= alphaFactor;
 
-      outputBlockData[i] = qRgba( currentOpacity * red, currentOpacity * green, currentOpacity * blue, currentOpacity * alpha );
+      return qRgba( currentOpacity * red, currentOpacity * green, currentOpacity * blue, currentOpacity * alpha );
     }
+  };
+
+  qgssize count = ( qgssize )width * height;
+
+  // Byte and 16 bit data without alpha band: shade every value only once
+  QgsRasterLookupTable< QRgb > lookupTable;
+  if ( !alphaBlock && lookupTable.build( inputBlock.get(), myDefaultColor, [&pixelColor]( double value ) { return pixelColor( value, 1.0 ); } ) )
+  {
+    lookupTable.map( 0, count, outputBlockData );
+    return outputBlock.release();
+  }
+
+  bool isNoData = false;
+  for ( qgssize i = 0; i < count; i++ )
+  {
+    double val = inputBlock->valueAndNoData( i, isNoData );
+    if ( isNoData )
+    {
+      outputBlockData[i] = myDefaultColor;
+      continue;
+    }
+
+    outputBlockData[i] = pixelColor( val, mAlphaBand > 0 ? alphaBlock->value( i ) / 255.0 : 1.0 );
   }
 
   return outputBlock.release();
@@ -1950,7 +1950,38 @@ QString QgsSvgMarkerSymbolLayer::layerType() const
 void QgsSvgMarkerSymbolLayer::startRender( QgsSymbolRenderContext &context )
 {
   QgsMarkerSymbolLayer::startRender( context ); // get anchor point expressions
-  Q_UNUSED( context )
+
+  // if all features are drawn with the same image, rasterize it into the SVG cache before
+  // the features are rendered, so that rendering them only needs a quick cache lookup
+  if ( mPath.isEmpty() || context.renderContext().forceVectorOutput() || context.renderHints() & QgsSymbol::DynamicRotation
+       || !qgsDoubleNear( mAngle + mLineAngle, 0 ) )
+    return;
+
+  const QList< QgsSymbolLayer::Property > dataDefinedImageProperties
+  {
+    QgsSymbolLayer::PropertyName,
+    QgsSymbolLayer::PropertySize,
+    QgsSymbolLayer::PropertyWidth,
+    QgsSymbolLayer::PropertyHeight,
+    QgsSymbolLayer::PropertyAngle,
+    QgsSymbolLayer::PropertyStrokeWidth,
+    QgsSymbolLayer::PropertyFillColor,
+    QgsSymbolLayer::PropertyStrokeColor
+  };
+  for ( QgsSymbolLayer::Property property : dataDefinedImageProperties )
+  {
+    if ( mDataDefinedProperties.isActive( property ) )
+      return;
+  }
+
+  const double size = context.renderContext().convertToPainterUnits( mSize, mSizeUnit, mSizeMapUnitScale );
+  if ( static_cast< int >( size ) < 1 || 10000.0 < size )
+    return;
+
+  const double strokeWidth = context.renderContext().convertToPainterUnits( mStrokeWidth, mStrokeWidthUnit, mStrokeWidthMapUnitScale );
+  bool fitsInCache = true;
+  QgsApplication::svgCache()->svgAsImage( mPath, size, mColor, mStrokeColor, strokeWidth,
+                                          context.renderContext().scaleFactor(), fitsInCache, mFixedAspectRatio );
 }
 
 void QgsSvgMarkerSymbolLayer::stopRender( QgsSymbolRenderContext &context )
@@ -122,10 +122,11 @@ QgsSvgCache::QgsSvgCache( QObject *parent )
 QImage QgsSvgCache::svgAsImage( const QString &file, double size, const QColor &fill, const QColor &stroke, double strokeWidth,
                                 double widthScaleFactor, bool &fitsInCache, double fixedAspectRatio )
 {
-  QMutexLocker locker( &mMutex );
+  std::unique_ptr< QgsSvgCacheEntry > entryTemplate = qgis::make_unique< QgsSvgCacheEntry >( file, size, strokeWidth, widthScaleFactor, fill, stroke, fixedAspectRatio );
+  QMutexLocker locker( mutexForEntry( entryTemplate.get() ) );
 
   fitsInCache = true;
-  QgsSvgCacheEntry *currentEntry = cacheEntry( file, size, fill, stroke, strokeWidth, widthScaleFactor, fixedAspectRatio );
+  QgsSvgCacheEntry *currentEntry = cacheEntry( entryTemplate.release() );
 
   QImage result;
 
@@ -169,7 +170,7 @@ QImage QgsSvgCache::svgAsImage( const QString &file, double size, const QColor &
       cacheImage( currentEntry );
       result = *( currentEntry->image );
     }
-    trimToMaximumSize();
+    trimToMaximumSize( currentEntry );
   }
   else
   {
@@ -182,16 +183,17 @@ QImage QgsSvgCache::svgAsImage( const QString &file, double size, const QColor &
 QPicture QgsSvgCache::svgAsPicture( const QString &path, double size, const QColor &fill, const QColor &stroke, double strokeWidth,
                                     double widthScaleFactor, bool forceVectorOutput, double fixedAspectRatio )
 {
-  QMutexLocker locker( &mMutex );
+  std::unique_ptr< QgsSvgCacheEntry > entryTemplate = qgis::make_unique< QgsSvgCacheEntry >( path, size, strokeWidth, widthScaleFactor, fill, stroke, fixedAspectRatio );
+  QMutexLocker locker( mutexForEntry( entryTemplate.get() ) );
 
-  QgsSvgCacheEntry *currentEntry = cacheEntry( path, size, fill, stroke, strokeWidth, widthScaleFactor, fixedAspectRatio );
+  QgsSvgCacheEntry *currentEntry = cacheEntry( entryTemplate.release() );
 
   //if current entry picture is 0: cache picture for entry
   //update stats for memory usage
   if ( !currentEntry->picture )
   {
     cachePicture( currentEntry, forceVectorOutput );
-    trimToMaximumSize();
+    trimToMaximumSize( currentEntry );
   }
 
   QPicture p;
@@ -206,18 +208,20 @@ QPicture QgsSvgCache::svgAsPicture( const QString &path, double size, const QCol
 QByteArray QgsSvgCache::svgContent( const QString &path, double size, const QColor &fill, const QColor &stroke, double strokeWidth,
                                     double widthScaleFactor, double fixedAspectRatio )
 {
-  QMutexLocker locker( &mMutex );
+  std::unique_ptr< QgsSvgCacheEntry > entryTemplate = qgis::make_unique< QgsSvgCacheEntry >( path, size, strokeWidth, widthScaleFactor, fill, stroke, fixedAspectRatio );
+  QMutexLocker locker( mutexForEntry( entryTemplate.get() ) );
 
-  QgsSvgCacheEntry *currentEntry = cacheEntry( path, size, fill, stroke, strokeWidth, widthScaleFactor, fixedAspectRatio );
+  QgsSvgCacheEntry *currentEntry = cacheEntry( entryTemplate.release() );
 
   return currentEntry->svgContent;
 }
 
 QSizeF QgsSvgCache::svgViewboxSize( const QString &path, double size, const QColor &fill, const QColor &stroke, double strokeWidth, double widthScaleFactor, double fixedAspectRatio )
 {
-  QMutexLocker locker( &mMutex );
+  std::unique_ptr< QgsSvgCacheEntry > entryTemplate = qgis::make_unique< QgsSvgCacheEntry >( path, size, strokeWidth, widthScaleFactor, fill, stroke, fixedAspectRatio );
+  QMutexLocker locker( mutexForEntry( entryTemplate.get() ) );
 
-  QgsSvgCacheEntry *currentEntry = cacheEntry( path, size, fill, stroke, strokeWidth, widthScaleFactor, fixedAspectRatio );
+  QgsSvgCacheEntry *currentEntry = cacheEntry( entryTemplate.release() );
   return currentEntry->viewboxSize;
 }
 
@@ -307,7 +311,7 @@ void QgsSvgCache::replaceParamsAndCacheSvg( QgsSvgCacheEntry *entry )
   entry->svgContent.replace( "\n<tspan", "<tspan" );
   entry->svgContent.replace( "</tspan>\n", "</tspan>" );
 
-  mTotalSize += entry->svgContent.size();
+  addCachedSize( entry, entry->svgContent.size() );
 }
 
 double QgsSvgCache::calcSizeScaleFactor( QgsSvgCacheEntry *entry, const QDomElement &docElem, QSizeF &viewboxSize ) const
@@ -415,7 +419,7 @@ void QgsSvgCache::cacheImage( QgsSvgCacheEntry *entry )
     r.render( &p, rect );
   }
 
-  mTotalSize += ( image->width() * image->height() * 32 );
+  addCachedSize( entry, image->width() * image->height() * 32 );
   entry->image = std::move( image );
 }
 
@@ -458,13 +462,12 @@ void QgsSvgCache::cachePicture( QgsSvgCacheEntry *entry, bool forceVectorOutput
   QPainter p( picture.get() );
   r.render( &p, rect );
   entry->picture = std::move( picture );
-  mTotalSize += entry->picture->size();
+  addCachedSize( entry, entry->picture->size() );
 }
 
-QgsSvgCacheEntry *QgsSvgCache::cacheEntry( const QString &path, double size, const QColor &fill, const QColor &stroke, double strokeWidth,
-    double widthScaleFactor, double fixedAspectRatio )
+QgsSvgCacheEntry *QgsSvgCache::cacheEntry( QgsSvgCacheEntry *entryTemplate )
 {
-  QgsSvgCacheEntry *currentEntry = findExistingEntry( new QgsSvgCacheEntry( path, size, strokeWidth, widthScaleFactor, fill, stroke, fixedAspectRatio ) );
+  QgsSvgCacheEntry *currentEntry = findExistingEntry( entryTemplate );
 
   if ( currentEntry->svgContent.isEmpty() )
   {
@@ -475,6 +478,12 @@ QgsSvgCacheEntry *QgsSvgCache::cacheEntry( const QString &path, double size, con
 }
 
 
+uint QgsSvgCache::entryHash( const QgsSvgCacheEntry *entry ) const
+{
+  // sizes are compared with a tolerance by isEqual(), so only their rounded value can be hashed
+  return qHash( entry->path ) ^ qHash( qRound( entry->size ) ) ^ entry->fill.rgba() ^ ( entry->stroke.rgba() * 31 );
+}
+
 void QgsSvgCache::replaceElemParams( QDomElement &elem, const QColor &fill, const QColor &stroke, double strokeWidth )
 {
   if ( elem.isNull() )
@@ -216,9 +216,16 @@ class CORE_EXPORT QgsSvgCache : public QgsAbstractContentCache< QgsSvgCacheEntry
     void replaceParamsAndCacheSvg( QgsSvgCacheEntry *entry );
     void cacheImage( QgsSvgCacheEntry *entry );
     void cachePicture( QgsSvgCacheEntry *entry, bool forceVectorOutput = false );
-    //! Returns entry from cache or creates a new entry if it does not exist already
-    QgsSvgCacheEntry *cacheEntry( const QString &path, double size, const QColor &fill, const QColor &stroke, double strokeWidth,
-                                  double widthScaleFactor, double fixedAspectRatio = 0 );
+
+    /**
+     * Returns the entry from the cache matching \a entryTemplate or creates a new entry if it does not exist already.
+     * Ownership of \a entryTemplate is transferred, the lock for the entry must be held.
+     */
+    QgsSvgCacheEntry *cacheEntry( QgsSvgCacheEntry *entryTemplate );
+
+#ifndef SIP_RUN
+    uint entryHash( const QgsSvgCacheEntry *entry ) const override;
+#endif
 
     //! Replaces parameters in elements of a dom node and calls method for all child nodes
     void replaceElemParams( QDomElement &elem, const QColor &fill, const QColor &stroke, double strokeWidth );
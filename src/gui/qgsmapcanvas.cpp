@@ -456,6 +456,7 @@ void QgsMapCanvas::clearCache()
 void QgsMapCanvas::setParallelRenderingEnabled( bool enabled )
 {
   mUseParallelRendering = enabled;
+  mSettings.setFlag( QgsMapSettings::RenderLayerTilesInParallel, enabled );
 }
 
 bool QgsMapCanvas::isParallelRenderingEnabled() const
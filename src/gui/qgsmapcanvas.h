@@ -168,7 +168,9 @@ class GUI_EXPORT QgsMapCanvas : public QGraphicsView
     void waitWhileRendering();
 
     /**
-     * Set whether the layers are rendered in parallel or sequentially
+     * Set whether the layers are rendered in parallel or sequentially.
+     * When enabled, heavy vector layers are also split into tiles which are rendered
+     * in parallel (see QgsMapSettings::RenderLayerTilesInParallel).
      * \since QGIS 2.4
      */
     void setParallelRenderingEnabled( bool enabled );
@@ -302,6 +302,8 @@ void QgsDelimitedTextProvider::scanFile( bool buildIndexes )
 
   resetIndexes();
   bool buildSpatialIndex = buildIndexes && nullptr != mSpatialIndex;
+  // bounding boxes are collected while scanning and bulk loaded into the index afterwards
+  QVector< QPair< QgsFeatureId, QgsRectangle > > spatialIndexEntries;
 
   // No point building a subset index if there is no geometry, as all
   // records will be included.
@@ -438,10 +440,9 @@ void QgsDelimitedTextProvider::scanFile( bool buildIndexes )
               }
               if ( buildSpatialIndex )
               {
-                QgsFeature f;
-                f.setId( mFile->recordId() );
-                f.setGeometry( geom );
-                mSpatialIndex->addFeature( f );
+                const QgsRectangle bbox = geom.boundingBox();
+                if ( bbox.isFinite() )
+                  spatialIndexEntries.append( qMakePair( static_cast< QgsFeatureId >( mFile->recordId() ), bbox ) );
               }
             }
             else
@@ -493,10 +494,7 @@ void QgsDelimitedTextProvider::scanFile( bool buildIndexes )
           mNumberFeatures++;
           if ( buildSpatialIndex && std::isfinite( pt.x() ) && std::isfinite( pt.y() ) )
           {
-            QgsFeature f;
-            f.setId( mFile->recordId() );
-            f.setGeometry( QgsGeometry::fromPointXY( pt ) );
-            mSpatialIndex->addFeature( f );
+            spatialIndexEntries.append( qMakePair( static_cast< QgsFeatureId >( mFile->recordId() ), QgsRectangle( pt.x(), pt.y(), pt.x(), pt.y() ) ) );
           }
         }
         else
@@ -673,6 +671,8 @@ void QgsDelimitedTextProvider::scanFile( bool buildIndexes )
       mSubsetIndex = QList<quintptr>();
   }
 
+  if ( buildSpatialIndex )
+    mSpatialIndex = qgis::make_unique< QgsSpatialIndex >( spatialIndexEntries );
   mUseSpatialIndex = buildSpatialIndex;
 
   mValid = mGeometryType != QgsWkbTypes::UnknownGeometry;
@@ -692,6 +692,7 @@ void QgsDelimitedTextProvider::rescanFile() const
 
   bool buildSpatialIndex = nullptr != mSpatialIndex;
   bool buildSubsetIndex = mBuildSubsetIndex && ( mSubsetExpression || mGeomRep != GeomNone );
+  QVector< QPair< QgsFeatureId, QgsRectangle > > spatialIndexEntries;
 
   // In case file has been rewritten check that it is still valid
 
@@ -754,18 +755,18 @@ void QgsDelimitedTextProvider::rescanFile() const
   {
     if ( mGeometryType != QgsWkbTypes::NullGeometry && f.hasGeometry() )
     {
+      QgsRectangle bbox( f.geometry().boundingBox() );
       if ( !foundFirstGeometry )
       {
-        mExtent = f.geometry().boundingBox();
+        mExtent = bbox;
         foundFirstGeometry = true;
       }
       else
       {
-        QgsRectangle bbox( f.geometry().boundingBox() );
         mExtent.combineExtentWith( bbox );
       }
-      if ( buildSpatialIndex )
-        mSpatialIndex->addFeature( f );
+      if ( buildSpatialIndex && bbox.isFinite() )
+        spatialIndexEntries.append( qMakePair( f.id(), bbox ) );
     }
     if ( buildSubsetIndex )
       mSubsetIndex.append( ( quintptr ) f.id() );
@@ -780,6 +781,8 @@ void QgsDelimitedTextProvider::rescanFile() const
       mSubsetIndex.clear();
   }
 
+  if ( buildSpatialIndex )
+    mSpatialIndex = qgis::make_unique< QgsSpatialIndex >( spatialIndexEntries );
   mUseSpatialIndex = buildSpatialIndex;
 }
 
@@ -1228,6 +1228,11 @@ PGresult *QgsPostgresConn::PQgetResult()
   return ::PQgetResult( mConn );
 }
 
+int QgsPostgresConn::PQconsumeInput()
+{
+  return ::PQconsumeInput( mConn );
+}
+
 PGresult *QgsPostgresConn::PQprepare( const QString &stmtName, const QString &query, int nParams, const Oid *paramTypes )
 {
   QMutexLocker locker( &mLock );
@@ -1809,6 +1814,7 @@ QgsDataSourceUri QgsPostgresConn::connUri( const QString &connName )
   QString database = settings.value( key + "/database" ).toString();
 
   bool useEstimatedMetadata = settings.value( key + "/estimatedMetadata", false ).toBool();
+  bool binaryAttributes = settings.value( key + "/binaryAttributes", false ).toBool();
   QgsDataSourceUri::SslMode sslmode = settings.enumValue( key + "/sslmode", QgsDataSourceUri::SslPrefer );
 
   QString username;
@@ -1846,6 +1852,8 @@ QgsDataSourceUri QgsPostgresConn::connUri( const QString &connName )
     uri.setConnection( host, port, database, username, password, sslmode, authcfg );
   }
   uri.setUseEstimatedMetadata( useEstimatedMetadata );
+  if ( binaryAttributes )
+    uri.setParam( QStringLiteral( "binaryAttributes" ), QStringLiteral( "1" ) );
 
   return uri;
 }
@@ -1898,6 +1906,7 @@ void QgsPostgresConn::deleteConnection( const QString &connName )
   settings.remove( key + "/geometryColumnsOnly" );
   settings.remove( key + "/allowGeometrylessTables" );
   settings.remove( key + "/estimatedMetadata" );
+  settings.remove( key + "/binaryAttributes" );
   settings.remove( key + "/saveUsername" );
   settings.remove( key + "/savePassword" );
   settings.remove( key + "/save" );
@@ -265,6 +265,12 @@ class QgsPostgresConn : public QObject
      */
     PGresult *PQgetResult();
 
+    /**
+     * PQconsumeInput reads pending input of an asynchronous query (started with PQsendQuery) without blocking
+     * Thread safety must be ensured by the caller by calling QgsPostgresConn::lock() and QgsPostgresConn::unlock()
+     */
+    int PQconsumeInput();
+
     bool begin();
     bool commit();
     bool rollback();
@@ -23,8 +23,12 @@
 #include "qgssettings.h"
 #include "qgsexception.h"
 
-#include <QElapsedTimer>
 #include <QObject>
+#include <QtEndian>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
 
 QgsPostgresFeatureIterator::QgsPostgresFeatureIterator( QgsPostgresFeatureSource *source, bool ownSource, const QgsFeatureRequest &request )
   : QgsAbstractFeatureIteratorFromSource<QgsPostgresFeatureSource>( source, ownSource, request )
@@ -55,6 +59,13 @@ QgsPostgresFeatureIterator::QgsPostgresFeatureIterator( QgsPostgresFeatureSource
     return;
   }
 
+  if ( mSource->mBinaryAttributes )
+  {
+    // date and timestamp binary formats depend on the server's compile time options
+    const char *integerDatetimes = ::PQparameterStatus( mConn->pgConnection(), "integer_datetimes" );
+    mIntegerDatetimes = integerDatetimes && qstrcmp( integerDatetimes, "on" ) == 0;
+  }
+
   if ( mRequest.destinationCrs().isValid() && mRequest.destinationCrs() != mSource->mCrs )
   {
     mTransform = QgsCoordinateTransform( mSource->mCrs, mRequest.destinationCrs(), mRequest.transformContext() );
@@ -255,57 +266,67 @@ bool QgsPostgresFeatureIterator::fetchFeature( QgsFeature &feature )
 
   if ( mFeatureQueue.empty() && !mLastFetch )
   {
-#if 0 //disabled dynamic queue size
-    QElapsedTimer timer;
-    timer.start();
-#endif
-
-    QString fetch = QStringLiteral( "FETCH FORWARD %1 FROM %2" ).arg( mFeatureQueueSize ).arg( mCursorName );
-    QgsDebugMsgLevel( QStringLiteral( "fetching %1 features." ).arg( mFeatureQueueSize ), 4 );
-
     lock();
-    if ( mConn->PQsendQuery( fetch ) == 0 ) // fetch features asynchronously
-    {
-      QgsMessageLog::logMessage( QObject::tr( "Fetching from cursor %1 failed\nDatabase error: %2" ).arg( mCursorName, mConn->PQerrorMessage() ), QObject::tr( "PostGIS" ) );
-    }
+
+    if ( !mFetchPending )
+      sendFetch();
 
     QgsPostgresResult queryResult;
-    for ( ;; )
+    const int fetchSize = mPendingFetchSize;
+    if ( mFetchPending )
     {
-      queryResult = mConn->PQgetResult();
-      if ( !queryResult.result() )
-        break;
-
-      if ( queryResult.PQresultStatus() != PGRES_TUPLES_OK )
+      for ( ;; )
       {
-        QgsMessageLog::logMessage( QObject::tr( "Fetching from cursor %1 failed\nDatabase error: %2" ).arg( mCursorName, mConn->PQerrorMessage() ), QObject::tr( "PostGIS" ) );
-        break;
-      }
+        PGresult *result = mConn->PQgetResult();
+        if ( !result )
+          break;
 
-      int rows = queryResult.PQntuples();
-      if ( rows == 0 )
-        continue;
+        const ExecStatusType status = ::PQresultStatus( result );
+        if ( status == PGRES_COMMAND_OK )
+        {
+          // result of the savepoint around the FETCH
+          ::PQclear( result );
+          continue;
+        }
 
-      mLastFetch = rows < mFeatureQueueSize;
+        if ( status != PGRES_TUPLES_OK )
+        {
+          QgsMessageLog::logMessage( QObject::tr( "Fetching from cursor %1 failed\nDatabase error: %2" ).arg( mCursorName, mConn->PQerrorMessage() ), QObject::tr( "PostGIS" ) );
+          ::PQclear( result );
+          continue;
+        }
 
-      for ( int row = 0; row < rows; row++ )
-      {
-        mFeatureQueue.enqueue( QgsFeature() );
-        getFeature( queryResult, row, mFeatureQueue.back() );
-      } // for each row in queue
+        queryResult = result;
+      }
+      mFetchPending = false;
     }
-    unlock();
 
-#if 0 //disabled dynamic queue size
-    if ( timer.elapsed() > 500 && mFeatureQueueSize > 1 )
+    // a FETCH which could not be sent or failed ends the iteration
+    const int rows = queryResult.result() ? queryResult.PQntuples() : 0;
+    mLastFetch = !queryResult.result() || rows < fetchSize;
+
+    if ( !mLastFetch )
     {
-      mFeatureQueueSize /= 2;
+      adaptFeatureQueueSize( queryResult );
+
+      // Request the next batch right away, so that the server and the network
+      // work on it while this batch is turned into features. Transaction
+      // connections are shared with other users and must not be left busy.
+      if ( !mIsTransactionConnection )
+        sendFetch();
     }
-    else if ( timer.elapsed() < 50 && mFeatureQueueSize < 10000 )
+
+    for ( int row = 0; row < rows; row++ )
     {
-      mFeatureQueueSize *= 2;
-    }
-#endif
+      mFeatureQueue.enqueue( QgsFeature() );
+      getFeature( queryResult, row, mFeatureQueue.back() );
+
+      // keep draining the socket, otherwise the server stalls once the buffers are full
+      if ( mFetchPending && row % 256 == 255 )
+        mConn->PQconsumeInput();
+    } // for each row in queue
+
+    unlock();
   }
 
   if ( mFeatureQueue.empty() )
@@ -386,6 +407,8 @@ bool QgsPostgresFeatureIterator::rewind()
   if ( mClosed )
     return false;
 
+  discardPendingFetch();
+
   // move cursor to first record
 
   mConn->PQexecNR( QStringLiteral( "move absolute 0 in %1" ).arg( mCursorName ) );
@@ -401,6 +424,8 @@ bool QgsPostgresFeatureIterator::close()
   if ( !mConn )
     return false;
 
+  discardPendingFetch();
+
   mConn->closeCursor( mCursorName );
 
   if ( !mIsTransactionConnection )
@@ -420,6 +445,81 @@ bool QgsPostgresFeatureIterator::close()
   return true;
 }
 
+bool QgsPostgresFeatureIterator::sendFetch()
+{
+  QString fetch = QStringLiteral( "FETCH FORWARD %1 FROM %2" ).arg( mFeatureQueueSize ).arg( mCursorName );
+  if ( !mIsTransactionConnection )
+    fetch = QStringLiteral( "SAVEPOINT %1_fetch;%2;RELEASE SAVEPOINT %1_fetch" ).arg( mCursorName, fetch );
+  QgsDebugMsgLevel( QStringLiteral( "fetching %1 features." ).arg( mFeatureQueueSize ), 4 );
+
+  if ( mConn->PQsendQuery( fetch ) == 0 ) // fetch features asynchronously
+  {
+    QgsMessageLog::logMessage( QObject::tr( "Fetching from cursor %1 failed\nDatabase error: %2" ).arg( mCursorName, mConn->PQerrorMessage() ), QObject::tr( "PostGIS" ) );
+    mFetchPending = false;
+    return false;
+  }
+
+  mFetchPending = true;
+  mPendingFetchSize = mFeatureQueueSize;
+  return true;
+}
+
+void QgsPostgresFeatureIterator::discardPendingFetch()
+{
+  if ( !mFetchPending )
+    return;
+
+  lock();
+
+  // don't wait for a whole batch which is not needed anymore
+  mConn->cancel();
+
+  bool canceled = false;
+  while ( PGresult *result = mConn->PQgetResult() )
+  {
+    const ExecStatusType status = ::PQresultStatus( result );
+    if ( status != PGRES_TUPLES_OK && status != PGRES_COMMAND_OK )
+      canceled = true;
+    ::PQclear( result );
+  }
+
+  // the canceled FETCH aborted the transaction, return to the savepoint before it so that the cursor stays usable
+  if ( canceled && !mIsTransactionConnection )
+    mConn->PQexecNR( QStringLiteral( "ROLLBACK TO SAVEPOINT %1_fetch;RELEASE SAVEPOINT %1_fetch" ).arg( mCursorName ) );
+
+  unlock();
+
+  mFetchPending = false;
+}
+
+void QgsPostgresFeatureIterator::adaptFeatureQueueSize( QgsPostgresResult &queryResult )
+{
+  // Aim for batches of a few megabytes: narrow rows need fewer round trips,
+  // while wide rows (e.g. detailed polygons) must not hold two huge batches
+  // in memory at once.
+  const qint64 targetBatchBytes = 4 * 1024 * 1024;
+  const int minQueueSize = 100;
+  const int maxQueueSize = 10000;
+
+  const int rows = queryResult.PQntuples();
+  const int cols = queryResult.PQnfields();
+  if ( rows == 0 || cols == 0 )
+    return;
+
+  // sample up to 64 rows evenly spread over the batch
+  const int step = std::max( 1, rows / 64 );
+  qint64 bytes = 0;
+  int sampled = 0;
+  for ( int row = 0; row < rows; row += step, ++sampled )
+  {
+    for ( int col = 0; col < cols; ++col )
+      bytes += ::PQgetlength( queryResult.result(), row, col );
+  }
+
+  const qint64 rowBytes = std::max< qint64 >( 1, bytes / sampled );
+  mFeatureQueueSize = static_cast< int >( qBound< qint64 >( minQueueSize, targetBatchBytes / rowBytes, maxQueueSize ) );
+}
+
 ///////////////
 
 QString QgsPostgresFeatureIterator::whereClauseRect()
@@ -629,6 +729,10 @@ bool QgsPostgresFeatureIterator::declareCursor( const QString &whereClause, long
       return false;
   }
 
+  mBinaryTypes.clear();
+  if ( mSource->mBinaryAttributes )
+    mBinaryTypes.fill( BinaryNone, mSource->mFields.count() );
+
   bool subsetOfAttributes = mRequest.flags() & QgsFeatureRequest::SubsetOfAttributes;
   const auto constAllAttributesList = subsetOfAttributes ? mRequest.subsetOfAttributes() : mSource->mFields.allAttributesList();
   for ( int idx : constAllAttributesList )
@@ -636,7 +740,18 @@ bool QgsPostgresFeatureIterator::declareCursor( const QString &whereClause, long
     if ( mSource->mPrimaryKeyAttrs.contains( idx ) )
       continue;
 
-    query += delim + mConn->fieldExpression( mSource->mFields.at( idx ) );
+    const QgsField fld = mSource->mFields.at( idx );
+    const BinaryType type = mSource->mBinaryAttributes ? binaryType( fld ) : BinaryNone;
+    if ( type != BinaryNone )
+    {
+      // the cursor is binary, so selecting the plain column avoids the text conversion on both ends
+      mBinaryTypes[idx] = type;
+      query += delim + QgsPostgresConn::quotedIdentifier( fld.name() );
+    }
+    else
+    {
+      query += delim + mConn->fieldExpression( fld );
+    }
   }
 
   query += " FROM " + mSource->mQuery;
@@ -814,6 +929,19 @@ void QgsPostgresFeatureIterator::getFeatureAttribute( int idx, QgsPostgresResult
 
   QVariant v;
 
+  const BinaryType type = mBinaryTypes.isEmpty() ? BinaryNone : mBinaryTypes.at( idx );
+  if ( type != BinaryNone )
+  {
+    if ( ::PQgetisnull( queryResult.result(), row, col ) )
+      v = QVariant( fld.type() );
+    else
+      v = binaryValue( type, fld, queryResult, row, col );
+
+    feature.setAttribute( idx, v );
+    col++;
+    return;
+  }
+
   switch ( fld.type() )
   {
     case QVariant::ByteArray:
@@ -851,6 +979,183 @@ void QgsPostgresFeatureIterator::getFeatureAttribute( int idx, QgsPostgresResult
   col++;
 }
 
+QgsPostgresFeatureIterator::BinaryType QgsPostgresFeatureIterator::binaryType( const QgsField &field ) const
+{
+  const QString &typeName = field.typeName();
+
+  switch ( field.type() )
+  {
+    case QVariant::Int:
+    case QVariant::LongLong:
+      if ( typeName == QLatin1String( "int2" ) || typeName == QLatin1String( "int4" ) || typeName == QLatin1String( "int8" ) )
+        return BinaryInt;
+      break;
+
+    case QVariant::Double:
+      // float4 stays on the text path, as its shortest decimal representation
+      // differs from the exact value of the widened binary float
+      if ( typeName == QLatin1String( "float8" ) )
+        return BinaryFloat8;
+      else if ( typeName == QLatin1String( "numeric" ) )
+        return BinaryNumeric;
+      break;
+
+    case QVariant::Bool:
+      if ( typeName == QLatin1String( "bool" ) )
+        return BinaryBool;
+      break;
+
+    case QVariant::Date:
+      if ( mIntegerDatetimes && typeName == QLatin1String( "date" ) )
+        return BinaryDate;
+      break;
+
+    case QVariant::DateTime:
+      if ( mIntegerDatetimes && typeName == QLatin1String( "timestamp" ) )
+        return BinaryTimestamp;
+      break;
+
+    case QVariant::ByteArray:
+      if ( typeName == QLatin1String( "bytea" ) )
+        return BinaryBytea;
+      break;
+
+    default:
+      break;
+  }
+
+  return BinaryNone;
+}
+
+QVariant QgsPostgresFeatureIterator::binaryValue( BinaryType type, const QgsField &field, QgsPostgresResult &queryResult, int row, int col ) const
+{
+  const uchar *p = reinterpret_cast< const uchar * >( ::PQgetvalue( queryResult.result(), row, col ) );
+  const int length = ::PQgetlength( queryResult.result(), row, col );
+
+  switch ( type )
+  {
+    case BinaryInt:
+    {
+      qint64 value;
+      switch ( length )
+      {
+        case 2:
+          value = qFromBigEndian<qint16>( p );
+          break;
+        case 4:
+          value = qFromBigEndian<qint32>( p );
+          break;
+        case 8:
+          value = qFromBigEndian<qint64>( p );
+          break;
+        default:
+          return QVariant( field.type() );
+      }
+      return field.type() == QVariant::Int ? QVariant( static_cast< int >( value ) ) : QVariant( value );
+    }
+
+    case BinaryFloat8:
+    {
+      if ( length != 8 )
+        return QVariant( field.type() );
+
+      const quint64 bits = qFromBigEndian<quint64>( p );
+      double value;
+      memcpy( &value, &bits, sizeof( value ) );
+      return value;
+    }
+
+    case BinaryBool:
+      return length == 1 ? QVariant( *p != 0 ) : QVariant( field.type() );
+
+    case BinaryNumeric:
+    {
+      // ndigits, weight, sign and dscale header, followed by ndigits base 10000 digits
+      if ( length < 8 )
+        return QVariant( field.type() );
+
+      const int ndigits = qFromBigEndian<qint16>( p );
+      const int weight = qFromBigEndian<qint16>( p + 2 );
+      const quint16 sign = qFromBigEndian<quint16>( p + 4 );
+      if ( length < 8 + 2 * ndigits )
+        return QVariant( field.type() );
+
+      // special values, infinity is supported since PostgreSQL 14
+      if ( sign == 0xC000 )
+        return std::numeric_limits<double>::quiet_NaN();
+      else if ( sign == 0xD000 )
+        return std::numeric_limits<double>::infinity();
+      else if ( sign == 0xF000 )
+        return -std::numeric_limits<double>::infinity();
+
+      // accumulate the digits as an integer. As long as it and the power of ten
+      // are exact doubles the single multiplication or division rounds correctly,
+      // otherwise the digits are converted like the text representation
+      double value = 0;
+      for ( int i = 0; i < ndigits; ++i )
+        value = value * 10000 + qFromBigEndian<qint16>( p + 8 + 2 * i );
+
+      const int exponent = 4 * ( weight - ndigits + 1 );
+      if ( value <= 9007199254740992.0 && std::abs( exponent ) <= 22 )
+      {
+        if ( exponent > 0 )
+          value *= std::pow( 10.0, exponent );
+        else if ( exponent < 0 )
+          value /= std::pow( 10.0, -exponent );
+      }
+      else
+      {
+        QByteArray digits;
+        digits.reserve( 4 * ndigits + 8 );
+        for ( int i = 0; i < ndigits; ++i )
+          digits += QByteArray::number( qFromBigEndian<qint16>( p + 8 + 2 * i ) ).rightJustified( 4, '0' );
+        digits += 'e' + QByteArray::number( exponent );
+        value = digits.toDouble();
+      }
+
+      return sign == 0x4000 ? -value : value;
+    }
+
+    case BinaryDate:
+    {
+      if ( length != 4 )
+        return QVariant( field.type() );
+
+      // days since 2000-01-01, with the extreme values reserved for +/-infinity
+      const qint32 days = qFromBigEndian<qint32>( p );
+      if ( days == std::numeric_limits<qint32>::max() || days == std::numeric_limits<qint32>::min() )
+        return QVariant( field.type() );
+
+      return QDate( 2000, 1, 1 ).addDays( days );
+    }
+
+    case BinaryTimestamp:
+    {
+      if ( length != 8 )
+        return QVariant( field.type() );
+
+      // microseconds since 2000-01-01 00:00:00, with the extreme values reserved for +/-infinity
+      const qint64 usecs = qFromBigEndian<qint64>( p );
+      if ( usecs == std::numeric_limits<qint64>::max() || usecs == std::numeric_limits<qint64>::min() )
+        return QVariant( field.type() );
+
+      // timestamp without time zone is a wall clock value, so compute it in UTC
+      // and reinterpret the result as local time like the text conversion does
+      const qint64 msecs = usecs >= 0 ? usecs / 1000 : -( ( -usecs + 999 ) / 1000 );
+      const QDateTime utc = QDateTime( QDate( 2000, 1, 1 ), QTime( 0, 0 ), Qt::UTC ).addMSecs( msecs );
+      return QDateTime( utc.date(), utc.time() );
+    }
+
+    case BinaryBytea:
+      return length == 0 ? QVariant( QVariant::ByteArray ) : QVariant( QByteArray( reinterpret_cast< const char * >( p ), length ) );
+
+    case BinaryNone:
+      break;
+  }
+
+  return QgsPostgresProvider::convertValue( field.type(), field.subType(), queryResult.PQgetvalue( row, col ), field.typeName() );
+}
+
 
 //  ------------------
 
@@ -868,6 +1173,7 @@ QgsPostgresFeatureSource::QgsPostgresFeatureSource( const QgsPostgresProvider *p
   , mPrimaryKeyAttrs( p->mPrimaryKeyAttrs )
   , mQuery( p->mQuery )
   , mCrs( p->crs() )
+  , mBinaryAttributes( p->mBinaryAttributes )
   , mShared( p->mShared )
 {
   if ( mSqlWhereClause.startsWith( QLatin1String( " WHERE " ) ) )
@@ -52,6 +52,9 @@ class QgsPostgresFeatureSource : public QgsAbstractFeatureSource
     // TODO: loadFields()
     QgsCoordinateReferenceSystem mCrs;
 
+    //! Fetch supported attribute types in their native binary representation
+    bool mBinaryAttributes = false;
+
     std::shared_ptr<QgsPostgresSharedData> mShared;
 
     /* The transaction connection (if any) gets refed/unrefed when creating/
@@ -85,6 +88,19 @@ class QgsPostgresFeatureIterator : public QgsAbstractFeatureIteratorFromSource<Q
 
   private:
 
+    //! Attribute types which can be decoded from the binary cursor without a text round-trip
+    enum BinaryType
+    {
+      BinaryNone, //!< Fetched as text and converted with QgsPostgresProvider::convertValue()
+      BinaryInt, //!< int2, int4 or int8
+      BinaryFloat8,
+      BinaryBool,
+      BinaryNumeric,
+      BinaryDate,
+      BinaryTimestamp,
+      BinaryBytea,
+    };
+
     QgsPostgresConn *mConn = nullptr;
 
 
@@ -93,6 +109,27 @@ class QgsPostgresFeatureIterator : public QgsAbstractFeatureIteratorFromSource<Q
     void getFeatureAttribute( int idx, QgsPostgresResult &queryResult, int row, int &col, QgsFeature &feature );
     bool declareCursor( const QString &whereClause, long limit = -1, bool closeOnFail = true, const QString &orderBy = QString() );
 
+    /**
+     * Sends a FETCH for the next batch without waiting for its result.
+     * Returns FALSE if the query could not be sent.
+     *
+     * Unless the connection is a shared transaction connection, the FETCH is wrapped in a
+     * savepoint, so that it can be canceled without aborting the transaction of the cursor.
+     */
+    bool sendFetch();
+
+    //! Cancels a pending FETCH and discards its result
+    void discardPendingFetch();
+
+    //! Adapts the batch size to the average row width of \a queryResult
+    void adaptFeatureQueueSize( QgsPostgresResult &queryResult );
+
+    //! Returns the binary decoder to use for \a field, or BinaryNone if it must be fetched as text
+    BinaryType binaryType( const QgsField &field ) const;
+
+    //! Decodes a non-null binary cursor value of type \a type
+    QVariant binaryValue( BinaryType type, const QgsField &field, QgsPostgresResult &queryResult, int row, int col ) const;
+
     QString mCursorName;
 
     /**
@@ -104,6 +141,12 @@ class QgsPostgresFeatureIterator : public QgsAbstractFeatureIteratorFromSource<Q
     //! Maximal size of the feature queue
     int mFeatureQueueSize = 2000;
 
+    //! TRUE if a FETCH has been sent and its result was not retrieved yet
+    bool mFetchPending = false;
+
+    //! Number of rows requested by the pending FETCH
+    int mPendingFetchSize = 0;
+
     //! Number of retrieved features
     int mFetched = 0;
 
@@ -112,6 +155,12 @@ class QgsPostgresFeatureIterator : public QgsAbstractFeatureIteratorFromSource<Q
 
     bool mIsTransactionConnection = false;
 
+    //! Binary decoder per field index, empty if binary attribute fetching is disabled
+    QVector<BinaryType> mBinaryTypes;
+
+    //! TRUE if the server sends date/time values as 64 bit integers
+    bool mIntegerDatetimes = false;
+
     bool providerCanSimplify( QgsSimplifyMethod::MethodType methodType ) const override;
 
     bool prepareOrderBy( const QList<QgsFeatureRequest::OrderByClause> &orderBys ) override;
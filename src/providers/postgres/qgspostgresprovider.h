@@ -413,6 +413,9 @@ class QgsPostgresProvider : public QgsVectorDataProvider
 
     bool mSelectAtIdDisabled = false; //!< Disable support for SelectAtId
 
+    //! Fetch numeric, boolean, date/time and bytea attributes in binary form instead of converting them from text
+    bool mBinaryAttributes = false;
+
     struct PGFieldNotFound {}; //! Exception to throw
 
     struct PGException
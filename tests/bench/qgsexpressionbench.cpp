@@ -0,0 +1,172 @@
+/***************************************************************************
+                 qgsexpressionbench.cpp  - Expression benchmark
+                             -------------------
+    begin                : October 2019
+    copyright            : (C) 2019 by the QGIS project
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+/*
+ * Evaluates typical filter and label expressions over a reproducible set of
+ * generated features and reports the evaluation time.
+ *
+ * Every expression is evaluated feature by feature with evaluate(), like
+ * most consumers do, again after compile(), and in blocks of features with
+ * evaluateBatch(). The number of TRUE results (filters) or the total length
+ * of the results (labels) is printed for all of them, so that diverging
+ * results show up.
+ */
+
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+
+#include <iostream>
+#include <random>
+
+#include "qgsapplication.h"
+#include "qgsexpression.h"
+#include "qgsexpressioncontext.h"
+#include "qgsfeature.h"
+#include "qgsfields.h"
+
+//! Number of features evaluated by a single evaluateBatch() call
+static const int BLOCK_SIZE = 1000;
+
+//! Creates \a count features with a name, a population, an area and a class attribute
+static QgsFeatureList createFeatures( const QgsFields &fields, int count, unsigned int seed )
+{
+  const QStringList classes { QStringLiteral( "city" ), QStringLiteral( "town" ), QStringLiteral( "village" ), QStringLiteral( "hamlet" ) };
+
+  // the output of std::mt19937 is fully specified, unlike the standard distributions
+  std::mt19937 generator( seed );
+  QgsFeatureList features;
+  features.reserve( count );
+  for ( int i = 0; i < count; ++i )
+  {
+    QgsFeature feature( fields, i );
+    QString name;
+    const int nameLength = 3 + static_cast< int >( generator() % 10 );
+    for ( int j = 0; j < nameLength; ++j )
+      name += QChar( 'A' + static_cast< int >( generator() % 26 ) );
+    // a few NULL values, as in real data
+    const QVariant population = generator() % 50 == 0 ? QVariant( QVariant::Int ) : QVariant( static_cast< int >( generator() % 100000 ) );
+    const double area = generator() / 4294967296.0 * 10000;
+    feature.setAttributes( QgsAttributes() << name << population << area << classes.at( generator() % classes.size() ) );
+    features << feature;
+  }
+  return features;
+}
+
+//! Summarizes a result, the number of TRUE values for filters and the length of the text for labels
+static qlonglong summarize( const QVariant &value, bool filter )
+{
+  if ( filter )
+    return value.toBool() ? 1 : 0;
+  return value.toString().length();
+}
+
+//! Evaluates \a expression for all \a features, one by one and in blocks, and prints the times
+static void evaluate( const QString &expression, bool filter, const QgsFields &fields, const QgsFeatureList &features )
+{
+  QgsExpressionContext context;
+  context.setFields( fields );
+
+  QgsExpression perFeature( expression );
+  perFeature.prepare( &context );
+  QElapsedTimer timer;
+  timer.start();
+  qlonglong perFeatureSummary = 0;
+  for ( const QgsFeature &feature : features )
+  {
+    context.setFeature( feature );
+    perFeatureSummary += summarize( perFeature.evaluate( &context ), filter );
+  }
+  const qint64 perFeatureElapsed = timer.elapsed();
+
+  QgsExpression compiled( expression );
+  compiled.prepare( &context );
+  compiled.compile( &context );
+  timer.restart();
+  qlonglong compiledSummary = 0;
+  for ( const QgsFeature &feature : features )
+  {
+    context.setFeature( feature );
+    compiledSummary += summarize( compiled.evaluate( &context ), filter );
+  }
+  const qint64 compiledElapsed = timer.elapsed();
+
+  QgsExpression batch( expression );
+  batch.prepare( &context );
+  timer.restart();
+  qlonglong batchSummary = 0;
+  for ( int start = 0; start < features.size(); start += BLOCK_SIZE )
+  {
+    const QVariantList results = batch.evaluateBatch( features.mid( start, BLOCK_SIZE ), &context );
+    for ( const QVariant &result : results )
+      batchSummary += summarize( result, filter );
+  }
+  const qint64 batchElapsed = timer.elapsed();
+
+  std::cout << expression.toLocal8Bit().constData() << std::endl
+            << "\tevaluate\ttime " << perFeatureElapsed << " ms\tresult " << perFeatureSummary << std::endl
+            << "\tcompiled\ttime " << compiledElapsed << " ms\tresult " << compiledSummary << ( compiled.isCompiled() ? "" : "\t(not compiled)" ) << std::endl
+            << "\tevaluateBatch\ttime " << batchElapsed << " ms\tresult " << batchSummary << std::endl;
+}
+
+int main( int argc, char *argv[] )
+{
+  QgsApplication app( argc, argv, false );
+  QCoreApplication::setApplicationName( QStringLiteral( "qgis_expression_bench" ) );
+
+  QCommandLineParser parser;
+  parser.setApplicationDescription( QStringLiteral( "QGIS expression benchmark" ) );
+  parser.addHelpOption();
+  QCommandLineOption featuresOption( QStringLiteral( "features" ), QStringLiteral( "Number of features, default 1000000" ), QStringLiteral( "count" ), QStringLiteral( "1000000" ) );
+  QCommandLineOption seedOption( QStringLiteral( "seed" ), QStringLiteral( "Seed of the random attributes, default 2019" ), QStringLiteral( "seed" ), QStringLiteral( "2019" ) );
+  parser.addOption( featuresOption );
+  parser.addOption( seedOption );
+  parser.process( app );
+
+  QgsApplication::init();
+  QgsApplication::initQgis();
+
+  QgsFields fields;
+  fields.append( QgsField( QStringLiteral( "name" ), QVariant::String ) );
+  fields.append( QgsField( QStringLiteral( "population" ), QVariant::Int ) );
+  fields.append( QgsField( QStringLiteral( "area" ), QVariant::Double ) );
+  fields.append( QgsField( QStringLiteral( "class" ), QVariant::String ) );
+  const QgsFeatureList features = createFeatures( fields, parser.value( featuresOption ).toInt(), parser.value( seedOption ).toUInt() );
+
+  // filter expressions, as used by feature requests and rule based renderers
+  const QStringList filters
+  {
+    QStringLiteral( "\"population\" > 50000" ),
+    QStringLiteral( "\"area\" / 1000 >= 5" ),
+    QStringLiteral( "\"population\" > 90000 AND \"name\" LIKE 'A%'" ),
+    QStringLiteral( "\"class\" = 'city' OR \"name\" ~ '^[A-F]+$'" ),
+    QStringLiteral( "\"class\" IN ('town', 'village') AND \"population\" IS NOT NULL" ),
+  };
+  // label expressions
+  const QStringList labels
+  {
+    QStringLiteral( "\"name\" || ' (' || to_string(\"population\") || ')'" ),
+    QStringLiteral( "CASE WHEN \"population\" > 50000 THEN upper(\"name\") ELSE title(\"name\") END" ),
+    QStringLiteral( "format_number(\"area\", 2)" ),
+  };
+
+  for ( const QString &filter : filters )
+    evaluate( filter, true, fields, features );
+  for ( const QString &label : labels )
+    evaluate( label, false, fields, features );
+
+  QgsApplication::exitQgis();
+  return 0;
+}
@@ -0,0 +1,162 @@
+/***************************************************************************
+                 qgslabelingbench.cpp  - Labeling benchmark
+                             -------------------
+    begin                : October 2019
+    copyright            : (C) 2019 by the QGIS project
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+/*
+ * Renders a reproducible, dense set of point labels and reports the time
+ * needed to place them together with the number of placed labels, which is
+ * a measure for the quality of the solution.
+ *
+ * Every search method is run three times: with an empty component solution
+ * cache, for the same extent again, and after panning the map by a tenth of
+ * its width.
+ */
+
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QImage>
+#include <QPainter>
+
+#include <iostream>
+#include <memory>
+#include <random>
+
+#include "qgsapplication.h"
+#include "qgsfeature.h"
+#include "qgsfontutils.h"
+#include "qgsgeometry.h"
+#include "qgslabelingengine.h"
+#include "qgslabelingenginesettings.h"
+#include "qgsmaprenderersequentialjob.h"
+#include "qgsmapsettings.h"
+#include "qgsnullsymbolrenderer.h"
+#include "qgspallabeling.h"
+#include "qgsvectorlayer.h"
+#include "qgsvectorlayerlabeling.h"
+
+//! Creates a memory layer with \a count randomly placed points in a 1000 x 1000 square
+static std::unique_ptr< QgsVectorLayer > createPointLayer( int count, unsigned int seed )
+{
+  std::unique_ptr< QgsVectorLayer > layer = qgis::make_unique< QgsVectorLayer >( QStringLiteral( "Point?crs=EPSG:3857&field=name:string" ), QStringLiteral( "points" ), QStringLiteral( "memory" ) );
+
+  // the output of std::mt19937 is fully specified, unlike the standard distributions
+  std::mt19937 generator( seed );
+  QgsFeatureList features;
+  features.reserve( count );
+  for ( int i = 0; i < count; ++i )
+  {
+    const double x = generator() / 4294967296.0 * 1000;
+    const double y = generator() / 4294967296.0 * 1000;
+    QgsFeature feature( layer->fields() );
+    feature.setGeometry( QgsGeometry::fromPointXY( QgsPointXY( x, y ) ) );
+    feature.setAttribute( 0, QStringLiteral( "label %1" ).arg( QString( static_cast< int >( generator() % 8 ) + 1, QChar( 'x' ) ) ) );
+    features << feature;
+  }
+  layer->dataProvider()->addFeatures( features );
+
+  QgsTextFormat format;
+  format.setFont( QgsFontUtils::getStandardTestFont( QStringLiteral( "Bold" ) ) );
+  format.setSize( 10 );
+
+  QgsPalLayerSettings settings;
+  settings.fieldName = QStringLiteral( "name" );
+  settings.placement = QgsPalLayerSettings::AroundPoint;
+  settings.setFormat( format );
+  layer->setLabeling( new QgsVectorLayerSimpleLabeling( settings ) );
+  layer->setLabelsEnabled( true );
+
+  // only the labels are rendered
+  layer->setRenderer( new QgsNullSymbolRenderer() );
+  return layer;
+}
+
+//! Renders the map and prints the rendering time and the number of placed labels
+static void renderLabels( const QString &name, const QgsMapSettings &settings, int labelCount )
+{
+  QgsMapRendererSequentialJob job( settings );
+  QElapsedTimer timer;
+  timer.start();
+  job.start();
+  job.waitForFinished();
+  const qint64 elapsed = timer.elapsed();
+
+  std::unique_ptr< QgsLabelingResults > results( job.takeLabelingResults() );
+  const int placed = results ? results->labelsWithinRect( settings.visibleExtent() ).size() : 0;
+
+  std::cout << name.toLocal8Bit().constData()
+            << "\ttime " << elapsed << " ms"
+            << "\tplaced " << placed << " / " << labelCount << std::endl;
+}
+
+int main( int argc, char *argv[] )
+{
+  QgsApplication app( argc, argv, false );
+  QCoreApplication::setApplicationName( QStringLiteral( "qgis_labeling_bench" ) );
+
+  QCommandLineParser parser;
+  parser.setApplicationDescription( QStringLiteral( "QGIS labeling benchmark" ) );
+  parser.addHelpOption();
+  QCommandLineOption featuresOption( QStringLiteral( "features" ), QStringLiteral( "Number of labeled points, default 20000" ), QStringLiteral( "count" ), QStringLiteral( "20000" ) );
+  QCommandLineOption seedOption( QStringLiteral( "seed" ), QStringLiteral( "Seed of the random points, default 2019" ), QStringLiteral( "seed" ), QStringLiteral( "2019" ) );
+  QCommandLineOption sizeOption( QStringLiteral( "size" ), QStringLiteral( "Width and height of the map in pixels, default 2000" ), QStringLiteral( "pixels" ), QStringLiteral( "2000" ) );
+  parser.addOption( featuresOption );
+  parser.addOption( seedOption );
+  parser.addOption( sizeOption );
+  parser.process( app );
+
+  QgsApplication::init();
+  QgsApplication::initQgis();
+  QgsFontUtils::loadStandardTestFonts( QStringList() << QStringLiteral( "Bold" ) );
+
+  const int labelCount = parser.value( featuresOption ).toInt();
+  const int size = parser.value( sizeOption ).toInt();
+  std::unique_ptr< QgsVectorLayer > layer = createPointLayer( labelCount, parser.value( seedOption ).toUInt() );
+
+  QgsMapSettings settings;
+  settings.setLayers( QList< QgsMapLayer * >() << layer.get() );
+  settings.setDestinationCrs( layer->crs() );
+  settings.setOutputSize( QSize( size, size ) );
+  settings.setOutputDpi( 96 );
+  settings.setExtent( QgsRectangle( 0, 0, 1000, 1000 ) );
+
+  const QList< QPair< QString, QgsLabelingEngineSettings::Search > > methods
+  {
+    qMakePair( QStringLiteral( "chain" ), QgsLabelingEngineSettings::Chain ),
+    qMakePair( QStringLiteral( "popmusic_chain" ), QgsLabelingEngineSettings::Popmusic_Chain ),
+    qMakePair( QStringLiteral( "popmusic_tabu" ), QgsLabelingEngineSettings::Popmusic_Tabu ),
+    qMakePair( QStringLiteral( "falp" ), QgsLabelingEngineSettings::Falp )
+  };
+
+  for ( const QPair< QString, QgsLabelingEngineSettings::Search > &method : methods )
+  {
+    QgsLabelingEngineSettings engineSettings = settings.labelingEngineSettings();
+    engineSettings.setSearchMethod( method.second );
+    engineSettings.setFlag( QgsLabelingEngineSettings::SplitConflictComponents, true );
+    engineSettings.setFlag( QgsLabelingEngineSettings::ReuseComponentSolutions, true );
+    settings.setLabelingEngineSettings( engineSettings );
+    settings.setExtent( QgsRectangle( 0, 0, 1000, 1000 ) );
+
+    QgsLabelingEngine::clearComponentSolutionCache();
+    renderLabels( method.first + QStringLiteral( " cold" ), settings, labelCount );
+    renderLabels( method.first + QStringLiteral( " same extent" ), settings, labelCount );
+
+    settings.setExtent( QgsRectangle( 100, 0, 1100, 1000 ) );
+    renderLabels( method.first + QStringLiteral( " panned" ), settings, labelCount );
+  }
+
+  layer.reset();
+  QgsApplication::exitQgis();
+  return 0;
+}
@@ -18,6 +18,7 @@
 #include "qgsalignraster.h"
 #include "qgsapplication.h"
 #include "qgscoordinatereferencesystem.h"
+#include "qgsfeedback.h"
 #include "qgsrectangle.h"
 
 #include <QDir>
@@ -46,6 +47,12 @@ class TestAlignRaster : public QObject
       SRC_FILE = QStringLiteral( TEST_DATA_DIR ) + "/float1-16.tif";
 
       QgsApplication::init(); // needed for CRS database
+      QgsApplication::initQgis(); // the stacked GeoTIFF is written through the GDAL provider
+    }
+
+    void cleanupTestCase()
+    {
+      QgsApplication::exitQgis();
     }
 
     void testRasterInfo()
@@ -252,6 +259,96 @@ class TestAlignRaster : public QObject
       QVERIFY( !res );
     }
 
+    void testMultipleRasters()
+    {
+      QString tmpFile1( _tempFile( QStringLiteral( "multiple-1" ) ) );
+      QString tmpFile2( _tempFile( QStringLiteral( "multiple-2" ) ) );
+      QString vrtFile( QStringLiteral( "%1/aligntest-stacked.vrt" ).arg( QDir::tempPath() ) );
+
+      QgsFeedback feedback1;
+      QgsFeedback feedback2;
+
+      QgsAlignRaster align;
+      QgsAlignRaster::List rasters;
+      rasters << QgsAlignRaster::Item( SRC_FILE, tmpFile1 );
+      rasters << QgsAlignRaster::Item( SRC_FILE, tmpFile2 );
+      rasters[0].feedback = &feedback1;
+      rasters[1].resampleMethod = QgsAlignRaster::RA_Bilinear;
+      rasters[1].feedback = &feedback2;
+      align.setRasters( rasters );
+      align.setParametersFromRaster( SRC_FILE );
+      align.setStackedOutputFilename( vrtFile );
+      bool res = align.run();
+      QVERIFY( res );
+      QCOMPARE( feedback1.progress(), 100.0 );
+      QCOMPARE( feedback2.progress(), 100.0 );
+
+      QgsAlignRaster::RasterInfo out1( tmpFile1 );
+      QVERIFY( out1.isValid() );
+      QgsAlignRaster::RasterInfo out2( tmpFile2 );
+      QVERIFY( out2.isValid() );
+      QCOMPARE( out1.rasterSize(), out2.rasterSize() );
+
+      // the virtual raster stacks the bands of both aligned rasters
+      QgsAlignRaster::RasterInfo stacked( vrtFile );
+      QVERIFY( stacked.isValid() );
+      QCOMPARE( stacked.bandCount(), 2 );
+      QCOMPARE( stacked.rasterSize(), out1.rasterSize() );
+      QCOMPARE( stacked.identify( 106.3, -6.9 ), out1.identify( 106.3, -6.9 ) );
+    }
+
+    void testStackedGeoTiff()
+    {
+      QString tmpFile( _tempFile( QStringLiteral( "stacked" ) ) );
+
+      // rasters without output filename are only aligned to temporary files
+      QgsAlignRaster align;
+      QgsAlignRaster::List rasters;
+      rasters << QgsAlignRaster::Item( SRC_FILE, QString() );
+      rasters << QgsAlignRaster::Item( SRC_FILE, QString() );
+      rasters << QgsAlignRaster::Item( SRC_FILE, QString() );
+      align.setRasters( rasters );
+      align.setParametersFromRaster( SRC_FILE );
+      align.setStackedOutputFilename( tmpFile );
+      bool res = align.run();
+      QVERIFY( res );
+
+      QgsAlignRaster::RasterInfo out( tmpFile );
+      QVERIFY( out.isValid() );
+      QCOMPARE( out.bandCount(), 3 );
+      QgsAlignRaster::RasterInfo src( SRC_FILE );
+      QCOMPARE( out.rasterSize(), src.rasterSize() );
+      QCOMPARE( out.identify( 106.3, -6.9 ), src.identify( 106.3, -6.9 ) );
+
+      // the cloud optimized output is tiled
+      GDALDatasetH hDS = GDALOpen( tmpFile.toLocal8Bit().constData(), GA_ReadOnly );
+      QVERIFY( hDS );
+      int blockXSize = 0;
+      int blockYSize = 0;
+      GDALGetBlockSize( GDALGetRasterBand( hDS, 1 ), &blockXSize, &blockYSize );
+      GDALClose( hDS );
+      QCOMPARE( blockXSize, 512 );
+      QCOMPARE( blockYSize, 512 );
+    }
+
+    void testCanceled()
+    {
+      QString tmpFile( _tempFile( QStringLiteral( "canceled" ) ) );
+
+      QgsFeedback feedback;
+      feedback.cancel();
+
+      QgsAlignRaster align;
+      QgsAlignRaster::List rasters;
+      rasters << QgsAlignRaster::Item( SRC_FILE, tmpFile );
+      rasters[0].feedback = &feedback;
+      align.setRasters( rasters );
+      align.setParametersFromRaster( SRC_FILE );
+      bool res = align.run();
+      QVERIFY( !res );
+      QVERIFY( !align.errorMessage().isEmpty() );
+    }
+
     void testSuggestedReferenceLayer()
     {
       QgsAlignRaster align;
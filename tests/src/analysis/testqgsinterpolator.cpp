@@ -16,6 +16,20 @@ Email                : nyall dot dawson at gmail dot com
 
 #include "qgsapplication.h"
 #include "DualEdgeTriangulation.h"
+#include "qgsidwinterpolator.h"
+#include "qgstininterpolator.h"
+#include "qgsgridfilewriter.h"
+#include "qgsvectorlayer.h"
+#include "qgsvectordataprovider.h"
+#include "qgsrasterlayer.h"
+#include "qgsrasterdataprovider.h"
+
+#include <QTemporaryDir>
+
+#include <algorithm>
+#include <memory>
+#include <numeric>
+#include <random>
 
 class TestQgsInterpolator : public QObject
 {
@@ -29,8 +43,16 @@ class TestQgsInterpolator : public QObject
     void init() ;// will be called before each testfunction is executed.
     void cleanup() ;// will be called after every testfunction.
     void dualEdge();
+    void triangleVertexIndexes();
+    void idwNearestPoints();
+    void idwSearchRadius();
+    void tinLinearRows();
+    void gridFileWriter();
 
   private:
+
+    //! Returns a memory layer with \a count random points, with the value stored in the first attribute
+    std::unique_ptr< QgsVectorLayer > randomPoints( int count ) const;
 };
 
 void  TestQgsInterpolator::initTestCase()
@@ -265,5 +287,258 @@ void TestQgsInterpolator::dualEdge()
 //  QVERIFY( tri.getSurroundingTriangles( 0 ).empty() );
 }
 
+void TestQgsInterpolator::triangleVertexIndexes()
+{
+  DualEdgeTriangulation tri;
+  QVERIFY( tri.getTriangleVertexIndexes().isEmpty() );
+
+  tri.addPoint( QgsPoint( 1, 2, 3 ) );
+  tri.addPoint( QgsPoint( 3, 0, 4 ) );
+  tri.addPoint( QgsPoint( 4, 4, 5 ) );
+  QVector< int > indexes = tri.getTriangleVertexIndexes();
+  QCOMPARE( indexes.size(), 3 );
+  std::sort( indexes.begin(), indexes.end() );
+  QCOMPARE( indexes, QVector< int >() << 0 << 1 << 2 );
+
+  tri.addPoint( QgsPoint( 2, 4, 6 ) );
+  tri.addPoint( QgsPoint( 2, 2, 7 ) );
+  indexes = tri.getTriangleVertexIndexes();
+  QCOMPARE( indexes.size(), 4 * 3 );
+  // every triangle is found by its containing point
+  for ( int i = 0; i < indexes.size(); i += 3 )
+  {
+    const QgsPoint *p1 = tri.getPoint( indexes.at( i ) );
+    const QgsPoint *p2 = tri.getPoint( indexes.at( i + 1 ) );
+    const QgsPoint *p3 = tri.getPoint( indexes.at( i + 2 ) );
+    const double x = ( p1->x() + p2->x() + p3->x() ) / 3;
+    const double y = ( p1->y() + p2->y() + p3->y() ) / 3;
+    QgsPoint t1( 0, 0, 0 );
+    QgsPoint t2( 0, 0, 0 );
+    QgsPoint t3( 0, 0, 0 );
+    int n1 = 0;
+    int n2 = 0;
+    int n3 = 0;
+    QVERIFY( tri.getTriangle( x, y, t1, n1, t2, n2, t3, n3 ) );
+    QVector< int > expected { indexes.at( i ), indexes.at( i + 1 ), indexes.at( i + 2 ) };
+    QVector< int > found { n1, n2, n3 };
+    std::sort( expected.begin(), expected.end() );
+    std::sort( found.begin(), found.end() );
+    QCOMPARE( found, expected );
+  }
+}
+
+std::unique_ptr< QgsVectorLayer > TestQgsInterpolator::randomPoints( int count ) const
+{
+  std::unique_ptr< QgsVectorLayer > layer = qgis::make_unique< QgsVectorLayer >( QStringLiteral( "Point?crs=EPSG:3857&field=value:double" ), QStringLiteral( "points" ), QStringLiteral( "memory" ) );
+  std::mt19937 generator( 7 );
+  std::uniform_real_distribution< double > coordinate( 0, 100 );
+  QgsFeatureList features;
+  for ( int i = 0; i < count; ++i )
+  {
+    const double x = coordinate( generator );
+    const double y = coordinate( generator );
+    QgsFeature feature( layer->fields() );
+    feature.setGeometry( QgsGeometry::fromPointXY( QgsPointXY( x, y ) ) );
+    feature.setAttribute( 0, std::sin( x / 10 ) * 10 + y );
+    features << feature;
+  }
+  layer->dataProvider()->addFeatures( features );
+  return layer;
+}
+
+void TestQgsInterpolator::idwNearestPoints()
+{
+  std::unique_ptr< QgsVectorLayer > layer = randomPoints( 500 );
+  QgsInterpolator::LayerData data;
+  data.source = layer.get();
+  data.valueSource = QgsInterpolator::ValueAttribute;
+  data.interpolationAttribute = 0;
+
+  QgsIDWInterpolator all( QList< QgsInterpolator::LayerData >() << data );
+  QgsIDWInterpolator indexedAll( QList< QgsInterpolator::LayerData >() << data );
+  indexedAll.setMaximumPoints( 500 );
+  QCOMPARE( indexedAll.maximumPoints(), 500 );
+  QgsIDWInterpolator nearest( QList< QgsInterpolator::LayerData >() << data );
+  nearest.setMaximumPoints( 5 );
+  QVERIFY( nearest.supportsParallelInterpolation() );
+  QCOMPARE( nearest.prepare(), QgsInterpolator::Success );
+
+  QVector< QgsPointXY > points;
+  QgsFeature feature;
+  QgsFeatureIterator it = layer->getFeatures();
+  QVector< double > values;
+  while ( it.nextFeature( feature ) )
+  {
+    points << feature.geometry().asPoint();
+    values << feature.attribute( 0 ).toDouble();
+  }
+
+  double result = 0;
+  double expected = 0;
+  for ( const QgsPointXY &location : { QgsPointXY( 50, 50 ), QgsPointXY( 0.5, 99 ), QgsPointXY( -20, 130 ), QgsPointXY( 33.3, 66.6 ) } )
+  {
+    // using all points through the index gives the same result as the full scan
+    QCOMPARE( all.interpolatePoint( location.x(), location.y(), expected ), 0 );
+    QCOMPARE( indexedAll.interpolatePoint( location.x(), location.y(), result ), 0 );
+    QGSCOMPARENEAR( result, expected, 1e-9 );
+
+    // brute force nearest points
+    QVector< int > order( points.size() );
+    std::iota( order.begin(), order.end(), 0 );
+    std::sort( order.begin(), order.end(), [&]( int a, int b )
+    {
+      return points.at( a ).sqrDist( location ) < points.at( b ).sqrDist( location );
+    } );
+    double sumCounter = 0;
+    double sumDenominator = 0;
+    for ( int i = 0; i < 5; ++i )
+    {
+      const double weight = 1 / points.at( order.at( i ) ).sqrDist( location );
+      sumCounter += weight * values.at( order.at( i ) );
+      sumDenominator += weight;
+    }
+    QCOMPARE( nearest.interpolatePoint( location.x(), location.y(), result ), 0 );
+    QGSCOMPARENEAR( result, sumCounter / sumDenominator, 1e-9 );
+  }
+
+  // exact hit on a point
+  QCOMPARE( nearest.interpolatePoint( points.at( 3 ).x(), points.at( 3 ).y(), result ), 0 );
+  QCOMPARE( result, values.at( 3 ) );
+}
+
+void TestQgsInterpolator::idwSearchRadius()
+{
+  std::unique_ptr< QgsVectorLayer > layer = randomPoints( 200 );
+  QgsInterpolator::LayerData data;
+  data.source = layer.get();
+  data.valueSource = QgsInterpolator::ValueAttribute;
+  data.interpolationAttribute = 0;
+
+  QgsIDWInterpolator interpolator( QList< QgsInterpolator::LayerData >() << data );
+  interpolator.setSearchRadius( 10 );
+  QCOMPARE( interpolator.searchRadius(), 10.0 );
+
+  QVector< QgsPointXY > points;
+  QVector< double > values;
+  QgsFeature feature;
+  QgsFeatureIterator it = layer->getFeatures();
+  while ( it.nextFeature( feature ) )
+  {
+    points << feature.geometry().asPoint();
+    values << feature.attribute( 0 ).toDouble();
+  }
+
+  const QgsPointXY location( 40, 60 );
+  double sumCounter = 0;
+  double sumDenominator = 0;
+  for ( int i = 0; i < points.size(); ++i )
+  {
+    const double distanceSquared = points.at( i ).sqrDist( location );
+    if ( distanceSquared > 100 )
+      continue;
+    sumCounter += values.at( i ) / distanceSquared;
+    sumDenominator += 1 / distanceSquared;
+  }
+  QVERIFY( sumDenominator > 0 );
+
+  double result = 0;
+  QCOMPARE( interpolator.interpolatePoint( location.x(), location.y(), result ), 0 );
+  QGSCOMPARENEAR( result, sumCounter / sumDenominator, 1e-9 );
+
+  // no points within the radius
+  QCOMPARE( interpolator.interpolatePoint( 500, 500, result ), 1 );
+
+  // the row interpolation marks such locations as NaN
+  const QVector< double > row = interpolator.interpolateRow( 300, 500, 1, 3 );
+  QCOMPARE( row.size(), 3 );
+  QVERIFY( std::isnan( row.at( 0 ) ) );
+}
+
+void TestQgsInterpolator::tinLinearRows()
+{
+  std::unique_ptr< QgsVectorLayer > layer = randomPoints( 300 );
+  QgsInterpolator::LayerData data;
+  data.source = layer.get();
+  data.valueSource = QgsInterpolator::ValueAttribute;
+  data.interpolationAttribute = 0;
+
+  QgsTinInterpolator interpolator( QList< QgsInterpolator::LayerData >() << data, QgsTinInterpolator::Linear );
+  QVERIFY( interpolator.supportsParallelInterpolation() );
+  QCOMPARE( interpolator.prepare(), QgsInterpolator::Success );
+
+  QgsTinInterpolator cloughTocher( QList< QgsInterpolator::LayerData >() << data, QgsTinInterpolator::CloughTocher );
+  QVERIFY( !cloughTocher.supportsParallelInterpolation() );
+
+  // the fast path for rows gives the same result as the interpolation of single points
+  int interpolated = 0;
+  for ( double y = -5.25; y < 105; y += 2.5 )
+  {
+    const QVector< double > row = interpolator.interpolateRow( -5.125, y, 1.5, 75 );
+    QCOMPARE( row.size(), 75 );
+    for ( int column = 0; column < row.size(); ++column )
+    {
+      const double x = -5.125 + column * 1.5;
+      double expected = 0;
+      if ( interpolator.interpolatePoint( x, y, expected, nullptr ) == 0 )
+      {
+        QVERIFY( !std::isnan( row.at( column ) ) );
+        QGSCOMPARENEAR( row.at( column ), expected, 1e-6 );
+        interpolated++;
+      }
+      else
+      {
+        QVERIFY( std::isnan( row.at( column ) ) );
+      }
+    }
+  }
+  QVERIFY( interpolated > 1500 );
+}
+
+void TestQgsInterpolator::gridFileWriter()
+{
+  std::unique_ptr< QgsVectorLayer > layer = randomPoints( 100 );
+  QgsInterpolator::LayerData data;
+  data.source = layer.get();
+  data.valueSource = QgsInterpolator::ValueAttribute;
+  data.interpolationAttribute = 0;
+
+  QgsIDWInterpolator interpolator( QList< QgsInterpolator::LayerData >() << data );
+  interpolator.setMaximumPoints( 8 );
+
+  QTemporaryDir dir;
+  const QgsRectangle extent( 0, 0, 100, 50 );
+
+  // GeoTIFF output
+  const QString tifFile = dir.path() + QStringLiteral( "/idw.tif" );
+  QgsGridFileWriter writer( &interpolator, tifFile, extent, 200, 100 );
+  QCOMPARE( writer.writeFile(), 0 );
+
+  QgsRasterLayer raster( tifFile, QStringLiteral( "idw" ) );
+  QVERIFY( raster.isValid() );
+  QCOMPARE( raster.width(), 200 );
+  QCOMPARE( raster.height(), 100 );
+  QCOMPARE( raster.extent(), extent );
+  QCOMPARE( raster.dataProvider()->dataType( 1 ), Qgis::Float32 );
+  QCOMPARE( raster.crs().authid(), QStringLiteral( "EPSG:3857" ) );
+
+  std::unique_ptr< QgsRasterBlock > block( raster.dataProvider()->block( 1, extent, 200, 100 ) );
+  double expected = 0;
+  QCOMPARE( interpolator.interpolatePoint( 10.25, 50 - 10.25, expected ), 0 );
+  QGSCOMPARENEAR( block->value( 20, 20 ), expected, 1e-4 );
+  QCOMPARE( interpolator.interpolatePoint( 99.75, 0.25, expected ), 0 );
+  QGSCOMPARENEAR( block->value( 99, 199 ), expected, 1e-4 );
+
+  // ASCII grid output
+  const QString ascFile = dir.path() + QStringLiteral( "/idw.asc" );
+  QgsGridFileWriter asciiWriter( &interpolator, ascFile, extent, 200, 100 );
+  QCOMPARE( asciiWriter.writeFile(), 0 );
+  QVERIFY( QFile::exists( dir.path() + QStringLiteral( "/idw.prj" ) ) );
+  QgsRasterLayer asciiRaster( ascFile, QStringLiteral( "idw" ) );
+  QVERIFY( asciiRaster.isValid() );
+  QCOMPARE( asciiRaster.width(), 200 );
+  std::unique_ptr< QgsRasterBlock > asciiBlock( asciiRaster.dataProvider()->block( 1, extent, 200, 100 ) );
+  QGSCOMPARENEAR( asciiBlock->value( 20, 20 ), block->value( 20, 20 ), 1e-4 );
+}
+
 QGSTEST_MAIN( TestQgsInterpolator )
 #include "testqgsinterpolator.moc"
@@ -462,6 +462,42 @@ void TestQgsNetworkAnalysis::dijkkjkjkskkjsktra()
   QCOMPARE( resultCost.at( point_0_0_idx ), 2.0 );
   QCOMPARE( graph->edge( resultTree.at( point_0_0_idx ) ).fromVertex(), point_10_0_idx );
   QCOMPARE( graph->edge( resultTree.at( point_0_0_idx ) ).toVertex(), point_0_0_idx );
+
+  // reverse search on forward direction graph, gives the paths leading to the end vertex
+  director = qgis::make_unique< QgsVectorLayerDirector > ( network.get(),
+             -1, QString(), QString(), QString(), QgsVectorLayerDirector::DirectionForward );
+  strategy = qgis::make_unique< TestNetworkStrategy >();
+  director->addStrategy( strategy.release() );
+  builder = qgis::make_unique< QgsGraphBuilder > ( network->sourceCrs(), true, 0 );
+  director->makeGraph( builder.get(), QVector<QgsPointXY>(), snapped );
+  graph.reset( builder->graph() );
+  int endVertexIdx = graph->findVertex( QgsPointXY( 10, 10 ) );
+  QVERIFY( endVertexIdx != -1 );
+  resultTree.clear();
+  resultCost.clear();
+  QgsGraphAnalyzer::reverseDijkstra( graph.get(), endVertexIdx, 0, &resultTree, &resultCost );
+  point_0_0_idx = graph->findVertex( QgsPointXY( 0, 0 ) );
+  point_10_0_idx = graph->findVertex( QgsPointXY( 10, 0 ) );
+  point_10_20_idx = graph->findVertex( QgsPointXY( 10, 20 ) );
+  point_20_10_idx = graph->findVertex( QgsPointXY( 20, 10 ) );
+  point_20_n10_idx = graph->findVertex( QgsPointXY( 20, -10 ) );
+
+  QCOMPARE( resultTree.at( endVertexIdx ), -1 );
+  QCOMPARE( resultCost.at( endVertexIdx ), 0.0 );
+  QCOMPARE( resultTree.at( point_20_10_idx ), -1 );
+  QCOMPARE( resultTree.at( point_20_n10_idx ), -1 );
+  QVERIFY( resultTree.at( point_10_20_idx ) != -1 );
+  QCOMPARE( resultCost.at( point_10_20_idx ), 3.0 );
+  QCOMPARE( graph->edge( resultTree.at( point_10_20_idx ) ).fromVertex(), point_10_20_idx );
+  QCOMPARE( graph->edge( resultTree.at( point_10_20_idx ) ).toVertex(), endVertexIdx );
+  QVERIFY( resultTree.at( point_10_0_idx ) != -1 );
+  QCOMPARE( resultCost.at( point_10_0_idx ), 1.0 );
+  QCOMPARE( graph->edge( resultTree.at( point_10_0_idx ) ).fromVertex(), point_10_0_idx );
+  QCOMPARE( graph->edge( resultTree.at( point_10_0_idx ) ).toVertex(), endVertexIdx );
+  QVERIFY( resultTree.at( point_0_0_idx ) != -1 );
+  QCOMPARE( resultCost.at( point_0_0_idx ), 2.0 );
+  QCOMPARE( graph->edge( resultTree.at( point_0_0_idx ) ).fromVertex(), point_0_0_idx );
+  QCOMPARE( graph->edge( resultTree.at( point_0_0_idx ) ).toVertex(), point_10_0_idx );
 }
 
 void TestQgsNetworkAnalysis::testRouteFail()
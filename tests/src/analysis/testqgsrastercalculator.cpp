@@ -20,6 +20,7 @@ Email                : nyall dot dawson at gmail dot com
 
 #include "qgsrastercalculator.h"
 #include "qgsrastercalcnode.h"
+#include "qgsrastercalcprogram.h"
 #include "qgsrasterdataprovider.h"
 #include "qgsrasterlayer.h"
 #include "qgsrastermatrix.h"
@@ -54,6 +55,7 @@ class TestQgsRasterCalculator : public QObject
 
     void rasterRefOp();
     void dualOpRasterRaster(); //test dual op on raster ref and raster ref
+    void calcProgram(); //test compiled expressions give the same results as the node tree
 
     void calcWithLayers();
     void calcWithReprojectedLayers();
@@ -439,6 +441,79 @@ void TestQgsRasterCalculator::dualOpRasterRaster()
   QCOMPARE( result.data()[5], -9999.0 );
 }
 
+void TestQgsRasterCalculator::calcProgram()
+{
+  const int width = 300; // more than one batch per row
+  const int height = 2;
+  QgsRasterBlock m1( Qgis::Float32, width, height );
+  m1.setNoDataValue( -1.0 );
+  QgsRasterBlock m2( Qgis::Int16, width, height );
+  m2.setNoDataValue( 7 );
+  for ( int row = 0; row < height; ++row )
+  {
+    for ( int col = 0; col < width; ++col )
+    {
+      m1.setValue( row, col, ( col % 13 ) * 0.5 - 2.5 );
+      m2.setValue( row, col, col % 11 - 3 + row );
+    }
+  }
+  QMap<QString, QgsRasterBlock *> rasterData;
+  rasterData.insert( QStringLiteral( "raster1" ), &m1 );
+  rasterData.insert( QStringLiteral( "raster2" ), &m2 );
+  const QVector< const QgsRasterBlock * > inputs { &m1, &m2 };
+
+  const QStringList formulas
+  {
+    QStringLiteral( "\"raster1\" + \"raster2\" * 2 - 1" ),
+    QStringLiteral( "\"raster1\" / \"raster2\"" ),
+    QStringLiteral( "\"raster1\" ^ \"raster2\"" ),
+    QStringLiteral( "\"raster2\" ^ 0.5" ),
+    QStringLiteral( "sqrt( \"raster1\" ) + log( \"raster2\" ) + log10( \"raster1\" )" ),
+    QStringLiteral( "sin( \"raster1\" ) * cos( \"raster2\" ) - tan( \"raster1\" ) + asin( \"raster1\" ) + acos( \"raster2\" ) + atan( \"raster1\" )" ),
+    QStringLiteral( "-\"raster1\"" ),
+    QStringLiteral( "( \"raster1\" > \"raster2\" ) AND ( \"raster1\" != 0 ) OR ( \"raster2\" <= 1 )" ),
+    QStringLiteral( "( \"raster1\" = \"raster2\" ) + ( \"raster1\" < 0 ) + ( \"raster2\" >= 2 )" ),
+    QStringLiteral( "2 + 3" ),
+  };
+
+  for ( const QString &formula : formulas )
+  {
+    QString error;
+    std::unique_ptr< QgsRasterCalcNode > node( QgsRasterCalcNode::parseRasterCalcString( formula, error ) );
+    QVERIFY( node );
+
+    QgsRasterCalcProgram program;
+    QVERIFY( program.compile( node.get() ) );
+    QVector< const QgsRasterBlock * > programInputs;
+    for ( const QString &reference : program.rasterReferences() )
+      programInputs << ( reference == QLatin1String( "raster1" ) ? inputs.at( 0 ) : inputs.at( 1 ) );
+
+    for ( int row = 0; row < height; ++row )
+    {
+      QgsRasterMatrix expected;
+      expected.setNodataValue( -9999 );
+      QVERIFY( node->calculate( rasterData, expected, row ) );
+
+      std::vector< float > result( width );
+      program.evaluate( programInputs, static_cast< qgssize >( row ) * width, width, -9999, result.data() );
+      for ( int col = 0; col < width; ++col )
+      {
+        const float expectedValue = static_cast< float >( expected.isNumber() ? expected.number() : expected.data()[ col ] );
+        if ( std::isnan( expectedValue ) )
+          QVERIFY2( std::isnan( result[ col ] ), formula.toLocal8Bit().constData() );
+        else
+          QCOMPARE( result[ col ], expectedValue );
+      }
+    }
+  }
+
+  // matrix nodes can't be compiled
+  QgsRasterMatrix matrix( 1, 1, new double[1] { 1.0 }, -1 );
+  QgsRasterCalcNode matrixNode( QgsRasterCalcNode::opPLUS, new QgsRasterCalcNode( &matrix ), new QgsRasterCalcNode( 2.0 ) );
+  QgsRasterCalcProgram program;
+  QVERIFY( !program.compile( &matrixNode ) );
+}
+
 void TestQgsRasterCalculator::calcWithLayers()
 {
   QgsRasterCalculatorEntry entry1;
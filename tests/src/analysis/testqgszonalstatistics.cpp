@@ -23,6 +23,7 @@
 #include "qgszonalstatistics.h"
 #include "qgsproject.h"
 #include "qgsvectorlayerutils.h"
+#include "qgsvectordataprovider.h"
 
 /**
  * \ingroup UnitTests
@@ -42,6 +43,8 @@ class TestQgsZonalStatistics : public QObject
     void testReprojection();
     void testNoData();
     void testSmallPolygons();
+    void testPolygonWithHole();
+    void testPolygonOverhangingRaster();
 
   private:
     QgsVectorLayer *mVectorLayer = nullptr;
@@ -343,5 +346,84 @@ void TestQgsZonalStatistics::testSmallPolygons()
   QGSCOMPARENEAR( f.attribute( "nmean" ).toDouble(), 864.285638, 0.001 );
 }
 
+void TestQgsZonalStatistics::testPolygonWithHole()
+{
+  QString myDataPath( TEST_DATA_DIR ); //defined in CmakeLists.txt
+  QString myTestDataPath = myDataPath + "/zonalstatistics/";
+
+  // the statistics of a polygon with a hole must match those of the outer polygon minus the hole
+  std::unique_ptr< QgsRasterLayer > rasterLayer = qgis::make_unique< QgsRasterLayer >( myTestDataPath + "raster.tif", QStringLiteral( "raster" ), QStringLiteral( "gdal" ) );
+  QVERIFY( rasterLayer->isValid() );
+  const QgsRectangle extent = rasterLayer->extent();
+  const QgsRectangle outer = extent.buffered( -0.13 * extent.width() );
+  const QgsRectangle hole = extent.buffered( -0.37 * extent.width() );
+
+  std::unique_ptr< QgsVectorLayer > vectorLayer = qgis::make_unique< QgsVectorLayer >( QStringLiteral( "Polygon?crs=%1" ).arg( rasterLayer->crs().authid() ), QStringLiteral( "poly" ), QStringLiteral( "memory" ) );
+  QgsFeature outerFeature;
+  outerFeature.setGeometry( QgsGeometry::fromRect( outer ) );
+  QgsFeature holeFeature;
+  holeFeature.setGeometry( QgsGeometry::fromRect( hole ) );
+  QgsFeature withHoleFeature;
+  withHoleFeature.setGeometry( QgsGeometry::fromRect( outer ).difference( QgsGeometry::fromRect( hole ) ) );
+  QgsFeatureList features = QgsFeatureList() << outerFeature << holeFeature << withHoleFeature;
+  QVERIFY( vectorLayer->dataProvider()->addFeatures( features ) );
+
+  QgsZonalStatistics zs( vectorLayer.get(), rasterLayer.get(), QString(), 1, QgsZonalStatistics::Count | QgsZonalStatistics::Sum );
+  zs.calculateStatistics( nullptr );
+
+  QgsFeatureIterator it = vectorLayer->getFeatures();
+  QgsFeature f;
+  QVERIFY( it.nextFeature( f ) );
+  const double outerCount = f.attribute( "count" ).toDouble();
+  const double outerSum = f.attribute( "sum" ).toDouble();
+  QVERIFY( it.nextFeature( f ) );
+  const double holeCount = f.attribute( "count" ).toDouble();
+  const double holeSum = f.attribute( "sum" ).toDouble();
+  QVERIFY( holeCount > 1 );
+  QVERIFY( it.nextFeature( f ) );
+  QCOMPARE( f.attribute( "count" ).toDouble(), outerCount - holeCount );
+  QGSCOMPARENEAR( f.attribute( "sum" ).toDouble(), outerSum - holeSum, 0.001 );
+}
+
+void TestQgsZonalStatistics::testPolygonOverhangingRaster()
+{
+  QString myDataPath( TEST_DATA_DIR ); //defined in CmakeLists.txt
+  QString myTestDataPath = myDataPath + "/zonalstatistics/";
+
+  // a polygon extending past the right edge of the raster must cover the same cells as the
+  // part of it which is inside the raster
+  std::unique_ptr< QgsRasterLayer > rasterLayer = qgis::make_unique< QgsRasterLayer >( myTestDataPath + "raster.tif", QStringLiteral( "raster" ), QStringLiteral( "gdal" ) );
+  QVERIFY( rasterLayer->isValid() );
+  const QgsRectangle extent = rasterLayer->extent();
+  const double cellSizeX = rasterLayer->rasterUnitsPerPixelX();
+  const double cellSizeY = rasterLayer->rasterUnitsPerPixelY();
+  // the borders inside the raster don't fall on cell boundaries, so cell center and precise statistics differ
+  const QgsRectangle overhanging( extent.xMinimum() + 4.3 * cellSizeX, extent.yMaximum() - 9.7 * cellSizeY,
+                                 extent.xMaximum() + 3 * cellSizeX, extent.yMaximum() - 2.3 * cellSizeY );
+  QgsRectangle clipped = overhanging;
+  clipped.setXMaximum( extent.xMaximum() );
+
+  std::unique_ptr< QgsVectorLayer > vectorLayer = qgis::make_unique< QgsVectorLayer >( QStringLiteral( "Polygon?crs=%1" ).arg( rasterLayer->crs().authid() ), QStringLiteral( "poly" ), QStringLiteral( "memory" ) );
+  QgsFeature overhangingFeature;
+  overhangingFeature.setGeometry( QgsGeometry::fromRect( overhanging ) );
+  QgsFeature clippedFeature;
+  clippedFeature.setGeometry( QgsGeometry::fromRect( clipped ) );
+  QgsFeatureList features = QgsFeatureList() << overhangingFeature << clippedFeature;
+  QVERIFY( vectorLayer->dataProvider()->addFeatures( features ) );
+
+  QgsZonalStatistics zs( vectorLayer.get(), rasterLayer.get(), QString(), 1, QgsZonalStatistics::Count | QgsZonalStatistics::Sum );
+  zs.calculateStatistics( nullptr );
+
+  QgsFeatureIterator it = vectorLayer->getFeatures();
+  QgsFeature f;
+  QVERIFY( it.nextFeature( f ) );
+  const double overhangingCount = f.attribute( "count" ).toDouble();
+  const double overhangingSum = f.attribute( "sum" ).toDouble();
+  QVERIFY( it.nextFeature( f ) );
+  QVERIFY( f.attribute( "count" ).toDouble() > 1 );
+  QCOMPARE( overhangingCount, f.attribute( "count" ).toDouble() );
+  QGSCOMPARENEAR( overhangingSum, f.attribute( "sum" ).toDouble(), 0.001 );
+}
+
 QGSTEST_MAIN( TestQgsZonalStatistics )
 #include "testqgszonalstatistics.moc"
@@ -42,6 +42,7 @@ class TestQgsFieldCalculator : public QObject
     void cleanup() {} // will be called after every testfunction.
     void testLengthCalculations();
     void testAreaCalculations();
+    void testBlockCalculations();
 
   private:
     QgisApp *mQgisApp = nullptr;
@@ -183,5 +184,56 @@ void TestQgsFieldCalculator::testAreaCalculations()
   QGSCOMPARENEAR( f.attribute( "col1" ).toDouble(), expected, 0.001 );
 }
 
+void TestQgsFieldCalculator::testBlockCalculations()
+{
+  // more features than evaluated in a single block
+  std::unique_ptr< QgsVectorLayer> tempLayer( new QgsVectorLayer( QStringLiteral( "Point?crs=epsg:3111&field=pk:int&field=col1:double" ), QStringLiteral( "vl" ), QStringLiteral( "memory" ) ) );
+  QVERIFY( tempLayer->isValid() );
+  QgsFeatureList features;
+  for ( int i = 1; i <= 2500; ++i )
+  {
+    QgsFeature f( tempLayer->dataProvider()->fields(), i );
+    f.setAttribute( QStringLiteral( "pk" ), i );
+    f.setAttribute( QStringLiteral( "col1" ), 0.0 );
+    features << f;
+  }
+  tempLayer->dataProvider()->addFeatures( features );
+
+  tempLayer->startEditing();
+  std::unique_ptr< QgsFieldCalculator > calc( new QgsFieldCalculator( tempLayer.get() ) );
+  calc->mUpdateExistingGroupBox->setChecked( true );
+  calc->mExistingFieldComboBox->setCurrentIndex( 1 );
+  calc->builder->setExpressionText( QStringLiteral( "\"pk\" * 2" ) );
+  calc->accept();
+  tempLayer->commitChanges();
+
+  QgsFeatureIterator fit = tempLayer->dataProvider()->getFeatures();
+  QgsFeature f;
+  int count = 0;
+  while ( fit.nextFeature( f ) )
+  {
+    QCOMPARE( f.attribute( "col1" ).toDouble(), f.attribute( "pk" ).toDouble() * 2 );
+    count++;
+  }
+  QCOMPARE( count, 2500 );
+
+  // @row_number has to be updated for every feature
+  tempLayer->startEditing();
+  std::unique_ptr< QgsFieldCalculator > calc2( new QgsFieldCalculator( tempLayer.get() ) );
+  calc2->mUpdateExistingGroupBox->setChecked( true );
+  calc2->mExistingFieldComboBox->setCurrentIndex( 1 );
+  calc2->builder->setExpressionText( QStringLiteral( "@row_number + 0.5" ) );
+  calc2->accept();
+  tempLayer->commitChanges();
+
+  QSet< double > rowNumbers;
+  fit = tempLayer->dataProvider()->getFeatures();
+  while ( fit.nextFeature( f ) )
+    rowNumbers.insert( f.attribute( "col1" ).toDouble() );
+  QCOMPARE( rowNumbers.size(), 2500 );
+  QVERIFY( rowNumbers.contains( 1.5 ) );
+  QVERIFY( rowNumbers.contains( 2500.5 ) );
+}
+
 QGSTEST_MAIN( TestQgsFieldCalculator )
 #include "testqgsfieldcalculator.moc"
@@ -624,6 +624,10 @@ class TestQgsExpression: public QObject
       QTest::newRow( "invalid and" ) << "'foo' and 2=3" << true << QVariant();
       QTest::newRow( "invalid or" ) << "'foo' or 2=3" << true << QVariant();
       QTest::newRow( "invalid not" ) << "not 'foo'" << true << QVariant();
+      QTest::newRow( "F and invalid" ) << "2=3 and 'foo'" << false << QVariant( 0 );
+      QTest::newRow( "T or invalid" ) << "1=1 or 'foo'" << false << QVariant( 1 );
+      QTest::newRow( "T and invalid" ) << "1=1 and 'foo'" << true << QVariant();
+      QTest::newRow( "U and invalid" ) << "null=1 and 'foo'" << true << QVariant();
 
       // in, not in
       QTest::newRow( "in 1" ) << "1 in (1,2,3)" << false << QVariant( 1 );
@@ -1555,6 +1559,208 @@ class TestQgsExpression: public QObject
       QCOMPARE( res.toInt(), 0 );
     }
 
+    void eval_like_prepared()
+    {
+      QgsFields fields;
+      fields.append( QgsField( QStringLiteral( "name" ), QVariant::String ) );
+      fields.append( QgsField( QStringLiteral( "pattern" ), QVariant::String ) );
+
+      QgsFeature f( fields );
+      QgsExpressionContext context = QgsExpressionContextUtils::createFeatureBasedContext( f, fields );
+
+      // static pattern, compiled once during prepare
+      QgsExpression exp( QStringLiteral( "name LIKE 'ap%'" ) );
+      QVERIFY( exp.prepare( &context ) );
+      QgsExpression iexp( QStringLiteral( "name NOT ILIKE 'AP%'" ) );
+      QVERIFY( iexp.prepare( &context ) );
+      QgsExpression rexp( QStringLiteral( "name ~ 'an+'" ) );
+      QVERIFY( rexp.prepare( &context ) );
+      // pattern taken from the feature
+      QgsExpression dexp( QStringLiteral( "name LIKE pattern" ) );
+      QVERIFY( dexp.prepare( &context ) );
+
+      const QStringList names = QStringList() << QStringLiteral( "apple" ) << QStringLiteral( "banana" ) << QStringLiteral( "Apricot" );
+      const QStringList patterns = QStringList() << QStringLiteral( "a%" ) << QStringLiteral( "%nan_" ) << QStringLiteral( "a%" );
+      const QList< int > expected = QList< int >() << 1 << 0 << 0;
+      const QList< int > expectedNotILike = QList< int >() << 0 << 1 << 0;
+      const QList< int > expectedRegExp = QList< int >() << 0 << 1 << 0;
+      const QList< int > expectedDynamic = QList< int >() << 1 << 1 << 0;
+      for ( int i = 0; i < names.count(); ++i )
+      {
+        f.setAttribute( 0, names.at( i ) );
+        f.setAttribute( 1, patterns.at( i ) );
+        context.setFeature( f );
+        QCOMPARE( exp.evaluate( &context ).toInt(), expected.at( i ) );
+        QCOMPARE( iexp.evaluate( &context ).toInt(), expectedNotILike.at( i ) );
+        QCOMPARE( rexp.evaluate( &context ).toInt(), expectedRegExp.at( i ) );
+        QCOMPARE( dexp.evaluate( &context ).toInt(), expectedDynamic.at( i ) );
+      }
+
+      // the cached pattern must survive copying the prepared expression
+      QgsExpression copy( exp );
+      f.setAttribute( 0, QStringLiteral( "apricot" ) );
+      context.setFeature( f );
+      QCOMPARE( copy.evaluate( &context ).toInt(), 1 );
+    }
+
+    void eval_batch_data()
+    {
+      QTest::addColumn<QString>( "string" );
+
+      // typed fast path
+      QTest::newRow( "int gt" ) << "int_field > 5";
+      QTest::newRow( "int eq double" ) << "int_field = 7.0";
+      QTest::newRow( "double le" ) << "double_field <= 2.5";
+      QTest::newRow( "double ne" ) << "double_field <> 2.5";
+      QTest::newRow( "int plus" ) << "int_field + 3";
+      QTest::newRow( "int minus double" ) << "int_field - 0.5";
+      QTest::newRow( "double mul" ) << "double_field * 2";
+      QTest::newRow( "int div" ) << "int_field / 2";
+      QTest::newRow( "div zero" ) << "double_field / 0";
+      QTest::newRow( "string numeric compare" ) << "string_field >= 3";
+      // generic evaluation
+      QTest::newRow( "mod" ) << "int_field % 4";
+      QTest::newRow( "and" ) << "int_field > 2 and double_field < 5";
+      QTest::newRow( "string concat" ) << "string_field || 'x'";
+      QTest::newRow( "invalid" ) << "string_field * 2";
+    }
+
+    void eval_batch()
+    {
+      QFETCH( QString, string );
+
+      QgsFields fields;
+      fields.append( QgsField( QStringLiteral( "int_field" ), QVariant::Int ) );
+      fields.append( QgsField( QStringLiteral( "double_field" ), QVariant::Double ) );
+      fields.append( QgsField( QStringLiteral( "string_field" ), QVariant::String ) );
+
+      QgsFeatureList features;
+      const QList< QVariantList > values = QList< QVariantList >()
+                                           << ( QVariantList() << 1 << 2.5 << QStringLiteral( "3" ) )
+                                           << ( QVariantList() << 7 << -1.25 << QStringLiteral( "a" ) )
+                                           << ( QVariantList() << QVariant( QVariant::Int ) << QVariant( QVariant::Double ) << QVariant( QVariant::String ) )
+                                           << ( QVariantList() << 12 << 100.0 << QStringLiteral( "2.5" ) );
+      for ( const QVariantList &attributes : values )
+      {
+        QgsFeature f( fields );
+        f.setAttributes( attributes.toVector() );
+        features << f;
+      }
+
+      QgsExpressionContext context = QgsExpressionContextUtils::createFeatureBasedContext( QgsFeature(), fields );
+      QgsExpression exp( string );
+      exp.prepare( &context );
+
+      QList< QVariant > expected;
+      bool expectedError = false;
+      for ( const QgsFeature &f : qgis::as_const( features ) )
+      {
+        context.setFeature( f );
+        expected << exp.evaluate( &context );
+        expectedError |= exp.hasEvalError();
+      }
+
+      QgsExpression batchExp( string );
+      batchExp.prepare( &context );
+      const QVariantList results = batchExp.evaluateBatch( features, &context );
+      QCOMPARE( results.count(), expected.count() );
+      for ( int i = 0; i < results.count(); ++i )
+      {
+        QCOMPARE( results.at( i ).type(), expected.at( i ).type() );
+        QCOMPARE( results.at( i ), expected.at( i ) );
+      }
+      QCOMPARE( batchExp.hasEvalError(), expectedError );
+    }
+
+    void eval_compiled_data()
+    {
+      QTest::addColumn<QString>( "string" );
+      QTest::addColumn<bool>( "compiled" );
+
+      QTest::newRow( "int gt" ) << "int_field > 5" << true;
+      QTest::newRow( "and" ) << "int_field > 2 and double_field < 5" << true;
+      QTest::newRow( "or" ) << "int_field > 2 or string_field = 'a'" << true;
+      QTest::newRow( "not" ) << "not int_field" << true;
+      QTest::newRow( "int arithmetic" ) << "int_field * 2 + 1" << true;
+      QTest::newRow( "int mod" ) << "int_field % 4" << true;
+      QTest::newRow( "mod zero" ) << "int_field % 0" << true;
+      QTest::newRow( "double arithmetic" ) << "double_field / 2 - int_field" << true;
+      QTest::newRow( "div zero" ) << "double_field / 0" << true;
+      QTest::newRow( "power" ) << "double_field ^ 2" << true;
+      QTest::newRow( "string compare" ) << "string_field < 'b'" << true;
+      QTest::newRow( "string plus" ) << "string_field + 'x'" << true;
+      QTest::newRow( "concat" ) << "string_field || int_field" << true;
+      QTest::newRow( "is null" ) << "int_field is null" << true;
+      QTest::newRow( "is not" ) << "double_field is not 2.5" << true;
+      QTest::newRow( "in" ) << "int_field in (1, 12, '7')" << true;
+      QTest::newRow( "not in" ) << "string_field not in ('a', 3, null)" << true;
+      QTest::newRow( "with function" ) << "int_field > 3 and abs(double_field) > 1" << true;
+      QTest::newRow( "mixed types" ) << "string_field > 3" << false;
+      QTest::newRow( "function" ) << "abs(int_field)" << false;
+      QTest::newRow( "column" ) << "int_field" << false;
+      QTest::newRow( "static" ) << "1 + 2" << false;
+    }
+
+    void eval_compiled()
+    {
+      QFETCH( QString, string );
+      QFETCH( bool, compiled );
+
+      QgsFields fields;
+      fields.append( QgsField( QStringLiteral( "int_field" ), QVariant::Int ) );
+      fields.append( QgsField( QStringLiteral( "double_field" ), QVariant::Double ) );
+      fields.append( QgsField( QStringLiteral( "string_field" ), QVariant::String ) );
+
+      QgsFeatureList features;
+      const QList< QVariantList > values = QList< QVariantList >()
+                                           << ( QVariantList() << 1 << 2.5 << QStringLiteral( "3" ) )
+                                           << ( QVariantList() << 7 << -1.25 << QStringLiteral( "a" ) )
+                                           << ( QVariantList() << QVariant( QVariant::Int ) << QVariant( QVariant::Double ) << QVariant( QVariant::String ) )
+                                           << ( QVariantList() << 12 << 100.0 << QVariant() )
+                                           // not the type of the field, evaluated by the tree
+                                           << ( QVariantList() << QStringLiteral( "5" ) << 1.0 << QStringLiteral( "b" ) )
+                                           << ( QVariantList() << 3 << std::numeric_limits< double >::infinity() << QStringLiteral( "c" ) );
+      for ( const QVariantList &attributes : values )
+      {
+        QgsFeature f( fields );
+        f.setAttributes( attributes.toVector() );
+        features << f;
+      }
+
+      QgsExpressionContext context = QgsExpressionContextUtils::createFeatureBasedContext( QgsFeature(), fields );
+      QgsExpression exp( string );
+      exp.prepare( &context );
+      QVERIFY( !exp.isCompiled() );
+
+      QgsExpression compiledExp( string );
+      compiledExp.prepare( &context );
+      QCOMPARE( compiledExp.compile( &context ), compiled );
+      QCOMPARE( compiledExp.isCompiled(), compiled );
+
+      QList< QVariant > expected;
+      bool expectedError = false;
+      for ( const QgsFeature &f : qgis::as_const( features ) )
+      {
+        context.setFeature( f );
+        const QVariant value = exp.evaluate( &context );
+        expected << value;
+        expectedError |= exp.hasEvalError();
+
+        const QVariant result = compiledExp.evaluate( &context );
+        QCOMPARE( result.type(), value.type() );
+        QCOMPARE( result, value );
+        QCOMPARE( compiledExp.evalErrorString(), exp.evalErrorString() );
+      }
+
+      const QVariantList results = compiledExp.evaluateBatch( features, &context );
+      QCOMPARE( results, expected );
+      QCOMPARE( compiledExp.hasEvalError(), expectedError );
+
+      // preparing again discards the program
+      compiledExp.prepare( &context );
+      QVERIFY( !compiledExp.isCompiled() );
+    }
+
     void eval_feature_id()
     {
       QgsFeature f( 100 );
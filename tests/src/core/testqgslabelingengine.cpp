@@ -29,6 +29,10 @@
 #include "qgsfontutils.h"
 #include "qgsnullsymbolrenderer.h"
 #include "pointset.h"
+#include "problem.h"
+#include "qgslabelplacementcache.h"
+
+#include <QThreadPool>
 
 class TestQgsLabelingEngine : public QObject
 {
@@ -72,6 +76,9 @@ class TestQgsLabelingEngine : public QObject
     void curvedOverrun();
     void parallelOverrun();
     void testDataDefinedLabelAllParts();
+    void testComponentSearch();
+    void testPlacementCache();
+    void testParallelPlacementDeterministic();
 
   private:
     QgsVectorLayer *vl = nullptr;
@@ -126,6 +133,8 @@ void TestQgsLabelingEngine::testEngineSettings()
 
   // getters/setters
   QgsLabelingEngineSettings settings;
+  QVERIFY( settings.testFlag( QgsLabelingEngineSettings::SplitConflictComponents ) );
+  QVERIFY( !settings.testFlag( QgsLabelingEngineSettings::ReuseComponentSolutions ) );
   settings.setDefaultTextRenderFormat( QgsRenderContext::TextFormatAlwaysText );
   QCOMPARE( settings.defaultTextRenderFormat(), QgsRenderContext::TextFormatAlwaysText );
   settings.setDefaultTextRenderFormat( QgsRenderContext::TextFormatAlwaysOutlines );
@@ -143,20 +152,34 @@ void TestQgsLabelingEngine::testEngineSettings()
   QgsProject p;
   settings.setDefaultTextRenderFormat( QgsRenderContext::TextFormatAlwaysText );
   settings.setFlag( QgsLabelingEngineSettings::DrawUnplacedLabels, true );
+  settings.setFlag( QgsLabelingEngineSettings::UsePlacementCache, true );
+  settings.setFlag( QgsLabelingEngineSettings::SplitConflictComponents, true );
+  settings.setFlag( QgsLabelingEngineSettings::ReuseComponentSolutions, true );
+  settings.setComponentSolutionCacheSize( 1000 );
   settings.setUnplacedLabelColor( QColor( 0, 255, 0 ) );
   settings.writeSettingsToProject( &p );
   QgsLabelingEngineSettings settings2;
   settings2.readSettingsFromProject( &p );
   QCOMPARE( settings2.defaultTextRenderFormat(), QgsRenderContext::TextFormatAlwaysText );
   QVERIFY( settings2.testFlag( QgsLabelingEngineSettings::DrawUnplacedLabels ) );
+  QVERIFY( settings2.testFlag( QgsLabelingEngineSettings::UsePlacementCache ) );
+  QVERIFY( settings2.testFlag( QgsLabelingEngineSettings::SplitConflictComponents ) );
+  QVERIFY( settings2.testFlag( QgsLabelingEngineSettings::ReuseComponentSolutions ) );
+  QCOMPARE( settings2.componentSolutionCacheSize(), 1000 );
   QCOMPARE( settings2.unplacedLabelColor().name(), QStringLiteral( "#00ff00" ) );
 
   settings.setDefaultTextRenderFormat( QgsRenderContext::TextFormatAlwaysOutlines );
   settings.setFlag( QgsLabelingEngineSettings::DrawUnplacedLabels, false );
+  settings.setFlag( QgsLabelingEngineSettings::UsePlacementCache, false );
+  settings.setFlag( QgsLabelingEngineSettings::SplitConflictComponents, false );
+  settings.setFlag( QgsLabelingEngineSettings::ReuseComponentSolutions, false );
   settings.writeSettingsToProject( &p );
   settings2.readSettingsFromProject( &p );
   QCOMPARE( settings2.defaultTextRenderFormat(), QgsRenderContext::TextFormatAlwaysOutlines );
   QVERIFY( !settings2.testFlag( QgsLabelingEngineSettings::DrawUnplacedLabels ) );
+  QVERIFY( !settings2.testFlag( QgsLabelingEngineSettings::UsePlacementCache ) );
+  QVERIFY( !settings2.testFlag( QgsLabelingEngineSettings::SplitConflictComponents ) );
+  QVERIFY( !settings2.testFlag( QgsLabelingEngineSettings::ReuseComponentSolutions ) );
 
   // test that older setting is still respected as a fallback
   QgsProject p2;
@@ -164,6 +187,8 @@ void TestQgsLabelingEngine::testEngineSettings()
   p2.writeEntry( QStringLiteral( "PAL" ), QStringLiteral( "/DrawOutlineLabels" ), false );
   settings3.readSettingsFromProject( &p2 );
   QCOMPARE( settings3.defaultTextRenderFormat(), QgsRenderContext::TextFormatAlwaysText );
+  // projects without the setting split the components
+  QVERIFY( settings3.testFlag( QgsLabelingEngineSettings::SplitConflictComponents ) );
 
   p2.writeEntry( QStringLiteral( "PAL" ), QStringLiteral( "/DrawOutlineLabels" ), true );
   settings3.readSettingsFromProject( &p2 );
@@ -2195,5 +2220,228 @@ void TestQgsLabelingEngine::testDataDefinedLabelAllParts()
 
 }
 
+void TestQgsLabelingEngine::testComponentSearch()
+{
+  // dense labels, solved as independent groups of conflicting labels
+  QgsPalLayerSettings settings;
+  setDefaultLabelParams( settings );
+  settings.fieldName = QStringLiteral( "'XXXX'" );
+  settings.isExpression = true;
+  settings.placement = QgsPalLayerSettings::AroundPoint;
+
+  std::unique_ptr< QgsVectorLayer> vl2( new QgsVectorLayer( QStringLiteral( "Point?crs=epsg:3946&field=id:integer" ), QStringLiteral( "vl" ), QStringLiteral( "memory" ) ) );
+  vl2->setRenderer( new QgsNullSymbolRenderer() );
+
+  QgsFeatureList features;
+  for ( int i = 0; i < 400; ++i )
+  {
+    QgsFeature f;
+    f.setAttributes( QgsAttributes() << i );
+    // clusters of points with some space between them
+    const double x = 190000 + ( i % 20 ) * 10 + ( i % 3 ) * 1.5;
+    const double y = 5000000 + ( i / 20 ) * 5 + ( i % 7 ) * 0.5;
+    f.setGeometry( QgsGeometry::fromPointXY( QgsPointXY( x, y ) ) );
+    features << f;
+  }
+  QVERIFY( vl2->dataProvider()->addFeatures( features ) );
+
+  vl2->setLabeling( new QgsVectorLayerSimpleLabeling( settings ) );  // TODO: this should not be necessary!
+  vl2->setLabelsEnabled( true );
+
+  QgsMapSettings mapSettings;
+  mapSettings.setDestinationCrs( vl2->crs() );
+  mapSettings.setOutputSize( QSize( 800, 600 ) );
+  mapSettings.setExtent( QgsRectangle( 189990, 4999990, 190210, 5000110 ) );
+  mapSettings.setLayers( QList<QgsMapLayer *>() << vl2.get() );
+  mapSettings.setOutputDpi( 96 );
+  QgsLabelingEngineSettings engineSettings = mapSettings.labelingEngineSettings();
+  engineSettings.setFlag( QgsLabelingEngineSettings::SplitConflictComponents, true );
+  engineSettings.setFlag( QgsLabelingEngineSettings::ReuseComponentSolutions, true );
+  mapSettings.setLabelingEngineSettings( engineSettings );
+
+  auto placedLabels = [&mapSettings]() -> QList< QgsLabelPosition >
+  {
+    QgsMapRendererSequentialJob job( mapSettings );
+    job.start();
+    job.waitForFinished();
+    std::unique_ptr< QgsLabelingResults > results( job.takeLabelingResults() );
+    QList< QgsLabelPosition > labels = results->labelsWithinRect( mapSettings.visibleExtent() );
+    std::sort( labels.begin(), labels.end(), []( const QgsLabelPosition & a, const QgsLabelPosition & b )
+    {
+      return a.featureId < b.featureId;
+    } );
+    return labels;
+  };
+
+  QgsLabelingEngine::clearComponentSolutionCache();
+  const QList< QgsLabelPosition > labels = placedLabels();
+  QVERIFY( labels.size() > 50 );
+  QVERIFY( labels.size() < 400 );
+
+  // placed labels must not overlap
+  for ( int i = 0; i < labels.size(); ++i )
+  {
+    for ( int j = i + 1; j < labels.size(); ++j )
+    {
+      const QgsRectangle overlap = labels.at( i ).labelRect.intersect( labels.at( j ).labelRect );
+      QVERIFY( overlap.isEmpty() || overlap.area() < 1e-6 );
+    }
+  }
+
+  // reused solutions must result in the very same labels
+  const QList< QgsLabelPosition > cachedLabels = placedLabels();
+  QCOMPARE( cachedLabels.size(), labels.size() );
+  for ( int i = 0; i < labels.size(); ++i )
+  {
+    QCOMPARE( cachedLabels.at( i ).featureId, labels.at( i ).featureId );
+    QCOMPARE( cachedLabels.at( i ).labelRect, labels.at( i ).labelRect );
+  }
+}
+
+void TestQgsLabelingEngine::testPlacementCache()
+{
+  QgsPalLayerSettings settings;
+  setDefaultLabelParams( settings );
+  settings.fieldName = QStringLiteral( "'label ' || \"id\"" );
+  settings.isExpression = true;
+  settings.placement = QgsPalLayerSettings::AroundPoint;
+
+  std::unique_ptr< QgsVectorLayer> vl2( new QgsVectorLayer( QStringLiteral( "Point?crs=epsg:3946&field=id:integer" ), QStringLiteral( "vl" ), QStringLiteral( "memory" ) ) );
+  vl2->setRenderer( new QgsNullSymbolRenderer() );
+
+  QgsFeatureList features;
+  for ( int i = 0; i < 200; ++i )
+  {
+    QgsFeature f;
+    f.setAttributes( QgsAttributes() << i );
+    f.setGeometry( QgsGeometry::fromPointXY( QgsPointXY( 190000 + ( i % 20 ) * 10 + ( i % 3 ) * 1.5, 5000000 + ( i / 20 ) * 10 + ( i % 7 ) * 0.5 ) ) );
+    features << f;
+  }
+  QVERIFY( vl2->dataProvider()->addFeatures( features ) );
+
+  vl2->setLabeling( new QgsVectorLayerSimpleLabeling( settings ) );  // TODO: this should not be necessary!
+  vl2->setLabelsEnabled( true );
+
+  QgsMapSettings mapSettings;
+  mapSettings.setDestinationCrs( vl2->crs() );
+  mapSettings.setOutputSize( QSize( 400, 400 ) );
+  mapSettings.setLayers( QList<QgsMapLayer *>() << vl2.get() );
+  mapSettings.setOutputDpi( 96 );
+  QgsLabelingEngineSettings engineSettings = mapSettings.labelingEngineSettings();
+  engineSettings.setFlag( QgsLabelingEngineSettings::UsePlacementCache, true );
+  mapSettings.setLabelingEngineSettings( engineSettings );
+
+  auto placedLabels = [&mapSettings]( const QgsRectangle & extent ) -> QMap< QgsFeatureId, QgsRectangle >
+  {
+    mapSettings.setExtent( extent );
+    QgsMapRendererSequentialJob job( mapSettings );
+    job.start();
+    job.waitForFinished();
+    std::unique_ptr< QgsLabelingResults > results( job.takeLabelingResults() );
+    QMap< QgsFeatureId, QgsRectangle > labels;
+    const QList< QgsLabelPosition > positions = results->labelsWithinRect( extent );
+    for ( const QgsLabelPosition &position : positions )
+      labels.insert( position.featureId, position.labelRect );
+    return labels;
+  };
+
+  QgsLabelPlacementCache *cache = QgsApplication::labelPlacementCache();
+  cache->clear();
+
+  // two overlapping tiles of the same scale
+  const QgsRectangle firstTile( 189990, 4999990, 190100, 5000100 );
+  const QgsRectangle secondTile( 190045, 4999990, 190155, 5000100 );
+  const QMap< QgsFeatureId, QgsRectangle > first = placedLabels( firstTile );
+  QVERIFY( !first.isEmpty() );
+  QVERIFY( cache->count() > 0 );
+
+  // the same tile again results in the same labels
+  QCOMPARE( placedLabels( firstTile ), first );
+
+  // labels shown in both tiles are placed the same way
+  const QMap< QgsFeatureId, QgsRectangle > second = placedLabels( secondTile );
+  int shared = 0;
+  for ( auto it = first.constBegin(); it != first.constEnd(); ++it )
+  {
+    if ( !second.contains( it.key() ) )
+      continue;
+
+    shared++;
+    QCOMPARE( second.value( it.key() ), it.value() );
+  }
+  QVERIFY( shared > 0 );
+
+  // changed labeling settings invalidate the cached labels of the layer
+  vl2->setLabeling( new QgsVectorLayerSimpleLabeling( settings ) );
+  QCOMPARE( cache->count(), 0 );
+
+  // the cache is not used without the flag
+  engineSettings.setFlag( QgsLabelingEngineSettings::UsePlacementCache, false );
+  mapSettings.setLabelingEngineSettings( engineSettings );
+  placedLabels( firstTile );
+  QCOMPARE( cache->count(), 0 );
+}
+
+void TestQgsLabelingEngine::testParallelPlacementDeterministic()
+{
+  QgsPalLayerSettings settings;
+  setDefaultLabelParams( settings );
+  settings.fieldName = QStringLiteral( "'label ' || \"id\"" );
+  settings.isExpression = true;
+  settings.placement = QgsPalLayerSettings::AroundPoint;
+
+  std::unique_ptr< QgsVectorLayer> vl2( new QgsVectorLayer( QStringLiteral( "Point?crs=epsg:3946&field=id:integer" ), QStringLiteral( "vl" ), QStringLiteral( "memory" ) ) );
+  vl2->setRenderer( new QgsNullSymbolRenderer() );
+
+  // densely packed points, so that many candidates conflict with each other
+  QgsFeatureList features;
+  for ( int i = 0; i < 400; ++i )
+  {
+    QgsFeature f;
+    f.setAttributes( QgsAttributes() << i );
+    f.setGeometry( QgsGeometry::fromPointXY( QgsPointXY( 190000 + ( i % 20 ) * 5 + ( i % 3 ) * 1.5, 5000000 + ( i / 20 ) * 5 + ( i % 7 ) * 0.5 ) ) );
+    features << f;
+  }
+  QVERIFY( vl2->dataProvider()->addFeatures( features ) );
+
+  vl2->setLabeling( new QgsVectorLayerSimpleLabeling( settings ) );  // TODO: this should not be necessary!
+  vl2->setLabelsEnabled( true );
+
+  QgsMapSettings mapSettings;
+  mapSettings.setDestinationCrs( vl2->crs() );
+  mapSettings.setOutputSize( QSize( 400, 400 ) );
+  mapSettings.setExtent( QgsRectangle( 189990, 4999990, 190110, 5000110 ) );
+  mapSettings.setLayers( QList<QgsMapLayer *>() << vl2.get() );
+  mapSettings.setOutputDpi( 96 );
+
+  auto placedLabels = [&mapSettings]() -> QMap< QgsFeatureId, QgsRectangle >
+  {
+    QgsMapRendererSequentialJob job( mapSettings );
+    job.start();
+    job.waitForFinished();
+    std::unique_ptr< QgsLabelingResults > results( job.takeLabelingResults() );
+    QMap< QgsFeatureId, QgsRectangle > labels;
+    const QList< QgsLabelPosition > positions = results->labelsWithinRect( mapSettings.visibleExtent() );
+    for ( const QgsLabelPosition &position : positions )
+      labels.insert( position.featureId, position.labelRect );
+    return labels;
+  };
+
+  // the candidates and costs are calculated on the global thread pool, the
+  // placement must not depend on how many workers share the tasks
+  const int maxThreadCount = QThreadPool::globalInstance()->maxThreadCount();
+  QThreadPool::globalInstance()->setMaxThreadCount( 1 );
+  const QMap< QgsFeatureId, QgsRectangle > serial = placedLabels();
+  QThreadPool::globalInstance()->setMaxThreadCount( 8 );
+  const QMap< QgsFeatureId, QgsRectangle > parallel = placedLabels();
+  const QMap< QgsFeatureId, QgsRectangle > parallelAgain = placedLabels();
+  QThreadPool::globalInstance()->setMaxThreadCount( maxThreadCount );
+
+  QVERIFY( !serial.isEmpty() );
+  QVERIFY( serial.size() < features.size() );
+  QCOMPARE( parallel, serial );
+  QCOMPARE( parallelAgain, serial );
+}
+
 QGSTEST_MAIN( TestQgsLabelingEngine )
 #include "testqgslabelingengine.moc"
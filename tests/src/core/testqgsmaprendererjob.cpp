@@ -20,6 +20,7 @@
 #include <QTime>
 #include <QApplication>
 #include <QDesktopServices>
+#include <QThreadPool>
 
 //qgis includes...
 #include <qgsvectorlayer.h> //defines QgsFieldMap
@@ -32,6 +33,7 @@
 #include <qgsfield.h>
 #include <qgis.h> //defines GEOWkt
 #include "qgsmaprenderersequentialjob.h"
+#include "qgsmaprendererparalleljob.h"
 #include <qgsmaplayer.h>
 #include <qgsreadwritecontext.h>
 #include <qgsvectorlayer.h>
@@ -76,6 +78,9 @@ class TestQgsMapRendererJob : public QObject
     void testFourAdjacentTiles_data();
     void testFourAdjacentTiles();
 
+    //! Checks that splitting a layer into tiles rendered in parallel gives the same result
+    void testParallelLayerTiles();
+
   private:
     QString mEncoding;
     QgsVectorFileWriter::WriterError mError =  QgsVectorFileWriter::NoError ;
@@ -330,6 +335,34 @@ void TestQgsMapRendererJob::testFourAdjacentTiles()
   QVERIFY( result );
 }
 
+void TestQgsMapRendererJob::testParallelLayerTiles()
+{
+  QgsMapSettings mapSettings;
+  mapSettings.setExtent( QgsRectangle( -20, -15, 20, 15 ) );
+  mapSettings.setOutputSize( QSize( 400, 600 ) );
+  mapSettings.setLayers( QList<QgsMapLayer *>() << mpPolysLayer );
+  mapSettings.setFlag( QgsMapSettings::Antialiasing );
+
+  // layers are only split when the pool has at least two threads
+  const int maxThreadCount = QThreadPool::globalInstance()->maxThreadCount();
+  QThreadPool::globalInstance()->setMaxThreadCount( std::max( 2, maxThreadCount ) );
+
+  QgsMapRendererParallelJob job( mapSettings );
+  job.start();
+  job.waitForFinished();
+  const QImage image = job.renderedImage();
+
+  mapSettings.setFlag( QgsMapSettings::RenderLayerTilesInParallel );
+  QgsMapRendererParallelJob tiledJob( mapSettings );
+  tiledJob.start();
+  tiledJob.waitForFinished();
+  const QImage tiledImage = tiledJob.renderedImage();
+
+  QThreadPool::globalInstance()->setMaxThreadCount( maxThreadCount );
+
+  QVERIFY( tiledJob.errors().isEmpty() );
+  QCOMPARE( tiledImage, image );
+}
 
 QGSTEST_MAIN( TestQgsMapRendererJob )
 #include "testqgsmaprendererjob.moc"
@@ -17,10 +17,19 @@
 #include <QObject>
 #include <QString>
 #include <QTemporaryFile>
+#include <QTemporaryDir>
 
 #include "qgsrasterlayer.h"
 #include "qgsrasterdataprovider.h"
 #include "qgsrasteriterator.h"
+#include "qgsogrutils.h"
+
+#include <QMutex>
+#include <QSet>
+#include <QtConcurrent>
+
+#include <gdal.h>
+#include <cpl_string.h>
 
 /**
  * \ingroup UnitTests
@@ -40,6 +49,10 @@ class TestQgsRasterIterator : public QObject
 
     void testBasic();
     void testNoBlock();
+    void testAlignToSourceBlocks();
+    void testReadAhead();
+    void testParallelNext();
+    void testCopy();
 
   private:
 
@@ -353,6 +366,197 @@ void TestQgsRasterIterator::testNoBlock()
   QVERIFY( !it.next( 1, nCols, nRows, topLeftCol, topLeftRow, blockExtent ) );
 }
 
+void TestQgsRasterIterator::testAlignToSourceBlocks()
+{
+  // tiled raster with 256x256 blocks, 1 unit per pixel
+  QTemporaryDir dir;
+  const QString fileName = dir.path() + QStringLiteral( "/tiled.tif" );
+  {
+    char **options = nullptr;
+    options = CSLSetNameValue( options, "TILED", "YES" );
+    options = CSLSetNameValue( options, "BLOCKXSIZE", "256" );
+    options = CSLSetNameValue( options, "BLOCKYSIZE", "256" );
+    gdal::dataset_unique_ptr ds( GDALCreate( GDALGetDriverByName( "GTiff" ), fileName.toUtf8().constData(), 1000, 700, 1, GDT_Byte, options ) );
+    CSLDestroy( options );
+    QVERIFY( ds );
+    double geoTransform[6] = { 0, 1, 0, 700, 0, -1 };
+    GDALSetGeoTransform( ds.get(), geoTransform );
+  }
+
+  QgsRasterLayer layer( fileName, QStringLiteral( "tiled" ) );
+  QVERIFY( layer.isValid() );
+  QCOMPARE( layer.dataProvider()->xBlockSize(), 256 );
+  QCOMPARE( layer.dataProvider()->yBlockSize(), 256 );
+
+  QgsRasterIterator it( layer.dataProvider() );
+  it.setMaximumTileWidth( 600 );
+  it.setMaximumTileHeight( 600 );
+  QVERIFY( !it.alignToSourceBlocks() );
+  it.setAlignToSourceBlocks( true );
+  QVERIFY( it.alignToSourceBlocks() );
+
+  // start reading at column 100, parts end at multiples of 512 source columns
+  it.startRasterRead( 1, 900, 700, QgsRectangle( 100, 0, 1000, 700 ) );
+
+  int nCols;
+  int nRows;
+  int topLeftCol;
+  int topLeftRow;
+  QgsRectangle blockExtent;
+
+  QVERIFY( it.next( 1, nCols, nRows, topLeftCol, topLeftRow, blockExtent ) );
+  QCOMPARE( nCols, 412 );
+  QCOMPARE( nRows, 512 );
+  QCOMPARE( topLeftCol, 0 );
+  QCOMPARE( topLeftRow, 0 );
+  QCOMPARE( blockExtent, QgsRectangle( 100, 188, 512, 700 ) );
+
+  QVERIFY( it.next( 1, nCols, nRows, topLeftCol, topLeftRow, blockExtent ) );
+  QCOMPARE( nCols, 488 );
+  QCOMPARE( nRows, 512 );
+  QCOMPARE( topLeftCol, 412 );
+  QCOMPARE( topLeftRow, 0 );
+
+  QVERIFY( it.next( 1, nCols, nRows, topLeftCol, topLeftRow, blockExtent ) );
+  QCOMPARE( nCols, 412 );
+  QCOMPARE( nRows, 188 );
+  QCOMPARE( topLeftCol, 0 );
+  QCOMPARE( topLeftRow, 512 );
+
+  QVERIFY( it.next( 1, nCols, nRows, topLeftCol, topLeftRow, blockExtent ) );
+  QCOMPARE( nCols, 488 );
+  QCOMPARE( nRows, 188 );
+  QCOMPARE( topLeftCol, 412 );
+  QCOMPARE( topLeftRow, 512 );
+  QCOMPARE( blockExtent, QgsRectangle( 512, 0, 1000, 188 ) );
+
+  QVERIFY( !it.next( 1, nCols, nRows, topLeftCol, topLeftRow, blockExtent ) );
+
+  // resampled reads are not aligned
+  it.startRasterRead( 1, 450, 350, QgsRectangle( 100, 0, 1000, 700 ) );
+  QVERIFY( it.next( 1, nCols, nRows, topLeftCol, topLeftRow, blockExtent ) );
+  QCOMPARE( nCols, 450 );
+  QCOMPARE( nRows, 350 );
+
+  // without alignment the maximum tile size is used
+  it.setAlignToSourceBlocks( false );
+  it.startRasterRead( 1, 900, 700, QgsRectangle( 100, 0, 1000, 700 ) );
+  QVERIFY( it.next( 1, nCols, nRows, topLeftCol, topLeftRow, blockExtent ) );
+  QCOMPARE( nCols, 600 );
+  QCOMPARE( nRows, 600 );
+}
+
+void TestQgsRasterIterator::testReadAhead()
+{
+  QgsRasterDataProvider *provider = mpRasterLayer->dataProvider();
+  QVERIFY( provider );
+  QgsRasterIterator it( provider );
+  it.setMaximumTileHeight( 2500 );
+  it.setMaximumTileWidth( 3000 );
+  QVERIFY( !it.readAheadEnabled() );
+  it.setReadAheadEnabled( true );
+  QVERIFY( it.readAheadEnabled() );
+
+  it.startRasterRead( 1, mpRasterLayer->width(), mpRasterLayer->height(), mpRasterLayer->extent() );
+
+  int nCols;
+  int nRows;
+  int topLeftCol;
+  int topLeftRow;
+  QgsRectangle blockExtent;
+  std::unique_ptr< QgsRasterBlock > block;
+  int parts = 0;
+  while ( it.readNextRasterPart( 1, nCols, nRows, block, topLeftCol, topLeftRow, &blockExtent ) )
+  {
+    parts++;
+    QVERIFY( block.get() );
+    QVERIFY( block->isValid() );
+    QCOMPARE( block->width(), nCols );
+    QCOMPARE( block->height(), nRows );
+
+    // the block read in the background is the same as a direct read of the part
+    std::unique_ptr< QgsRasterBlock > expected( provider->block( 1, blockExtent, nCols, nRows ) );
+    QCOMPARE( block->data(), expected->data() );
+  }
+  QCOMPARE( parts, 9 );
+  QVERIFY( !block.get() );
+
+  // restarting discards the pending read
+  it.startRasterRead( 1, mpRasterLayer->width(), mpRasterLayer->height(), mpRasterLayer->extent() );
+  QVERIFY( it.readNextRasterPart( 1, nCols, nRows, block, topLeftCol, topLeftRow, &blockExtent ) );
+  it.startRasterRead( 1, mpRasterLayer->width(), mpRasterLayer->height(), mpRasterLayer->extent() );
+  QVERIFY( it.readNextRasterPart( 1, nCols, nRows, block, topLeftCol, topLeftRow, &blockExtent ) );
+  QCOMPARE( topLeftCol, 0 );
+  QCOMPARE( topLeftRow, 0 );
+  QVERIFY( block->isValid() );
+}
+
+void TestQgsRasterIterator::testParallelNext()
+{
+  QgsRasterIterator it( mpRasterLayer->dataProvider() );
+  it.setMaximumTileHeight( 500 );
+  it.setMaximumTileWidth( 500 );
+  it.startRasterRead( 1, mpRasterLayer->width(), mpRasterLayer->height(), mpRasterLayer->extent() );
+
+  // several workers take parts from the same iterator
+  QMutex mutex;
+  QSet< QPair< int, int > > parts;
+  int duplicates = 0;
+  QVector< int > workers( 4 );
+  QtConcurrent::blockingMap( workers, [&]( int & )
+  {
+    int nCols;
+    int nRows;
+    int topLeftCol;
+    int topLeftRow;
+    QgsRectangle blockExtent;
+    while ( it.next( 1, nCols, nRows, topLeftCol, topLeftRow, blockExtent ) )
+    {
+      QMutexLocker locker( &mutex );
+      if ( parts.contains( qMakePair( topLeftCol, topLeftRow ) ) )
+        duplicates++;
+      parts.insert( qMakePair( topLeftCol, topLeftRow ) );
+    }
+  } );
+
+  QCOMPARE( duplicates, 0 );
+  QCOMPARE( parts.size(), 15 * 11 );
+}
+
+void TestQgsRasterIterator::testCopy()
+{
+  QgsRasterIterator it( mpRasterLayer->dataProvider() );
+  it.setMaximumTileHeight( 500 );
+  it.setMaximumTileWidth( 500 );
+  it.startRasterRead( 1, mpRasterLayer->width(), mpRasterLayer->height(), mpRasterLayer->extent() );
+
+  int nCols;
+  int nRows;
+  int topLeftCol;
+  int topLeftRow;
+  QgsRectangle blockExtent;
+  QVERIFY( it.next( 1, nCols, nRows, topLeftCol, topLeftRow, blockExtent ) );
+
+  // the copy continues from the same position, independently of the original
+  QgsRasterIterator copy( it );
+  QCOMPARE( copy.input(), it.input() );
+  QCOMPARE( copy.maximumTileWidth(), 500 );
+  QCOMPARE( copy.maximumTileHeight(), 500 );
+  QVERIFY( copy.next( 1, nCols, nRows, topLeftCol, topLeftRow, blockExtent ) );
+  QCOMPARE( topLeftCol, 500 );
+  QCOMPARE( topLeftRow, 0 );
+  QVERIFY( copy.next( 1, nCols, nRows, topLeftCol, topLeftRow, blockExtent ) );
+  QCOMPARE( topLeftCol, 1000 );
+  QVERIFY( it.next( 1, nCols, nRows, topLeftCol, topLeftRow, blockExtent ) );
+  QCOMPARE( topLeftCol, 500 );
+
+  QgsRasterIterator assigned( nullptr );
+  assigned = copy;
+  QCOMPARE( assigned.input(), it.input() );
+  QVERIFY( assigned.next( 1, nCols, nRows, topLeftCol, topLeftRow, blockExtent ) );
+  QCOMPARE( topLeftCol, 1500 );
+}
+
 
 QGSTEST_MAIN( TestQgsRasterIterator )
 
@@ -0,0 +1,343 @@
+/***************************************************************************
+     testqgsrasterstatisticssketch.cpp
+     --------------------------------------
+    Date                 : October 2019
+    Copyright            : (C) 2019 by the QGIS project
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgstest.h"
+#include <QObject>
+#include <QString>
+#include <QTemporaryDir>
+
+#include "qgsrasterlayer.h"
+#include "qgsrasterdataprovider.h"
+#include "qgsrasterstatisticssketch.h"
+#include "qgssettings.h"
+
+#include <algorithm>
+#include <random>
+
+/**
+ * \ingroup UnitTests
+ * This is a unit test for the QgsRasterStatisticsSketch class.
+ */
+class TestQgsRasterStatisticsSketch : public QObject
+{
+    Q_OBJECT
+  public:
+    TestQgsRasterStatisticsSketch() = default;
+
+  private slots:
+    void initTestCase();// will be called before the first testfunction is executed.
+    void cleanupTestCase();// will be called after the last testfunction was executed.
+    void init() {} // will be called before each testfunction is executed.
+    void cleanup() {} // will be called after every testfunction.
+
+    void exactValues();
+    void exactCumulativeCut();
+    void approximateQuantiles();
+    void merge();
+    void serialization();
+    void cumulativeCutMatchesHistogram();
+    void notPersistedByDefault();
+    void persistedSketch();
+
+  private:
+
+    QString mTestDataDir;
+};
+
+void TestQgsRasterStatisticsSketch::initTestCase()
+{
+  // Set up the QgsSettings environment
+  QCoreApplication::setOrganizationName( QStringLiteral( "QGIS" ) );
+  QCoreApplication::setOrganizationDomain( QStringLiteral( "qgis.org" ) );
+  QCoreApplication::setApplicationName( QStringLiteral( "QGIS-TEST" ) );
+
+  QgsApplication::init();
+  QgsApplication::initQgis();
+
+  mTestDataDir = QStringLiteral( TEST_DATA_DIR ); //defined in CmakeLists.txt
+}
+
+void TestQgsRasterStatisticsSketch::cleanupTestCase()
+{
+  QgsApplication::exitQgis();
+}
+
+void TestQgsRasterStatisticsSketch::exactValues()
+{
+  QgsRasterStatisticsSketch sketch;
+  QVERIFY( std::isnan( sketch.quantile( 0.5 ) ) );
+  QVERIFY( std::isnan( sketch.minimum() ) );
+
+  // 0..99, each value ten times, and an infinite value
+  for ( int i = 0; i < 10; ++i )
+  {
+    for ( int value = 0; value < 100; ++value )
+      sketch.addValue( value );
+  }
+  sketch.addValue( std::numeric_limits<double>::infinity() );
+
+  QCOMPARE( sketch.count(), static_cast< qgssize >( 1001 ) );
+  QCOMPARE( sketch.finiteCount(), static_cast< qgssize >( 1000 ) );
+  QCOMPARE( sketch.minimum(), 0.0 );
+  QCOMPARE( sketch.maximum(), 99.0 );
+  QCOMPARE( sketch.mean(), 49.5 );
+  QVERIFY( sketch.isExact() );
+  QCOMPARE( sketch.quantile( 0 ), 0.0 );
+  QCOMPARE( sketch.quantile( 0.02 ), 1.0 );
+  QCOMPARE( sketch.quantile( 0.5 ), 49.0 );
+  QCOMPARE( sketch.quantile( 0.98 ), 97.0 );
+  QCOMPARE( sketch.quantile( 1 ), 99.0 );
+}
+
+void TestQgsRasterStatisticsSketch::exactCumulativeCut()
+{
+  double lower = 0;
+  double upper = 0;
+  QgsRasterStatisticsSketch sketch;
+  sketch.cumulativeCut( 0.02, 0.98, lower, upper );
+  QVERIFY( std::isnan( lower ) );
+  QVERIFY( std::isnan( upper ) );
+
+  // 2 x 1, 96 x 5, 2 x 9
+  for ( int i = 0; i < 2; ++i )
+    sketch.addValue( 1 );
+  for ( int i = 0; i < 96; ++i )
+    sketch.addValue( 5 );
+  for ( int i = 0; i < 2; ++i )
+    sketch.addValue( 9 );
+  QVERIFY( sketch.isExact() );
+
+  // like a histogram cut the lower count has to be exceeded, the upper count reached
+  sketch.cumulativeCut( 0.02, 0.98, lower, upper );
+  QCOMPARE( lower, 5.0 );
+  QCOMPARE( upper, 5.0 );
+  sketch.cumulativeCut( 0.01, 0.99, lower, upper );
+  QCOMPARE( lower, 1.0 );
+  QCOMPARE( upper, 9.0 );
+  sketch.cumulativeCut( 0, 1, lower, upper );
+  QCOMPARE( lower, sketch.minimum() );
+  QCOMPARE( upper, sketch.maximum() );
+}
+
+void TestQgsRasterStatisticsSketch::approximateQuantiles()
+{
+  std::mt19937 generator( 42 );
+  std::normal_distribution< double > distribution( 100, 15 );
+
+  std::vector< double > values( 200000 );
+  QgsRasterStatisticsSketch sketch;
+  for ( double &value : values )
+  {
+    value = distribution( generator );
+    sketch.addValue( value );
+  }
+  std::sort( values.begin(), values.end() );
+
+  QVERIFY( !sketch.isExact() );
+  QCOMPARE( sketch.quantile( 0 ), values.front() );
+  QCOMPARE( sketch.quantile( 1 ), values.back() );
+
+  // the rank of the estimated quantiles must be close to the requested one
+  for ( double q : { 0.001, 0.02, 0.25, 0.5, 0.75, 0.98, 0.999 } )
+  {
+    const double estimate = sketch.quantile( q );
+    const double rank = static_cast< double >( std::lower_bound( values.begin(), values.end(), estimate ) - values.begin() ) / values.size();
+    QGSCOMPARENEAR( rank, q, std::max( 0.0005, q * ( 1 - q ) * 0.02 ) );
+  }
+}
+
+void TestQgsRasterStatisticsSketch::merge()
+{
+  QgsRasterStatisticsSketch all;
+  QgsRasterStatisticsSketch first;
+  QgsRasterStatisticsSketch second;
+  for ( int i = 0; i < 50000; ++i )
+  {
+    const double value = std::fmod( i * 7919.0, 1000.0 ) / 10.0;
+    all.addValue( value );
+    if ( i < 20000 )
+      first.addValue( value );
+    else
+      second.addValue( value );
+  }
+
+  QgsRasterStatisticsSketch merged;
+  merged.merge( first );
+  merged.merge( second );
+  QCOMPARE( merged.count(), all.count() );
+  QCOMPARE( merged.sum(), all.sum() );
+  QCOMPARE( merged.minimum(), all.minimum() );
+  QCOMPARE( merged.maximum(), all.maximum() );
+  QGSCOMPARENEAR( merged.mean(), all.mean(), 1e-9 );
+  QGSCOMPARENEAR( merged.sumOfSquares(), all.sumOfSquares(), 1e-6 * all.sumOfSquares() );
+  QGSCOMPARENEAR( merged.quantile( 0.02 ), all.quantile( 0.02 ), 0.2 );
+  QGSCOMPARENEAR( merged.quantile( 0.5 ), all.quantile( 0.5 ), 0.2 );
+  QGSCOMPARENEAR( merged.quantile( 0.98 ), all.quantile( 0.98 ), 0.2 );
+}
+
+void TestQgsRasterStatisticsSketch::serialization()
+{
+  QgsRasterStatisticsSketch sketch;
+  for ( int i = 0; i < 20000; ++i )
+    sketch.addValue( std::sin( i ) * 1000 );
+
+  bool ok = false;
+  const QgsRasterStatisticsSketch restored = QgsRasterStatisticsSketch::fromString( sketch.toString(), &ok );
+  QVERIFY( ok );
+  QCOMPARE( restored.count(), sketch.count() );
+  QCOMPARE( restored.sum(), sketch.sum() );
+  QCOMPARE( restored.mean(), sketch.mean() );
+  QCOMPARE( restored.sumOfSquares(), sketch.sumOfSquares() );
+  QCOMPARE( restored.minimum(), sketch.minimum() );
+  QCOMPARE( restored.maximum(), sketch.maximum() );
+  QCOMPARE( restored.quantile( 0.1 ), sketch.quantile( 0.1 ) );
+  QCOMPARE( restored.quantile( 0.9 ), sketch.quantile( 0.9 ) );
+  QCOMPARE( restored.toString(), sketch.toString() );
+
+  QgsRasterStatisticsSketch::fromString( QStringLiteral( "not a sketch" ), &ok );
+  QVERIFY( !ok );
+  QgsRasterStatisticsSketch::fromString( sketch.toString().replace( ':', '#' ), &ok );
+  QVERIFY( !ok );
+}
+
+void TestQgsRasterStatisticsSketch::cumulativeCutMatchesHistogram()
+{
+  QgsRasterLayer layer( mTestDataDir + QStringLiteral( "/raster/band1_byte_noct_epsg4326.tif" ), QStringLiteral( "band1_byte" ) );
+  QVERIFY( layer.isValid() );
+  QgsRasterDataProvider *provider = layer.dataProvider();
+
+  const QgsRasterBandStats stats = provider->bandStatistics( 1, QgsRasterBandStats::Min | QgsRasterBandStats::Max );
+  const int binCount = static_cast< int >( stats.maximumValue - stats.minimumValue + 1 );
+  const QgsRasterHistogram histogram = provider->histogram( 1, binCount, stats.minimumValue, stats.maximumValue );
+  QCOMPARE( histogram.binCount, binCount );
+
+  const QList< QPair< double, double > > fractions
+  {
+    qMakePair( 0.0, 1.0 ),
+    qMakePair( 0.02, 0.98 ),
+    qMakePair( 0.1, 0.9 ),
+    qMakePair( 0.25, 0.75 ),
+  };
+  for ( const QPair< double, double > &fraction : fractions )
+  {
+    // the cut of a histogram with one bin per value, as calculated before statistics sketches
+    double expectedLower = std::numeric_limits<double>::quiet_NaN();
+    double expectedUpper = std::numeric_limits<double>::quiet_NaN();
+    const int lowerCount = static_cast< int >( std::round( fraction.first * histogram.nonNullCount ) );
+    const int upperCount = static_cast< int >( std::round( fraction.second * histogram.nonNullCount ) );
+    int count = 0;
+    for ( int bin = 0; bin < histogram.histogramVector.size(); ++bin )
+    {
+      count += histogram.histogramVector.at( bin );
+      if ( std::isnan( expectedLower ) && count > lowerCount )
+        expectedLower = stats.minimumValue + bin;
+      if ( count >= upperCount )
+      {
+        expectedUpper = stats.minimumValue + bin;
+        break;
+      }
+    }
+
+    double lower = 0;
+    double upper = 0;
+    provider->cumulativeCut( 1, fraction.first, fraction.second, lower, upper );
+    QCOMPARE( lower, expectedLower );
+    QCOMPARE( upper, expectedUpper );
+  }
+
+  // a full cut is the minimum and maximum
+  double lower = 0;
+  double upper = 0;
+  provider->cumulativeCut( 1, 0, 1, lower, upper );
+  QCOMPARE( lower, stats.minimumValue );
+  QCOMPARE( upper, stats.maximumValue );
+}
+
+void TestQgsRasterStatisticsSketch::notPersistedByDefault()
+{
+  QTemporaryDir dir;
+  const QString path = dir.path() + QStringLiteral( "/band1_byte.tif" );
+  QVERIFY( QFile::copy( mTestDataDir + QStringLiteral( "/raster/band1_byte_noct_epsg4326.tif" ), path ) );
+
+  QgsSettings().remove( QStringLiteral( "/Raster/persistStatisticsSketches" ) );
+  {
+    QgsRasterLayer layer( path, QStringLiteral( "band1_byte" ) );
+    QVERIFY( layer.isValid() );
+    double lower = 0;
+    double upper = 0;
+    layer.dataProvider()->cumulativeCut( 1, 0.02, 0.98, lower, upper );
+  }
+  QVERIFY( !QFile::exists( path + QStringLiteral( ".aux.xml" ) ) );
+
+  // sampled sketches never create an auxiliary file
+  QgsSettings().setValue( QStringLiteral( "/Raster/persistStatisticsSketches" ), true );
+  {
+    QgsRasterLayer layer( path, QStringLiteral( "band1_byte" ) );
+    QVERIFY( layer.isValid() );
+    double lower = 0;
+    double upper = 0;
+    layer.dataProvider()->cumulativeCut( 1, 0.02, 0.98, lower, upper, QgsRectangle(), 100 );
+  }
+  QgsSettings().remove( QStringLiteral( "/Raster/persistStatisticsSketches" ) );
+  QVERIFY( !QFile::exists( path + QStringLiteral( ".aux.xml" ) ) );
+}
+
+void TestQgsRasterStatisticsSketch::persistedSketch()
+{
+  QTemporaryDir dir;
+  const QString path = dir.path() + QStringLiteral( "/band1_byte.tif" );
+  QVERIFY( QFile::copy( mTestDataDir + QStringLiteral( "/raster/band1_byte_noct_epsg4326.tif" ), path ) );
+
+  // creating an auxiliary file is opt-in
+  QgsSettings().setValue( QStringLiteral( "/Raster/persistStatisticsSketches" ), true );
+
+  double lower = 0;
+  double upper = 0;
+  {
+    QgsRasterLayer layer( path, QStringLiteral( "band1_byte" ) );
+    QVERIFY( layer.isValid() );
+    const QgsRasterStatisticsSketch sketch = layer.dataProvider()->statisticsSketch( 1 );
+    QCOMPARE( sketch.count(), static_cast< qgssize >( layer.width() ) * layer.height() );
+    QVERIFY( sketch.isExact() );
+
+    const QgsRasterBandStats stats = layer.dataProvider()->bandStatistics( 1, QgsRasterBandStats::Min | QgsRasterBandStats::Max );
+    layer.dataProvider()->cumulativeCut( 1, 0.02, 0.98, lower, upper );
+    QVERIFY( lower >= stats.minimumValue );
+    QVERIFY( upper <= stats.maximumValue );
+    QVERIFY( lower < upper );
+  }
+  QgsSettings().remove( QStringLiteral( "/Raster/persistStatisticsSketches" ) );
+
+  // the sketch has been stored in the auxiliary file when the dataset was closed
+  QFile auxFile( path + QStringLiteral( ".aux.xml" ) );
+  QVERIFY( auxFile.open( QIODevice::ReadOnly ) );
+  QVERIFY( auxFile.readAll().contains( "STATISTICS_SKETCH_" ) );
+  auxFile.close();
+
+  {
+    QgsRasterLayer layer( path, QStringLiteral( "band1_byte" ) );
+    QVERIFY( layer.isValid() );
+
+    // a full resolution sketch can be used for estimates as well
+    double estimatedLower = 0;
+    double estimatedUpper = 0;
+    layer.dataProvider()->cumulativeCut( 1, 0.02, 0.98, estimatedLower, estimatedUpper, QgsRectangle(), 100 );
+    QCOMPARE( estimatedLower, lower );
+    QCOMPARE( estimatedUpper, upper );
+  }
+}
+
+QGSTEST_MAIN( TestQgsRasterStatisticsSketch )
+
+#include "testqgsrasterstatisticssketch.moc"
@@ -234,6 +234,80 @@ class TestQgsSpatialIndex : public QObject
       delete indexInsert;
     }
 
+    void testBoundingBoxes()
+    {
+      QVector< QPair< QgsFeatureId, QgsRectangle > > boundingBoxes;
+      const QList<QgsFeature> features = _pointFeatures();
+      for ( const QgsFeature &f : features )
+        boundingBoxes << qMakePair( f.id(), f.geometry().boundingBox() );
+      boundingBoxes << qMakePair( static_cast< QgsFeatureId >( 5 ), QgsRectangle( 0.5, 0.5, 3, 3 ) );
+
+      QgsSpatialIndex index( boundingBoxes );
+
+      QList<QgsFeatureId> fids = index.intersects( QgsRectangle( 0, 0, 10, 10 ) );
+      std::sort( fids.begin(), fids.end() );
+      QCOMPARE( fids, QList<QgsFeatureId>() << 1 << 5 );
+      fids = index.intersects( QgsRectangle( -10, -10, 0, 10 ) );
+      std::sort( fids.begin(), fids.end() );
+      QCOMPARE( fids, QList<QgsFeatureId>() << 2 << 3 );
+
+      // index can still be modified and copied after bulk loading
+      QgsFeature f = _pointFeature( 6, 2, 2 );
+      QVERIFY( index.addFeature( f ) );
+      QgsSpatialIndex copy( index );
+      f = features.at( 0 );
+      QVERIFY( copy.deleteFeature( f ) );
+      fids = copy.intersects( QgsRectangle( 0, 0, 10, 10 ) );
+      std::sort( fids.begin(), fids.end() );
+      QCOMPARE( fids, QList<QgsFeatureId>() << 5 << 6 );
+      fids = index.intersects( QgsRectangle( 0, 0, 10, 10 ) );
+      std::sort( fids.begin(), fids.end() );
+      QCOMPARE( fids, QList<QgsFeatureId>() << 1 << 5 << 6 );
+
+      // empty list
+      QgsSpatialIndex emptyIndex( ( QVector< QPair< QgsFeatureId, QgsRectangle > >() ) );
+      QVERIFY( emptyIndex.intersects( QgsRectangle( -10, -10, 10, 10 ) ).isEmpty() );
+    }
+
+    void benchmarkBulkLoadBoundingBoxes()
+    {
+      // a few thousand overlapping boxes, enough to build a multi-level tree
+      QVector< QPair< QgsFeatureId, QgsRectangle > > boundingBoxes;
+      boundingBoxes.reserve( 5000 );
+      for ( int i = 0; i < 5000; ++i )
+      {
+        const double x = ( i * 7919 ) % 200;
+        const double y = ( i * 104729 ) % 100;
+        boundingBoxes << qMakePair( static_cast< QgsFeatureId >( i ), QgsRectangle( x, y, x + 1.5, y + 1.5 ) );
+      }
+
+      QTime t;
+      t.start();
+      QgsSpatialIndex indexBulk( boundingBoxes );
+      qDebug( "bulk load: %d ms", t.elapsed() );
+
+      t.start();
+      QgsSpatialIndex indexInsert;
+      for ( const QPair< QgsFeatureId, QgsRectangle > &boundingBox : qgis::as_const( boundingBoxes ) )
+        indexInsert.addFeature( boundingBox.first, boundingBox.second );
+      qDebug( "insert:    %d ms", t.elapsed() );
+
+      // both trees must give the same results, in a different order
+      const QgsRectangle rect( 10.2, 10.2, 12.3, 12.3 );
+      QList<QgsFeatureId> resBulk = indexBulk.intersects( rect );
+      QList<QgsFeatureId> resInsert = indexInsert.intersects( rect );
+      QVERIFY( !resBulk.isEmpty() );
+      std::sort( resBulk.begin(), resBulk.end() );
+      std::sort( resInsert.begin(), resInsert.end() );
+      QCOMPARE( resBulk, resInsert );
+
+      QBENCHMARK
+      {
+        for ( int i = 0; i < 1000; ++i )
+          indexBulk.intersects( QgsRectangle( i % 200, i % 100, i % 200 + 5, i % 100 + 5 ) );
+      }
+    }
+
     void testRetrieveGeometries()
     {
       QgsVectorLayer *vl = new QgsVectorLayer( QStringLiteral( "LineString" ), QStringLiteral( "x" ), QStringLiteral( "memory" ) );
@@ -24,6 +24,7 @@
 #include <QPainter>
 #include <QtConcurrent>
 #include <QElapsedTimer>
+#include <numeric>
 #include "qgssvgcache.h"
 #include "qgsmultirenderchecker.h"
 #include "qgsapplication.h"
@@ -50,6 +51,8 @@ class TestQgsSvgCache : public QObject
     void fillCache();
     void threadSafePicture();
     void threadSafeImage();
+    void threadSafeSizeAccounting();
+    void trimAcrossShards();
     void changeImage(); //check that cache is updated if svg source file changes
     void base64();
 
@@ -175,6 +178,69 @@ void TestQgsSvgCache::threadSafeImage()
   QtConcurrent::blockingMap( list, RenderImageWrapper( cache, svgPath ) );
 }
 
+struct RenderVariantsWrapper
+{
+  QgsSvgCache &cache;
+  QString svgPath;
+  explicit RenderVariantsWrapper( QgsSvgCache &cache, const QString &svgPath )
+    : cache( cache )
+    , svgPath( svgPath )
+  {}
+  void operator()( int i )
+  {
+    bool fitsInCache = false;
+    const double size = 20 + ( i % 40 ) * 10;
+    cache.svgAsImage( svgPath, size, QColor( 255, i % 3 * 100, 0 ), QColor( 0, 255, 0 ), 1, 1, fitsInCache );
+  }
+};
+
+void TestQgsSvgCache::threadSafeSizeAccounting()
+{
+  // renders many variants of an svg concurrently, so that entries are spread over
+  // all shards of the cache, and checks that the cached sizes are accounted correctly
+  QgsSvgCache cache;
+  QString svgPath = TEST_DATA_DIR + QStringLiteral( "/sample_svg.svg" );
+
+  QVector< int > list;
+  list.resize( 400 );
+  std::iota( list.begin(), list.end(), 0 );
+  QtConcurrent::blockingMap( list, RenderVariantsWrapper( cache, svgPath ) );
+
+  qint64 totalSize = 0;
+  int entryCount = 0;
+  for ( const auto &shard : cache.mShards )
+  {
+    long shardSize = 0;
+    for ( const QgsSvgCacheEntry *entry : shard.entryLookup )
+    {
+      shardSize += entry->dataSize();
+      entryCount++;
+    }
+    QCOMPARE( shard.totalSize, shardSize );
+    totalSize += shardSize;
+  }
+  QCOMPARE( cache.mTotalSize.load(), totalSize );
+  QVERIFY( entryCount > 0 );
+}
+
+void TestQgsSvgCache::trimAcrossShards()
+{
+  // entries of different sizes are spread over the shards, the total size must still stay
+  // within the limit when the shard of a new entry cannot be trimmed any further
+  QgsSvgCache cache;
+  cache.mMaxCacheSize = 2000000;
+  QString svgPath = TEST_DATA_DIR + QStringLiteral( "/sample_svg.svg" );
+
+  for ( int size = 100; size < 150; ++size )
+  {
+    bool fitsInCache = false;
+    const QImage image = cache.svgAsImage( svgPath, size, QColor( 255, 0, 0 ), QColor( 0, 255, 0 ), 1, 1, fitsInCache );
+    QVERIFY( fitsInCache );
+    QVERIFY( !image.isNull() );
+    QVERIFY( cache.mTotalSize.load() <= cache.mMaxCacheSize );
+  }
+}
+
 void TestQgsSvgCache::changeImage()
 {
   bool inCache;
@@ -0,0 +1,148 @@
+/***************************************************************************
+     testqgstextlayoutcache.cpp
+     --------------------------------------
+    Date                 : October 2019
+    Copyright            : (C) 2019 by the QGIS project
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgstest.h"
+#include <QObject>
+#include <QFontMetricsF>
+#include <QThread>
+#include <QtConcurrentMap>
+
+#include "qgsapplication.h"
+#include "qgsfontutils.h"
+#include "qgsruntimeprofiler.h"
+#include "qgstextlayoutcache.h"
+
+/**
+ * \ingroup UnitTests
+ * This is a unit test for the QgsTextLayoutCache class.
+ */
+class TestQgsTextLayoutCache : public QObject
+{
+    Q_OBJECT
+  public:
+    TestQgsTextLayoutCache() = default;
+
+  private slots:
+    void initTestCase();// will be called before the first testfunction is executed.
+    void cleanupTestCase();// will be called after the last testfunction was executed.
+    void init() {} // will be called before each testfunction is executed.
+    void cleanup() {} // will be called after every testfunction.
+
+    void widths();
+    void paths();
+    void threads();
+    void profilerCounters();
+
+  private:
+
+    QFont mFont;
+};
+
+void TestQgsTextLayoutCache::initTestCase()
+{
+  QgsApplication::init();
+  QgsApplication::initQgis();
+  QgsFontUtils::loadStandardTestFonts( QStringList() << QStringLiteral( "Bold" ) );
+
+  mFont = QgsFontUtils::getStandardTestFont( QStringLiteral( "Bold" ) );
+  mFont.setPixelSize( 20 );
+}
+
+void TestQgsTextLayoutCache::cleanupTestCase()
+{
+  QgsApplication::exitQgis();
+}
+
+void TestQgsTextLayoutCache::widths()
+{
+  QgsTextLayoutCache cache;
+  const QFontMetricsF fm( mFont );
+  QCOMPARE( cache.textWidth( mFont, QStringLiteral( "Main Street" ) ), fm.width( QStringLiteral( "Main Street" ) ) );
+  QCOMPARE( cache.hits(), 0LL );
+  QCOMPARE( cache.misses(), 1LL );
+
+  QCOMPARE( cache.textWidth( mFont, QStringLiteral( "Main Street" ) ), fm.width( QStringLiteral( "Main Street" ) ) );
+  QCOMPARE( cache.hits(), 1LL );
+
+  // any change to the font is a different entry
+  QFont spaced = mFont;
+  spaced.setLetterSpacing( QFont::AbsoluteSpacing, 5 );
+  QCOMPARE( cache.textWidth( spaced, QStringLiteral( "Main Street" ) ), QFontMetricsF( spaced ).width( QStringLiteral( "Main Street" ) ) );
+  QVERIFY( cache.textWidth( spaced, QStringLiteral( "Main Street" ) ) > cache.textWidth( mFont, QStringLiteral( "Main Street" ) ) );
+  QFont larger = mFont;
+  larger.setPixelSize( 30 );
+  QCOMPARE( cache.textWidth( larger, QStringLiteral( "Main Street" ) ), QFontMetricsF( larger ).width( QStringLiteral( "Main Street" ) ) );
+
+  cache.clear();
+  QCOMPARE( cache.hits(), 0LL );
+  QCOMPARE( cache.misses(), 0LL );
+}
+
+void TestQgsTextLayoutCache::paths()
+{
+  QgsTextLayoutCache cache;
+  QPainterPath expected;
+  expected.setFillRule( Qt::WindingFill );
+  expected.addText( 0, 0, mFont, QStringLiteral( "Main Street" ) );
+
+  const QPainterPath first = cache.textPath( mFont, QStringLiteral( "Main Street" ) );
+  QCOMPARE( first, expected );
+  QCOMPARE( first.fillRule(), Qt::WindingFill );
+
+  const QPainterPath second = cache.textPath( mFont, QStringLiteral( "Main Street" ) );
+  QCOMPARE( second, expected );
+  QCOMPARE( cache.hits(), 1LL );
+
+  QVERIFY( cache.textPath( mFont, QStringLiteral( "Side Street" ) ) != expected );
+  QVERIFY( cache.textPath( mFont, QString() ).isEmpty() );
+}
+
+void TestQgsTextLayoutCache::threads()
+{
+  QgsTextLayoutCache cache;
+  QStringList texts;
+  for ( int i = 0; i < 2000; ++i )
+    texts << QStringLiteral( "Street %1" ).arg( i % 50 );
+
+  const QFont font = mFont;
+  QtConcurrent::blockingMap( texts, [&cache, font]( const QString & text )
+  {
+    cache.textWidth( font, text );
+    cache.textPath( font, text ).boundingRect();
+  } );
+
+  QCOMPARE( cache.hits() + cache.misses(), 4000LL );
+  QVERIFY( cache.hits() >= 4000 - 2 * QThread::idealThreadCount() * 50 );
+  QCOMPARE( cache.textWidth( mFont, QStringLiteral( "Street 7" ) ), QFontMetricsF( mFont ).width( QStringLiteral( "Street 7" ) ) );
+}
+
+void TestQgsTextLayoutCache::profilerCounters()
+{
+  QgsTextLayoutCache cache;
+  cache.textWidth( mFont, QStringLiteral( "a" ) );
+  cache.textWidth( mFont, QStringLiteral( "a" ) );
+  cache.textWidth( mFont, QStringLiteral( "a" ) );
+  cache.textWidth( mFont, QStringLiteral( "b" ) );
+
+  QgsRuntimeProfiler profiler;
+  cache.updateProfilerCounters( &profiler );
+  QCOMPARE( profiler.counter( QStringLiteral( "Text layout cache/hits" ) ), 2.0 );
+  QCOMPARE( profiler.counter( QStringLiteral( "Text layout cache/misses" ) ), 2.0 );
+  QCOMPARE( profiler.counter( QStringLiteral( "Text layout cache/hit rate" ) ), 0.5 );
+  QVERIFY( profiler.counterNames().contains( QStringLiteral( "Text layout cache/hit rate" ) ) );
+  QCOMPARE( profiler.counter( QStringLiteral( "not set" ) ), 0.0 );
+}
+
+QGSTEST_MAIN( TestQgsTextLayoutCache )
+#include "testqgstextlayoutcache.moc"
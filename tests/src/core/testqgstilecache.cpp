@@ -0,0 +1,179 @@
+/***************************************************************************
+     testqgstilecache.cpp
+     --------------------------------------
+    Date                 : October 2019
+    Copyright            : (C) 2019 by the QGIS project
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgstest.h"
+#include <QBuffer>
+#include <QColor>
+#include <QDateTime>
+#include <QImage>
+#include <QObject>
+#include <QTemporaryDir>
+#include <QUrl>
+
+#include "qgsapplication.h"
+#include "qgsnetworkaccessmanager.h"
+#include "qgsnetworkdiskcache.h"
+#include "qgstilecache.h"
+
+/**
+ * \ingroup UnitTests
+ * This is a unit test for the QgsTileCache class.
+ */
+class TestQgsTileCache : public QObject
+{
+    Q_OBJECT
+  public:
+    TestQgsTileCache() = default;
+
+  private slots:
+    void initTestCase();// will be called before the first testfunction is executed.
+    void cleanupTestCase();// will be called after the last testfunction was executed.
+    void init() {} // will be called before each testfunction is executed.
+    void cleanup() {} // will be called after every testfunction.
+
+    void evictionBySize();
+    void expiredTile();
+
+  private:
+
+    //! Stores \a image as PNG in the network disk cache for \a url, expiring at \a expiration
+    bool insertIntoDiskCache( const QUrl &url, const QImage &image, const QDateTime &expiration );
+
+    QTemporaryDir mCacheDir;
+    QString mPreviousCacheDir;
+};
+
+void TestQgsTileCache::initTestCase()
+{
+  QgsApplication::init();
+  QgsApplication::initQgis();
+
+  // use an empty disk cache
+  QVERIFY( mCacheDir.isValid() );
+  QgsNetworkDiskCache *diskCache = qobject_cast< QgsNetworkDiskCache * >( QgsNetworkAccessManager::instance()->cache() );
+  QVERIFY( diskCache );
+  mPreviousCacheDir = diskCache->cacheDirectory();
+  diskCache->setCacheDirectory( mCacheDir.path() );
+}
+
+void TestQgsTileCache::cleanupTestCase()
+{
+  QgsNetworkDiskCache *diskCache = qobject_cast< QgsNetworkDiskCache * >( QgsNetworkAccessManager::instance()->cache() );
+  if ( diskCache )
+    diskCache->setCacheDirectory( mPreviousCacheDir );
+
+  QgsApplication::exitQgis();
+}
+
+bool TestQgsTileCache::insertIntoDiskCache( const QUrl &url, const QImage &image, const QDateTime &expiration )
+{
+  QByteArray data;
+  QBuffer buffer( &data );
+  buffer.open( QIODevice::WriteOnly );
+  if ( !image.save( &buffer, "PNG" ) )
+    return false;
+
+  QNetworkCacheMetaData metaData;
+  metaData.setUrl( url );
+  metaData.setSaveToDisk( true );
+  metaData.setLastModified( QDateTime::currentDateTimeUtc().addDays( -1 ) );
+  metaData.setExpirationDate( expiration );
+
+  QAbstractNetworkCache *diskCache = QgsNetworkAccessManager::instance()->cache();
+  QIODevice *device = diskCache->prepare( metaData );
+  if ( !device )
+    return false;
+  device->write( data );
+  diskCache->insert( device );
+  return true;
+}
+
+void TestQgsTileCache::evictionBySize()
+{
+  const int previousMaxCost = QgsTileCache::maxCost();
+
+  // a 256x256 ARGB32 tile costs 256 KiB
+  QImage tile( 256, 256, QImage::Format_ARGB32 );
+  tile.fill( Qt::red );
+
+  QgsTileCache::setMaxCost( 600 );
+  QCOMPARE( QgsTileCache::maxCost(), 600 );
+
+  const QUrl url1( QStringLiteral( "http://localhost/tiles/eviction/1.png" ) );
+  const QUrl url2( QStringLiteral( "http://localhost/tiles/eviction/2.png" ) );
+  const QUrl url3( QStringLiteral( "http://localhost/tiles/eviction/3.png" ) );
+  QgsTileCache::insertTile( url1, tile );
+  QgsTileCache::insertTile( url2, tile );
+  QCOMPARE( QgsTileCache::totalCost(), 512 );
+
+  QImage image;
+  QVERIFY( QgsTileCache::tile( url1, image ) );
+  QCOMPARE( image.size(), tile.size() );
+  QVERIFY( QgsTileCache::tile( url2, image ) );
+
+  // the third tile exceeds the size, the least recently used one is evicted
+  QgsTileCache::insertTile( url3, tile );
+  QCOMPARE( QgsTileCache::totalCost(), 512 );
+  QVERIFY( !QgsTileCache::tile( url1, image ) );
+  QVERIFY( QgsTileCache::tile( url2, image ) );
+  QVERIFY( QgsTileCache::tile( url3, image ) );
+
+  // many small tiles fit where few large ones do
+  // a 16x16 ARGB32 tile costs 1 KiB
+  QImage smallTile( 16, 16, QImage::Format_ARGB32 );
+  smallTile.fill( Qt::blue );
+  QgsTileCache::setMaxCost( 100 );
+  QVERIFY( QgsTileCache::totalCost() <= 100 );
+  for ( int i = 0; i < 100; ++i )
+    QgsTileCache::insertTile( QUrl( QStringLiteral( "http://localhost/tiles/eviction/small/%1.png" ).arg( i ) ), smallTile );
+  QCOMPARE( QgsTileCache::totalCost(), 100 );
+  QVERIFY( QgsTileCache::tile( QUrl( QStringLiteral( "http://localhost/tiles/eviction/small/0.png" ) ), image ) );
+  QVERIFY( QgsTileCache::tile( QUrl( QStringLiteral( "http://localhost/tiles/eviction/small/99.png" ) ), image ) );
+
+  // a tile larger than the cache is not kept
+  QgsTileCache::insertTile( url1, tile );
+  QVERIFY( !QgsTileCache::tile( url1, image ) );
+
+  QgsTileCache::setMaxCost( previousMaxCost );
+}
+
+void TestQgsTileCache::expiredTile()
+{
+  QImage tile( 256, 256, QImage::Format_ARGB32 );
+  tile.fill( Qt::green );
+  QImage image;
+
+  // a tile in the disk cache which has not expired is read and decoded on request
+  const QUrl freshUrl( QStringLiteral( "http://localhost/tiles/expiry/fresh.png" ) );
+  QVERIFY( insertIntoDiskCache( freshUrl, tile, QDateTime::currentDateTimeUtc().addDays( 1 ) ) );
+  QVERIFY( QgsTileCache::tile( freshUrl, image ) );
+  QCOMPARE( image.size(), tile.size() );
+  QCOMPARE( image.pixelColor( 0, 0 ), QColor( Qt::green ) );
+
+  // an expired tile is a cache miss, so that it is fetched again from the server
+  const QUrl expiredUrl( QStringLiteral( "http://localhost/tiles/expiry/expired.png" ) );
+  QVERIFY( insertIntoDiskCache( expiredUrl, tile, QDateTime::currentDateTimeUtc().addDays( -1 ) ) );
+  QVERIFY( QgsNetworkAccessManager::instance()->cache()->metaData( expiredUrl ).isValid() );
+  QVERIFY( !QgsTileCache::tile( expiredUrl, image ) );
+
+  // once fetched again, the updated tile is served
+  QImage refetched( 256, 256, QImage::Format_ARGB32 );
+  refetched.fill( Qt::blue );
+  QVERIFY( insertIntoDiskCache( expiredUrl, refetched, QDateTime::currentDateTimeUtc().addDays( 1 ) ) );
+  QVERIFY( QgsTileCache::tile( expiredUrl, image ) );
+  QCOMPARE( image.pixelColor( 0, 0 ), QColor( Qt::blue ) );
+}
+
+QGSTEST_MAIN( TestQgsTileCache )
+#include "testqgstilecache.moc"
@@ -57,6 +57,7 @@ class TestQgsMapCanvas : public QObject
     void testScaleLockCanvasResize();
     void testZoomByWheel();
     void testShiftZoom();
+    void testParallelRendering();
 
   private:
     QgsMapCanvas *mCanvas = nullptr;
@@ -431,5 +432,17 @@ void TestQgsMapCanvas::testShiftZoom()
   QGSCOMPARENEAR( mCanvas->extent().height(), originalHeight, 0.00001 );
 }
 
+void TestQgsMapCanvas::testParallelRendering()
+{
+  // parallel rendering also splits heavy layers into tiles
+  mCanvas->setParallelRenderingEnabled( true );
+  QVERIFY( mCanvas->isParallelRenderingEnabled() );
+  QVERIFY( mCanvas->mapSettings().testFlag( QgsMapSettings::RenderLayerTilesInParallel ) );
+
+  mCanvas->setParallelRenderingEnabled( false );
+  QVERIFY( !mCanvas->isParallelRenderingEnabled() );
+  QVERIFY( !mCanvas->mapSettings().testFlag( QgsMapSettings::RenderLayerTilesInParallel ) );
+}
+
 QGSTEST_MAIN( TestQgsMapCanvas )
 #include "testqgsmapcanvas.moc"
@@ -115,18 +115,6 @@ class TestPyQgsMemoryProvider(unittest.TestCase, ProviderTestCase):
     def getEditableLayer(self):
         return self.createLayer()
 
-    def testGetFeaturesSubsetAttributes2(self):
-        """ Override and skip this test for memory provider, as it's actually more efficient for the memory provider to return
-        its features as direct copies (due to implicit sharing of QgsFeature)
-        """
-        pass
-
-    def testGetFeaturesNoGeometry(self):
-        """ Override and skip this test for memory provider, as it's actually more efficient for the memory provider to return
-        its features as direct copies (due to implicit sharing of QgsFeature)
-        """
-        pass
-
     def testCtors(self):
         testVectors = ["Point", "LineString", "Polygon", "MultiPoint", "MultiLineString", "MultiPolygon", "None"]
         for v in testVectors:
@@ -643,6 +631,64 @@ class TestPyQgsMemoryProvider(unittest.TestCase, ProviderTestCase):
 
         self.assertEqual([f.attributes() for f in dp.getFeatures()], [[1, True, NULL], [2, False, NULL], [3, NULL, NULL], [2, NULL, True]])
 
+    def testStorage(self):
+        """ Test features survive the round trip through the columnar storage """
+        vl = QgsVectorLayer(
+            'LineString?crs=epsg:4326&field=i:integer&field=l:int8&field=d:double&field=s:string',
+            'test', 'memory')
+        self.assertTrue(vl.isValid())
+        dp = vl.dataProvider()
+
+        f1 = QgsFeature()
+        f1.setAttributes([1, 10000000000, 1.5, 'a'])
+        f1.setGeometry(QgsGeometry.fromWkt('LineString (1 2, 3 4)'))
+        f2 = QgsFeature()
+        f2.setAttributes([NULL, NULL, NULL, NULL])
+        f3 = QgsFeature()
+        # values which don't match the field type are kept as they are
+        f3.setAttributes(['x', 2.5, 'y', 3])
+        f3.setGeometry(QgsGeometry.fromWkt('CompoundCurveZ ((0 0 1, 1 1 2))'))
+        res, [f1, f2, f3] = dp.addFeatures([f1, f2, f3])
+        self.assertTrue(res)
+
+        features = {f.id(): f for f in dp.getFeatures()}
+        self.assertEqual(features[f1.id()].attributes(), [1, 10000000000, 1.5, 'a'])
+        self.assertEqual(features[f1.id()].geometry().asWkt(), 'LineString (1 2, 3 4)')
+        self.assertEqual(features[f2.id()].attributes(), [NULL, NULL, NULL, NULL])
+        self.assertFalse(features[f2.id()].hasGeometry())
+        self.assertEqual(features[f3.id()].attributes(), ['x', 2.5, 'y', 3])
+        self.assertEqual(features[f3.id()].geometry().asWkt(), 'CompoundCurveZ ((0 0 1, 1 1 2))')
+        self.assertEqual(dp.extent(), QgsRectangle(0, 0, 3, 4))
+
+        # modify features
+        self.assertTrue(dp.changeGeometryValues({f1.id(): QgsGeometry.fromWkt('LineString (5 5, 6 6)'),
+                                                 f2.id(): QgsGeometry.fromWkt('LineString (7 7, 8 8)')}))
+        self.assertTrue(dp.changeAttributeValues({f2.id(): {0: 5, 3: 'b'}}))
+        self.assertTrue(dp.deleteFeatures([f3.id()]))
+        self.assertTrue(dp.addAttributes([QgsField('new', QVariant.Int)]))
+        self.assertTrue(dp.deleteAttributes([1]))
+
+        features = {f.id(): f for f in dp.getFeatures()}
+        self.assertEqual(list(features.keys()), [f1.id(), f2.id()])
+        self.assertEqual(features[f1.id()].attributes(), [1, 1.5, 'a', NULL])
+        self.assertEqual(features[f1.id()].geometry().asWkt(), 'LineString (5 5, 6 6)')
+        self.assertEqual(features[f2.id()].attributes(), [5, NULL, 'b', NULL])
+        self.assertEqual(features[f2.id()].geometry().asWkt(), 'LineString (7 7, 8 8)')
+        self.assertEqual(dp.extent(), QgsRectangle(5, 5, 8, 8))
+
+        # only requested parts are returned
+        f = next(dp.getFeatures(QgsFeatureRequest(f2.id()).setSubsetOfAttributes([2]).setFlags(QgsFeatureRequest.NoGeometry)))
+        self.assertEqual(f.attributes(), [NULL, NULL, 'b', NULL])
+        self.assertFalse(f.hasGeometry())
+
+        # ids are not reused after truncating
+        self.assertTrue(dp.truncate())
+        self.assertEqual(dp.featureCount(), 0)
+        res, [f4] = dp.addFeatures([QgsFeature()])
+        self.assertTrue(res)
+        self.assertEqual(f4.id(), f3.id() + 1)
+        self.assertEqual([f.id() for f in dp.getFeatures()], [f4.id()])
+
 
 class TestPyQgsMemoryProviderIndexed(unittest.TestCase, ProviderTestCase):
 
@@ -705,18 +751,6 @@ class TestPyQgsMemoryProviderIndexed(unittest.TestCase, ProviderTestCase):
     def tearDownClass(cls):
         """Run after all tests"""
 
-    def testGetFeaturesSubsetAttributes2(self):
-        """ Override and skip this test for memory provider, as it's actually more efficient for the memory provider to return
-        its features as direct copies (due to implicit sharing of QgsFeature)
-        """
-        pass
-
-    def testGetFeaturesNoGeometry(self):
-        """ Override and skip this test for memory provider, as it's actually more efficient for the memory provider to return
-        its features as direct copies (due to implicit sharing of QgsFeature)
-        """
-        pass
-
 
 if __name__ == '__main__':
     unittest.main()
@@ -32,6 +32,7 @@ from qgis.core import (
     QgsFeature,
     QgsFieldConstraints,
     QgsDataProvider,
+    QgsDataSourceUri,
     NULL,
     QgsVectorLayerUtils,
     QgsSettings,
@@ -969,6 +970,64 @@ class TestPyQgsPostgresProvider(unittest.TestCase, ProviderTestCase):
         self.assertEqual(f['f2'], 123.456)
         self.assertEqual(f['f3'], '12345678.90123456789')
 
+    def testBinaryAttributes(self):
+        self.execSQLCommand('DROP TABLE IF EXISTS qgis_test.binary_attributes CASCADE')
+        self.execSQLCommand('CREATE TABLE qgis_test.binary_attributes (pk SERIAL NOT NULL PRIMARY KEY, '
+                            'i2 int2, i4 int4, i8 int8, f4 float4, f8 float8, n numeric, n2 numeric(10,3), '
+                            'b bool, d date, ts timestamp without time zone, ba bytea, t text)')
+        self.execSQLCommand("INSERT INTO qgis_test.binary_attributes (i2, i4, i8, f4, f8, n, n2, b, d, ts, ba, t) VALUES "
+                            "(-32768, 2147483647, -9223372036854775807, 1.1, 123.456, -12345678.90123, 0.001, true, "
+                            "'2004-03-04', '2004-03-04 13:41:52.123', 'binvalue', 'qgis'), "
+                            "(NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL), "
+                            "(7, -7, 70000000000, -0.5, -1e-300, 'NaN', 12345.678, false, "
+                            "'1999-12-31', '1999-12-31 23:59:59.999', '', '')")
+
+        def attributes(uri):
+            vl = QgsVectorLayer(uri, 'test', 'postgres')
+            self.assertTrue(vl.isValid())
+            return {f['pk']: f.attributes() for f in vl.getFeatures()}
+
+        uri = '{} sslmode=disable key=\'pk\' table="qgis_test"."binary_attributes" sql='.format(self.dbconn)
+        binary_uri = QgsDataSourceUri(uri)
+        binary_uri.setParam('binaryAttributes', '1')
+        binary_uri = binary_uri.uri(False)
+
+        # the option must reach the provider and not end up in the subset string
+        vl = QgsVectorLayer(binary_uri, 'test', 'postgres')
+        self.assertTrue(vl.isValid())
+        self.assertEqual(vl.subsetString(), '')
+        self.assertEqual(vl.dataProvider().uri().param('binaryAttributes'), '1')
+        self.assertFalse(QgsVectorLayer(uri, 'test', 'postgres').dataProvider().uri().hasParam('binaryAttributes'))
+
+        text = attributes(uri)
+        binary = attributes(binary_uri)
+        self.assertEqual(binary.keys(), text.keys())
+        for pk in text:
+            for text_value, binary_value in zip(text[pk], binary[pk]):
+                if text_value != text_value:
+                    # NaN
+                    self.assertNotEqual(binary_value, binary_value)
+                else:
+                    self.assertEqual(binary_value, text_value)
+
+        # a subset of attributes must keep the columns in step
+        request = QgsFeatureRequest().setSubsetOfAttributes(['d', 't'], vl.fields())
+        values = {f['pk']: (f['d'], f['t']) for f in vl.getFeatures(request)}
+        self.assertEqual(values[1], (QDate(2004, 3, 4), 'qgis'))
+        self.assertEqual(values[2], (NULL, NULL))
+
+        # numeric infinity is only supported since PostgreSQL 14
+        cur = self.con.cursor()
+        cur.execute('SHOW server_version_num')
+        server_version = int(cur.fetchone()[0])
+        cur.close()
+        if server_version >= 140000:
+            self.execSQLCommand("INSERT INTO qgis_test.binary_attributes (pk, n) VALUES (4, 'Infinity'), (5, '-Infinity')")
+            binary = attributes(binary_uri)
+            n = vl.fields().lookupField('n')
+            self.assertEqual(binary[4][n], float('inf'))
+            self.assertEqual(binary[5][n], float('-inf'))
+
     # See https://github.com/qgis/QGIS/issues/23163
     def testImportKey(self):
         uri = 'point?field=f1:int'
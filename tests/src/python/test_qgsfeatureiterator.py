@@ -61,6 +61,39 @@ class TestQgsFeatureIterator(unittest.TestCase):
         myMessage = '\nExpected: {0} features\nGot: {1} features'.format(repr(expectedIds), repr(ids))
         assert ids == expectedIds, myMessage
 
+    def test_FilterExpressionOnVirtualField(self):
+        # the provider cannot filter on a virtual field, so the filter is evaluated by the
+        # vector layer iterator for blocks of features
+        layer = QgsVectorLayer('Point?field=x:integer', 'layer', 'memory')
+        features = []
+        for i in range(1000):
+            f = QgsFeature(layer.fields())
+            f.setAttributes([i])
+            features.append(f)
+        self.assertTrue(layer.dataProvider().addFeatures(features))
+        layer.addExpressionField('"x" * 2', QgsField('double_x', QVariant.Int))
+
+        request = QgsFeatureRequest().setFilterExpression('"double_x" > 500 and "x" % 3 = 0')
+        values = [f['x'] for f in layer.getFeatures(request)]
+        self.assertEqual(values, [x for x in range(251, 1000) if x % 3 == 0])
+
+        # with a limit
+        request.setLimit(5)
+        self.assertEqual([f['x'] for f in layer.getFeatures(request)], [252, 255, 258, 261, 264])
+
+        # rewind returns the same features again
+        it = layer.getFeatures(QgsFeatureRequest().setFilterExpression('"double_x" >= 1990'))
+        self.assertEqual([f['x'] for f in it], [995, 996, 997, 998, 999])
+        self.assertTrue(it.rewind())
+        self.assertEqual([f['x'] for f in it], [995, 996, 997, 998, 999])
+
+        # uncommitted changes are filtered too
+        layer.startEditing()
+        self.assertTrue(layer.changeAttributeValue(next(layer.getFeatures(QgsFeatureRequest().setFilterExpression('"x" = 10'))).id(), 0, 2000))
+        values = [f['x'] for f in layer.getFeatures(QgsFeatureRequest().setFilterExpression('"double_x" >= 1990'))]
+        self.assertEqual(sorted(values), [995, 996, 997, 998, 999, 2000])
+        layer.rollBack()
+
     def test_FilterExpressionWithAccents(self):
         myShpFile = os.path.join(TEST_DATA_DIR, 'france_parts.shp')
         layer = QgsVectorLayer(myShpFile, 'poly', 'ogr')
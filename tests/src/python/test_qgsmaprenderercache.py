@@ -15,10 +15,13 @@ import qgis  # NOQA
 from qgis.core import (QgsMapRendererCache,
                        QgsRectangle,
                        QgsVectorLayer,
-                       QgsProject)
+                       QgsProject,
+                       QgsFeature,
+                       QgsGeometry,
+                       QgsPointXY)
 from qgis.testing import start_app, unittest
-from qgis.PyQt.QtCore import QCoreApplication
-from qgis.PyQt.QtGui import QImage
+from qgis.PyQt.QtCore import QCoreApplication, QRect
+from qgis.PyQt.QtGui import QImage, QColor
 from time import sleep
 start_app()
 
@@ -95,6 +98,121 @@ class TestQgsMapRendererCache(unittest.TestCase):
         self.assertTrue(cache.cacheImage('layer').isNull())
         self.assertFalse(cache.hasCacheImage('layer'))
 
+    def testPannedCacheImage(self):
+        cache = QgsMapRendererCache()
+        # 10 map units per pixel
+        self.assertFalse(cache.init(QgsRectangle(0, 0, 1000, 1000), 1000))
+
+        im = QImage(100, 100, QImage.Format_ARGB32)
+        im.fill(QColor(255, 0, 0))
+        cache.setCacheImage('layer', im)
+        # no pan, nothing to shift
+        panned, reused = cache.pannedCacheImage('layer')
+        self.assertEqual(reused, QRect(0, 0, 100, 100))
+        self.assertEqual(panned.pixelColor(50, 50).name(), '#ff0000')
+
+        # pan right and down by 10 and 20 pixels
+        self.assertFalse(cache.init(QgsRectangle(100, -200, 1100, 800), 1000))
+        # image does not match the current extent anymore...
+        self.assertFalse(cache.hasCacheImage('layer'))
+        self.assertTrue(cache.cacheImage('layer').isNull())
+        # ...but can be reused after shifting it
+        panned, reused = cache.pannedCacheImage('layer')
+        self.assertEqual(reused, QRect(0, 0, 90, 80))
+        self.assertEqual(panned.size(), im.size())
+        self.assertEqual(panned.pixelColor(5, 50).name(), '#ff0000')
+        self.assertEqual(panned.pixelColor(95, 50).alpha(), 0)
+        self.assertEqual(panned.pixelColor(50, 90).alpha(), 0)
+        self.assertTrue(cache.pannedCacheImage('bad')[0].isNull())
+
+        # not a whole number of pixels
+        self.assertFalse(cache.init(QgsRectangle(105, -200, 1105, 800), 1000))
+        self.assertTrue(cache.pannedCacheImage('layer')[0].isNull())
+
+        # no overlap with the previous render
+        self.assertFalse(cache.init(QgsRectangle(5000, 0, 6000, 1000), 1000))
+        self.assertTrue(cache.pannedCacheImage('layer')[0].isNull())
+
+        # different scale clears the cache
+        self.assertFalse(cache.init(QgsRectangle(100, -200, 1100, 800), 2000))
+        self.assertTrue(cache.pannedCacheImage('layer')[0].isNull())
+
+    def testEditedArea(self):
+        """ test that edits only mark the area of the edited features as out of date """
+        layer = QgsVectorLayer("Point?field=fldtxt:string",
+                               "layer", "memory")
+        f1 = QgsFeature(layer.fields())
+        f1.setGeometry(QgsGeometry.fromPointXY(QgsPointXY(1, 2)))
+        f2 = QgsFeature(layer.fields())
+        f2.setGeometry(QgsGeometry.fromPointXY(QgsPointXY(50, 60)))
+        self.assertTrue(layer.dataProvider().addFeatures([f1, f2]))
+        f1_id = next(layer.getFeatures()).id()
+        self.assertTrue(layer.startEditing())
+
+        cache = QgsMapRendererCache()
+        cache.init(QgsRectangle(0, 0, 100, 100), 1000)
+        im = QImage(100, 100, QImage.Format_ARGB32)
+        im.fill(QColor(255, 0, 0))
+        cache.setCacheImage(layer.id(), im, [layer])
+        cache.setCacheImage('labels', im, [layer])
+        self.assertTrue(cache.hasCacheImage(layer.id()))
+        self.assertTrue(cache.dirtyCacheImage(layer.id())[0].isNull())
+
+        # moving a feature marks its old and new position as out of date...
+        self.assertTrue(layer.changeGeometry(f1_id, QgsGeometry.fromPointXY(QgsPointXY(10, 20))))
+        self.assertFalse(cache.hasCacheImage(layer.id()))
+        self.assertTrue(cache.cacheImage(layer.id()).isNull())
+        dirty, extent = cache.dirtyCacheImage(layer.id())
+        self.assertEqual(dirty, im)
+        self.assertEqual(extent, QgsRectangle(1, 2, 10, 20))
+        # ...but labels are not rendered piecewise
+        self.assertFalse(cache.hasCacheImage('labels'))
+
+        # the repaint following the edit keeps the image
+        layer.triggerRepaint()
+        dirty, extent = cache.dirtyCacheImage(layer.id())
+        self.assertFalse(dirty.isNull())
+
+        # deleted features are added to the out of date area
+        self.assertTrue(layer.deleteFeature(f1_id))
+        dirty, extent = cache.dirtyCacheImage(layer.id())
+        self.assertEqual(extent, QgsRectangle(1, 2, 10, 20))
+        f3 = QgsFeature(layer.fields())
+        f3.setGeometry(QgsGeometry.fromPointXY(QgsPointXY(30, 5)))
+        self.assertTrue(layer.addFeature(f3))
+        dirty, extent = cache.dirtyCacheImage(layer.id())
+        self.assertEqual(extent, QgsRectangle(1, 2, 30, 20))
+
+        # a new render replaces the image
+        cache.setCacheImage(layer.id(), im, [layer])
+        self.assertTrue(cache.hasCacheImage(layer.id()))
+        self.assertTrue(cache.dirtyCacheImage(layer.id())[0].isNull())
+
+        # a repaint which does not follow an edit clears the image
+        layer.triggerRepaint()
+        self.assertFalse(cache.hasCacheImage(layer.id()))
+        self.assertTrue(cache.dirtyCacheImage(layer.id())[0].isNull())
+
+        # changed attributes may change the symbology of any feature
+        cache.setCacheImage(layer.id(), im, [layer])
+        self.assertTrue(layer.changeAttributeValue(f3.id(), 0, 'a'))
+        self.assertFalse(cache.hasCacheImage(layer.id()))
+        self.assertTrue(cache.dirtyCacheImage(layer.id())[0].isNull())
+
+        # the image is only reused at the extent it was rendered for
+        cache.setCacheImage(layer.id(), im, [layer])
+        self.assertTrue(layer.changeGeometry(f3.id(), QgsGeometry.fromPointXY(QgsPointXY(40, 5))))
+        self.assertFalse(cache.dirtyCacheImage(layer.id())[0].isNull())
+        cache.init(QgsRectangle(10, 0, 110, 100), 1000)
+        self.assertTrue(cache.dirtyCacheImage(layer.id())[0].isNull())
+        self.assertTrue(cache.pannedCacheImage(layer.id())[0].isNull())
+
+        # stopping the edits clears the image
+        cache.init(QgsRectangle(0, 0, 100, 100), 1000)
+        cache.setCacheImage(layer.id(), im, [layer])
+        self.assertTrue(layer.rollBack())
+        self.assertFalse(cache.hasCacheImage(layer.id()))
+
     def testRequestRepaintSimple(self):
         """ test requesting repaint with a single dependent layer """
         layer = QgsVectorLayer("Point?field=fldtxt:string",
@@ -223,6 +223,46 @@ class TestQgsRasterFileWriter(unittest.TestCase):
     def testGeneratePyramidsErdas(self):
         return self._testGeneratePyramids(QgsRaster.PyramidsErdas)
 
+    def testCloudOptimized(self):
+        tmpName = tempfile.mktemp(suffix='.tif')
+        source = QgsRasterLayer(os.path.join(self.testDataDir, 'raster', 'byte.tif'), 'my', 'gdal')
+        self.assertTrue(source.isValid())
+        provider = source.dataProvider()
+        fw = QgsRasterFileWriter(tmpName)
+        fw.setCloudOptimized(True)
+        self.assertTrue(fw.cloudOptimized())
+        fw.setCreateOptions(['COMPRESS=LZW'])
+        fw.setPyramidsResampling('NEAREST')
+
+        pipe = QgsRasterPipe()
+        self.assertTrue(pipe.set(provider.clone()))
+
+        # upsample, so that the output has more than a single tile
+        self.assertEqual(fw.writeRaster(pipe,
+                                        provider.xSize() * 64,
+                                        provider.ySize() * 64,
+                                        provider.extent(),
+                                        provider.crs()), 0)
+        del fw
+        ds = gdal.Open(tmpName)
+        self.assertEqual(ds.RasterXSize, provider.xSize() * 64)
+        self.assertEqual(len(ds.GetFileList()), 1)
+        self.assertEqual(ds.GetMetadataItem('COMPRESSION', 'IMAGE_STRUCTURE'), 'LZW')
+        band = ds.GetRasterBand(1)
+        self.assertEqual(band.GetBlockSize(), [512, 512])
+
+        # overviews are reduced until they fit into a single tile
+        self.assertGreater(band.GetOverviewCount(), 0)
+        smallest = band.GetOverview(band.GetOverviewCount() - 1)
+        self.assertLessEqual(max(smallest.XSize, smallest.YSize), 512)
+        overview = band.GetOverview(0)
+        self.assertEqual(overview.XSize, (ds.RasterXSize + 1) // 2)
+
+        # nearest neighbour overviews match the source pixels
+        self.assertEqual(overview.ReadRaster(0, 0, 1, 1), band.ReadRaster(0, 0, 1, 1))
+        ds = None
+        os.unlink(tmpName)
+
 
 if __name__ == '__main__':
     unittest.main()
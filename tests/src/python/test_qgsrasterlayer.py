@@ -15,6 +15,7 @@ import qgis  # NOQA
 
 import os
 import filecmp
+import struct
 
 from qgis.PyQt.QtCore import QSize, QFileInfo, Qt, QTemporaryDir
 
@@ -25,6 +26,7 @@ from qgis.PyQt.QtGui import (
     QResizeEvent
 )
 from qgis.PyQt.QtXml import QDomDocument
+from osgeo import gdal
 
 
 from qgis.core import (QgsRaster,
@@ -49,6 +51,8 @@ from qgis.core import (QgsRaster,
                        QgsCoordinateTransformContext,
                        QgsCoordinateReferenceSystem,
                        QgsRasterHistogram,
+                       QgsMultiBandColorRenderer,
+                       Qgis,
                        )
 from utilities import unitTestDataPath
 from qgis.testing import start_app, unittest
@@ -1046,6 +1050,42 @@ class TestQgsRasterLayer(unittest.TestCase):
         # Check it twice because it crashed in some circumstances with the old implementation
         self.assertTrue(len(h.histogramVector), 100)
 
+    def testRenderedByteBlockColors(self):
+        """Test colors of renderers for byte data, which are calculated with lookup tables"""
+
+        temp_dir = QTemporaryDir()
+        path = os.path.join(temp_dir.path(), 'byte.tif')
+        ds = gdal.GetDriverByName('GTiff').Create(path, 5, 1, 3, gdal.GDT_Byte)
+        ds.SetGeoTransform([0, 1, 0, 1, 0, -1])
+        for band in range(1, 4):
+            ds.GetRasterBand(band).SetNoDataValue(7)
+            ds.GetRasterBand(band).WriteRaster(0, 0, 5, 1, struct.pack('5B', 0, 50, 100, 200, 7))
+        ds = None
+
+        layer = QgsRasterLayer(path, 'byte')
+        self.assertTrue(layer.isValid())
+        extent = layer.extent()
+        expected = [(0, 0, 0, 255), (127, 127, 127, 255), (255, 255, 255, 255), (255, 255, 255, 255), (0, 0, 0, 0)]
+
+        def enhancement():
+            ce = QgsContrastEnhancement(Qgis.Byte)
+            ce.setContrastEnhancementAlgorithm(QgsContrastEnhancement.StretchToMinimumMaximum)
+            ce.setMinimumValue(0)
+            ce.setMaximumValue(100)
+            return ce
+
+        gray = QgsSingleBandGrayRenderer(layer.dataProvider(), 1)
+        gray.setContrastEnhancement(enhancement())
+        block = gray.block(1, extent, 5, 1)
+        self.assertEqual([QColor.fromRgba(block.color(0, i)).getRgb() for i in range(5)], expected)
+
+        multi = QgsMultiBandColorRenderer(layer.dataProvider(), 1, 2, 3)
+        multi.setRedContrastEnhancement(enhancement())
+        multi.setGreenContrastEnhancement(enhancement())
+        multi.setBlueContrastEnhancement(enhancement())
+        block = multi.block(1, extent, 5, 1)
+        self.assertEqual([QColor.fromRgba(block.color(0, i)).getRgb() for i in range(5)], expected)
+
 
 class TestQgsRasterLayerTransformContext(unittest.TestCase):
 
@@ -0,0 +1,77 @@
+# -*- coding: utf-8 -*-
+"""QGIS Unit tests for QgsRasterProjector.
+
+.. note:: This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+"""
+__author__ = 'QGIS Project'
+__date__ = '17/10/2019'
+__copyright__ = 'Copyright 2019, The QGIS Project'
+
+import qgis  # NOQA
+
+import os
+
+from qgis.core import (QgsCoordinateReferenceSystem,
+                       QgsProject,
+                       QgsRasterLayer,
+                       QgsRasterProjector,
+                       QgsRectangle)
+
+from qgis.testing import start_app, unittest
+from utilities import unitTestDataPath
+
+start_app()
+
+
+class TestQgsRasterProjector(unittest.TestCase):
+
+    def setUp(self):
+        self.layer = QgsRasterLayer(os.path.join(unitTestDataPath(), 'landsat.tif'), 'landsat')
+        self.assertTrue(self.layer.isValid())
+        self.destCrs = QgsCoordinateReferenceSystem('EPSG:4326')
+
+    def projector(self, precision):
+        projector = QgsRasterProjector()
+        projector.setCrs(self.layer.crs(), self.destCrs, QgsProject.instance().transformContext())
+        projector.setInput(self.layer.dataProvider())
+        projector.setPrecision(precision)
+        return projector
+
+    def differentPixels(self, block1, block2):
+        self.assertEqual(block1.width(), block2.width())
+        self.assertEqual(block1.height(), block2.height())
+        count = 0
+        for row in range(block1.height()):
+            for col in range(block1.width()):
+                if block1.value(row, col) != block2.value(row, col):
+                    count += 1
+        return count
+
+    def testApproximateMatchesExact(self):
+        provider = self.layer.dataProvider()
+        ok, extent, width, height = self.projector(QgsRasterProjector.Exact).destExtentSize(provider.extent(), provider.xSize(), provider.ySize())
+        self.assertTrue(ok)
+
+        # the matrix of the approximate projector is cached, repeated requests must give the same result
+        approximate = self.projector(QgsRasterProjector.Approximate).block(1, extent, width, height)
+        self.assertTrue(approximate.isValid())
+        self.assertEqual(self.differentPixels(approximate, self.projector(QgsRasterProjector.Approximate).block(1, extent, width, height)), 0)
+
+        exact = self.projector(QgsRasterProjector.Exact).block(1, extent, width, height)
+        self.assertTrue(exact.isValid())
+        self.assertLess(self.differentPixels(approximate, exact), width * height * 0.05)
+
+        # panned extent with the same resolution
+        xShift = extent.width() / width * 3.3
+        yShift = extent.height() / height * 1.7
+        panned = QgsRectangle(extent.xMinimum() + xShift, extent.yMinimum() - yShift, extent.xMaximum() + xShift, extent.yMaximum() - yShift)
+        approximate = self.projector(QgsRasterProjector.Approximate).block(1, panned, width, height)
+        exact = self.projector(QgsRasterProjector.Exact).block(1, panned, width, height)
+        self.assertLess(self.differentPixels(approximate, exact), width * height * 0.05)
+
+
+if __name__ == '__main__':
+    unittest.main()